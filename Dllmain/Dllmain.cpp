@@ -225,6 +225,10 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 		// Init logs
 		Logging::EnableLogging = !Config.DisableLogging;
 		Logging::InitLog();
+		if (Config.LogCallTrace && Logging::EnableLogging)
+		{
+			Logging::Trace::Start();
+		}
 		bool IsRunningFromMemory = false;
 		Logging::Log() << "Starting DxWrapper v" << APP_VERSION;
 		{
@@ -791,6 +795,9 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 			Utils::SetThreadAffinity(GetCurrentThreadId());
 		}
 
+		// Add new threads to the priority monitor
+		Utils::AddPriorityMonitorThread(GetCurrentThreadId());
+
 #ifdef DDRAWCOMPAT
 		// Unload and Unhook DDrawCompat
 		if (DDrawCompat::IsEnabled())
@@ -848,6 +855,9 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 		Fullscreen::StopThread();
 		WriteMemory::StopThread();
 		//Utils::StopPriorityMonitor();
+		AudioScheduler::StopThread();
+		Profiler::Stop();
+		Logging::Trace::Stop();
 
 		// Unload DdrawWrapper
 		if (Config.Dd7to9)
@@ -17,13 +17,17 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include "WndProc.h"
+#include "WndProcTable.h"
 #include "GDI.h"
 #include "ddraw\ddraw.h"
 #include "d3d9\d3d9External.h"
 #include "Utils\Utils.h"
 #include "Settings\Settings.h"
 #include "Logging\Logging.h"
+#include "Libraries\ScopeGuard.h"
 
 #undef DefWindowProc
 
@@ -120,6 +124,29 @@ namespace WndProc
 	};
 
 	std::vector<std::shared_ptr<WNDPROCSTRUCT>> WndProcList;
+
+	WndProcTable<WNDPROCSTRUCT> WndProcIndex;		// Lock free index of WndProcList
+
+	struct WNDPROCLOCK
+	{
+		CRITICAL_SECTION cs;
+		WNDPROCLOCK() { InitializeCriticalSection(&cs); }
+		~WNDPROCLOCK() { DeleteCriticalSection(&cs); }
+	} WndProcLock;		// Held while WndProcList is changed
+
+	void RebuildTable();
+}
+
+void WndProc::RebuildTable()
+{
+	std::vector<WNDPROCSTRUCT*> Entries;
+	Entries.reserve(WndProcList.size());
+	for (auto& entry : WndProcList)
+	{
+		Entries.push_back(entry.get());
+	}
+
+	WndProcIndex.Publish(Entries);
 }
 
 bool WndProc::IsExecutableAddress(void* address)
@@ -142,14 +169,11 @@ bool WndProc::IsExecutableAddress(void* address)
 
 WNDPROC WndProc::CheckWndProc(HWND hWnd, LONG dwNewLong)
 {
-	for (auto& entry : WndProcList)
-	{
-		if (entry->IsActive() && entry->GetHWnd() == hWnd && !(entry->IsExiting() && (LONG)entry->GetAppWndProc() == dwNewLong))
-		{
-			return entry->GetMyWndProc();
-		}
-	}
-	return nullptr;
+	return WndProcIndex.Find<WNDPROC>(hWnd,
+		[dwNewLong](WNDPROCSTRUCT* wndProc) {
+			return wndProc->IsActive() && !(wndProc->IsExiting() && (LONG)wndProc->GetAppWndProc() == dwNewLong);
+		},
+		[](WNDPROCSTRUCT* wndProc) { return wndProc->GetMyWndProc(); });
 }
 
 WNDPROC WndProc::GetWndProc(HWND hWnd)
@@ -222,21 +246,26 @@ WndProc::DATASTRUCT* WndProc::AddWndProc(HWND hWnd)
 		return nullptr;
 	}
 
+	ScopedCriticalSection ThreadLock(&WndProcLock.cs);
+
 	// Remove inactive elements
-	WndProcList.erase(
-		std::remove_if(WndProcList.begin(), WndProcList.end(),
-			[](const std::shared_ptr<WNDPROCSTRUCT>& wndProc) {
-				return !wndProc->IsActive() && !IsWindow(wndProc->GetHWnd());
-			}),
-		WndProcList.end());
+	auto newEnd = std::remove_if(WndProcList.begin(), WndProcList.end(),
+		[](const std::shared_ptr<WNDPROCSTRUCT>& wndProc) {
+			return !wndProc->IsActive() && !IsWindow(wndProc->GetHWnd());
+		});
+	if (newEnd != WndProcList.end())
+	{
+		// Removed elements are freed after the readers of the old table are done
+		std::vector<std::shared_ptr<WNDPROCSTRUCT>> Removed(std::make_move_iterator(newEnd), std::make_move_iterator(WndProcList.end()));
+		WndProcList.erase(newEnd, WndProcList.end());
+		RebuildTable();
+	}
 
 	// Check if window is already hooked
-	for (auto& entry : WndProcList)
+	DATASTRUCT* DataStruct = GetWndProctStruct(hWnd);
+	if (DataStruct)
 	{
-		if (entry->IsActive() && entry->GetHWnd() == hWnd)
-		{
-			return entry->GetDataStruct();
-		}
+		return DataStruct;
 	}
 
 	// Get WndProc from hWnd
@@ -280,6 +309,7 @@ WndProc::DATASTRUCT* WndProc::AddWndProc(HWND hWnd)
 	LOG_LIMIT(100, __FUNCTION__ << " Creating WndProc instance! " << hWnd);
 	SetWndProc(hWnd, NewWndProc);
 	WndProcList.push_back(NewEntry);
+	RebuildTable();
 
 	// Handle keyboard layout
 	if (Config.ForceKeyboardLayout && hWnd == GetForegroundWindow())
@@ -293,46 +323,40 @@ WndProc::DATASTRUCT* WndProc::AddWndProc(HWND hWnd)
 
 void WndProc::RemoveWndProc(HWND hWnd)
 {
+	ScopedCriticalSection ThreadLock(&WndProcLock.cs);
+
 	// Remove instances from the vector
 	auto newEnd = std::remove_if(WndProcList.begin(), WndProcList.end(), [hWnd](const std::shared_ptr<WNDPROCSTRUCT>& AppWndProcInstance) -> bool
 		{
 			return (AppWndProcInstance->GetHWnd() == hWnd);
 		});
 
-	// Erase removed instances from the vector
-	WndProcList.erase(newEnd, WndProcList.end());
+	// Erase removed instances from the vector, they are freed after the readers of the old table are done
+	if (newEnd != WndProcList.end())
+	{
+		std::vector<std::shared_ptr<WNDPROCSTRUCT>> Removed(std::make_move_iterator(newEnd), std::make_move_iterator(WndProcList.end()));
+		WndProcList.erase(newEnd, WndProcList.end());
+		RebuildTable();
+	}
 }
 
+// The returned pointer is into the entry and is used after the lookup ends, like before the table. It
+// stays valid while the entry is in WndProcList, so callers must not keep it past RemoveWndProc for the window.
 WndProc::DATASTRUCT* WndProc::GetWndProctStruct(HWND hWnd)
 {
-	for (auto& entry : WndProcList)
-	{
-		if (entry->IsActive() && entry->GetHWnd() == hWnd)
-		{
-			return entry->GetDataStruct();
-		}
-	}
-	return nullptr;
+	return WndProcIndex.Find<DATASTRUCT*>(hWnd,
+		[](WNDPROCSTRUCT* wndProc) { return wndProc->IsActive(); },
+		[](WNDPROCSTRUCT* wndProc) { return wndProc->GetDataStruct(); });
 }
 
 DWORD WndProc::MakeKey(DWORD Val1, DWORD Val2)
 {
-	// Single-step mixer
-	auto Mix = [](DWORD v) -> DWORD {
-		v ^= v >> 16;
-		v *= 0x7feb352d;
-		v ^= v >> 15;
-		v *= 0x846ca68b;
-		v ^= v >> 16;
-		return v;
-		};
-
 	// Combine two inputs in a simple, asymmetric way
-	DWORD Result = Mix(Val1) + 0x9E3779B9;   // add golden ratio constant
-	Result ^= Mix(Val2) + (Result << 6) + (Result >> 2);
+	DWORD Result = MixKey(Val1) + 0x9E3779B9;   // add golden ratio constant
+	Result ^= MixKey(Val2) + (Result << 6) + (Result >> 2);
 
 	// Final avalanche
-	return Mix(Result);
+	return MixKey(Result);
 }
 
 void WndProc::SetKeyboardLayoutFocus(HWND hWnd, bool IsActivating)
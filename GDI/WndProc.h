@@ -25,6 +25,17 @@ namespace WndProc
 
 	extern bool SwitchingResolution;
 
+	// Single-step mixer used by MakeKey and to hash window handles in WndProcTable
+	inline DWORD MixKey(DWORD v)
+	{
+		v ^= v >> 16;
+		v *= 0x7feb352d;
+		v ^= v >> 15;
+		v *= 0x846ca68b;
+		v ^= v >> 16;
+		return v;
+	}
+
 	bool ShouldHook(HWND hWnd);
 	DATASTRUCT* AddWndProc(HWND hWnd);
 	void RemoveWndProc(HWND hWnd);
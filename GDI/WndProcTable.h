@@ -0,0 +1,144 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <atomic>
+#include <vector>
+#include "WndProc.h"
+
+// Open addressed index of the WndProc instances keyed by window handle. Lookups take no lock and
+// never block: a table is never changed after it is published and each change publishes a new one.
+//
+// Replaced tables are reclaimed with two reader counters picked by the low bit of an epoch. A
+// reader counts itself in the current epoch's counter and then checks the epoch did not move, so
+// once a writer has moved the epoch and the old counter drops to zero no reader can still hold the
+// old table. Publish waits for that before it returns, so the old table and any entries the caller
+// removed from its list can be freed once Publish returns. Writers must be serialized by the caller.
+template <typename T>
+class WndProcTable
+{
+private:
+	struct TABLE
+	{
+		DWORD Mask = 0;
+		std::vector<T*> Slots;
+		std::atomic<DWORD> LastHitSlot = (DWORD)-1;	// Slot of the last window found, most apps have a single window
+	};
+
+	std::atomic<TABLE*> Current = nullptr;
+	std::atomic<DWORD> Epoch = 0;
+	std::atomic<LONG> Readers[2] = {};
+
+	static DWORD GetHash(HWND hWnd)
+	{
+		return WndProc::MixKey((DWORD)(ULONG_PTR)hWnd);
+	}
+
+	// Counts the reader in the current epoch and returns the counter to release
+	std::atomic<LONG>& EnterRead()
+	{
+		while (true)
+		{
+			const DWORD ReadEpoch = Epoch.load();
+			std::atomic<LONG>& Counter = Readers[ReadEpoch & 1];
+			Counter.fetch_add(1);
+			if (Epoch.load() == ReadEpoch)
+			{
+				return Counter;
+			}
+			// A writer moved the epoch and may already have checked this counter
+			Counter.fetch_sub(1);
+		}
+	}
+
+	// Waits until no reader can still see a table replaced before this call
+	void Synchronize()
+	{
+		const DWORD OldEpoch = Epoch.fetch_add(1);
+		while (Readers[OldEpoch & 1].load() != 0)
+		{
+			Sleep(0);
+		}
+	}
+
+public:
+	~WndProcTable()
+	{
+		delete Current.load();
+	}
+
+	// Builds and publishes a table with the entries, entries for the same window are found in list order
+	void Publish(const std::vector<T*>& Entries)
+	{
+		DWORD Size = 8;
+		while (Size < Entries.size() * 2)
+		{
+			Size <<= 1;
+		}
+
+		TABLE* NewTable = new TABLE;
+		NewTable->Mask = Size - 1;
+		NewTable->Slots.resize(Size, nullptr);
+		for (T* entry : Entries)
+		{
+			DWORD Slot = GetHash(entry->GetHWnd()) & NewTable->Mask;
+			while (NewTable->Slots[Slot])
+			{
+				Slot = (Slot + 1) & NewTable->Mask;
+			}
+			NewTable->Slots[Slot] = entry;
+		}
+
+		TABLE* OldTable = Current.exchange(NewTable);
+		Synchronize();
+		delete OldTable;
+	}
+
+	// Returns Get(entry) for the first entry of the window that passes Check, or R() if there is none.
+	// Check and Get run while the table is held, so they must not call Publish. Only the table is
+	// protected here, a pointer Get returns into the entry is only valid while the caller keeps the entry.
+	template <typename R, typename C, typename G>
+	R Find(HWND hWnd, C Check, G Get)
+	{
+		std::atomic<LONG>& Counter = EnterRead();
+		R Found = R();
+
+		TABLE* Table = Current.load();
+		if (Table)
+		{
+			// Check last hit first, it is only stored for the first entry of its window in probe order
+			// so it returns the same entry as the full lookup
+			const DWORD LastHit = Table->LastHitSlot.load(std::memory_order_relaxed);
+			T* entry = (LastHit <= Table->Mask) ? Table->Slots[LastHit] : nullptr;
+			if (entry && entry->GetHWnd() == hWnd && Check(entry))
+			{
+				Found = Get(entry);
+			}
+			else
+			{
+				bool IsFirst = true;
+				DWORD Slot = GetHash(hWnd) & Table->Mask;
+				while ((entry = Table->Slots[Slot]) != nullptr)
+				{
+					if (entry->GetHWnd() == hWnd)
+					{
+						if (Check(entry))
+						{
+							if (IsFirst)
+							{
+								Table->LastHitSlot.store(Slot, std::memory_order_relaxed);
+							}
+							Found = Get(entry);
+							break;
+						}
+						IsFirst = false;
+					}
+					Slot = (Slot + 1) & Table->Mask;
+				}
+			}
+		}
+
+		Counter.fetch_sub(1);
+		return Found;
+	}
+};
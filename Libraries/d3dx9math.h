@@ -0,0 +1,119 @@
+#pragma once
+
+// Math types only need the Direct3D 9 types, so code without a device can use them
+#include <d3d9types.h>
+
+using D3DXMATRIX = D3DMATRIX;
+
+struct D3DXCOLOR {
+	FLOAT r, g, b, a;
+
+	D3DXCOLOR() : r(0), g(0), b(0), a(0) {}
+	D3DXCOLOR(FLOAT _r, FLOAT _g, FLOAT _b, FLOAT _a)
+		: r(_r), g(_g), b(_b), a(_a) {
+	}
+};
+
+// Define the D3DXVECTOR2 structure
+typedef struct D3DXVECTOR2
+{
+	float x, y;
+
+	D3DXVECTOR2() : x(0), y(0) {}
+	D3DXVECTOR2(float x_, float y_) : x(x_), y(y_) {}
+} D3DXVECTOR2, * LPD3DXVECTOR2;
+
+// Define the D3DXVECTOR3 structure with operator overloading
+typedef struct D3DXVECTOR3
+{
+	float x, y, z;
+
+	D3DXVECTOR3() : x(0), y(0), z(0) {}
+	D3DXVECTOR3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+
+	// Conversion operators for D3DVECTOR
+	operator const D3DVECTOR& () const
+	{
+		return reinterpret_cast<const D3DVECTOR&>(*this);
+	}
+
+	operator D3DVECTOR& ()
+	{
+		return reinterpret_cast<D3DVECTOR&>(*this);
+	}
+
+	// Assignment from D3DVECTOR
+	D3DXVECTOR3& operator=(const D3DVECTOR& rhs)
+	{
+		x = rhs.x;
+		y = rhs.y;
+		z = rhs.z;
+		return *this;
+	}
+
+	// Addition
+	D3DXVECTOR3 operator+(const D3DXVECTOR3& rhs) const
+	{
+		return D3DXVECTOR3(x + rhs.x, y + rhs.y, z + rhs.z);
+	}
+
+	// Subtraction
+	D3DXVECTOR3 operator-(const D3DXVECTOR3& rhs) const
+	{
+		return D3DXVECTOR3(x - rhs.x, y - rhs.y, z - rhs.z);
+	}
+
+	// Unary minus
+	D3DXVECTOR3 operator-() const
+	{
+		return D3DXVECTOR3(-x, -y, -z);
+	}
+
+	// Scalar multiplication
+	D3DXVECTOR3 operator*(float scalar) const
+	{
+		return D3DXVECTOR3(x * scalar, y * scalar, z * scalar);
+	}
+
+	// Scalar division
+	D3DXVECTOR3 operator/(float scalar) const
+	{
+		float inv = 1.0f / scalar;
+		return D3DXVECTOR3(x * inv, y * inv, z * inv);
+	}
+
+	// Compound assignment operators
+	D3DXVECTOR3& operator+=(const D3DXVECTOR3& rhs)
+	{
+		x += rhs.x; y += rhs.y; z += rhs.z;
+		return *this;
+	}
+
+	D3DXVECTOR3& operator-=(const D3DXVECTOR3& rhs)
+	{
+		x -= rhs.x; y -= rhs.y; z -= rhs.z;
+		return *this;
+	}
+
+	D3DXVECTOR3& operator*=(float scalar)
+	{
+		x *= scalar; y *= scalar; z *= scalar;
+		return *this;
+	}
+
+	D3DXVECTOR3& operator/=(float scalar)
+	{
+		float inv = 1.0f / scalar;
+		x *= inv; y *= inv; z *= inv;
+		return *this;
+	}
+} D3DXVECTOR3, * LPD3DXVECTOR3;
+
+// Define the D3DXVECTOR4 structure
+typedef struct D3DXVECTOR4
+{
+	float x, y, z, w;
+
+	D3DXVECTOR4() : x(0), y(0), z(0), w(0) {}
+	D3DXVECTOR4(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+} D3DXVECTOR4, * LPD3DXVECTOR4;
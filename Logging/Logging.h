@@ -3,6 +3,7 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include "External\Logging\Logging.h"
+#include "TraceLog.h"
 
 namespace Logging
 {
@@ -0,0 +1,146 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Logging.h"
+
+namespace Logging
+{
+	namespace Trace
+	{
+		std::atomic<bool> Enabled = false;
+	}
+}
+
+namespace {
+	constexpr DWORD RingSize = 4096;
+	constexpr DWORD DrainInterval = 100;
+
+	Logging::Trace::TraceRing<RingSize> Ring;
+	LARGE_INTEGER Frequency = {};
+	LARGE_INTEGER StartTime = {};
+	HANDLE hThread = nullptr;
+	HANDLE hStopEvent = nullptr;
+	HANDLE hDrainedEvent = nullptr;
+
+	void OutputRecord(const Logging::Trace::TRACERECORD& Record)
+	{
+		const double Time = (double)(Record.Time - StartTime.QuadPart) * 1000.0 / (double)Frequency.QuadPart;
+
+		char Args[Logging::Trace::MaxArgs * 18 + 1] = {};
+		int Length = 0;
+		for (DWORD x = 0; x < Record.ArgCount && x < Logging::Trace::MaxArgs; x++)
+		{
+			Length += sprintf_s(Args + Length, sizeof(Args) - Length, " %08IX", Record.Args[x]);
+		}
+
+		Logging::Log() << Record.Function << " [" << Record.ThreadId << "] " << Time << "ms" << Args;
+	}
+
+	void DrainRing()
+	{
+		Ring.Drain(OutputRecord);
+
+		DWORD Dropped = Ring.GetDropped();
+		if (Dropped)
+		{
+			Logging::Log() << "Trace: dropped " << Dropped << " records";
+		}
+	}
+
+	DWORD WINAPI TraceThreadFunc(LPVOID)
+	{
+		while (WaitForSingleObject(hStopEvent, DrainInterval) == WAIT_TIMEOUT)
+		{
+			DrainRing();
+		}
+
+		// Final drain, signaled separately since the thread cannot exit while the loader lock is held
+		DrainRing();
+		SetEvent(hDrainedEvent);
+
+		return 0;
+	}
+
+	void CloseEvents()
+	{
+		for (HANDLE* pEvent : { &hStopEvent, &hDrainedEvent })
+		{
+			if (*pEvent)
+			{
+				CloseHandle(*pEvent);
+				*pEvent = nullptr;
+			}
+		}
+	}
+}
+
+void Logging::Trace::Start()
+{
+	if (hThread)
+	{
+		return;
+	}
+
+	QueryPerformanceFrequency(&Frequency);
+	QueryPerformanceCounter(&StartTime);
+
+	hStopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	hDrainedEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	if (!hStopEvent || !hDrainedEvent)
+	{
+		Logging::Log() << __FUNCTION__ << " Error: failed to create trace events!";
+		CloseEvents();
+		return;
+	}
+
+	hThread = CreateThread(nullptr, 0, TraceThreadFunc, nullptr, 0, nullptr);
+	if (!hThread)
+	{
+		Logging::Log() << __FUNCTION__ << " Error: failed to create trace thread!";
+		CloseEvents();
+		return;
+	}
+	SetThreadPriority(hThread, THREAD_PRIORITY_BELOW_NORMAL);
+
+	Enabled.store(true, std::memory_order_relaxed);
+}
+
+void Logging::Trace::Stop()
+{
+	Enabled.store(false, std::memory_order_relaxed);
+
+	if (hThread)
+	{
+		SetEvent(hStopEvent);
+
+		// If the thread was already terminated with the process then drain what is left here
+		HANDLE Handles[] = { hDrainedEvent, hThread };
+		if (WaitForMultipleObjects(2, Handles, FALSE, 1000) == WAIT_OBJECT_0 + 1)
+		{
+			DrainRing();
+		}
+
+		CloseHandle(hThread);
+		hThread = nullptr;
+	}
+
+	CloseEvents();
+}
+
+void Logging::Trace::Write(const char* Function, const ULONG_PTR* Args, DWORD ArgCount)
+{
+	WriteRecord(Ring, Function, Args, ArgCount);
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// Binary call trace. Log sites store the function name pointer and a few raw arguments in a ring
+// and a background thread renders the text, so the calling thread never formats anything. When
+// tracing is off a log site costs one atomic load and its arguments are not evaluated.
+#define LOG_TRACE(...) \
+	if (!Logging::Trace::Enabled.load(std::memory_order_relaxed)) {} else Logging::Trace::WriteArgs(__FUNCTION__, __VA_ARGS__)
+
+namespace Logging
+{
+	namespace Trace
+	{
+		constexpr DWORD MaxArgs = 9;		// Enough for every argument of the indexed draw calls
+
+		struct TRACERECORD {
+			LONGLONG Time = 0;
+			const char* Function = nullptr;
+			DWORD ThreadId = 0;
+			DWORD ArgCount = 0;
+			ULONG_PTR Args[MaxArgs] = {};
+		};
+
+		// Multi-producer ring with a per-slot sequence number. A slot is free for index i when its sequence
+		// is i, holds a record when it is i + 1 and is freed for the next lap as i + Size once read. Writers
+		// claim an index with a compare-exchange only while its slot is free, so two writers never share a
+		// slot. When the reader falls a full ring behind new records are dropped and counted, writers never wait.
+		template <DWORD Size>
+		class TraceRing
+		{
+		private:
+			static_assert((Size & (Size - 1)) == 0, "Size must be a power of two");
+
+			struct SLOT {
+				std::atomic<DWORD> Sequence = 0;
+				TRACERECORD Record;
+			};
+
+			SLOT Slots[Size];
+			std::atomic<DWORD> WriteIndex = 0;
+			std::atomic<DWORD> Dropped = 0;
+			DWORD ReadIndex = 0;
+
+		public:
+			TraceRing()
+			{
+				for (DWORD x = 0; x < Size; x++)
+				{
+					Slots[x].Sequence.store(x, std::memory_order_relaxed);
+				}
+			}
+
+			// Returns false if the ring is full and the record was dropped
+			bool Push(const TRACERECORD& Record)
+			{
+				DWORD Index = WriteIndex.load(std::memory_order_relaxed);
+				while (true)
+				{
+					SLOT& Slot = Slots[Index & (Size - 1)];
+					const LONG Diff = (LONG)(Slot.Sequence.load(std::memory_order_acquire) - Index);
+					if (Diff == 0)
+					{
+						// Slot is free for this lap, claim it unless another writer got there first
+						if (WriteIndex.compare_exchange_weak(Index, Index + 1, std::memory_order_relaxed))
+						{
+							Slot.Record = Record;
+							Slot.Sequence.store(Index + 1, std::memory_order_release);
+							return true;
+						}
+					}
+					else if (Diff < 0)
+					{
+						// Slot still holds a record from the last lap
+						Dropped.fetch_add(1, std::memory_order_relaxed);
+						return false;
+					}
+					else
+					{
+						// Another writer claimed this index
+						Index = WriteIndex.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+			// Calls Output(const TRACERECORD&) for each completed record in order, returns the number output.
+			// Only one thread may drain at a time.
+			template <typename F>
+			DWORD Drain(F Output)
+			{
+				DWORD Count = 0;
+				while (true)
+				{
+					SLOT& Slot = Slots[ReadIndex & (Size - 1)];
+
+					// Stop at the first slot not yet written, a writer may still be copying its record
+					if (Slot.Sequence.load(std::memory_order_acquire) != ReadIndex + 1)
+					{
+						break;
+					}
+
+					Output(Slot.Record);
+					Count++;
+
+					Slot.Sequence.store(ReadIndex + Size, std::memory_order_release);
+					ReadIndex++;
+				}
+				return Count;
+			}
+
+			DWORD GetDropped()
+			{
+				return Dropped.exchange(0, std::memory_order_relaxed);
+			}
+		};
+
+		extern std::atomic<bool> Enabled;
+
+		void Start();
+		void Stop();
+		void Write(const char* Function, const ULONG_PTR* Args, DWORD ArgCount);
+
+		template <typename T>
+		inline ULONG_PTR ToArg(T Value)
+		{
+			if constexpr (std::is_pointer_v<T>)
+			{
+				return reinterpret_cast<ULONG_PTR>(Value);
+			}
+			else if constexpr (std::is_floating_point_v<T>)
+			{
+				const float f = (float)Value;
+				return *reinterpret_cast<const DWORD*>(&f);
+			}
+			else
+			{
+				return static_cast<ULONG_PTR>(Value);
+			}
+		}
+
+		// Stamps a record for the calling thread and pushes it, Write uses it with the global ring
+		template <DWORD Size>
+		inline void WriteRecord(TraceRing<Size>& Ring, const char* Function, const ULONG_PTR* Args, DWORD ArgCount)
+		{
+			TRACERECORD Record;
+			LARGE_INTEGER Time;
+			QueryPerformanceCounter(&Time);
+			Record.Time = Time.QuadPart;
+			Record.Function = Function;
+			Record.ThreadId = GetCurrentThreadId();
+			Record.ArgCount = ArgCount;
+			memcpy(Record.Args, Args, ArgCount * sizeof(ULONG_PTR));
+
+			Ring.Push(Record);
+		}
+
+		template <typename... A>
+		inline void WriteArgs(const char* Function, A... Args)
+		{
+			static_assert(sizeof...(A) <= MaxArgs, "Too many trace arguments");
+			const ULONG_PTR Values[sizeof...(A) + 1] = { ToArg(Args)... };
+			Write(Function, Values, sizeof...(A));
+		}
+
+		template <DWORD Size, typename... A>
+		inline void WriteArgs(TraceRing<Size>& Ring, const char* Function, A... Args)
+		{
+			static_assert(sizeof...(A) <= MaxArgs, "Too many trace arguments");
+			const ULONG_PTR Values[sizeof...(A) + 1] = { ToArg(Args)... };
+			WriteRecord(Ring, Function, Values, sizeof...(A));
+		}
+	}
+}
@@ -43,6 +43,7 @@ inline std::ostream& operator<<(std::ostream& os, const DHEX& dhex) {
 	visit(DdrawAllowMultiSampling) \
 	visit(DdrawAlternatePixelCenter) \
 	visit(DdrawAutoFrameSkip) \
+	visit(DdrawBatchPrimitives) \
 	visit(DdrawClampVertexZDepth) \
 	visit(DdrawClippedWidth) \
 	visit(DdrawClippedHeight) \
@@ -73,6 +74,7 @@ inline std::ostream& operator<<(std::ostream& os, const DHEX& dhex) {
 	visit(DdrawOverrideWidth) \
 	visit(DdrawOverrideHeight) \
 	visit(DdrawOverrideStencilFormat) \
+	visit(DdrawProfiler) \
 	visit(DdrawResolutionHack) \
 	visit(DdrawUseDirect3D9Caps) \
 	visit(DdrawUseShadowSurface) \
@@ -143,6 +145,7 @@ inline std::ostream& operator<<(std::ostream& os, const DHEX& dhex) {
 	visit(LoadFromScriptsOnly) \
 	visit(LoadPlugins) \
 	visit(LockColorkey) \
+	visit(LogCallTrace) \
 	visit(LoopSleepTime) \
 	visit(MouseMovementFactor) \
 	visit(MouseMovementPadding) \
@@ -285,6 +288,8 @@ struct CONFIG
 	bool DdrawLinearTextureFilter = false;		// Uses D3DTEXF_LINEAR filtering when stretching non-paletted images
 	bool DdrawUseNativeResolution = false;		// Uses the current screen resolution for Dd7to9
 	bool DdrawVertexLockDiscard = false;		// Sets the discard flag for vertex Lock
+	bool DdrawBatchPrimitives = false;			// Merges consecutive DrawPrimitive calls that use the same states into one draw
+	bool DdrawProfiler = false;					// Times draw, blit, lock and present calls and writes percentile stats to dxwrapper-profile.csv
 	DWORD DdrawClippedWidth = 0;				// Used to scaled Direct3d9 to use this width when using Dd7to9
 	DWORD DdrawClippedHeight = 0;				// Used to scaled Direct3d9 to use this height when using Dd7to9
 	DWORD DdrawCustomWidth = 0;					// Custom resolution width for Dd7to9 when using DdrawLimitDisplayModeCount, resolution must be supported by video card and monitor
@@ -315,6 +320,7 @@ struct CONFIG
 	bool DisableGDIGammaRamp = false;			// Disables gamma ramp for GDI, some games look washed out with gamme ramp enabled
 	bool DisableHighDPIScaling = false;			// Disables display scaling on high DPI settings
 	bool DisableLogging = false;				// Disables the logging file
+	bool LogCallTrace = false;					// Records a binary trace of hot wrapped calls and writes it to the log from a background thread
 	DWORD SetSwapEffectShim = 0;				// Disables the call to d3d9.dll 'Direct3D9SetSwapEffectUpgradeShim' to switch present mode
 	DWORD CacheClipPlane = 0;					// Caches the ClipPlane for Direct3D9 to fix an issue in d3d9 on Windows 8 and newer
 	bool EnvironmentCubeMapFix = false;			// Fixes environment cube maps when no texture is applied, issue exists in d3d8
@@ -19,8 +19,11 @@
 #include <winternl.h>
 #include <tlhelp32.h>
 #include <map>
+#include <vector>
+#include <algorithm>
 #include "Dllmain\Dllmain.h"
 #include "Utils.h"
+#include "ThreadMonitor.h"
 #include "Settings\Settings.h"
 #include "Logging\Logging.h"
 
@@ -57,8 +60,21 @@ namespace Utils
 		DWORD threadId;
 	};
 
+	// Thread calls used by the priority monitor
+	struct PRIORITYCALLS {
+		HANDLE OpenThread(DWORD threadId);
+		bool IsRunning(HANDLE hThread);
+		bool FixPriority(HANDLE hThread);
+		void CloseThread(HANDLE hThread);
+	};
+
 	HANDLE g_hPriorityFixThread = nullptr;
 	HANDLE g_hStopEvent = nullptr;
+	HANDLE g_hNewThreadEvent = nullptr;
+	volatile LONG g_PriorityMonitorRunning = FALSE;
+	volatile LONG g_AddingThreadCount = 0;	// Threads inside AddPriorityMonitorThread, the lock is only deleted once this is zero
+	std::vector<DWORD> g_NewThreadIds;		// Added from DLL_THREAD_ATTACH, guarded by g_csNewThreads
+	CRITICAL_SECTION g_csNewThreads = {};
 
 	// Function declarations
 	void GetNtThreadFunctions(NtQueryInformationThreadFunc& queryFn, NtSetInformationThreadFunc& setFn);
@@ -259,76 +275,147 @@ void Utils::ApplyThreadAffinity()
 	CloseHandle(snapshot);
 }
 
-DWORD WINAPI Utils::PriorityFixThreadProc(LPVOID)
+HANDLE Utils::PRIORITYCALLS::OpenThread(DWORD threadId)
+{
+	return ::OpenThread(THREAD_QUERY_INFORMATION | THREAD_SET_INFORMATION | SYNCHRONIZE, FALSE, threadId);
+}
+
+bool Utils::PRIORITYCALLS::IsRunning(HANDLE hThread)
 {
-	DWORD currentPid = GetCurrentProcessId();
+	return WaitForSingleObject(hThread, 0) == WAIT_TIMEOUT;
+}
 
-	while (WaitForSingleObject(g_hStopEvent, 10) == WAIT_TIMEOUT)
+// Returns true if the thread was boosted into the realtime range and had to be lowered
+bool Utils::PRIORITYCALLS::FixPriority(HANDLE hThread)
+{
+	THREAD_BASIC_INFORMATION tbi = {};
+	if (NT_SUCCESS(g_ntQueryInformationThread(hThread, ThreadBasicInformation, &tbi, sizeof(tbi), nullptr)))
 	{
-		HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
-		if (snapshot == INVALID_HANDLE_VALUE)
+		if (tbi.Priority >= 16 && tbi.BasePriority < 16)
 		{
-			continue;
+			ULONG prio = THREAD_PRIORITY_HIGHEST;
+			return NT_SUCCESS(g_ntSetInformationThread(hThread, ThreadPriority, &prio, sizeof(prio)));
 		}
+	}
+	return false;
+}
 
-		THREADENTRY32 te = { sizeof(te) };
-		if (Thread32First(snapshot, &te))
+void Utils::PRIORITYCALLS::CloseThread(HANDLE hThread)
+{
+	CloseHandle(hThread);
+}
+
+DWORD WINAPI Utils::PriorityFixThreadProc(LPVOID)
+{
+	const DWORD currentThreadId = GetCurrentThreadId();
+	PRIORITYCALLS Calls;
+	ThreadMonitor<PRIORITYCALLS> Threads(Calls);
+	std::vector<DWORD> NewThreadIds;
+
+	HANDLE Events[] = { g_hStopEvent, g_hNewThreadEvent };
+	DWORD Timeout = 0;
+
+	while (WaitForMultipleObjects(_countof(Events), Events, FALSE, Timeout) != WAIT_OBJECT_0)
+	{
+		// Add new threads
+		EnterCriticalSection(&g_csNewThreads);
+		NewThreadIds.swap(g_NewThreadIds);
+		LeaveCriticalSection(&g_csNewThreads);
+
+		const DWORD Now = GetTickCount();
+		for (DWORD threadId : NewThreadIds)
 		{
-			do {
-				if (te.th32OwnerProcessID == currentPid)
-				{
-					HANDLE hThread = OpenThread(THREAD_QUERY_INFORMATION | THREAD_SET_INFORMATION, FALSE, te.th32ThreadID);
-					if (hThread)
-					{
-						THREAD_BASIC_INFORMATION tbi = {};
-						NTSTATUS status = g_ntQueryInformationThread(hThread, ThreadBasicInformation, &tbi, sizeof(tbi), nullptr);
-						if (NT_SUCCESS(status))
-						{
-							if (tbi.Priority >= 16 && tbi.BasePriority < 16)
-							{
-								ULONG prio = THREAD_PRIORITY_HIGHEST;
-								status = g_ntSetInformationThread(hThread, ThreadPriority, &prio, sizeof(prio));
-								if (!NT_SUCCESS(status))
-								{
-									//Log(L"NtSetInformationThread failed for thread %u\n", it->first, 0, 0);
-								}
-							}
-						}
-						CloseHandle(hThread);
-					}
-				}
-			} while (Thread32Next(snapshot, &te));
+			if (threadId != currentThreadId)
+			{
+				Threads.Add(threadId, Now);
+			}
 		}
-		CloseHandle(snapshot);
+		NewThreadIds.clear();
+
+		// Check threads that are due and find the next due time
+		Timeout = Threads.CheckDue(Now);
 	}
 
 	return 0;
 }
 
+// Called from DLL_THREAD_ATTACH, so it only queues the thread for the monitor. DLL_THREAD_ATTACH runs
+// for every thread started through CreateThread, suspended threads once they are resumed, so the
+// CreateThread hook does not queue threads.
+void Utils::AddPriorityMonitorThread(DWORD threadId)
+{
+	InterlockedIncrement(&g_AddingThreadCount);
+
+	if (g_PriorityMonitorRunning)
+	{
+		EnterCriticalSection(&g_csNewThreads);
+		g_NewThreadIds.push_back(threadId);
+		LeaveCriticalSection(&g_csNewThreads);
+
+		SetEvent(g_hNewThreadEvent);
+	}
+
+	InterlockedDecrement(&g_AddingThreadCount);
+}
+
 void Utils::StartPriorityMonitor()
 {
 	GetNtThreadFunctions(g_ntQueryInformationThread, g_ntSetInformationThread);
 
-	if (!g_ntQueryInformationThread || !g_ntSetInformationThread)
+	if (!g_ntQueryInformationThread || !g_ntSetInformationThread || g_hPriorityFixThread)
 	{
 		return;
 	}
 
+	// New thread event and lock are deleted when the monitor stops
+	if (!g_hNewThreadEvent)
+	{
+		g_hNewThreadEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		if (!g_hNewThreadEvent)
+		{
+			return;
+		}
+		InitializeCriticalSection(&g_csNewThreads);
+	}
+
 	if (!g_hStopEvent)
 	{
 		g_hStopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr); // Manual-reset, initially non-signaled
+		if (!g_hStopEvent)
+		{
+			return;
+		}
 	}
 
-	if (!g_hPriorityFixThread)
+	// Threads created from now on are added as they start
+	InterlockedExchange(&g_PriorityMonitorRunning, TRUE);
+
+	// Add threads that already exist, this is the only time all threads are enumerated
+	const DWORD pid = GetCurrentProcessId();
+	const HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+	if (snapshot != INVALID_HANDLE_VALUE)
 	{
-		g_hPriorityFixThread = CreateThread(nullptr, 0, PriorityFixThreadProc, nullptr, 0, nullptr);
+		THREADENTRY32 te = { sizeof(te) };
+		if (Thread32First(snapshot, &te))
+		{
+			do {
+				if (te.th32OwnerProcessID == pid)
+				{
+					AddPriorityMonitorThread(te.th32ThreadID);
+				}
+			} while (Thread32Next(snapshot, &te));
+		}
+		CloseHandle(snapshot);
 	}
+
+	g_hPriorityFixThread = CreateThread(nullptr, 0, PriorityFixThreadProc, nullptr, 0, nullptr);
 }
 
 void Utils::StopPriorityMonitor()
 {
 	if (g_hStopEvent)
 	{
+		InterlockedExchange(&g_PriorityMonitorRunning, FALSE);
 		SetEvent(g_hStopEvent);
 		if (g_hPriorityFixThread)
 		{
@@ -339,6 +426,21 @@ void Utils::StopPriorityMonitor()
 		CloseHandle(g_hStopEvent);
 		g_hStopEvent = nullptr;
 	}
+
+	if (g_hNewThreadEvent)
+	{
+		// Wait for threads that saw the monitor running to finish queuing before deleting the lock
+		while (InterlockedCompareExchange(&g_AddingThreadCount, 0, 0))
+		{
+			Sleep(0);
+		}
+
+		// Drop threads queued after the monitor last ran, a restart enumerates all threads again
+		g_NewThreadIds.clear();
+		DeleteCriticalSection(&g_csNewThreads);
+		CloseHandle(g_hNewThreadEvent);
+		g_hNewThreadEvent = nullptr;
+	}
 }
 
 static bool IsRegularPriority(LONG Priority)
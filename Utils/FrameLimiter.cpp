@@ -0,0 +1,112 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "FrameLimiter.h"
+#include <algorithm>
+
+namespace
+{
+	constexpr LONGLONG MinSpinMarginUS = 250;
+	constexpr LONGLONG MaxSpinMarginUS = 4000;
+	constexpr LONGLONG DefaultSpinMarginUS = 1000;
+}
+
+Utils::FrameLimiter::FrameLimiter(FrameLimiterClock& Clock) : Clock(Clock)
+{
+	InitClock();
+}
+
+Utils::FrameLimiter::FrameLimiter(std::unique_ptr<FrameLimiterClock> NewClock) : OwnedClock(std::move(NewClock)), Clock(*OwnedClock)
+{
+	InitClock();
+}
+
+void Utils::FrameLimiter::InitClock()
+{
+	Frequency = Clock.GetFrequency();
+	SpinMargin = DefaultSpinMarginUS * Frequency / 1000000;
+}
+
+void Utils::FrameLimiter::SetFrameRate(double FPS)
+{
+	const LONGLONG NewFrameTicks = (FPS > 0.0) ? static_cast<LONGLONG>(Frequency / FPS) : 0;
+	if (NewFrameTicks != FrameTicks)
+	{
+		FrameTicks = NewFrameTicks;
+		Deadline = 0;
+	}
+}
+
+// Sleeps until the spin margin before the target time and then spins the rest
+void Utils::FrameLimiter::WaitUntil(LONGLONG TargetTime)
+{
+	LONGLONG Now = Clock.GetTime();
+	const LONGLONG SleepUntil = TargetTime - SpinMargin;
+
+	if (SleepUntil > Now && Clock.Sleep(SleepUntil - Now))
+	{
+		// Keep the margin a bit above how late the sleep wakes up, grow quickly and shrink slowly
+		Now = Clock.GetTime();
+		const LONGLONG Late = Now - SleepUntil;
+		const LONGLONG Target = (std::max)(Late + Late / 2, MinSpinMarginUS * Frequency / 1000000);
+		SpinMargin = (Target > SpinMargin) ? Target : SpinMargin - (SpinMargin - Target) / 16;
+		SpinMargin = (std::min)(SpinMargin, MaxSpinMarginUS * Frequency / 1000000);
+	}
+
+	// Spin the rest of the time
+	while ((Now = Clock.GetTime()) < TargetTime)
+	{
+		Clock.Spin(TargetTime - Now);
+	}
+}
+
+// Waits until the next frame should be presented, call before presenting
+void Utils::FrameLimiter::WaitForFrame()
+{
+	if (!FrameTicks)
+	{
+		return;
+	}
+
+	const LONGLONG Now = Clock.GetTime();
+
+	// First frame or if we fell behind, reset the cadence from now
+	if (Deadline == 0 || Now >= Deadline - PresentTicks)
+	{
+		Deadline = Now + PresentTicks + FrameTicks;
+		WakeTime = Now;
+		return;
+	}
+
+	WaitUntil(Deadline - PresentTicks);
+	Deadline += FrameTicks;
+	WakeTime = Clock.GetTime();
+}
+
+// Records how long the present took, call after presenting
+void Utils::FrameLimiter::EndPresent()
+{
+	if (!FrameTicks || !WakeTime)
+	{
+		return;
+	}
+
+	// Average over about 8 frames and never reserve more than half the frame for presenting
+	const LONGLONG Elapsed = (std::min)(Clock.GetTime() - WakeTime, FrameTicks / 2);
+	PresentTicks += (Elapsed - PresentTicks) / 8;
+	WakeTime = 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <windows.h>
+#include <memory>
+
+namespace Utils
+{
+	// Time source the frame limiter sleeps and spins on. Times are in ticks of GetFrequency().
+	class FrameLimiterClock
+	{
+	public:
+		virtual ~FrameLimiterClock() {}
+
+		virtual LONGLONG GetFrequency() = 0;
+		virtual LONGLONG GetTime() = 0;
+		// Sleeps for about the given time and returns false if it could not sleep
+		virtual bool Sleep(LONGLONG Ticks) = 0;
+		// Called in the spin loop with the time left
+		virtual void Spin(LONGLONG Ticks) = 0;
+	};
+
+	// Frame limiter that sleeps until shortly before the deadline and spins the rest. The spin
+	// margin is calibrated from how late the sleep wakes up, and the wait ends early by the average
+	// present time so the present itself finishes on the frame cadence.
+	class FrameLimiter
+	{
+	private:
+		std::unique_ptr<FrameLimiterClock> OwnedClock;
+		FrameLimiterClock& Clock;
+		LONGLONG Frequency = 0;
+		LONGLONG FrameTicks = 0;
+		LONGLONG Deadline = 0;			// Time the next present should finish
+		LONGLONG WakeTime = 0;			// Time the last wait returned
+		LONGLONG PresentTicks = 0;		// Average time from the wait returning to the present finishing
+		LONGLONG SpinMargin = 0;		// Time before the target to stop sleeping and start spinning
+
+		FrameLimiter(std::unique_ptr<FrameLimiterClock> NewClock);
+		void InitClock();
+
+	public:
+		FrameLimiter();		// Uses the performance counter and a waitable timer, see FrameLimiterClock.cpp
+		FrameLimiter(FrameLimiterClock& Clock);
+
+		void SetFrameRate(double FPS);
+		void WaitUntil(LONGLONG TargetTime);
+		void WaitForFrame();
+		void EndPresent();
+		void CancelPresent() { WakeTime = 0; }		// Present failed, nothing to measure
+		LONGLONG GetFrequency() const { return Frequency; }
+		LONGLONG GetSpinMargin() const { return SpinMargin; }
+		LONGLONG GetPresentTicks() const { return PresentTicks; }
+	};
+}
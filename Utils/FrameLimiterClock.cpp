@@ -0,0 +1,109 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include "Utils.h"
+#include "Logging\Logging.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+typedef HANDLE(WINAPI* CreateWaitableTimerExWProc)(LPSECURITY_ATTRIBUTES lpTimerAttributes, LPCWSTR lpTimerName, DWORD dwFlags, DWORD dwDesiredAccess);
+
+namespace
+{
+	// Performance counter clock that sleeps on a waitable timer
+	class TimerClock : public Utils::FrameLimiterClock
+	{
+	private:
+		LONGLONG Frequency = 0;
+		HANDLE hTimer = nullptr;
+
+		void CreateTimer();
+
+	public:
+		TimerClock()
+		{
+			LARGE_INTEGER Freq = {};
+			QueryPerformanceFrequency(&Freq);
+			Frequency = Freq.QuadPart;
+		}
+		~TimerClock()
+		{
+			if (hTimer)
+			{
+				CloseHandle(hTimer);
+			}
+		}
+
+		LONGLONG GetFrequency() override { return Frequency; }
+		LONGLONG GetTime() override
+		{
+			LARGE_INTEGER Time;
+			QueryPerformanceCounter(&Time);
+			return Time.QuadPart;
+		}
+		bool Sleep(LONGLONG Ticks) override;
+		void Spin(LONGLONG Ticks) override { Utils::BusyWaitYield(static_cast<DWORD>(Ticks * 1000 / Frequency)); }
+	};
+
+	void TimerClock::CreateTimer()
+	{
+		// High resolution timers need Windows 10 1803 or newer, older systems use a regular timer with the 1ms timer period
+		static CreateWaitableTimerExWProc pCreateWaitableTimerExW = []() {
+			HMODULE kernel32 = GetModuleHandleA("kernel32.dll");
+			return kernel32 ? (CreateWaitableTimerExWProc)GetProcAddress(kernel32, "CreateWaitableTimerExW") : nullptr;
+			}();
+
+		if (pCreateWaitableTimerExW)
+		{
+			hTimer = pCreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		}
+		if (!hTimer)
+		{
+			hTimer = CreateWaitableTimer(nullptr, TRUE, nullptr);
+		}
+		if (!hTimer)
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create waitable timer: " << GetLastError());
+		}
+	}
+
+	bool TimerClock::Sleep(LONGLONG Ticks)
+	{
+		if (!hTimer)
+		{
+			CreateTimer();
+		}
+
+		// Negative due time is relative, in 100 nanosecond units
+		LARGE_INTEGER DueTime = {};
+		DueTime.QuadPart = -(Ticks * 10000000 / Frequency);
+		if (DueTime.QuadPart < 0 && hTimer && SetWaitableTimer(hTimer, &DueTime, 0, nullptr, nullptr, FALSE))
+		{
+			WaitForSingleObject(hTimer, INFINITE);
+			return true;
+		}
+		return false;
+	}
+}
+
+Utils::FrameLimiter::FrameLimiter() : FrameLimiter(std::make_unique<TimerClock>())
+{
+}
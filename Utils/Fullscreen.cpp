@@ -18,6 +18,7 @@
 #include "shellapi.h"
 #include "Dllmain\Dllmain.h"
 #include "Utils.h"
+#include "WindowScore.h"
 #include "Logging\Logging.h"
 
 namespace Fullscreen
@@ -25,9 +26,10 @@ namespace Fullscreen
 	// Declare constants
 	static constexpr LONG MinWindowWidth = 4;			// Minimum window width for valid window check
 	static constexpr LONG MinWindowHeight = 4;			// Minimum window height for valid window check
-	static constexpr LONG WindowDelta = 40;				// Delta between window size and screensize for fullscreen check
 	static constexpr DWORD TerminationCount = 10;		// Minimum number of loops to check for termination
 	static constexpr DWORD TerminationWaitTime = 2000;	// Minimum time to wait for termination (LoopSleepTime * NumberOfLoops)
+	static constexpr DWORD IdleCheckTime = 1000;		// Maximum time to wait for window events before checking windows again
+	static constexpr DWORD IdlePumpTime = 100;			// Maximum time to wait for messages while waiting for window events
 
 	// Overload functions
 	bool operator==(const RECT& a, const RECT& b)
@@ -94,19 +96,12 @@ namespace Fullscreen
 		}
 	};
 
-	struct window_layer
-	{
-		HWND hwnd = nullptr;
-		bool IsMain = false;
-		bool IsFullScreen = false;
-	};
-
 	struct handle_data
 	{
 		DWORD process_id = 0;
 		HWND best_handle = nullptr;
 		DWORD LayerNumber = 0;
-		window_layer Windows[256];
+		std::vector<WINDOWDESC> Windows;
 		bool AutoDetect = true;
 		bool Debug = false;
 	};
@@ -117,11 +112,33 @@ namespace Fullscreen
 		bool Menu = false;
 	};
 
+	// Window calls used by the window info cache
+	struct window_calls
+	{
+		bool IsCompatWindow(HWND hwnd)
+		{
+			char class_name[80] = { 0 };
+			GetClassName(hwnd, class_name, sizeof(class_name));
+			return strcmp(class_name, "CompatWindowDesktopReplacement") == 0;
+		}
+
+		bool HasTitle(HWND hwnd)
+		{
+			char title[256] = { 0 };
+			GetWindowText(hwnd, title, sizeof(title) / sizeof(TCHAR));
+			return strlen(title) != 0;
+		}
+	};
+
 	// Declare variables
 	const bool& m_StopThreadFlag = Config.Exiting;
 	bool m_ThreadRunningFlag = false;
 	HANDLE m_hThread = nullptr;
 	DWORD m_dwThreadID = 0;
+	volatile LONG m_WindowEventFlag = FALSE;
+	bool m_WindowEventsHooked = false;
+	window_calls m_WindowCalls;
+	WindowInfoCache<window_calls> m_WindowInfo(m_WindowCalls);		// Only used by the fullscreen thread, window events are delivered to it
 
 	// Function declarations
 	void GetScreenSize(HWND, screen_res&, MONITORINFO&);
@@ -139,7 +156,10 @@ namespace Fullscreen
 	BOOL CALLBACK EnumChildWindowsProc(HWND, LPARAM);
 	void SendAltEnter(HWND&);
 	void SetFullScreen(HWND&, const MONITORINFO&);
-	void CheckForTermination(DWORD);
+	bool CheckForTermination(DWORD);
+	void CALLBACK WinEventProc(HWINEVENTHOOK, DWORD, HWND, LONG, LONG, DWORD, DWORD);
+	void PumpWindowEvents();
+	void WaitForWindowEvent(DWORD);
 	DWORD WINAPI StartThreadFunc(LPVOID);
 	void MainFunc();
 }
@@ -538,8 +558,7 @@ bool Fullscreen::IsWindowTooSmall(screen_res WindowSize)
 
 bool Fullscreen::IsWindowFullScreen(screen_res WindowSize, screen_res ScreenSize)
 {
-	return abs(ScreenSize.Width - WindowSize.Width) <= WindowDelta ||		// Window width matches screen width
-		abs(ScreenSize.Height - WindowSize.Height) <= WindowDelta;			// Window height matches screen height
+	return IsFullScreenSize(WindowSize.Width, WindowSize.Height, ScreenSize.Width, ScreenSize.Height);
 }
 
 bool Fullscreen::IsWindowNotFullScreen(screen_res WindowSize, screen_res ScreenSize)
@@ -571,9 +590,7 @@ BOOL CALLBACK Fullscreen::EnumWindowsCallback(HWND hwnd, LPARAM lParam)
 	}
 
 	// Skip compatibility class windows
-	char class_name[80] = { 0 };
-	GetClassName(hwnd, class_name, sizeof(class_name));
-	if (strcmp(class_name, "CompatWindowDesktopReplacement") == 0)			// Compatibility class windows
+	if (m_WindowInfo.IsCompatWindow(hwnd))
 	{
 		return true;
 	}
@@ -592,6 +609,8 @@ BOOL CALLBACK Fullscreen::EnumWindowsCallback(HWND hwnd, LPARAM lParam)
 	if (data.Debug)
 	{
 		++data.LayerNumber;
+		char class_name[80] = { 0 };
+		GetClassName(hwnd, class_name, sizeof(class_name));
 		char buffer[7] = { 0 };
 		_itoa_s(data.LayerNumber, buffer, 10);
 		char* isMain = "";
@@ -623,55 +642,31 @@ BOOL CALLBACK Fullscreen::EnumWindowsCallback(HWND hwnd, LPARAM lParam)
 		GetScreenSize(hwnd, ScreenSize, mi);
 
 		// Store window layer information
-		++data.LayerNumber;
-		data.Windows[data.LayerNumber].hwnd = hwnd;
-		data.Windows[data.LayerNumber].IsFullScreen = IsWindowFullScreen(WindowSize, ScreenSize);
-		data.Windows[data.LayerNumber].IsMain = (GetWindow(hwnd, GW_OWNER) == (HWND)0);
-
-		// Check if the window has a caption (to avoid tool windows and other non-main windows)
-		if (data.Windows[data.LayerNumber].IsMain)
+		WINDOWDESC Window;
+		Window.hwnd = hwnd;
+		Window.Width = WindowSize.Width;
+		Window.Height = WindowSize.Height;
+		Window.ScreenWidth = ScreenSize.Width;
+		Window.ScreenHeight = ScreenSize.Height;
+		Window.HasOwner = (GetWindow(hwnd, GW_OWNER) != (HWND)0);
+		Window.HasCaption = ((GetWindowLong(hwnd, GWL_STYLE) & WS_CAPTION) != 0);
+		Window.HasParent = (GetWindowLong(hwnd, GWL_HWNDPARENT) != 0);
+		Window.HasTitle = m_WindowInfo.HasTitle(hwnd);
+		Window.IsVisible = (IsWindowVisible(hwnd) != FALSE);
+		data.Windows.push_back(Window);
+
+		// Stop at the first visible fullscreen main window
+		if (Window.IsVisible && IsFullScreenWindow(Window) && IsMainWindow(Window))
 		{
-			LONG style = GetWindowLong(hwnd, GWL_STYLE);
-			if ((style & WS_CAPTION) == 0)
-			{
-				data.Windows[data.LayerNumber].IsMain = false;
-			}
-		}
-
-		// Check if the window is not a child window
-		if (data.Windows[data.LayerNumber].IsMain)
-		{
-			if (GetWindowLong(hwnd, GWL_HWNDPARENT) != 0)
-			{
-				data.Windows[data.LayerNumber].IsMain = false;
-			}
-		}
-
-		// Check if the window has a significant title
-		if (data.Windows[data.LayerNumber].IsMain)
-		{
-			char title[256];
-			GetWindowText(hwnd, title, sizeof(title) / sizeof(TCHAR));
-			if (strlen(title) == 0)
-			{
-				data.Windows[data.LayerNumber].IsMain = false;
-			}
-		}
-
-		// Check if the window is the best window
-		if (data.Windows[data.LayerNumber].IsFullScreen && data.Windows[data.LayerNumber].IsMain)
-		{
-			// Match found returning value
-			data.best_handle = hwnd;
-			if (IsWindowVisible(hwnd))
-			{
-				return false;
-			}
+			return false;
 		}
 	}
 	// Manually search windows for a specific window
 	else
 	{
+		char class_name[80] = { 0 };
+		GetClassName(hwnd, class_name, sizeof(class_name));
+
 		// Check other windows for a match
 		if ((Config.SetNamedLayer.size() == 0 && ++data.LayerNumber == Config.SetFullScreenLayer) ||		// Check for specific window layer
 			Settings::IfStringExistsInList(class_name, Config.SetNamedLayer))								// Check for specific window class name
@@ -698,32 +693,21 @@ HWND Fullscreen::FindMainWindow(DWORD process_id, bool AutoDetect, bool Debug)
 	data.LayerNumber = 0;
 	data.Debug = Debug;
 
+	// Deliver queued window events so the window info cache is current, without the events it can't be kept
+	PumpWindowEvents();
+	if (!m_WindowEventsHooked)
+	{
+		m_WindowInfo.Clear();
+	}
+
 	// Gets all window layers and looks for a main window that is fullscreen
 	EnumWindows(EnumWindowsCallback, (LPARAM)&data);
 	WindowsHandle = data.best_handle;
 
-	// If no main fullscreen window found then check for other windows
-	if (!WindowsHandle)
-	{
-		for (DWORD x = 1; x <= data.LayerNumber; x++)
-		{
-			// Return the first fullscreen window layer
-			if (data.Windows[x].IsFullScreen)
-			{
-				return data.Windows[x].hwnd;
-			}
-			// If no fullscreen layer then return the first 'main' window
-			if (!WindowsHandle && data.Windows[x].IsMain)
-			{
-				WindowsHandle = data.Windows[x].hwnd;
-			}
-		}
-	}
-
-	// Get first window handle if no handle has been found yet
-	if (!WindowsHandle && data.LayerNumber > 0)
+	// If no specific window layer was found then pick the best of the window layers
+	if (!WindowsHandle && !data.Windows.empty())
 	{
-		WindowsHandle = data.Windows[1].hwnd;
+		WindowsHandle = data.Windows[SelectMainWindow(data.Windows)].hwnd;
 	}
 
 	// Return the best handle
@@ -819,8 +803,8 @@ void Fullscreen::SetFullScreen(HWND& hwnd, const MONITORINFO& mi)
 // Process Termination check function below
 //*********************************************************************************
 
-// Check if process should be termianted
-void Fullscreen::CheckForTermination(DWORD m_ProcessId)
+// Check if process should be termianted, returns true while waiting to terminate
+bool Fullscreen::CheckForTermination(DWORD m_ProcessId)
 {
 	static DWORD countAttempts = 0;
 	static bool FoundWindow = false;
@@ -879,6 +863,50 @@ void Fullscreen::CheckForTermination(DWORD m_ProcessId)
 	{
 		countAttempts = 0;
 	}
+
+	return (countAttempts != 0);
+}
+
+
+//*********************************************************************************
+// Window event functions below
+//*********************************************************************************
+
+// Flags any change to the windows of this process
+void CALLBACK Fullscreen::WinEventProc(HWINEVENTHOOK, DWORD Event, HWND hwnd, LONG idObject, LONG idChild, DWORD, DWORD)
+{
+	if (hwnd && idObject == OBJID_WINDOW && idChild == CHILDID_SELF)
+	{
+		m_WindowInfo.OnWindowEvent(Event, hwnd);
+		InterlockedExchange(&m_WindowEventFlag, TRUE);
+	}
+}
+
+// Delivers the queued window events, out of context events are only delivered while this thread checks its messages
+void Fullscreen::PumpWindowEvents()
+{
+	MSG msg;
+	while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+	{
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+}
+
+// Waits until a window event is received or the timeout expires, window events are delivered while pumping messages
+void Fullscreen::WaitForWindowEvent(DWORD Timeout)
+{
+	const DWORD StartTime = GetTickCount();
+	DWORD Elapsed = 0;
+
+	while (!InterlockedExchange(&m_WindowEventFlag, FALSE) && !m_StopThreadFlag && Elapsed < Timeout)
+	{
+		MsgWaitForMultipleObjects(0, nullptr, FALSE, min(Timeout - Elapsed, IdlePumpTime), QS_ALLINPUT);
+
+		PumpWindowEvents();
+
+		Elapsed = GetTickCount() - StartTime;
+	}
 }
 
 
@@ -979,6 +1007,7 @@ void Fullscreen::MainFunc()
 	bool NoChangeFromLastRunFlag = false;
 	bool HasNoMenu = false;
 	bool IsNotFullScreenFlag = false;
+	bool WaitForEvents = false;
 
 	// Get process ID
 	DWORD m_ProcessId = GetCurrentProcessId();
@@ -986,6 +1015,16 @@ void Fullscreen::MainFunc()
 	// Short sleep to allow other items to load
 	Sleep(100);
 
+	// Get notified of window changes so the windows are only checked again after something changed
+	const DWORD HookFlags = WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNTHREAD;
+	HWINEVENTHOOK hObjectHook = SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_NAMECHANGE, nullptr, WinEventProc, m_ProcessId, 0, HookFlags);
+	HWINEVENTHOOK hSystemHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_MINIMIZEEND, nullptr, WinEventProc, m_ProcessId, 0, HookFlags);
+	if (!hObjectHook || !hSystemHook)
+	{
+		Logging::Log() << __FUNCTION__ << " Warning: failed to set window event hooks, falling back to polling!";
+	}
+	m_WindowEventsHooked = (hObjectHook != nullptr);
+
 	// Start main fullscreen loop
 	while (!m_StopThreadFlag)
 	{
@@ -994,6 +1033,9 @@ void Fullscreen::MainFunc()
 		Logging::Log() << "Starting Main Fullscreen loop...";
 #endif
 
+		// Wait for window events once nothing is changing
+		WaitForEvents = true;
+
 		// Get window hwnd for specific layer
 		CurrentLoop.hwnd = FindMainWindow(m_ProcessId, false);
 
@@ -1021,6 +1063,9 @@ void Fullscreen::MainFunc()
 			// Check if there is no change from the last run
 			NoChangeFromLastRunFlag = (CurrentLoop == PreviousLoop);
 
+			// Keep checking while the window or screen is changing
+			WaitForEvents = (!ChangeDetectedFlag && NoChangeFromLastRunFlag);
+
 #ifdef _DEBUG
 			// Debug window changes
 			if (ChangeDetectedFlag)
@@ -1184,10 +1229,10 @@ void Fullscreen::MainFunc()
 		// Store last loop information
 		PreviousLoop = CurrentLoop;
 
-		// Check if appliction needs to be terminated
-		if (Config.ForceTermination)
+		// Check if appliction needs to be terminated, keep checking while waiting to terminate
+		if (Config.ForceTermination && CheckForTermination(m_ProcessId))
 		{
-			CheckForTermination(m_ProcessId);
+			WaitForEvents = false;
 		}
 
 #ifdef _DEBUG
@@ -1198,5 +1243,23 @@ void Fullscreen::MainFunc()
 		// Wait for a while
 		Sleep(Config.LoopSleepTime + (ChangeDetectedFlag * Config.WaitForWindowChanges * Config.WindowSleepTime));
 
+		// Wait for window changes
+		if (WaitForEvents && hObjectHook && hSystemHook)
+		{
+			WaitForWindowEvent(IdleCheckTime);
+		}
+
 	} // Main while loop
+
+	// Remove window event hooks
+	m_WindowEventsHooked = false;
+	m_WindowInfo.Clear();
+	if (hObjectHook)
+	{
+		UnhookWinEvent(hObjectHook);
+	}
+	if (hSystemHook)
+	{
+		UnhookWinEvent(hSystemHook);
+	}
 }
@@ -0,0 +1,95 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <vector>
+#include <algorithm>
+
+namespace Utils
+{
+	// Threads watched by the priority monitor. Each thread is checked on its own schedule: soon
+	// after it is added or its priority had to be fixed, then less often while it stays stable.
+	// Times are tick counts passed in by the caller. T provides the thread calls:
+	//   HANDLE OpenThread(DWORD threadId)	returns nullptr if the thread can't be opened
+	//   bool IsRunning(HANDLE hThread)
+	//   bool FixPriority(HANDLE hThread)	returns true if the priority had to be fixed
+	//   void CloseThread(HANDLE hThread)
+	template <typename T>
+	class ThreadMonitor
+	{
+	public:
+		static constexpr DWORD MinCheckInterval = 10;
+		static constexpr DWORD MaxCheckInterval = 1000;
+
+		struct MONITOREDTHREAD {
+			DWORD threadId;
+			HANDLE hThread;
+			DWORD NextCheck;
+			DWORD Interval;
+		};
+
+	private:
+		T& Calls;
+		std::vector<MONITOREDTHREAD> Threads;
+
+	public:
+		ThreadMonitor(T& p_Calls) : Calls(p_Calls) {}
+		~ThreadMonitor()
+		{
+			for (auto& Thread : Threads)
+			{
+				Calls.CloseThread(Thread.hThread);
+			}
+		}
+
+		const std::vector<MONITOREDTHREAD>& GetThreads() const { return Threads; }
+
+		// Adds a thread to be checked now, threads already monitored are not added again
+		void Add(DWORD threadId, DWORD Now)
+		{
+			// Thread ids are reused, so an entry for an exited thread is replaced by the new thread
+			auto it = std::find_if(Threads.begin(), Threads.end(), [threadId](const MONITOREDTHREAD& Thread) { return Thread.threadId == threadId; });
+			if (it != Threads.end())
+			{
+				if (Calls.IsRunning(it->hThread))
+				{
+					return;
+				}
+				Calls.CloseThread(it->hThread);
+				Threads.erase(it);
+			}
+
+			HANDLE hThread = Calls.OpenThread(threadId);
+			if (hThread)
+			{
+				// First check finds the thread stable and doubles this to the minimum interval
+				Threads.push_back({ threadId, hThread, Now, MinCheckInterval / 2 });
+			}
+		}
+
+		// Checks the threads that are due, drops the ones that exited and returns the time until the next check
+		DWORD CheckDue(DWORD Now)
+		{
+			DWORD Timeout = INFINITE;
+			for (auto it = Threads.begin(); it != Threads.end(); )
+			{
+				if ((LONG)(it->NextCheck - Now) <= 0)
+				{
+					if (!Calls.IsRunning(it->hThread))
+					{
+						Calls.CloseThread(it->hThread);
+						it = Threads.erase(it);
+						continue;
+					}
+
+					// Check again soon after a change, back off while the priority is stable
+					it->Interval = Calls.FixPriority(it->hThread) ? MinCheckInterval : (std::min)(it->Interval * 2, MaxCheckInterval);
+					it->NextCheck = Now + it->Interval;
+				}
+				Timeout = (std::min)(Timeout, (DWORD)(std::max)((LONG)(it->NextCheck - Now), (LONG)0));
+				++it;
+			}
+			return Timeout;
+		}
+	};
+}
@@ -5,6 +5,7 @@
 #include "Wrappers\wrapper.h"
 #include "External\MemoryModule\MemoryModule.h"
 #include "Logging\Logging.h"
+#include "FrameLimiter.h"
 #ifndef _TIMERAPI_H_
 #include "winmm.h"
 #endif
@@ -117,6 +118,7 @@ namespace Utils
 	void ApplyThreadAffinity();
 	void StartPriorityMonitor();
 	void StopPriorityMonitor();
+	void AddPriorityMonitorThread(DWORD threadId);
 
 	static inline void my_cpuid(int cpuInfo[4], int function_id)
 	{
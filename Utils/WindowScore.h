@@ -0,0 +1,171 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <vector>
+#include <unordered_map>
+#include <cstdlib>
+
+namespace Fullscreen
+{
+	static constexpr LONG WindowDelta = 40;				// Delta between window size and screensize for fullscreen check
+
+	// What the fullscreen thread knows about a top level window when it picks the main window
+	struct WINDOWDESC
+	{
+		HWND hwnd = nullptr;
+		LONG Width = 0;
+		LONG Height = 0;
+		LONG ScreenWidth = 0;		// Size of the monitor the window is on
+		LONG ScreenHeight = 0;
+		bool HasOwner = false;
+		bool HasCaption = false;
+		bool HasParent = false;
+		bool HasTitle = false;
+		bool IsVisible = false;
+	};
+
+	inline bool IsFullScreenSize(LONG Width, LONG Height, LONG ScreenWidth, LONG ScreenHeight)
+	{
+		return abs(ScreenWidth - Width) <= WindowDelta ||		// Window width matches screen width
+			abs(ScreenHeight - Height) <= WindowDelta;			// Window height matches screen height
+	}
+
+	inline bool IsFullScreenWindow(const WINDOWDESC& Window)
+	{
+		return IsFullScreenSize(Window.Width, Window.Height, Window.ScreenWidth, Window.ScreenHeight);
+	}
+
+	// Main windows are unowned top level windows with a caption and a title, this skips tool windows and other non-main windows
+	inline bool IsMainWindow(const WINDOWDESC& Window)
+	{
+		return !Window.HasOwner && Window.HasCaption && !Window.HasParent && Window.HasTitle;
+	}
+
+	// Returns the index of the best window of the windows in z-order, or the window count if there are none.
+	// Picks a visible fullscreen main window, then the last hidden one, then the first fullscreen window,
+	// then the first main window and then the top window.
+	inline size_t SelectMainWindow(const std::vector<WINDOWDESC>& Windows)
+	{
+		size_t Best = Windows.size();
+		for (size_t x = 0; x < Windows.size(); x++)
+		{
+			if (IsFullScreenWindow(Windows[x]) && IsMainWindow(Windows[x]))
+			{
+				Best = x;
+				if (Windows[x].IsVisible)
+				{
+					return x;
+				}
+			}
+		}
+		if (Best < Windows.size())
+		{
+			return Best;
+		}
+
+		for (size_t x = 0; x < Windows.size(); x++)
+		{
+			if (IsFullScreenWindow(Windows[x]))
+			{
+				return x;
+			}
+			if (Best == Windows.size() && IsMainWindow(Windows[x]))
+			{
+				Best = x;
+			}
+		}
+		return (Best < Windows.size()) ? Best : 0;
+	}
+
+	// Caches the window details that only change with a window event, so each scan only asks for the size,
+	// style and owner. The title is asked with a message to the window's thread, so it is the slow part.
+	// Windows are asked again after a create or destroy event and the title after a name change event.
+	// T provides the window calls:
+	//   bool IsCompatWindow(HWND hwnd)	returns true for compatibility layer windows
+	//   bool HasTitle(HWND hwnd)
+	template <typename T>
+	class WindowInfoCache
+	{
+	private:
+		struct WINDOWINFO
+		{
+			bool IsCompatWindow = false;
+			bool HasTitle = false;
+			bool IsTitleKnown = false;
+		};
+
+		T& Calls;
+		std::unordered_map<HWND, WINDOWINFO> Windows;
+
+		// The window calls can run window event callbacks that change the map, so they are made before
+		// an entry is looked up and no entry reference is held across them
+		WINDOWINFO& GetInfo(HWND hwnd)
+		{
+			auto it = Windows.find(hwnd);
+			if (it == Windows.end())
+			{
+				const bool IsCompat = Calls.IsCompatWindow(hwnd);
+				auto Result = Windows.emplace(hwnd, WINDOWINFO());
+				if (Result.second)
+				{
+					Result.first->second.IsCompatWindow = IsCompat;
+				}
+				it = Result.first;
+			}
+			return it->second;
+		}
+
+	public:
+		WindowInfoCache(T& p_Calls) : Calls(p_Calls) {}
+
+		size_t GetCount() const { return Windows.size(); }
+
+		bool IsCompatWindow(HWND hwnd)
+		{
+			return GetInfo(hwnd).IsCompatWindow;
+		}
+
+		bool HasTitle(HWND hwnd)
+		{
+			auto it = Windows.find(hwnd);
+			if (it != Windows.end() && it->second.IsTitleKnown)
+			{
+				return it->second.HasTitle;
+			}
+
+			// Asking the title sends a message to the window's thread, which can run OnWindowEvent
+			const bool Title = Calls.HasTitle(hwnd);
+			WINDOWINFO& Info = GetInfo(hwnd);
+			Info.HasTitle = Title;
+			Info.IsTitleKnown = true;
+			return Title;
+		}
+
+		// Window handles are reused, so a created window is asked again like a destroyed one
+		void OnWindowEvent(DWORD Event, HWND hwnd)
+		{
+			switch (Event)
+			{
+			case EVENT_OBJECT_CREATE:
+			case EVENT_OBJECT_DESTROY:
+				Windows.erase(hwnd);
+				break;
+			case EVENT_OBJECT_NAMECHANGE:
+			{
+				auto it = Windows.find(hwnd);
+				if (it != Windows.end())
+				{
+					it->second.IsTitleKnown = false;
+				}
+				break;
+			}
+			}
+		}
+
+		void Clear()
+		{
+			Windows.clear();
+		}
+	};
+}
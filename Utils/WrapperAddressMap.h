@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <array>
+
+// Maps proxy addresses to wrapper objects for each cache index. Every wrapper also has one reverse entry
+// with its cache index and keys, so finding, moving and removing a wrapper each need a single lookup.
+template <typename O, size_t IndexCount, size_t KeyCount = 1>
+class WrapperAddressMap
+{
+public:
+	using KEYLIST = std::array<void*, KeyCount>;
+
+private:
+	struct WRAPPERENTRY {
+		size_t CacheIndex = 0;
+		KEYLIST Keys = {};
+	};
+	std::unordered_map<void*, O*> g_map[IndexCount];
+	std::unordered_map<O*, WRAPPERENTRY> reverse_map;
+
+	void EraseKeys(O* Wrapper, const WRAPPERENTRY& Entry)
+	{
+		// Keys claimed by another wrapper since are left alone
+		auto& map = g_map[Entry.CacheIndex];
+		for (void* Key : Entry.Keys)
+		{
+			auto it = map.find(Key);
+			if (it != map.end() && it->second == Wrapper)
+			{
+				map.erase(it);
+			}
+		}
+	}
+
+public:
+	O* Find(size_t CacheIndex, void* Key) const
+	{
+		auto it = g_map[CacheIndex].find(Key);
+		return (it != g_map[CacheIndex].end()) ? it->second : nullptr;
+	}
+
+	// Checks if the wrapper is saved under a cache index in the range
+	bool IsSaved(O* Wrapper, size_t StartIndex, size_t EndIndex) const
+	{
+		auto it = reverse_map.find(Wrapper);
+		return (it != reverse_map.end() && it->second.CacheIndex >= StartIndex && it->second.CacheIndex <= EndIndex);
+	}
+
+	size_t GetKeyCount(size_t CacheIndex) const { return g_map[CacheIndex].size(); }
+	size_t GetWrapperCount() const { return reverse_map.size(); }
+
+	void Save(O* Wrapper, size_t CacheIndex, const KEYLIST& Keys)
+	{
+		WRAPPERENTRY& Entry = reverse_map[Wrapper];
+
+		// Drop the previous keys if this wrapper is being moved
+		EraseKeys(Wrapper, Entry);
+
+		for (void* Key : Keys)
+		{
+			g_map[CacheIndex][Key] = Wrapper;
+		}
+		Entry.CacheIndex = CacheIndex;
+		Entry.Keys = Keys;
+	}
+
+	// Returns false if the wrapper was not saved
+	bool Erase(O* Wrapper)
+	{
+		auto entry = reverse_map.find(Wrapper);
+		if (entry == reverse_map.end())
+		{
+			return false;
+		}
+
+		EraseKeys(Wrapper, entry->second);
+		reverse_map.erase(entry);
+		return true;
+	}
+
+	// Deletes each wrapper once, even when it is saved with several keys
+	template <typename F>
+	void DeleteAll(F IsDeletable)
+	{
+		std::vector<O*> List;
+		for (const auto& entry : reverse_map)
+		{
+			if (IsDeletable(entry.second.CacheIndex))
+			{
+				List.push_back(entry.first);
+			}
+		}
+
+		for (O* Wrapper : List)
+		{
+			// Skip wrappers already removed by an earlier destructor in this loop
+			if (Erase(Wrapper))
+			{
+				delete Wrapper;
+			}
+		}
+	}
+};
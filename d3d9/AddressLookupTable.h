@@ -2,6 +2,7 @@
 
 #include "Settings\Settings.h"
 #include "Logging\Logging.h"
+#include "Utils\WrapperAddressMap.h"
 
 class AddressLookupTableD3d9Object
 {
@@ -15,7 +16,10 @@ private:
 	static constexpr size_t MaxCacheIndex = 15;
 
 	bool ConstructorFlag = false;
-	std::unordered_map<void*, class AddressLookupTableD3d9Object*> g_map[MaxCacheIndex];
+
+	// Each wrapper is keyed by its IUnknown identity, resolved once when the wrapper is saved, and by the
+	// proxy pointer it wraps, so lookups with the same pointer skip QueryInterface.
+	WrapperAddressMap<AddressLookupTableD3d9Object, MaxCacheIndex, 2> AddressMap;
 
 	template <typename T>
 	struct AddressCacheIndex {};
@@ -71,10 +75,14 @@ private:
 	{
 		constexpr size_t CacheIndex = AddressCacheIndex<T>::CacheIndex;
 
-		auto it = g_map[CacheIndex].find(GetIndentityInterface<T>(Proxy));
-		if (it != std::end(g_map[CacheIndex]))
+		AddressLookupTableD3d9Object* Object = AddressMap.Find(CacheIndex, Proxy);
+		if (!Object)
+		{
+			Object = AddressMap.Find(CacheIndex, GetIndentityInterface<T>(Proxy));
+		}
+		if (Object)
 		{
-			T* addr = static_cast<T*>(it->second);
+			T* addr = static_cast<T*>(Object);
 			addr->AddRef();
 			Proxy->Release();
 			return addr;
@@ -139,12 +147,9 @@ public:
 	{
 		constexpr size_t CacheIndex = AddressCacheIndex<T>::CacheIndex;
 
-		for (const auto& pair : g_map[CacheIndex])
+		if (AddressMap.IsSaved(WrapperInterface, CacheIndex, CacheIndex))
 		{
-			if (pair.second == WrapperInterface)
-			{
-				return WrapperInterface->GetProxyInterface();
-			}
+			return WrapperInterface->GetProxyInterface();
 		}
 
 		return nullptr;
@@ -163,19 +168,19 @@ public:
 		IUnknown* identity = GetIndentityInterface<T>(Proxy);
 
 		// Check if the entry already exists in the map
-		auto it = g_map[CacheIndex].find(identity);
-		if (it != g_map[CacheIndex].end())
+		for (void* Key : { (void*)identity, (void*)Proxy })
 		{
-			// If the entry exists, delete the existing object
-			if (it->second)
+			AddressLookupTableD3d9Object* Object = AddressMap.Find(CacheIndex, Key);
+			if (Object && Object != Wrapper)
 			{
-				delete it->second;
-				DeleteAddress((T*)it->second);
+				// If the entry exists, delete the existing object
+				AddressMap.Erase(Object);
+				delete Object;
 			}
 		}
 
 		// Now save the new entry in the map
-		g_map[CacheIndex][identity] = Wrapper;
+		AddressMap.Save(Wrapper, CacheIndex, { identity, Proxy });
 	}
 
 	template <typename T>
@@ -186,27 +191,12 @@ public:
 			return;
 		}
 
-		constexpr size_t CacheIndex = AddressCacheIndex<T>::CacheIndex;
-
-		auto it = std::find_if(g_map[CacheIndex].begin(), g_map[CacheIndex].end(),
-			[=](auto& Map) -> bool { return Map.second == Wrapper; });
-		if (it != std::end(g_map[CacheIndex]))
-		{
-			g_map[CacheIndex].erase(it);
-		}
+		AddressMap.Erase(Wrapper);
 	}
 
 	void DeleteAll()
 	{
-		for (auto& map : g_map)
-		{
-			while (!map.empty())
-			{
-				auto it = map.begin();
-				delete it->second;
-				map.erase(it);
-			}
-		}
+		AddressMap.DeleteAll([](size_t) { return true; });
 	}
 };
 
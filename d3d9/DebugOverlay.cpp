@@ -142,8 +142,12 @@ void DebugOverlay::EndScene()
 	{
 		std::stringstream stats;
 		stats << "FPS: " << (DWORD)(AverageFPS * 100) / 100.0f << '\n';
+		stats << "1% low: " << (DWORD)(Low1FPS * 100) / 100.0f << '\n';
+		stats << "0.1% low: " << (DWORD)(Low01FPS * 100) / 100.0f << '\n';
+		stats << "Stutters: " << WindowStutters << " (" << TotalStutters << " total)" << '\n';
 		ImGui::Begin("Stats");
 		ImGui::Text(stats.str().c_str());
+		ImGui::PlotLines("Frame time (ms)", FrameTimeGraph, FrameStats::GraphSize, FrameTimeGraphOffset, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
 		ImGui::End();
 
 		std::stringstream matrices;
@@ -261,6 +265,16 @@ void DebugOverlay::SetFPSCount(double FPS)
 	AverageFPS = FPS;
 }
 
+void DebugOverlay::SetFrameStats(const FrameStats& Stats)
+{
+	Low1FPS = Stats.GetLow1FPS();
+	Low01FPS = Stats.GetLow01FPS();
+	WindowStutters = Stats.GetWindowStutters();
+	TotalStutters = Stats.GetTotalStutters();
+	memcpy(FrameTimeGraph, Stats.GetGraph(), sizeof(FrameTimeGraph));
+	FrameTimeGraphOffset = Stats.GetGraphOffset();
+}
+
 void DebugOverlay::SetLight(DWORD dwLightIndex, LPD3DLIGHT7 lpLight)
 {
 	bool found = false;
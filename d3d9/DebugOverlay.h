@@ -8,6 +8,7 @@
 #include <d3d9.h>
 #include <ddraw.h>
 #include <d3dtypes.h>
+#include "FrameStats.h"
 
 class DebugOverlay
 {
@@ -19,6 +20,10 @@ private:
 
 	// Frame counter
 	double AverageFPS = 0.0f;
+	double Low1FPS = 0.0, Low01FPS = 0.0;
+	DWORD WindowStutters = 0, TotalStutters = 0;
+	float FrameTimeGraph[FrameStats::GraphSize] = {};
+	DWORD FrameTimeGraphOffset = 0;
 
 	// Store debug matrix information
 	D3DMATRIX worldMatrix = {}, viewMatrix = {}, projectionMatrix = {};
@@ -66,6 +71,7 @@ public:
 	bool IsSetup() { return IsContextSetup; }
 	LPDIRECT3DDEVICE9 Getd3d9Device() { return d3d9Device; }
 	void SetFPSCount(double FPS);
+	void SetFrameStats(const FrameStats& Stats);
 	void SetTransform(D3DTRANSFORMSTATETYPE dtstTransformStateType, LPD3DMATRIX lpD3DMatrix);
 	void SetLight(DWORD dwLightIndex, LPD3DLIGHT7 lpLight);
 	void LightEnable(DWORD dwLightIndex, BOOL bEnable);
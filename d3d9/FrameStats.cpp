@@ -0,0 +1,129 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "FrameStats.h"
+#include <cmath>
+#include <cstring>
+
+void FrameStats::AddSample(DWORD Bucket)
+{
+	Counts[Bucket]++;
+	for (auto& entry : Rank)
+	{
+		if (Bucket < entry.Bucket)
+		{
+			entry.Below++;
+		}
+	}
+}
+
+void FrameStats::RemoveSample(DWORD Bucket)
+{
+	Counts[Bucket]--;
+	for (auto& entry : Rank)
+	{
+		if (Bucket < entry.Bucket)
+		{
+			entry.Below--;
+		}
+	}
+}
+
+void FrameStats::RemoveOldestFrame()
+{
+	const FRAMEENTRY& Oldest = Frames[FirstFrame];
+	WindowSum -= Oldest.Time;
+	WindowStutters -= Oldest.Stutter ? 1 : 0;
+	RemoveSample(GetBucket(Oldest.Time));
+	FirstFrame = (FirstFrame + 1) & (MaxFrames - 1);
+	FrameCount--;
+}
+
+void FrameStats::UpdateRanks()
+{
+	if (!FrameCount)
+	{
+		for (auto& entry : Rank)
+		{
+			entry.Bucket = 0;
+			entry.Below = 0;
+		}
+		return;
+	}
+
+	for (auto& entry : Rank)
+	{
+		// One based index of the sample this rank points at in the sorted window
+		DWORD Target = (DWORD)ceil(FrameCount * entry.Fraction);
+		if (Target < 1) Target = 1;
+		if (Target > FrameCount) Target = FrameCount;
+
+		while (entry.Below >= Target)
+		{
+			entry.Bucket--;
+			entry.Below -= Counts[entry.Bucket];
+		}
+		while (entry.Below + Counts[entry.Bucket] < Target)
+		{
+			entry.Below += Counts[entry.Bucket];
+			entry.Bucket++;
+		}
+	}
+}
+
+bool FrameStats::AddFrame(DWORD Time)
+{
+	// Compare against the window before this frame so a spike does not raise its own threshold
+	const bool Stutter = (FrameCount >= 8 && Time > StutterFactor * GetMedianTime());
+
+	if (FrameCount == MaxFrames)
+	{
+		RemoveOldestFrame();
+	}
+
+	Frames[(FirstFrame + FrameCount) & (MaxFrames - 1)] = { Time, Stutter };
+	FrameCount++;
+	WindowSum += Time;
+	WindowStutters += Stutter ? 1 : 0;
+	TotalStutters += Stutter ? 1 : 0;
+	AddSample(GetBucket(Time));
+
+	// Remove frames that ended more than the window time ago
+	while (FrameCount > 1 && WindowSum - Frames[FirstFrame].Time > WindowTime)
+	{
+		RemoveOldestFrame();
+	}
+
+	UpdateRanks();
+
+	Graph[GraphOffset] = Time / 1000.0f;
+	GraphOffset = (GraphOffset + 1) % GraphSize;
+
+	return Stutter;
+}
+
+void FrameStats::clear()
+{
+	FirstFrame = 0;
+	FrameCount = 0;
+	WindowSum = 0;
+	WindowStutters = 0;
+	TotalStutters = 0;
+	memset(Counts, 0, sizeof(Counts));
+	UpdateRanks();
+	memset(Graph, 0, sizeof(Graph));
+	GraphOffset = 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <windows.h>
+
+// Rolling frame time statistics over the last second of frames. Frame times are fed in
+// microseconds, so the class has no dependency on the device or the clock. Nothing is re-summed
+// per frame: the window sum is adjusted for the frame added and the frames evicted, and the median
+// and low percentiles are tracked ranks in a fixed-bucket histogram that only step past the
+// buckets between their old and new position.
+class FrameStats
+{
+public:
+	static constexpr DWORD WindowTime = 1000000;	// Microseconds of frames kept in the window
+	static constexpr DWORD MaxFrames = 8192;		// Frames kept in the window, must be a power of two
+	static constexpr DWORD GraphSize = 256;			// Frames kept for the overlay graph
+	static constexpr DWORD StutterFactor = 2;		// Frames above this multiple of the median are stutters
+
+private:
+	static constexpr DWORD BucketTime = 50;			// Microseconds per histogram bucket
+	static constexpr DWORD BucketCount = 4000;		// Frame times of 200ms and above share the last bucket
+
+	enum { RANK_MEDIAN, RANK_LOW1, RANK_LOW01, RANK_COUNT };
+
+	// Bucket holding the sample at a given fraction of the sorted window, and the number of
+	// samples in the buckets below it
+	struct RANKTRACKER {
+		double Fraction;
+		DWORD Bucket;
+		DWORD Below;
+	};
+
+	struct FRAMEENTRY {
+		DWORD Time;
+		bool Stutter;
+	};
+
+	FRAMEENTRY Frames[MaxFrames] = {};
+	DWORD FirstFrame = 0;
+	DWORD FrameCount = 0;
+	ULONGLONG WindowSum = 0;
+	DWORD WindowStutters = 0;
+	DWORD TotalStutters = 0;
+
+	DWORD Counts[BucketCount] = {};
+	RANKTRACKER Rank[RANK_COUNT] = { { 0.5, 0, 0 }, { 0.99, 0, 0 }, { 0.999, 0, 0 } };
+
+	float Graph[GraphSize] = {};
+	DWORD GraphOffset = 0;
+
+	static DWORD GetBucket(DWORD Time) { return (Time / BucketTime < BucketCount) ? Time / BucketTime : BucketCount - 1; }
+	static DWORD GetBucketTime(DWORD Bucket) { return Bucket * BucketTime + BucketTime / 2; }
+
+	void AddSample(DWORD Bucket);
+	void RemoveSample(DWORD Bucket);
+	void RemoveOldestFrame();
+	void UpdateRanks();
+	DWORD GetRankTime(DWORD Index) const { return FrameCount ? GetBucketTime(Rank[Index].Bucket) : 0; }
+
+public:
+	// Adds a frame and returns true if it was a stutter
+	bool AddFrame(DWORD Time);
+	void clear();
+
+	DWORD GetFrameCount() const { return FrameCount; }
+	double GetAverageTime() const { return FrameCount ? (double)WindowSum / FrameCount : 0.0; }
+	double GetAverageFPS() const { return WindowSum ? 1000000.0 * FrameCount / WindowSum : 0.0; }
+	DWORD GetMedianTime() const { return GetRankTime(RANK_MEDIAN); }
+	double GetLow1FPS() const { return FrameCount ? 1000000.0 / GetRankTime(RANK_LOW1) : 0.0; }
+	double GetLow01FPS() const { return FrameCount ? 1000000.0 / GetRankTime(RANK_LOW01) : 0.0; }
+	DWORD GetWindowStutters() const { return WindowStutters; }
+	DWORD GetTotalStutters() const { return TotalStutters; }
+
+	// Frame times in milliseconds, oldest first when read from Offset, for ImGui::PlotLines
+	const float* GetGraph() const { return Graph; }
+	DWORD GetGraphOffset() const { return GraphOffset; }
+};
@@ -444,12 +444,22 @@ HRESULT m_IDirect3DDevice9Ex::Present(CONST RECT* pSourceRect, CONST RECT* pDest
 
 	ApplyPrePresentFixes();
 
+	// Limit frame rate before presenting so the present finishes on the frame cadence
+	if (Config.LimitPerFrameFPS)
+	{
+		LimitFrameRate();
+	}
+
 	HRESULT hr = ProxyInterface->Present(pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion);
 
 	if (SUCCEEDED(hr))
 	{
 		ApplyPostPresentFixes();
 	}
+	else if (Config.LimitPerFrameFPS)
+	{
+		FrameLimiter.CancelPresent();
+	}
 
 	return hr;
 }
@@ -2155,12 +2165,22 @@ HRESULT m_IDirect3DDevice9Ex::PresentEx(THIS_ CONST RECT* pSourceRect, CONST REC
 
 	ApplyPrePresentFixes();
 
+	// Limit frame rate before presenting so the present finishes on the frame cadence
+	if (Config.LimitPerFrameFPS)
+	{
+		LimitFrameRate();
+	}
+
 	HRESULT hr = ProxyInterfaceEx->PresentEx(pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion, dwFlags);
 
 	if (SUCCEEDED(hr))
 	{
 		ApplyPostPresentFixes();
 	}
+	else if (Config.LimitPerFrameFPS)
+	{
+		FrameLimiter.CancelPresent();
+	}
 
 	return hr;
 }
@@ -2636,7 +2656,7 @@ void m_IDirect3DDevice9Ex::ApplyPostPresentFixes()
 
 	if (Config.LimitPerFrameFPS)
 	{
-		LimitFrameRate();
+		FrameLimiter.EndPresent();
 	}
 
 	if (Config.ShowFPSCounter || Config.EnableImgui)
@@ -2699,94 +2719,50 @@ bool m_IDirect3DDevice9Ex::UsingShadowBackBuffer(DWORD iSwapChain) const
 
 void m_IDirect3DDevice9Ex::LimitFrameRate()
 {
-	// Count the number of frames
-	Counter.FrameCounter++;
+	FrameLimiter.SetFrameRate(Config.LimitPerFrameFPS);
+
+	FrameLimiter.WaitForFrame();
+}
 
+void m_IDirect3DDevice9Ex::CalculateFPS()
+{
 	// Get performance frequency once
-	static const LARGE_INTEGER Frequency = [] {
+	static const LONGLONG Frequency = [] {
 		LARGE_INTEGER freq = {};
 		QueryPerformanceFrequency(&freq);
-		return freq;
+		return freq.QuadPart;
 		}();
-	static const LONGLONG TicksPerMS = Frequency.QuadPart / 1000;
-
-	// Calculate time per frame in ticks
-	static long double PerFrameFPS = Config.LimitPerFrameFPS;
-	static LONGLONG PerFrameTicks = static_cast<LONGLONG>(static_cast<long double>(Frequency.QuadPart) / PerFrameFPS);
-
-	// Get current time
-	LARGE_INTEGER ClickTime = {};
-	QueryPerformanceCounter(&ClickTime);
 
-	LONGLONG TargetEndTicks = Counter.LastPresentTime.QuadPart + PerFrameTicks;
-
-	// First frame or if we fell behind, reset base time
-	if (Counter.LastPresentTime.QuadPart == 0 || ClickTime.QuadPart >= TargetEndTicks)
-	{
-		Counter.LastPresentTime.QuadPart = ClickTime.QuadPart;
-		return;
-	}
-
-	// Wait until target time
-	while (true)
-	{
-		QueryPerformanceCounter(&ClickTime);
-		LONGLONG RemainingTicks = TargetEndTicks - ClickTime.QuadPart;
-
-		if (RemainingTicks <= 0) break;
-
-		// Busy wait until we reach the target time
-		Utils::BusyWaitYield(static_cast<DWORD>(RemainingTicks / TicksPerMS));
-	}
-
-	// Store target time for next frame
-	Counter.LastPresentTime.QuadPart = TargetEndTicks;
-}
-
-void m_IDirect3DDevice9Ex::CalculateFPS()
-{
 	// Calculate frame time
-	auto endTime = std::chrono::steady_clock::now();
-	auto newstart = std::chrono::steady_clock::now();
-	std::chrono::duration<double> frameTime = endTime - startTime;
-	startTime = newstart;
-
-	// Store the frame time along with the time it occurred
-	frameTimes.emplace_back(endTime, frameTime);
-
-	// Remove frame times older than FPS_CALCULATION_WINDOW
-	while (!frameTimes.empty() && (endTime - frameTimes.front().first) > FPS_CALCULATION_WINDOW)
-	{
-		frameTimes.pop_front();
-	}
+	LARGE_INTEGER EndTime = {};
+	QueryPerformanceCounter(&EndTime);
+	const LONGLONG FrameTicks = EndTime.QuadPart - LastFrameTime.QuadPart;
+	const bool FirstFrame = (LastFrameTime.QuadPart == 0);
+	LastFrameTime = EndTime;
 
-	if (frameTimes.empty())
+	if (FirstFrame)
 	{
-		// No frame times available
 		return;
 	}
 
-	double totalTime = 0.0;
-	for (const auto& entry : frameTimes)
+	// Store the frame time in microseconds, the stats drop frames older than the window
+	const DWORD FrameTime = static_cast<DWORD>(min(FrameTicks * 1000000 / Frequency, (LONGLONG)MAXDWORD));
+	if (FrameStatistics->AddFrame(FrameTime))
 	{
-		totalTime += entry.second.count();
+		Logging::LogDebug() << __FUNCTION__ << " Stutter: " << FrameTime / 1000.0 << "ms median: " << FrameStatistics->GetMedianTime() / 1000.0 << "ms";
 	}
 
-	// Calculate average frame time
-	double averageFrameTime = totalTime / frameTimes.size();
-
 	// Calculate FPS
-	if (averageFrameTime > 0.0)
-	{
-		AverageFPSCounter = 1.0 / averageFrameTime;
-	}
+	AverageFPSCounter = FrameStatistics->GetAverageFPS();
 
 #ifdef ENABLE_DEBUGOVERLAY
 	DOverlay.SetFPSCount(AverageFPSCounter);
+	DOverlay.SetFrameStats(*FrameStatistics);
 #endif
 
 	// Output FPS
-	Logging::LogDebug() << "Frames: " << frameTimes.size() << " Average time: " << averageFrameTime << " FPS: " << AverageFPSCounter;
+	Logging::LogDebug() << "Frames: " << FrameStatistics->GetFrameCount() << " Average time: " << FrameStatistics->GetAverageTime() / 1000.0 <<
+		"ms FPS: " << AverageFPSCounter << " 1% low: " << FrameStatistics->GetLow1FPS() << " 0.1% low: " << FrameStatistics->GetLow01FPS();
 }
 
 void m_IDirect3DDevice9Ex::DrawFPS(float fps, const RECT& presentRect, DWORD position)
@@ -2,7 +2,6 @@
 
 static constexpr size_t MAX_CLIP_PLANES = 6;
 static constexpr size_t MAX_TEXTURE_STAGES = 8;
-const std::chrono::seconds FPS_CALCULATION_WINDOW(1);	// Define a constant for the desired duration of FPS calculation
 
 struct DEVICEDETAILS
 {
@@ -72,14 +71,11 @@ private:
 
 	// Frame counter
 	double AverageFPSCounter = 0.0;
-	std::deque<std::pair<std::chrono::steady_clock::time_point, std::chrono::duration<double>>> frameTimes;	// Store frame times in a deque
-	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();	// Store start time for PFS counter
+	std::unique_ptr<FrameStats> FrameStatistics = std::make_unique<FrameStats>();	// Rolling frame time statistics for the FPS counter
+	LARGE_INTEGER LastFrameTime = {};	// Store last present time for FPS counter
 
 	// Limit frame rate
-	struct {
-		DWORD FrameCounter = 0;
-		LARGE_INTEGER LastPresentTime = {};
-	} Counter;
+	Utils::FrameLimiter FrameLimiter;
 
 	// State block
 	IDirect3DStateBlock9* pStateBlock = nullptr;
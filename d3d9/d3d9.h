@@ -119,6 +119,7 @@ namespace D3d9Wrapper
 
 #include "ComPtr.h"
 #include "ScopeGuard.h"
+#include "FrameStats.h"
 
 #include "IDirect3DDevice9Ex.h"
 #include "IDirect3DCubeTexture9.h"
@@ -0,0 +1,256 @@
+#include "Utils\WrapperAddressMap.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+    constexpr size_t CacheIndexCount = 4;
+    constexpr size_t ClipperIndex = 3;
+
+    class MockWrapper;
+
+    // Two keys per wrapper like the d3d9 table, which saves both the IUnknown identity and the raw proxy
+    using MockAddressMap = WrapperAddressMap<MockWrapper, CacheIndexCount, 2>;
+
+    DWORD DeleteCount = 0;
+
+    // Removes itself from the map on delete like the wrappers do through DeleteAddress, and can own a child wrapper
+    class MockWrapper
+    {
+    public:
+        MockAddressMap* Map = nullptr;
+        MockWrapper* Parent = nullptr;
+        MockWrapper* Child = nullptr;
+
+        MockWrapper(MockAddressMap* Map = nullptr) : Map(Map) {}
+        virtual ~MockWrapper()
+        {
+            DeleteCount++;
+            if (Map)
+            {
+                Map->Erase(this);
+            }
+            if (Parent)
+            {
+                Parent->Child = nullptr;
+            }
+            delete Child;
+        }
+    };
+
+    // Distinct fake proxy addresses, they are only used as keys
+    BYTE Proxies[16];
+
+    void* Key(size_t Index) { return &Proxies[Index]; }
+
+    void TestInsertFindDelete(DWORD& TestID)
+    {
+        MockAddressMap Map;
+        MockWrapper A, B;
+
+        // Identity and raw proxy both find the wrapper
+        Map.Save(&A, 0, { Key(0), Key(1) });
+        LOG_TEST_RESULT(TestID++, "Wrapper is found by its identity: ", (Map.Find(0, Key(0)) == &A), true);
+        LOG_TEST_RESULT(TestID++, "Wrapper is found by its raw proxy: ", (Map.Find(0, Key(1)) == &A), true);
+        LOG_TEST_RESULT(TestID++, "Unknown key is not found: ", (Map.Find(0, Key(2)) == nullptr), true);
+        LOG_TEST_RESULT(TestID++, "Key is not found under another cache index: ", (Map.Find(1, Key(0)) == nullptr), true);
+        LOG_TEST_RESULT(TestID++, "Both keys are counted once per wrapper: ", (Map.GetKeyCount(0) == 2 && Map.GetWrapperCount() == 1), true);
+
+        // Validation accepts the wrapper's own index and any range holding it
+        Map.Save(&B, 2, { Key(2), Key(3) });
+        LOG_TEST_RESULT(TestID++, "Wrapper is saved under its cache index: ", (Map.IsSaved(&B, 2, 2)), true);
+        LOG_TEST_RESULT(TestID++, "Wrapper is saved in a range holding its index: ", (Map.IsSaved(&B, 1, 3)), true);
+        LOG_TEST_RESULT(TestID++, "Wrapper is not saved under another index: ", (Map.IsSaved(&B, 0, 1)), false);
+
+        // Moving a wrapper drops its old keys
+        Map.Save(&A, 1, { Key(4), Key(5) });
+        LOG_TEST_RESULT(TestID++, "Moved wrapper's old keys are dropped: ", (Map.Find(0, Key(0)) == nullptr && Map.Find(0, Key(1)) == nullptr), true);
+        LOG_TEST_RESULT(TestID++, "Moved wrapper is found by its new keys: ", (Map.Find(1, Key(4)) == &A && Map.Find(1, Key(5)) == &A), true);
+        LOG_TEST_RESULT(TestID++, "Moved wrapper keeps one reverse entry: ", Map.GetWrapperCount(), 2);
+
+        // Deleting removes every key of the wrapper
+        const bool IsErased = Map.Erase(&A);
+        LOG_TEST_RESULT(TestID++, "Saved wrapper is erased: ", IsErased, true);
+        LOG_TEST_RESULT(TestID++, "Erased wrapper's keys are removed: ", (Map.Find(1, Key(4)) == nullptr && Map.Find(1, Key(5)) == nullptr && Map.GetKeyCount(1) == 0), true);
+        LOG_TEST_RESULT(TestID++, "Erased wrapper is no longer saved: ", (Map.IsSaved(&A, 0, CacheIndexCount - 1)), false);
+        const bool IsErasedTwice = Map.Erase(&A);
+        LOG_TEST_RESULT(TestID++, "Erasing twice returns false: ", IsErasedTwice, false);
+        LOG_TEST_RESULT(TestID++, "Other wrapper is untouched: ", (Map.Find(2, Key(2)) == &B && Map.Find(2, Key(3)) == &B), true);
+    }
+
+    void TestClaimedKeys(DWORD& TestID)
+    {
+        MockAddressMap Map;
+        MockWrapper A, B;
+
+        // A new wrapper for the same identity takes over the key, deleting the old one must not remove it
+        Map.Save(&A, 0, { Key(0), Key(1) });
+        Map.Save(&B, 0, { Key(0), Key(2) });
+        LOG_TEST_RESULT(TestID++, "Claimed key finds the new wrapper: ", (Map.Find(0, Key(0)) == &B), true);
+        LOG_TEST_RESULT(TestID++, "Old wrapper keeps its other key: ", (Map.Find(0, Key(1)) == &A), true);
+
+        Map.Erase(&A);
+        LOG_TEST_RESULT(TestID++, "Deleting the old wrapper keeps the claimed key: ", (Map.Find(0, Key(0)) == &B), true);
+        LOG_TEST_RESULT(TestID++, "Deleting the old wrapper removes its own key: ", (Map.Find(0, Key(1)) == nullptr), true);
+
+        // Saving again with the same keys is a no-op
+        Map.Save(&B, 0, { Key(0), Key(2) });
+        LOG_TEST_RESULT(TestID++, "Saving the same keys again keeps them: ", (Map.Find(0, Key(0)) == &B && Map.Find(0, Key(2)) == &B && Map.GetKeyCount(0) == 2), true);
+
+        // Identity equal to the raw proxy is a single key
+        MockAddressMap Map2;
+        Map2.Save(&A, 0, { Key(0), Key(0) });
+        LOG_TEST_RESULT(TestID++, "Identity equal to the proxy is one key: ", Map2.GetKeyCount(0), 1);
+        Map2.Erase(&A);
+        LOG_TEST_RESULT(TestID++, "Identity equal to the proxy is erased: ", Map2.GetKeyCount(0), 0);
+    }
+
+    void TestDeleteAll(DWORD& TestID)
+    {
+        // Every wrapper has two keys, each must be deleted exactly once
+        {
+            MockAddressMap Map;
+            for (size_t i = 0; i < 6; i++)
+            {
+                Map.Save(new MockWrapper(&Map), i % CacheIndexCount, { Key(i * 2), Key(i * 2 + 1) });
+            }
+            DeleteCount = 0;
+            Map.DeleteAll([](size_t) { return true; });
+            LOG_TEST_RESULT(TestID++, "Wrapper with identity and proxy keys is deleted once: ", DeleteCount, 6);
+            LOG_TEST_RESULT(TestID++, "Map is empty after DeleteAll: ", (Map.GetWrapperCount() == 0 && Map.GetKeyCount(0) == 0 && Map.GetKeyCount(1) == 0), true);
+        }
+
+        // Destructors that do not remove themselves, like the wrappers while the table is being destroyed
+        {
+            MockAddressMap Map;
+            Map.Save(new MockWrapper(), 0, { Key(0), Key(1) });
+            Map.Save(new MockWrapper(), 1, { Key(2), Key(2) });
+            DeleteCount = 0;
+            Map.DeleteAll([](size_t) { return true; });
+            LOG_TEST_RESULT(TestID++, "Wrappers not removing themselves are deleted once: ", DeleteCount, 2);
+        }
+
+        // Filtered indexes are kept, like the clipper in the ddraw table
+        {
+            MockAddressMap Map;
+            MockWrapper Clipper;
+            Map.Save(&Clipper, ClipperIndex, { Key(0), Key(1) });
+            Map.Save(new MockWrapper(&Map), 0, { Key(2), Key(3) });
+            DeleteCount = 0;
+            Map.DeleteAll([](size_t CacheIndex) { return CacheIndex != ClipperIndex; });
+            LOG_TEST_RESULT(TestID++, "Filtered wrapper is not deleted: ", (DeleteCount == 1 && Map.Find(ClipperIndex, Key(0)) == &Clipper), true);
+            Map.Erase(&Clipper);
+        }
+
+        // A destructor deleting another saved wrapper removes it before DeleteAll reaches it, several pairs so
+        // some parents come before their child in the map
+        {
+            MockAddressMap Map;
+            for (size_t i = 0; i < 4; i++)
+            {
+                MockWrapper* Parent = new MockWrapper(&Map);
+                Parent->Child = new MockWrapper(&Map);
+                Parent->Child->Parent = Parent;
+                Map.Save(Parent, 0, { Key(i * 4), Key(i * 4 + 1) });
+                Map.Save(Parent->Child, 1, { Key(i * 4 + 2), Key(i * 4 + 3) });
+            }
+            DeleteCount = 0;
+            Map.DeleteAll([](size_t) { return true; });
+            LOG_TEST_RESULT(TestID++, "Wrapper deleted by another destructor is deleted once: ", DeleteCount, 8);
+        }
+    }
+
+    // Layout the tables used before, one map per cache index with a linear search to remove a wrapper
+    struct OLDADDRESSMAP
+    {
+        std::unordered_map<void*, MockWrapper*> g_map[CacheIndexCount];
+
+        MockWrapper* Find(size_t CacheIndex, void* Key) const
+        {
+            auto it = g_map[CacheIndex].find(Key);
+            return (it != g_map[CacheIndex].end()) ? it->second : nullptr;
+        }
+
+        void Save(MockWrapper* Wrapper, size_t CacheIndex, void* Key)
+        {
+            g_map[CacheIndex][Key] = Wrapper;
+        }
+
+        void Erase(MockWrapper* Wrapper, size_t CacheIndex)
+        {
+            auto it = std::find_if(g_map[CacheIndex].begin(), g_map[CacheIndex].end(),
+                [=](const auto& Map) { return Map.second == Wrapper; });
+            if (it != g_map[CacheIndex].end())
+            {
+                g_map[CacheIndex].erase(it);
+            }
+        }
+    };
+
+    // Logs the cost of 100k cycles that each release the oldest of 1,000 live wrappers, create a new one
+    // and look up a live one, with one key per wrapper in both layouts
+    void BenchmarkAddressMap()
+    {
+        constexpr size_t LiveCount = 1000;
+        constexpr DWORD CycleCount = 100000;
+
+        // Keys are only compared, so plain numbers stand in for proxy addresses
+        auto CycleKey = [](size_t Cycle) { return (void*)(ULONG_PTR)(0x10000 + Cycle * 16); };
+
+        std::vector<MockWrapper> Wrappers(LiveCount);
+
+        WrapperAddressMap<MockWrapper, CacheIndexCount> Map;
+        OLDADDRESSMAP OldMap;
+        for (size_t i = 0; i < LiveCount; i++)
+        {
+            Map.Save(&Wrappers[i], i % CacheIndexCount, { CycleKey(i) });
+            OldMap.Save(&Wrappers[i], i % CacheIndexCount, CycleKey(i));
+        }
+
+        volatile size_t FoundCount = 0;
+        size_t Cycle = LiveCount;
+        const double MapTime = MeasureNanoseconds(CycleCount, [&]()
+            {
+                MockWrapper* Wrapper = &Wrappers[Cycle % LiveCount];
+                Map.Erase(Wrapper);
+                Map.Save(Wrapper, Cycle % CacheIndexCount, { CycleKey(Cycle) });
+                const size_t Lookup = Cycle - (Cycle * 7919) % LiveCount;
+                FoundCount = FoundCount + (Map.Find(Lookup % CacheIndexCount, CycleKey(Lookup)) != nullptr);
+                Cycle++;
+            });
+
+        Cycle = LiveCount;
+        const double OldTime = MeasureNanoseconds(CycleCount, [&]()
+            {
+                MockWrapper* Wrapper = &Wrappers[Cycle % LiveCount];
+                OldMap.Erase(Wrapper, (Cycle - LiveCount) % CacheIndexCount);
+                OldMap.Save(Wrapper, Cycle % CacheIndexCount, CycleKey(Cycle));
+                const size_t Lookup = Cycle - (Cycle * 7919) % LiveCount;
+                FoundCount = FoundCount + (OldMap.Find(Lookup % CacheIndexCount, CycleKey(Lookup)) != nullptr);
+                Cycle++;
+            });
+
+        Logging::Log() << "Benchmark: AddressLookupTable " << CycleCount << " create, lookup and release cycles with " << LiveCount <<
+            " live wrappers, reverse map " << MapTime << " ns, old layout " << OldTime << " ns per cycle";
+    }
+}
+
+void TestAddressLookupTable()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing AddressLookupTable";
+    Logging::Log() << "****";
+
+    DWORD TestID = 10500;
+
+    TestInsertFindDelete(TestID);
+    TestClaimedKeys(TestID);
+    TestDeleteAll(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkAddressMap();
+    }
+}
@@ -0,0 +1,307 @@
+#include "dsound\AudioStopQueue.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+namespace {
+    constexpr LONG StopCall = 1;        // Recorded in place of a volume for Stop, volumes are never positive
+
+    // Records the calls the scheduler makes on the real buffer
+    struct MockSoundBuffer
+    {
+        std::vector<LONG> Calls;
+
+        HRESULT SetVolume(LONG lVolume) { Calls.push_back(lVolume); return DS_OK; }
+        HRESULT Stop() { Calls.push_back(StopCall); return DS_OK; }
+    };
+
+    // Same fields as AUDIOCLIP, Play and Stop below change them the way m_IDirectSoundBuffer8 does
+    struct MockAudioClip
+    {
+        CRITICAL_SECTION dics = {};
+        MockSoundBuffer* ProxyInterface = nullptr;
+        LONG CurrentVolume = 0;
+        DWORD Generation = 0;
+        bool PendingStop = false;
+
+        MockSoundBuffer Buffer;
+
+        MockAudioClip(LONG Volume) : CurrentVolume(Volume)
+        {
+            ProxyInterface = &Buffer;
+            InitializeCriticalSection(&dics);
+        }
+        ~MockAudioClip()
+        {
+            DeleteCriticalSection(&dics);
+        }
+    };
+
+    typedef AudioStopQueue<MockAudioClip> STOPQUEUE;
+
+    void Stop(STOPQUEUE& Queue, MockAudioClip& Clip, DWORD Now)
+    {
+        if (!Clip.PendingStop)
+        {
+            Clip.PendingStop = true;
+            Queue.Post(&Clip, ++Clip.Generation, Now);
+        }
+    }
+
+    // FinishPendingStop, called from Play and Release
+    void Play(MockAudioClip& Clip)
+    {
+        if (Clip.PendingStop)
+        {
+            Clip.ProxyInterface->Stop();
+            Clip.ProxyInterface->SetVolume(Clip.CurrentVolume);
+            Clip.PendingStop = false;
+            Clip.Generation++;
+        }
+    }
+
+    // Runs the due jobs the way the scheduler thread does
+    void RunDue(STOPQUEUE& Queue, DWORD Now)
+    {
+        STOPQUEUE::STOPJOB Job;
+        while (Queue.PopDue(Now, Job))
+        {
+            if (Queue.RunJob(Job))
+            {
+                Queue.Requeue(Job, Now);
+            }
+        }
+    }
+
+    LONG GetStepVolume(LONG Volume, LONG Step, LONG Steps)
+    {
+        return Volume + (DSBVOLUME_MIN - Volume) * Step / Steps;
+    }
+
+    void TestFadeSteps(DWORD& TestID)
+    {
+        // Default 20ms fade is 4 steps of 5ms, three volume steps and then the stop
+        {
+            STOPQUEUE Queue;
+            Queue.SetFadeOutDelay(0);
+            MockAudioClip Clip(-1000);
+            DWORD Now = 1000;
+            Stop(Queue, Clip, Now);
+            LOG_TEST_RESULT(TestID++, "First step is due after the step delay: ", Queue.GetTimeout(Now), 5);
+
+            RunDue(Queue, Now + 4);
+            LOG_TEST_RESULT(TestID++, "Step is not run before it is due: ", Clip.Buffer.Calls.size(), 0);
+
+            bool IsStepTimed = true;
+            for (Now = 1005; Now <= 1015; Now += 5)
+            {
+                RunDue(Queue, Now);
+                IsStepTimed = IsStepTimed && Queue.GetTimeout(Now) == 5;
+            }
+            RunDue(Queue, Now);
+            const std::vector<LONG> Expected = { GetStepVolume(-1000, 1, 4), GetStepVolume(-1000, 2, 4), GetStepVolume(-1000, 3, 4), StopCall, -1000 };
+            LOG_TEST_RESULT(TestID++, "Volume steps down then the buffer stops at its volume: ", (Clip.Buffer.Calls == Expected), true);
+            LOG_TEST_RESULT(TestID++, "Each step is queued one step delay later: ", IsStepTimed, true);
+            LOG_TEST_RESULT(TestID++, "Stop clears the pending stop: ", Clip.PendingStop, false);
+            LOG_TEST_RESULT(TestID++, "Queue sleeps forever once empty: ", (Queue.size() == 0 && Queue.GetTimeout(Now) == INFINITE), true);
+        }
+
+        // Delays that do not divide into 5ms steps stretch the steps
+        {
+            STOPQUEUE Queue;
+            bool IsSplit = true;
+            const DWORD Delays[][3] = { { 1, 1, 1 }, { 7, 1, 7 }, { 12, 2, 6 }, { 33, 6, 5 }, { 100, 20, 5 } };
+            for (const auto& Entry : Delays)
+            {
+                Queue.SetFadeOutDelay(Entry[0]);
+                IsSplit = IsSplit && Queue.GetFadeSteps() == Entry[1] && Queue.GetStepDelay() == Entry[2];
+            }
+            LOG_TEST_RESULT(TestID++, "Fade delay is split into steps of at least 5ms: ", IsSplit, true);
+
+            // A single step stops at once when due
+            Queue.SetFadeOutDelay(7);
+            MockAudioClip Clip(-500);
+            Stop(Queue, Clip, 0);
+            RunDue(Queue, 7);
+            LOG_TEST_RESULT(TestID++, "Single step fade only stops: ", (Clip.Buffer.Calls == std::vector<LONG>{ StopCall, -500 }), true);
+        }
+
+        // Volume set while fading is the new base for the remaining steps and is restored after the stop
+        {
+            STOPQUEUE Queue;
+            MockAudioClip Clip(0);
+            Stop(Queue, Clip, 0);
+            RunDue(Queue, 5);
+            Clip.CurrentVolume = -2000;
+            RunDue(Queue, 10);
+            RunDue(Queue, 15);
+            RunDue(Queue, 20);
+            const std::vector<LONG> Expected = { GetStepVolume(0, 1, 4), GetStepVolume(-2000, 2, 4), GetStepVolume(-2000, 3, 4), StopCall, -2000 };
+            LOG_TEST_RESULT(TestID++, "Volume changed while fading is used for the next steps: ", (Clip.Buffer.Calls == Expected), true);
+        }
+
+        // Tick count wrapping between the post and the due time
+        {
+            STOPQUEUE Queue;
+            MockAudioClip Clip(0);
+            Stop(Queue, Clip, 0xFFFFFFFE);
+            LOG_TEST_RESULT(TestID++, "Timeout across the tick count wrap: ", Queue.GetTimeout(0xFFFFFFFE), 5);
+            RunDue(Queue, 0xFFFFFFFF);
+            LOG_TEST_RESULT(TestID++, "Step not due before the wrap: ", Clip.Buffer.Calls.size(), 0);
+            RunDue(Queue, 2);
+            LOG_TEST_RESULT(TestID++, "Step not due after the wrap until its time: ", Clip.Buffer.Calls.size(), 0);
+            RunDue(Queue, 3);
+            LOG_TEST_RESULT(TestID++, "Step due after the wrap: ", Clip.Buffer.Calls.size(), 1);
+        }
+    }
+
+    void TestPlayStopRaces(DWORD& TestID)
+    {
+        // Play before the first step stops the buffer at once and the queued job is skipped
+        {
+            STOPQUEUE Queue;
+            MockAudioClip Clip(-100);
+            Stop(Queue, Clip, 0);
+            Play(Clip);
+            RunDue(Queue, 100);
+            LOG_TEST_RESULT(TestID++, "Play skips the queued fade: ", (Clip.Buffer.Calls == std::vector<LONG>{ StopCall, -100 }), true);
+            LOG_TEST_RESULT(TestID++, "Skipped job is not queued again: ", Queue.size(), 0);
+        }
+
+        // Play in the middle of the fade restores the volume and no more steps run
+        {
+            STOPQUEUE Queue;
+            MockAudioClip Clip(-100);
+            Stop(Queue, Clip, 0);
+            RunDue(Queue, 5);
+            Play(Clip);
+            RunDue(Queue, 10);
+            RunDue(Queue, 100);
+            LOG_TEST_RESULT(TestID++, "Play during the fade stops the remaining steps: ", (Clip.Buffer.Calls == std::vector<LONG>{ GetStepVolume(-100, 1, 4), StopCall, -100 }), true);
+        }
+
+        // Play after the job is taken from the queue but before it runs
+        {
+            STOPQUEUE Queue;
+            MockAudioClip Clip(-100);
+            Stop(Queue, Clip, 0);
+            STOPQUEUE::STOPJOB Job;
+            const bool IsDue = Queue.PopDue(5, Job);
+            Play(Clip);
+            const bool MoreSteps = Queue.RunJob(Job);
+            LOG_TEST_RESULT(TestID++, "Job taken before Play is skipped when it runs: ", (IsDue && !MoreSteps && Clip.Buffer.Calls.size() == 2), true);
+        }
+
+        // Stop, Play and Stop again within one step, only the last stop fades and it stops once
+        {
+            STOPQUEUE Queue;
+            MockAudioClip Clip(-100);
+            Stop(Queue, Clip, 0);
+            Play(Clip);
+            Clip.Buffer.Calls.clear();
+            Stop(Queue, Clip, 2);
+            LOG_TEST_RESULT(TestID++, "Both stops are queued: ", Queue.size(), 2);
+
+            RunDue(Queue, 5);
+            LOG_TEST_RESULT(TestID++, "Old stop is skipped when due: ", (Clip.Buffer.Calls.size() == 0 && Queue.size() == 1), true);
+            LOG_TEST_RESULT(TestID++, "Timeout is taken from the new stop: ", Queue.GetTimeout(5), 2);
+            for (DWORD Now = 7; Now <= 22; Now += 5)
+            {
+                RunDue(Queue, Now);
+            }
+            const std::vector<LONG> Expected = { GetStepVolume(-100, 1, 4), GetStepVolume(-100, 2, 4), GetStepVolume(-100, 3, 4), StopCall, -100 };
+            LOG_TEST_RESULT(TestID++, "New stop fades once and stops once: ", (Clip.Buffer.Calls == Expected), true);
+        }
+
+        // A second Stop while one is pending does not queue another fade
+        {
+            STOPQUEUE Queue;
+            MockAudioClip Clip(0);
+            Stop(Queue, Clip, 0);
+            Stop(Queue, Clip, 1);
+            LOG_TEST_RESULT(TestID++, "Stop while pending is not queued: ", Queue.size(), 1);
+        }
+
+        // Release cancels the jobs of one buffer and leaves the others
+        {
+            STOPQUEUE Queue;
+            MockAudioClip ClipA(0), ClipB(-300);
+            Stop(Queue, ClipA, 0);
+            Stop(Queue, ClipB, 2);
+            RunDue(Queue, 5);
+            Queue.Cancel(&ClipA);
+            LOG_TEST_RESULT(TestID++, "Cancel removes the buffer's jobs: ", Queue.size(), 1);
+            LOG_TEST_RESULT(TestID++, "Next timeout is the other buffer's: ", Queue.GetTimeout(5), 2);
+            for (DWORD Now = 7; Now <= 22; Now += 5)
+            {
+                RunDue(Queue, Now);
+            }
+            LOG_TEST_RESULT(TestID++, "Cancelled buffer gets no more calls: ", ClipA.Buffer.Calls.size(), 1);
+            LOG_TEST_RESULT(TestID++, "Other buffer finishes its fade: ", (ClipB.Buffer.Calls.size() == 5 && ClipB.Buffer.Calls[3] == StopCall), true);
+        }
+
+        // Jobs for a buffer without a proxy are dropped
+        {
+            STOPQUEUE Queue;
+            MockAudioClip Clip(0);
+            Stop(Queue, Clip, 0);
+            Clip.ProxyInterface = nullptr;
+            RunDue(Queue, 5);
+            LOG_TEST_RESULT(TestID++, "Job without a proxy is dropped: ", (Queue.size() == 0 && Clip.Buffer.Calls.size() == 0), true);
+        }
+    }
+
+    // Logs the cost per stop of 10k stops per second over 10 simulated seconds, with the scheduler thread
+    // running the due jobs every millisecond and each stop fading in 4 steps
+    void BenchmarkAudioStopQueue()
+    {
+        constexpr DWORD StopsPerMS = 10;
+        constexpr DWORD DurationMS = 10000;
+        constexpr DWORD ClipCount = 400;    // Each clip is stopped again every 40ms, after its fade ended
+
+        std::vector<std::unique_ptr<MockAudioClip>> Clips;
+        for (DWORD x = 0; x < ClipCount; x++)
+        {
+            Clips.emplace_back(new MockAudioClip(-1000));
+        }
+
+        STOPQUEUE Queue;
+        DWORD Now = 0, NextClip = 0;
+        size_t MaxQueued = 0;
+        const double TickTime = MeasureNanoseconds(DurationMS, [&]()
+            {
+                for (DWORD x = 0; x < StopsPerMS; x++)
+                {
+                    MockAudioClip& Clip = *Clips[NextClip++ % ClipCount];
+                    Clip.Buffer.Calls.clear();
+                    Stop(Queue, Clip, Now);
+                }
+                MaxQueued = (std::max)(MaxQueued, Queue.size());
+                RunDue(Queue, Now);
+                Now++;
+            });
+
+        Logging::Log() << "Benchmark: AudioStopQueue " << (StopsPerMS * 1000) << " stops per second, " << (TickTime / StopsPerMS) <<
+            " ns per stop, up to " << MaxQueued << " jobs queued";
+    }
+}
+
+void TestAudioScheduler()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing AudioScheduler";
+    Logging::Log() << "****";
+
+    DWORD TestID = 13000;
+
+    TestFadeSteps(TestID);
+    TestPlayStopRaces(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkAudioStopQueue();
+    }
+}
@@ -0,0 +1,353 @@
+#include "dsound\BufferStatusCache.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+
+namespace {
+    constexpr DWORD LoopingStatus = DSBSTATUS_PLAYING | DSBSTATUS_LOOPING;
+
+    // Driver side of the buffer, counts the GetStatus calls that reach it
+    struct MockDriver
+    {
+        DWORD Status = 0;
+        HRESULT StatusResult = DS_OK;
+        DWORD Queries = 0;
+
+        HRESULT GetStatus(LPDWORD pdwStatus)
+        {
+            Queries++;
+            if (SUCCEEDED(StatusResult))
+            {
+                *pdwStatus = Status;
+            }
+            return StatusResult;
+        }
+    };
+
+    enum EVENTTYPE
+    {
+        Play,           // Play without looping
+        PlayLooping,
+        PlayFailed,
+        Stop,
+        FadeStop,       // Stop with AudioClipDetection, the buffer plays on muted
+        FadeDone,       // Audio scheduler stops the buffer after the fade
+        DriverStop,     // Non-looping buffer ends or the buffer is lost
+        StatusFails,    // Driver GetStatus fails from now on
+        Restore,
+        GetStatus,      // Application calls GetStatus
+        Poll,           // GetCurrentPosition with StoppedDriverWorkaround
+    };
+
+    struct EVENT
+    {
+        EVENTTYPE Type;
+        DWORD Time;
+    };
+
+    struct REPLAY
+    {
+        DWORD Queries = 0;
+        std::vector<DWORD> Polls;       // Status returned to each poll
+    };
+
+    // Feeds the events to the cache the way m_IDirectSoundBuffer8 does
+    REPLAY Replay(const std::vector<EVENT>& Events)
+    {
+        BufferStatusCache Cache;
+        MockDriver Driver;
+        bool PendingStop = false;
+        REPLAY Trace;
+
+        for (const EVENT& Event : Events)
+        {
+            switch (Event.Type)
+            {
+            case Play:
+            case PlayLooping:
+                PendingStop = false;
+                Driver.Status = DSBSTATUS_PLAYING | ((Event.Type == PlayLooping) ? DSBSTATUS_LOOPING : 0);
+                Cache.OnPlay(DS_OK, (Event.Type == PlayLooping) ? DSBPLAY_LOOPING : 0, Event.Time);
+                break;
+            case PlayFailed:
+                Cache.OnPlay(DSERR_BUFFERLOST, 0, Event.Time);
+                break;
+            case Stop:
+                Driver.Status = 0;
+                Cache.OnStop(DS_OK, Event.Time);
+                break;
+            case FadeStop:
+                PendingStop = true;
+                Cache.Invalidate();
+                break;
+            case FadeDone:
+                PendingStop = false;
+                Driver.Status = 0;
+                break;
+            case DriverStop:
+                Driver.Status = 0;
+                break;
+            case StatusFails:
+                Driver.StatusResult = DSERR_BUFFERLOST;
+                break;
+            case Restore:
+                Driver.StatusResult = DS_OK;
+                Cache.Invalidate();
+                break;
+            case GetStatus:
+            {
+                DWORD dwStatus = 0;
+                const HRESULT hr = Driver.GetStatus(&dwStatus);
+                Cache.OnGetStatus(hr, dwStatus, PendingStop, Event.Time);
+                break;
+            }
+            case Poll:
+                Trace.Polls.push_back(Cache.GetStatus(&Driver, PendingStop, Event.Time));
+                break;
+            }
+        }
+        Trace.Queries = Driver.Queries;
+        return Trace;
+    }
+
+    // Adds a poll every Step ticks from First to Last
+    void AddPolls(std::vector<EVENT>& Events, DWORD First, DWORD Last, DWORD Step)
+    {
+        for (DWORD Time = First; (LONG)(Last - Time) >= 0; Time += Step)
+        {
+            Events.push_back({ Poll, Time });
+        }
+    }
+
+    bool AllPollsAre(const REPLAY& Trace, DWORD Status)
+    {
+        for (DWORD Polled : Trace.Polls)
+        {
+            if (Polled != Status)
+            {
+                return false;
+            }
+        }
+        return !Trace.Polls.empty();
+    }
+
+    void TestPlayStatus(DWORD& TestID)
+    {
+        // Looping buffer polled every 10ms for a second is asked again every 250ms
+        {
+            std::vector<EVENT> Events = { { PlayLooping, 0 } };
+            AddPolls(Events, 10, 1000, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Looping buffer is refreshed every 250ms: ", Trace.Queries, 4);
+            LOG_TEST_RESULT(TestID++, "Looping buffer polls see it playing: ", AllPollsAre(Trace, LoopingStatus), true);
+        }
+
+        // Looping buffer is refreshed across the tick count wrap
+        {
+            std::vector<EVENT> Events = { { PlayLooping, 0xFFFFFF00 } };
+            AddPolls(Events, 0xFFFFFF0A, 0xFA, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Refresh time wraps with the tick count: ", Trace.Queries, 2);
+        }
+
+        // A lost looping buffer is seen at the next refresh and the stopped status is then kept
+        {
+            std::vector<EVENT> Events = { { PlayLooping, 0 }, { DriverStop, 100 }, { Poll, 240 }, { Poll, 250 } };
+            AddPolls(Events, 260, 2000, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Lost looping buffer still shows the cached status: ", Trace.Polls[0], LoopingStatus);
+            LOG_TEST_RESULT(TestID++, "Lost looping buffer is seen at the refresh: ", Trace.Polls[1], 0);
+            LOG_TEST_RESULT(TestID++, "Stopped status is kept after the refresh: ", Trace.Queries, 1);
+        }
+
+        // Non-looping buffers can end at any time so every poll asks until it stops
+        {
+            std::vector<EVENT> Events = { { Play, 0 } };
+            AddPolls(Events, 10, 40, 10);
+            Events.push_back({ DriverStop, 45 });
+            AddPolls(Events, 50, 1000, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Non-looping buffer asks on every poll until it ends: ", Trace.Queries, 5);
+            LOG_TEST_RESULT(TestID++, "Ended buffer shows stopped: ", (Trace.Polls[3] == DSBSTATUS_PLAYING && Trace.Polls[4] == 0 && Trace.Polls.back() == 0), true);
+        }
+
+        // Stopped buffers never ask, Play makes the status known again
+        {
+            std::vector<EVENT> Events = { { Stop, 0 } };
+            AddPolls(Events, 10, 5000, 10);
+            Events.push_back({ Play, 5005 });
+            Events.push_back({ Stop, 5006 });
+            AddPolls(Events, 5010, 6000, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Stopped buffer never asks the driver: ", Trace.Queries, 0);
+            LOG_TEST_RESULT(TestID++, "Stopped buffer polls see it stopped: ", AllPollsAre(Trace, 0), true);
+        }
+
+        // Nothing is known before the first call
+        {
+            std::vector<EVENT> Events;
+            AddPolls(Events, 0, 100, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Unknown status is asked once: ", Trace.Queries, 1);
+        }
+    }
+
+    void TestInvalidation(DWORD& TestID)
+    {
+        // A fade stop keeps asking while the scheduler fades, then keeps the stopped status
+        {
+            std::vector<EVENT> Events = { { PlayLooping, 0 }, { FadeStop, 100 } };
+            AddPolls(Events, 105, 120, 5);
+            Events.push_back({ FadeDone, 120 });
+            AddPolls(Events, 125, 1000, 5);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Pending stop asks on every poll: ", Trace.Queries, 5);
+            LOG_TEST_RESULT(TestID++, "Buffer plays on while fading: ", Trace.Polls[2], LoopingStatus);
+            LOG_TEST_RESULT(TestID++, "Finished fade shows stopped: ", (Trace.Polls[4] == 0 && Trace.Polls.back() == 0), true);
+        }
+
+        // Status the application reads while fading is not kept
+        {
+            std::vector<EVENT> Events = { { PlayLooping, 0 }, { FadeStop, 100 }, { GetStatus, 105 }, { FadeDone, 110 }, { Poll, 115 } };
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Status read while fading is not cached: ", (Trace.Queries == 2 && Trace.Polls[0] == 0), true);
+        }
+
+        // Play during the fade clears the pending stop and the status is known again
+        {
+            std::vector<EVENT> Events = { { PlayLooping, 0 }, { FadeStop, 100 }, { Poll, 105 }, { PlayLooping, 107 } };
+            AddPolls(Events, 110, 350, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Play during the fade stops the polling: ", Trace.Queries, 1);
+        }
+
+        // Restore drops the status, it is asked once and then cached
+        {
+            std::vector<EVENT> Events = { { Stop, 0 }, { Poll, 10 }, { Restore, 20 } };
+            AddPolls(Events, 30, 100, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Restore asks the driver once: ", Trace.Queries, 1);
+        }
+
+        // A failed GetStatus returns stopped and is asked again on the next poll
+        {
+            std::vector<EVENT> Events = { { PlayLooping, 0 }, { StatusFails, 100 } };
+            AddPolls(Events, 250, 290, 10);
+            Events.push_back({ Restore, 295 });
+            AddPolls(Events, 300, 500, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Failed status is asked on every poll: ", Trace.Queries, 6);
+            LOG_TEST_RESULT(TestID++, "Failed status is returned as stopped: ", (Trace.Polls[0] == 0 && Trace.Polls[4] == 0), true);
+            LOG_TEST_RESULT(TestID++, "Status is cached again after Restore: ", Trace.Polls.back(), LoopingStatus);
+        }
+
+        // A failed Play drops the status
+        {
+            std::vector<EVENT> Events = { { Stop, 0 }, { PlayFailed, 10 } };
+            AddPolls(Events, 20, 100, 10);
+            const REPLAY Trace = Replay(Events);
+            LOG_TEST_RESULT(TestID++, "Failed Play asks the driver once: ", Trace.Queries, 1);
+        }
+    }
+
+    // Logs the cost of one status poll straight from the buffer and through the cache
+    template <typename B>
+    void BenchmarkPolls(B* Buffer, const char* Name)
+    {
+        constexpr DWORD Count = 100000;
+
+        volatile DWORD Status = 0;
+        const double DriverTime = MeasureNanoseconds(Count, [&]()
+            {
+                DWORD dwStatus = 0;
+                Buffer->GetStatus(&dwStatus);
+                Status = dwStatus;
+            });
+
+        BufferStatusCache Cache;
+        Cache.OnPlay(DS_OK, DSBPLAY_LOOPING, GetTickCount());
+        const double CachedTime = MeasureNanoseconds(Count, [&]()
+            {
+                Status = Cache.GetStatus(Buffer, false, GetTickCount());
+            });
+
+        Logging::Log() << "Benchmark: BufferStatusCache " << Name << " GetStatus " << DriverTime << " ns, cached " << CachedTime << " ns per poll of a looping buffer";
+    }
+
+    // Polls a looping buffer from the DirectSound driver, or the mock when there is no sound device
+    void BenchmarkBufferStatusCache()
+    {
+        typedef HRESULT(WINAPI* DirectSoundCreate8Proc)(LPCGUID, LPDIRECTSOUND8*, LPUNKNOWN);
+
+        HMODULE dsound_dll = LoadLibraryA("dsound.dll");
+        DirectSoundCreate8Proc pDirectSoundCreate8 = dsound_dll ? reinterpret_cast<DirectSoundCreate8Proc>(GetProcAddress(dsound_dll, "DirectSoundCreate8")) : nullptr;
+
+        IDirectSound8* pDirectSound = nullptr;
+        IDirectSoundBuffer* pBuffer = nullptr;
+        if (pDirectSoundCreate8 && SUCCEEDED(pDirectSoundCreate8(nullptr, &pDirectSound, nullptr)) &&
+            SUCCEEDED(pDirectSound->SetCooperativeLevel(DDhWnd, DSSCL_PRIORITY)))
+        {
+            WAVEFORMATEX Format = {};
+            Format.wFormatTag = WAVE_FORMAT_PCM;
+            Format.nChannels = 2;
+            Format.nSamplesPerSec = 44100;
+            Format.wBitsPerSample = 16;
+            Format.nBlockAlign = Format.nChannels * Format.wBitsPerSample / 8;
+            Format.nAvgBytesPerSec = Format.nSamplesPerSec * Format.nBlockAlign;
+
+            DSBUFFERDESC Desc = {};
+            Desc.dwSize = sizeof(DSBUFFERDESC);
+            Desc.dwFlags = DSBCAPS_CTRLVOLUME | DSBCAPS_GLOBALFOCUS;
+            Desc.dwBufferBytes = Format.nAvgBytesPerSec;
+            Desc.lpwfxFormat = &Format;
+            if (FAILED(pDirectSound->CreateSoundBuffer(&Desc, &pBuffer, nullptr)) || FAILED(pBuffer->Play(0, 0, DSBPLAY_LOOPING)))
+            {
+                if (pBuffer)
+                {
+                    pBuffer->Release();
+                    pBuffer = nullptr;
+                }
+            }
+        }
+
+        if (pBuffer)
+        {
+            BenchmarkPolls(pBuffer, "driver");
+            pBuffer->Stop();
+            pBuffer->Release();
+        }
+        else
+        {
+            MockDriver Driver;
+            Driver.Status = LoopingStatus;
+            BenchmarkPolls(&Driver, "no sound device, mock");
+        }
+
+        if (pDirectSound)
+        {
+            pDirectSound->Release();
+        }
+        if (dsound_dll)
+        {
+            FreeLibrary(dsound_dll);
+        }
+    }
+}
+
+void TestBufferStatusCache()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing BufferStatusCache";
+    Logging::Log() << "****";
+
+    DWORD TestID = 13500;
+
+    TestPlayStatus(TestID);
+    TestInvalidation(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkBufferStatusCache();
+    }
+}
@@ -0,0 +1,237 @@
+// Included first so the Direct3D 9 types are used the same way as in the wrapper
+#include "ddraw\SurfaceBlitter.h"
+#include "ddraw\ClipRects.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <string>
+
+namespace {
+    constexpr LONG GridSize = 64;
+
+    DWORD NextRandom(DWORD& Seed)
+    {
+        Seed = Seed * 214013 + 2531011;
+        return Seed >> 16;
+    }
+
+    RECT RandomRect(DWORD& Seed)
+    {
+        const LONG Left = NextRandom(Seed) % GridSize;
+        const LONG Top = NextRandom(Seed) % GridSize;
+        return { Left, Top, Left + 1 + (LONG)(NextRandom(Seed) % (GridSize - Left)), Top + 1 + (LONG)(NextRandom(Seed) % (GridSize - Top)) };
+    }
+
+    // Converts a coverage grid into y-x banded rects the same way GDI stores region data
+    std::vector<RECT> BuildBandedRects(const std::vector<BYTE>& Grid)
+    {
+        std::vector<RECT> Rects;
+        size_t BandStart = 0;
+        for (LONG y = 0; y < GridSize; y++)
+        {
+            std::vector<RECT> Spans;
+            for (LONG x = 0; x < GridSize; x++)
+            {
+                if (Grid[y * GridSize + x])
+                {
+                    LONG End = x;
+                    while (End < GridSize && Grid[y * GridSize + End])
+                    {
+                        End++;
+                    }
+                    Spans.push_back({ x, y, End, y + 1 });
+                    x = End;
+                }
+            }
+
+            // Rows with the same spans as the previous band extend it
+            bool IsSameBand = (y > 0 && !Spans.empty() && Rects.size() - BandStart == Spans.size() && Rects.back().bottom == y);
+            for (size_t i = 0; IsSameBand && i < Spans.size(); i++)
+            {
+                IsSameBand = (Rects[BandStart + i].left == Spans[i].left && Rects[BandStart + i].right == Spans[i].right);
+            }
+            if (IsSameBand)
+            {
+                for (size_t i = BandStart; i < Rects.size(); i++)
+                {
+                    Rects[i].bottom = y + 1;
+                }
+            }
+            else if (!Spans.empty())
+            {
+                BandStart = Rects.size();
+                Rects.insert(Rects.end(), Spans.begin(), Spans.end());
+            }
+        }
+        return Rects;
+    }
+
+    std::vector<BYTE> BuildCoverage(const std::vector<RECT>& Rects, DWORD Count)
+    {
+        std::vector<BYTE> Grid(GridSize * GridSize);
+        for (DWORD i = 0; i < Count; i++)
+        {
+            for (LONG y = Rects[i].top; y < Rects[i].bottom; y++)
+            {
+                for (LONG x = Rects[i].left; x < Rects[i].right; x++)
+                {
+                    Grid[y * GridSize + x] = 1;
+                }
+            }
+        }
+        return Grid;
+    }
+
+    // Every clipped pixel must be covered exactly once and only where both the clip list and the rect cover it
+    void TestBandIntersection(DWORD& TestID)
+    {
+        DWORD Seed = 1;
+        for (DWORD Count : { 1, 3, 8, 20 })
+        {
+            std::vector<RECT> Occluders(Count);
+            for (RECT& Rect : Occluders)
+            {
+                Rect = RandomRect(Seed);
+            }
+            const std::vector<BYTE> Coverage = BuildCoverage(Occluders, Count);
+            const std::vector<RECT> ClipRects = BuildBandedRects(Coverage);
+
+            bool IsSorted = true;
+            for (size_t i = 1; i < ClipRects.size(); i++)
+            {
+                IsSorted = IsSorted && ClipRects[i - 1].bottom <= ClipRects[i].bottom;
+            }
+            LOG_TEST_RESULT(TestID++, "Banded clip list from " << Count << " rects has non-decreasing bottom edges: ", IsSorted, true);
+
+            bool IsMatching = true;
+            std::vector<RECT> OutRects;
+            for (int Query = 0; Query < 200; Query++)
+            {
+                const RECT Rect = RandomRect(Seed);
+                IntersectClipRects(ClipRects, Rect, OutRects);
+
+                std::vector<BYTE> Hits(GridSize * GridSize);
+                for (const RECT& OutRect : OutRects)
+                {
+                    for (LONG y = OutRect.top; y < OutRect.bottom; y++)
+                    {
+                        for (LONG x = OutRect.left; x < OutRect.right; x++)
+                        {
+                            Hits[y * GridSize + x]++;
+                        }
+                    }
+                }
+                for (LONG y = 0; y < GridSize; y++)
+                {
+                    for (LONG x = 0; x < GridSize; x++)
+                    {
+                        const bool IsInside = x >= Rect.left && x < Rect.right && y >= Rect.top && y < Rect.bottom;
+                        IsMatching = IsMatching && Hits[y * GridSize + x] == ((IsInside && Coverage[y * GridSize + x]) ? 1 : 0);
+                    }
+                }
+            }
+            LOG_TEST_RESULT(TestID++, "Band intersection with " << ClipRects.size() << " clip rects matches brute force: ", IsMatching, true);
+        }
+
+        // Rect outside of all bands
+        std::vector<RECT> ClipRects = { { 0, 0, 10, 10 }, { 0, 20, 10, 30 } };
+        std::vector<RECT> OutRects;
+        IntersectClipRects(ClipRects, { 0, 10, 10, 20 }, OutRects);
+        LOG_TEST_RESULT(TestID++, "Rect between bands is fully clipped: ", OutRects.size(), 0);
+    }
+
+    // Each clipped part blitted on its own must give the same pixels as the unclipped stretch
+    void TestStretchParts(DWORD& TestID)
+    {
+        constexpr LONG SrcWidth = 37;
+        constexpr LONG SrcHeight = 23;
+        constexpr LONG DestWidth = 77;
+        constexpr LONG DestHeight = 41;
+
+        std::vector<DWORD> Src(SrcWidth * SrcHeight);
+        for (size_t i = 0; i < Src.size(); i++)
+        {
+            Src[i] = (DWORD)i;
+        }
+        std::vector<DWORD> Scratch((GetComplexCopyScratchSize(DestWidth, sizeof(DWORD)) + 3) / 4);
+        const D3DLOCKED_RECT SrcLockRect = { SrcWidth * sizeof(DWORD), Src.data() };
+
+        // Uneven grid so parts start between source pixels
+        const LONG SplitX[] = { 0, 5, 30, 31, 62, DestWidth };
+        const LONG SplitY[] = { 0, 7, 20, 33, DestHeight };
+
+        for (int Flags = 0; Flags < 4; Flags++)
+        {
+            const bool IsMirrorUpDown = (Flags & 1) != 0;
+            const bool IsMirrorLeftRight = (Flags & 2) != 0;
+            const std::string Options = std::string(IsMirrorUpDown ? " updown" : "") + (IsMirrorLeftRight ? " leftright" : "");
+
+            std::vector<DWORD> Expected(DestWidth * DestHeight);
+            D3DLOCKED_RECT DestLockRect = { DestWidth * sizeof(DWORD), Expected.data() };
+            ComplexCopy<DWORD>(0, SrcLockRect, DestLockRect, SrcWidth, SrcHeight, DestWidth, DestHeight, (BYTE*)Scratch.data(), false, IsMirrorUpDown, IsMirrorLeftRight);
+
+            std::vector<DWORD> Output(DestWidth * DestHeight);
+            bool IsSpanValid = true;
+            for (size_t py = 0; py + 1 < _countof(SplitY); py++)
+            {
+                for (size_t px = 0; px + 1 < _countof(SplitX); px++)
+                {
+                    const RECT Part = { SplitX[px], SplitY[py], SplitX[px + 1], SplitY[py + 1] };
+                    LONG SrcLeft, SrcRight, SrcTop, SrcBottom;
+                    GetStretchSrcSpan(SrcWidth, DestWidth, Part.left, Part.right, IsMirrorLeftRight, SrcLeft, SrcRight);
+                    GetStretchSrcSpan(SrcHeight, DestHeight, Part.top, Part.bottom, IsMirrorUpDown, SrcTop, SrcBottom);
+                    IsSpanValid = IsSpanValid && SrcLeft >= 0 && SrcRight <= SrcWidth && SrcLeft < SrcRight && SrcTop >= 0 && SrcBottom <= SrcHeight && SrcTop < SrcBottom;
+
+                    const STRETCHPART StretchPart = { SrcWidth, SrcHeight, DestWidth, DestHeight, Part.left, Part.top };
+                    const D3DLOCKED_RECT PartSrcLockRect = { SrcLockRect.Pitch, Src.data() + SrcTop * SrcWidth + SrcLeft };
+                    const D3DLOCKED_RECT PartDestLockRect = { DestLockRect.Pitch, Output.data() + Part.top * DestWidth + Part.left };
+                    ComplexCopy<DWORD>(0, PartSrcLockRect, PartDestLockRect, SrcRight - SrcLeft, SrcBottom - SrcTop, Part.right - Part.left, Part.bottom - Part.top,
+                        (BYTE*)Scratch.data(), false, IsMirrorUpDown, IsMirrorLeftRight, {}, 0, 0, &StretchPart);
+                }
+            }
+            LOG_TEST_RESULT(TestID++, "Stretch part source spans" << Options << " are inside the source: ", IsSpanValid, true);
+            LOG_TEST_RESULT(TestID++, "Stretch by parts" << Options << " matches the whole stretch: ", (Output == Expected), true);
+        }
+    }
+
+    // Logs the lookup time for a full screen blit against clip lists of different sizes
+    void BenchmarkBandIntersection()
+    {
+        for (LONG Count : { 1, 8, 64 })
+        {
+            // Count bands of one rect each down a 640x480 screen, like a window under a stack of others
+            std::vector<RECT> ClipRects;
+            for (LONG i = 0; i < Count; i++)
+            {
+                ClipRects.push_back({ (i * 7) % 64, i * 480 / Count, 640 - (i * 5) % 64, (i + 1) * 480 / Count });
+            }
+
+            std::vector<RECT> OutRects;
+            const RECT Rect = { 0, 0, 640, 480 };
+            const double Time = MeasureNanoseconds(100000, [&]()
+                {
+                    IntersectClipRects(ClipRects, Rect, OutRects);
+                });
+
+            Logging::Log() << "Benchmark: IntersectClipRects " << Count << " rects " << Time << " ns per blit";
+        }
+    }
+}
+
+void TestClipRects()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing ClipRects";
+    Logging::Log() << "****";
+
+    DWORD TestID = 8000;
+
+    TestBandIntersection(TestID);
+    TestStretchParts(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkBandIntersection();
+    }
+}
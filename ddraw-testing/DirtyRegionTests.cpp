@@ -0,0 +1,234 @@
+#include "ddraw\DirtyRegion.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+
+namespace {
+    bool IsRectEqual(const RECT& a, const RECT& b)
+    {
+        return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+    }
+
+    bool IsRectInside(const RECT& Inner, const RECT& Outer)
+    {
+        return Inner.left >= Outer.left && Inner.top >= Outer.top && Inner.right <= Outer.right && Inner.bottom <= Outer.bottom;
+    }
+
+    bool HasRect(const DirtyRegion& Region, const RECT& Rect)
+    {
+        for (DWORD x = 0; x < Region.GetCount(); x++)
+        {
+            if (IsRectEqual(Region.GetRects()[x], Rect))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Every added rect must still be covered by one of the boxes
+    bool IsCovered(const DirtyRegion& Region, const std::vector<RECT>& Added)
+    {
+        for (const RECT& Rect : Added)
+        {
+            bool Found = false;
+            for (DWORD x = 0; x < Region.GetCount() && !Found; x++)
+            {
+                Found = IsRectInside(Rect, Region.GetRects()[x]);
+            }
+            if (!Found)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    LONGLONG GetRegionArea(const DirtyRegion& Region)
+    {
+        LONGLONG Area = 0;
+        for (DWORD x = 0; x < Region.GetCount(); x++)
+        {
+            const RECT& Rect = Region.GetRects()[x];
+            Area += (LONGLONG)(Rect.right - Rect.left) * (Rect.bottom - Rect.top);
+        }
+        return Area;
+    }
+
+    void TestZeroCostAbsorb(DWORD& TestID)
+    {
+        DirtyRegion Region;
+
+        Region.Add({ 10, 10, 20, 20 });
+        Region.Add({ 12, 12, 18, 18 });
+        LOG_TEST_RESULT(TestID++, "Rect inside a box is absorbed: ", Region.GetCount(), 1);
+        LOG_TEST_RESULT(TestID++, "Box is unchanged by a rect inside it: ", (HasRect(Region, { 10, 10, 20, 20 })), true);
+
+        // Same height and touching, the union adds no area
+        Region.Add({ 20, 10, 30, 20 });
+        LOG_TEST_RESULT(TestID++, "Touching rect of the same height is absorbed: ", Region.GetCount(), 1);
+        LOG_TEST_RESULT(TestID++, "Touching rect is merged into one box: ", (HasRect(Region, { 10, 10, 30, 20 })), true);
+
+        // Gap of one pixel adds area so both boxes are kept
+        Region.Add({ 31, 10, 40, 20 });
+        LOG_TEST_RESULT(TestID++, "Rect with a gap is kept separate: ", Region.GetCount(), 2);
+
+        // Filling the gap lets the new rect absorb both boxes one after the other
+        Region.Add({ 30, 10, 31, 20 });
+        LOG_TEST_RESULT(TestID++, "Rect filling the gap absorbs both boxes: ", Region.GetCount(), 1);
+        LOG_TEST_RESULT(TestID++, "Boxes joined by the gap form one box: ", (HasRect(Region, { 10, 10, 40, 20 })), true);
+
+        // Overlapping but not covering the union adds area
+        Region.Add({ 35, 15, 50, 30 });
+        LOG_TEST_RESULT(TestID++, "Partly overlapping rect adding area is kept separate: ", Region.GetCount(), 2);
+
+        // Empty rects and adds after SetFull are ignored
+        Region.Add({ 5, 5, 5, 10 });
+        LOG_TEST_RESULT(TestID++, "Empty rect is ignored: ", Region.GetCount(), 2);
+        Region.SetFull();
+        Region.Add({ 0, 0, 10, 10 });
+        LOG_TEST_RESULT(TestID++, "Full region ignores adds: ", (Region.IsFullSurface() && Region.GetCount() == 0), true);
+        Region.Clear();
+        LOG_TEST_RESULT(TestID++, "Cleared region is empty: ", Region.IsEmpty(), true);
+    }
+
+    void TestRectCap(DWORD& TestID)
+    {
+        // Rects on a sparse grid never touch, so every add past the cap has to merge a pair
+        DirtyRegion Region;
+        std::vector<RECT> Added;
+        for (LONG i = 0; i < 40; i++)
+        {
+            const LONG x = (i * 7) % 10 * 50;
+            const LONG y = (i * 3) % 8 * 50;
+            const RECT Rect = { x, y, x + 10 + i % 5, y + 10 + i % 3 };
+            Region.Add(Rect);
+            Added.push_back(Rect);
+        }
+        LOG_TEST_RESULT(TestID++, "Box count is capped: ", Region.GetCount(), DirtyRegion::MaxRects);
+        LOG_TEST_RESULT(TestID++, "Every added rect is covered after merging: ", IsCovered(Region, Added), true);
+    }
+
+    void TestMinCostMerge(DWORD& TestID)
+    {
+        // Fill the region with boxes far apart, two of them are only 2 pixels apart
+        DirtyRegion Region;
+        for (LONG i = 0; i < (LONG)DirtyRegion::MaxRects - 1; i++)
+        {
+            Region.Add({ i * 100, 0, i * 100 + 10, 10 });
+        }
+        Region.Add({ 12, 0, 22, 10 });
+        LOG_TEST_RESULT(TestID++, "Region is full before the merge: ", Region.GetCount(), DirtyRegion::MaxRects);
+
+        // The new rect is far from all boxes so the close pair is the cheapest merge
+        Region.Add({ 0, 400, 10, 410 });
+        LOG_TEST_RESULT(TestID++, "Box count stays at the cap: ", Region.GetCount(), DirtyRegion::MaxRects);
+        LOG_TEST_RESULT(TestID++, "Closest pair is merged: ", (HasRect(Region, { 0, 0, 22, 10 })), true);
+        LOG_TEST_RESULT(TestID++, "New far rect is kept as its own box: ", (HasRect(Region, { 0, 400, 10, 410 })), true);
+        LOG_TEST_RESULT(TestID++, "Merge adds only the gap between the pair: ", GetRegionArea(Region), (LONGLONG)(DirtyRegion::MaxRects + 1) * 100 + 20);
+
+        // When the new rect is the cheapest to merge it joins its nearest box instead
+        DirtyRegion Region2;
+        for (LONG i = 0; i < (LONG)DirtyRegion::MaxRects; i++)
+        {
+            Region2.Add({ i * 100, 0, i * 100 + 10, 10 });
+        }
+        Region2.Add({ 312, 0, 322, 10 });
+        LOG_TEST_RESULT(TestID++, "New rect is merged with its nearest box: ", (HasRect(Region2, { 300, 0, 322, 10 })), true);
+        LOG_TEST_RESULT(TestID++, "Other boxes are unchanged: ", (HasRect(Region2, { 0, 0, 10, 10 }) && HasRect(Region2, { 700, 0, 710, 10 })), true);
+    }
+
+    constexpr LONG BenchmarkWidth = 640;
+    constexpr LONG BenchmarkHeight = 480;
+
+    const char* const PatternNames[] = { "score and health bar", "moving cursor", "HUD with minimap", "text lines" };
+
+    // Rects a game updates each frame for common UI elements
+    void GetPatternRects(DWORD Pattern, DWORD Frame, std::vector<RECT>& Rects)
+    {
+        Rects.clear();
+        switch (Pattern)
+        {
+        case 0:
+            Rects.push_back({ 8, 8, 108, 28 });
+            Rects.push_back({ 220, 460, 420, 470 });
+            break;
+        case 1:
+        {
+            const LONG x = (Frame * 9) % (BenchmarkWidth - 32);
+            const LONG y = (Frame * 5) % (BenchmarkHeight - 32);
+            Rects.push_back({ x, y, x + 32, y + 32 });
+            break;
+        }
+        case 2:
+            Rects.push_back({ 8, 8, 108, 28 });
+            Rects.push_back({ 504, 8, 632, 136 });
+            Rects.push_back({ 220, 460, 420, 470 });
+            Rects.push_back({ (LONG)(Frame % 600), 240, (LONG)(Frame % 600) + 16, 256 });
+            break;
+        default:
+            for (LONG i = 0; i < 12; i++)
+            {
+                Rects.push_back({ 16, 300 + i * 14, 216 + (LONG)((Frame + i) % 7) * 40, 312 + i * 14 });
+            }
+            break;
+        }
+    }
+
+    // Logs the bytes the palette expansion converts per frame with the region instead of the whole frame
+    void BenchmarkDirtyRegion()
+    {
+        constexpr LONG BytesPerPixel = 4;
+        constexpr DWORD FrameCount = 64;
+
+        std::vector<RECT> Rects;
+        for (DWORD Pattern = 0; Pattern < _countof(PatternNames); Pattern++)
+        {
+            DirtyRegion Region;
+            LONGLONG Bytes = 0;
+            for (DWORD Frame = 0; Frame < FrameCount; Frame++)
+            {
+                GetPatternRects(Pattern, Frame, Rects);
+                for (const RECT& Rect : Rects)
+                {
+                    Region.Add(Rect);
+                }
+                Bytes += GetRegionArea(Region) * BytesPerPixel;
+                Region.Clear();
+            }
+
+            DWORD Frame = 0;
+            const double AddTime = MeasureNanoseconds(10000, [&]()
+                {
+                    GetPatternRects(Pattern, Frame++, Rects);
+                    for (const RECT& Rect : Rects)
+                    {
+                        Region.Add(Rect);
+                    }
+                    Region.Clear();
+                });
+
+            Logging::Log() << "Benchmark: DirtyRegion " << PatternNames[Pattern] << " " << (Bytes / FrameCount) << " bytes per frame instead of " <<
+                (BenchmarkWidth * BenchmarkHeight * BytesPerPixel) << ", " << AddTime << " ns per frame to build the region";
+        }
+    }
+}
+
+void TestDirtyRegion()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing DirtyRegion";
+    Logging::Log() << "****";
+
+    DWORD TestID = 8500;
+
+    TestZeroCostAbsorb(TestID);
+    TestRectCap(TestID);
+    TestMinCostMerge(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkDirtyRegion();
+    }
+}
@@ -0,0 +1,248 @@
+#include "ddraw\DynamicBuffer.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <memory>
+
+namespace {
+    constexpr UINT MinBufferSize = 1024;
+
+    struct LOCKRECORD
+    {
+        UINT Offset;
+        UINT Size;
+        DWORD Flags;
+    };
+
+    // Headless stand-in for IDirect3DVertexBuffer9, only the methods DynamicBuffer uses
+    class MockVertexBuffer
+    {
+    public:
+        std::vector<BYTE> Data;
+        std::vector<LOCKRECORD> Locks;
+        DWORD DiscardLocks = 0;
+        DWORD NoOverwriteLocks = 0;
+        DWORD Unlocks = 0;
+        ULONG RefCount = 1;
+        bool IsLocked = false;
+        bool FailNoSysLock = false;
+
+        MockVertexBuffer(UINT Size) : Data(Size) {}
+
+        HRESULT Lock(UINT OffsetToLock, UINT SizeToLock, void** ppbData, DWORD Flags)
+        {
+            if (IsLocked || OffsetToLock + SizeToLock > Data.size() || (FailNoSysLock && (Flags & D3DLOCK_NOSYSLOCK)))
+            {
+                return E_FAIL;
+            }
+            Locks.push_back({ OffsetToLock, SizeToLock, Flags });
+            DiscardLocks += (Flags & D3DLOCK_DISCARD) ? 1 : 0;
+            NoOverwriteLocks += (Flags & D3DLOCK_NOOVERWRITE) ? 1 : 0;
+            IsLocked = true;
+            *ppbData = Data.data() + OffsetToLock;
+            return S_OK;
+        }
+
+        HRESULT Unlock()
+        {
+            Unlocks++;
+            IsLocked = false;
+            return S_OK;
+        }
+
+        ULONG Release()
+        {
+            return --RefCount;
+        }
+    };
+
+    // Owns every buffer it creates so released buffers can still be checked
+    struct MockDevice
+    {
+        std::vector<std::unique_ptr<MockVertexBuffer>> Buffers;
+        bool FailCreate = false;
+        bool FailNoSysLock = false;
+    };
+
+    HRESULT CreateDynamicBuffer(MockDevice* Device, UINT Size, MockVertexBuffer** ppBuffer)
+    {
+        if (Device->FailCreate)
+        {
+            return E_OUTOFMEMORY;
+        }
+        Device->Buffers.emplace_back(new MockVertexBuffer(Size));
+        Device->Buffers.back()->FailNoSysLock = Device->FailNoSysLock;
+        *ppBuffer = Device->Buffers.back().get();
+        return S_OK;
+    }
+
+    using MockDynamicBuffer = DynamicBuffer<MockVertexBuffer, MockDevice>;
+
+    std::vector<BYTE> BuildData(UINT Size, BYTE Seed)
+    {
+        std::vector<BYTE> Data(Size);
+        for (UINT i = 0; i < Size; i++)
+        {
+            Data[i] = (BYTE)(Seed + i * 7);
+        }
+        return Data;
+    }
+
+    bool IsDataAt(const MockVertexBuffer* pBuffer, UINT Offset, const std::vector<BYTE>& Data)
+    {
+        return Offset + Data.size() <= pBuffer->Data.size() && memcmp(pBuffer->Data.data() + Offset, Data.data(), Data.size()) == 0;
+    }
+
+    void TestAppendAndWrap(DWORD& TestID)
+    {
+        MockDevice Device;
+        MockDynamicBuffer Buffer(MinBufferSize);
+
+        // Four loads of 256 bytes fill the buffer exactly, only the first one discards
+        constexpr UINT Stride = 32;
+        constexpr UINT Count = 8;
+        bool IsIndexMatching = true;
+        bool IsDataMatching = true;
+        for (UINT x = 0; x < 4; x++)
+        {
+            const std::vector<BYTE> Data = BuildData(Count * Stride, (BYTE)x);
+            const INT Start = Buffer.Load(&Device, Data.data(), Count, Stride, 0);
+            IsIndexMatching = IsIndexMatching && Start == (INT)(x * Count);
+            IsDataMatching = IsDataMatching && Start >= 0 && IsDataAt(Buffer.GetBuffer(), Start * Stride, Data);
+        }
+        MockVertexBuffer* pMock = Buffer.GetBuffer();
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer appends return consecutive start vertices: ", IsIndexMatching, true);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer appends copy the data to the locked range: ", IsDataMatching, true);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer filling the buffer creates it once: ", Device.Buffers.size(), 1);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer filling the buffer discards once: ", pMock->DiscardLocks, 1);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer filling the buffer appends with NOOVERWRITE: ", pMock->NoOverwriteLocks, 3);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer first lock of a new buffer discards: ", (pMock->Locks[0].Offset == 0 && (pMock->Locks[0].Flags & D3DLOCK_DISCARD)), true);
+
+        // The next load does not fit so it wraps to the start and discards
+        const std::vector<BYTE> Data = BuildData(Count * Stride, 9);
+        const INT Start = Buffer.Load(&Device, Data.data(), Count, Stride, 0);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer full buffer wraps to the start: ", Start, 0);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer wrap discards: ", pMock->DiscardLocks, 2);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer wrap does not recreate the buffer: ", Device.Buffers.size(), 1);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer every lock is unlocked: ", pMock->Unlocks, pMock->Locks.size());
+
+        // A load that only fits without the remaining space wraps as well
+        const std::vector<BYTE> LargeData = BuildData(MinBufferSize, 11);
+        Buffer.Load(&Device, LargeData.data(), 1, 700, 0);
+        const INT WrapStart = Buffer.Load(&Device, LargeData.data(), 1, 400, 0);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer load past the end wraps: ", (WrapStart == 0 && (pMock->Locks.back().Flags & D3DLOCK_DISCARD)), true);
+
+        // Extra lock flags are passed through
+        Buffer.Load(&Device, Data.data(), 1, 16, D3DLOCK_NOSYSLOCK);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer passes the extra lock flags: ", (pMock->Locks.back().Flags == (D3DLOCK_NOSYSLOCK | D3DLOCK_NOOVERWRITE)), true);
+    }
+
+    void TestStrideAlignment(DWORD& TestID)
+    {
+        MockDevice Device;
+        MockDynamicBuffer Buffer(MinBufferSize);
+        const std::vector<BYTE> Data = BuildData(256, 3);
+
+        // 100 bytes of 20 byte vertices leaves the position between 24 byte vertices
+        Buffer.Load(&Device, Data.data(), 5, 20, 0);
+        const INT Start = Buffer.Load(&Device, Data.data(), 4, 24, 0);
+        MockVertexBuffer* pMock = Buffer.GetBuffer();
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer rounds the offset up to the stride: ", pMock->Locks.back().Offset, 120);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer start vertex is the aligned offset over the stride: ", Start, 5);
+
+        // Odd index counts leave the position on a two byte boundary
+        Buffer.Load(&Device, Data.data(), 3, 2, 0);
+        const INT IndexStart = Buffer.Load(&Device, Data.data(), 2, 4, 0);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer aligns after an odd index count: ", (pMock->Locks.back().Offset % 4 == 0 && (UINT)IndexStart * 4 == pMock->Locks.back().Offset), true);
+
+        // Every lock offset is a whole number of strides
+        bool IsAligned = true;
+        const UINT Strides[] = { 12, 28, 32, 36, 44, 2, 64 };
+        for (UINT x = 0; x < 100; x++)
+        {
+            const UINT Stride = Strides[x % _countof(Strides)];
+            const INT Index = Buffer.Load(&Device, Data.data(), 1 + x % 3, Stride, 0);
+            IsAligned = IsAligned && Index >= 0 && Buffer.GetBuffer()->Locks.back().Offset == (UINT)Index * Stride;
+        }
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer lock offsets are whole strides: ", IsAligned, true);
+    }
+
+    void TestGrowAndFailures(DWORD& TestID)
+    {
+        MockDevice Device;
+        MockDynamicBuffer Buffer(MinBufferSize);
+        const std::vector<BYTE> Data = BuildData(3000, 5);
+
+        Buffer.Load(&Device, Data.data(), 1, 32, 0);
+        const INT Start = Buffer.Load(&Device, Data.data(), 100, 30, 0);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer grows to the next power of two: ", Buffer.GetSize(), 4096);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer grown buffer starts at zero with a discard: ", (Start == 0 && Buffer.GetBuffer()->DiscardLocks == 1), true);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer releases the old buffer when growing: ", (Device.Buffers.size() == 2 && Device.Buffers[0]->RefCount == 0), true);
+
+        Buffer.Release();
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer release frees the buffer: ", (!Buffer.GetBuffer() && Buffer.GetSize() == 0 && Device.Buffers[1]->RefCount == 0), true);
+
+        // Locks that fail with NOSYSLOCK are retried without it
+        MockDevice NoSysLockDevice;
+        NoSysLockDevice.FailNoSysLock = true;
+        MockDynamicBuffer NoSysLockBuffer(MinBufferSize);
+        const INT NoSysLockStart = NoSysLockBuffer.Load(&NoSysLockDevice, Data.data(), 4, 16, D3DLOCK_NOSYSLOCK);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer retries a failed NOSYSLOCK lock without it: ", (NoSysLockStart == 0 && NoSysLockBuffer.GetBuffer()->Locks.size() == 1 && !(NoSysLockBuffer.GetBuffer()->Locks[0].Flags & D3DLOCK_NOSYSLOCK)), true);
+
+        // Invalid parameters and failed creates return -1
+        MockDevice FailDevice;
+        FailDevice.FailCreate = true;
+        MockDynamicBuffer FailBuffer(MinBufferSize);
+        const INT FailStart = FailBuffer.Load(&FailDevice, Data.data(), 1, 16, 0);
+        const INT ZeroCountStart = Buffer.Load(&Device, Data.data(), 0, 16, 0);
+        const INT NoDeviceStart = Buffer.Load(nullptr, Data.data(), 1, 16, 0);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer failed create returns -1: ", (FailStart == -1 && !FailBuffer.GetBuffer()), true);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer zero count returns -1: ", (ZeroCountStart == -1), true);
+        LOG_TEST_RESULT(TestID++, "DynamicBuffer no device returns -1: ", (NoDeviceStart == -1), true);
+    }
+
+    // Logs how many locks discard when streaming draws of common sizes, one discard per draw without the ring
+    void BenchmarkDynamicBuffer()
+    {
+        constexpr DWORD DrawCount = 1000;
+        const std::vector<BYTE> Data = BuildData(64 * 1024, 1);
+
+        for (UINT VertexCount : { 4, 32, 256 })
+        {
+            MockDevice Device;
+            MockDynamicBuffer Buffer(256 * 1024);
+            for (DWORD x = 0; x < DrawCount; x++)
+            {
+                Buffer.Load(&Device, Data.data(), VertexCount, 32, 0);
+            }
+            const DWORD DiscardLocks = Buffer.GetBuffer()->DiscardLocks;
+            const DWORD NoOverwriteLocks = Buffer.GetBuffer()->NoOverwriteLocks;
+
+            const double Time = MeasureNanoseconds(DrawCount, [&]()
+                {
+                    Buffer.Load(&Device, Data.data(), VertexCount, 32, 0);
+                });
+
+            Logging::Log() << "Benchmark: DynamicBuffer " << DrawCount << " draws of " << VertexCount << " vertices " << DiscardLocks << " discard locks and " << NoOverwriteLocks << " NOOVERWRITE locks, " << Time << " ns per load";
+        }
+    }
+}
+
+void TestDynamicBuffer()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing DynamicBuffer";
+    Logging::Log() << "****";
+
+    DWORD TestID = 10000;
+
+    TestAppendAndWrap(TestID);
+    TestStrideAlignment(TestID);
+    TestGrowAndFailures(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkDynamicBuffer();
+    }
+}
@@ -0,0 +1,580 @@
+#include "ddraw\ExecuteCompiler.h"
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <string>
+
+namespace {
+    constexpr DWORD TestVertexCount = 32;
+
+    // Each entry is one triangle or line, triangles are rotated to start with their lowest vertex so only the winding is compared
+    typedef std::vector<std::vector<WORD>> PRIMITIVELIST;
+
+    // Builds the instruction data of an execute buffer
+    struct INSTRUCTIONWRITER
+    {
+        std::vector<BYTE> Data;
+
+        template <typename T>
+        DWORD Add(BYTE Opcode, const std::vector<T>& Records)
+        {
+            const DWORD Offset = (DWORD)Data.size();
+            const D3DINSTRUCTION Instruction = { Opcode, (BYTE)sizeof(T), (WORD)Records.size() };
+            Data.insert(Data.end(), (const BYTE*)&Instruction, (const BYTE*)(&Instruction + 1));
+            Data.insert(Data.end(), (const BYTE*)Records.data(), (const BYTE*)(Records.data() + Records.size()));
+            return Offset;
+        }
+
+        DWORD AddExit()
+        {
+            const DWORD Offset = (DWORD)Data.size();
+            const D3DINSTRUCTION Instruction = { D3DOP_EXIT, 0, 0 };
+            Data.insert(Data.end(), (const BYTE*)&Instruction, (const BYTE*)(&Instruction + 1));
+            return Offset;
+        }
+
+        DWORD AddRenderState()
+        {
+            D3DSTATE State = {};
+            State.drstRenderStateType = D3DRENDERSTATE_SHADEMODE;
+            State.dwArg[0] = D3DSHADE_FLAT;
+            return Add(D3DOP_STATERENDER, std::vector<D3DSTATE>{ State });
+        }
+
+        // Branch offsets are relative to the branch instruction
+        void SetBranchTarget(DWORD BranchOffset, DWORD Target)
+        {
+            D3DBRANCH* Branch = (D3DBRANCH*)(Data.data() + BranchOffset + sizeof(D3DINSTRUCTION));
+            Branch->dwOffset = Target - BranchOffset;
+        }
+    };
+
+    D3DTRIANGLE Tri(WORD v1, WORD v2, WORD v3, WORD Flags)
+    {
+        D3DTRIANGLE Triangle = {};
+        Triangle.v1 = v1;
+        Triangle.v2 = v2;
+        Triangle.v3 = v3;
+        Triangle.wFlags = (WORD)(Flags | D3DTRIFLAG_EDGEENABLETRIANGLE);
+        return Triangle;
+    }
+
+    D3DLINE Line(WORD v1, WORD v2)
+    {
+        D3DLINE Entry = {};
+        Entry.v1 = v1;
+        Entry.v2 = v2;
+        return Entry;
+    }
+
+    D3DSPAN Span(WORD First, WORD Count)
+    {
+        D3DSPAN Entry = {};
+        Entry.wFirst = First;
+        Entry.wCount = Count;
+        return Entry;
+    }
+
+    D3DBRANCH Branch(DWORD Mask, DWORD BranchValue, BOOL Negate)
+    {
+        D3DBRANCH Entry = {};
+        Entry.dwMask = Mask;
+        Entry.dwValue = BranchValue;
+        Entry.bNegate = Negate;
+        return Entry;
+    }
+
+    void AddTriangle(PRIMITIVELIST& List, WORD a, WORD b, WORD c)
+    {
+        const std::vector<WORD> Rotated[] = { { a, b, c }, { b, c, a }, { c, a, b } };
+        List.push_back(min(Rotated[0], min(Rotated[1], Rotated[2])));
+    }
+
+    // Triangle records drawn the way the device used to interpret them: each START begins a new primitive
+    // and the first EVEN or ODD record after it makes the primitive a fan or a strip
+    void InterpretTriangles(PRIMITIVELIST& List, const D3DTRIANGLE* triangle, DWORD triangleCount, DWORD VertexCount)
+    {
+        std::vector<WORD> Vertices;
+        D3DPRIMITIVETYPE PrimitiveType = D3DPT_TRIANGLELIST;
+
+        auto Draw = [&]()
+            {
+                for (size_t i = 0; i + 2 < Vertices.size(); i++)
+                {
+                    if (PrimitiveType == D3DPT_TRIANGLEFAN)
+                    {
+                        AddTriangle(List, Vertices[0], Vertices[i + 1], Vertices[i + 2]);
+                    }
+                    else if (i & 1)
+                    {
+                        AddTriangle(List, Vertices[i + 1], Vertices[i], Vertices[i + 2]);
+                    }
+                    else
+                    {
+                        AddTriangle(List, Vertices[i], Vertices[i + 1], Vertices[i + 2]);
+                    }
+                }
+                Vertices.clear();
+            };
+
+        for (DWORD i = 0; i < triangleCount; i++)
+        {
+            const WORD TriFlags = (triangle[i].wFlags & 0x1F);
+
+            if (TriFlags < D3DTRIFLAG_STARTFLAT(30))
+            {
+                Draw();
+                if (triangle[i].v1 < VertexCount && triangle[i].v2 < VertexCount && triangle[i].v3 < VertexCount)
+                {
+                    Vertices = { triangle[i].v1, triangle[i].v2, triangle[i].v3 };
+                    PrimitiveType = D3DPT_TRIANGLELIST;
+                }
+            }
+            else if (!Vertices.empty() && triangle[i].v3 < VertexCount)
+            {
+                if (PrimitiveType == D3DPT_TRIANGLELIST)
+                {
+                    PrimitiveType = (TriFlags == D3DTRIFLAG_EVEN) ? D3DPT_TRIANGLEFAN : D3DPT_TRIANGLESTRIP;
+                }
+                Vertices.push_back(triangle[i].v3);
+            }
+        }
+        Draw();
+    }
+
+    bool IsBranchTaken(const D3DBRANCH& Entry, DWORD Status)
+    {
+        bool Condition = ((Status & Entry.dwMask) == Entry.dwValue);
+        return Entry.bNegate ? !Condition : Condition;
+    }
+
+    // Walks the raw instructions like Execute() did before the buffers were compiled
+    PRIMITIVELIST Interpret(const std::vector<BYTE>& Data, DWORD VertexCount, DWORD Status)
+    {
+        PRIMITIVELIST List;
+
+        const BYTE* instructionData = Data.data();
+        const BYTE* instructionEnd = Data.data() + Data.size();
+
+        while (instructionData + sizeof(D3DINSTRUCTION) <= instructionEnd)
+        {
+            const D3DINSTRUCTION* instruction = (const D3DINSTRUCTION*)instructionData;
+            const BYTE* opstruct = instructionData + sizeof(D3DINSTRUCTION);
+            const DWORD instructionSize = sizeof(D3DINSTRUCTION) + (instruction->wCount * instruction->bSize);
+
+            if (instruction->bOpcode == D3DOP_EXIT || instructionData + instructionSize > instructionEnd)
+            {
+                break;
+            }
+
+            bool Branched = false;
+
+            switch (instruction->bOpcode)
+            {
+            case D3DOP_TRIANGLE:
+                InterpretTriangles(List, (const D3DTRIANGLE*)opstruct, instruction->wCount, VertexCount);
+                break;
+            case D3DOP_LINE:
+            {
+                const D3DLINE* line = (const D3DLINE*)opstruct;
+                for (DWORD i = 0; i < instruction->wCount; i++)
+                {
+                    if (line[i].v1 < VertexCount && line[i].v2 < VertexCount)
+                    {
+                        List.push_back({ line[i].v1, line[i].v2 });
+                    }
+                }
+                break;
+            }
+            case D3DOP_SPAN:
+            {
+                // The vertices of all spans were drawn as one line strip
+                std::vector<WORD> Vertices;
+                const D3DSPAN* span = (const D3DSPAN*)opstruct;
+                for (DWORD i = 0; i < instruction->wCount; i++)
+                {
+                    if ((DWORD)span[i].wFirst < VertexCount)
+                    {
+                        const DWORD count = min((DWORD)span[i].wCount, VertexCount - span[i].wFirst);
+                        for (DWORD x = 0; x < count; x++)
+                        {
+                            Vertices.push_back((WORD)(span[i].wFirst + x));
+                        }
+                    }
+                }
+                for (size_t i = 1; i < Vertices.size(); i++)
+                {
+                    List.push_back({ Vertices[i - 1], Vertices[i] });
+                }
+                break;
+            }
+            case D3DOP_BRANCHFORWARD:
+            {
+                const D3DBRANCH* branch = (const D3DBRANCH*)opstruct;
+                for (DWORD i = 0; i < instruction->wCount; i++)
+                {
+                    if (IsBranchTaken(branch[i], Status))
+                    {
+                        if (!branch[i].dwOffset)
+                        {
+                            return List;
+                        }
+                        Branched = true;
+                        instructionData += branch[i].dwOffset;
+                        break;
+                    }
+                }
+                break;
+            }
+            }
+
+            if (!Branched)
+            {
+                instructionData += instructionSize;
+            }
+        }
+
+        return List;
+    }
+
+    // Walks the compiled commands the same way Execute() does
+    PRIMITIVELIST Replay(const EXECUTECOMMANDLIST& CommandList, DWORD Status)
+    {
+        PRIMITIVELIST List;
+
+        size_t CommandIndex = 0;
+        while (CommandIndex < CommandList.Commands.size())
+        {
+            const EXECUTECOMMAND& Command = CommandList.Commands[CommandIndex];
+            size_t NextCommandIndex = CommandIndex + 1;
+
+            if (Command.Opcode == D3DOP_EXIT)
+            {
+                break;
+            }
+
+            const WORD* pIndices = CommandList.Indices.data() + Command.StartIndex;
+            const WORD Base = (WORD)Command.BaseVertex;
+
+            if (Command.Opcode == D3DOP_TRIANGLE)
+            {
+                for (DWORD i = 0; i + 2 < Command.IndexCount; i += 3)
+                {
+                    AddTriangle(List, Base + pIndices[i], Base + pIndices[i + 1], Base + pIndices[i + 2]);
+                }
+            }
+            else if (Command.Opcode == D3DOP_LINE || Command.Opcode == D3DOP_SPAN)
+            {
+                for (DWORD i = 0; i + 1 < Command.IndexCount; i += 2)
+                {
+                    List.push_back({ (WORD)(Base + pIndices[i]), (WORD)(Base + pIndices[i + 1]) });
+                }
+            }
+            else if (Command.Opcode == D3DOP_BRANCHFORWARD)
+            {
+                const D3DINSTRUCTION* instruction = (const D3DINSTRUCTION*)(CommandList.pInstructions + Command.Offset);
+                const D3DBRANCH* branch = (const D3DBRANCH*)(CommandList.pInstructions + Command.Offset + sizeof(D3DINSTRUCTION));
+                bool IsExit = false;
+                for (DWORD i = 0; i < instruction->wCount; i++)
+                {
+                    if (IsBranchTaken(branch[i], Status))
+                    {
+                        IsExit = !branch[i].dwOffset;
+                        NextCommandIndex = IsExit ? NextCommandIndex : FindExecuteCommand(CommandList, Command.Offset + branch[i].dwOffset);
+                        break;
+                    }
+                }
+                if (IsExit)
+                {
+                    break;
+                }
+            }
+
+            CommandIndex = NextCommandIndex;
+        }
+
+        return List;
+    }
+
+    DWORD GetDrawCommandCount(const EXECUTECOMMANDLIST& CommandList)
+    {
+        DWORD Count = 0;
+        for (const auto& Command : CommandList.Commands)
+        {
+            Count += (Command.Opcode == D3DOP_TRIANGLE || Command.Opcode == D3DOP_LINE || Command.Opcode == D3DOP_SPAN) ? 1 : 0;
+        }
+        return Count;
+    }
+
+    // Compiles the buffer and checks the replayed primitives against the interpreted ones
+    void CompareWithInterpreter(DWORD& TestID, const std::string& Name, const INSTRUCTIONWRITER& Writer, DWORD ExpectedCount, DWORD Status = 0)
+    {
+        EXECUTECOMMANDLIST CommandList;
+        CompileExecuteInstructions(CommandList, Writer.Data.data(), (DWORD)Writer.Data.size(), TestVertexCount);
+
+        const PRIMITIVELIST Expected = Interpret(Writer.Data, TestVertexCount, Status);
+        const PRIMITIVELIST Output = Replay(CommandList, Status);
+
+        const std::string Entry = Name + " status " + std::to_string(Status);
+        LOG_TEST_RESULT(TestID++, Entry << " interpreted primitive count: ", Expected.size(), ExpectedCount);
+        LOG_TEST_RESULT(TestID++, Entry << " compiled matches interpreted: ", (Output == Expected), true);
+    }
+
+    void TestTriangleLists(DWORD& TestID)
+    {
+        INSTRUCTIONWRITER Writer;
+        Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{
+            Tri(0, 1, 2, D3DTRIFLAG_START),
+            Tri(3, 4, 5, D3DTRIFLAG_START),
+            Tri(6, 7, 8, D3DTRIFLAG_STARTFLAT(1)),
+            Tri(9, 10, 40, D3DTRIFLAG_START) });   // Out of range, skipped
+        CompareWithInterpreter(TestID, "TRIANGLE list", Writer, 3);
+    }
+
+    void TestStripsAndFans(DWORD& TestID)
+    {
+        {
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{
+                Tri(0, 1, 2, D3DTRIFLAG_START),
+                Tri(0, 0, 3, D3DTRIFLAG_ODD),
+                Tri(0, 0, 4, D3DTRIFLAG_EVEN),
+                Tri(0, 0, 5, D3DTRIFLAG_ODD),
+                Tri(0, 0, 6, D3DTRIFLAG_EVEN) });
+            CompareWithInterpreter(TestID, "TRIANGLE strip", Writer, 5);
+        }
+        {
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{
+                Tri(10, 11, 12, D3DTRIFLAG_START),
+                Tri(0, 0, 13, D3DTRIFLAG_EVEN),
+                Tri(0, 0, 14, D3DTRIFLAG_EVEN),
+                Tri(0, 0, 15, D3DTRIFLAG_EVEN) });
+            CompareWithInterpreter(TestID, "TRIANGLE fan", Writer, 4);
+        }
+        {
+            // Strip, fan and list in one instruction, with a vertex out of range inside the strip
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{
+                Tri(0, 1, 2, D3DTRIFLAG_START),
+                Tri(0, 0, 3, D3DTRIFLAG_ODD),
+                Tri(0, 0, 50, D3DTRIFLAG_EVEN),
+                Tri(0, 0, 4, D3DTRIFLAG_EVEN),
+                Tri(20, 21, 22, D3DTRIFLAG_START),
+                Tri(0, 0, 23, D3DTRIFLAG_EVEN),
+                Tri(0, 0, 24, D3DTRIFLAG_EVEN),
+                Tri(25, 26, 27, D3DTRIFLAG_START),
+                Tri(28, 29, 30, D3DTRIFLAG_START) });
+            CompareWithInterpreter(TestID, "TRIANGLE strip, fan and list", Writer, 8);
+        }
+    }
+
+    void TestSpans(DWORD& TestID)
+    {
+        {
+            // Consecutive spans are joined, a span past the vertex count is skipped and one with too many vertices is clipped
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_SPAN, std::vector<D3DSPAN>{ Span(0, 3), Span(10, 2), Span(40, 4), Span(30, 5) });
+            CompareWithInterpreter(TestID, "SPAN strip", Writer, 6);
+        }
+        {
+            // Each instruction is its own strip, even when merged with the lines after it
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_SPAN, std::vector<D3DSPAN>{ Span(0, 2) });
+            Writer.Add(D3DOP_SPAN, std::vector<D3DSPAN>{ Span(5, 1), Span(8, 2) });
+            Writer.Add(D3DOP_LINE, std::vector<D3DLINE>{ Line(20, 21) });
+            CompareWithInterpreter(TestID, "SPAN and LINE merging", Writer, 4);
+        }
+    }
+
+    void TestMerging(DWORD& TestID)
+    {
+        {
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(0, 1, 2, D3DTRIFLAG_START) });
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(3, 4, 5, D3DTRIFLAG_START), Tri(0, 0, 6, D3DTRIFLAG_ODD) });
+            Writer.Add(D3DOP_LINE, std::vector<D3DLINE>{ Line(7, 8) });
+            Writer.AddRenderState();
+            Writer.Add(D3DOP_LINE, std::vector<D3DLINE>{ Line(9, 10), Line(10, 11) });
+            Writer.AddExit();
+            CompareWithInterpreter(TestID, "TRIANGLE and LINE merging", Writer, 6);
+
+            EXECUTECOMMANDLIST CommandList;
+            CompileExecuteInstructions(CommandList, Writer.Data.data(), (DWORD)Writer.Data.size(), TestVertexCount);
+            LOG_TEST_RESULT(TestID++, "Adjacent draws merged until the type or state changes: ", GetDrawCommandCount(CommandList), 3);
+        }
+    }
+
+    void TestBranches(DWORD& TestID)
+    {
+        {
+            // Taken branch skips the second draw, the target starts its own command
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(0, 1, 2, D3DTRIFLAG_START) });
+            const DWORD BranchOffset = Writer.Add(D3DOP_BRANCHFORWARD, std::vector<D3DBRANCH>{ Branch(0x1, 0x1, FALSE) });
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(3, 4, 5, D3DTRIFLAG_START) });
+            const DWORD Target = Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(6, 7, 8, D3DTRIFLAG_START), Tri(0, 0, 9, D3DTRIFLAG_EVEN) });
+            Writer.AddExit();
+            Writer.SetBranchTarget(BranchOffset, Target);
+            CompareWithInterpreter(TestID, "BRANCHFORWARD skip", Writer, 4, 0);
+            CompareWithInterpreter(TestID, "BRANCHFORWARD skip", Writer, 3, 1);
+
+            EXECUTECOMMANDLIST CommandList;
+            CompileExecuteInstructions(CommandList, Writer.Data.data(), (DWORD)Writer.Data.size(), TestVertexCount);
+            LOG_TEST_RESULT(TestID++, "BRANCHFORWARD target starts a command: ", (FindExecuteCommand(CommandList, Target) != CommandList.Commands.size()), true);
+        }
+        {
+            // The second record is used when the first does not match
+            INSTRUCTIONWRITER Writer;
+            const DWORD BranchOffset = Writer.Add(D3DOP_BRANCHFORWARD, std::vector<D3DBRANCH>{ Branch(0x2, 0x2, FALSE), Branch(0x1, 0x1, TRUE) });
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(0, 1, 2, D3DTRIFLAG_START) });
+            const DWORD Target1 = Writer.Add(D3DOP_LINE, std::vector<D3DLINE>{ Line(3, 4) });
+            const DWORD Target2 = Writer.Add(D3DOP_LINE, std::vector<D3DLINE>{ Line(5, 6) });
+            Writer.AddExit();
+            D3DBRANCH* Records = (D3DBRANCH*)(Writer.Data.data() + BranchOffset + sizeof(D3DINSTRUCTION));
+            Records[0].dwOffset = Target1 - BranchOffset;
+            Records[1].dwOffset = Target2 - BranchOffset;
+            CompareWithInterpreter(TestID, "BRANCHFORWARD records", Writer, 1, 0);
+            CompareWithInterpreter(TestID, "BRANCHFORWARD records", Writer, 3, 1);
+            CompareWithInterpreter(TestID, "BRANCHFORWARD records", Writer, 2, 2);
+            CompareWithInterpreter(TestID, "BRANCHFORWARD records", Writer, 2, 3);
+        }
+        {
+            // A taken branch with no offset ends the buffer
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(0, 1, 2, D3DTRIFLAG_START) });
+            Writer.Add(D3DOP_BRANCHFORWARD, std::vector<D3DBRANCH>{ Branch(0x1, 0x1, FALSE) });
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(3, 4, 5, D3DTRIFLAG_START) });
+            CompareWithInterpreter(TestID, "BRANCHFORWARD exit", Writer, 2, 0);
+            CompareWithInterpreter(TestID, "BRANCHFORWARD exit", Writer, 1, 1);
+        }
+    }
+
+    void TestExit(DWORD& TestID)
+    {
+        {
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(0, 1, 2, D3DTRIFLAG_START) });
+            Writer.AddExit();
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(3, 4, 5, D3DTRIFLAG_START) });
+            CompareWithInterpreter(TestID, "EXIT", Writer, 1);
+        }
+        {
+            // Instructions after an exit are still reachable by a branch
+            INSTRUCTIONWRITER Writer;
+            Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(0, 1, 2, D3DTRIFLAG_START) });
+            const DWORD BranchOffset = Writer.Add(D3DOP_BRANCHFORWARD, std::vector<D3DBRANCH>{ Branch(0x1, 0x1, FALSE) });
+            Writer.AddExit();
+            const DWORD Target = Writer.Add(D3DOP_TRIANGLE, std::vector<D3DTRIANGLE>{ Tri(3, 4, 5, D3DTRIFLAG_START), Tri(0, 0, 6, D3DTRIFLAG_ODD) });
+            Writer.SetBranchTarget(BranchOffset, Target);
+            CompareWithInterpreter(TestID, "EXIT skipped by BRANCHFORWARD", Writer, 1, 0);
+            CompareWithInterpreter(TestID, "EXIT skipped by BRANCHFORWARD", Writer, 3, 1);
+        }
+    }
+
+    // Logs the parse and draw cost per frame of a synthetic execute buffer with 100 state changes, each followed by
+    // a strip, a list and lines. Interpreted is the old path, uncached compiles every frame like after each Lock and
+    // cached only walks the commands like an Execute of an unchanged buffer.
+    void BenchmarkExecuteCompiler()
+    {
+        constexpr DWORD VertexCount = 1024;
+        constexpr DWORD Count = 1000;
+
+        INSTRUCTIONWRITER Writer;
+        for (WORD Group = 0; Group < 100; Group++)
+        {
+            const WORD Base = (WORD)(Group * 10 % (VertexCount - 40));
+            Writer.AddRenderState();
+
+            std::vector<D3DTRIANGLE> Strip = { Tri(Base, Base + 1, Base + 2, D3DTRIFLAG_START) };
+            for (WORD x = 0; x < 20; x++)
+            {
+                Strip.push_back(Tri(0, 0, Base + 3 + x, (x & 1) ? D3DTRIFLAG_EVEN : D3DTRIFLAG_ODD));
+            }
+            Writer.Add(D3DOP_TRIANGLE, Strip);
+
+            std::vector<D3DTRIANGLE> List;
+            for (WORD x = 0; x < 10; x++)
+            {
+                List.push_back(Tri(Base + x, Base + x + 1, Base + x + 2, D3DTRIFLAG_START));
+            }
+            Writer.Add(D3DOP_TRIANGLE, List);
+
+            std::vector<D3DLINE> Lines;
+            for (WORD x = 0; x < 5; x++)
+            {
+                Lines.push_back(Line(Base + x, Base + x + 1));
+            }
+            Writer.Add(D3DOP_LINE, Lines);
+        }
+        Writer.AddExit();
+
+        // Stands in for the draws Execute issues from the compiled commands
+        volatile DWORD IndexSum = 0;
+        auto Draw = [&](const EXECUTECOMMANDLIST& CommandList)
+            {
+                DWORD Sum = 0;
+                for (const auto& Command : CommandList.Commands)
+                {
+                    if (Command.Opcode == D3DOP_TRIANGLE || Command.Opcode == D3DOP_LINE)
+                    {
+                        Sum += Command.BaseVertex + Command.IndexCount;
+                    }
+                }
+                IndexSum = IndexSum + Sum;
+            };
+
+        volatile size_t PrimitiveCount = 0;
+        const double InterpretTime = MeasureNanoseconds(Count, [&]()
+            {
+                PrimitiveCount = Interpret(Writer.Data, VertexCount, 0).size();
+            });
+
+        const double FreshTime = MeasureNanoseconds(Count, [&]()
+            {
+                EXECUTECOMMANDLIST CommandList;
+                CompileExecuteInstructions(CommandList, Writer.Data.data(), (DWORD)Writer.Data.size(), VertexCount);
+                Draw(CommandList);
+            });
+
+        EXECUTECOMMANDLIST CommandList;
+        const double UncachedTime = MeasureNanoseconds(Count, [&]()
+            {
+                CommandList.IsCompiled = false;
+                CompileExecuteInstructions(CommandList, Writer.Data.data(), (DWORD)Writer.Data.size(), VertexCount);
+                Draw(CommandList);
+            });
+        const double CachedTime = MeasureNanoseconds(Count, [&]()
+            {
+                if (!CommandList.IsCompiled || CommandList.pInstructions != Writer.Data.data())
+                {
+                    CompileExecuteInstructions(CommandList, Writer.Data.data(), (DWORD)Writer.Data.size(), VertexCount);
+                }
+                Draw(CommandList);
+            });
+
+        Logging::Log() << "Benchmark: ExecuteCompiler " << Writer.Data.size() << " bytes to " << GetDrawCommandCount(CommandList) << " draws, interpreted " <<
+            (InterpretTime / 1000.0) << " us, uncached " << (UncachedTime / 1000.0) << " us, uncached with a new list " << (FreshTime / 1000.0) << " us, cached " << (CachedTime / 1000.0) << " us per frame";
+    }
+}
+
+void TestExecuteCompiler()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing ExecuteCompiler";
+    Logging::Log() << "****";
+
+    DWORD TestID = 5500;
+
+    TestTriangleLists(TestID);
+    TestStripsAndFans(TestID);
+    TestSpans(TestID);
+    TestMerging(TestID);
+    TestBranches(TestID);
+    TestExit(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkExecuteCompiler();
+    }
+}
@@ -0,0 +1,256 @@
+#include "Utils\FrameLimiter.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+
+namespace {
+    // One tick is a microsecond so the limiter constants read directly
+    constexpr LONGLONG TestFrequency = 1000000;
+    constexpr LONGLONG SpinStep = 10;
+
+    // Time only moves when the limiter sleeps or spins, or when the test moves it
+    class FakeClock : public Utils::FrameLimiterClock
+    {
+    public:
+        LONGLONG Time = 1000000;
+        LONGLONG Late = 0;          // How much later than asked each sleep wakes up
+        LONGLONG Jitter = 0;        // Random extra lateness up to this on each sleep
+        DWORD Seed = 1;
+        bool CanSleep = true;
+        DWORD Sleeps = 0;
+        DWORD Spins = 0;
+        LONGLONG SleptTicks = 0;
+        LONGLONG SpunTicks = 0;
+
+        LONGLONG GetFrequency() override { return TestFrequency; }
+        LONGLONG GetTime() override { return Time; }
+        bool Sleep(LONGLONG Ticks) override
+        {
+            if (!CanSleep)
+            {
+                return false;
+            }
+            Sleeps++;
+            LONGLONG Slept = Ticks + Late;
+            if (Jitter)
+            {
+                Seed = Seed * 214013 + 2531011;
+                Slept += (Seed >> 8) % Jitter;
+            }
+            SleptTicks += Slept;
+            Time += Slept;
+            return true;
+        }
+        void Spin(LONGLONG Ticks) override
+        {
+            Spins++;
+            const LONGLONG Spun = (Ticks < SpinStep) ? Ticks : SpinStep;
+            SpunTicks += Spun;
+            Time += Spun;
+        }
+    };
+
+    void TestSpinMargin(DWORD& TestID)
+    {
+        FakeClock Clock;
+        Utils::FrameLimiter Limiter(Clock);
+        LOG_TEST_RESULT(TestID++, "Frequency comes from the clock: ", (Limiter.GetFrequency() == TestFrequency), true);
+        LOG_TEST_RESULT(TestID++, "Spin margin starts at 1ms: ", (Limiter.GetSpinMargin() == 1000), true);
+
+        // Sleeps until the margin before the target and spins the rest
+        Clock.Late = 200;
+        LONGLONG Target = Clock.Time + 10000;
+        Limiter.WaitUntil(Target);
+        LOG_TEST_RESULT(TestID++, "Wait sleeps once: ", Clock.Sleeps, 1);
+        LOG_TEST_RESULT(TestID++, "Wait spins after waking: ", (Clock.Spins > 0), true);
+        LOG_TEST_RESULT(TestID++, "Wait ends on the target: ", (Clock.Time == Target), true);
+
+        // The margin grows at once to half again above how late the sleep woke
+        Clock.Late = 2000;
+        Limiter.WaitUntil(Clock.Time + 10000);
+        LOG_TEST_RESULT(TestID++, "Margin grows at once for a late wake: ", (Limiter.GetSpinMargin() == 3000), true);
+
+        // A wake later than the target leaves nothing to spin
+        Clock.Late = 5000;
+        Clock.Spins = 0;
+        Target = Clock.Time + 10000;
+        Limiter.WaitUntil(Target);
+        LOG_TEST_RESULT(TestID++, "Margin is capped at 4ms: ", (Limiter.GetSpinMargin() == 4000), true);
+        LOG_TEST_RESULT(TestID++, "Wait past the target does not spin: ", (Clock.Spins == 0 && Clock.Time == Target + 2000), true);
+
+        // The margin shrinks by 1/16 of the difference per wait down to its floor
+        Clock.Late = 100;
+        Limiter.WaitUntil(Clock.Time + 10000);
+        LOG_TEST_RESULT(TestID++, "Margin shrinks slowly for an early wake: ", (Limiter.GetSpinMargin() == 4000 - (4000 - 250) / 16), true);
+        for (DWORD x = 0; x < 200; x++)
+        {
+            Limiter.WaitUntil(Clock.Time + 10000);
+        }
+        LOG_TEST_RESULT(TestID++, "Margin settles just above the 0.25ms floor: ", (Limiter.GetSpinMargin() >= 250 && Limiter.GetSpinMargin() < 270), true);
+
+        // Targets within the margin only spin
+        const DWORD Sleeps = Clock.Sleeps;
+        Target = Clock.Time + Limiter.GetSpinMargin();
+        Limiter.WaitUntil(Target);
+        LOG_TEST_RESULT(TestID++, "Target within the margin does not sleep: ", (Clock.Sleeps == Sleeps && Clock.Time == Target), true);
+
+        // Without a timer the whole wait is spun and the margin is left as is
+        const LONGLONG SpinMargin = Limiter.GetSpinMargin();
+        Clock.CanSleep = false;
+        Target = Clock.Time + 5000;
+        Limiter.WaitUntil(Target);
+        LOG_TEST_RESULT(TestID++, "Failed sleep spins the whole wait: ", (Clock.Time == Target && Limiter.GetSpinMargin() == SpinMargin), true);
+
+        // A target in the past returns at once
+        Clock.Spins = 0;
+        Target = Clock.Time;
+        Limiter.WaitUntil(Target - 100);
+        LOG_TEST_RESULT(TestID++, "Target in the past does not wait: ", (Clock.Spins == 0 && Clock.Time == Target), true);
+    }
+
+    // Runs one frame, the wait then a present that takes PresentTime, and returns when it finished
+    LONGLONG RunFrame(FakeClock& Clock, Utils::FrameLimiter& Limiter, LONGLONG PresentTime)
+    {
+        Limiter.WaitForFrame();
+        Clock.Time += PresentTime;
+        Limiter.EndPresent();
+        return Clock.Time;
+    }
+
+    void TestPresentCompensation(DWORD& TestID)
+    {
+        FakeClock Clock;
+        Clock.Late = 300;
+        Utils::FrameLimiter Limiter(Clock);
+
+        // No limit set, nothing waits
+        const LONGLONG Start = Clock.Time;
+        Limiter.WaitForFrame();
+        Limiter.EndPresent();
+        LOG_TEST_RESULT(TestID++, "No frame rate does not wait: ", (Clock.Time == Start && Limiter.GetPresentTicks() == 0), true);
+
+        // 100 FPS with a 2ms present, the average present time converges and is waited less
+        // The first frame starts the cadence, frame N should finish N frame times after it started
+        Limiter.SetFrameRate(100.0);
+        const LONGLONG CadenceStart = Clock.Time;
+        LONGLONG LastEnd = RunFrame(Clock, Limiter, 2000);
+        LONGLONG Frames = 1;
+        for (; Frames <= 100; Frames++)
+        {
+            LastEnd = RunFrame(Clock, Limiter, 2000);
+        }
+        LOG_TEST_RESULT(TestID++, "Average present time converges: ", (Limiter.GetPresentTicks() > 1950 && Limiter.GetPresentTicks() <= 2000), true);
+
+        bool IsOnCadence = true;
+        for (DWORD x = 0; x < 20; x++, Frames++)
+        {
+            const LONGLONG End = RunFrame(Clock, Limiter, 2000);
+            IsOnCadence = IsOnCadence && End - LastEnd == 10000;
+            LastEnd = End;
+        }
+        LOG_TEST_RESULT(TestID++, "Presents finish every frame time: ", IsOnCadence, true);
+
+        // Without compensation the present would finish a present time after each deadline
+        const LONGLONG Deadline = CadenceStart + Frames * 10000;
+        const LONGLONG End = RunFrame(Clock, Limiter, 2000);
+        LOG_TEST_RESULT(TestID++, "Present finishes within 50us of its deadline: ", (End >= Deadline - 50 && End <= Deadline + 50), true);
+
+        // A present longer than half the frame only reserves half the frame
+        for (DWORD x = 0; x < 100; x++)
+        {
+            RunFrame(Clock, Limiter, 8000);
+        }
+        LOG_TEST_RESULT(TestID++, "Present time is capped at half the frame: ", (Limiter.GetPresentTicks() <= 5000 && Limiter.GetPresentTicks() > 4900), true);
+
+        // A failed present is not measured
+        const LONGLONG PresentTicks = Limiter.GetPresentTicks();
+        Limiter.WaitForFrame();
+        Clock.Time += 100;
+        Limiter.CancelPresent();
+        Limiter.EndPresent();
+        LOG_TEST_RESULT(TestID++, "Cancelled present is not measured: ", (Limiter.GetPresentTicks() == PresentTicks), true);
+
+        // Falling behind restarts the cadence instead of waiting to catch up
+        Limiter.SetFrameRate(50.0);
+        RunFrame(Clock, Limiter, 1000);
+        const DWORD Sleeps = Clock.Sleeps;
+        Clock.Time += 30000;
+        const LONGLONG Behind = Clock.Time;
+        Limiter.WaitForFrame();
+        LOG_TEST_RESULT(TestID++, "Late frame does not wait: ", (Clock.Time == Behind && Clock.Sleeps == Sleeps), true);
+        Limiter.EndPresent();
+        RunFrame(Clock, Limiter, 1000);
+        LOG_TEST_RESULT(TestID++, "Cadence restarts from the late frame: ", (Clock.Sleeps == Sleeps + 1), true);
+    }
+
+    // Logs the frame time error distribution and the time slept and spun per frame at 60 FPS, with sleeps
+    // waking up to 3ms late and a present taking 1.5 to 2.5ms
+    void BenchmarkFrameLimiter()
+    {
+        constexpr DWORD FrameCount = 10000;
+        constexpr LONGLONG FrameTicks = TestFrequency / 60;
+        constexpr LONGLONG BucketLimits[] = { 10, 50, 100, 500, 1000 };
+        DWORD Buckets[_countof(BucketLimits) + 1] = {};
+
+        FakeClock Clock;
+        Clock.Late = 100;
+        Clock.Jitter = 3000;
+        Utils::FrameLimiter Limiter(Clock);
+        Limiter.SetFrameRate(60.0);
+
+        // Let the spin margin and present time settle first
+        DWORD Seed = 5;
+        auto GetPresentTime = [&]()
+            {
+                Seed = Seed * 214013 + 2531011;
+                return (LONGLONG)(1500 + (Seed >> 8) % 1000);
+            };
+        LONGLONG LastEnd = 0;
+        for (DWORD x = 0; x < 100; x++)
+        {
+            LastEnd = RunFrame(Clock, Limiter, GetPresentTime());
+        }
+
+        Clock.Sleeps = 0;
+        Clock.Spins = 0;
+        Clock.SleptTicks = 0;
+        Clock.SpunTicks = 0;
+        LONGLONG MaxError = 0;
+        for (DWORD x = 0; x < FrameCount; x++)
+        {
+            const LONGLONG End = RunFrame(Clock, Limiter, GetPresentTime());
+            const LONGLONG Error = (End - LastEnd > FrameTicks) ? End - LastEnd - FrameTicks : FrameTicks - (End - LastEnd);
+            LastEnd = End;
+
+            DWORD Bucket = 0;
+            while (Bucket < _countof(BucketLimits) && Error >= BucketLimits[Bucket])
+            {
+                Bucket++;
+            }
+            Buckets[Bucket]++;
+            MaxError = (Error > MaxError) ? Error : MaxError;
+        }
+
+        Logging::Log() << "Benchmark: FrameLimiter " << FrameCount << " frames at 60 FPS, frame time error <10us " << Buckets[0] << ", <50us " << Buckets[1] <<
+            ", <100us " << Buckets[2] << ", <500us " << Buckets[3] << ", <1ms " << Buckets[4] << ", >=1ms " << Buckets[5] << ", max " << MaxError << " us";
+        Logging::Log() << "Benchmark: FrameLimiter per frame " << ((double)Clock.SleptTicks / FrameCount) << " us slept in " << ((double)Clock.Sleeps / FrameCount) <<
+            " sleeps, " << ((double)Clock.SpunTicks / FrameCount) << " us spun in " << ((double)Clock.Spins / FrameCount) << " spins, spin margin " << Limiter.GetSpinMargin() << " us";
+    }
+}
+
+void TestFrameLimiter()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing FrameLimiter";
+    Logging::Log() << "****";
+
+    DWORD TestID = 12500;
+
+    TestSpinMargin(TestID);
+    TestPresentCompensation(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkFrameLimiter();
+    }
+}
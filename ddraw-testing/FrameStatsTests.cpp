@@ -0,0 +1,244 @@
+#include "d3d9\FrameStats.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+
+namespace {
+    // Matches the histogram in FrameStats, ranks are reported as the middle of their bucket
+    constexpr DWORD BucketTime = 50;
+    constexpr DWORD BucketCount = 4000;
+
+    DWORD Seed = 17;
+
+    DWORD GetRandom()
+    {
+        Seed = Seed * 214013 + 2531011;
+        return Seed >> 8;
+    }
+
+    DWORD GetBucketTime(DWORD Time)
+    {
+        return (std::min)(Time / BucketTime, BucketCount - 1) * BucketTime + BucketTime / 2;
+    }
+
+    // Keeps the window the simple way, every frame in a list that is sorted when a rank is needed
+    class ReferenceWindow
+    {
+    private:
+        std::deque<DWORD> Frames;
+        ULONGLONG Sum = 0;
+
+    public:
+        void AddFrame(DWORD Time)
+        {
+            if (Frames.size() == FrameStats::MaxFrames)
+            {
+                Sum -= Frames.front();
+                Frames.pop_front();
+            }
+            Frames.push_back(Time);
+            Sum += Time;
+            while (Frames.size() > 1 && Sum - Frames.front() > FrameStats::WindowTime)
+            {
+                Sum -= Frames.front();
+                Frames.pop_front();
+            }
+        }
+
+        DWORD GetCount() const { return (DWORD)Frames.size(); }
+        ULONGLONG GetSum() const { return Sum; }
+
+        DWORD GetRankTime(double Fraction) const
+        {
+            std::vector<DWORD> Sorted(Frames.begin(), Frames.end());
+            std::sort(Sorted.begin(), Sorted.end());
+            const DWORD Target = (std::max)((DWORD)ceil(Sorted.size() * Fraction), 1u);
+            return GetBucketTime(Sorted[Target - 1]);
+        }
+    };
+
+    bool IsSameFPS(double FPS, DWORD Time)
+    {
+        return fabs(FPS - 1000000.0 / Time) < 0.001;
+    }
+
+    void TestWindowEviction(DWORD& TestID)
+    {
+        std::unique_ptr<FrameStats> Stats(new FrameStats);
+
+        // 10ms frames, a frame is kept while the frames after it add up to at most the window time
+        for (DWORD x = 0; x < 300; x++)
+        {
+            Stats->AddFrame(10000);
+        }
+        LOG_TEST_RESULT(TestID++, "Window keeps one second of frames: ", Stats->GetFrameCount(), 101);
+        LOG_TEST_RESULT(TestID++, "Window average is the frame time: ", (Stats->GetAverageTime() == 10000.0), true);
+        LOG_TEST_RESULT(TestID++, "Window average FPS: ", (Stats->GetAverageFPS() == 100.0), true);
+
+        // A frame longer than the window evicts every other frame but is kept itself
+        Stats->AddFrame(1500000);
+        LOG_TEST_RESULT(TestID++, "Long frame evicts the window: ", Stats->GetFrameCount(), 1);
+        LOG_TEST_RESULT(TestID++, "Long frame is the only frame left: ", (Stats->GetAverageTime() == 1500000.0), true);
+        Stats->AddFrame(10000);
+        LOG_TEST_RESULT(TestID++, "Long frame stays while the frames after it fit the window: ", Stats->GetFrameCount(), 2);
+
+        // Frames too short to fill the window are capped by the frame ring
+        Stats->clear();
+        for (DWORD x = 0; x < FrameStats::MaxFrames + 100; x++)
+        {
+            Stats->AddFrame(x & 1);
+        }
+        LOG_TEST_RESULT(TestID++, "Full frame ring evicts the oldest frame: ", Stats->GetFrameCount(), FrameStats::MaxFrames);
+        LOG_TEST_RESULT(TestID++, "Full frame ring keeps the sum: ", (Stats->GetAverageTime() == 0.5), true);
+
+        Stats->clear();
+        LOG_TEST_RESULT(TestID++, "Cleared window is empty: ", (Stats->GetFrameCount() == 0 && Stats->GetMedianTime() == 0 && Stats->GetAverageFPS() == 0.0), true);
+    }
+
+    void TestRanks(DWORD& TestID)
+    {
+        std::unique_ptr<FrameStats> Stats(new FrameStats);
+        ReferenceWindow Reference;
+
+        // Phases of fast, slow and mixed frames so the window grows and shrinks and every rank
+        // moves up and down across many buckets, including the shared bucket above 200ms
+        const DWORD PhaseBase[] = { 2000, 40000, 6000, 250000, 1000, 16000, 90000, 3000 };
+        const DWORD PhaseSpread[] = { 2000, 30000, 20000, 100000, 500, 4000, 150000, 60000 };
+
+        bool IsMedian = true, IsLow1 = true, IsLow01 = true, IsWindow = true;
+        bool MedianRose = false, MedianFell = false;
+        DWORD LastMedian = 0, Frames = 0;
+        for (DWORD Phase = 0; Phase < _countof(PhaseBase); Phase++)
+        {
+            for (DWORD x = 0; x < 600; x++, Frames++)
+            {
+                // Spikes every so often so the lows sit above the median
+                DWORD Time = PhaseBase[Phase] + GetRandom() % PhaseSpread[Phase];
+                if (GetRandom() % 100 == 0)
+                {
+                    Time *= 4;
+                }
+                Stats->AddFrame(Time);
+                Reference.AddFrame(Time);
+
+                IsWindow = IsWindow && Stats->GetFrameCount() == Reference.GetCount() &&
+                    Stats->GetAverageTime() == (double)Reference.GetSum() / Reference.GetCount();
+                IsMedian = IsMedian && Stats->GetMedianTime() == Reference.GetRankTime(0.5);
+                IsLow1 = IsLow1 && IsSameFPS(Stats->GetLow1FPS(), Reference.GetRankTime(0.99));
+                IsLow01 = IsLow01 && IsSameFPS(Stats->GetLow01FPS(), Reference.GetRankTime(0.999));
+
+                MedianRose = MedianRose || Stats->GetMedianTime() > LastMedian + 10 * BucketTime;
+                MedianFell = MedianFell || Stats->GetMedianTime() + 10 * BucketTime < LastMedian;
+                LastMedian = Stats->GetMedianTime();
+            }
+        }
+        LOG_TEST_RESULT(TestID++, "Window matches the reference after every frame: ", IsWindow, true);
+        LOG_TEST_RESULT(TestID++, "Median matches the sorted reference: ", IsMedian, true);
+        LOG_TEST_RESULT(TestID++, "1% low matches the sorted reference: ", IsLow1, true);
+        LOG_TEST_RESULT(TestID++, "0.1% low matches the sorted reference: ", IsLow01, true);
+        LOG_TEST_RESULT(TestID++, "Median moved up and down: ", (MedianRose && MedianFell), true);
+    }
+
+    void TestStutter(DWORD& TestID)
+    {
+        std::unique_ptr<FrameStats> Stats(new FrameStats);
+
+        // No stutters until there are enough frames for a median
+        bool IsStutter = false;
+        for (DWORD x = 0; x < 8; x++)
+        {
+            IsStutter = Stats->AddFrame((x & 1) ? 100000 : 10000) || IsStutter;
+        }
+        LOG_TEST_RESULT(TestID++, "Short window reports no stutter: ", IsStutter, false);
+
+        // Half the window is 10ms and half 30ms so the median is still 10ms before the next frame,
+        // after adding a 25ms frame the median would be 25ms and the frame would not be twice that
+        Stats->clear();
+        for (DWORD x = 0; x < 4; x++)
+        {
+            Stats->AddFrame(10000);
+            Stats->AddFrame(30000);
+        }
+        LOG_TEST_RESULT(TestID++, "Median before the spike: ", Stats->GetMedianTime(), GetBucketTime(10000));
+        const bool IsSpikeStutter = Stats->AddFrame(25000);
+        LOG_TEST_RESULT(TestID++, "Spike is compared to the median before it: ", IsSpikeStutter, true);
+        LOG_TEST_RESULT(TestID++, "Median after the spike: ", Stats->GetMedianTime(), GetBucketTime(25000));
+
+        // Threshold is twice the median bucket time
+        Stats->clear();
+        for (DWORD x = 0; x < 20; x++)
+        {
+            Stats->AddFrame(10000);
+        }
+        const DWORD Threshold = FrameStats::StutterFactor * GetBucketTime(10000);
+        const bool IsThresholdStutter = Stats->AddFrame(Threshold);
+        const bool IsAboveStutter = Stats->AddFrame(Threshold + 1);
+        LOG_TEST_RESULT(TestID++, "Frame at the threshold is not a stutter: ", IsThresholdStutter, false);
+        LOG_TEST_RESULT(TestID++, "Frame above the threshold is a stutter: ", IsAboveStutter, true);
+        LOG_TEST_RESULT(TestID++, "Stutter is counted in the window: ", Stats->GetWindowStutters(), 1);
+
+        // Stutters leave the window count with their frame but stay in the total
+        for (DWORD x = 0; x < 150; x++)
+        {
+            Stats->AddFrame(10000);
+        }
+        LOG_TEST_RESULT(TestID++, "Evicted stutter leaves the window count: ", Stats->GetWindowStutters(), 0);
+        LOG_TEST_RESULT(TestID++, "Evicted stutter stays in the total: ", Stats->GetTotalStutters(), 1);
+    }
+
+    // Logs the cost of AddFrame over 10M synthetic frame times around 60 FPS with occasional spikes, with the
+    // median and lows read after every frame like the overlay does
+    void BenchmarkFrameStats()
+    {
+        constexpr DWORD FrameCount = 10000000;
+
+        std::vector<DWORD> Times(0x10000);
+        for (DWORD& Time : Times)
+        {
+            Time = 14000 + GetRandom() % 5000;
+            if (GetRandom() % 200 == 0)
+            {
+                Time *= 3;
+            }
+        }
+
+        std::unique_ptr<FrameStats> Stats(new FrameStats);
+        DWORD Frame = 0;
+        volatile double Sum = 0.0;
+        const double AddTime = MeasureNanoseconds(FrameCount, [&]()
+            {
+                Stats->AddFrame(Times[Frame++ & 0xFFFF]);
+            });
+        const double ReadTime = MeasureNanoseconds(FrameCount, [&]()
+            {
+                Stats->AddFrame(Times[Frame++ & 0xFFFF]);
+                Sum = Sum + Stats->GetMedianTime() + Stats->GetLow1FPS() + Stats->GetLow01FPS();
+            });
+
+        Logging::Log() << "Benchmark: FrameStats " << FrameCount << " frames, " << AddTime << " ns per AddFrame, " << ReadTime <<
+            " ns with the ranks read, " << Stats->GetTotalStutters() << " stutters";
+    }
+}
+
+void TestFrameStats()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing FrameStats";
+    Logging::Log() << "****";
+
+    DWORD TestID = 12000;
+
+    TestWindowEviction(TestID);
+    TestRanks(TestID);
+    TestStutter(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkFrameStats();
+    }
+}
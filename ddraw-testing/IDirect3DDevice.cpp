@@ -1,5 +1,7 @@
 #include "ddraw-testing.h"
 #include "testing-harness.h"
+#include <vector>
+#include <cmath>
 
 
 template <typename DDType, typename D3DDType>
@@ -38,6 +40,286 @@ void TestExecuteBuffer(DDType* pDDraw, D3DDType* pDirect3DDevice)
     LOG_TEST_RESULT(TestID, "After ExecuteBuffer release. Direct3DDevice Ref count: ", GetRefCount(pDirect3DDevice), GetResults<DDType>(TestID));
 }
 
+template <typename D3DType, typename D3DDType, typename D3DVType>
+void TestTransformVertices(D3DType* pDirect3D, D3DDType* pDirect3DDevice)
+{
+    D3DVType* pViewport = nullptr;
+    HRESULT hr = pDirect3D->CreateViewport(&pViewport, nullptr);
+
+    // ****  950  ****
+    DWORD TestID = 950;
+    if (FAILED(hr))
+    {
+        LOG_TEST_RESULT(TestID, "Failed to create Viewport. Error: ", (DDERR)hr, TEST_FAILED);
+        return;
+    }
+
+    // Clip volume of -1 to 1 mapped to the whole 640x480 render target
+    D3DVIEWPORT2 vp = {};
+    vp.dwSize = sizeof(vp);
+    vp.dwWidth = 640;
+    vp.dwHeight = 480;
+    vp.dvClipX = -1.0f;
+    vp.dvClipY = 1.0f;
+    vp.dvClipWidth = 2.0f;
+    vp.dvClipHeight = 2.0f;
+    vp.dvMinZ = 0.0f;
+    vp.dvMaxZ = 1.0f;
+
+    hr = pDirect3DDevice->AddViewport(pViewport);
+    if (SUCCEEDED(hr))
+    {
+        hr = pViewport->SetViewport2(&vp);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = pDirect3DDevice->SetCurrentViewport(pViewport);
+    }
+    LOG_TEST_RESULT(TestID, "Viewport added and set. Error: ", (DDERR)hr, (DDERR)DD_OK);
+    if (FAILED(hr))
+    {
+        pDirect3DDevice->DeleteViewport(pViewport);
+        pViewport->Release();
+        return;
+    }
+
+    D3DMATRIX Identity = {};
+    Identity._11 = Identity._22 = Identity._33 = Identity._44 = 1.0f;
+    pDirect3DDevice->SetTransform(D3DTRANSFORMSTATE_WORLD, &Identity);
+    pDirect3DDevice->SetTransform(D3DTRANSFORMSTATE_VIEW, &Identity);
+    pDirect3DDevice->SetTransform(D3DTRANSFORMSTATE_PROJECTION, &Identity);
+
+    // Seven vertices so both four vertex batches and the remaining tail are used, one inside and one past each plane
+    const D3DVALUE Positions[][3] = { { 0.0f, 0.0f, 0.5f }, { 2.0f, 0.0f, 0.5f }, { -2.0f, 0.0f, 0.5f }, { 0.0f, 2.0f, 0.5f }, { 0.0f, -2.0f, 0.5f }, { 0.0f, 0.0f, -0.5f }, { 0.0f, 0.0f, 2.0f } };
+    const DWORD ClipCodes[] = { 0, D3DCLIP_RIGHT, D3DCLIP_LEFT, D3DCLIP_TOP, D3DCLIP_BOTTOM, D3DCLIP_FRONT, D3DCLIP_BACK };
+    constexpr DWORD Count = _countof(Positions);
+    constexpr DWORD ClipFrustum = D3DCLIP_LEFT | D3DCLIP_RIGHT | D3DCLIP_TOP | D3DCLIP_BOTTOM | D3DCLIP_FRONT | D3DCLIP_BACK;
+
+    D3DLVERTEX In[Count] = {};
+    D3DTLVERTEX Out[Count] = {};
+    D3DHVERTEX HOut[Count] = {};
+    for (DWORD x = 0; x < Count; x++)
+    {
+        In[x].x = Positions[x][0];
+        In[x].y = Positions[x][1];
+        In[x].z = Positions[x][2];
+    }
+
+    D3DTRANSFORMDATA td = {};
+    td.dwSize = sizeof(td);
+    td.lpIn = In;
+    td.dwInSize = sizeof(D3DLVERTEX);
+    td.lpOut = Out;
+    td.dwOutSize = sizeof(D3DTLVERTEX);
+    td.lpHOut = HOut;
+
+    DWORD Offscreen = 0xFFFFFFFF;
+    hr = pViewport->TransformVertices(Count, &td, D3DTRANSFORM_CLIPPED, &Offscreen);
+
+    // ****  951  ****
+    TestID = 951;
+    LOG_TEST_RESULT(TestID, "TransformVertices clipped. Error: ", (DDERR)hr, (DDERR)DD_OK);
+
+    // ****  952  ****
+    TestID = 952;
+    LOG_TEST_RESULT(TestID, "TransformVertices clip union has every plane: ", td.dwClipUnion, ClipFrustum);
+
+    // ****  953  ****
+    TestID = 953;
+    LOG_TEST_RESULT(TestID, "TransformVertices clip intersection with an inside vertex: ", td.dwClipIntersection, 0);
+
+    // ****  954  ****
+    TestID = 954;
+    LOG_TEST_RESULT(TestID, "TransformVertices partly visible vertices are not offscreen: ", Offscreen, 0);
+
+    // ****  955  ****
+    TestID = 955;
+    bool IsMatching = true;
+    for (DWORD x = 0; x < Count; x++)
+    {
+        IsMatching = IsMatching && (HOut[x].dwFlags & ClipFrustum) == ClipCodes[x];
+    }
+    LOG_TEST_RESULT(TestID, "TransformVertices clip code of each homogeneous vertex: ", IsMatching, true);
+
+    // ****  956  ****
+    TestID = 956;
+    LOG_TEST_RESULT(TestID, "TransformVertices inside vertex mapped to the viewport center: ",
+        (fabsf(Out[0].sx - 320.0f) < 0.01f && fabsf(Out[0].sy - 240.0f) < 0.01f && fabsf(Out[0].sz - 0.5f) < 0.0001f && fabsf(Out[0].rhw - 1.0f) < 0.0001f), true);
+
+    // Every vertex past the right plane, five so the tail holds one vertex
+    for (DWORD x = 0; x < Count; x++)
+    {
+        In[x].x = 2.0f + x;
+        In[x].y = (x % 2) ? 2.0f : 0.0f;
+    }
+    td.dwClipUnion = td.dwClipIntersection = 0;
+    Offscreen = 0;
+    hr = pViewport->TransformVertices(5, &td, D3DTRANSFORM_CLIPPED, &Offscreen);
+
+    // ****  957  ****
+    TestID = 957;
+    LOG_TEST_RESULT(TestID, "TransformVertices clip intersection with all vertices outside: ", td.dwClipIntersection, (DWORD)D3DCLIP_RIGHT);
+
+    // ****  958  ****
+    TestID = 958;
+    LOG_TEST_RESULT(TestID, "TransformVertices clip union with all vertices outside: ", td.dwClipUnion, (DWORD)(D3DCLIP_RIGHT | D3DCLIP_TOP));
+
+    // ****  959  ****
+    TestID = 959;
+    LOG_TEST_RESULT(TestID, "TransformVertices all vertices outside are offscreen: ", Offscreen, 1);
+
+    // Logs the cost per vertex without and with the clip status and homogeneous output
+    {
+        constexpr DWORD BenchCount = 4096;
+        std::vector<D3DLVERTEX> BenchIn(BenchCount);
+        std::vector<D3DTLVERTEX> BenchOut(BenchCount);
+        std::vector<D3DHVERTEX> BenchHOut(BenchCount);
+        for (DWORD x = 0; x < BenchCount; x++)
+        {
+            BenchIn[x].x = sinf(x * 0.01f) * 1.2f;
+            BenchIn[x].y = cosf(x * 0.013f) * 1.2f;
+            BenchIn[x].z = (x % 100) / 100.0f;
+        }
+        td.lpIn = BenchIn.data();
+        td.lpOut = BenchOut.data();
+
+        td.lpHOut = nullptr;
+        const double UnclippedTime = MeasureNanoseconds(200, [&]()
+            {
+                pViewport->TransformVertices(BenchCount, &td, D3DTRANSFORM_UNCLIPPED, &Offscreen);
+            });
+        td.lpHOut = BenchHOut.data();
+        const double ClippedTime = MeasureNanoseconds(200, [&]()
+            {
+                pViewport->TransformVertices(BenchCount, &td, D3DTRANSFORM_CLIPPED, &Offscreen);
+            });
+
+        Logging::Log() << "Benchmark: TransformVertices unclipped " << (UnclippedTime / BenchCount) << " ns per vertex, clipped " <<
+            (ClippedTime / BenchCount) << " ns per vertex";
+    }
+
+    pDirect3DDevice->DeleteViewport(pViewport);
+    pViewport->Release();
+}
+
+// Source and destination vertex buffers for software vertex processing of Count vertices spread around the view volume
+template <typename D3DType>
+bool CreateProcessVertexBuffers(D3DType* pDirect3D, DWORD Count, IDirect3DVertexBuffer7** ppSrc, IDirect3DVertexBuffer7** ppDest)
+{
+    D3DVERTEXBUFFERDESC Desc = {};
+    Desc.dwSize = sizeof(Desc);
+    Desc.dwCaps = D3DVBCAPS_SYSTEMMEMORY;
+    Desc.dwFVF = D3DFVF_XYZ | D3DFVF_NORMAL;
+    Desc.dwNumVertices = Count;
+    if (FAILED(pDirect3D->CreateVertexBuffer(&Desc, ppSrc, 0)))
+    {
+        return false;
+    }
+
+    Desc.dwFVF = D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_SPECULAR;
+    if (FAILED(pDirect3D->CreateVertexBuffer(&Desc, ppDest, 0)))
+    {
+        (*ppSrc)->Release();
+        return false;
+    }
+
+    // Positions go a little past the view volume so some vertices are clipped
+    D3DVERTEX* pVertices = nullptr;
+    if (FAILED((*ppSrc)->Lock(DDLOCK_WAIT, (LPVOID*)&pVertices, nullptr)))
+    {
+        (*ppSrc)->Release();
+        (*ppDest)->Release();
+        return false;
+    }
+    for (DWORD x = 0; x < Count; x++)
+    {
+        const float Angle = x * 0.01f;
+        pVertices[x].x = sinf(Angle) * 1.2f;
+        pVertices[x].y = cosf(Angle * 1.3f) * 1.2f;
+        pVertices[x].z = (x % 100) / 100.0f;
+        pVertices[x].nx = cosf(Angle);
+        pVertices[x].ny = sinf(Angle);
+        pVertices[x].nz = 0.0f;
+    }
+    (*ppSrc)->Unlock();
+
+    return true;
+}
+
+// Logs the rate of ProcessVertices with transform and lighting for 0, 1, 4 and 8 enabled point lights
+template <typename D3DType>
+void BenchmarkProcessVertices(D3DType* pDirect3D, IDirect3DDevice7* pDevice)
+{
+    constexpr DWORD VertexCount = 4096;
+    constexpr DWORD Count = 50;
+
+    IDirect3DVertexBuffer7* pSrc = nullptr;
+    IDirect3DVertexBuffer7* pDest = nullptr;
+    if (!CreateProcessVertexBuffers(pDirect3D, VertexCount, &pSrc, &pDest))
+    {
+        Logging::Log() << "Benchmark: ProcessVertices skipped, could not create vertex buffers";
+        return;
+    }
+
+    D3DVIEWPORT7 vp = { 0, 0, 640, 480, 0.0f, 1.0f };
+    pDevice->SetViewport(&vp);
+
+    D3DMATRIX Identity = {};
+    Identity._11 = Identity._22 = Identity._33 = Identity._44 = 1.0f;
+    pDevice->SetTransform(D3DTRANSFORMSTATE_WORLD, &Identity);
+    pDevice->SetTransform(D3DTRANSFORMSTATE_VIEW, &Identity);
+    pDevice->SetTransform(D3DTRANSFORMSTATE_PROJECTION, &Identity);
+
+    D3DMATERIAL7 Material = {};
+    Material.dcvDiffuse = { 1.0f, 1.0f, 1.0f, 1.0f };
+    Material.dcvAmbient = { 0.2f, 0.2f, 0.2f, 1.0f };
+    Material.dcvSpecular = { 1.0f, 1.0f, 1.0f, 1.0f };
+    Material.dvPower = 16.0f;
+    pDevice->SetMaterial(&Material);
+    pDevice->SetRenderState(D3DRENDERSTATE_LIGHTING, TRUE);
+    pDevice->SetRenderState(D3DRENDERSTATE_SPECULARENABLE, TRUE);
+
+    // Point lights around the view volume so each one reaches part of the vertices
+    constexpr DWORD MaxLights = 8;
+    for (DWORD x = 0; x < MaxLights; x++)
+    {
+        D3DLIGHT7 Light = {};
+        Light.dltType = D3DLIGHT_POINT;
+        Light.dcvDiffuse = { 0.5f, 0.4f, 0.3f, 1.0f };
+        Light.dcvSpecular = { 0.3f, 0.3f, 0.3f, 1.0f };
+        Light.dvPosition = { cosf(x * 0.785f) * 2.0f, sinf(x * 0.785f) * 2.0f, -1.0f };
+        Light.dvRange = 100.0f;
+        Light.dvAttenuation0 = 1.0f;
+        pDevice->SetLight(x, &Light);
+    }
+
+    for (DWORD LightCount : { 0, 1, 4, 8 })
+    {
+        for (DWORD x = 0; x < MaxLights; x++)
+        {
+            pDevice->LightEnable(x, x < LightCount);
+        }
+
+        HRESULT hr = D3D_OK;
+        const double Time = MeasureNanoseconds(Count, [&]()
+            {
+                hr = pDest->ProcessVertices(D3DVOP_TRANSFORM | D3DVOP_LIGHT, 0, VertexCount, pSrc, 0, pDevice, 0);
+            });
+
+        Logging::Log() << "Benchmark: ProcessVertices " << LightCount << " lights " << (VertexCount * 1000.0 / Time) << " Mvertices/s" <<
+            (FAILED(hr) ? " (failed)" : "");
+    }
+
+    for (DWORD x = 0; x < MaxLights; x++)
+    {
+        pDevice->LightEnable(x, FALSE);
+    }
+    pDevice->SetRenderState(D3DRENDERSTATE_LIGHTING, FALSE);
+
+    pDest->Release();
+    pSrc->Release();
+}
+
 template <typename D3DDType>
 void TestDefaultRenderState(D3DDType* pDevice, const DWORD DefaultValue[], const DWORD Unchangeable[], size_t ArraySize, DWORD DirectXVersion)
 {
@@ -393,6 +675,7 @@ void TestCreate3DDeviceT(DDType* pDDraw, D3DType* pDirect3D)
 
         TestRenderState<IDirect3DDevice2>(pD3DDevice1, UnchangeableRenderTarget, sizeof(UnchangeableRenderTarget) / sizeof(UnchangeableRenderTarget[0]), TRUE, 2);
         TestLightState<IDirect3DDevice2>(pD3DDevice1, TRUE, 7);
+        TestTransformVertices<IDirect3D2, IDirect3DDevice2, IDirect3DViewport2>(pDirect3D, pD3DDevice1);
     }
     else if constexpr (std::is_same_v<D3DType, IDirect3D3>)
     {
@@ -419,6 +702,7 @@ void TestCreate3DDeviceT(DDType* pDDraw, D3DType* pDirect3D)
         TestRenderState<IDirect3DDevice3>(pD3DDevice1, UnchangeableRenderTarget, sizeof(UnchangeableRenderTarget) / sizeof(UnchangeableRenderTarget[0]), TRUE, 3);
         TestTextureStageState<IDirect3DDevice3>(pD3DDevice1, TRUE);
         TestLightState<IDirect3DDevice3>(pD3DDevice1, TRUE, 8);
+        TestTransformVertices<IDirect3D3, IDirect3DDevice3, IDirect3DViewport3>(pDirect3D, pD3DDevice1);
     }
     else if constexpr (std::is_same_v<D3DType, IDirect3D7>)
     {
@@ -441,6 +725,10 @@ void TestCreate3DDeviceT(DDType* pDDraw, D3DType* pDirect3D)
 
         TestRenderState<IDirect3DDevice7>(pD3DDevice1, UnchangeableRenderTargetDX7, sizeof(UnchangeableRenderTargetDX7) / sizeof(UnchangeableRenderTargetDX7[0]), TRUE, 7);
         TestTextureStageState<IDirect3DDevice7>(pD3DDevice1, TRUE);
+        if (RunBenchmarks)
+        {
+            BenchmarkProcessVertices(pDirect3D, pD3DDevice1);
+        }
     }
 
     // ****  803  ****
@@ -0,0 +1,285 @@
+#include "dinput8\MouseDataRing.h"
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <utility>
+
+namespace {
+    constexpr DWORD TestCapacity = 16;
+    constexpr DWORD AxisX = 0;
+    constexpr DWORD AxisY = 4;
+    constexpr DWORD Button0 = 12;
+
+    struct TESTRECORD
+    {
+        DWORD dwOfs;
+        LONG lData;
+        DWORD dwTimeStamp;
+        DWORD dwSequence;
+    };
+
+    typedef MouseDataRing<TESTRECORD> TESTRING;
+
+    struct TESTPOLL
+    {
+        TESTRING Ring;
+        DWORD Sequence = 0;
+        bool Overflow = false;
+
+        TESTPOLL() { Ring.Reserve(TestCapacity); }
+
+        void Push(DWORD Ofs, LONG Data)
+        {
+            if (!Ring.push_back({ Ofs, Data, 0, Sequence++ }))
+            {
+                Overflow = true;
+            }
+        }
+
+        // Same merge as GetMouseDeviceData(), movement on an axis is added to its first record of the poll
+        void Merge(const std::vector<std::pair<DWORD, LONG>>& Input)
+        {
+            MouseMergeLocations MergeLoc;
+            for (const auto& entry : Input)
+            {
+                if (entry.first == AxisX || entry.first == AxisY)
+                {
+                    const int v = (entry.first == AxisX) ? 0 : 1;
+                    DWORD Loc;
+                    if (MergeLoc.Find(v, Loc))
+                    {
+                        Ring[Loc].lData += entry.second;
+                        continue;
+                    }
+                    MergeLoc.Set(v, Ring.size());
+                }
+                if (!Ring.push_back({ entry.first, entry.second, 0, Sequence++ }))
+                {
+                    Overflow = true;
+                    MergeLoc.DropOldest();
+                }
+            }
+        }
+
+        // Same as the DIGDD_PEEK handling in GetMouseDeviceData()
+        std::vector<TESTRECORD> GetData(DWORD Max, bool isPeek)
+        {
+            std::vector<TESTRECORD> Buffer(Max);
+            const DWORD dwOut = min(Ring.size(), Max);
+            Ring.Peek(Buffer.data(), dwOut);
+            if (!isPeek)
+            {
+                Ring.Consume(dwOut);
+            }
+            Buffer.resize(dwOut);
+            return Buffer;
+        }
+    };
+
+    bool IsSequence(const std::vector<TESTRECORD>& Records, DWORD FirstSequence)
+    {
+        for (DWORD x = 0; x < Records.size(); x++)
+        {
+            if (Records[x].dwSequence != FirstSequence + x)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    DWORD CountRecords(const TESTRING& Ring, DWORD Ofs)
+    {
+        DWORD Count = 0;
+        for (DWORD x = 0; x < Ring.size(); x++)
+        {
+            Count += (Ring[x].dwOfs == Ofs) ? 1 : 0;
+        }
+        return Count;
+    }
+
+    void TestWraparound(DWORD& TestID)
+    {
+        TESTPOLL Poll;
+
+        for (DWORD x = 0; x < 12; x++)
+        {
+            Poll.Push(Button0, 1);
+        }
+        Poll.GetData(10, false);
+
+        // Records 10 to 21 now wrap around the end of the storage
+        for (DWORD x = 0; x < 10; x++)
+        {
+            Poll.Push(Button0, 1);
+        }
+        LOG_TEST_RESULT(TestID++, "Wrapped ring size: ", Poll.Ring.size(), 12);
+        LOG_TEST_RESULT(TestID++, "No overflow before the ring is full: ", Poll.Overflow, false);
+
+        std::vector<TESTRECORD> Records = Poll.GetData(5, false);
+        LOG_TEST_RESULT(TestID++, "Partial read count: ", Records.size(), 5);
+        LOG_TEST_RESULT(TestID++, "Partial read returns the oldest records: ", IsSequence(Records, 10), true);
+
+        Records = Poll.GetData(TestCapacity, false);
+        LOG_TEST_RESULT(TestID++, "Read across the wrap count: ", Records.size(), 7);
+        LOG_TEST_RESULT(TestID++, "Read across the wrap keeps the order: ", IsSequence(Records, 15), true);
+        LOG_TEST_RESULT(TestID++, "Ring empty after reading everything: ", Poll.Ring.empty(), true);
+
+        Poll.Ring.Consume(3);
+        LOG_TEST_RESULT(TestID++, "Consume on an empty ring does nothing: ", Poll.Ring.size(), 0);
+    }
+
+    void TestPeek(DWORD& TestID)
+    {
+        TESTPOLL Poll;
+
+        // Start the records near the end of the storage so the peek wraps
+        for (DWORD x = 0; x < 14; x++)
+        {
+            Poll.Push(Button0, 1);
+        }
+        Poll.GetData(14, false);
+        for (DWORD x = 0; x < 6; x++)
+        {
+            Poll.Push(Button0, 1);
+        }
+
+        const std::vector<TESTRECORD> First = Poll.GetData(TestCapacity, true);
+        const std::vector<TESTRECORD> Second = Poll.GetData(TestCapacity, true);
+        LOG_TEST_RESULT(TestID++, "DIGDD_PEEK returns the records: ", (First.size() == 6 && IsSequence(First, 14)), true);
+        LOG_TEST_RESULT(TestID++, "DIGDD_PEEK does not consume: ", Poll.Ring.size(), 6);
+        LOG_TEST_RESULT(TestID++, "Second DIGDD_PEEK returns the same records: ", (Second.size() == 6 && IsSequence(Second, 14)), true);
+
+        const std::vector<TESTRECORD> Read = Poll.GetData(TestCapacity, false);
+        LOG_TEST_RESULT(TestID++, "Read after DIGDD_PEEK returns the same records: ", (Read.size() == 6 && IsSequence(Read, 14)), true);
+        LOG_TEST_RESULT(TestID++, "Read consumes: ", Poll.Ring.size(), 0);
+    }
+
+    void TestOverflow(DWORD& TestID)
+    {
+        TESTPOLL Poll;
+
+        for (DWORD x = 0; x < TestCapacity + 3; x++)
+        {
+            Poll.Push(Button0, 1);
+        }
+        LOG_TEST_RESULT(TestID++, "Full ring reports overflow: ", Poll.Overflow, true);
+        LOG_TEST_RESULT(TestID++, "Full ring keeps its capacity: ", Poll.Ring.size(), TestCapacity);
+        LOG_TEST_RESULT(TestID++, "Oldest records dropped: ", Poll.Ring[0].dwSequence, 3);
+
+        // Growing a wrapped ring keeps the records in order
+        Poll.Ring.Reserve(TestCapacity * 2);
+        Poll.Overflow = false;
+        for (DWORD x = 0; x < TestCapacity; x++)
+        {
+            Poll.Push(Button0, 1);
+        }
+        LOG_TEST_RESULT(TestID++, "Grown ring has room: ", Poll.Overflow, false);
+        LOG_TEST_RESULT(TestID++, "Grown ring keeps the order: ", IsSequence(Poll.GetData(TestCapacity * 2, false), 3), true);
+    }
+
+    void TestMergeShift(DWORD& TestID)
+    {
+        // Movement record moves down one slot when the oldest record is dropped
+        {
+            TESTPOLL Poll;
+            for (DWORD x = 0; x < TestCapacity - 2; x++)
+            {
+                Poll.Push(Button0, 0x80);
+            }
+            Poll.Merge({ { AxisX, 1 }, { Button0, 0 }, { Button0, 0x80 }, { AxisX, 2 }, { AxisY, 7 }, { AxisX, 4 } });
+
+            DWORD Loc = 0;
+            while (Loc < Poll.Ring.size() && Poll.Ring[Loc].dwOfs != AxisX)
+            {
+                Loc++;
+            }
+            LOG_TEST_RESULT(TestID++, "Merge after drop reports overflow: ", Poll.Overflow, true);
+            LOG_TEST_RESULT(TestID++, "One X record after drop: ", CountRecords(Poll.Ring, AxisX), 1);
+            LOG_TEST_RESULT(TestID++, "X movement merged into the shifted record: ", (Loc < Poll.Ring.size() ? Poll.Ring[Loc].lData : 0), 7);
+            LOG_TEST_RESULT(TestID++, "Button records not changed by the merge: ", (Poll.Ring[Poll.Ring.size() - 2].lData == 0x80 && Poll.Ring[Poll.Ring.size() - 3].lData == 0), true);
+        }
+
+        // Movement record dropped, later movement starts a new record
+        {
+            TESTPOLL Poll;
+            std::vector<std::pair<DWORD, LONG>> Input = { { AxisX, 1 } };
+            for (DWORD x = 0; x < TestCapacity; x++)
+            {
+                Input.push_back({ Button0, 0x80 });
+            }
+            Input.push_back({ AxisX, 5 });
+            Poll.Merge(Input);
+
+            LOG_TEST_RESULT(TestID++, "Dropped X record replaced by a new one: ", CountRecords(Poll.Ring, AxisX), 1);
+            LOG_TEST_RESULT(TestID++, "New X record holds only the later movement: ", Poll.Ring[Poll.Ring.size() - 1].lData, 5);
+            LOG_TEST_RESULT(TestID++, "Oldest button record not changed: ", Poll.Ring[0].lData, 0x80);
+        }
+    }
+
+    // Logs the cost per poll of an 8 kHz mouse read at 60 Hz, about 133 X and Y reports and a button change
+    // merged per poll, then read back with a DIGDD_PEEK and a full read like most games do. Unmerged pushes every
+    // report and overflows the ring
+    void BenchmarkMouseDataRing()
+    {
+        constexpr DWORD ReportsPerPoll = 8000 / 60;
+        constexpr DWORD PollCount = 10000;
+
+        std::vector<std::pair<DWORD, LONG>> Input;
+        for (DWORD x = 0; x < ReportsPerPoll; x++)
+        {
+            Input.push_back({ AxisX, (LONG)(x % 3) - 1 });
+            Input.push_back({ AxisY, 1 });
+            if (x == ReportsPerPoll / 2)
+            {
+                Input.push_back({ Button0, 0x80 });
+            }
+        }
+
+        TESTPOLL Poll;
+        Poll.Ring.Reserve(256);
+        std::vector<TESTRECORD> Buffer(256);
+        volatile DWORD ReadCount = 0;
+        const double MergeTime = MeasureNanoseconds(PollCount, [&]()
+            {
+                Poll.Merge(Input);
+                ReadCount = Poll.Ring.Peek(Buffer.data(), (DWORD)Buffer.size());
+                Poll.Ring.Peek(Buffer.data(), ReadCount);
+                Poll.Ring.Consume(ReadCount);
+            });
+        const DWORD MergedCount = ReadCount;
+
+        const double PushTime = MeasureNanoseconds(PollCount, [&]()
+            {
+                for (const auto& entry : Input)
+                {
+                    Poll.Push(entry.first, entry.second);
+                }
+                ReadCount = Poll.Ring.Peek(Buffer.data(), (DWORD)Buffer.size());
+                Poll.Ring.Peek(Buffer.data(), ReadCount);
+                Poll.Ring.Consume(ReadCount);
+            });
+
+        Logging::Log() << "Benchmark: MouseDataRing " << Input.size() << " reports per poll, merged " << MergeTime << " ns for " << MergedCount <<
+            " records, unmerged " << PushTime << " ns for " << ReadCount << " records per poll";
+    }
+}
+
+void TestMouseDataRing()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing MouseDataRing";
+    Logging::Log() << "****";
+
+    DWORD TestID = 7000;
+
+    TestWraparound(TestID);
+    TestPeek(TestID);
+    TestOverflow(TestID);
+    TestMergeShift(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkMouseDataRing();
+    }
+}
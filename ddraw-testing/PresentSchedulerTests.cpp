@@ -0,0 +1,259 @@
+#include "ddraw\PresentScheduler.h"
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <algorithm>
+
+namespace {
+    constexpr LONG ProducerCount = 4;
+    constexpr LONG PostsPerProducer = 2000;
+    constexpr DWORD TestTimeoutMS = 10000;
+
+    struct CONSUMERDATA
+    {
+        PresentScheduler* Scheduler = nullptr;
+        volatile LONG Consumed = 0;
+        volatile LONG Presents = 0;
+    };
+
+    // Same loop as the present thread without the locks
+    DWORD WINAPI ConsumerThread(LPVOID lpParam)
+    {
+        CONSUMERDATA& Data = *reinterpret_cast<CONSUMERDATA*>(lpParam);
+        while (Data.Scheduler->WaitForFrame())
+        {
+            const LONG Count = Data.Scheduler->Consume();
+            InterlockedExchangeAdd(&Data.Consumed, Count);
+            InterlockedIncrement(&Data.Presents);
+        }
+        return 0;
+    }
+
+    DWORD WINAPI ProducerThread(LPVOID lpParam)
+    {
+        PresentScheduler& Scheduler = *reinterpret_cast<PresentScheduler*>(lpParam);
+        for (LONG x = 0; x < PostsPerProducer; x++)
+        {
+            Scheduler.Post();
+            if ((x & 63) == 0)
+            {
+                Sleep(0);
+            }
+        }
+        return 0;
+    }
+
+    struct LOCKWAITDATA
+    {
+        PresentScheduler* Scheduler = nullptr;
+        CRITICAL_SECTION* Lock = nullptr;
+        HANDLE ReadyEvent = nullptr;    // Set once the frame is taken, Stop() then always finds it waiting for the lock
+        volatile LONG SawExiting = FALSE;
+        volatile LONG Deleted = FALSE;
+    };
+
+    // Same handoff as the present thread blocked on the ddraw lock
+    DWORD WINAPI LockWaitThread(LPVOID lpParam)
+    {
+        LOCKWAITDATA& Data = *reinterpret_cast<LOCKWAITDATA*>(lpParam);
+        PresentScheduler& Scheduler = *Data.Scheduler;
+
+        if (Scheduler.WaitForFrame())
+        {
+            SetEvent(Data.ReadyEvent);
+            Scheduler.BeginLockWait();
+            EnterCriticalSection(Data.Lock);
+            Scheduler.EndLockWait();
+            InterlockedExchange(&Data.SawExiting, Scheduler.IsExiting());
+            LeaveCriticalSection(Data.Lock);
+        }
+
+        if (Scheduler.IsDetached())
+        {
+            delete &Scheduler;
+            InterlockedExchange(&Data.Deleted, TRUE);
+        }
+        return 0;
+    }
+
+    struct LATENCYDATA
+    {
+        PresentScheduler* Scheduler = nullptr;
+        volatile LONGLONG PostTime = 0;
+        std::vector<LONGLONG> Latencies;    // Only written by the consumer
+    };
+
+    // Same loop as the present thread, timing each wake from the last post
+    DWORD WINAPI LatencyConsumerThread(LPVOID lpParam)
+    {
+        LATENCYDATA& Data = *reinterpret_cast<LATENCYDATA*>(lpParam);
+        while (Data.Scheduler->WaitForFrame())
+        {
+            LARGE_INTEGER Now;
+            QueryPerformanceCounter(&Now);
+            Data.Latencies.push_back(Now.QuadPart - Data.PostTime);
+            Data.Scheduler->Consume();
+        }
+        return 0;
+    }
+
+    ULONGLONG GetThreadCPUTime(HANDLE hThread)
+    {
+        FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+        if (!GetThreadTimes(hThread, &CreationTime, &ExitTime, &KernelTime, &UserTime))
+        {
+            return 0;
+        }
+        return (((ULONGLONG)KernelTime.dwHighDateTime << 32) | KernelTime.dwLowDateTime) +
+            (((ULONGLONG)UserTime.dwHighDateTime << 32) | UserTime.dwLowDateTime);
+    }
+
+    // Logs the wake to present latency percentiles and the consumer CPU time for a producer that sleeps
+    // between posts, the consumer should use next to no CPU while it waits
+    void BenchmarkPresentScheduler()
+    {
+        constexpr DWORD FrameCount = 200;
+
+        PresentScheduler Scheduler;
+        LATENCYDATA Data;
+        Data.Scheduler = &Scheduler;
+        Data.Latencies.reserve(FrameCount);
+
+        HANDLE hConsumer = CreateThread(nullptr, 0, LatencyConsumerThread, &Data, 0, nullptr);
+        for (DWORD x = 0; x < FrameCount; x++)
+        {
+            Sleep(2);
+            LARGE_INTEGER Now;
+            QueryPerformanceCounter(&Now);
+            Data.PostTime = Now.QuadPart;
+            Scheduler.Post();
+        }
+        Sleep(10);
+
+        Scheduler.Stop(hConsumer);
+        const ULONGLONG CPUTime = GetThreadCPUTime(hConsumer);
+        CloseHandle(hConsumer);
+
+        if (Data.Latencies.empty())
+        {
+            Logging::Log() << "Benchmark: PresentScheduler consumer never woke";
+            return;
+        }
+
+        LARGE_INTEGER Frequency;
+        QueryPerformanceFrequency(&Frequency);
+        std::sort(Data.Latencies.begin(), Data.Latencies.end());
+        auto GetPercentile = [&](double Fraction)
+            {
+                const size_t Index = (std::min)((size_t)(Data.Latencies.size() * Fraction), Data.Latencies.size() - 1);
+                return (double)Data.Latencies[Index] * 1000000.0 / (double)Frequency.QuadPart;
+            };
+
+        Logging::Log() << "Benchmark: PresentScheduler " << FrameCount << " posts, " << Data.Latencies.size() << " wakes, latency p50 " << GetPercentile(0.5) <<
+            " us, p99 " << GetPercentile(0.99) << " us, max " << GetPercentile(1.0) << " us, consumer CPU " << (CPUTime / 10) << " us total, " <<
+            ((double)CPUTime / 10.0 / Data.Latencies.size()) << " us per wake";
+    }
+
+    void TestMergedTokens(DWORD& TestID)
+    {
+        PresentScheduler Scheduler;
+        LOG_TEST_RESULT(TestID++, "Scheduler created: ", Scheduler.IsCreated(), true);
+
+        Scheduler.Post();
+        Scheduler.Post();
+        Scheduler.Post();
+        const bool IsFrameFound = Scheduler.WaitForFrame();
+        const LONG Merged = Scheduler.Consume();
+        const LONG Left = Scheduler.Consume();
+        LOG_TEST_RESULT(TestID++, "Posted frame found without waiting: ", IsFrameFound, true);
+        LOG_TEST_RESULT(TestID++, "Posts merged into one present: ", Merged, 3);
+        LOG_TEST_RESULT(TestID++, "Nothing left after consume: ", Left, 0);
+    }
+
+    void TestProducerConsumer(DWORD& TestID)
+    {
+        PresentScheduler Scheduler;
+        CONSUMERDATA Data;
+        Data.Scheduler = &Scheduler;
+
+        HANDLE hConsumer = CreateThread(nullptr, 0, ConsumerThread, &Data, 0, nullptr);
+        HANDLE hProducers[ProducerCount] = {};
+        for (LONG x = 0; x < ProducerCount; x++)
+        {
+            hProducers[x] = CreateThread(nullptr, 0, ProducerThread, &Scheduler, 0, nullptr);
+        }
+        WaitForMultipleObjects(ProducerCount, hProducers, TRUE, TestTimeoutMS);
+
+        // The consumer must wake for the last post even if it raced with its wait
+        const LONG Expected = ProducerCount * PostsPerProducer;
+        const DWORD StartTime = GetTickCount();
+        while (InterlockedCompareExchange(&Data.Consumed, 0, 0) != Expected && GetTickCount() - StartTime < TestTimeoutMS)
+        {
+            Sleep(1);
+        }
+
+        const LONG Presents = InterlockedCompareExchange(&Data.Presents, 0, 0);
+        LOG_TEST_RESULT(TestID++, "Every posted token consumed: ", Data.Consumed, Expected);
+        LOG_TEST_RESULT(TestID++, "No more presents than posts: ", (Presents >= 1 && Presents <= Expected), true);
+
+        const bool IsJoined = Scheduler.Stop(hConsumer);
+        LOG_TEST_RESULT(TestID++, "Stop joins a waiting consumer: ", IsJoined, true);
+        LOG_TEST_RESULT(TestID++, "Consumer exited: ", WaitForSingleObject(hConsumer, 0), WAIT_OBJECT_0);
+        LOG_TEST_RESULT(TestID++, "Not detached: ", Scheduler.IsDetached(), false);
+
+        for (LONG x = 0; x < ProducerCount; x++)
+        {
+            CloseHandle(hProducers[x]);
+        }
+        CloseHandle(hConsumer);
+    }
+
+    void TestDetachedStop(DWORD& TestID)
+    {
+        CRITICAL_SECTION Lock;
+        InitializeCriticalSection(&Lock);
+
+        LOCKWAITDATA Data;
+        Data.Scheduler = new PresentScheduler();
+        Data.Lock = &Lock;
+        Data.ReadyEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+        // Held across Stop() like ReleaseInterface() holds the ddraw lock
+        EnterCriticalSection(&Lock);
+
+        Data.Scheduler->Post();
+        HANDLE hThread = CreateThread(nullptr, 0, LockWaitThread, &Data, 0, nullptr);
+        WaitForSingleObject(Data.ReadyEvent, TestTimeoutMS);
+
+        const bool Stopped = Data.Scheduler->Stop(hThread);
+        LOG_TEST_RESULT(TestID++, "Stop detaches a consumer waiting for the lock: ", Stopped, false);
+
+        LeaveCriticalSection(&Lock);
+        WaitForSingleObject(hThread, TestTimeoutMS);
+
+        LOG_TEST_RESULT(TestID++, "Consumer sees the exit flag after the lock: ", Data.SawExiting, TRUE);
+        LOG_TEST_RESULT(TestID++, "Detached scheduler deleted by the consumer: ", Data.Deleted, TRUE);
+
+        CloseHandle(hThread);
+        CloseHandle(Data.ReadyEvent);
+        DeleteCriticalSection(&Lock);
+    }
+}
+
+void TestPresentScheduler()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing PresentScheduler";
+    Logging::Log() << "****";
+
+    DWORD TestID = 7500;
+
+    TestMergedTokens(TestID);
+    TestProducerConsumer(TestID);
+    TestDetachedStop(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkPresentScheduler();
+    }
+}
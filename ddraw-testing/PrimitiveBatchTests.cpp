@@ -0,0 +1,240 @@
+#include "ddraw\PrimitiveBatch.h"
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <string>
+
+namespace {
+    constexpr DWORD TestFVF = D3DFVF_XYZ | D3DFVF_DIFFUSE;
+
+    struct TESTVERTEX
+    {
+        float x, y, z;
+        DWORD color;
+    };
+
+    std::vector<TESTVERTEX> MakeVertices(DWORD Count, DWORD FirstColor)
+    {
+        std::vector<TESTVERTEX> Vertices(Count);
+        for (DWORD x = 0; x < Count; x++)
+        {
+            Vertices[x] = { (float)x, (float)x, 0.0f, FirstColor + x };
+        }
+        return Vertices;
+    }
+
+    void CheckIndices(DWORD& TestID, const std::string& Name, D3DPRIMITIVETYPE PrimitiveType, const std::vector<WORD>& Indices, DWORD Count, DWORD BaseVertex, const std::vector<WORD>& Expected)
+    {
+        std::vector<WORD> Output;
+        const DWORD Added = AppendBatchIndices(Output, PrimitiveType, Indices.empty() ? nullptr : Indices.data(), Count, BaseVertex);
+
+        LOG_TEST_RESULT(TestID++, Name << " index count: ", Added, Expected.size());
+        LOG_TEST_RESULT(TestID++, Name << " indices match: ", (Output == Expected), true);
+    }
+
+    void TestPrimitiveTypes(DWORD& TestID)
+    {
+        LOG_TEST_RESULT(TestID++, "POINTLIST batched as: ", GetBatchPrimitiveType(D3DPT_POINTLIST), D3DPT_POINTLIST);
+        LOG_TEST_RESULT(TestID++, "LINESTRIP batched as: ", GetBatchPrimitiveType(D3DPT_LINESTRIP), D3DPT_LINELIST);
+        LOG_TEST_RESULT(TestID++, "TRIANGLESTRIP batched as: ", GetBatchPrimitiveType(D3DPT_TRIANGLESTRIP), D3DPT_TRIANGLELIST);
+        LOG_TEST_RESULT(TestID++, "TRIANGLEFAN batched as: ", GetBatchPrimitiveType(D3DPT_TRIANGLEFAN), D3DPT_TRIANGLELIST);
+        LOG_TEST_RESULT(TestID++, "Unknown type not batched: ", GetBatchPrimitiveType((D3DPRIMITIVETYPE)7), 0);
+    }
+
+    void TestIndexConversion(DWORD& TestID)
+    {
+        // Odd strip triangles are drawn as (n + 1, n, n + 2), rotated here to keep vertex n first for flat shading
+        CheckIndices(TestID, "TRIANGLESTRIP", D3DPT_TRIANGLESTRIP, {}, 5, 0, { 0, 1, 2, 1, 3, 2, 2, 3, 4 });
+
+        // Fan triangles keep the vertex after the center first for flat shading
+        CheckIndices(TestID, "TRIANGLEFAN", D3DPT_TRIANGLEFAN, {}, 5, 0, { 1, 2, 0, 2, 3, 0, 3, 4, 0 });
+
+        CheckIndices(TestID, "Indexed TRIANGLESTRIP", D3DPT_TRIANGLESTRIP, { 10, 11, 12, 13 }, 4, 4, { 14, 15, 16, 15, 17, 16 });
+        CheckIndices(TestID, "Indexed TRIANGLEFAN", D3DPT_TRIANGLEFAN, { 7, 2, 5, 9 }, 4, 100, { 102, 105, 107, 105, 109, 107 });
+        CheckIndices(TestID, "LINESTRIP", D3DPT_LINESTRIP, {}, 4, 2, { 2, 3, 3, 4, 4, 5 });
+        CheckIndices(TestID, "Incomplete TRIANGLELIST", D3DPT_TRIANGLELIST, {}, 7, 0, { 0, 1, 2, 3, 4, 5 });
+        CheckIndices(TestID, "Degenerate TRIANGLESTRIP", D3DPT_TRIANGLESTRIP, {}, 2, 0, {});
+        CheckIndices(TestID, "Degenerate TRIANGLEFAN", D3DPT_TRIANGLEFAN, { 0, 1 }, 2, 0, {});
+    }
+
+    void TestMerging(DWORD& TestID)
+    {
+        PRIMITIVEBATCH Batch;
+
+        const std::vector<TESTVERTEX> Strip = MakeVertices(4, 0);
+        const std::vector<TESTVERTEX> Fan = MakeVertices(4, 100);
+
+        Batch.Append(D3DPT_TRIANGLESTRIP, TestFVF, Strip.data(), 4, sizeof(TESTVERTEX), nullptr, 0, 0, 7);
+        LOG_TEST_RESULT(TestID++, "Strip and fan merge: ", Batch.CanMerge(D3DPT_TRIANGLEFAN, TestFVF, 4, 0, 7), true);
+        Batch.Append(D3DPT_TRIANGLEFAN, TestFVF, Fan.data(), 4, sizeof(TESTVERTEX), nullptr, 0, 0, 7);
+
+        const std::vector<WORD> Expected = { 0, 1, 2, 1, 3, 2, 5, 6, 4, 6, 7, 4 };
+        LOG_TEST_RESULT(TestID++, "Merged draw count: ", Batch.DrawCount, 2);
+        LOG_TEST_RESULT(TestID++, "Merged vertex count: ", Batch.VertexCount, 8);
+        LOG_TEST_RESULT(TestID++, "Merged primitive type: ", Batch.PrimitiveType, D3DPT_TRIANGLELIST);
+        LOG_TEST_RESULT(TestID++, "Second draw indices offset by the first: ", (Batch.Indices == Expected), true);
+
+        std::vector<TESTVERTEX> Joined(Strip);
+        Joined.insert(Joined.end(), Fan.begin(), Fan.end());
+        LOG_TEST_RESULT(TestID++, "Vertices appended in draw order: ", (Batch.Vertices.size() == Joined.size() * sizeof(TESTVERTEX) &&
+            memcmp(Batch.Vertices.data(), Joined.data(), Batch.Vertices.size()) == 0), true);
+
+        LOG_TEST_RESULT(TestID++, "Line after triangles breaks the batch: ", Batch.CanMerge(D3DPT_LINELIST, TestFVF, 4, 0, 7), false);
+        LOG_TEST_RESULT(TestID++, "Different FVF breaks the batch: ", Batch.CanMerge(D3DPT_TRIANGLELIST, D3DFVF_XYZRHW, 3, 0, 7), false);
+        LOG_TEST_RESULT(TestID++, "Different flags break the batch: ", Batch.CanMerge(D3DPT_TRIANGLELIST, TestFVF, 3, D3DDP_DONOTCLIP, 7), false);
+        LOG_TEST_RESULT(TestID++, "Different DirectX version breaks the batch: ", Batch.CanMerge(D3DPT_TRIANGLELIST, TestFVF, 3, 0, 3), false);
+        LOG_TEST_RESULT(TestID++, "Oversized draw breaks the batch: ", Batch.CanMerge(D3DPT_TRIANGLELIST, TestFVF, PRIMITIVEBATCH::MaxDrawVertices + 1, 0, 7), false);
+
+        Batch.clear();
+        LOG_TEST_RESULT(TestID++, "Cleared batch draw count: ", Batch.DrawCount, 0);
+        LOG_TEST_RESULT(TestID++, "Cleared batch indices: ", Batch.Indices.size(), 0);
+        LOG_TEST_RESULT(TestID++, "Empty batch accepts any batchable draw: ", Batch.CanMerge(D3DPT_LINESTRIP, D3DFVF_XYZRHW, 2, D3DDP_DONOTCLIP, 3), true);
+        LOG_TEST_RESULT(TestID++, "Empty batch rejects oversized draw: ", Batch.CanMerge(D3DPT_TRIANGLELIST, TestFVF, PRIMITIVEBATCH::MaxDrawVertices + 1, 0, 7), false);
+        LOG_TEST_RESULT(TestID++, "Empty batch rejects unknown type: ", Batch.CanMerge((D3DPRIMITIVETYPE)7, TestFVF, 3, 0, 7), false);
+    }
+
+    void TestVertexLimit(DWORD& TestID)
+    {
+        PRIMITIVEBATCH Batch;
+
+        const DWORD DrawVertices = PRIMITIVEBATCH::MaxDrawVertices;
+        const std::vector<TESTVERTEX> Vertices = MakeVertices(DrawVertices, 0);
+
+        bool AllMerged = true;
+        for (DWORD x = 0; x < PRIMITIVEBATCH::MaxVertices / DrawVertices; x++)
+        {
+            AllMerged = AllMerged && Batch.CanMerge(D3DPT_POINTLIST, TestFVF, DrawVertices, 0, 7);
+            Batch.Append(D3DPT_POINTLIST, TestFVF, Vertices.data(), DrawVertices, sizeof(TESTVERTEX), nullptr, 0, 0, 7);
+        }
+
+        LOG_TEST_RESULT(TestID++, "Draws merged up to the vertex limit: ", AllMerged, true);
+        LOG_TEST_RESULT(TestID++, "Vertex count at the limit: ", Batch.VertexCount, PRIMITIVEBATCH::MaxVertices);
+        LOG_TEST_RESULT(TestID++, "Last index fits in 16 bits: ", Batch.Indices.back(), PRIMITIVEBATCH::MaxVertices - 1);
+        LOG_TEST_RESULT(TestID++, "Vertex overflow breaks the batch: ", Batch.CanMerge(D3DPT_POINTLIST, TestFVF, 1, 0, 7), false);
+    }
+
+    // Follows the device: draws that cannot merge and state changes draw the queued primitives first
+    struct BATCHINGDEVICE
+    {
+        PRIMITIVEBATCH Batch;
+        DWORD RenderState = 0;
+        std::vector<DWORD> Flushes;     // Draw count of each flushed batch
+
+        void Flush()
+        {
+            if (Batch.DrawCount)
+            {
+                Flushes.push_back(Batch.DrawCount);
+                Batch.clear();
+            }
+        }
+
+        void Draw(D3DPRIMITIVETYPE PrimitiveType, const std::vector<TESTVERTEX>& Vertices)
+        {
+            if (Batch.DrawCount && !Batch.CanMerge(PrimitiveType, TestFVF, (DWORD)Vertices.size(), 0, 7))
+            {
+                Flush();
+            }
+            Batch.Append(PrimitiveType, TestFVF, Vertices.data(), (DWORD)Vertices.size(), sizeof(TESTVERTEX), nullptr, 0, 0, 7);
+        }
+
+        void SetRenderState(DWORD Value)
+        {
+            if (Batch.IsStateChange(RenderState, Value))
+            {
+                Flush();
+            }
+            RenderState = Value;
+        }
+    };
+
+    void TestStateChanges(DWORD& TestID)
+    {
+        const std::vector<TESTVERTEX> Vertices = MakeVertices(3, 0);
+
+        BATCHINGDEVICE Device;
+
+        Device.SetRenderState(1);
+        LOG_TEST_RESULT(TestID++, "State change with no queued draws does not flush: ", Device.Flushes.size(), 0);
+
+        Device.Draw(D3DPT_TRIANGLELIST, Vertices);
+        Device.SetRenderState(1);
+        Device.Draw(D3DPT_TRIANGLELIST, Vertices);
+        LOG_TEST_RESULT(TestID++, "Setting the same value keeps draws merged: ", Device.Batch.DrawCount, 2);
+        LOG_TEST_RESULT(TestID++, "Setting the same value does not flush: ", Device.Flushes.size(), 0);
+
+        Device.SetRenderState(2);
+        LOG_TEST_RESULT(TestID++, "Render state change between draws flushes: ", Device.Flushes.size(), 1);
+        LOG_TEST_RESULT(TestID++, "Flushed batch holds the draws before the change: ", Device.Flushes.back(), 2);
+        LOG_TEST_RESULT(TestID++, "Batch empty after the state change: ", Device.Batch.DrawCount, 0);
+
+        Device.Draw(D3DPT_TRIANGLESTRIP, Vertices);
+        Device.Draw(D3DPT_LINESTRIP, Vertices);
+        LOG_TEST_RESULT(TestID++, "Type change flushes the draw before it: ", Device.Flushes.size(), 2);
+        LOG_TEST_RESULT(TestID++, "Draw after the state change starts a new batch: ", Device.Flushes.back(), 1);
+
+        Device.Flush();
+        LOG_TEST_RESULT(TestID++, "Total batches drawn: ", Device.Flushes.size(), 3);
+    }
+
+    // Logs the submitted to issued draw ratio of a synthetic frame of 1,000 small strips, fans and line strips
+    // with a render state change every few draws, and the batching cost per submitted draw
+    void BenchmarkPrimitiveBatch()
+    {
+        constexpr DWORD DrawsPerFrame = 1000;
+        constexpr DWORD Count = 100;
+
+        const std::vector<TESTVERTEX> Vertices[] = { MakeVertices(4, 0), MakeVertices(6, 0), MakeVertices(8, 0) };
+        const D3DPRIMITIVETYPE Types[] = { D3DPT_TRIANGLESTRIP, D3DPT_TRIANGLEFAN, D3DPT_TRIANGLELIST, D3DPT_LINESTRIP };
+
+        // Mostly triangles, a line strip now and then and a state change every 1 to 32 draws
+        struct DRAW { D3DPRIMITIVETYPE PrimitiveType; DWORD VertexIndex; DWORD RenderState; };
+        std::vector<DRAW> Stream;
+        DWORD Seed = 1, RenderState = 0;
+        for (DWORD x = 0; x < DrawsPerFrame; x++)
+        {
+            Seed = Seed * 1664525 + 1013904223;
+            RenderState = ((Seed >> 8) & 31) ? RenderState : RenderState + 1;
+            const DWORD TypeIndex = ((Seed >> 16) & 15) ? ((Seed >> 20) % 3) : 3;
+            Stream.push_back({ Types[TypeIndex], (Seed >> 24) % 3, RenderState });
+        }
+
+        BATCHINGDEVICE Device;
+        auto Frame = [&]()
+            {
+                Device.Flushes.clear();
+                for (const DRAW& Draw : Stream)
+                {
+                    Device.SetRenderState(Draw.RenderState);
+                    Device.Draw(Draw.PrimitiveType, Vertices[Draw.VertexIndex]);
+                }
+                Device.Flush();
+            };
+
+        const double FrameTime = MeasureNanoseconds(Count, Frame);
+
+        const size_t Issued = Device.Flushes.size();
+        Logging::Log() << "Benchmark: PrimitiveBatch " << DrawsPerFrame << " draws submitted, " << Issued << " issued, ratio " <<
+            ((double)DrawsPerFrame / Issued) << ", " << (FrameTime / DrawsPerFrame) << " ns per submitted draw";
+    }
+}
+
+void TestPrimitiveBatch()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing PrimitiveBatch";
+    Logging::Log() << "****";
+
+    DWORD TestID = 6000;
+
+    TestPrimitiveTypes(TestID);
+    TestIndexConversion(TestID);
+    TestMerging(TestID);
+    TestVertexLimit(TestID);
+    TestStateChanges(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkPrimitiveBatch();
+    }
+}
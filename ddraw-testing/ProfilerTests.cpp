@@ -0,0 +1,219 @@
+#include "ddraw\Profiler.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+namespace {
+    // Largest amount a percentile can be above the real value, the bucket width is 1/8 of its base
+    constexpr double MaxBucketError = 0.125;
+
+    DWORD Seed = 11;
+
+    DWORD GetRandom()
+    {
+        Seed = Seed * 214013 + 2531011;
+        return Seed >> 8;
+    }
+
+    // Call times spread over many powers of two, from a few ns to about a second
+    ULONGLONG GetRandomTime()
+    {
+        const UINT Shift = GetRandom() % 30;
+        return ((ULONGLONG)GetRandom() << 8 | GetRandom() % 256) >> (32 - Shift);
+    }
+
+    bool IsWithinBucket(ULONGLONG Value, ULONGLONG Expected)
+    {
+        return Value >= Expected && (double)(Value - Expected) <= (double)Expected * MaxBucketError;
+    }
+
+    // Same rank GetPercentile looks for, the value at that rank in sorted order
+    ULONGLONG GetReferencePercentile(const std::vector<ULONGLONG>& Sorted, double Percentile)
+    {
+        const DWORD Target = (DWORD)(Sorted.size() * Percentile / 100.0 + 0.5);
+        return Target ? Sorted[Target - 1] : 0;
+    }
+
+    void TestBucketAccuracy(DWORD& TestID)
+    {
+        std::unique_ptr<ProfileHistogram> Histogram(new ProfileHistogram);
+
+        // With a larger value recorded the median is the upper bound of the smaller value's bucket
+        constexpr ULONGLONG LargeValue = 1ULL << 50;
+        bool IsExact = true, IsBounded = true, IsInclusive = true, IsTight = true;
+        double WorstError = 0.0;
+        for (ULONGLONG Value = 0; Value < (1ULL << 40); Value = Value * 17 / 16 + 1)
+        {
+            Histogram->clear();
+            Histogram->Record(Value);
+            Histogram->Record(LargeValue);
+            const ULONGLONG Bucket = Histogram->GetPercentile(50.0);
+            if (Value < 16)
+            {
+                IsExact = IsExact && Bucket == Value;
+            }
+            IsBounded = IsBounded && IsWithinBucket(Bucket, Value);
+            WorstError = (std::max)(WorstError, Value ? (double)(Bucket - Value) / Value : 0.0);
+
+            // The upper bound itself is in the bucket and the value right after it starts the next bucket
+            Histogram->clear();
+            Histogram->Record(Bucket);
+            Histogram->Record(LargeValue);
+            IsInclusive = IsInclusive && Histogram->GetPercentile(50.0) == Bucket;
+
+            Histogram->clear();
+            Histogram->Record(Bucket + 1);
+            Histogram->Record(LargeValue);
+            IsTight = IsTight && Histogram->GetPercentile(50.0) > Bucket;
+        }
+        LOG_TEST_RESULT(TestID++, "Values below 16 have exact buckets: ", IsExact, true);
+        LOG_TEST_RESULT(TestID++, "Every bucket is within 12.5% above its values: ", IsBounded, true);
+        LOG_TEST_RESULT(TestID++, "Bucket upper bound is inside its bucket: ", IsInclusive, true);
+        LOG_TEST_RESULT(TestID++, "Bucket bounds do not overlap: ", IsTight, true);
+        LOG_TEST_RESULT(TestID++, "Worst bucket error is close to the bound: ", (WorstError > 0.1 && WorstError <= MaxBucketError), true);
+
+        // A single value is reported exactly since percentiles are capped at the max
+        Histogram->clear();
+        Histogram->Record(123456789);
+        LOG_TEST_RESULT(TestID++, "Single value p50 is exact: ", Histogram->GetPercentile(50.0), 123456789);
+        LOG_TEST_RESULT(TestID++, "Single value max is exact: ", Histogram->GetMax(), 123456789);
+
+        Histogram->clear();
+        LOG_TEST_RESULT(TestID++, "Empty histogram p50 is zero: ", Histogram->GetPercentile(50.0), 0);
+        LOG_TEST_RESULT(TestID++, "Empty histogram has no count: ", Histogram->GetCount(), 0);
+    }
+
+    void TestPercentiles(DWORD& TestID)
+    {
+        std::unique_ptr<ProfileHistogram> Histogram(new ProfileHistogram);
+
+        for (DWORD Count : { 1u, 7u, 100u, 10000u })
+        {
+            std::vector<ULONGLONG> Values;
+            ULONGLONG Total = 0;
+            Histogram->clear();
+            for (DWORD x = 0; x < Count; x++)
+            {
+                Values.push_back(GetRandomTime());
+                Total += Values.back();
+                Histogram->Record(Values.back());
+            }
+            std::sort(Values.begin(), Values.end());
+
+            const bool IsP50 = IsWithinBucket(Histogram->GetPercentile(50.0), GetReferencePercentile(Values, 50.0));
+            const bool IsP99 = IsWithinBucket(Histogram->GetPercentile(99.0), GetReferencePercentile(Values, 99.0));
+            LOG_TEST_RESULT(TestID++, "p50 of " << Count << " values is within its bucket: ", IsP50, true);
+            LOG_TEST_RESULT(TestID++, "p99 of " << Count << " values is within its bucket: ", IsP99, true);
+            LOG_TEST_RESULT(TestID++, "Max of " << Count << " values is exact: ", (Histogram->GetMax() == Values.back()), true);
+            LOG_TEST_RESULT(TestID++, "Total and count of " << Count << " values are exact: ", (Histogram->GetTotal() == Total && Histogram->GetCount() == Count), true);
+        }
+
+        // Percentiles of a known spread, 99 fast calls and one slow call
+        Histogram->clear();
+        for (DWORD x = 0; x < 99; x++)
+        {
+            Histogram->Record(1000);
+        }
+        Histogram->Record(50000);
+        LOG_TEST_RESULT(TestID++, "p50 ignores a single slow call: ", IsWithinBucket(Histogram->GetPercentile(50.0), 1000), true);
+        LOG_TEST_RESULT(TestID++, "p99 is the 99th call: ", IsWithinBucket(Histogram->GetPercentile(99.0), 1000), true);
+        LOG_TEST_RESULT(TestID++, "p100 is the slow call: ", Histogram->GetPercentile(100.0), 50000);
+    }
+
+    void TestFrameFold(DWORD& TestID)
+    {
+        std::unique_ptr<ProfileStats> Stats(new ProfileStats);
+
+        // Frame one has two calls, the fold records their sum
+        Stats->Record(ZONE_BLT, 100);
+        Stats->Record(ZONE_BLT, 200);
+        Stats->Record(ZONE_LOCK, 40);
+        Stats->EndFrame(16000);
+        LOG_TEST_RESULT(TestID++, "Each call is recorded: ", Stats->GetCallTime(ZONE_BLT).GetCount(), 2);
+        LOG_TEST_RESULT(TestID++, "Frame total is the sum of the calls: ", Stats->GetFrameTime(ZONE_BLT).GetMax(), 300);
+        LOG_TEST_RESULT(TestID++, "Frame time is recorded once per frame: ", Stats->GetFrameTime(ZONE_BLT).GetCount(), 1);
+        LOG_TEST_RESULT(TestID++, "Frame zone records the frame time: ", Stats->GetFrameTime(ZONE_FRAME).GetMax(), 16000);
+        LOG_TEST_RESULT(TestID++, "Zone without calls folds a zero: ", (Stats->GetFrameTime(ZONE_FLIP).GetCount() == 1 && Stats->GetFrameTime(ZONE_FLIP).GetMax() == 0), true);
+
+        // The totals restart after each fold
+        Stats->Record(ZONE_BLT, 50);
+        Stats->EndFrame(17000);
+        LOG_TEST_RESULT(TestID++, "Next frame starts from zero: ", Stats->GetFrameTime(ZONE_BLT).GetTotal(), 350);
+        LOG_TEST_RESULT(TestID++, "Frame total max is kept: ", Stats->GetFrameTime(ZONE_BLT).GetMax(), 300);
+        LOG_TEST_RESULT(TestID++, "Calls across frames are all recorded: ", Stats->GetCallTime(ZONE_BLT).GetTotal(), 350);
+        LOG_TEST_RESULT(TestID++, "Zone with calls in one frame folds a zero in the other: ", Stats->GetFrameTime(ZONE_LOCK).GetTotal(), 40);
+        LOG_TEST_RESULT(TestID++, "Frames are counted: ", Stats->GetFrameCount(), 2);
+
+        // Per-frame p50 follows the typical frame not the busiest one
+        for (DWORD x = 0; x < 98; x++)
+        {
+            Stats->Record(ZONE_DRAWPRIMITIVE, 500);
+            Stats->Record(ZONE_DRAWPRIMITIVE, 500);
+            Stats->EndFrame(16000);
+        }
+        LOG_TEST_RESULT(TestID++, "Per-frame p50 is the typical frame total: ", IsWithinBucket(Stats->GetFrameTime(ZONE_DRAWPRIMITIVE).GetPercentile(50.0), 1000), true);
+
+        Stats->clear();
+        LOG_TEST_RESULT(TestID++, "Clear resets the window: ", (Stats->GetFrameCount() == 0 && Stats->GetCallTime(ZONE_BLT).GetCount() == 0 && Stats->GetFrameTime(ZONE_FRAME).GetCount() == 0), true);
+    }
+
+    // Logs the cost of a profiled zone, the two counter reads and the record a PROFILE_ZONE does when
+    // enabled, next to the one flag check it costs when disabled, and the cost of the per-frame fold
+    void BenchmarkProfiler()
+    {
+        constexpr DWORD Count = 1000000;
+        std::unique_ptr<ProfileStats> Stats(new ProfileStats);
+        volatile bool IsEnabled = false;
+        volatile LONGLONG Sink = 0;
+
+        std::vector<ULONGLONG> Times(1024);
+        for (ULONGLONG& Time : Times)
+        {
+            Time = GetRandomTime();
+        }
+        DWORD Index = 0;
+
+        const double DisabledTime = MeasureNanoseconds(Count, [&]()
+            {
+                const LONGLONG StartTime = IsEnabled ? Profiler::GetTime() : 0;
+                Sink = Sink + StartTime;
+            });
+        const double EnabledTime = MeasureNanoseconds(Count, [&]()
+            {
+                const LONGLONG StartTime = Profiler::GetTime();
+                Stats->Record(ZONE_DRAWPRIMITIVE, (ULONGLONG)(Profiler::GetTime() - StartTime));
+            });
+        const double RecordTime = MeasureNanoseconds(Count, [&]()
+            {
+                Stats->Record(ZONE_DRAWPRIMITIVE, Times[Index++ & 1023]);
+            });
+        const double EndFrameTime = MeasureNanoseconds(Count / 100, [&]()
+            {
+                Stats->EndFrame(16000000);
+            });
+
+        Logging::Log() << "Benchmark: Profiler zone " << DisabledTime << " ns disabled, " << EnabledTime << " ns enabled, " <<
+            RecordTime << " ns per record, " << EndFrameTime << " ns per EndFrame";
+    }
+}
+
+void TestProfiler()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing Profiler";
+    Logging::Log() << "****";
+
+    DWORD TestID = 11500;
+
+    TestBucketAccuracy(TestID);
+    TestPercentiles(TestID);
+    TestFrameFold(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkProfiler();
+    }
+}
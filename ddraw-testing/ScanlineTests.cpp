@@ -0,0 +1,199 @@
+// Included first so the Direct3D 9 types are used the same way as in the wrapper
+#include "ddraw\SurfaceBlitter.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <string>
+
+namespace {
+    constexpr LONG FrameWidth = 101;    // Odd width so rows do not end on a pixel group boundary
+    constexpr LONG FrameHeight = 120;   // RemoveScanlines skips locks under 100 rows
+    constexpr LONG FramePadding = 12;
+
+    // Detector used before the single pass, copies the first row of each parity and compares every row with it
+    void DetectScanlinesReference(const BYTE* pBits, INT Pitch, size_t RowSize, DWORD Height, bool& bEvenScanlines, bool& bOddScanlines)
+    {
+        std::vector<BYTE> EvenScanLine(RowSize), OddScanLine(RowSize);
+        for (DWORD y = 0; y < Height; y++)
+        {
+            const BYTE* Row = pBits + Pitch * y;
+            if (y % 2 == 0)
+            {
+                if (y == 0)
+                {
+                    bEvenScanlines = true;
+                    memcpy(EvenScanLine.data(), Row, RowSize);
+                }
+                else if (bEvenScanlines)
+                {
+                    bEvenScanlines = (memcmp(EvenScanLine.data(), Row, RowSize) == 0);
+                }
+            }
+            else
+            {
+                if (y == 1)
+                {
+                    bOddScanlines = true;
+                    memcpy(OddScanLine.data(), Row, RowSize);
+                }
+                else if (bOddScanlines)
+                {
+                    bOddScanlines = (memcmp(OddScanLine.data(), Row, RowSize) == 0);
+                }
+            }
+            if (!bOddScanlines && !bEvenScanlines)
+            {
+                break;
+            }
+        }
+    }
+
+    enum FRAMETYPE
+    {
+        FRAME_EVENLINES,        // Even rows are one solid scanline color, odd rows carry the picture
+        FRAME_ODDLINES,
+        FRAME_SOLID,            // Every row the same, both parities match
+        FRAME_PROGRESSIVE,      // No repeated rows
+        FRAME_LASTROWCHANGED,   // Even scanlines except one byte in the last even row
+        FRAME_LASTBYTECHANGED,  // Odd scanlines except the last byte of a middle odd row
+        FRAME_PERIOD4,          // Even rows alternate between two colors, rows two apart differ
+        FRAME_COUNT
+    };
+
+    const char* const FrameNames[] = { "even scanlines", "odd scanlines", "solid", "progressive", "last even row changed", "last byte of odd row changed", "two color even rows" };
+
+    void BuildFrame(std::vector<BYTE>& Frame, INT Pitch, size_t RowSize, LONG Height, FRAMETYPE Type)
+    {
+        DWORD Seed = 7;
+        for (BYTE& Byte : Frame)
+        {
+            Seed = Seed * 214013 + 2531011;
+            Byte = (BYTE)(Seed >> 16);
+        }
+
+        for (LONG y = 0; y < Height; y++)
+        {
+            BYTE* Row = Frame.data() + Pitch * y;
+            const bool IsEven = (y % 2 == 0);
+            switch (Type)
+            {
+            case FRAME_EVENLINES:
+            case FRAME_LASTROWCHANGED:
+            case FRAME_PERIOD4:
+                if (IsEven)
+                {
+                    memset(Row, (Type == FRAME_PERIOD4 && y % 4 == 2) ? 0x11 : 0x00, RowSize);
+                }
+                break;
+            case FRAME_ODDLINES:
+            case FRAME_LASTBYTECHANGED:
+                if (!IsEven)
+                {
+                    memset(Row, 0x20, RowSize);
+                }
+                break;
+            case FRAME_SOLID:
+                memset(Row, 0x40, RowSize);
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (Type == FRAME_LASTROWCHANGED)
+        {
+            Frame[Pitch * (Height - 2) + RowSize / 2] ^= 0x01;
+        }
+        if (Type == FRAME_LASTBYTECHANGED)
+        {
+            Frame[Pitch * (Height / 2 | 1) + RowSize - 1] ^= 0x80;
+        }
+    }
+
+    void TestDetectScanlines(DWORD& TestID, DWORD BitCount)
+    {
+        const size_t RowSize = FrameWidth * (BitCount / 8);
+        const INT Pitch = (INT)RowSize + FramePadding;
+        std::vector<BYTE> Frame(Pitch * FrameHeight);
+
+        for (int Type = 0; Type < FRAME_COUNT; Type++)
+        {
+            BuildFrame(Frame, Pitch, RowSize, FrameHeight, (FRAMETYPE)Type);
+
+            bool bRefEven = false, bRefOdd = false;
+            DetectScanlinesReference(Frame.data(), Pitch, RowSize, FrameHeight, bRefEven, bRefOdd);
+
+            bool bEven = false, bOdd = false;
+            DetectScanlines(Frame.data(), Pitch, RowSize, FrameHeight, bEven, bOdd);
+            const bool IsMatching = (bEven == bRefEven && bOdd == bRefOdd);
+
+            LOG_TEST_RESULT(TestID++, "DetectScanlines " << BitCount << "-bit " << FrameNames[Type] << " matches the old detector: ", IsMatching, true);
+        }
+
+        // Known answers so both detectors can not be wrong the same way
+        BuildFrame(Frame, Pitch, RowSize, FrameHeight, FRAME_EVENLINES);
+        bool bEven = false, bOdd = false;
+        DetectScanlines(Frame.data(), Pitch, RowSize, FrameHeight, bEven, bOdd);
+        LOG_TEST_RESULT(TestID++, "DetectScanlines " << BitCount << "-bit even scanlines found: ", (bEven && !bOdd), true);
+
+        BuildFrame(Frame, Pitch, RowSize, FrameHeight, FRAME_ODDLINES);
+        DetectScanlines(Frame.data(), Pitch, RowSize, FrameHeight, bEven, bOdd);
+        LOG_TEST_RESULT(TestID++, "DetectScanlines " << BitCount << "-bit odd scanlines found: ", (!bEven && bOdd), true);
+
+        BuildFrame(Frame, Pitch, RowSize, FrameHeight, FRAME_PROGRESSIVE);
+        DetectScanlines(Frame.data(), Pitch, RowSize, FrameHeight, bEven, bOdd);
+        LOG_TEST_RESULT(TestID++, "DetectScanlines " << BitCount << "-bit progressive frame has no scanlines: ", (!bEven && !bOdd), true);
+    }
+
+    // Logs the time to check a 640x480 frame for scanlines with the single pass and with the old detector, which copies
+    // the first row of each parity and compares every later row with the copy
+    void BenchmarkDetectScanlines(DWORD BitCount)
+    {
+        constexpr LONG Width = 640;
+        constexpr LONG Height = 480;
+        constexpr DWORD Count = 200;
+        const size_t RowSize = Width * (BitCount / 8);
+        const INT Pitch = (INT)RowSize;
+        std::vector<BYTE> Frame(Pitch * Height);
+
+        for (FRAMETYPE Type : { FRAME_EVENLINES, FRAME_ODDLINES, FRAME_SOLID, FRAME_PROGRESSIVE })
+        {
+            BuildFrame(Frame, Pitch, RowSize, Height, Type);
+            bool bEven = false, bOdd = false;
+
+            const double RefTime = MeasureNanoseconds(Count, [&]()
+                {
+                    DetectScanlinesReference(Frame.data(), Pitch, RowSize, Height, bEven, bOdd);
+                });
+
+            const double Time = MeasureNanoseconds(Count, [&]()
+                {
+                    DetectScanlines(Frame.data(), Pitch, RowSize, Height, bEven, bOdd);
+                });
+
+            Logging::Log() << "Benchmark: DetectScanlines " << BitCount << "-bit " << FrameNames[Type] <<
+                " single pass " << (Time / 1000.0) << " us, old detector " << (RefTime / 1000.0) << " us per frame";
+        }
+    }
+}
+
+void TestScanlines()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing Scanlines";
+    Logging::Log() << "****";
+
+    DWORD TestID = 9000;
+
+    TestDetectScanlines(TestID, 8);
+    TestDetectScanlines(TestID, 16);
+    TestDetectScanlines(TestID, 32);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkDetectScanlines(8);
+        BenchmarkDetectScanlines(16);
+        BenchmarkDetectScanlines(32);
+    }
+}
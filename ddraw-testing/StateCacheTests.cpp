@@ -0,0 +1,267 @@
+#include "ddraw\StateCache.h"
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+namespace {
+    constexpr UINT TestStateCount = 70;     // Not a multiple of 32 so the last dirty word is partial
+
+    typedef std::vector<std::pair<UINT, DWORD>> STATELIST;
+
+    STATELIST FlushStates(DirtyStateArray<DWORD, TestStateCount>& States)
+    {
+        STATELIST Visited;
+        States.Flush([&](UINT Index, DWORD NewValue) {
+            Visited.push_back({ Index, NewValue });
+        });
+        return Visited;
+    }
+
+    // Follows the device: states are batched, then only sent if the device does not already have them
+    struct CACHEDDEVICE
+    {
+        DirtyStateArray<DWORD, TestStateCount> BatchStates;
+        AppliedStateArray<TestStateCount> AppliedStates;
+        DWORD DeviceState[TestStateCount] = {};
+        STATELIST DeviceCalls;
+
+        void SetState(UINT Index, DWORD NewValue)
+        {
+            BatchStates.Set(Index, NewValue);
+        }
+
+        // Same as PrepDevice()
+        void PrepDevice()
+        {
+            BatchStates.Flush([&](UINT Index, DWORD NewValue) {
+                if (AppliedStates.Update(Index, NewValue))
+                {
+                    SetDeviceState(Index, NewValue);
+                }
+            });
+        }
+
+        // State changed outside the cache, such as the draw state fixups
+        void SetDeviceStateDirect(UINT Index, DWORD NewValue)
+        {
+            SetDeviceState(Index, NewValue);
+            AppliedStates.Invalidate(Index);
+        }
+
+        // The device state may have been changed by another device
+        void RestoreStates()
+        {
+            AppliedStates.clear();
+        }
+
+        void ClearDeviceState()
+        {
+            BatchStates.clear();
+            AppliedStates.clear();
+        }
+
+        void SetDeviceState(UINT Index, DWORD NewValue)
+        {
+            DeviceState[Index] = NewValue;
+            DeviceCalls.push_back({ Index, NewValue });
+        }
+    };
+
+    void TestDirtyStates(DWORD& TestID)
+    {
+        DirtyStateArray<DWORD, TestStateCount> States;
+
+        States.Set(40, 4);
+        States.Set(3, 1);
+        States.Set(69, 6);
+        States.Set(31, 2);
+        States.Set(32, 3);
+        States.Set(40, 5);
+
+        const STATELIST Expected = { { 3, 1 }, { 31, 2 }, { 32, 3 }, { 40, 5 }, { 69, 6 } };
+        const STATELIST Flushed = FlushStates(States);
+        const STATELIST FlushedAgain = FlushStates(States);
+        LOG_TEST_RESULT(TestID++, "Dirty states flushed in index order with the last value: ", (Flushed == Expected), true);
+        LOG_TEST_RESULT(TestID++, "Second flush visits nothing: ", FlushedAgain.size(), 0);
+
+        States.Set(10, 1);
+        States.Set(11, 1);
+        States.Reset(10);
+        LOG_TEST_RESULT(TestID++, "Reset entry is not dirty: ", States.IsDirty(10), false);
+        LOG_TEST_RESULT(TestID++, "Other entry still dirty: ", States.IsDirty(11), true);
+        const STATELIST FlushedAfterReset = FlushStates(States);
+        LOG_TEST_RESULT(TestID++, "Flush skips the reset entry: ", (FlushedAfterReset == STATELIST{ { 11, 1 } }), true);
+
+        States.Set(5, 1);
+        States.Set(68, 1);
+        States.clear();
+        const STATELIST FlushedAfterClear = FlushStates(States);
+        LOG_TEST_RESULT(TestID++, "Cleared states flush nothing: ", FlushedAfterClear.size(), 0);
+    }
+
+    // Recorded state blocks can be applied more than once, so visiting them keeps the dirty bits
+    void TestRecordedStates(DWORD& TestID)
+    {
+        DirtyStateArray<DWORD, TestStateCount> States;
+
+        States.Set(64, 2);
+        States.Set(9, 1);
+
+        STATELIST Visited;
+        States.ForEach([&](UINT Index, DWORD NewValue) {
+            Visited.push_back({ Index, NewValue });
+        });
+        const STATELIST Expected = { { 9, 1 }, { 64, 2 } };
+        LOG_TEST_RESULT(TestID++, "Recorded states visited in index order: ", (Visited == Expected), true);
+        LOG_TEST_RESULT(TestID++, "Visiting keeps the states dirty: ", (FlushStates(States) == Expected), true);
+        LOG_TEST_RESULT(TestID++, "Recorded value can be read back: ", States.Get(64), 2);
+    }
+
+    void TestAppliedStates(DWORD& TestID)
+    {
+        AppliedStateArray<TestStateCount> States;
+
+        const bool IsUnknownSent = States.Update(7, 0);
+        const bool IsSameSent = States.Update(7, 0);
+        const bool IsDifferentSent = States.Update(7, 1);
+        LOG_TEST_RESULT(TestID++, "Unknown state is sent: ", IsUnknownSent, true);
+        LOG_TEST_RESULT(TestID++, "Same value is skipped: ", IsSameSent, false);
+        LOG_TEST_RESULT(TestID++, "Different value is sent: ", IsDifferentSent, true);
+
+        States.Invalidate(7);
+        const bool IsInvalidatedSent = States.Update(7, 1);
+        const bool IsOtherSent = States.Update(69, 2);
+        const bool IsRepeatSent = States.Update(7, 1);
+        LOG_TEST_RESULT(TestID++, "Same value sent after Invalidate: ", IsInvalidatedSent, true);
+        LOG_TEST_RESULT(TestID++, "Invalidate only affects its entry: ", (IsOtherSent && !IsRepeatSent), true);
+
+        States.clear();
+        const bool IsClearedSent = States.Update(69, 2);
+        LOG_TEST_RESULT(TestID++, "Same value sent after clear: ", IsClearedSent, true);
+    }
+
+    void TestDeviceShadow(DWORD& TestID)
+    {
+        CACHEDDEVICE Device;
+
+        Device.SetState(1, 10);
+        Device.SetState(2, 20);
+        Device.PrepDevice();
+        LOG_TEST_RESULT(TestID++, "New states sent to the device: ", Device.DeviceCalls.size(), 2);
+
+        Device.DeviceCalls.clear();
+        Device.SetState(1, 10);
+        Device.SetState(2, 21);
+        Device.PrepDevice();
+        LOG_TEST_RESULT(TestID++, "Redundant set skipped: ", (Device.DeviceCalls == STATELIST{ { 2, 21 } }), true);
+
+        Device.DeviceCalls.clear();
+        Device.SetDeviceStateDirect(1, 0);
+        Device.SetState(1, 10);
+        Device.PrepDevice();
+        LOG_TEST_RESULT(TestID++, "State changed outside the cache is set again: ", Device.DeviceState[1], 10);
+
+        Device.DeviceCalls.clear();
+        Device.RestoreStates();
+        Device.SetState(1, 10);
+        Device.SetState(2, 21);
+        Device.PrepDevice();
+        LOG_TEST_RESULT(TestID++, "All states sent again after RestoreStates: ", Device.DeviceCalls.size(), 2);
+
+        Device.DeviceCalls.clear();
+        Device.SetState(3, 30);
+        Device.ClearDeviceState();
+        Device.PrepDevice();
+        LOG_TEST_RESULT(TestID++, "Batched states dropped by ClearDeviceState: ", Device.DeviceCalls.size(), 0);
+
+        Device.SetState(2, 21);
+        Device.PrepDevice();
+        LOG_TEST_RESULT(TestID++, "Same value sent again after ClearDeviceState: ", (Device.DeviceCalls == STATELIST{ { 2, 21 } }), true);
+    }
+
+    // Logs the cost per frame of 200 state sets over 256 render states, half of them repeating the value the
+    // device already has, through the dirty and applied arrays and through the unordered_map flush used before
+    void BenchmarkStateCache()
+    {
+        constexpr UINT StateCount = 256;
+        constexpr DWORD SetsPerFrame = 200;
+        constexpr DWORD FrameCount = 1000;
+
+        // Each frame sets the same states, every other one to a new value
+        std::vector<std::pair<UINT, DWORD>> Sets;
+        DWORD Seed = 1;
+        for (DWORD x = 0; x < SetsPerFrame; x++)
+        {
+            Seed = Seed * 1664525 + 1013904223;
+            Sets.push_back({ (Seed >> 16) % StateCount, x & 1 });
+        }
+
+        DWORD DeviceState[StateCount] = {};
+        DWORD DeviceCalls = 0;
+        auto SetDeviceState = [&](UINT Index, DWORD NewValue)
+            {
+                DeviceState[Index] = NewValue;
+                DeviceCalls++;
+            };
+
+        DirtyStateArray<DWORD, StateCount> BatchStates;
+        AppliedStateArray<StateCount> AppliedStates;
+        DWORD Frame = 0;
+        const double ArrayTime = MeasureNanoseconds(FrameCount, [&]()
+            {
+                Frame++;
+                for (const auto& Set : Sets)
+                {
+                    BatchStates.Set(Set.first, Set.second ? Frame : 0);
+                }
+                BatchStates.Flush([&](UINT Index, DWORD NewValue) {
+                    if (AppliedStates.Update(Index, NewValue))
+                    {
+                        SetDeviceState(Index, NewValue);
+                    }
+                });
+            });
+        const DWORD ArrayCalls = DeviceCalls / (FrameCount + 1);
+
+        std::unordered_map<UINT, DWORD> BatchMap;
+        DeviceCalls = 0;
+        const double MapTime = MeasureNanoseconds(FrameCount, [&]()
+            {
+                Frame++;
+                for (const auto& Set : Sets)
+                {
+                    BatchMap[Set.first] = Set.second ? Frame : 0;
+                }
+                for (const auto& entry : BatchMap)
+                {
+                    SetDeviceState(entry.first, entry.second);
+                }
+                BatchMap.clear();
+            });
+        const DWORD MapCalls = DeviceCalls / (FrameCount + 1);
+
+        Logging::Log() << "Benchmark: StateCache " << SetsPerFrame << " sets per frame, dirty array " << ArrayTime << " ns and " << ArrayCalls <<
+            " device calls, unordered_map " << MapTime << " ns and " << MapCalls << " device calls per frame";
+    }
+}
+
+void TestStateCache()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing StateCache";
+    Logging::Log() << "****";
+
+    DWORD TestID = 6500;
+
+    TestDirtyStates(TestID);
+    TestRecordedStates(TestID);
+    TestAppliedStates(TestID);
+    TestDeviceShadow(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkStateCache();
+    }
+}
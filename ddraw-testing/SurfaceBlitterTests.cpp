@@ -0,0 +1,693 @@
+// Included first so the Direct3D 9 types are used the same way as in the wrapper
+#include "ddraw\SurfaceBlitter.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <string>
+#include <algorithm>
+
+namespace {
+    constexpr LONG TestWidth = 77;      // Odd size so every SIMD loop also runs its scalar tail
+    constexpr LONG TestHeight = 9;
+    constexpr LONG TestPadding = 16;    // Extra bytes at the end of each row, a kernel writing past the row changes them
+
+    const char* GetBlitLevelName(BLITLEVEL Level)
+    {
+        switch (Level)
+        {
+        case BLIT_SSE2:
+            return "SSE2";
+        case BLIT_SSSE3:
+            return "SSSE3";
+        case BLIT_AVX2:
+            return "AVX2";
+        default:
+            return "Scalar";
+        }
+    }
+
+    // Repeatable noise so each level works on the same data
+    void FillPattern(std::vector<BYTE>& Buffer, DWORD Seed)
+    {
+        for (BYTE& Byte : Buffer)
+        {
+            Seed = Seed * 214013 + 2531011;
+            Byte = (BYTE)(Seed >> 16);
+        }
+    }
+
+    // Sets single color key pixels and a fully transparent run, so the SIMD loops skip whole vectors too
+    template <typename T>
+    void SetColorKeyPixels(std::vector<BYTE>& Buffer, INT Pitch, LONG Width, LONG Height, T ColorKey)
+    {
+        for (LONG y = 0; y < Height; y++)
+        {
+            T* Row = reinterpret_cast<T*>(Buffer.data() + y * Pitch);
+            for (LONG x = 0; x < Width; x++)
+            {
+                if ((x + y) % 5 == 0 || (x >= 32 && x < 64))
+                {
+                    Row[x] = ColorKey;
+                }
+            }
+        }
+    }
+
+    // Runs the blit once per instruction set the CPU supports and compares each result with the scalar one
+    template <typename F>
+    void CompareWithScalar(DWORD& TestID, const std::string& Name, F Run)
+    {
+        std::vector<BYTE> Expected;
+        Run(Expected, BLIT_SCALAR);
+
+        const BLITLEVEL MaxLevel = GetBlitLevel();
+
+        for (int Level = BLIT_SSE2; Level <= MaxLevel; Level++)
+        {
+            std::vector<BYTE> Output;
+            Run(Output, (BLITLEVEL)Level);
+            LOG_TEST_RESULT(TestID++, Name << " " << GetBlitLevelName((BLITLEVEL)Level) << " matches scalar: ", (Output == Expected), TRUE);
+        }
+    }
+
+    // Area moved by the overlap tests, leaves room for the largest offset
+    constexpr LONG OverlapWidth = TestWidth - 5;
+    constexpr LONG OverlapHeight = TestHeight - 1;
+
+    template <typename T>
+    INT GetOverlapSrcOffset(INT Pitch, const POINT& Offset)
+    {
+        return (Offset.y < 0 ? -Offset.y : 0) * Pitch + (Offset.x < 0 ? -Offset.x : 0) * (INT)sizeof(T);
+    }
+
+    // Copies the source area out of a snapshot of the buffer, so the result is what an overlapping copy must give
+    template <typename T>
+    void OverlapReference(std::vector<BYTE>& Expected, const std::vector<BYTE>& Buffer, INT Pitch, const POINT& Offset, T ColorKey, bool IsColorKey, bool IsMirror)
+    {
+        const std::vector<BYTE> Snapshot = Buffer;
+        Expected = Buffer;
+        const INT SrcOffset = GetOverlapSrcOffset<T>(Pitch, Offset);
+        const INT DestOffset = SrcOffset + Offset.y * Pitch + Offset.x * (INT)sizeof(T);
+        for (LONG y = 0; y < OverlapHeight; y++)
+        {
+            const T* SrcRow = reinterpret_cast<const T*>(Snapshot.data() + SrcOffset + y * Pitch);
+            T* DestRow = reinterpret_cast<T*>(Expected.data() + DestOffset + y * Pitch);
+            for (LONG x = 0; x < OverlapWidth; x++)
+            {
+                const T Pixel = SrcRow[IsMirror ? OverlapWidth - x - 1 : x];
+                if (!IsColorKey || Pixel != ColorKey)
+                {
+                    DestRow[x] = Pixel;
+                }
+            }
+        }
+    }
+
+    template <typename T>
+    void TestCopyKernels(DWORD& TestID, T ColorKey)
+    {
+        const INT Pitch = TestWidth * sizeof(T) + TestPadding;
+        const std::string Size = std::to_string(sizeof(T) * 8) + "-bit";
+
+        std::vector<BYTE> Src(Pitch * TestHeight);
+        FillPattern(Src, 1);
+        SetColorKeyPixels<T>(Src, Pitch, TestWidth, TestHeight, ColorKey);
+
+        for (int Flags = 0; Flags < 4; Flags++)
+        {
+            const bool IsColorKey = (Flags & 1) != 0;
+            const bool IsMirror = (Flags & 2) != 0;
+            const std::string Options = std::string(IsColorKey ? " colorkey" : "") + (IsMirror ? " mirror" : "");
+
+            CompareWithScalar(TestID, "SimpleColorKeyCopy " + Size + Options, [&](std::vector<BYTE>& Dest, BLITLEVEL Level)
+                {
+                    Dest.resize(Pitch * TestHeight);
+                    FillPattern(Dest, 2);
+                    SimpleColorKeyCopy<T>(ColorKey, Src.data(), Dest.data(), Pitch, Pitch, TestWidth, TestHeight, IsColorKey, IsMirror, Level);
+                });
+
+            // Copies within one buffer moving left, right, up, down and diagonally, the shift of 5 is shorter than a vector
+            const POINT Offsets[] = { { -1, 0 }, { 1, 0 }, { -5, 0 }, { 5, 0 }, { 0, -1 }, { 0, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 } };
+            for (const POINT& Offset : Offsets)
+            {
+                std::vector<BYTE> Expected;
+                OverlapReference<T>(Expected, Src, Pitch, Offset, ColorKey, IsColorKey, IsMirror);
+
+                const BLITLEVEL MaxLevel = GetBlitLevel();
+
+                bool IsMatching = true;
+                for (int Level = BLIT_SCALAR; Level <= MaxLevel; Level++)
+                {
+                    std::vector<BYTE> Dest = Src;
+                    std::vector<BYTE> RowBuffer(Pitch);
+                    BYTE* SrcBuffer = Dest.data() + GetOverlapSrcOffset<T>(Pitch, Offset);
+                    BYTE* DestBuffer = SrcBuffer + Offset.y * Pitch + Offset.x * (INT)sizeof(T);
+                    OverlapCopy<T>(ColorKey, SrcBuffer, DestBuffer, Pitch, OverlapWidth, OverlapHeight, Offset.y, RowBuffer.data(), IsColorKey, IsMirror, (BLITLEVEL)Level);
+                    IsMatching = IsMatching && (Dest == Expected);
+                }
+
+                LOG_TEST_RESULT(TestID++, "OverlapCopy " << Size << Options << " offset " << Offset.x << "," << Offset.y << " matches a copy from a snapshot: ", IsMatching, TRUE);
+            }
+        }
+    }
+
+    // Nearest source pixel computed directly, the stretch must match it for every pixel
+    template <typename T>
+    void StretchReference(std::vector<BYTE>& Dest, INT DestPitch, const std::vector<BYTE>& Src, INT SrcPitch, LONG SrcWidth, LONG SrcHeight, LONG DestWidth, LONG DestHeight,
+        T ColorKey, bool IsColorKey, bool IsMirrorUpDown, bool IsMirrorLeftRight)
+    {
+        for (LONG y = 0; y < DestHeight; y++)
+        {
+            LONG sy = (LONG)((ULONGLONG)y * SrcHeight / DestHeight);
+            LONG SrcRow = IsMirrorUpDown ? SrcHeight - sy - 1 : sy;
+            const T* SrcLine = reinterpret_cast<const T*>(Src.data() + SrcRow * SrcPitch);
+            T* DestLine = reinterpret_cast<T*>(Dest.data() + y * DestPitch);
+            for (LONG x = 0; x < DestWidth; x++)
+            {
+                LONG sx = (LONG)((ULONGLONG)x * SrcWidth / DestWidth);
+                T Pixel = SrcLine[IsMirrorLeftRight ? SrcWidth - sx - 1 : sx];
+                if (!IsColorKey || Pixel != ColorKey)
+                {
+                    DestLine[x] = Pixel;
+                }
+            }
+        }
+    }
+
+    template <typename T>
+    void TestStretchKernels(DWORD& TestID, T ColorKey)
+    {
+        const std::string Size = std::to_string(sizeof(T) * 8) + "-bit";
+
+        // Sizes that do not divide evenly, growing in one direction and shrinking in the other
+        const LONG SrcWidth = 37;
+        const LONG SrcHeight = 23;
+        const INT SrcPitch = SrcWidth * sizeof(T) + TestPadding;
+        const INT DestPitch = TestWidth * sizeof(T) + TestPadding;
+
+        std::vector<BYTE> Src(SrcPitch * SrcHeight);
+        FillPattern(Src, 3);
+        SetColorKeyPixels<T>(Src, SrcPitch, SrcWidth, SrcHeight, ColorKey);
+
+        std::vector<DWORD> Scratch((GetComplexCopyScratchSize(TestWidth, sizeof(T)) + 3) / 4);
+
+        for (int Flags = 0; Flags < 8; Flags++)
+        {
+            const bool IsColorKey = (Flags & 1) != 0;
+            const bool IsMirrorUpDown = (Flags & 2) != 0;
+            const bool IsMirrorLeftRight = (Flags & 4) != 0;
+            const std::string Options = std::string(IsColorKey ? " colorkey" : "") + (IsMirrorUpDown ? " updown" : "") + (IsMirrorLeftRight ? " leftright" : "");
+
+            auto Run = [&](std::vector<BYTE>& Dest, BLITLEVEL Level)
+                {
+                    Dest.resize(DestPitch * TestHeight);
+                    FillPattern(Dest, 4);
+                    D3DLOCKED_RECT SrcLockRect = { SrcPitch, Src.data() };
+                    D3DLOCKED_RECT DestLockRect = { DestPitch, Dest.data() };
+                    ComplexCopy<T>(ColorKey, SrcLockRect, DestLockRect, SrcWidth, SrcHeight, TestWidth, TestHeight, (BYTE*)Scratch.data(),
+                        IsColorKey, IsMirrorUpDown, IsMirrorLeftRight, {}, 0, 0, nullptr, Level);
+                };
+
+            std::vector<BYTE> Output;
+            Run(Output, GetBlitLevel());
+            std::vector<BYTE> Expected(DestPitch * TestHeight);
+            FillPattern(Expected, 4);
+            StretchReference<T>(Expected, DestPitch, Src, SrcPitch, SrcWidth, SrcHeight, TestWidth, TestHeight, ColorKey, IsColorKey, IsMirrorUpDown, IsMirrorLeftRight);
+            LOG_TEST_RESULT(TestID++, "ComplexCopy " << Size << Options << " matches x * Src / Dest: ", (Output == Expected), TRUE);
+
+            CompareWithScalar(TestID, "ComplexCopy " + Size + Options, Run);
+        }
+    }
+
+    DWORD GetFormatSize(D3DFORMAT Format)
+    {
+        switch ((DWORD)Format)
+        {
+        case D3DFMT_R8G8B8:
+        case D3DFMT_B8G8R8:
+            return 3;
+        case D3DFMT_A8R8G8B8:
+        case D3DFMT_X8R8G8B8:
+        case D3DFMT_A8B8G8R8:
+        case D3DFMT_X8B8G8R8:
+            return 4;
+        default:
+            return 2;
+        }
+    }
+
+    // Bits the conversion must set, the X bits of a format without alpha are undefined
+    DWORD GetFormatMask(D3DFORMAT Format)
+    {
+        switch ((DWORD)Format)
+        {
+        case D3DFMT_X8R8G8B8:
+        case D3DFMT_X8B8G8R8:
+        case D3DFMT_R8G8B8:
+        case D3DFMT_B8G8R8:
+            return 0x00FFFFFF;
+        case D3DFMT_X1R5G5B5:
+            return 0x7FFF;
+        case D3DFMT_X4R4G4B4:
+            return 0x0FFF;
+        case D3DFMT_A8R8G8B8:
+        case D3DFMT_A8B8G8R8:
+            return 0xFFFFFFFF;
+        default:
+            return 0xFFFF;
+        }
+    }
+
+    bool HasAlpha(D3DFORMAT Format)
+    {
+        return (Format == D3DFMT_A8R8G8B8 || Format == D3DFMT_A8B8G8R8 || Format == D3DFMT_A1R5G5B5 || Format == D3DFMT_A4R4G4B4);
+    }
+
+    // Reference conversion of one pixel to A8R8G8B8, uses the old scalar macros where the wrapper had them
+    DWORD DecodePixel(D3DFORMAT Format, DWORD Pixel)
+    {
+        DWORD Color;
+        switch ((DWORD)Format)
+        {
+        case D3DFMT_R5G6B5:
+            Color = D3DFMT_R5G6B5_TO_X8R8G8B8(Pixel);
+            break;
+        case D3DFMT_A1R5G5B5:
+        case D3DFMT_X1R5G5B5:
+            Color = ((Pixel & 0x8000) ? 0xFF000000 : 0) + (((Pixel >> 10) & 0x1F) * 8 << 16) + (((Pixel >> 5) & 0x1F) * 8 << 8) + ((Pixel & 0x1F) * 8);
+            break;
+        case D3DFMT_A4R4G4B4:
+        case D3DFMT_X4R4G4B4:
+            Color = (((Pixel >> 12) & 0xF) * 17 << 24) + (((Pixel >> 8) & 0xF) * 17 << 16) + (((Pixel >> 4) & 0xF) * 17 << 8) + ((Pixel & 0xF) * 17);
+            break;
+        case D3DFMT_B8G8R8:
+            Color = D3DFMT_X8R8G8B8_TO_B8G8R8(Pixel);
+            break;
+        case D3DFMT_A8B8G8R8:
+        case D3DFMT_X8B8G8R8:
+            Color = D3DFMT_A8R8G8B8_TO_A8B8G8R8(Pixel);
+            break;
+        default:
+            Color = Pixel;
+            break;
+        }
+        // A source without alpha is opaque
+        return HasAlpha(Format) ? Color : (Color | 0xFF000000);
+    }
+
+    // Reference conversion of one A8R8G8B8 pixel to the format
+    DWORD EncodePixel(D3DFORMAT Format, DWORD Color)
+    {
+        const DWORD a = Color >> 24, r = (Color >> 16) & 0xFF, g = (Color >> 8) & 0xFF, b = Color & 0xFF;
+        switch ((DWORD)Format)
+        {
+        case D3DFMT_A4R4G4B4:
+        case D3DFMT_X4R4G4B4:
+            return D3DFMT_A8R8G8B8_TO_A4R4G4B4(Color);
+        case D3DFMT_R5G6B5:
+            return ((r >> 3) << 11) + ((g >> 2) << 5) + (b >> 3);
+        case D3DFMT_A1R5G5B5:
+        case D3DFMT_X1R5G5B5:
+            return ((a >> 7) << 15) + ((r >> 3) << 10) + ((g >> 3) << 5) + (b >> 3);
+        case D3DFMT_B8G8R8:
+            return D3DFMT_X8R8G8B8_TO_B8G8R8(Color);
+        case D3DFMT_A8B8G8R8:
+        case D3DFMT_X8B8G8R8:
+            return D3DFMT_A8R8G8B8_TO_A8B8G8R8(Color);
+        default:
+            return Color;
+        }
+    }
+
+    DWORD ReadPixel(const BYTE* pPixel, DWORD Size)
+    {
+        return (Size == 4) ? *(const DWORD*)pPixel : (Size == 3) ? (DWORD)*(const TRIBYTE*)pPixel : *(const WORD*)pPixel;
+    }
+
+    // Converts the rect with every instruction set and checks each pixel against the reference conversion
+    void CompareWithReference(DWORD& TestID, const char* Name, D3DFORMAT SrcFormat, D3DFORMAT DestFormat)
+    {
+        const DWORD SrcSize = GetFormatSize(SrcFormat);
+        const DWORD DestSize = GetFormatSize(DestFormat);
+        const INT SrcPitch = TestWidth * SrcSize + TestPadding;
+        const INT DestPitch = TestWidth * DestSize + TestPadding;
+        const DWORD Mask = GetFormatMask(DestFormat);
+
+        std::vector<BYTE> Src(SrcPitch * TestHeight);
+        FillPattern(Src, 5);
+
+        const BLITLEVEL MaxLevel = GetBlitLevel();
+
+        for (int Level = BLIT_SCALAR; Level <= MaxLevel; Level++)
+        {
+            std::vector<BYTE> Dest(DestPitch * TestHeight);
+            FillPattern(Dest, 6);
+            const std::vector<BYTE> Initial = Dest;
+            ConvertPixelRect(Dest.data(), DestPitch, DestFormat, Src.data(), SrcPitch, SrcFormat, TestWidth, TestHeight, (BLITLEVEL)Level);
+
+            bool IsMatch = true;
+            for (LONG y = 0; y < TestHeight; y++)
+            {
+                for (LONG x = 0; x < TestWidth; x++)
+                {
+                    const DWORD Expected = EncodePixel(DestFormat, DecodePixel(SrcFormat, ReadPixel(Src.data() + y * SrcPitch + x * SrcSize, SrcSize)));
+                    IsMatch &= ((ReadPixel(Dest.data() + y * DestPitch + x * DestSize, DestSize) & Mask) == (Expected & Mask));
+                }
+                // Padding after the row must not be written
+                IsMatch &= std::equal(Dest.begin() + y * DestPitch + TestWidth * DestSize, Dest.begin() + (y + 1) * DestPitch, Initial.begin() + y * DestPitch + TestWidth * DestSize);
+            }
+            LOG_TEST_RESULT(TestID++, "ConvertPixelRect " << Name << " " << GetBlitLevelName((BLITLEVEL)Level) << " matches reference: ", IsMatch, true);
+        }
+    }
+
+    // Every conversion pair ConvertPixelRect has a kernel for
+    const struct { D3DFORMAT Src; D3DFORMAT Dest; const char* Name; } Conversions[] =
+    {
+        { D3DFMT_A8R8G8B8, D3DFMT_A4R4G4B4, "A8R8G8B8 to A4R4G4B4" },
+        { D3DFMT_X8R8G8B8, D3DFMT_X4R4G4B4, "X8R8G8B8 to X4R4G4B4" },
+        { D3DFMT_A4R4G4B4, D3DFMT_A8R8G8B8, "A4R4G4B4 to A8R8G8B8" },
+        { D3DFMT_X4R4G4B4, D3DFMT_X8R8G8B8, "X4R4G4B4 to X8R8G8B8" },
+        { D3DFMT_R5G6B5, D3DFMT_X8R8G8B8, "R5G6B5 to X8R8G8B8" },
+        { D3DFMT_X8R8G8B8, D3DFMT_R5G6B5, "X8R8G8B8 to R5G6B5" },
+        { D3DFMT_A1R5G5B5, D3DFMT_A8R8G8B8, "A1R5G5B5 to A8R8G8B8" },
+        { D3DFMT_X1R5G5B5, D3DFMT_X8R8G8B8, "X1R5G5B5 to X8R8G8B8" },
+        { D3DFMT_A8R8G8B8, D3DFMT_A1R5G5B5, "A8R8G8B8 to A1R5G5B5" },
+        { D3DFMT_X8R8G8B8, D3DFMT_X1R5G5B5, "X8R8G8B8 to X1R5G5B5" },
+        { D3DFMT_X8R8G8B8, D3DFMT_R8G8B8, "X8R8G8B8 to R8G8B8" },
+        { D3DFMT_X8R8G8B8, D3DFMT_B8G8R8, "X8R8G8B8 to B8G8R8" },
+        { D3DFMT_R8G8B8, D3DFMT_X8R8G8B8, "R8G8B8 to X8R8G8B8" },
+        { D3DFMT_B8G8R8, D3DFMT_X8R8G8B8, "B8G8R8 to X8R8G8B8" },
+        { D3DFMT_A8R8G8B8, D3DFMT_A8B8G8R8, "A8R8G8B8 to A8B8G8R8" },
+        { D3DFMT_A8B8G8R8, D3DFMT_A8R8G8B8, "A8B8G8R8 to A8R8G8B8" },
+        { D3DFMT_X8R8G8B8, D3DFMT_X8B8G8R8, "X8R8G8B8 to X8B8G8R8" },
+        { D3DFMT_X8B8G8R8, D3DFMT_X8R8G8B8, "X8B8G8R8 to X8R8G8B8" },
+        { D3DFMT_X1R5G5B5, D3DFMT_A8R8G8B8, "X1R5G5B5 to A8R8G8B8" },
+        { D3DFMT_X8R8G8B8, D3DFMT_A4R4G4B4, "X8R8G8B8 to A4R4G4B4" },
+    };
+
+    void TestConvertKernels(DWORD& TestID)
+    {
+        for (const auto& Entry : Conversions)
+        {
+            LOG_TEST_RESULT(TestID++, "IsPixelConversionSupported " << Entry.Name << ": ", IsPixelConversionSupported(Entry.Src, Entry.Dest), true);
+            CompareWithReference(TestID, Entry.Name, Entry.Src, Entry.Dest);
+        }
+
+        // The X bits are undefined so converting to a format with alpha must give opaque pixels
+        const struct { D3DFORMAT Src; D3DFORMAT Dest; DWORD AlphaMask; const char* Name; } OpaqueConversions[] =
+        {
+            { D3DFMT_X1R5G5B5, D3DFMT_A8R8G8B8, 0xFF000000, "X1R5G5B5 to A8R8G8B8" },
+            { D3DFMT_X8R8G8B8, D3DFMT_A4R4G4B4, 0xF000, "X8R8G8B8 to A4R4G4B4" },
+            { D3DFMT_R5G6B5, D3DFMT_A8R8G8B8, 0xFF000000, "R5G6B5 to A8R8G8B8" },
+            { D3DFMT_X8R8G8B8, D3DFMT_A1R5G5B5, 0x8000, "X8R8G8B8 to A1R5G5B5" },
+            { D3DFMT_X8R8G8B8, D3DFMT_A8B8G8R8, 0xFF000000, "X8R8G8B8 to A8B8G8R8" },
+        };
+
+        for (const auto& Entry : OpaqueConversions)
+        {
+            const DWORD DestSize = GetFormatSize(Entry.Dest);
+            const INT SrcPitch = TestWidth * GetFormatSize(Entry.Src) + TestPadding;
+            const INT DestPitch = TestWidth * DestSize + TestPadding;
+
+            std::vector<BYTE> Src(SrcPitch * TestHeight);
+            FillPattern(Src, 10);
+            std::vector<BYTE> Dest(DestPitch * TestHeight);
+
+            ConvertPixelRect(Dest.data(), DestPitch, Entry.Dest, Src.data(), SrcPitch, Entry.Src, TestWidth, TestHeight);
+
+            bool IsOpaque = true;
+            for (LONG y = 0; y < TestHeight; y++)
+            {
+                for (LONG x = 0; x < TestWidth; x++)
+                {
+                    const BYTE* Pixel = Dest.data() + y * DestPitch + x * DestSize;
+                    const DWORD Alpha = (DestSize == 4 ? *(const DWORD*)Pixel : *(const WORD*)Pixel) & Entry.AlphaMask;
+                    IsOpaque &= (Alpha == Entry.AlphaMask);
+                }
+            }
+            LOG_TEST_RESULT(TestID++, "ConvertPixelRect " << Entry.Name << " alpha is opaque: ", IsOpaque, true);
+        }
+    }
+
+    void TestPaletteKernels(DWORD& TestID)
+    {
+        std::vector<BYTE> Palette(MaxPaletteSize * sizeof(PALETTEENTRY));
+        FillPattern(Palette, 7);
+
+        const INT SrcPitch = TestWidth + TestPadding;
+        std::vector<BYTE> Src(SrcPitch * TestHeight);
+        FillPattern(Src, 8);
+
+        for (D3DFORMAT Format : { D3DFMT_X8R8G8B8, D3DFMT_R5G6B5 })
+        {
+            const INT DestPitch = TestWidth * GetFormatSize(Format) + TestPadding;
+
+            DWORD Lookup[MaxPaletteSize] = {};
+            BuildPaletteLookup(Lookup, reinterpret_cast<const PALETTEENTRY*>(Palette.data()), Format);
+
+            const char* Name = (Format == D3DFMT_R5G6B5 ? "R5G6B5" : "X8R8G8B8");
+
+            CompareWithScalar(TestID, std::string("ExpandPaletteRect ") + Name, [&](std::vector<BYTE>& Dest, BLITLEVEL Level)
+                {
+                    Dest.resize(DestPitch * TestHeight);
+                    FillPattern(Dest, 9);
+                    ExpandPaletteRect(Dest.data(), DestPitch, Format, Src.data(), SrcPitch, Lookup, TestWidth, TestHeight, Level);
+                });
+
+            // Each pixel must be the palette entry of its index
+            const DWORD DestSize = GetFormatSize(Format);
+            const DWORD Mask = GetFormatMask(Format);
+            const PALETTEENTRY* pPalette = reinterpret_cast<const PALETTEENTRY*>(Palette.data());
+            std::vector<BYTE> Dest(DestPitch * TestHeight);
+            ExpandPaletteRect(Dest.data(), DestPitch, Format, Src.data(), SrcPitch, Lookup, TestWidth, TestHeight);
+
+            bool IsMatch = true;
+            for (LONG y = 0; y < TestHeight; y++)
+            {
+                for (LONG x = 0; x < TestWidth; x++)
+                {
+                    const PALETTEENTRY& Entry = pPalette[Src[y * SrcPitch + x]];
+                    const DWORD Color = (Entry.peRed << 16) + (Entry.peGreen << 8) + Entry.peBlue;
+                    const DWORD Expected = (Format == D3DFMT_R5G6B5) ? ((Entry.peRed >> 3) << 11) + ((Entry.peGreen >> 2) << 5) + (Entry.peBlue >> 3) : Color;
+                    IsMatch &= ((ReadPixel(Dest.data() + y * DestPitch + x * DestSize, DestSize) & Mask) == Expected);
+                }
+            }
+            LOG_TEST_RESULT(TestID++, "ExpandPaletteRect " << Name << " matches Palette[index]: ", IsMatch, true);
+        }
+    }
+
+    // Logs the time to rebuild the lookup and expand a full frame, the palette changes every frame like palette cycling games
+    void BenchmarkPaletteKernels()
+    {
+        std::vector<BYTE> Palette(MaxPaletteSize * sizeof(PALETTEENTRY));
+        FillPattern(Palette, 12);
+
+        for (LONG Width : { 640, 1024 })
+        {
+            const LONG Height = Width * 3 / 4;
+            std::vector<BYTE> Src(Width * Height);
+            FillPattern(Src, 13);
+
+            for (D3DFORMAT Format : { D3DFMT_X8R8G8B8, D3DFMT_R5G6B5 })
+            {
+                const INT DestPitch = Width * GetFormatSize(Format);
+                std::vector<BYTE> Dest(DestPitch * Height);
+                DWORD Lookup[MaxPaletteSize] = {};
+
+                const double FrameTime = MeasureNanoseconds(20, [&]()
+                    {
+                        // Rotate the palette by one entry
+                        std::rotate(Palette.begin(), Palette.begin() + sizeof(PALETTEENTRY), Palette.end());
+                        BuildPaletteLookup(Lookup, reinterpret_cast<const PALETTEENTRY*>(Palette.data()), Format);
+                        ExpandPaletteRect(Dest.data(), DestPitch, Format, Src.data(), Width, Lookup, Width, Height);
+                    });
+
+                Logging::Log() << "Benchmark: ExpandPaletteRect " << Width << "x" << Height << " " << (Format == D3DFMT_R5G6B5 ? "R5G6B5" : "X8R8G8B8") <<
+                    " with palette rotation " << (FrameTime / 1000.0) << " us per frame";
+            }
+        }
+    }
+
+    // Logs the throughput of the copy and stretch kernels for each instruction set on a 640x480 frame
+    template <typename T>
+    void BenchmarkCopyKernels(T ColorKey)
+    {
+        constexpr LONG Width = 640;
+        constexpr LONG Height = 480;
+        constexpr DWORD Count = 20;
+        const INT Pitch = Width * sizeof(T);
+        const std::string Size = std::to_string(sizeof(T) * 8) + "-bit";
+
+        std::vector<BYTE> Src(Pitch * Height);
+        FillPattern(Src, 11);
+        SetColorKeyPixels<T>(Src, Pitch, Width, Height, ColorKey);
+        std::vector<BYTE> Dest(Pitch * Height);
+        std::vector<DWORD> Scratch((GetComplexCopyScratchSize(Width, sizeof(T)) + 3) / 4);
+
+        const BLITLEVEL MaxLevel = GetBlitLevel();
+
+        for (int Level = BLIT_SCALAR; Level <= MaxLevel; Level++)
+        {
+            const double CopyTime = MeasureNanoseconds(Count, [&]()
+                {
+                    SimpleColorKeyCopy<T>(ColorKey, Src.data(), Dest.data(), Pitch, Pitch, Width, Height, true, false, (BLITLEVEL)Level);
+                });
+
+            // Stretches the top left quarter of the frame to the full frame
+            const double StretchTime = MeasureNanoseconds(Count, [&]()
+                {
+                    D3DLOCKED_RECT SrcLockRect = { Pitch, Src.data() };
+                    D3DLOCKED_RECT DestLockRect = { Pitch, Dest.data() };
+                    ComplexCopy<T>(ColorKey, SrcLockRect, DestLockRect, Width / 2, Height / 2, Width, Height, (BYTE*)Scratch.data(), true, false, false, {}, 0, 0, nullptr, (BLITLEVEL)Level);
+                });
+
+            Logging::Log() << "Benchmark: " << Size << " " << GetBlitLevelName((BLITLEVEL)Level) <<
+                " SimpleColorKeyCopy " << (Width * Height * 1000.0 / CopyTime) << " Mpix/s" <<
+                ", ComplexCopy stretch " << (Width * Height * 1000.0 / StretchTime) << " Mpix/s";
+        }
+    }
+
+    // Logs the throughput of each conversion pair for each instruction set on a 640x480 frame
+    void BenchmarkConvertKernels()
+    {
+        constexpr LONG Width = 640;
+        constexpr LONG Height = 480;
+        constexpr DWORD Count = 20;
+
+        const BLITLEVEL MaxLevel = GetBlitLevel();
+
+        for (const auto& Entry : Conversions)
+        {
+            const INT SrcPitch = Width * GetFormatSize(Entry.Src);
+            const INT DestPitch = Width * GetFormatSize(Entry.Dest);
+            std::vector<BYTE> Src(SrcPitch * Height);
+            FillPattern(Src, 14);
+            std::vector<BYTE> Dest(DestPitch * Height);
+
+            for (int Level = BLIT_SCALAR; Level <= MaxLevel; Level++)
+            {
+                const double Time = MeasureNanoseconds(Count, [&]()
+                    {
+                        ConvertPixelRect(Dest.data(), DestPitch, Entry.Dest, Src.data(), SrcPitch, Entry.Src, Width, Height, (BLITLEVEL)Level);
+                    });
+
+                Logging::Log() << "Benchmark: ConvertPixelRect " << Entry.Name << " " << GetBlitLevelName((BLITLEVEL)Level) <<
+                    " " << (Width * Height * 1000.0 / Time) << " Mpix/s";
+            }
+        }
+    }
+
+    // Logs the time of a full screen one pixel scroll down and right on one 640x480 surface, moving the
+    // rows in place with OverlapCopy against the old path that staged the source in a buffer and then copied it back
+    template <typename T>
+    void BenchmarkOverlapCopy(T ColorKey)
+    {
+        constexpr LONG Width = 640;
+        constexpr LONG Height = 480;
+        constexpr DWORD Count = 20;
+        const INT Pitch = Width * sizeof(T);
+        const std::string Size = std::to_string(sizeof(T) * 8) + "-bit";
+
+        std::vector<BYTE> Buffer(Pitch * Height);
+        FillPattern(Buffer, 15);
+        std::vector<BYTE> RowBuffer(Pitch);
+        std::vector<BYTE> Staging(Pitch * Height);
+
+        const struct { LONG x; LONG y; const char* Name; } Scrolls[] = { { 0, 1, "down" }, { 1, 0, "right" } };
+        for (const auto& Scroll : Scrolls)
+        {
+            const LONG ScrollWidth = Width - Scroll.x;
+            const LONG ScrollHeight = Height - Scroll.y;
+            BYTE* SrcBuffer = Buffer.data();
+            BYTE* DestBuffer = Buffer.data() + Scroll.y * Pitch + Scroll.x * sizeof(T);
+
+            const double InPlaceTime = MeasureNanoseconds(Count, [&]()
+                {
+                    OverlapCopy<T>(ColorKey, SrcBuffer, DestBuffer, Pitch, ScrollWidth, ScrollHeight, Scroll.y, RowBuffer.data(), false, false);
+                });
+            const double StagedTime = MeasureNanoseconds(Count, [&]()
+                {
+                    const INT StagingPitch = ScrollWidth * sizeof(T);
+                    for (LONG y = 0; y < ScrollHeight; y++)
+                    {
+                        memcpy(Staging.data() + y * StagingPitch, SrcBuffer + y * Pitch, StagingPitch);
+                    }
+                    SimpleColorKeyCopy<T>(ColorKey, Staging.data(), DestBuffer, StagingPitch, Pitch, ScrollWidth, ScrollHeight, false, false);
+                });
+
+            Logging::Log() << "Benchmark: " << Size << " scroll " << Scroll.Name << " OverlapCopy " << (InPlaceTime / 1000.0) <<
+                " us, staged copy " << (StagedTime / 1000.0) << " us per frame";
+        }
+    }
+
+    void TestRowCompare(DWORD& TestID)
+    {
+        const size_t Size = 201;
+        std::vector<BYTE> Row1(Size);
+        FillPattern(Row1, 10);
+
+        // Equal rows, then one byte changed at the start, middle and end of the row
+        for (size_t Changed : { Size, (size_t)0, (size_t)100, Size - 1 })
+        {
+            std::vector<BYTE> Row2 = Row1;
+            if (Changed < Size)
+            {
+                Row2[Changed] ^= 0x10;
+            }
+
+            LOG_TEST_RESULT(TestID++, "IsRowEqual changed byte " << Changed << ": ", IsRowEqual(Row1.data(), Row2.data(), Size), (Changed == Size));
+        }
+    }
+}
+
+void TestSurfaceBlitter()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing SurfaceBlitter";
+    Logging::Log() << "****";
+
+    DWORD TestID = 5000;
+
+    TestCopyKernels<BYTE>(TestID, 0x5A);
+    TestCopyKernels<WORD>(TestID, 0x7C1F);
+    TestCopyKernels<TRIBYTE>(TestID, TRIBYTE(0x00FF00FF));
+    TestCopyKernels<DWORD>(TestID, 0x00FF00FF);
+
+    TestStretchKernels<BYTE>(TestID, 0x5A);
+    TestStretchKernels<WORD>(TestID, 0x7C1F);
+    TestStretchKernels<TRIBYTE>(TestID, TRIBYTE(0x00FF00FF));
+    TestStretchKernels<DWORD>(TestID, 0x00FF00FF);
+
+    // Long stretch that drifted with a truncated 16.16 step
+    {
+        std::vector<DWORD> Src(320);
+        for (DWORD x = 0; x < Src.size(); x++)
+        {
+            Src[x] = x;
+        }
+        std::vector<DWORD> Dest(960);
+        std::vector<DWORD> Scratch((GetComplexCopyScratchSize((LONG)Dest.size(), sizeof(DWORD)) + 3) / 4);
+        D3DLOCKED_RECT SrcLockRect = { (INT)(Src.size() * sizeof(DWORD)), Src.data() };
+        D3DLOCKED_RECT DestLockRect = { (INT)(Dest.size() * sizeof(DWORD)), Dest.data() };
+        ComplexCopy<DWORD>(0, SrcLockRect, DestLockRect, (LONG)Src.size(), 1, (LONG)Dest.size(), 1, (BYTE*)Scratch.data(), false, false, false);
+        LOG_TEST_RESULT(TestID++, "ComplexCopy 320 to 960 source column for x=3: ", Dest[3], 1);
+        LOG_TEST_RESULT(TestID++, "ComplexCopy 320 to 960 source column for x=959: ", Dest[959], 319);
+    }
+
+    TestConvertKernels(TestID);
+    TestPaletteKernels(TestID);
+    TestRowCompare(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkCopyKernels<BYTE>(0x5A);
+        BenchmarkCopyKernels<WORD>(0x7C1F);
+        BenchmarkCopyKernels<TRIBYTE>(TRIBYTE(0x00FF00FF));
+        BenchmarkCopyKernels<DWORD>(0x00FF00FF);
+        BenchmarkOverlapCopy<WORD>(0x7C1F);
+        BenchmarkOverlapCopy<DWORD>(0x00FF00FF);
+        BenchmarkConvertKernels();
+        BenchmarkPaletteKernels();
+    }
+}
@@ -0,0 +1,290 @@
+#include "Utils\ThreadMonitor.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <map>
+#include <algorithm>
+
+namespace {
+    // Threads of a fake process. A thread id can be reused, each start is a new thread object and
+    // a handle keeps referring to the thread it was opened for.
+    class MockThreads
+    {
+    private:
+        struct THREADOBJECT
+        {
+            bool Running = true;
+            bool Boosted = false;
+            DWORD Checks = 0;
+        };
+
+        std::vector<THREADOBJECT> Objects;
+        std::map<DWORD, size_t> Current;            // Thread id to its latest thread object
+        std::map<HANDLE, size_t> Handles;           // Open handles to their thread object
+        ULONG_PTR NextHandle = 0x100;
+
+    public:
+        DWORD Opens = 0;
+        DWORD Closes = 0;
+        DWORD BadCloses = 0;
+
+        void Start(DWORD threadId)
+        {
+            Objects.push_back(THREADOBJECT());
+            Current[threadId] = Objects.size() - 1;
+        }
+        void Exit(DWORD threadId) { Objects[Current[threadId]].Running = false; }
+        void Boost(DWORD threadId) { Objects[Current[threadId]].Boosted = true; }
+        DWORD GetChecks(DWORD threadId) { return Objects[Current[threadId]].Checks; }
+        size_t GetOpenHandles() const { return Handles.size(); }
+
+        // Calls made by ThreadMonitor
+        HANDLE OpenThread(DWORD threadId)
+        {
+            auto it = Current.find(threadId);
+            if (it == Current.end() || !Objects[it->second].Running)
+            {
+                return nullptr;
+            }
+            HANDLE hThread = (HANDLE)NextHandle;
+            NextHandle += 4;
+            Handles[hThread] = it->second;
+            Opens++;
+            return hThread;
+        }
+        bool IsRunning(HANDLE hThread) { return Objects[Handles.at(hThread)].Running; }
+        bool FixPriority(HANDLE hThread)
+        {
+            THREADOBJECT& Thread = Objects[Handles.at(hThread)];
+            Thread.Checks++;
+            const bool WasBoosted = Thread.Boosted;
+            Thread.Boosted = false;
+            return WasBoosted;
+        }
+        void CloseThread(HANDLE hThread)
+        {
+            if (Handles.erase(hThread))
+            {
+                Closes++;
+            }
+            else
+            {
+                BadCloses++;
+            }
+        }
+    };
+
+    typedef Utils::ThreadMonitor<MockThreads> MONITOR;
+
+    // Runs the monitor from one due time to the next and records the waits until Until
+    std::vector<DWORD> RunSchedule(MONITOR& Monitor, DWORD& Now, DWORD Until)
+    {
+        std::vector<DWORD> Waits;
+        while ((LONG)(Until - Now) > 0)
+        {
+            const DWORD Timeout = Monitor.CheckDue(Now);
+            if (Timeout == INFINITE)
+            {
+                break;
+            }
+            Waits.push_back(Timeout);
+            Now += Timeout;
+        }
+        return Waits;
+    }
+
+    void TestSchedule(DWORD& TestID)
+    {
+        const std::vector<DWORD> Backoff = { 10, 20, 40, 80, 160, 320, 640, 1000, 1000, 1000 };
+
+        // Checked when added, then the interval doubles from 10ms up to 1s while the priority is stable
+        {
+            MockThreads Threads;
+            MONITOR Monitor(Threads);
+            Threads.Start(1);
+            DWORD Now = 5000;
+            Monitor.Add(1, Now);
+            const std::vector<DWORD> Waits = RunSchedule(Monitor, Now, 5000 + 4270);
+            LOG_TEST_RESULT(TestID++, "Checks back off from 10ms to 1s: ", (Waits == Backoff), true);
+            LOG_TEST_RESULT(TestID++, "Thread is checked once per due time: ", Threads.GetChecks(1), Backoff.size());
+
+            // A boosted thread is fixed and checked again soon
+            Threads.Boost(1);
+            const std::vector<DWORD> BoostWaits = RunSchedule(Monitor, Now, Now + 4270);
+            LOG_TEST_RESULT(TestID++, "Fixed priority restarts the backoff: ", (BoostWaits == Backoff), true);
+        }
+
+        // Back off across the tick count wrap
+        {
+            MockThreads Threads;
+            MONITOR Monitor(Threads);
+            Threads.Start(1);
+            DWORD Now = 0xFFFFFF00;
+            Monitor.Add(1, Now);
+            const std::vector<DWORD> Waits = RunSchedule(Monitor, Now, 0xFFFFFF00 + 4270);
+            LOG_TEST_RESULT(TestID++, "Backoff across the tick count wrap: ", (Waits == Backoff), true);
+
+            // Due time after the wrap is not due before it
+            Threads.Start(2);
+            Monitor.Add(2, 0xFFFFFFF8);
+            Monitor.CheckDue(0xFFFFFFF8);
+            const DWORD Timeout = Monitor.CheckDue(0xFFFFFFFC);
+            LOG_TEST_RESULT(TestID++, "Thread due after the wrap is not checked before it: ", (Threads.GetChecks(2) == 1 && Timeout == 6), true);
+        }
+
+        // Threads are only checked when due and the wait is for the thread due first
+        {
+            MockThreads Threads;
+            MONITOR Monitor(Threads);
+            Threads.Start(1);
+            Threads.Start(2);
+            Monitor.Add(1, 0);
+            Monitor.CheckDue(0);
+            Monitor.CheckDue(10);
+            Monitor.CheckDue(30);
+            Monitor.Add(2, 35);
+            const DWORD Timeout = Monitor.CheckDue(35);
+            LOG_TEST_RESULT(TestID++, "Wait is for the thread due first: ", Timeout, 10);
+            LOG_TEST_RESULT(TestID++, "Thread not due is not checked: ", (Threads.GetChecks(1) == 3 && Threads.GetChecks(2) == 1), true);
+
+            MONITOR Empty(Threads);
+            const DWORD EmptyTimeout = Empty.CheckDue(0);
+            LOG_TEST_RESULT(TestID++, "Empty monitor waits forever: ", (EmptyTimeout == INFINITE), true);
+        }
+    }
+
+    void TestRegistry(DWORD& TestID)
+    {
+        MockThreads Threads;
+        {
+            MONITOR Monitor(Threads);
+
+            // Same thread queued twice, from DLL_THREAD_ATTACH and from CreateThread
+            Threads.Start(1);
+            Monitor.Add(1, 0);
+            Monitor.Add(1, 0);
+            LOG_TEST_RESULT(TestID++, "Thread added twice is monitored once: ", (Monitor.GetThreads().size() == 1 && Threads.Opens == 1), true);
+
+            // Threads that exit before they are added are skipped
+            Threads.Start(2);
+            Threads.Exit(2);
+            Monitor.Add(2, 0);
+            LOG_TEST_RESULT(TestID++, "Exited thread is not added: ", Monitor.GetThreads().size(), 1);
+
+            // An exited thread is dropped when it is next due
+            Threads.Start(3);
+            Monitor.Add(3, 0);
+            Monitor.CheckDue(0);
+            Threads.Exit(3);
+            Monitor.CheckDue(5);
+            const size_t CountBeforeDue = Monitor.GetThreads().size();
+            Monitor.CheckDue(10);
+            LOG_TEST_RESULT(TestID++, "Exited thread is kept until it is due: ", CountBeforeDue, 2);
+            LOG_TEST_RESULT(TestID++, "Exited thread is dropped when due: ", (Monitor.GetThreads().size() == 1 && Monitor.GetThreads()[0].threadId == 1), true);
+            LOG_TEST_RESULT(TestID++, "Dropped thread handle is closed: ", Threads.GetOpenHandles(), 1);
+
+            // A new thread that reuses the id of an exited thread replaces it before the old one is due
+            Monitor.CheckDue(30);
+            Monitor.CheckDue(70);
+            Threads.Exit(1);
+            Threads.Start(1);
+            Monitor.Add(1, 75);
+            const DWORD Timeout = Monitor.CheckDue(75);
+            LOG_TEST_RESULT(TestID++, "Reused id replaces the exited thread: ", (Monitor.GetThreads().size() == 1 && Threads.Opens == 3 && Threads.Closes == 2), true);
+            LOG_TEST_RESULT(TestID++, "New thread starts the backoff again: ", (Threads.GetChecks(1) == 1 && Timeout == 10), true);
+        }
+
+        LOG_TEST_RESULT(TestID++, "Every handle is closed once: ", (Threads.GetOpenHandles() == 0 && Threads.Opens == Threads.Closes && Threads.BadCloses == 0), true);
+    }
+
+    // Logs the time the monitor spends over 10 simulated seconds for 50 and 500 threads, with one thread
+    // boosted every 100ms, against the old pass that opened and checked every thread every 10ms
+    void BenchmarkThreadMonitor()
+    {
+        constexpr DWORD SimulatedTime = 10000;
+        constexpr DWORD BoostInterval = 100;
+        constexpr DWORD PollInterval = 10;
+
+        for (const DWORD ThreadCount : { 50u, 500u })
+        {
+            DWORD MonitorChecks = 0;
+            const double MonitorTime = MeasureNanoseconds(1, [&]()
+                {
+                    MockThreads Threads;
+                    MONITOR Monitor(Threads);
+                    DWORD Now = 0;
+                    for (DWORD x = 1; x <= ThreadCount; x++)
+                    {
+                        Threads.Start(x);
+                        Monitor.Add(x, Now);
+                    }
+                    DWORD NextBoost = BoostInterval;
+                    while (Now < SimulatedTime)
+                    {
+                        const DWORD Timeout = Monitor.CheckDue(Now);
+                        if (Now >= NextBoost)
+                        {
+                            Threads.Boost(NextBoost / BoostInterval % ThreadCount + 1);
+                            NextBoost += BoostInterval;
+                        }
+                        Now += (std::min)(Timeout, NextBoost - Now);
+                    }
+                    MonitorChecks = 0;
+                    for (DWORD x = 1; x <= ThreadCount; x++)
+                    {
+                        MonitorChecks += Threads.GetChecks(x);
+                    }
+                });
+
+            DWORD PollChecks = 0;
+            const double PollTime = MeasureNanoseconds(1, [&]()
+                {
+                    MockThreads Threads;
+                    for (DWORD x = 1; x <= ThreadCount; x++)
+                    {
+                        Threads.Start(x);
+                    }
+                    for (DWORD Now = 0; Now < SimulatedTime; Now += PollInterval)
+                    {
+                        if (Now && Now % BoostInterval == 0)
+                        {
+                            Threads.Boost(Now / BoostInterval % ThreadCount + 1);
+                        }
+                        for (DWORD x = 1; x <= ThreadCount; x++)
+                        {
+                            HANDLE hThread = Threads.OpenThread(x);
+                            Threads.FixPriority(hThread);
+                            Threads.CloseThread(hThread);
+                        }
+                    }
+                    PollChecks = 0;
+                    for (DWORD x = 1; x <= ThreadCount; x++)
+                    {
+                        PollChecks += Threads.GetChecks(x);
+                    }
+                });
+
+            Logging::Log() << "Benchmark: ThreadMonitor " << ThreadCount << " threads, monitor " << (MonitorTime / 1000.0 / (SimulatedTime / 1000)) << " us and " <<
+                (MonitorChecks / (SimulatedTime / 1000)) << " checks, polling every 10ms " << (PollTime / 1000.0 / (SimulatedTime / 1000)) << " us and " <<
+                (PollChecks / (SimulatedTime / 1000)) << " checks per simulated second";
+        }
+    }
+}
+
+void TestThreadMonitor()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing ThreadMonitor";
+    Logging::Log() << "****";
+
+    DWORD TestID = 14500;
+
+    TestSchedule(TestID);
+    TestRegistry(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkThreadMonitor();
+    }
+}
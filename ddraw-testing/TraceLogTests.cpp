@@ -0,0 +1,245 @@
+#include "Logging\Logging.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <memory>
+
+namespace {
+    using namespace Logging::Trace;
+
+    constexpr DWORD SmallRingSize = 8;
+    constexpr DWORD StressRingSize = 256;
+    constexpr LONG ProducerCount = 4;
+    constexpr DWORD PushesPerProducer = 50000;
+    constexpr DWORD TestTimeoutMS = 30000;
+
+    const char* const TraceFunction = "TraceLogTests";
+
+    // Every argument is derived from the producer and its sequence so a record mixing two writes is caught
+    ULONG_PTR GetArg(ULONG_PTR Producer, ULONG_PTR Sequence, DWORD Arg)
+    {
+        return (Producer << 24) ^ (Sequence * 2654435761u) ^ (Arg * 0x01010101u);
+    }
+
+    TRACERECORD MakeRecord(ULONG_PTR Producer, ULONG_PTR Sequence)
+    {
+        TRACERECORD Record;
+        Record.Time = (LONGLONG)Sequence;
+        Record.Function = TraceFunction;
+        Record.ThreadId = (DWORD)Producer;
+        Record.ArgCount = MaxArgs;
+        Record.Args[0] = Producer;
+        Record.Args[1] = Sequence;
+        for (DWORD x = 2; x < MaxArgs; x++)
+        {
+            Record.Args[x] = GetArg(Producer, Sequence, x);
+        }
+        return Record;
+    }
+
+    bool IsRecordIntact(const TRACERECORD& Record)
+    {
+        const ULONG_PTR Producer = Record.Args[0];
+        const ULONG_PTR Sequence = Record.Args[1];
+        bool IsIntact = Record.Function == TraceFunction && Record.ArgCount == MaxArgs &&
+            Record.ThreadId == (DWORD)Producer && Record.Time == (LONGLONG)Sequence;
+        for (DWORD x = 2; x < MaxArgs; x++)
+        {
+            IsIntact = IsIntact && Record.Args[x] == GetArg(Producer, Sequence, x);
+        }
+        return IsIntact;
+    }
+
+    void TestRingOrder(DWORD& TestID)
+    {
+        std::unique_ptr<TraceRing<SmallRingSize>> Ring(new TraceRing<SmallRingSize>);
+
+        Ring->Push(MakeRecord(1, 0));
+        Ring->Push(MakeRecord(1, 1));
+        Ring->Push(MakeRecord(1, 2));
+        ULONG_PTR Expected = 0;
+        bool IsInOrder = true;
+        const DWORD Count = Ring->Drain([&](const TRACERECORD& Record) { IsInOrder = IsInOrder && IsRecordIntact(Record) && Record.Args[1] == Expected++; });
+        LOG_TEST_RESULT(TestID++, "Drain outputs every pushed record: ", Count, 3);
+        LOG_TEST_RESULT(TestID++, "Records are output intact and in order: ", IsInOrder, true);
+        const DWORD SecondCount = Ring->Drain([](const TRACERECORD&) {});
+        LOG_TEST_RESULT(TestID++, "Second drain finds nothing: ", SecondCount, 0);
+
+        // A full ring drops new records instead of overwriting ones the reader has not seen
+        DWORD Pushed = 0;
+        for (DWORD x = 0; x < SmallRingSize + 2; x++)
+        {
+            Pushed += Ring->Push(MakeRecord(2, x)) ? 1 : 0;
+        }
+        LOG_TEST_RESULT(TestID++, "Full ring accepts one record per slot: ", Pushed, SmallRingSize);
+        const DWORD Dropped = Ring->GetDropped();
+        const DWORD DroppedAgain = Ring->GetDropped();
+        LOG_TEST_RESULT(TestID++, "Records pushed to a full ring are counted as dropped: ", Dropped, 2);
+        LOG_TEST_RESULT(TestID++, "Dropped count is reset once read: ", DroppedAgain, 0);
+
+        Expected = 0;
+        IsInOrder = true;
+        Ring->Drain([&](const TRACERECORD& Record) { IsInOrder = IsInOrder && IsRecordIntact(Record) && Record.Args[1] == Expected++; });
+        LOG_TEST_RESULT(TestID++, "Full ring keeps the oldest records: ", (IsInOrder && Expected == SmallRingSize), true);
+
+        // Slots freed by the reader are reused on every lap
+        bool IsReused = true;
+        for (ULONG_PTR Lap = 0; Lap < 5; Lap++)
+        {
+            for (DWORD x = 0; x < SmallRingSize; x++)
+            {
+                IsReused = IsReused && Ring->Push(MakeRecord(3, Lap * SmallRingSize + x));
+            }
+            Expected = Lap * SmallRingSize;
+            IsReused = IsReused && Ring->Drain([&](const TRACERECORD& Record) { IsInOrder = IsInOrder && IsRecordIntact(Record) && Record.Args[1] == Expected++; }) == SmallRingSize;
+        }
+        LOG_TEST_RESULT(TestID++, "Freed slots are reused on later laps: ", (IsReused && IsInOrder), true);
+    }
+
+    struct STRESSDATA
+    {
+        TraceRing<StressRingSize> Ring;
+        volatile LONG ProducersDone = 0;
+        volatile LONG Pushed[ProducerCount] = {};
+        volatile LONG ProducerIndex = 0;
+    };
+
+    struct DRAINRESULT
+    {
+        LONG Count = 0;
+        bool IsIntact = true;
+        bool IsInOrder = true;
+        ULONG_PTR NextSequence[ProducerCount] = {};
+    };
+
+    DWORD WINAPI TraceProducerThread(LPVOID lpParam)
+    {
+        STRESSDATA& Data = *reinterpret_cast<STRESSDATA*>(lpParam);
+        const LONG Producer = InterlockedExchangeAdd(&Data.ProducerIndex, 1);
+        LONG Pushed = 0;
+        for (DWORD x = 0; x < PushesPerProducer; x++)
+        {
+            Pushed += Data.Ring.Push(MakeRecord(Producer, x)) ? 1 : 0;
+            if ((x & 63) == 0)
+            {
+                Sleep(0);
+            }
+        }
+        InterlockedExchangeAdd(&Data.Pushed[Producer], Pushed);
+        InterlockedExchangeAdd(&Data.ProducersDone, 1);
+        return 0;
+    }
+
+    void DrainStress(STRESSDATA& Data, DRAINRESULT& Drained)
+    {
+        Data.Ring.Drain([&](const TRACERECORD& Record)
+            {
+                Drained.Count++;
+                if (!IsRecordIntact(Record) || Record.Args[0] >= ProducerCount)
+                {
+                    Drained.IsIntact = false;
+                    return;
+                }
+                // Dropped records leave gaps but each producer's records must stay in order
+                ULONG_PTR& Next = Drained.NextSequence[Record.Args[0]];
+                Drained.IsInOrder = Drained.IsInOrder && Record.Args[1] >= Next;
+                Next = Record.Args[1] + 1;
+            });
+    }
+
+    void TestRingStress(DWORD& TestID)
+    {
+        std::unique_ptr<STRESSDATA> Data(new STRESSDATA);
+        DRAINRESULT Drained;
+
+        HANDLE hProducers[ProducerCount] = {};
+        for (LONG x = 0; x < ProducerCount; x++)
+        {
+            hProducers[x] = CreateThread(nullptr, 0, TraceProducerThread, Data.get(), 0, nullptr);
+        }
+
+        // Drain on this thread like the trace thread while the producers run
+        const DWORD StartTime = GetTickCount();
+        while (InterlockedExchangeAdd(&Data->ProducersDone, 0) != ProducerCount && GetTickCount() - StartTime < TestTimeoutMS)
+        {
+            DrainStress(*Data, Drained);
+        }
+        WaitForMultipleObjects(ProducerCount, hProducers, TRUE, TestTimeoutMS);
+        DrainStress(*Data, Drained);
+
+        LONG Pushed = 0;
+        for (LONG x = 0; x < ProducerCount; x++)
+        {
+            Pushed += Data->Pushed[x];
+            CloseHandle(hProducers[x]);
+        }
+        const LONG Dropped = (LONG)Data->Ring.GetDropped();
+
+        LOG_TEST_RESULT(TestID++, "Concurrent records are never torn: ", Drained.IsIntact, true);
+        LOG_TEST_RESULT(TestID++, "Each producer's records stay in order: ", Drained.IsInOrder, true);
+        LOG_TEST_RESULT(TestID++, "Every accepted record is drained once: ", Drained.Count, Pushed);
+        LOG_TEST_RESULT(TestID++, "Accepted and dropped records add up to all pushes: ", Pushed + Dropped, ProducerCount * (LONG)PushesPerProducer);
+
+        Logging::Log() << "Benchmark: TraceRing stress " << Drained.Count << " records drained, " << Dropped << " dropped with " << ProducerCount << " writers";
+    }
+
+    DWORD WINAPI TraceDrainThread(LPVOID lpParam)
+    {
+        STRESSDATA& Data = *reinterpret_cast<STRESSDATA*>(lpParam);
+        while (!InterlockedExchangeAdd(&Data.ProducersDone, 0))
+        {
+            Data.Ring.Drain([](const TRACERECORD&) {});
+            Sleep(0);
+        }
+        return 0;
+    }
+
+    // Logs the cost of a trace site with tracing off and on
+    void BenchmarkTraceSite()
+    {
+        constexpr DWORD Count = 1000000;
+        std::unique_ptr<STRESSDATA> Data(new STRESSDATA);
+        DWORD Value = 0;
+
+        const bool WasEnabled = Enabled.load();
+        Enabled.store(false);
+        const double DisabledTime = MeasureNanoseconds(Count, [&]()
+            {
+                Value++;
+                LOG_TRACE(&Value, Value, Count);
+            });
+
+        // Same site with a reader draining the ring like the trace thread
+        HANDLE hThread = CreateThread(nullptr, 0, TraceDrainThread, Data.get(), 0, nullptr);
+        Enabled.store(true);
+        const double EnabledTime = MeasureNanoseconds(Count, [&]()
+            {
+                Value++;
+                if (!Enabled.load(std::memory_order_relaxed)) {} else WriteArgs(Data->Ring, __FUNCTION__, &Value, Value, Count);
+            });
+        Enabled.store(WasEnabled);
+        InterlockedExchangeAdd(&Data->ProducersDone, 1);
+        WaitForSingleObject(hThread, TestTimeoutMS);
+        CloseHandle(hThread);
+
+        Logging::Log() << "Benchmark: trace site " << DisabledTime << " ns disabled, " << EnabledTime << " ns enabled, " <<
+            Data->Ring.GetDropped() << " of " << Count << " records dropped";
+    }
+}
+
+void TestTraceLog()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing TraceLog";
+    Logging::Log() << "****";
+
+    DWORD TestID = 11000;
+
+    TestRingOrder(TestID);
+    TestRingStress(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkTraceSite();
+    }
+}
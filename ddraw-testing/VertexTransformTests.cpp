@@ -0,0 +1,449 @@
+// Included first so the Direct3D 9 types are used the same way as in the wrapper
+#include "ddraw\VertexTransform.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+    constexpr UINT SrcStride = 28;      // Position followed by a normal and a color, like D3DVERTEX without texture coordinates
+    constexpr UINT DestStride = 32;     // Screen position followed by data the transform must not touch
+    constexpr BYTE DestSentinel = 0xCD;
+
+    DWORD NextRandom(DWORD& Seed)
+    {
+        Seed = Seed * 214013 + 2531011;
+        return Seed >> 16;
+    }
+
+    float RandomFloat(DWORD& Seed, float Range)
+    {
+        return ((float)NextRandom(Seed) / 32767.0f * 2.0f - 1.0f) * Range;
+    }
+
+    bool IsClose(float Value, float Expected, float Tolerance)
+    {
+        return fabsf(Value - Expected) <= Tolerance * (std::max)(1.0f, fabsf(Expected));
+    }
+
+    // Perspective matrix with a translation so w depends on z and x, y and z on every input
+    D3DMATRIX GetTestMatrix()
+    {
+        D3DMATRIX Matrix = {};
+        Matrix._11 = 1.2f;  Matrix._12 = 0.1f;  Matrix._13 = -0.2f;
+        Matrix._21 = -0.3f; Matrix._22 = 1.6f;  Matrix._23 = 0.05f;
+        Matrix._31 = 0.25f; Matrix._32 = -0.4f; Matrix._33 = 1.01f; Matrix._34 = 1.0f;
+        Matrix._41 = 0.5f;  Matrix._42 = -1.5f; Matrix._43 = -0.1f;
+        return Matrix;
+    }
+
+    // Scalar transform the batched kernel has to match
+    void TransformPositionReference(const D3DMATRIX& Matrix, const float* pSrc, float* pDest, D3DXVECTOR4& Homogeneous)
+    {
+        const float x = pSrc[0], y = pSrc[1], z = pSrc[2];
+
+        Homogeneous.x = x * Matrix._11 + y * Matrix._21 + z * Matrix._31 + Matrix._41;
+        Homogeneous.y = x * Matrix._12 + y * Matrix._22 + z * Matrix._32 + Matrix._42;
+        Homogeneous.z = x * Matrix._13 + y * Matrix._23 + z * Matrix._33 + Matrix._43;
+        Homogeneous.w = x * Matrix._14 + y * Matrix._24 + z * Matrix._34 + Matrix._44;
+
+        const float rhw = (Homogeneous.w != 0.0f) ? (1.0f / Homogeneous.w) : 0.0f;
+
+        pDest[0] = Homogeneous.x * rhw;
+        pDest[1] = Homogeneous.y * rhw;
+        pDest[2] = Homogeneous.z * rhw;
+        pDest[3] = rhw;
+    }
+
+    void TransformNormalReference(const D3DMATRIX& Matrix, const float* pSrc, D3DXVECTOR3& Dest)
+    {
+        const float x = pSrc[0], y = pSrc[1], z = pSrc[2];
+
+        Dest.x = x * Matrix._11 + y * Matrix._21 + z * Matrix._31;
+        Dest.y = x * Matrix._12 + y * Matrix._22 + z * Matrix._32;
+        Dest.z = x * Matrix._13 + y * Matrix._23 + z * Matrix._33;
+
+        const float Length = sqrtf(Dest.x * Dest.x + Dest.y * Dest.y + Dest.z * Dest.z);
+        if (x * x + y * y + z * z > 1e-12f && Length > 0.0f)
+        {
+            Dest.x /= Length;
+            Dest.y /= Length;
+            Dest.z /= Length;
+        }
+    }
+
+    // Source vertices with random positions and normals, some placed at z = 0 so w is zero
+    std::vector<BYTE> BuildSourceVertices(DWORD Count, DWORD& Seed)
+    {
+        std::vector<BYTE> Src(Count * SrcStride);
+        for (DWORD i = 0; i < Count; i++)
+        {
+            float* pVertex = (float*)(Src.data() + i * SrcStride);
+            for (int j = 0; j < 6; j++)
+            {
+                pVertex[j] = RandomFloat(Seed, 10.0f);
+            }
+            if (i % 5 == 2)
+            {
+                pVertex[2] = 0.0f;
+            }
+            if (i % 7 == 3)
+            {
+                pVertex[3] = pVertex[4] = pVertex[5] = 0.0f;
+            }
+        }
+        return Src;
+    }
+
+    void TestTransformPositions(DWORD& TestID)
+    {
+        const D3DMATRIX Matrix = GetTestMatrix();
+        DWORD Seed = 3;
+
+        // Counts cover whole batches of four, a scalar tail and a tail alone
+        for (DWORD Count : { 3, 4, 7, 65 })
+        {
+            const std::vector<BYTE> Src = BuildSourceVertices(Count, Seed);
+            std::vector<BYTE> Dest(Count * DestStride, DestSentinel);
+            std::vector<D3DXVECTOR4> Homogeneous(Count);
+            TransformPositions(Matrix, Src.data(), SrcStride, Dest.data(), DestStride, Homogeneous.data(), Count);
+
+            bool IsMatching = true;
+            bool IsZeroWHandled = true;
+            bool IsRestUntouched = true;
+            for (DWORD i = 0; i < Count; i++)
+            {
+                float Expected[4];
+                D3DXVECTOR4 ExpectedHomogeneous;
+                TransformPositionReference(Matrix, (const float*)(Src.data() + i * SrcStride), Expected, ExpectedHomogeneous);
+
+                const float* pDest = (const float*)(Dest.data() + i * DestStride);
+                for (int j = 0; j < 4; j++)
+                {
+                    IsMatching = IsMatching && IsClose(pDest[j], Expected[j], 1e-6f);
+                }
+                IsMatching = IsMatching &&
+                    IsClose(Homogeneous[i].x, ExpectedHomogeneous.x, 1e-6f) && IsClose(Homogeneous[i].y, ExpectedHomogeneous.y, 1e-6f) &&
+                    IsClose(Homogeneous[i].z, ExpectedHomogeneous.z, 1e-6f) && IsClose(Homogeneous[i].w, ExpectedHomogeneous.w, 1e-6f);
+
+                if (ExpectedHomogeneous.w == 0.0f)
+                {
+                    IsZeroWHandled = IsZeroWHandled && pDest[0] == 0.0f && pDest[1] == 0.0f && pDest[2] == 0.0f && pDest[3] == 0.0f;
+                }
+                for (UINT j = 4 * sizeof(float); j < DestStride; j++)
+                {
+                    IsRestUntouched = IsRestUntouched && Dest[i * DestStride + j] == DestSentinel;
+                }
+            }
+            LOG_TEST_RESULT(TestID++, "TransformPositions " << Count << " vertices matches the scalar transform: ", IsMatching, true);
+            LOG_TEST_RESULT(TestID++, "TransformPositions " << Count << " vertices gives zero rhw when w is zero: ", IsZeroWHandled, true);
+            LOG_TEST_RESULT(TestID++, "TransformPositions " << Count << " vertices leaves the rest of each vertex as is: ", IsRestUntouched, true);
+
+            // Without homogeneous output the screen positions must be the same
+            std::vector<BYTE> DestNoHomogeneous(Count * DestStride, DestSentinel);
+            TransformPositions(Matrix, Src.data(), SrcStride, DestNoHomogeneous.data(), DestStride, nullptr, Count);
+            LOG_TEST_RESULT(TestID++, "TransformPositions " << Count << " vertices without homogeneous output gives the same positions: ", (DestNoHomogeneous == Dest), true);
+        }
+    }
+
+    void TestTransformNormals(DWORD& TestID)
+    {
+        const D3DMATRIX Matrix = GetTestMatrix();
+        DWORD Seed = 5;
+
+        for (DWORD Count : { 3, 4, 7, 65 })
+        {
+            // Normals start after the position
+            const std::vector<BYTE> Src = BuildSourceVertices(Count, Seed);
+            std::vector<D3DXVECTOR3> Normals(Count);
+            TransformNormals(Matrix, Src.data() + 3 * sizeof(float), SrcStride, Normals.data(), Count);
+
+            bool IsMatching = true;
+            bool IsZeroKept = true;
+            for (DWORD i = 0; i < Count; i++)
+            {
+                const float* pSrc = (const float*)(Src.data() + i * SrcStride + 3 * sizeof(float));
+                D3DXVECTOR3 Expected;
+                TransformNormalReference(Matrix, pSrc, Expected);
+
+                IsMatching = IsMatching && IsClose(Normals[i].x, Expected.x, 1e-6f) && IsClose(Normals[i].y, Expected.y, 1e-6f) && IsClose(Normals[i].z, Expected.z, 1e-6f);
+
+                if (pSrc[0] == 0.0f && pSrc[1] == 0.0f && pSrc[2] == 0.0f)
+                {
+                    IsZeroKept = IsZeroKept && Normals[i].x == 0.0f && Normals[i].y == 0.0f && Normals[i].z == 0.0f;
+                }
+            }
+            LOG_TEST_RESULT(TestID++, "TransformNormals " << Count << " normals matches the scalar transform: ", IsMatching, true);
+            LOG_TEST_RESULT(TestID++, "TransformNormals " << Count << " normals keeps zero length normals: ", IsZeroKept, true);
+        }
+    }
+
+    void TestFastPow(DWORD& TestID)
+    {
+        // Bases and exponents used by specular lighting, where both are positive and the result is in range
+        float MaxError = 0.0f;
+        for (float Base = 1e-4f; Base < 1e4f; Base *= 1.37f)
+        {
+            for (float Exponent : { 0.25f, 0.5f, 1.0f, 1.5f, 2.0f, 3.7f, 8.0f, 10.0f, 16.0f, 32.0f, 64.0f, 100.0f, 128.0f })
+            {
+                const float Expected = powf(Base, Exponent);
+                if (Expected < 1e-30f || Expected > 1e30f)
+                {
+                    continue;
+                }
+                MaxError = (std::max)(MaxError, fabsf(FastPow(Base, Exponent) - Expected) / Expected);
+            }
+        }
+        Logging::Log() << "FastPow largest relative error against powf " << MaxError;
+        LOG_TEST_RESULT(TestID++, "FastPow matches powf within a relative error of 1e-5: ", (MaxError < 1e-5f), true);
+
+        // Edge cases
+        LOG_TEST_RESULT(TestID++, "FastPow zero exponent gives one: ", (FastPow(5.0f, 0.0f) == 1.0f), true);
+        LOG_TEST_RESULT(TestID++, "FastPow zero base with zero exponent gives one: ", (FastPow(0.0f, 0.0f) == 1.0f), true);
+        LOG_TEST_RESULT(TestID++, "FastPow negative base with zero exponent gives one: ", (FastPow(-2.0f, 0.0f) == 1.0f), true);
+        LOG_TEST_RESULT(TestID++, "FastPow zero base gives zero: ", (FastPow(0.0f, 2.0f) == 0.0f), true);
+        LOG_TEST_RESULT(TestID++, "FastPow negative base gives zero: ", (FastPow(-0.5f, 2.0f) == 0.0f), true);
+        LOG_TEST_RESULT(TestID++, "FastPow one raised to any exponent gives one: ", (FastPow(1.0f, 37.0f) == 1.0f), true);
+        LOG_TEST_RESULT(TestID++, "FastPow base below one with a large exponent underflows to zero: ", (FastPow(1e-10f, 20.0f) == 0.0f), true);
+        LOG_TEST_RESULT(TestID++, "FastPow large result saturates to FLT_MAX: ", (FastPow(1e10f, 20.0f) == FLT_MAX), true);
+        LOG_TEST_RESULT(TestID++, "FastPow negative exponent matches powf: ", (IsClose(FastPow(4.0f, -0.5f), 0.5f, 1e-4f)), true);
+        LOG_TEST_RESULT(TestID++, "FastPow denormal base gives zero: ", (FastPow(1e-40f, 0.5f) == 0.0f), true);
+    }
+
+    struct CLIPCASE
+    {
+        const char* Name;
+        D3DXVECTOR4 Position;
+        DWORD ClipCode;
+    };
+
+    // One vertex past each plane, vertices on a plane are inside
+    const CLIPCASE ClipCases[] = {
+        { "left", D3DXVECTOR4(-2.0f, 0.0f, 0.5f, 1.0f), D3DCLIP_LEFT },
+        { "right", D3DXVECTOR4(2.0f, 0.0f, 0.5f, 1.0f), D3DCLIP_RIGHT },
+        { "top", D3DXVECTOR4(0.0f, 2.0f, 0.5f, 1.0f), D3DCLIP_TOP },
+        { "bottom", D3DXVECTOR4(0.0f, -2.0f, 0.5f, 1.0f), D3DCLIP_BOTTOM },
+        { "front", D3DXVECTOR4(0.0f, 0.0f, -0.5f, 1.0f), D3DCLIP_FRONT },
+        { "back", D3DXVECTOR4(0.0f, 0.0f, 2.0f, 1.0f), D3DCLIP_BACK },
+        { "right top back corner", D3DXVECTOR4(3.0f, 3.0f, 3.0f, 2.0f), D3DCLIP_RIGHT | D3DCLIP_TOP | D3DCLIP_BACK },
+        { "on every plane", D3DXVECTOR4(1.0f, -1.0f, 1.0f, 1.0f), 0 },
+    };
+
+    const D3DXVECTOR4 InsidePosition(0.25f, -0.25f, 0.5f, 1.0f);
+
+    void TestClipCodes(DWORD& TestID)
+    {
+        // Four vertices go through the batched path and three through the scalar tail
+        constexpr DWORD Count = 7;
+
+        for (const CLIPCASE& Case : ClipCases)
+        {
+            bool IsMatching = true;
+            for (DWORD Index = 0; Index < Count; Index++)
+            {
+                std::vector<D3DXVECTOR4> Homogeneous(Count, InsidePosition);
+                Homogeneous[Index] = Case.Position;
+
+                std::vector<DWORD> ClipCodes(Count, 0xFFFFFFFF);
+                DWORD Intersection = D3DCLIP_FRUSTUM;
+                const DWORD Union = ComputeClipCodes(Homogeneous.data(), ClipCodes.data(), Count, Intersection);
+
+                IsMatching = IsMatching && Union == Case.ClipCode && Intersection == 0;
+                for (DWORD i = 0; i < Count; i++)
+                {
+                    IsMatching = IsMatching && ClipCodes[i] == (i == Index ? Case.ClipCode : 0);
+                }
+            }
+            LOG_TEST_RESULT(TestID++, "ComputeClipCodes " << Case.Name << " at every index of " << Count << " vertices: ", IsMatching, true);
+        }
+
+        // All inside
+        std::vector<D3DXVECTOR4> Homogeneous(Count, InsidePosition);
+        DWORD Intersection = D3DCLIP_FRUSTUM;
+        DWORD Union = ComputeClipCodes(Homogeneous.data(), nullptr, Count, Intersection);
+        LOG_TEST_RESULT(TestID++, "ComputeClipCodes all inside has no union: ", Union, 0);
+        LOG_TEST_RESULT(TestID++, "ComputeClipCodes all inside has no intersection: ", Intersection, 0);
+
+        // All outside the right plane, each also outside a different second plane, for counts with and without a tail
+        for (DWORD OutsideCount : { 3, 4, 5, 8 })
+        {
+            std::vector<D3DXVECTOR4> Outside(OutsideCount);
+            std::vector<DWORD> ClipCodes(OutsideCount);
+            DWORD ExpectedUnion = 0;
+            for (DWORD i = 0; i < OutsideCount; i++)
+            {
+                const CLIPCASE& Case = ClipCases[i % 6];
+                Outside[i] = D3DXVECTOR4(2.0f, Case.Position.y, Case.Position.z, 1.0f);
+                ExpectedUnion |= D3DCLIP_RIGHT | (Case.ClipCode & ~D3DCLIP_LEFT);
+            }
+            Intersection = D3DCLIP_FRUSTUM;
+            Union = ComputeClipCodes(Outside.data(), ClipCodes.data(), OutsideCount, Intersection);
+            LOG_TEST_RESULT(TestID++, "ComputeClipCodes " << OutsideCount << " vertices all outside the right plane intersect on it: ", Intersection, D3DCLIP_RIGHT);
+            LOG_TEST_RESULT(TestID++, "ComputeClipCodes " << OutsideCount << " vertices all outside have the union of their codes: ", Union, ExpectedUnion);
+
+            // The intersection is masked into the value passed in, not replaced
+            Intersection = D3DCLIP_LEFT;
+            ComputeClipCodes(Outside.data(), nullptr, OutsideCount, Intersection);
+            LOG_TEST_RESULT(TestID++, "ComputeClipCodes " << OutsideCount << " vertices masks the intersection passed in: ", Intersection, 0);
+        }
+
+        // No vertices leave the intersection as is
+        Intersection = D3DCLIP_FRUSTUM;
+        Union = ComputeClipCodes(Homogeneous.data(), nullptr, 0, Intersection);
+        LOG_TEST_RESULT(TestID++, "ComputeClipCodes no vertices keeps the intersection: ", (Union == 0 && Intersection == D3DCLIP_FRUSTUM), true);
+    }
+
+    // Known viewport at an offset with a depth range, the corners and center of the clip volume must land on the
+    // viewport edges. Pretransformed vertices are passed to Direct3D 9 as is, so this is the final screen position.
+    void TestViewportTransform(DWORD& TestID)
+    {
+        D3DVIEWPORT7 View = {};
+        View.dwX = 100;
+        View.dwY = 50;
+        View.dwWidth = 640;
+        View.dwHeight = 480;
+        View.dvMinZ = 0.25f;
+        View.dvMaxZ = 0.75f;
+
+        const float Input[][4] = {
+            { -1.0f, 1.0f, 0.0f, 0.5f },    // Top left, near
+            { 1.0f, -1.0f, 1.0f, 0.25f },   // Bottom right, far
+            { 0.0f, 0.0f, 0.5f, 1.0f },     // Center
+        };
+        const float Expected[][4] = {
+            { 100.0f, 50.0f, 0.25f, 0.5f },
+            { 740.0f, 530.0f, 0.75f, 0.25f },
+            { 420.0f, 290.0f, 0.5f, 1.0f },
+        };
+        constexpr DWORD Count = _countof(Input);
+
+        std::vector<BYTE> Dest(Count * DestStride, DestSentinel);
+        for (DWORD x = 0; x < Count; x++)
+        {
+            memcpy(Dest.data() + x * DestStride, Input[x], sizeof(Input[x]));
+        }
+
+        D3DVECTOR ExtentMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+        D3DVECTOR ExtentMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        ApplyViewportTransform(MakeViewportTransform(View, 1.0f, 1.0f), Dest.data(), DestStride, Count, &ExtentMin, &ExtentMax);
+
+        bool IsMatching = true;
+        bool IsRestUntouched = true;
+        for (DWORD x = 0; x < Count; x++)
+        {
+            const float* pVertex = (const float*)(Dest.data() + x * DestStride);
+            for (int y = 0; y < 4; y++)
+            {
+                IsMatching = IsMatching && IsClose(pVertex[y], Expected[x][y], 1e-6f);
+            }
+            for (UINT y = 4 * sizeof(float); y < DestStride; y++)
+            {
+                IsRestUntouched = IsRestUntouched && Dest[x * DestStride + y] == DestSentinel;
+            }
+        }
+
+        LOG_TEST_RESULT(TestID++, "ApplyViewportTransform maps the clip volume onto a 640x480 viewport at 100,50: ", IsMatching, true);
+        LOG_TEST_RESULT(TestID++, "ApplyViewportTransform leaves the rest of each vertex as is: ", IsRestUntouched, true);
+        LOG_TEST_RESULT(TestID++, "ApplyViewportTransform extents cover the viewport: ",
+            (ExtentMin.x == 100.0f && ExtentMin.y == 50.0f && ExtentMin.z == 0.25f && ExtentMax.x == 740.0f && ExtentMax.y == 530.0f && ExtentMax.z == 0.75f), true);
+
+        // The legacy viewport scale multiplies the half size, so a scale of two puts the edge of the clip volume a full width away
+        Dest.assign(Count * DestStride, DestSentinel);
+        memcpy(Dest.data(), Input[0], sizeof(Input[0]));
+        ApplyViewportTransform(MakeViewportTransform(View, 2.0f, 0.5f), Dest.data(), DestStride, 1, nullptr, nullptr);
+        const float* pVertex = (const float*)Dest.data();
+        LOG_TEST_RESULT(TestID++, "ApplyViewportTransform with the legacy viewport scale: ",
+            (IsClose(pVertex[0], -220.0f, 1e-6f) && IsClose(pVertex[1], 170.0f, 1e-6f)), true);
+    }
+
+    // Logs the cost per vertex of a plain transform to the screen, then with clip codes, extents and both,
+    // in batches like ProcessVertices
+    void BenchmarkClipAndExtents()
+    {
+        constexpr DWORD VertexCount = 4096;
+        const D3DMATRIX Matrix = GetTestMatrix();
+        DWORD Seed = 9;
+        const std::vector<BYTE> Src = BuildSourceVertices(VertexCount, Seed);
+        std::vector<BYTE> Dest(VertexCount * DestStride);
+
+        VIEWPORTTRANSFORM Viewport;
+        Viewport.ScaleX = 320.0f;
+        Viewport.ScaleY = -240.0f;
+        Viewport.OffsetX = 320.0f;
+        Viewport.OffsetY = 240.0f;
+
+        const struct { bool IsClip; bool IsExtents; const char* Name; } Options[] = {
+            { false, false, "transform" }, { true, false, "with clip codes" }, { false, true, "with extents" }, { true, true, "with clip codes and extents" } };
+        for (const auto& Option : Options)
+        {
+            D3DXVECTOR4 Homogeneous[VertexBatchSize];
+            DWORD ClipCodes[VertexBatchSize];
+            DWORD ClipUnion = 0, ClipIntersection = D3DCLIP_FRUSTUM;
+            D3DVECTOR ExtentMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+            D3DVECTOR ExtentMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+            const double Time = MeasureNanoseconds(200, [&]()
+                {
+                    for (DWORD Start = 0; Start < VertexCount; Start += VertexBatchSize)
+                    {
+                        const DWORD Count = (std::min)(VertexBatchSize, VertexCount - Start);
+                        BYTE* pDestBatch = Dest.data() + Start * DestStride;
+
+                        TransformPositions(Matrix, Src.data() + Start * SrcStride, SrcStride, pDestBatch, DestStride, Option.IsClip ? Homogeneous : nullptr, Count);
+                        if (Option.IsClip)
+                        {
+                            ClipUnion |= ComputeClipCodes(Homogeneous, ClipCodes, Count, ClipIntersection);
+                        }
+                        ApplyViewportTransform(Viewport, pDestBatch, DestStride, Count, Option.IsExtents ? &ExtentMin : nullptr, Option.IsExtents ? &ExtentMax : nullptr);
+                    }
+                });
+
+            Logging::Log() << "Benchmark: VertexTransform " << Option.Name << " " << (Time / VertexCount) << " ns per vertex";
+        }
+    }
+
+    // Logs the cost of FastPow against powf for the specular term
+    void BenchmarkFastPow()
+    {
+        // Results go to a volatile so the calls are not removed
+        volatile float Result = 0.0f;
+        float Base = 0.5f;
+        const double FastTime = MeasureNanoseconds(1000000, [&]()
+            {
+                Result = FastPow(Base, 16.0f);
+                Base = (Base < 0.99f) ? Base + 0.001f : 0.5f;
+            });
+        Base = 0.5f;
+        const double PowTime = MeasureNanoseconds(1000000, [&]()
+            {
+                Result = powf(Base, 16.0f);
+                Base = (Base < 0.99f) ? Base + 0.001f : 0.5f;
+            });
+
+        Logging::Log() << "Benchmark: FastPow " << FastTime << " ns per call, powf " << PowTime << " ns per call";
+    }
+}
+
+void TestVertexTransform()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing VertexTransform";
+    Logging::Log() << "****";
+
+    DWORD TestID = 9500;
+
+    TestTransformPositions(TestID);
+    TestTransformNormals(TestID);
+    TestFastPow(TestID);
+    TestClipCodes(TestID);
+    TestViewportTransform(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkClipAndExtents();
+        BenchmarkFastPow();
+    }
+}
@@ -0,0 +1,233 @@
+#include "Utils\WindowScore.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <map>
+
+using namespace Fullscreen;
+
+namespace {
+    constexpr LONG ScreenWidth = 1920;
+    constexpr LONG ScreenHeight = 1080;
+
+    HWND MakeWindow(DWORD x)
+    {
+        return (HWND)(ULONG_PTR)(0x00010010 + x * 0x00020002);
+    }
+
+    // Unowned captioned window with a title, sized to the screen unless a size is given
+    WINDOWDESC MakeMainWindow(DWORD x, bool IsVisible, LONG Width = ScreenWidth, LONG Height = ScreenHeight)
+    {
+        WINDOWDESC Window;
+        Window.hwnd = MakeWindow(x);
+        Window.Width = Width;
+        Window.Height = Height;
+        Window.ScreenWidth = ScreenWidth;
+        Window.ScreenHeight = ScreenHeight;
+        Window.HasCaption = true;
+        Window.HasTitle = true;
+        Window.IsVisible = IsVisible;
+        return Window;
+    }
+
+    WINDOWDESC MakeToolWindow(DWORD x, LONG Width = ScreenWidth, LONG Height = ScreenHeight)
+    {
+        WINDOWDESC Window = MakeMainWindow(x, true, Width, Height);
+        Window.HasOwner = true;
+        return Window;
+    }
+
+    void TestScore(DWORD& TestID)
+    {
+        LOG_TEST_RESULT(TestID++, "Window within 40 pixels of the screen width is fullscreen: ", IsFullScreenSize(1880, 600, ScreenWidth, ScreenHeight), true);
+        LOG_TEST_RESULT(TestID++, "Window within 40 pixels of the screen height is fullscreen: ", IsFullScreenSize(800, 1120, ScreenWidth, ScreenHeight), true);
+        LOG_TEST_RESULT(TestID++, "Window 41 pixels off both sizes is not fullscreen: ", IsFullScreenSize(1879, 1039, ScreenWidth, ScreenHeight), false);
+
+        const WINDOWDESC Main = MakeMainWindow(0, true);
+        WINDOWDESC Owned = Main, NoCaption = Main, Child = Main, NoTitle = Main;
+        Owned.HasOwner = true;
+        NoCaption.HasCaption = false;
+        Child.HasParent = true;
+        NoTitle.HasTitle = false;
+        LOG_TEST_RESULT(TestID++, "Unowned captioned window with a title is a main window: ", IsMainWindow(Main), true);
+        LOG_TEST_RESULT(TestID++, "Owned, uncaptioned, child and untitled windows are not main windows: ",
+            (IsMainWindow(Owned) || IsMainWindow(NoCaption) || IsMainWindow(Child) || IsMainWindow(NoTitle)), false);
+    }
+
+    void TestSelection(DWORD& TestID)
+    {
+        const std::vector<WINDOWDESC> NoWindows;
+        LOG_TEST_RESULT(TestID++, "No windows selects nothing: ", SelectMainWindow(NoWindows), 0);
+
+        // Fullscreen tool window on top of the game window
+        const std::vector<WINDOWDESC> Visible = { MakeToolWindow(0), MakeMainWindow(1, false), MakeMainWindow(2, true), MakeMainWindow(3, true) };
+        LOG_TEST_RESULT(TestID++, "First visible fullscreen main window is selected: ", SelectMainWindow(Visible), 2);
+
+        // Window still hidden while the game starts
+        const std::vector<WINDOWDESC> Hidden = { MakeToolWindow(0), MakeMainWindow(1, false), MakeMainWindow(2, false), MakeMainWindow(3, true, 640, 480) };
+        LOG_TEST_RESULT(TestID++, "Last hidden fullscreen main window is selected without a visible one: ", SelectMainWindow(Hidden), 2);
+
+        // Windowed game window with a fullscreen splash window
+        const std::vector<WINDOWDESC> Splash = { MakeMainWindow(0, true, 640, 480), MakeToolWindow(1, 640, 480), MakeToolWindow(2) };
+        LOG_TEST_RESULT(TestID++, "First fullscreen window is selected without a fullscreen main window: ", SelectMainWindow(Splash), 2);
+
+        const std::vector<WINDOWDESC> Windowed = { MakeToolWindow(0, 640, 480), MakeMainWindow(1, true, 640, 480), MakeMainWindow(2, true, 800, 600) };
+        LOG_TEST_RESULT(TestID++, "First main window is selected without a fullscreen window: ", SelectMainWindow(Windowed), 1);
+
+        const std::vector<WINDOWDESC> Tools = { MakeToolWindow(0, 640, 480), MakeToolWindow(1, 800, 600) };
+        LOG_TEST_RESULT(TestID++, "Top window is selected without a main or fullscreen window: ", SelectMainWindow(Tools), 0);
+    }
+
+    // Windows of the process, counts the calls that reach them
+    class MockWindows
+    {
+    private:
+        std::map<HWND, bool> Titles;
+
+    public:
+        DWORD ClassCalls = 0;
+        DWORD TitleCalls = 0;
+        WindowInfoCache<MockWindows>* DestroyDuringTitle = nullptr;	// Sends a destroy event while the title is asked
+
+        void SetTitle(HWND hwnd, bool HasTitle) { Titles[hwnd] = HasTitle; }
+
+        // Calls made by WindowInfoCache
+        bool IsCompatWindow(HWND hwnd)
+        {
+            ClassCalls++;
+            return hwnd == MakeWindow(0);
+        }
+        bool HasTitle(HWND hwnd)
+        {
+            TitleCalls++;
+            if (DestroyDuringTitle)
+            {
+                DestroyDuringTitle->OnWindowEvent(EVENT_OBJECT_DESTROY, hwnd);
+            }
+            return Titles[hwnd];
+        }
+    };
+
+    typedef WindowInfoCache<MockWindows> INFOCACHE;
+
+    // Asks the cache like a scan of the windows does
+    DWORD Scan(INFOCACHE& Cache, DWORD Windows)
+    {
+        DWORD Titled = 0;
+        for (DWORD x = 0; x < Windows; x++)
+        {
+            if (!Cache.IsCompatWindow(MakeWindow(x)) && Cache.HasTitle(MakeWindow(x)))
+            {
+                Titled++;
+            }
+        }
+        return Titled;
+    }
+
+    void TestInfoCache(DWORD& TestID)
+    {
+        MockWindows Windows;
+        INFOCACHE Cache(Windows);
+        for (DWORD x = 1; x < 4; x++)
+        {
+            Windows.SetTitle(MakeWindow(x), x != 3);
+        }
+
+        Scan(Cache, 4);
+        const DWORD Titled = Scan(Cache, 4);
+        LOG_TEST_RESULT(TestID++, "Cached details match the windows: ", Titled, 2);
+        LOG_TEST_RESULT(TestID++, "Each window is asked once over many scans: ", (Windows.ClassCalls == 4 && Windows.TitleCalls == 3), true);
+
+        // Moving a window does not change its cached details
+        Cache.OnWindowEvent(EVENT_OBJECT_LOCATIONCHANGE, MakeWindow(1));
+        Scan(Cache, 4);
+        LOG_TEST_RESULT(TestID++, "Location change asks nothing again: ", (Windows.ClassCalls == 4 && Windows.TitleCalls == 3), true);
+
+        // A title set after the window was created is seen at the next scan
+        Windows.SetTitle(MakeWindow(3), true);
+        Cache.OnWindowEvent(EVENT_OBJECT_NAMECHANGE, MakeWindow(3));
+        const DWORD RenamedTitled = Scan(Cache, 4);
+        LOG_TEST_RESULT(TestID++, "Name change asks only the title again: ", (RenamedTitled == 3 && Windows.ClassCalls == 4 && Windows.TitleCalls == 4), true);
+
+        Cache.OnWindowEvent(EVENT_OBJECT_NAMECHANGE, MakeWindow(50));
+        LOG_TEST_RESULT(TestID++, "Name change of an unknown window adds nothing: ", Cache.GetCount(), 4);
+
+        // A destroyed window is dropped and a new window that reuses its handle is asked again
+        Cache.OnWindowEvent(EVENT_OBJECT_DESTROY, MakeWindow(2));
+        const size_t CountAfterDestroy = Cache.GetCount();
+        Windows.SetTitle(MakeWindow(2), false);
+        Cache.OnWindowEvent(EVENT_OBJECT_CREATE, MakeWindow(2));
+        const DWORD ReusedTitled = Scan(Cache, 4);
+        LOG_TEST_RESULT(TestID++, "Destroyed window is dropped: ", CountAfterDestroy, 3);
+        LOG_TEST_RESULT(TestID++, "Reused handle is asked again: ", (ReusedTitled == 2 && Windows.ClassCalls == 5 && Windows.TitleCalls == 5), true);
+
+        // Created windows are asked when first scanned even if they were scanned before the event arrived
+        Scan(Cache, 6);
+        Cache.OnWindowEvent(EVENT_OBJECT_CREATE, MakeWindow(5));
+        Scan(Cache, 6);
+        LOG_TEST_RESULT(TestID++, "Create event asks the window again: ", (Windows.ClassCalls == 8 && Windows.TitleCalls == 8), true);
+
+        Cache.Clear();
+        Scan(Cache, 6);
+        LOG_TEST_RESULT(TestID++, "Cleared cache asks every window again: ", (Windows.ClassCalls == 14 && Windows.TitleCalls == 13), true);
+
+        // The window event callback can run while the title is asked and drop the entry being filled
+        Cache.Clear();
+        Cache.IsCompatWindow(MakeWindow(1));
+        Windows.DestroyDuringTitle = &Cache;
+        const bool ReenteredTitle = Cache.HasTitle(MakeWindow(1));
+        Windows.DestroyDuringTitle = nullptr;
+        const bool CachedTitle = Cache.HasTitle(MakeWindow(1));
+        LOG_TEST_RESULT(TestID++, "Window dropped while its title is asked is cached again: ", (ReenteredTitle && CachedTitle && Cache.GetCount() == 1 && Windows.TitleCalls == 14), true);
+    }
+
+    // Logs the time to pick the main window from 1 to 64 windows with the details cached
+    void BenchmarkWindowScore()
+    {
+        constexpr DWORD Count = 100000;
+        for (DWORD WindowCount = 1; WindowCount <= 64; WindowCount *= 2)
+        {
+            // Main window at the bottom of the z-order so every window is scored
+            std::vector<WINDOWDESC> Windows;
+            for (DWORD x = 1; x < WindowCount; x++)
+            {
+                Windows.push_back(MakeToolWindow(x, 640, 480));
+            }
+            Windows.push_back(MakeMainWindow(WindowCount, true));
+
+            MockWindows Calls;
+            INFOCACHE Cache(Calls);
+            volatile size_t Sink = 0;
+            const double SelectTime = MeasureNanoseconds(Count, [&]()
+                {
+                    Sink = Sink + SelectMainWindow(Windows);
+                });
+            const double CacheTime = MeasureNanoseconds(Count, [&]()
+                {
+                    Sink = Sink + Scan(Cache, WindowCount);
+                });
+
+            Logging::Log() << "Benchmark: WindowScore " << WindowCount << " windows " << SelectTime << " ns to select, " <<
+                CacheTime << " ns for the cached details, " << Calls.TitleCalls << " title calls";
+        }
+    }
+}
+
+void TestWindowScore()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing WindowScore";
+    Logging::Log() << "****";
+
+    DWORD TestID = 15000;
+
+    TestScore(TestID);
+    TestSelection(TestID);
+    TestInfoCache(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkWindowScore();
+    }
+}
@@ -0,0 +1,248 @@
+#include "GDI\WndProcTable.h"
+
+#include "ddraw-testing.h"
+#include "testing-harness.h"
+#include <vector>
+#include <memory>
+
+namespace {
+    constexpr DWORD TestTimeoutMS = 30000;
+    constexpr DWORD ReaderCount = 4;
+    constexpr DWORD StressWindows = 64;
+    constexpr DWORD StressPublishes = 20000;
+
+    struct TESTENTRY
+    {
+        HWND hWnd = nullptr;
+        DWORD Id = 0;
+        bool Active = true;
+        std::atomic<bool> Alive = true;     // Cleared before the entry would be freed
+
+        TESTENTRY(HWND p_hWnd, DWORD p_Id) : hWnd(p_hWnd), Id(p_Id) {}
+        HWND GetHWnd() const { return hWnd; }
+    };
+
+    typedef WndProcTable<TESTENTRY> TESTTABLE;
+
+    HWND MakeWindow(DWORD x)
+    {
+        // Window handles are spaced like the ones user32 hands out
+        return (HWND)(ULONG_PTR)(0x00010010 + x * 0x00020002);
+    }
+
+    DWORD FindId(TESTTABLE& Table, HWND hWnd)
+    {
+        return Table.Find<DWORD>(hWnd,
+            [](TESTENTRY* entry) { return entry->Active; },
+            [](TESTENTRY* entry) { return entry->Id; });
+    }
+
+    void TestLookup(DWORD& TestID)
+    {
+        TESTTABLE Table;
+        LOG_TEST_RESULT(TestID++, "Empty table finds nothing: ", FindId(Table, MakeWindow(0)), 0);
+
+        // Enough windows that probes collide and wrap around the table
+        std::vector<std::unique_ptr<TESTENTRY>> Owned;
+        std::vector<TESTENTRY*> Entries;
+        for (DWORD x = 0; x < 100; x++)
+        {
+            Owned.emplace_back(new TESTENTRY(MakeWindow(x), x + 1));
+            Entries.push_back(Owned.back().get());
+        }
+        Table.Publish(Entries);
+
+        bool IsFound = true;
+        for (DWORD x = 0; x < 100; x++)
+        {
+            IsFound = IsFound && FindId(Table, MakeWindow(x)) == x + 1;
+        }
+        LOG_TEST_RESULT(TestID++, "Every window is found: ", IsFound, true);
+        LOG_TEST_RESULT(TestID++, "Unknown window finds nothing: ", FindId(Table, MakeWindow(1000)), 0);
+
+        // Entries of the same window are checked in list order
+        Owned.emplace_back(new TESTENTRY(MakeWindow(7), 201));
+        Owned.emplace_back(new TESTENTRY(MakeWindow(7), 202));
+        Entries.push_back(Owned[Owned.size() - 2].get());
+        Entries.push_back(Owned.back().get());
+        Owned[7]->Active = false;
+        Table.Publish(Entries);
+        LOG_TEST_RESULT(TestID++, "First active entry of the window is found: ", FindId(Table, MakeWindow(7)), 201);
+
+        // The last hit is only kept for the first entry of its window, so it never hides an earlier one
+        Owned[Owned.size() - 2]->Active = false;
+        const DWORD LaterId = FindId(Table, MakeWindow(7));
+        Owned[7]->Active = true;
+        const DWORD EarlierId = FindId(Table, MakeWindow(7));
+        LOG_TEST_RESULT(TestID++, "Later entry is found when the earlier ones fail: ", LaterId, 202);
+        LOG_TEST_RESULT(TestID++, "Earlier entry is found again after a later hit: ", EarlierId, 8);
+
+        // Removed entries are gone from the new table
+        Entries.erase(Entries.begin() + 7);
+        Table.Publish(Entries);
+        LOG_TEST_RESULT(TestID++, "Removed entry is not found: ", FindId(Table, MakeWindow(7)), 202);
+        Table.Publish(std::vector<TESTENTRY*>());
+        LOG_TEST_RESULT(TestID++, "Empty list finds nothing: ", FindId(Table, MakeWindow(3)), 0);
+    }
+
+    struct STRESSDATA
+    {
+        TESTTABLE Table;
+        volatile LONG Stop = 0;
+        volatile LONG Lookups = 0;
+        volatile LONG Found = 0;
+        volatile LONG DeadHits = 0;     // Entries seen after they were removed and their readers were waited for
+        volatile LONG WrongHits = 0;    // Entries found for another window
+    };
+
+    DWORD WINAPI WndProcReaderThread(LPVOID lpParam)
+    {
+        STRESSDATA& Data = *reinterpret_cast<STRESSDATA*>(lpParam);
+        DWORD Seed = GetCurrentThreadId();
+        LONG Lookups = 0, Found = 0;
+        while (!InterlockedExchangeAdd(&Data.Stop, 0))
+        {
+            Seed = Seed * 214013 + 2531011;
+            const DWORD Window = (Seed >> 8) % StressWindows;
+            const HWND hWnd = MakeWindow(Window);
+            // Yield inside the lookup now and then so publishes happen while a table is held
+            const bool IsSlow = (Lookups & 15) == 0;
+            const TESTENTRY* entry = Data.Table.Find<TESTENTRY*>(hWnd,
+                [IsSlow](TESTENTRY*)
+                {
+                    if (IsSlow)
+                    {
+                        Sleep(0);
+                    }
+                    return true;
+                },
+                [&Data](TESTENTRY* entry)
+                {
+                    if (!entry->Alive)
+                    {
+                        InterlockedIncrement(&Data.DeadHits);
+                    }
+                    return entry;
+                });
+            if (entry)
+            {
+                Found++;
+                if (entry->Id % StressWindows != Window)
+                {
+                    InterlockedIncrement(&Data.WrongHits);
+                }
+            }
+            Lookups++;
+        }
+        InterlockedExchangeAdd(&Data.Lookups, Lookups);
+        InterlockedExchangeAdd(&Data.Found, Found);
+        return 0;
+    }
+
+    void TestReclamationStress(DWORD& TestID)
+    {
+        std::unique_ptr<STRESSDATA> Data(new STRESSDATA);
+
+        // Removed entries are marked dead once Publish returns and kept until the end, so a reader
+        // that could still reach one sees it is dead instead of reading freed memory
+        std::vector<std::unique_ptr<TESTENTRY>> Graveyard;
+        std::vector<TESTENTRY*> Entries;
+        DWORD NextId = 0;
+        for (DWORD x = 0; x < StressWindows / 2; x++, NextId++)
+        {
+            Graveyard.emplace_back(new TESTENTRY(MakeWindow(NextId % StressWindows), NextId));
+            Entries.push_back(Graveyard.back().get());
+        }
+        Data->Table.Publish(Entries);
+
+        HANDLE hReaders[ReaderCount] = {};
+        for (DWORD x = 0; x < ReaderCount; x++)
+        {
+            hReaders[x] = CreateThread(nullptr, 0, WndProcReaderThread, Data.get(), 0, nullptr);
+        }
+
+        // Replace one window per publish so the readers keep finding entries that are being removed
+        DWORD Seed = 29;
+        DWORD Publishes = 0;
+        const DWORD StartTime = GetTickCount();
+        for (; Publishes < StressPublishes && GetTickCount() - StartTime < TestTimeoutMS; Publishes++, NextId++)
+        {
+            Seed = Seed * 214013 + 2531011;
+            const size_t Index = (Seed >> 8) % Entries.size();
+            TESTENTRY* Removed = Entries[Index];
+            Graveyard.emplace_back(new TESTENTRY(MakeWindow(NextId % StressWindows), NextId));
+            Entries[Index] = Graveyard.back().get();
+            Data->Table.Publish(Entries);
+            Removed->Alive = false;
+        }
+
+        InterlockedExchange(&Data->Stop, 1);
+        WaitForMultipleObjects(ReaderCount, hReaders, TRUE, TestTimeoutMS);
+        for (DWORD x = 0; x < ReaderCount; x++)
+        {
+            CloseHandle(hReaders[x]);
+        }
+
+        LOG_TEST_RESULT(TestID++, "Writer finished every publish: ", Publishes, StressPublishes);
+        LOG_TEST_RESULT(TestID++, "Readers never see a removed entry after Publish returns: ", Data->DeadHits, 0);
+        LOG_TEST_RESULT(TestID++, "Readers only find entries of their window: ", Data->WrongHits, 0);
+        LOG_TEST_RESULT(TestID++, "Readers ran during the publishes: ", (Data->Lookups > 0 && Data->Found > 0), true);
+
+        Logging::Log() << "Benchmark: WndProcTable stress " << Publishes << " publishes, " << Data->Lookups << " lookups with " << ReaderCount << " readers";
+    }
+
+    // Logs the lookup time for 1 to 64 windows, hits cycle through the windows and misses use unknown handles
+    void BenchmarkWndProcTable()
+    {
+        constexpr DWORD Count = 1000000;
+        for (DWORD Windows = 1; Windows <= 64; Windows *= 2)
+        {
+            TESTTABLE Table;
+            std::vector<std::unique_ptr<TESTENTRY>> Owned;
+            std::vector<TESTENTRY*> Entries;
+            for (DWORD x = 0; x < Windows; x++)
+            {
+                Owned.emplace_back(new TESTENTRY(MakeWindow(x), x + 1));
+                Entries.push_back(Owned.back().get());
+            }
+            Table.Publish(Entries);
+
+            DWORD Next = 0;
+            volatile DWORD Sink = 0;
+            const double HitTime = MeasureNanoseconds(Count, [&]()
+                {
+                    Sink = Sink + FindId(Table, MakeWindow(Next));
+                    Next = (Next + 1 == Windows) ? 0 : Next + 1;
+                });
+            const double RepeatTime = MeasureNanoseconds(Count, [&]()
+                {
+                    Sink = Sink + FindId(Table, MakeWindow(0));
+                });
+            const double MissTime = MeasureNanoseconds(Count, [&]()
+                {
+                    Sink = Sink + FindId(Table, MakeWindow(1000 + Next));
+                    Next = (Next + 1 == Windows) ? 0 : Next + 1;
+                });
+
+            Logging::Log() << "Benchmark: WndProcTable " << Windows << " windows " << HitTime << " ns per hit, " <<
+                RepeatTime << " ns same window, " << MissTime << " ns per miss";
+        }
+    }
+}
+
+void TestWndProcTable()
+{
+    Logging::Log() << "****";
+    Logging::Log() << "**** Testing WndProcTable";
+    Logging::Log() << "****";
+
+    DWORD TestID = 14000;
+
+    TestLookup(TestID);
+    TestReclamationStress(TestID);
+
+    if (RunBenchmarks)
+    {
+        BenchmarkWndProcTable();
+    }
+}
@@ -5,6 +5,9 @@ std::ofstream LOG;
 
 HWND DDhWnd = nullptr;
 
+// Benchmarks only log timings and take a while, run them with the -benchmark command line option
+bool RunBenchmarks = false;
+
 DirectDrawCreateProc pDirectDrawCreate = nullptr;
 DirectDrawCreateExProc pDirectDrawCreateEx = nullptr;
 DirectDrawEnumerateAProc pDirectDrawEnumerateA = nullptr;
@@ -107,6 +110,29 @@ static HWND CreateTestWindow()
 // Run tests for all DirectDraw versions
 static void RunAllTests()
 {
+    // Wrapper code built into the tests, does not need ddraw.dll
+    TestSurfaceBlitter();
+    TestExecuteCompiler();
+    TestPrimitiveBatch();
+    TestStateCache();
+    TestPresentScheduler();
+    TestMouseDataRing();
+    TestClipRects();
+    TestDirtyRegion();
+    TestScanlines();
+    TestVertexTransform();
+    TestDynamicBuffer();
+    TestAddressLookupTable();
+    TestTraceLog();
+    TestProfiler();
+    TestFrameStats();
+    TestFrameLimiter();
+    TestAudioScheduler();
+    TestBufferStatusCache();
+    TestWndProcTable();
+    TestThreadMonitor();
+    TestWindowScore();
+
     // Load dll
     HMODULE ddraw_dll = LoadLibraryA("ddraw.dll");
     if (!ddraw_dll)
@@ -142,13 +168,14 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 {
 	UNREFERENCED_PARAMETER(hInstance);
 	UNREFERENCED_PARAMETER(hPrevInstance);
-	UNREFERENCED_PARAMETER(lpCmdLine);
 	UNREFERENCED_PARAMETER(nShowCmd);
 
 	Logging::Open("ddraw-testing.log");
 	Logging::LogVideoCard();
 	Logging::LogOSVersion();
 
+    RunBenchmarks = (lpCmdLine && wcsstr(lpCmdLine, L"-benchmark"));
+
     RunAllTests();
 
     Logging::Log() << "Exiting...";
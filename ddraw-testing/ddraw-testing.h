@@ -41,6 +41,7 @@ typedef HRESULT(WINAPI* SetAppCompatDataProc)(DWORD Type, DWORD Value);
 class IDirectDraw7Ex : public IDirectDraw7 {};
 
 extern HWND DDhWnd;
+extern bool RunBenchmarks;
 
 extern DirectDrawCreateProc pDirectDrawCreate;
 extern DirectDrawCreateExProc pDirectDrawCreateEx;
@@ -57,6 +58,27 @@ static UINT GetRefCount(T IUnknownAddr)
     return ref;
 }
 
+void TestSurfaceBlitter();
+void TestExecuteCompiler();
+void TestPrimitiveBatch();
+void TestStateCache();
+void TestPresentScheduler();
+void TestMouseDataRing();
+void TestClipRects();
+void TestDirtyRegion();
+void TestScanlines();
+void TestVertexTransform();
+void TestDynamicBuffer();
+void TestAddressLookupTable();
+void TestTraceLog();
+void TestProfiler();
+void TestFrameStats();
+void TestFrameLimiter();
+void TestAudioScheduler();
+void TestBufferStatusCache();
+void TestWndProcTable();
+void TestThreadMonitor();
+void TestWindowScore();
 void TestEnumDisplaySettings();
 
 template <typename DDType>
@@ -16,6 +16,22 @@
 		} \
 	}
 
+// Average time of one call in nanoseconds, benchmark results are only logged and never fail
+template <typename F>
+static double MeasureNanoseconds(DWORD Count, F Func)
+{
+	LARGE_INTEGER Frequency, Start, End;
+	QueryPerformanceFrequency(&Frequency);
+	Func();
+	QueryPerformanceCounter(&Start);
+	for (DWORD x = 0; x < Count; x++)
+	{
+		Func();
+	}
+	QueryPerformanceCounter(&End);
+	return (double)(End.QuadPart - Start.QuadPart) * 1000000000.0 / (double)Frequency.QuadPart / Count;
+}
+
 constexpr UINT MaxLightStates = 10;  // Devices have up to 10 types.
 constexpr UINT MaxTextureStageStates = 33;  // Devices have up to 33 types.
 
@@ -3,6 +3,7 @@
 #include <unordered_map>
 #include <algorithm>
 #include "ddraw.h"
+#include "Utils\WrapperAddressMap.h"
 
 template <typename T>
 struct AddressInterfaceList {
@@ -102,8 +103,7 @@ private:
 	static constexpr size_t MaxCacheIndex = 43;
 
 	bool ConstructorFlag = false;
-	std::unordered_map<void*, class AddressLookupTableDdrawObject*> g_map[MaxCacheIndex];
-	std::unordered_map<class AddressLookupTableDdrawObject*, void*> reverse_map[MaxCacheIndex];  // Reverse mapping
+	WrapperAddressMap<class AddressLookupTableDdrawObject, MaxCacheIndex> AddressMap;
 
 	template <typename T>
 	struct AddressCacheIndex {};
@@ -242,18 +242,10 @@ private:
 
 	void DeleteAll()
 	{
-		for (size_t i = 0; i < MaxCacheIndex; ++i)
+		// Don't delete m_IDirectDrawClipper it may be globally created
+		if (!ConstructorFlag)
 		{
-			const auto& map = g_map[i];
-
-			// Don't delete m_IDirectDrawClipper it may be globally created
-			if (!ConstructorFlag && i != AddressCacheIndex<m_IDirectDrawClipper>::CacheIndex)
-			{
-				for (const auto& entry : map)
-				{
-					delete entry.second;
-				}
-			}
+			AddressMap.DeleteAll([](size_t CacheIndex) { return CacheIndex != AddressCacheIndex<m_IDirectDrawClipper>::CacheIndex; });
 		}
 	}
 
@@ -351,13 +343,7 @@ private:
 
 		constexpr size_t CacheIndex = AddressCacheIndex<T>::CacheIndex;
 
-		auto it = g_map[CacheIndex].find(Proxy);
-		if (it != std::end(g_map[CacheIndex]))
-		{
-			return static_cast<T *>(it->second);
-		}
-
-		return nullptr;
+		return static_cast<T *>(AddressMap.Find(CacheIndex, Proxy));
 	}
 
 public:
@@ -480,15 +466,7 @@ public:
 
 			CacheIndex;
 
-		for (size_t i = Start; i <= End; i++)
-		{
-			if (reverse_map[i].find(Wrapper) != reverse_map[i].end())
-			{
-				return true;
-			}
-		}
-
-		return false;
+		return AddressMap.IsSaved(Wrapper, Start, End);
 	}
 
 	template <typename T>
@@ -501,13 +479,7 @@ public:
 
 		constexpr size_t CacheIndex = AddressCacheIndex<T>::CacheIndex;
 
-		auto it = g_map[CacheIndex].find(Proxy);
-		if (it != std::end(g_map[CacheIndex]))
-		{
-			return true;
-		}
-
-		return false;
+		return (AddressMap.Find(CacheIndex, Proxy) != nullptr);
 	}
 
 	template <typename T>
@@ -516,8 +488,7 @@ public:
 		constexpr size_t CacheIndex = AddressCacheIndex<T>::CacheIndex;
 		if (Wrapper && Proxy)
 		{
-			g_map[CacheIndex][Proxy] = Wrapper;
-			reverse_map[CacheIndex][Wrapper] = Proxy;  // Update reverse map
+			AddressMap.Save(Wrapper, CacheIndex, { Proxy });
 		}
 	}
 
@@ -531,21 +502,12 @@ public:
 
 		constexpr size_t CacheIndex = AddressCacheIndex<T>::CacheIndex;
 
-		// Remove from g_map
-		auto it = std::find_if(g_map[CacheIndex].begin(), g_map[CacheIndex].end(),
-			[=](auto& Map) -> bool { return Map.second == Wrapper; });
-		if (it != std::end(g_map[CacheIndex]))
-		{
-			g_map[CacheIndex].erase(it);
-		}
-
-		// Remove from reverse_map
-		reverse_map[CacheIndex].erase(Wrapper);
+		AddressMap.Erase(Wrapper);
 
 		// If this is the last DirectDraw than delete all interfaces and clear cache
 		if constexpr (CacheIndex == AddressCacheIndex<m_IDirectDrawX>::CacheIndex)
 		{
-			if (g_map[AddressCacheIndex<m_IDirectDrawX>::CacheIndex].size() == 0)
+			if (AddressMap.GetKeyCount(AddressCacheIndex<m_IDirectDrawX>::CacheIndex) == 0)
 			{
 				DeleteAll();
 			}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <windows.h>
+#include <vector>
+#include <algorithm>
+
+// Intersects Rect with a y-x banded clip list such as GDI region data, bands are sorted by y and do not overlap
+inline void IntersectClipRects(const std::vector<RECT>& ClipRects, const RECT& Rect, std::vector<RECT>& OutRects)
+{
+	OutRects.clear();
+
+	// The bottom edge is never decreasing so the first band below the rect top can be found with a binary search
+	auto it = std::partition_point(ClipRects.begin(), ClipRects.end(), [&](const RECT& ClipRect) { return ClipRect.bottom <= Rect.top; });
+
+	for (; it != ClipRects.end() && it->top < Rect.bottom; it++)
+	{
+		const RECT ClippedRect = {
+			(std::max)(Rect.left, it->left),
+			(std::max)(Rect.top, it->top),
+			(std::min)(Rect.right, it->right),
+			(std::min)(Rect.bottom, it->bottom) };
+		if (ClippedRect.left < ClippedRect.right && ClippedRect.top < ClippedRect.bottom)
+		{
+			OutRects.push_back(ClippedRect);
+		}
+	}
+}
@@ -0,0 +1,91 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "DirtyRegion.h"
+
+namespace {
+	inline LONGLONG GetArea(const RECT& Rect)
+	{
+		return (LONGLONG)(Rect.right - Rect.left) * (Rect.bottom - Rect.top);
+	}
+
+	inline RECT GetUnion(const RECT& a, const RECT& b)
+	{
+		return { min(a.left, b.left), min(a.top, b.top), max(a.right, b.right), max(a.bottom, b.bottom) };
+	}
+
+	// Area that merging the two rects would add that neither rect covers
+	LONGLONG GetMergeCost(const RECT& a, const RECT& b)
+	{
+		RECT Overlap = { max(a.left, b.left), max(a.top, b.top), min(a.right, b.right), min(a.bottom, b.bottom) };
+		const LONGLONG OverlapArea = (Overlap.left < Overlap.right && Overlap.top < Overlap.bottom) ? GetArea(Overlap) : 0;
+
+		return GetArea(GetUnion(a, b)) - GetArea(a) - GetArea(b) + OverlapArea;
+	}
+}
+
+void DirtyRegion::Add(const RECT& Rect)
+{
+	if (IsFull || Rect.left >= Rect.right || Rect.top >= Rect.bottom)
+	{
+		return;
+	}
+
+	// Absorb any rects that can be merged without adding extra area
+	RECT NewRect = Rect;
+	for (DWORD x = 0; x < Count; )
+	{
+		if (GetMergeCost(Rects[x], NewRect) <= 0)
+		{
+			NewRect = GetUnion(Rects[x], NewRect);
+			Rects[x] = Rects[--Count];
+			x = 0;
+			continue;
+		}
+		x++;
+	}
+
+	if (Count < MaxRects)
+	{
+		Rects[Count++] = NewRect;
+		return;
+	}
+
+	// Too many rects, merge the pair that adds the least extra area
+	RECT AllRects[MaxRects + 1];
+	memcpy(AllRects, Rects, sizeof(Rects));
+	AllRects[MaxRects] = NewRect;
+
+	DWORD BestA = 0, BestB = 1;
+	LONGLONG BestCost = MAXLONGLONG;
+	for (DWORD a = 0; a < MaxRects + 1; a++)
+	{
+		for (DWORD b = a + 1; b < MaxRects + 1; b++)
+		{
+			const LONGLONG Cost = GetMergeCost(AllRects[a], AllRects[b]);
+			if (Cost < BestCost)
+			{
+				BestCost = Cost;
+				BestA = a;
+				BestB = b;
+			}
+		}
+	}
+
+	AllRects[BestA] = GetUnion(AllRects[BestA], AllRects[BestB]);
+	AllRects[BestB] = AllRects[MaxRects];
+	memcpy(Rects, AllRects, sizeof(Rects));
+}
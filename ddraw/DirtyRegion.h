@@ -0,0 +1,24 @@
+#pragma once
+
+#include <windows.h>
+
+// Accumulates updated rects, merged down to at most MaxRects boxes
+class DirtyRegion
+{
+public:
+	static constexpr DWORD MaxRects = 8;
+
+private:
+	RECT Rects[MaxRects] = {};
+	DWORD Count = 0;
+	bool IsFull = false;
+
+public:
+	void Add(const RECT& Rect);
+	void SetFull() { IsFull = true; Count = 0; }
+	void Clear() { IsFull = false; Count = 0; }
+	bool IsEmpty() const { return !IsFull && Count == 0; }
+	bool IsFullSurface() const { return IsFull; }
+	DWORD GetCount() const { return Count; }
+	const RECT* GetRects() const { return Rects; }
+};
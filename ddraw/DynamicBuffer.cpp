@@ -0,0 +1,27 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ddraw.h"
+
+HRESULT CreateDynamicBuffer(IDirect3DDevice9* d3d9Device, UINT Size, IDirect3DVertexBuffer9** ppBuffer)
+{
+	return d3d9Device->CreateVertexBuffer(Size, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, 0, D3DPOOL_DEFAULT, ppBuffer, nullptr);
+}
+
+HRESULT CreateDynamicBuffer(IDirect3DDevice9* d3d9Device, UINT Size, IDirect3DIndexBuffer9** ppBuffer)
+{
+	return d3d9Device->CreateIndexBuffer(Size, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFMT_INDEX16, D3DPOOL_DEFAULT, ppBuffer, nullptr);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <windows.h>
+#include <d3d9types.h>
+#include <cstring>
+#include "Logging\Logging.h"
+
+struct IDirect3DDevice9;
+struct IDirect3DVertexBuffer9;
+struct IDirect3DIndexBuffer9;
+
+// Creates the write-only dynamic buffer used by DynamicBuffer, there is one overload for each buffer type
+HRESULT CreateDynamicBuffer(IDirect3DDevice9* d3d9Device, UINT Size, IDirect3DVertexBuffer9** ppBuffer);
+HRESULT CreateDynamicBuffer(IDirect3DDevice9* d3d9Device, UINT Size, IDirect3DIndexBuffer9** ppBuffer);
+
+// Streaming buffer for per-draw vertex and index data. Data is appended with NOOVERWRITE and
+// the buffer is only discarded when it wraps, so the driver does not rename it on every draw.
+template <typename T, typename D = IDirect3DDevice9>
+class DynamicBuffer
+{
+private:
+	T* Buffer = nullptr;
+	UINT Size = 0;
+	UINT Position = 0;
+	const UINT MinSize;
+
+public:
+	DynamicBuffer(UINT MinSize) : MinSize(MinSize) {}
+
+	T* GetBuffer() const { return Buffer; }
+	UINT GetSize() const { return Size; }
+
+	// Copies Count elements of Stride bytes and returns the first element's index, or -1 on failure
+	INT Load(D* Device, const void* pSrc, UINT Count, UINT Stride, DWORD LockFlags)
+	{
+		if (!Device || !pSrc || !Count || !Stride)
+		{
+			return -1;
+		}
+
+		const UINT DataSize = Count * Stride;
+
+		// Grow to the next power of two that fits the data
+		if (!Buffer || DataSize > Size)
+		{
+			Release();
+
+			UINT NewSize = MinSize;
+			while (NewSize < DataSize)
+			{
+				NewSize *= 2;
+			}
+
+			HRESULT hr = CreateDynamicBuffer(Device, NewSize, &Buffer);
+			if (FAILED(hr))
+			{
+				LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create dynamic buffer: " << Logging::hex(hr) << " Size: " << NewSize);
+				Buffer = nullptr;
+				return -1;
+			}
+
+			Size = NewSize;
+		}
+
+		// Align to the stride so the offset can be expressed as a start vertex or index
+		UINT Offset = (Position + Stride - 1) / Stride * Stride;
+
+		// Wrap to the start and discard once the buffer is full
+		if (Offset + DataSize > Size)
+		{
+			Offset = 0;
+		}
+
+		DWORD Flags = LockFlags | (Offset == 0 ? D3DLOCK_DISCARD : D3DLOCK_NOOVERWRITE);
+
+		void* pData = nullptr;
+		HRESULT hr = Buffer->Lock(Offset, DataSize, &pData, Flags);
+
+		if (FAILED(hr) && (Flags & D3DLOCK_NOSYSLOCK))
+		{
+			hr = Buffer->Lock(Offset, DataSize, &pData, Flags & ~D3DLOCK_NOSYSLOCK);
+		}
+
+		if (FAILED(hr))
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: failed to lock dynamic buffer: " << Logging::hex(hr));
+			return -1;
+		}
+
+		memcpy(pData, pSrc, DataSize);
+
+		Buffer->Unlock();
+
+		Position = Offset + DataSize;
+
+		return (INT)(Offset / Stride);
+	}
+
+	void Release()
+	{
+		// The device may still hold a reference while the buffer is bound
+		if (Buffer)
+		{
+			Buffer->Release();
+			Buffer = nullptr;
+		}
+		Size = 0;
+		Position = 0;
+	}
+};
+
+using DynamicVertexBuffer = DynamicBuffer<IDirect3DVertexBuffer9>;
+using DynamicIndexBuffer = DynamicBuffer<IDirect3DIndexBuffer9>;
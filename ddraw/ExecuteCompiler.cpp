@@ -0,0 +1,322 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ExecuteCompiler.h"
+#include "Logging\Logging.h"
+#include <algorithm>
+
+namespace {
+	inline bool IsDrawOpcode(BYTE Opcode)
+	{
+		return Opcode == D3DOP_POINT || Opcode == D3DOP_LINE || Opcode == D3DOP_SPAN || Opcode == D3DOP_TRIANGLE;
+	}
+
+	inline D3DPRIMITIVETYPE GetDrawPrimitiveType(BYTE Opcode)
+	{
+		return (Opcode == D3DOP_POINT) ? D3DPT_POINTLIST :
+			(Opcode == D3DOP_TRIANGLE) ? D3DPT_TRIANGLELIST : D3DPT_LINELIST;
+	}
+
+	inline bool IsBranchTarget(const EXECUTECOMMANDLIST& List, DWORD Offset)
+	{
+		return std::binary_search(List.BranchTargets.begin(), List.BranchTargets.end(), Offset);
+	}
+
+	// Rebase the indices of the last draw command so only the vertices it uses need to be uploaded
+	void FinishDrawCommand(EXECUTECOMMANDLIST& List)
+	{
+		if (List.Commands.empty() || !IsDrawOpcode(List.Commands.back().Opcode))
+		{
+			return;
+		}
+
+		EXECUTECOMMAND& Command = List.Commands.back();
+		Command.IndexCount = List.Indices.size() - Command.StartIndex;
+		if (!Command.IndexCount)
+		{
+			return;
+		}
+
+		WORD* pIndices = &List.Indices[Command.StartIndex];
+		WORD MinIndex = 0xFFFF, MaxIndex = 0;
+		for (DWORD i = 0; i < Command.IndexCount; i++)
+		{
+			MinIndex = min(MinIndex, pIndices[i]);
+			MaxIndex = max(MaxIndex, pIndices[i]);
+		}
+		for (DWORD i = 0; i < Command.IndexCount; i++)
+		{
+			pIndices[i] -= MinIndex;
+		}
+
+		Command.BaseVertex = MinIndex;
+		Command.NumVertices = MaxIndex - MinIndex + 1;
+	}
+
+	void AddPoints(std::vector<WORD>& Indices, const D3DPOINT* point, DWORD pointCount, DWORD VertexCount)
+	{
+		for (DWORD i = 0; i < pointCount; i++)
+		{
+			if ((DWORD)point[i].wFirst < VertexCount)
+			{
+				DWORD count = min((DWORD)point[i].wCount, VertexCount - point[i].wFirst);
+
+				for (DWORD x = 0; x < count; x++)
+				{
+					Indices.push_back((WORD)(point[i].wFirst + x));
+				}
+			}
+		}
+	}
+
+	// The vertices of all spans in one instruction are drawn as a single line strip, stored as line segments
+	void AddSpans(std::vector<WORD>& Indices, const D3DSPAN* span, DWORD spanCount, DWORD VertexCount)
+	{
+		bool HasPrev = false;
+		WORD Prev = 0;
+
+		for (DWORD i = 0; i < spanCount; i++)
+		{
+			if ((DWORD)span[i].wFirst < VertexCount)
+			{
+				DWORD count = min((DWORD)span[i].wCount, VertexCount - span[i].wFirst);
+
+				for (DWORD x = 0; x < count; x++)
+				{
+					const WORD Index = (WORD)(span[i].wFirst + x);
+					if (HasPrev)
+					{
+						Indices.push_back(Prev);
+						Indices.push_back(Index);
+					}
+					HasPrev = true;
+					Prev = Index;
+				}
+			}
+		}
+	}
+
+	void AddLines(std::vector<WORD>& Indices, const D3DLINE* line, DWORD lineCount, DWORD VertexCount)
+	{
+		for (DWORD i = 0; i < lineCount; i++)
+		{
+			if (line[i].v1 < VertexCount && line[i].v2 < VertexCount)
+			{
+				Indices.push_back(line[i].v1);
+				Indices.push_back(line[i].v2);
+			}
+		}
+	}
+
+	// START records begin a new triangle, EVEN and ODD records add one vertex to it as a fan or a strip.
+	// The first EVEN or ODD record after a START decides which, matching how the records were drawn before.
+	void AddTriangles(std::vector<WORD>& Indices, const D3DTRIANGLE* triangle, DWORD triangleCount, DWORD VertexCount)
+	{
+		bool IsInRecord = false;
+		bool IsFan = false;
+		DWORD RecordCount = 0;
+		WORD First = 0, Prev1 = 0, Prev2 = 0;
+
+		for (DWORD i = 0; i < triangleCount; i++)
+		{
+			const WORD TriFlags = (triangle[i].wFlags & 0x1F);
+
+			if (TriFlags < D3DTRIFLAG_STARTFLAT(30))
+			{
+				IsInRecord = (triangle[i].v1 < VertexCount && triangle[i].v2 < VertexCount && triangle[i].v3 < VertexCount);
+
+				if (IsInRecord)
+				{
+					Indices.push_back(triangle[i].v1);
+					Indices.push_back(triangle[i].v2);
+					Indices.push_back(triangle[i].v3);
+
+					RecordCount = 1;
+					First = triangle[i].v1;
+					Prev1 = triangle[i].v2;
+					Prev2 = triangle[i].v3;
+				}
+			}
+			else if (IsInRecord && triangle[i].v3 < VertexCount)
+			{
+				const WORD v3 = triangle[i].v3;
+
+				if (RecordCount == 1)
+				{
+					IsFan = (TriFlags == D3DTRIFLAG_EVEN);
+				}
+
+				// Same vertex order as the batched strips and fans, see AppendBatchIndices()
+				if (IsFan)
+				{
+					Indices.push_back(Prev2);
+					Indices.push_back(v3);
+					Indices.push_back(First);
+				}
+				else if (RecordCount & 1)
+				{
+					Indices.push_back(Prev1);
+					Indices.push_back(v3);
+					Indices.push_back(Prev2);
+				}
+				else
+				{
+					Indices.push_back(Prev1);
+					Indices.push_back(Prev2);
+					Indices.push_back(v3);
+				}
+
+				RecordCount++;
+				Prev1 = Prev2;
+				Prev2 = v3;
+			}
+		}
+	}
+}
+
+void CompileExecuteInstructions(EXECUTECOMMANDLIST& List, const BYTE* pInstructions, DWORD InstructionLength, DWORD VertexCount)
+{
+	List.Commands.clear();
+	List.Indices.clear();
+	List.BranchTargets.clear();
+	List.pInstructions = pInstructions;
+	List.IsCompiled = true;
+
+	// Indices are 16-bit
+	VertexCount = min(VertexCount, 0x10000UL);
+
+	const BYTE* instructionEnd = pInstructions + InstructionLength;
+
+	// Instructions after an exit are still compiled since a branch may skip over the exit.
+	// Draws are not merged across branch targets so each target starts its own command.
+	for (const BYTE* instructionData = pInstructions; instructionData + sizeof(D3DINSTRUCTION) <= instructionEnd; )
+	{
+		const D3DINSTRUCTION* instruction = (const D3DINSTRUCTION*)(instructionData);
+		const DWORD instructionSize = sizeof(D3DINSTRUCTION) + (instruction->wCount * instruction->bSize);
+
+		if (instructionData + instructionSize > instructionEnd)
+		{
+			break;
+		}
+
+		if (instruction->bOpcode == D3DOP_BRANCHFORWARD)
+		{
+			const D3DBRANCH* branch = reinterpret_cast<const D3DBRANCH*>(instructionData + sizeof(D3DINSTRUCTION));
+			for (DWORD i = 0; i < instruction->wCount; i++)
+			{
+				if (branch[i].dwOffset)
+				{
+					List.BranchTargets.push_back((DWORD)(instructionData - pInstructions) + branch[i].dwOffset);
+				}
+			}
+		}
+
+		instructionData += instructionSize;
+	}
+	std::sort(List.BranchTargets.begin(), List.BranchTargets.end());
+
+	bool LastWasDraw = false;
+
+	for (const BYTE* instructionData = pInstructions; instructionData + sizeof(D3DINSTRUCTION) <= instructionEnd; )
+	{
+		const D3DINSTRUCTION* instruction = (const D3DINSTRUCTION*)(instructionData);
+		const DWORD instructionSize = sizeof(D3DINSTRUCTION) + (instruction->wCount * instruction->bSize);
+		const DWORD Offset = (DWORD)(instructionData - pInstructions);
+		const BYTE Opcode = instruction->bOpcode;
+		const BYTE* opstruct = instructionData + sizeof(D3DINSTRUCTION);
+
+		if (instructionData + instructionSize > instructionEnd)
+		{
+			break;
+		}
+
+		if (IsDrawOpcode(Opcode))
+		{
+			const D3DPRIMITIVETYPE PrimitiveType = GetDrawPrimitiveType(Opcode);
+
+			// Start a new draw unless this continues the previous one
+			if (!LastWasDraw || List.Commands.back().PrimitiveType != PrimitiveType || IsBranchTarget(List, Offset))
+			{
+				FinishDrawCommand(List);
+
+				EXECUTECOMMAND Command;
+				Command.Offset = Offset;
+				Command.Opcode = Opcode;
+				Command.PrimitiveType = PrimitiveType;
+				Command.StartIndex = List.Indices.size();
+				List.Commands.push_back(Command);
+			}
+
+			switch (Opcode)
+			{
+			case D3DOP_POINT:
+				if (instruction->bSize != sizeof(D3DPOINT))
+				{
+					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_POINT instruction size does not match!");
+				}
+				AddPoints(List.Indices, reinterpret_cast<const D3DPOINT*>(opstruct), instruction->wCount, VertexCount);
+				break;
+			case D3DOP_SPAN:
+				if (instruction->bSize != sizeof(D3DSPAN))
+				{
+					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_SPAN instruction size does not match!");
+				}
+				AddSpans(List.Indices, reinterpret_cast<const D3DSPAN*>(opstruct), instruction->wCount, VertexCount);
+				break;
+			case D3DOP_LINE:
+				if (instruction->bSize != sizeof(D3DLINE))
+				{
+					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_LINE instruction size does not match!");
+				}
+				AddLines(List.Indices, reinterpret_cast<const D3DLINE*>(opstruct), instruction->wCount, VertexCount);
+				break;
+			case D3DOP_TRIANGLE:
+				if (instruction->bSize != sizeof(D3DTRIANGLE))
+				{
+					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_TRIANGLE instruction size does not match!");
+				}
+				AddTriangles(List.Indices, reinterpret_cast<const D3DTRIANGLE*>(opstruct), instruction->wCount, VertexCount);
+				break;
+			}
+
+			LastWasDraw = true;
+		}
+		else
+		{
+			FinishDrawCommand(List);
+
+			EXECUTECOMMAND Command;
+			Command.Offset = Offset;
+			Command.Opcode = Opcode;
+			List.Commands.push_back(Command);
+
+			LastWasDraw = false;
+		}
+
+		instructionData += instructionSize;
+	}
+
+	FinishDrawCommand(List);
+}
+
+// Returns the command starting at the offset, or the end of the list if no command starts there
+size_t FindExecuteCommand(const EXECUTECOMMANDLIST& List, DWORD Offset)
+{
+	auto it = std::lower_bound(List.Commands.begin(), List.Commands.end(), Offset,
+		[](const EXECUTECOMMAND& Command, DWORD Value) { return Command.Offset < Value; });
+
+	return (it != List.Commands.end() && it->Offset == Offset) ? (size_t)(it - List.Commands.begin()) : List.Commands.size();
+}
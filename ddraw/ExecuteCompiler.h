@@ -0,0 +1,30 @@
+#pragma once
+
+#include <windows.h>
+#include <d3d.h>
+#include <vector>
+
+// One replayable command, draw instructions are converted to indexed lists and adjacent ones are merged
+struct EXECUTECOMMAND
+{
+	DWORD Offset = 0;			// Offset of the first instruction from the start of the instruction data
+	BYTE Opcode = 0;
+	D3DPRIMITIVETYPE PrimitiveType = D3DPT_TRIANGLELIST;
+	DWORD BaseVertex = 0;		// Indices are relative to this vertex
+	DWORD NumVertices = 0;
+	DWORD StartIndex = 0;
+	DWORD IndexCount = 0;
+};
+
+// Compiled form of an execute buffer, vectors keep their capacity across compiles
+struct EXECUTECOMMANDLIST
+{
+	bool IsCompiled = false;
+	const BYTE* pInstructions = nullptr;
+	std::vector<EXECUTECOMMAND> Commands;
+	std::vector<WORD> Indices;
+	std::vector<DWORD> BranchTargets;
+};
+
+void CompileExecuteInstructions(EXECUTECOMMANDLIST& List, const BYTE* pInstructions, DWORD InstructionLength, DWORD VertexCount);
+size_t FindExecuteCommand(const EXECUTECOMMANDLIST& List, DWORD Offset);
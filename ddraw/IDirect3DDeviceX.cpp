@@ -381,6 +381,8 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	PROFILE_ZONE(ZONE_EXECUTE);
+
 	if (Config.Dd7to9)
 	{
 		if (!lpDirect3DExecuteBuffer || !lpDirect3DViewport)
@@ -439,8 +441,10 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 		}
 
 		// Pointer to the start of the instruction data
-		BYTE* instructionData = reinterpret_cast<BYTE*>(lpData) + ExecuteData.dwInstructionOffset;
-		BYTE* instructionEnd = instructionData + ExecuteData.dwInstructionLength;
+		BYTE* instructionBase = reinterpret_cast<BYTE*>(lpData) + ExecuteData.dwInstructionOffset;
+
+		// Instructions are compiled once after each lock, draws are already converted to indexed lists
+		const EXECUTECOMMANDLIST& CommandList = pExecuteBuffer->GetCommandList();
 
 		DWORD opcode = NULL;
 
@@ -452,80 +456,30 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 		BYTE* vertexBuffer = reinterpret_cast<BYTE*>(lpData) + ExecuteData.dwHVertexOffset;
 		const DWORD vertexCount = ExecuteData.dwVertexCount;
 
-		// Iterate through the instructions
-		while (instructionData < instructionEnd)
+		// Iterate through the compiled commands
+		size_t CommandIndex = 0;
+		while (CommandIndex < CommandList.Commands.size())
 		{
-			const D3DINSTRUCTION* instruction = (const D3DINSTRUCTION*)(instructionData);
-			const DWORD instructionSize = sizeof(D3DINSTRUCTION) + (instruction->wCount * instruction->bSize);
+			const EXECUTECOMMAND& Command = CommandList.Commands[CommandIndex];
+			const D3DINSTRUCTION* instruction = (const D3DINSTRUCTION*)(instructionBase + Command.Offset);
 
-			opcode = instruction->bOpcode;
-			BYTE* opstruct = instructionData + sizeof(D3DINSTRUCTION);
+			opcode = Command.Opcode;
+			BYTE* opstruct = instructionBase + Command.Offset + sizeof(D3DINSTRUCTION);
 
-			if (opcode == D3DOP_EXIT || instructionData + instructionSize > instructionEnd)
-			{
-				break;
-			}
-
-			bool Branched = false;
+			size_t NextCommandIndex = CommandIndex + 1;
 
 			switch (opcode)
 			{
 			case D3DOP_POINT:
 				// Sends a point to the renderer. Operand data is described by the D3DPOINT structure.
-			{
-				D3DPOINT* point = reinterpret_cast<D3DPOINT*>(opstruct);
-
-				if (instruction->bSize != sizeof(D3DPOINT))
-				{
-					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_POINT instruction size does not match!");
-				}
-
-				DrawExecutePoint(point, instruction->wCount, vertexCount, vertexBuffer, VertexTypeDesc);
-
-				break;
-			}
 			case D3DOP_SPAN:
 				// Spans a list of points with the same y value. For more information, see the D3DSPAN structure.
-			{
-				D3DSPAN* span = reinterpret_cast<D3DSPAN*>(opstruct);
-
-				if (instruction->bSize != sizeof(D3DSPAN))
-				{
-					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_SPAN instruction size does not match!");
-				}
-
-				DrawExecuteSpan(span, instruction->wCount, vertexCount, vertexBuffer, VertexTypeDesc);
-
-				break;
-			}
 			case D3DOP_LINE:
 				// Sends a line to the renderer. Operand data is described by the D3DLINE structure.
-			{
-				D3DLINE* line = reinterpret_cast<D3DLINE*>(opstruct);
-
-				if (instruction->bSize != sizeof(D3DLINE))
-				{
-					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_LINE instruction size does not match!");
-				}
-
-				DrawExecuteLine(line, instruction->wCount, vertexCount, vertexBuffer, VertexTypeDesc);
-
-				break;
-			}
 			case D3DOP_TRIANGLE:
 				// Sends a triangle to the renderer. Operand data is described by the D3DTRIANGLE structure.
-			{
-				D3DTRIANGLE* triangle = reinterpret_cast<D3DTRIANGLE*>(opstruct);
-
-				if (instruction->bSize != sizeof(D3DTRIANGLE))
-				{
-					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_TRIANGLE instruction size does not match!");
-				}
-
-				DrawExecuteTriangle(triangle, instruction->wCount, vertexCount, vertexBuffer, VertexTypeDesc);
-
+				DrawExecuteCommand(Command, CommandList, vertexBuffer, VertexTypeDesc);
 				break;
-			}
 			case D3DOP_MATRIXLOAD:
 				// Triggers a data transfer in the rendering engine. Operand data is described by the D3DMATRIXLOAD structure.
 			{
@@ -694,10 +648,6 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 					LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DOP_PROCESSVERTICES instruction size does not match!");
 				}
 
-#ifdef ENABLE_PROFILING
-				auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 				bool IsHVertexUsed = false;
 
 				HRESULT hr = D3D_OK;
@@ -778,12 +728,13 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 						D3DVERTEX* srcVertices = reinterpret_cast<D3DVERTEX*>(inputVerts) + processVertices[i].wStart;
 						D3DTLVERTEX* destVertices = reinterpret_cast<D3DTLVERTEX*>(outputVerts) + processVertices[i].wDest;
 
-						hr = m_IDirect3DVertexBufferX::TransformVertexUP(this, srcVertices, destVertices, nullptr, Count, drExtent, IsLight, UpdateExtents);
+						DWORD ClipStatus = 0;
+						hr = m_IDirect3DVertexBufferX::TransformVertexUP(this, srcVertices, destVertices, nullptr, Count, drExtent, &ClipStatus, IsLight, UpdateExtents);
 
 						if (SUCCEEDED(hr))
 						{
 							lpStatus->dwFlags |= D3DSETSTATUS_STATUS;
-							lpStatus->dwStatus = 0; // Just set no clip flags and no ZNOTVISIBLE
+							lpStatus->dwStatus = ClipStatus; // Clip union and intersection, no ZNOTVISIBLE
 
 							if (UpdateExtents)
 							{
@@ -797,10 +748,6 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 					}
 				}
 
-#ifdef ENABLE_PROFILING
-				Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 				break;
 			}
 			case D3DOP_SETSTATUS:
@@ -870,10 +817,9 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 						}
 						else
 						{
-							// Move the instruction pointer forward by the offset
-							instructionData += branch->dwOffset;
+							// Move forward by the offset, a target that is not the start of an instruction ends the buffer
+							NextCommandIndex = FindExecuteCommand(CommandList, Command.Offset + branch[i].dwOffset);
 						}
-						Branched = true;
 						break; // only branch once
 					}
 				}
@@ -895,11 +841,8 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 				break;
 			}
 
-			// Move to the next instruction if not branched
-			if (!Branched)
-			{
-				instructionData += instructionSize;
-			}
+			// Move to the next command
+			CommandIndex = NextCommandIndex;
 		}
 
 		return D3D_OK;
@@ -1308,6 +1251,7 @@ HRESULT m_IDirect3DDeviceX::DeleteMatrix(D3DMATRIXHANDLE D3DMatHandle)
 HRESULT m_IDirect3DDeviceX::BeginScene()
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this);
 
 	if (Config.Dd7to9)
 	{
@@ -1319,6 +1263,9 @@ HRESULT m_IDirect3DDeviceX::BeginScene()
 
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
+		// Draw queued primitives first
+		FlushDrawBatch();
+
 		// Set 3D Enabled
 		ddrawParent->Enable3D();
 
@@ -1328,11 +1275,6 @@ HRESULT m_IDirect3DDeviceX::BeginScene()
 		{
 			IsInScene = true;
 
-#ifdef ENABLE_PROFILING
-			Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr;
-			sceneTime = std::chrono::high_resolution_clock::now();
-#endif
-
 			PrepDevice();
 		}
 
@@ -1357,6 +1299,9 @@ HRESULT m_IDirect3DDeviceX::BeginScene()
 HRESULT m_IDirect3DDeviceX::EndScene()
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this);
+
+	PROFILE_ZONE(ZONE_ENDSCENE);
 
 	if (Config.Dd7to9)
 	{
@@ -1372,12 +1317,11 @@ HRESULT m_IDirect3DDeviceX::EndScene()
 		HRESULT hr;
 
 		{
-#ifdef ENABLE_PROFILING
-			auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 			ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
+			// Draw queued primitives first
+			FlushDrawBatch();
+
 			hr = (*d3d9Device)->EndScene();
 
 			if (SUCCEEDED(hr))
@@ -1385,9 +1329,6 @@ HRESULT m_IDirect3DDeviceX::EndScene()
 				IsInScene = false;
 			}
 
-#ifdef ENABLE_PROFILING
-			Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
 		}
 
 		if (SUCCEEDED(hr) && lpCurrentRenderTargetX)
@@ -1395,10 +1336,6 @@ HRESULT m_IDirect3DDeviceX::EndScene()
 			lpCurrentRenderTargetX->EndWritePresent(nullptr, 0, false, false);
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") Full Scene Time = " << Logging::GetTimeLapseInMS(sceneTime);
-#endif
-
 		return hr;
 	}
 
@@ -1625,6 +1562,9 @@ HRESULT m_IDirect3DDeviceX::SetRenderTarget(LPDIRECTDRAWSURFACE7 lpNewRenderTarg
 
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
+		// Draw queued primitives first
+		FlushDrawBatch();
+
 		HRESULT hr = ddrawParent->SetRenderTargetSurface(lpDDSrcSurfaceX);
 
 		if (SUCCEEDED(hr))
@@ -2004,6 +1944,7 @@ HRESULT m_IDirect3DDeviceX::End(DWORD dwFlags, DWORD DirectXVersion)
 HRESULT m_IDirect3DDeviceX::GetRenderState(D3DRENDERSTATETYPE dwRenderStateType, LPDWORD lpdwRenderState)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ") " << dwRenderStateType;
+	LOG_TRACE(this, dwRenderStateType);
 
 	if (Config.Dd7to9)
 	{
@@ -2192,6 +2133,7 @@ HRESULT m_IDirect3DDeviceX::GetRenderState(D3DRENDERSTATETYPE dwRenderStateType,
 HRESULT m_IDirect3DDeviceX::SetRenderState(D3DRENDERSTATETYPE dwRenderStateType, DWORD dwRenderState)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ") " << dwRenderStateType << " " << dwRenderState;
+	LOG_TRACE(this, dwRenderStateType, dwRenderState);
 
 	if (Config.Dd7to9)
 	{
@@ -2430,7 +2372,7 @@ HRESULT m_IDirect3DDeviceX::SetRenderState(D3DRENDERSTATETYPE dwRenderStateType,
 		case D3DRENDERSTATE_BLENDENABLE:		// 27
 			if (ClientDirectXVersion == 1)
 			{
-				DeviceStates.RenderState[D3DRENDERSTATE_COLORKEYENABLE].State = dwRenderState;
+				SetStateBlockRenderState(D3DRENDERSTATE_COLORKEYENABLE, dwRenderState);
 			}
 			break;
 		case D3DRENDERSTATE_ZVISIBLE:			// 30
@@ -2667,6 +2609,7 @@ HRESULT m_IDirect3DDeviceX::GetLightState(D3DLIGHTSTATETYPE dwLightStateType, LP
 HRESULT m_IDirect3DDeviceX::SetLightState(D3DLIGHTSTATETYPE dwLightStateType, DWORD dwLightState)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ") " << dwLightStateType << " " << dwLightState;
+	LOG_TRACE(this, dwLightStateType, dwLightState);
 
 	if (Config.Dd7to9)
 	{
@@ -2736,6 +2679,7 @@ HRESULT m_IDirect3DDeviceX::SetLightState(D3DLIGHTSTATETYPE dwLightStateType, DW
 HRESULT m_IDirect3DDeviceX::SetTransform(D3DTRANSFORMSTATETYPE dtstTransformStateType, LPD3DMATRIX lpD3DMatrix)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this, dtstTransformStateType, lpD3DMatrix);
 
 	if (Config.Dd7to9)
 	{
@@ -2849,6 +2793,7 @@ HRESULT m_IDirect3DDeviceX::GetTransform(D3DTRANSFORMSTATETYPE dtstTransformStat
 HRESULT m_IDirect3DDeviceX::MultiplyTransform(D3DTRANSFORMSTATETYPE dtstTransformStateType, LPD3DMATRIX lpD3DMatrix)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this, dtstTransformStateType, lpD3DMatrix);
 
 	if (Config.Dd7to9)
 	{
@@ -2900,6 +2845,9 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitive(D3DPRIMITIVETYPE dptPrimitiveType, DWO
 		" VertexCount = " << dwVertexCount <<
 		" Flags = " << Logging::hex(dwFlags) <<
 		" Version = " << DirectXVersion;
+	LOG_TRACE(this, dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, dwFlags, DirectXVersion);
+
+	PROFILE_ZONE(ZONE_DRAWPRIMITIVE);
 
 	if (Config.Dd7to9)
 	{
@@ -2929,10 +2877,6 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitive(D3DPRIMITIVETYPE dptPrimitiveType, DWO
 			return DDERR_INVALIDOBJECT;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
 		dwFlags = (dwFlags & D3DDP_FORCE_DWORD);
@@ -2940,6 +2884,12 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitive(D3DPRIMITIVETYPE dptPrimitiveType, DWO
 		// Update vertices for Direct3D9 (needs to be first)
 		UpdateVertices(dwVertexTypeDesc, lpVertices, 0, dwVertexCount);
 
+		// Queue the draw if it can be merged with the previous draws
+		if (Config.DdrawBatchPrimitives && AddToDrawBatch(dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, nullptr, 0, dwFlags, DirectXVersion))
+		{
+			return D3D_OK;
+		}
+
 		// Set fixed function vertex type
 		if (FAILED((*d3d9Device)->SetFVF(dwVertexTypeDesc)))
 		{
@@ -2950,21 +2900,17 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitive(D3DPRIMITIVETYPE dptPrimitiveType, DWO
 		// Handle dwFlags
 		SetDrawStates(dwVertexTypeDesc, dwFlags, DirectXVersion);
 
-		// Draw primitive UP
-		HRESULT hr = (*d3d9Device)->DrawPrimitiveUP(dptPrimitiveType, GetNumberOfPrimitives(dptPrimitiveType, dwVertexCount), lpVertices, GetVertexStride(dwVertexTypeDesc));
+		// Draw primitive from the streaming buffer
+		HRESULT hr = DrawStreamedPrimitive(dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, nullptr, 0);
 
 		// Handle dwFlags
 		RestoreDrawStates(hr, dwFlags, DirectXVersion);
 
 		if (FAILED(hr))
 		{
-			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawPrimitiveUP' call failed: " << (D3DERR)hr);
+			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawPrimitive' call failed: " << (D3DERR)hr);
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -2993,6 +2939,9 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitive(D3DPRIMITIVETYPE dptPrimitiveTy
 		" IndexCount = " << dwIndexCount <<
 		" Flags = " << Logging::hex(dwFlags) <<
 		" Version = " << DirectXVersion;
+	LOG_TRACE(this, dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, lpwIndices, dwIndexCount, dwFlags, DirectXVersion);
+
+	PROFILE_ZONE(ZONE_DRAWINDEXEDPRIMITIVE);
 
 	if (Config.Dd7to9)
 	{
@@ -3022,10 +2971,6 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitive(D3DPRIMITIVETYPE dptPrimitiveTy
 			return DDERR_INVALIDOBJECT;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
 		dwFlags = (dwFlags & D3DDP_FORCE_DWORD);
@@ -3033,6 +2978,12 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitive(D3DPRIMITIVETYPE dptPrimitiveTy
 		// Update vertices for Direct3D9 (needs to be first)
 		UpdateVertices(dwVertexTypeDesc, lpVertices, 0, dwVertexCount);
 
+		// Queue the draw if it can be merged with the previous draws
+		if (Config.DdrawBatchPrimitives && AddToDrawBatch(dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, lpwIndices, dwIndexCount, dwFlags, DirectXVersion))
+		{
+			return D3D_OK;
+		}
+
 		// Set fixed function vertex type
 		if (FAILED((*d3d9Device)->SetFVF(dwVertexTypeDesc)))
 		{
@@ -3043,21 +2994,17 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitive(D3DPRIMITIVETYPE dptPrimitiveTy
 		// Handle dwFlags
 		SetDrawStates(dwVertexTypeDesc, dwFlags, DirectXVersion);
 
-		// Draw indexed primitive UP
-		HRESULT hr = (*d3d9Device)->DrawIndexedPrimitiveUP(dptPrimitiveType, 0, dwVertexCount, GetNumberOfPrimitives(dptPrimitiveType, dwIndexCount), lpwIndices, D3DFMT_INDEX16, lpVertices, GetVertexStride(dwVertexTypeDesc));
+		// Draw indexed primitive from the streaming buffers
+		HRESULT hr = DrawStreamedPrimitive(dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, lpwIndices, dwIndexCount);
 
 		// Handle dwFlags
 		RestoreDrawStates(hr, dwFlags, DirectXVersion);
 
 		if (FAILED(hr))
 		{
-			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawIndexedPrimitiveUP' call failed: " << (D3DERR)hr);
+			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawIndexedPrimitive' call failed: " << (D3DERR)hr);
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -3168,6 +3115,9 @@ HRESULT m_IDirect3DDeviceX::GetClipStatus(LPD3DCLIPSTATUS lpD3DClipStatus)
 HRESULT m_IDirect3DDeviceX::DrawPrimitiveStrided(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, LPD3DDRAWPRIMITIVESTRIDEDDATA lpVertexArray, DWORD dwVertexCount, DWORD dwFlags, DWORD DirectXVersion)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this, dptPrimitiveType, dwVertexTypeDesc, lpVertexArray, dwVertexCount, dwFlags, DirectXVersion);
+
+	PROFILE_ZONE(ZONE_DRAWPRIMITIVESTRIDED);
 
 	if (Config.Dd7to9)
 	{
@@ -3197,12 +3147,11 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitiveStrided(D3DPRIMITIVETYPE dptPrimitiveTy
 			return DDERR_INVALIDOBJECT;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
+		// Draw queued primitives first
+		FlushDrawBatch();
+
 		dwFlags = (dwFlags & D3DDP_FORCE_DWORD);
 
 		// Update vertex desc type (FVF) before interleaving
@@ -3225,21 +3174,17 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitiveStrided(D3DPRIMITIVETYPE dptPrimitiveTy
 		// Handle dwFlags
 		SetDrawStates(dwVertexTypeDesc, dwFlags, DirectXVersion);
 
-		// Draw primitive UP
-		HRESULT hr = (*d3d9Device)->DrawPrimitiveUP(dptPrimitiveType, GetNumberOfPrimitives(dptPrimitiveType, dwVertexCount), VertexCache.data(), GetVertexStride(dwVertexTypeDesc));
+		// Draw primitive from the streaming buffer
+		HRESULT hr = DrawStreamedPrimitive(dptPrimitiveType, dwVertexTypeDesc, VertexCache.data(), dwVertexCount, nullptr, 0);
 
 		// Handle dwFlags
 		RestoreDrawStates(hr, dwFlags, DirectXVersion);
 
 		if (FAILED(hr))
 		{
-			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawPrimitiveUP' call failed: " << (D3DERR)hr);
+			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawPrimitive' call failed: " << (D3DERR)hr);
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -3259,6 +3204,9 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitiveStrided(D3DPRIMITIVETYPE dptPrimitiveTy
 HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitiveStrided(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, LPD3DDRAWPRIMITIVESTRIDEDDATA lpVertexArray, DWORD dwVertexCount, LPWORD lpwIndices, DWORD dwIndexCount, DWORD dwFlags, DWORD DirectXVersion)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this, dptPrimitiveType, dwVertexTypeDesc, lpVertexArray, dwVertexCount, lpwIndices, dwIndexCount, dwFlags, DirectXVersion);
+
+	PROFILE_ZONE(ZONE_DRAWINDEXEDPRIMITIVESTRIDED);
 
 	if (Config.Dd7to9)
 	{
@@ -3288,12 +3236,11 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitiveStrided(D3DPRIMITIVETYPE dptPrim
 			return DDERR_INVALIDOBJECT;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
+		// Draw queued primitives first
+		FlushDrawBatch();
+
 		dwFlags = (dwFlags & D3DDP_FORCE_DWORD);
 
 		// Update vertex desc type (FVF) before interleaving
@@ -3316,21 +3263,17 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitiveStrided(D3DPRIMITIVETYPE dptPrim
 		// Handle dwFlags
 		SetDrawStates(dwVertexTypeDesc, dwFlags, DirectXVersion);
 
-		// Draw indexed primitive UP
-		HRESULT hr = (*d3d9Device)->DrawIndexedPrimitiveUP(dptPrimitiveType, 0, dwVertexCount, GetNumberOfPrimitives(dptPrimitiveType, dwIndexCount), lpwIndices, D3DFMT_INDEX16, VertexCache.data(), GetVertexStride(dwVertexTypeDesc));
+		// Draw indexed primitive from the streaming buffers
+		HRESULT hr = DrawStreamedPrimitive(dptPrimitiveType, dwVertexTypeDesc, VertexCache.data(), dwVertexCount, lpwIndices, dwIndexCount);
 
 		// Handle dwFlags
 		RestoreDrawStates(hr, dwFlags, DirectXVersion);
 
 		if (FAILED(hr))
 		{
-			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawIndexedPrimitiveUP' call failed: " << (D3DERR)hr);
+			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawIndexedPrimitive' call failed: " << (D3DERR)hr);
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -3356,6 +3299,9 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitiveVB(D3DPRIMITIVETYPE dptPrimitiveType, L
 		" NumVertices = " << dwNumVertices <<
 		" Flags = " << Logging::hex(dwFlags) <<
 		" Version = " << DirectXVersion;
+	LOG_TRACE(this, dptPrimitiveType, lpd3dVertexBuffer, dwStartVertex, dwNumVertices, dwFlags, DirectXVersion);
+
+	PROFILE_ZONE(ZONE_DRAWPRIMITIVEVB);
 
 	if (Config.Dd7to9)
 	{
@@ -3375,12 +3321,11 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitiveVB(D3DPRIMITIVETYPE dptPrimitiveType, L
 			return DDERR_INVALIDOBJECT;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
+		// Draw queued primitives first
+		FlushDrawBatch();
+
 		dwFlags = (dwFlags & D3DDP_FORCE_DWORD);
 
 		m_IDirect3DVertexBufferX* pVertexBufferX = nullptr;
@@ -3424,10 +3369,6 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitiveVB(D3DPRIMITIVETYPE dptPrimitiveType, L
 			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawPrimitive' call failed: " << (D3DERR)hr);
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -3460,6 +3401,9 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitiveVB(D3DPRIMITIVETYPE dptPrimitive
 		" IndexCount = " << dwIndexCount <<
 		" Flags = " << Logging::hex(dwFlags) <<
 		" Version = " << DirectXVersion;
+	LOG_TRACE(this, dptPrimitiveType, lpd3dVertexBuffer, dwStartVertex, dwNumVertices, lpwIndices, dwIndexCount, dwFlags, DirectXVersion);
+
+	PROFILE_ZONE(ZONE_DRAWINDEXEDPRIMITIVEVB);
 
 	if (Config.Dd7to9)
 	{
@@ -3479,12 +3423,11 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitiveVB(D3DPRIMITIVETYPE dptPrimitive
 			return DDERR_INVALIDOBJECT;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
+		// Draw queued primitives first
+		FlushDrawBatch();
+
 		dwFlags = (dwFlags & D3DDP_FORCE_DWORD);
 
 		m_IDirect3DVertexBufferX* pVertexBufferX = nullptr;
@@ -3511,7 +3454,8 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitiveVB(D3DPRIMITIVETYPE dptPrimitive
 			return DDERR_INVALIDPARAMS;
 		}
 
-		LPDIRECT3DINDEXBUFFER9 d3d9IndexBuffer = ddrawParent->GetIndexBuffer(lpwIndices, dwIndexCount);
+		UINT StartIndex = 0;
+		LPDIRECT3DINDEXBUFFER9 d3d9IndexBuffer = ddrawParent->GetIndexBuffer(lpwIndices, dwIndexCount, StartIndex);
 		if (!d3d9IndexBuffer)
 		{
 			LOG_LIMIT(100, __FUNCTION__ << " Error: could not get d3d9 index buffer!");
@@ -3528,7 +3472,7 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitiveVB(D3DPRIMITIVETYPE dptPrimitive
 		SetDrawStates(FVF, dwFlags, DirectXVersion);
 
 		// Draw primitive
-		HRESULT hr = (*d3d9Device)->DrawIndexedPrimitive(dptPrimitiveType, dwStartVertex, 0, dwNumVertices, 0, GetNumberOfPrimitives(dptPrimitiveType, dwIndexCount));
+		HRESULT hr = (*d3d9Device)->DrawIndexedPrimitive(dptPrimitiveType, dwStartVertex, 0, dwNumVertices, StartIndex, GetNumberOfPrimitives(dptPrimitiveType, dwIndexCount));
 
 		// Handle dwFlags
 		RestoreDrawStates(hr, dwFlags, DirectXVersion);
@@ -3538,10 +3482,6 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitiveVB(D3DPRIMITIVETYPE dptPrimitive
 			LOG_LIMIT(100, __FUNCTION__ << " Error: 'DrawIndexedPrimitive' call failed: " << (D3DERR)hr);
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -3659,6 +3599,7 @@ HRESULT m_IDirect3DDeviceX::GetTexture(DWORD dwStage, LPDIRECT3DTEXTURE2* lplpTe
 HRESULT m_IDirect3DDeviceX::SetTexture(DWORD dwStage, LPDIRECT3DTEXTURE2 lpTexture)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this, dwStage, lpTexture);
 
 	if (Config.Dd7to9)
 	{
@@ -3791,6 +3732,7 @@ HRESULT m_IDirect3DDeviceX::GetTextureStageState(DWORD dwStage, D3DTEXTURESTAGES
 HRESULT m_IDirect3DDeviceX::SetTextureStageState(DWORD dwStage, D3DTEXTURESTAGESTATETYPE dwState, DWORD dwValue)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this, dwStage, dwState, dwValue);
 
 	if (Config.Dd7to9)
 	{
@@ -3882,10 +3824,6 @@ HRESULT m_IDirect3DDeviceX::ValidateDevice(LPDWORD lpdwPasses)
 			return DDERR_INVALIDOBJECT;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
 		PrepDevice();
@@ -3913,10 +3851,6 @@ HRESULT m_IDirect3DDeviceX::ValidateDevice(LPDWORD lpdwPasses)
 			LOG_LIMIT(100, __FUNCTION__ << " Error: ValidateDevice() function failed: " << (DDERR)hr);
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -4093,6 +4027,9 @@ HRESULT m_IDirect3DDeviceX::Clear(DWORD dwCount, LPD3DRECT lpRects, DWORD dwFlag
 
 		ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
+		// Draw queued primitives first
+		FlushDrawBatch();
+
 		// Clear respects the current viewport
 		(*d3d9Device)->SetViewport(&DeviceStates.Viewport.FixedView);
 
@@ -4382,6 +4319,7 @@ HRESULT m_IDirect3DDeviceX::GetTexture(DWORD dwStage, LPDIRECTDRAWSURFACE7* lplp
 HRESULT m_IDirect3DDeviceX::SetTexture(DWORD dwStage, LPDIRECTDRAWSURFACE7 lpSurface)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
+	LOG_TRACE(this, dwStage, lpSurface);
 
 	if (Config.Dd7to9)
 	{
@@ -4420,6 +4358,11 @@ HRESULT m_IDirect3DDeviceX::SetTexture(DWORD dwStage, LPDIRECTDRAWSURFACE7 lpSur
 			}
 		}
 
+		if (CurrentTextureSurfaceX[dwStage] != lpDDSrcSurfaceX)
+		{
+			FlushDrawBatch();
+		}
+
 		AttachedTexture[dwStage] = lpSurface;
 		CurrentTextureSurfaceX[dwStage] = lpDDSrcSurfaceX;
 
@@ -4456,6 +4399,9 @@ HRESULT m_IDirect3DDeviceX::ApplyStateBlock(DWORD dwBlockHandle)
 			return D3D_OK;
 		}
 
+		// Draw queued primitives first
+		FlushDrawBatch();
+
 		D3DSTATEBLOCKTYPE Type = StateBlock.Data[dwBlockHandle].Type;
 
 		switch (Type)
@@ -4470,24 +4416,20 @@ HRESULT m_IDirect3DDeviceX::ApplyStateBlock(DWORD dwBlockHandle)
 				const auto& RecordState = StateBlock.Data[dwBlockHandle].RecordState.value();
 
 				// Restore states
-				for (const auto& entry : RecordState.RenderState)
-				{
-					SetD9RenderState(entry.first, entry.second);
-				}
-				for (const auto& entry : RecordState.UnmappedRenderState)
-				{
-					DeviceStates.RenderState[entry.first].State = entry.second;
-				}
+				RecordState.RenderState.ForEach([&](UINT State, DWORD Value) {
+					SetD9RenderState((D3DRENDERSTATETYPE)State, Value);
+				});
+				RecordState.UnmappedRenderState.ForEach([&](UINT State, DWORD Value) {
+					DeviceStates.RenderState[State].State = Value;
+				});
 				for (UINT x = 0; x < D3DHAL_TSS_MAXSTAGES; x++)
 				{
-					for (const auto& entry : RecordState.TextureStageState[x])
-					{
-						SetD9TextureStageState(x, entry.first, entry.second);
-					}
-					for (const auto& entry : RecordState.SamplerState[x])
-					{
-						SetD9SamplerState(x, entry.first, entry.second);
-					}
+					RecordState.TextureStageState[x].ForEach([&](UINT Type, DWORD Value) {
+						SetD9TextureStageState(x, (D3DTEXTURESTAGESTATETYPE)Type, Value);
+					});
+					RecordState.SamplerState[x].ForEach([&](UINT Type, DWORD Value) {
+						SetD9SamplerState(x, (D3DSAMPLERSTATETYPE)Type, Value);
+					});
 				}
 				for (const auto& entry : RecordState.Light)
 				{
@@ -5074,6 +5016,61 @@ HRESULT m_IDirect3DDeviceX::SetViewportData(VIEWPORTINFO& Viewport)
 	return D3D_OK;
 }
 
+HRESULT m_IDirect3DDeviceX::GetViewportTransform(VIEWPORTTRANSFORM& Transform)
+{
+	D3DVIEWPORT7 View = {};
+	HRESULT hr = GetViewport(&View);
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// Include the viewport scale set by older viewport versions
+	float ScaleX = 1.0f, ScaleY = 1.0f;
+	if (DeviceStates.Viewport.UseViewportScale)
+	{
+		ScaleX = (fabsf(DeviceStates.Viewport.Scale.x) > 1e-6f) ? DeviceStates.Viewport.Scale.x : 1.0f;
+		ScaleY = (fabsf(DeviceStates.Viewport.Scale.y) > 1e-6f) ? DeviceStates.Viewport.Scale.y : 1.0f;
+	}
+
+	Transform = MakeViewportTransform(View, ScaleX, ScaleY);
+
+	return D3D_OK;
+}
+
+void m_IDirect3DDeviceX::MergeClipStatus(DWORD ClipUnion, DWORD ClipIntersection, const D3DVECTOR* pExtentMin, const D3DVECTOR* pExtentMax)
+{
+	// Union accumulates, intersection only keeps planes that every vertex so far is outside of
+	D3DClipStatus.dwFlags |= D3DCLIPSTATUS_STATUS;
+	D3DClipStatus.dwStatus |= (ClipUnion & D3DSTATUS_CLIPUNIONALL);
+	D3DClipStatus.dwStatus &= ~(D3DCLIP_FRUSTUM << 12) | ((ClipIntersection & D3DCLIP_FRUSTUM) << 12);
+
+	if (pExtentMin && pExtentMax && pExtentMin->x <= pExtentMax->x)
+	{
+		if (D3DClipStatus.dwFlags & (D3DCLIPSTATUS_EXTENTS2 | D3DCLIPSTATUS_EXTENTS3))
+		{
+			D3DClipStatus.minx = min(D3DClipStatus.minx, pExtentMin->x);
+			D3DClipStatus.maxx = max(D3DClipStatus.maxx, pExtentMax->x);
+			D3DClipStatus.miny = min(D3DClipStatus.miny, pExtentMin->y);
+			D3DClipStatus.maxy = max(D3DClipStatus.maxy, pExtentMax->y);
+		}
+		else
+		{
+			D3DClipStatus.dwFlags |= D3DCLIPSTATUS_EXTENTS2;
+			D3DClipStatus.minx = pExtentMin->x;
+			D3DClipStatus.maxx = pExtentMax->x;
+			D3DClipStatus.miny = pExtentMin->y;
+			D3DClipStatus.maxy = pExtentMax->y;
+		}
+
+		if (D3DClipStatus.dwFlags & D3DCLIPSTATUS_EXTENTS3)
+		{
+			D3DClipStatus.minz = min(D3DClipStatus.minz, pExtentMin->z);
+			D3DClipStatus.maxz = max(D3DClipStatus.maxz, pExtentMax->z);
+		}
+	}
+}
+
 bool m_IDirect3DDeviceX::DeleteAttachedViewport(LPDIRECT3DVIEWPORT3 ViewportX)
 {
 	auto it = std::find_if(AttachedViewports.begin(), AttachedViewports.end(),
@@ -5355,32 +5352,6 @@ void m_IDirect3DDeviceX::ClearExecuteBuffer(m_IDirect3DExecuteBuffer* lpExecuteB
 	}
 }
 
-void m_IDirect3DDeviceX::CopyConvertExecuteVertex(BYTE*& DestVertex, DWORD& DestVertexCount, BYTE* SrcVertex, DWORD SrcIndex, DWORD VertexTypeDesc)
-{
-	// Primitive structures and related defines. Vertex offsets are to types D3DVERTEX, D3DLVERTEX, or D3DTLVERTEX.
-	if (VertexTypeDesc == D3DFVF_VERTEX)
-	{
-		DestVertexCount++;
-		*((D3DVERTEX*)DestVertex) = ((D3DVERTEX*)SrcVertex)[SrcIndex];
-		DestVertex += sizeof(D3DVERTEX);
-		return;
-	}
-	else if (VertexTypeDesc == D3DFVF_LVERTEX)
-	{
-		DestVertexCount++;
-		*((D3DLVERTEX*)DestVertex) = ((D3DLVERTEX*)SrcVertex)[SrcIndex];
-		DestVertex += sizeof(D3DLVERTEX);
-		return;
-	}
-	else if (VertexTypeDesc == D3DFVF_TLVERTEX)
-	{
-		DestVertexCount++;
-		*((D3DTLVERTEX*)DestVertex) = ((D3DTLVERTEX*)SrcVertex)[SrcIndex];
-		DestVertex += sizeof(D3DTLVERTEX);
-		return;
-	}
-}
-
 void m_IDirect3DDeviceX::MergeExecuteExtents(D3DRECT& currentExtent, D3DRECT& newExtent, DWORD& dwFlags)
 {
 	if (!IsRectZero(newExtent))
@@ -5404,202 +5375,132 @@ void m_IDirect3DDeviceX::MergeExecuteExtents(D3DRECT& currentExtent, D3DRECT& ne
 	}
 }
 
-HRESULT m_IDirect3DDeviceX::DrawExecutePoint(D3DPOINT* point, WORD pointCount, DWORD vertexIndexCount, BYTE* vertexBuffer, DWORD VertexTypeDesc)
+HRESULT m_IDirect3DDeviceX::DrawStreamedPrimitive(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, LPVOID lpVertices, DWORD dwVertexCount, LPWORD lpwIndices, DWORD dwIndexCount)
 {
-	// Define vertices and setup vector
-	std::vector<BYTE, aligned_allocator<BYTE, 4>> vertices;
-	vertices.resize(sizeof(D3DTLVERTEX) * pointCount);
-	BYTE* verticesData = vertices.data();
-	DWORD verticesCount = 0;
+	const UINT Stride = GetVertexStride(dwVertexTypeDesc);
 
-	// Add vertices to vector
-	for (DWORD i = 0; i < pointCount; i++)
+	// Append the data to the streaming buffers
+	UINT StartVertex = 0, StartIndex = 0;
+	LPDIRECT3DVERTEXBUFFER9 d3d9VertexBuffer = ddrawParent->GetVertexBuffer(lpVertices, dwVertexCount, Stride, StartVertex);
+	LPDIRECT3DINDEXBUFFER9 d3d9IndexBuffer = (d3d9VertexBuffer && lpwIndices) ? ddrawParent->GetIndexBuffer(lpwIndices, dwIndexCount, StartIndex) : nullptr;
+
+	// Fall back to user pointer draws if the streaming buffers are not available
+	if (!d3d9VertexBuffer || (lpwIndices && !d3d9IndexBuffer))
 	{
-		if ((DWORD)point[i].wFirst < vertexIndexCount)
+		if (lpwIndices)
 		{
-			DWORD count = min(point[i].wCount, vertexIndexCount - point[i].wFirst);
-
-			for (DWORD x = 0; x < count; x++)
-			{
-				CopyConvertExecuteVertex(verticesData, verticesCount, vertexBuffer, point[i].wFirst + x, VertexTypeDesc);
-			}
+			return (*d3d9Device)->DrawIndexedPrimitiveUP(dptPrimitiveType, 0, dwVertexCount, GetNumberOfPrimitives(dptPrimitiveType, dwIndexCount), lpwIndices, D3DFMT_INDEX16, lpVertices, Stride);
 		}
+		return (*d3d9Device)->DrawPrimitiveUP(dptPrimitiveType, GetNumberOfPrimitives(dptPrimitiveType, dwVertexCount), lpVertices, Stride);
 	}
 
-	if (verticesCount)
-	{
-		// Pass the vertex data to the rendering pipeline
-		DrawPrimitive(D3DPT_POINTLIST, VertexTypeDesc, vertices.data(), verticesCount, 0, 1);
-	}
+	(*d3d9Device)->SetStreamSource(0, d3d9VertexBuffer, 0, Stride);
 
-	return D3D_OK;
-}
-
-HRESULT m_IDirect3DDeviceX::DrawExecuteSpan(D3DSPAN* span, WORD spanCount, DWORD vertexIndexCount, BYTE* vertexBuffer, DWORD VertexTypeDesc)
-{
-	// Define vertices and setup vector
-	std::vector<BYTE, aligned_allocator<BYTE, 4>> vertices;
-	vertices.resize(sizeof(D3DTLVERTEX) * vertexIndexCount);
-	BYTE* verticesData = vertices.data();
-	DWORD verticesCount = 0;
-
-	// Add vertices to vector
-	for (DWORD i = 0; i < spanCount; i++)
+	if (lpwIndices)
 	{
-		if ((DWORD)span[i].wFirst < vertexIndexCount)
-		{
-			DWORD count = min(span[i].wCount, vertexIndexCount - span[i].wFirst);
-
-			for (DWORD x = 0; x < count; x++)
-			{
-				CopyConvertExecuteVertex(verticesData, verticesCount, vertexBuffer, span[i].wFirst + x, VertexTypeDesc);
-			}
-		}
-	}
+		(*d3d9Device)->SetIndices(d3d9IndexBuffer);
 
-	if (verticesCount)
-	{
-		// Pass the vertex data to the rendering pipeline
-		DrawPrimitive(D3DPT_LINESTRIP, VertexTypeDesc, vertices.data(), verticesCount, 0, 1);
+		return (*d3d9Device)->DrawIndexedPrimitive(dptPrimitiveType, StartVertex, 0, dwVertexCount, StartIndex, GetNumberOfPrimitives(dptPrimitiveType, dwIndexCount));
 	}
-
-	return D3D_OK;
+	return (*d3d9Device)->DrawPrimitive(dptPrimitiveType, StartVertex, GetNumberOfPrimitives(dptPrimitiveType, dwVertexCount));
 }
 
-HRESULT m_IDirect3DDeviceX::DrawExecuteLine(D3DLINE* line, WORD lineCount, DWORD vertexIndexCount, BYTE* vertexBuffer, DWORD VertexTypeDesc)
+bool m_IDirect3DDeviceX::AddToDrawBatch(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, LPVOID lpVertices, DWORD dwVertexCount, LPWORD lpwIndices, DWORD dwIndexCount, DWORD dwFlags, DWORD DirectXVersion)
 {
-	// Define vertices and setup vector
-	std::vector<BYTE, aligned_allocator<BYTE, 4>> vertices;
-	vertices.resize(sizeof(D3DTLVERTEX) * lineCount * 2);
-	BYTE* verticesData = vertices.data();
-	DWORD verticesCount = 0;
+	const bool CanBatch = PRIMITIVEBATCH::CanBatch(dptPrimitiveType, dwVertexCount);
 
-	// Add vertices to vector
-	for (DWORD i = 0; i < lineCount; i++)
+	// Draw the queued primitives if this draw cannot be merged with them
+	if (DrawBatch.DrawCount && !DrawBatch.CanMerge(dptPrimitiveType, dwVertexTypeDesc, dwVertexCount, dwFlags, DirectXVersion))
 	{
-		if (line[i].v1 < vertexIndexCount && line[i].v2 < vertexIndexCount)
-		{
-			CopyConvertExecuteVertex(verticesData, verticesCount, vertexBuffer, line[i].v1, VertexTypeDesc);
-			CopyConvertExecuteVertex(verticesData, verticesCount, vertexBuffer, line[i].v2, VertexTypeDesc);
-		}
+		FlushDrawBatchX();
 	}
 
-	if (verticesCount)
+	if (!CanBatch)
 	{
-		// Pass the vertex data to the rendering pipeline
-		DrawPrimitive(D3DPT_LINELIST, VertexTypeDesc, vertices.data(), verticesCount, 0, 1);
+		return false;
 	}
 
-	return D3D_OK;
+	DrawBatch.Append(dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, GetVertexStride(dwVertexTypeDesc), lpwIndices, dwIndexCount, dwFlags, DirectXVersion);
+
+	return true;
 }
 
-HRESULT m_IDirect3DDeviceX::DrawExecuteTriangle(D3DTRIANGLE* triangle, WORD triangleCount, DWORD vertexIndexCount, BYTE* vertexBuffer, DWORD VertexTypeDesc)
+HRESULT m_IDirect3DDeviceX::FlushDrawBatchX()
 {
-	// Compute buffer size
-	DWORD BufferSize;
-	{
-		bool LastRecord = false;
-		DWORD Count = 0, MaxCount = 0;
-		for (DWORD i = 0; i < triangleCount; i++)
-		{
-			bool IsStartRecord = (triangle[i].wFlags & 0x1F) < D3DTRIFLAG_STARTFLAT(30);
-			if (IsStartRecord != LastRecord)
-			{
-				MaxCount = max(Count, MaxCount);
-				Count = (IsStartRecord) ? 3 : 4;
-			}
-			else
-			{
-				Count += (IsStartRecord) ? 3 : 1;
-			}
-			LastRecord = IsStartRecord;
-		}
-		BufferSize = sizeof(D3DTLVERTEX) * max(Count, MaxCount);
-	}
+	ScopedCriticalSection ThreadLockDD(DdrawWrapper::GetDDCriticalSection());
 
-	std::vector<BYTE, aligned_allocator<BYTE, 4>> vertices;
-	vertices.resize(BufferSize);
-	BYTE* verticesData = vertices.data();
-	DWORD verticesCount = 0;
+	Logging::LogDebug() << __FUNCTION__ << " (" << this << ") Draws = " << DrawBatch.DrawCount << " Vertices = " << DrawBatch.VertexCount;
 
-	D3DPRIMITIVETYPE PrimitiveType = D3DPT_TRIANGLELIST;
+	// Cleared first so state changes made while drawing do not flush again
+	DrawBatch.DrawCount = 0;
 
-	LONG LastCullMode = D3DTRIFLAG_START;
-	LONG CullRecordCount = 0;
+	HRESULT hr = D3D_OK;
 
-	for (DWORD i = 0; i < triangleCount; i++)
+	if (d3d9Device && *d3d9Device && !DrawBatch.Indices.empty())
 	{
-		// Flags for this triangle
-		WORD TriFlags = (triangle[i].wFlags & 0x1F);
+		hr = (*d3d9Device)->SetFVF(DrawBatch.FVF);
 
-		// START loads all three vertices
-		if (TriFlags < D3DTRIFLAG_STARTFLAT(30))
+		if (SUCCEEDED(hr))
 		{
-			if (triangle[i].v1 < vertexIndexCount && triangle[i].v2 < vertexIndexCount && triangle[i].v3 < vertexIndexCount)
-			{
-				PrimitiveType = D3DPT_TRIANGLELIST;
+			// Handle dwFlags
+			SetDrawStates(DrawBatch.FVF, DrawBatch.Flags, DrawBatch.DirectXVersion);
 
-				CopyConvertExecuteVertex(verticesData, verticesCount, vertexBuffer, triangle[i].v1, VertexTypeDesc);
-				CopyConvertExecuteVertex(verticesData, verticesCount, vertexBuffer, triangle[i].v2, VertexTypeDesc);
-				CopyConvertExecuteVertex(verticesData, verticesCount, vertexBuffer, triangle[i].v3, VertexTypeDesc);
+			hr = DrawStreamedPrimitive(DrawBatch.PrimitiveType, DrawBatch.FVF, DrawBatch.Vertices.data(), DrawBatch.VertexCount, DrawBatch.Indices.data(), DrawBatch.Indices.size());
 
-				LastCullMode = D3DTRIFLAG_START;
-				CullRecordCount = TriFlags;
-			}
+			// Handle dwFlags
+			RestoreDrawStates(hr, DrawBatch.Flags, DrawBatch.DirectXVersion);
 		}
-		// EVEN and ODD load just v3 with even or odd culling
-		else if (TriFlags == D3DTRIFLAG_EVEN || TriFlags == D3DTRIFLAG_ODD)
-		{
-			// Set primative type
-			if (LastCullMode == D3DTRIFLAG_START)
-			{
-				// Even cull modes indicates a triangle fan
-				if (TriFlags == D3DTRIFLAG_EVEN)
-				{
-					PrimitiveType = D3DPT_TRIANGLEFAN;
-				}
-				// Odd or mismatching cull modes indicates a triangle strip
-				else
-				{
-					PrimitiveType = D3DPT_TRIANGLESTRIP;
-				}
-			}
-
-			if (triangle[i].v3 < vertexIndexCount)
-			{
-				CopyConvertExecuteVertex(verticesData, verticesCount, vertexBuffer, triangle[i].v3, VertexTypeDesc);
-			}
 
-			LastCullMode = TriFlags;
-			CullRecordCount--;
+		if (FAILED(hr))
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: failed to draw batched primitives: " << (D3DERR)hr);
 		}
+	}
 
-		// Check next records
-		bool AtEndOfList = !(i + 1U < triangleCount);
-		LONG NextRecord = (i + 1U < triangleCount) ? ((triangle[i + 1].wFlags & 0x1F) < 30 ? D3DTRIFLAG_START : D3DTRIFLAG_EVEN) : 0;
-		LONG NextNextRecord = (i + 2U < triangleCount) ? ((triangle[i + 2].wFlags & 0x1F) < 30 ? D3DTRIFLAG_START : D3DTRIFLAG_EVEN) : 0;
+	DrawBatch.clear();
 
-		// Draw primitaves once at the end of the list
-		if (verticesCount &&								// There primatives to draw
-			(AtEndOfList ||									// There are no more records, or
-				(NextRecord == D3DTRIFLAG_START &&			// Next record is a new START
-					(LastCullMode != D3DTRIFLAG_START || NextNextRecord != D3DTRIFLAG_START))))
-		{
-			if (CullRecordCount > 0)
-			{
-				LOG_LIMIT(100, __FUNCTION__ << " Warning: drawing before all records have been culled: " << CullRecordCount);
-			}
+	return hr;
+}
 
-			// Pass the vertex data to the rendering pipeline
-			DrawPrimitive(PrimitiveType, VertexTypeDesc, vertices.data(), verticesCount, 0, 1);
+bool m_IDirect3DDeviceX::IsTextureBound(m_IDirectDrawSurfaceX* lpSurfaceX) const
+{
+	for (UINT x = 0; lpSurfaceX && x < D3DHAL_TSS_MAXSTAGES; x++)
+	{
+		if (CurrentTextureSurfaceX[x] == lpSurfaceX)
+		{
+			return true;
+		}
+	}
+	return false;
+}
 
-			// Reset variables for next list
-			verticesCount = 0;
-			verticesData = vertices.data();
+// Textures without a palette of their own use the primary surface palette
+bool m_IDirect3DDeviceX::IsPaletteBound(m_IDirectDrawPalette* lpPalette) const
+{
+	for (UINT x = 0; lpPalette && x < D3DHAL_TSS_MAXSTAGES; x++)
+	{
+		if (CurrentTextureSurfaceX[x] && CurrentTextureSurfaceX[x]->IsPalette() &&
+			(CurrentTextureSurfaceX[x]->GetAttachedPalette() == lpPalette || !CurrentTextureSurfaceX[x]->GetAttachedPalette()))
+		{
+			return true;
 		}
 	}
+	return false;
+}
 
-	return D3D_OK;
+HRESULT m_IDirect3DDeviceX::DrawExecuteCommand(const EXECUTECOMMAND& Command, const EXECUTECOMMANDLIST& CommandList, BYTE* vertexBuffer, DWORD VertexTypeDesc)
+{
+	if (!Command.IndexCount)
+	{
+		return D3D_OK;
+	}
+
+	// Indices are relative to the command's base vertex so only the used vertices are uploaded
+	BYTE* pVertices = vertexBuffer + Command.BaseVertex * GetVertexStride(VertexTypeDesc);
+	LPWORD pIndices = const_cast<LPWORD>(&CommandList.Indices[Command.StartIndex]);
+
+	// Pass the vertex data to the rendering pipeline
+	return DrawIndexedPrimitive(Command.PrimitiveType, VertexTypeDesc, pVertices, Command.NumVertices, pIndices, Command.IndexCount, 0, 1);
 }
 
 void m_IDirect3DDeviceX::ClearViewport(m_IDirect3DViewportX* lpViewportX)
@@ -5722,10 +5623,10 @@ HRESULT m_IDirect3DDeviceX::GetStateBlockRenderState(D3DRENDERSTATETYPE State, L
 
 	if (StateBlock.IsRecording)
 	{
-		auto it = StateBlock.Data[StateBlock.RecordingToken].RecordState.value().UnmappedRenderState.find(State);
-		if (it != StateBlock.Data[StateBlock.RecordingToken].RecordState.value().UnmappedRenderState.end())
+		const auto& Record = StateBlock.Data[StateBlock.RecordingToken].RecordState.value().UnmappedRenderState;
+		if (Record.IsDirty(State))
 		{
-			*lpValue = it->second;
+			*lpValue = Record.Get(State);
 			return D3D_OK;
 		}
 	}
@@ -5744,10 +5645,16 @@ HRESULT m_IDirect3DDeviceX::SetStateBlockRenderState(D3DRENDERSTATETYPE State, D
 
 	if (StateBlock.IsRecording)
 	{
-		StateBlock.Data[StateBlock.RecordingToken].RecordState.value().UnmappedRenderState[State] = Value;
+		StateBlock.Data[StateBlock.RecordingToken].RecordState.value().UnmappedRenderState.Set(State, Value);
 		return D3D_OK;
 	}
 
+	// Some of these, such as the color key states, are only read when the batch is drawn
+	if (DrawBatch.IsStateChange(DeviceStates.RenderState[State].State, Value))
+	{
+		FlushDrawBatchX();
+	}
+
 	DeviceStates.RenderState[State].State = Value;
 
 	return D3D_OK;
@@ -5767,10 +5674,10 @@ HRESULT m_IDirect3DDeviceX::GetD9RenderState(D3DRENDERSTATETYPE State, LPDWORD l
 
 	if (StateBlock.IsRecording)
 	{
-		auto it = StateBlock.Data[StateBlock.RecordingToken].RecordState.value().RenderState.find(State);
-		if (it != StateBlock.Data[StateBlock.RecordingToken].RecordState.value().RenderState.end())
+		const auto& Record = StateBlock.Data[StateBlock.RecordingToken].RecordState.value().RenderState;
+		if (Record.IsDirty(State))
 		{
-			*lpValue = it->second;
+			*lpValue = Record.Get(State);
 			return D3D_OK;
 		}
 	}
@@ -5796,11 +5703,16 @@ HRESULT m_IDirect3DDeviceX::SetD9RenderState(D3DRENDERSTATETYPE State, DWORD Val
 
 	if (StateBlock.IsRecording)
 	{
-		StateBlock.Data[StateBlock.RecordingToken].RecordState.value().RenderState[State] = Value;
+		StateBlock.Data[StateBlock.RecordingToken].RecordState.value().RenderState.Set(State, Value);
 		return D3D_OK;
 	}
 
-	BatchStates.RenderState[State] = Value;
+	if (DrawBatch.IsStateChange(DeviceStates.RenderState[State].Set ? DeviceStates.RenderState[State].State : DefaultRenderState[State], Value))
+	{
+		FlushDrawBatchX();
+	}
+
+	BatchStates.RenderState.Set(State, Value);
 
 	DeviceStates.RenderState[State].Set = (DefaultRenderState[State] != Value);
 	DeviceStates.RenderState[State].State = Value;
@@ -5822,10 +5734,10 @@ HRESULT m_IDirect3DDeviceX::GetD9TextureStageState(DWORD Stage, D3DTEXTURESTAGES
 
 	if (StateBlock.IsRecording)
 	{
-		auto it = StateBlock.Data[StateBlock.RecordingToken].RecordState.value().TextureStageState[Stage].find(Type);
-		if (it != StateBlock.Data[StateBlock.RecordingToken].RecordState.value().TextureStageState[Stage].end())
+		const auto& Record = StateBlock.Data[StateBlock.RecordingToken].RecordState.value().TextureStageState[Stage];
+		if (Record.IsDirty(Type))
 		{
-			*lpValue = it->second;
+			*lpValue = Record.Get(Type);
 			return D3D_OK;
 		}
 	}
@@ -5851,11 +5763,16 @@ HRESULT m_IDirect3DDeviceX::SetD9TextureStageState(DWORD Stage, D3DTEXTURESTAGES
 
 	if (StateBlock.IsRecording)
 	{
-		StateBlock.Data[StateBlock.RecordingToken].RecordState.value().TextureStageState[Stage][Type] = Value;
+		StateBlock.Data[StateBlock.RecordingToken].RecordState.value().TextureStageState[Stage].Set(Type, Value);
 		return D3D_OK;
 	}
 
-	BatchStates.TextureStageState[Stage][Type] = Value;
+	if (DrawBatch.IsStateChange(DeviceStates.TextureStageState[Stage][Type].Set ? DeviceStates.TextureStageState[Stage][Type].State : DefaultTextureStageState[Stage][Type], Value))
+	{
+		FlushDrawBatchX();
+	}
+
+	BatchStates.TextureStageState[Stage].Set(Type, Value);
 
 	DeviceStates.TextureStageState[Stage][Type].Set = (DefaultTextureStageState[Stage][Type] != Value);
 	DeviceStates.TextureStageState[Stage][Type].State = Value;
@@ -5877,10 +5794,10 @@ HRESULT m_IDirect3DDeviceX::GetD9SamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE
 
 	if (StateBlock.IsRecording)
 	{
-		auto it = StateBlock.Data[StateBlock.RecordingToken].RecordState.value().SamplerState[Sampler].find(Type);
-		if (it != StateBlock.Data[StateBlock.RecordingToken].RecordState.value().SamplerState[Sampler].end())
+		const auto& Record = StateBlock.Data[StateBlock.RecordingToken].RecordState.value().SamplerState[Sampler];
+		if (Record.IsDirty(Type))
 		{
-			*lpValue = it->second;
+			*lpValue = Record.Get(Type);
 			return D3D_OK;
 		}
 	}
@@ -5906,11 +5823,16 @@ HRESULT m_IDirect3DDeviceX::SetD9SamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE
 
 	if (StateBlock.IsRecording && StateBlock.Data[StateBlock.RecordingToken].RecordState.has_value())
 	{
-		StateBlock.Data[StateBlock.RecordingToken].RecordState.value().SamplerState[Sampler][Type] = Value;
+		StateBlock.Data[StateBlock.RecordingToken].RecordState.value().SamplerState[Sampler].Set(Type, Value);
 		return D3D_OK;
 	}
 
-	BatchStates.SamplerState[Sampler][Type] = FixSamplerState(Type, Value);
+	if (DrawBatch.IsStateChange(DeviceStates.SamplerState[Sampler][Type].Set ? DeviceStates.SamplerState[Sampler][Type].State : DefaultSamplerState[Sampler][Type], Value))
+	{
+		FlushDrawBatchX();
+	}
+
+	BatchStates.SamplerState[Sampler].Set(Type, FixSamplerState(Type, Value));
 
 	DeviceStates.SamplerState[Sampler][Type].Set = (DefaultSamplerState[Sampler][Type] != Value);
 	DeviceStates.SamplerState[Sampler][Type].State = Value;
@@ -5958,6 +5880,8 @@ HRESULT m_IDirect3DDeviceX::SetD9Light(DWORD Index, const D3DLIGHT9* lpLight)
 		return D3D_OK;
 	}
 
+	FlushDrawBatch();
+
 	BatchStates.Light[Index] = FixLight(*lpLight);
 
 	DeviceStates.Light[Index] = *lpLight;
@@ -6003,6 +5927,8 @@ HRESULT m_IDirect3DDeviceX::D9LightEnable(DWORD Index, BOOL Enable)
 		return D3D_OK;
 	}
 
+	FlushDrawBatch();
+
 	BatchStates.LightEnable[Index] = Enable;
 
 	DeviceStates.LightEnable[Index] = Enable;
@@ -6057,7 +5983,9 @@ HRESULT m_IDirect3DDeviceX::SetD9ClipPlane(DWORD Index, const float* lpPlane)
 		return D3D_OK;
 	}
 
-	BatchStates.ClipPlane[Index] = *(FLOAT4*)lpPlane;
+	FlushDrawBatch();
+
+	BatchStates.ClipPlane.Set(Index, *(FLOAT4*)lpPlane);
 
 	DeviceStates.ClipPlane[Index].Set = true;
 	DeviceStates.ClipPlane[Index].Plane = *(FLOAT4*)lpPlane;
@@ -6107,6 +6035,8 @@ HRESULT m_IDirect3DDeviceX::SetD9Viewport(const D3DVIEWPORT9* lpViewport)
 		return D3D_OK;
 	}
 
+	FlushDrawBatch();
+
 	DeviceStates.Viewport.Set = true;
 	DeviceStates.Viewport.View = *lpViewport;
 	DeviceStates.Viewport.FixedView = FixViewport(*lpViewport);
@@ -6156,6 +6086,8 @@ HRESULT m_IDirect3DDeviceX::SetD9Material(const D3DMATERIAL9* lpMaterial)
 		return D3D_OK;
 	}
 
+	FlushDrawBatch();
+
 	BatchStates.Material.Set = true;
 
 	DeviceStates.Material.Set = true;
@@ -6212,6 +6144,15 @@ HRESULT m_IDirect3DDeviceX::SetD9Transform(D3DTRANSFORMSTATETYPE State, const D3
 		return D3D_OK;
 	}
 
+	if (DrawBatch.DrawCount)
+	{
+		auto it = DeviceStates.Matrix.find(State);
+		if (it == DeviceStates.Matrix.end() || memcmp(&it->second, lpMatrix, sizeof(D3DMATRIX)) != 0)
+		{
+			FlushDrawBatchX();
+		}
+	}
+
 	BatchStates.Matrix[State] = *lpMatrix;
 
 	DeviceStates.Matrix[State] = *lpMatrix;
@@ -6240,6 +6181,8 @@ HRESULT m_IDirect3DDeviceX::D9MultiplyTransform(D3DTRANSFORMSTATETYPE State, con
 			return D3D_OK;
 		}
 
+		FlushDrawBatch();
+
 		BatchStates.Matrix[State] = result;
 
 		DeviceStates.Matrix[State] = result;
@@ -6258,23 +6201,29 @@ void m_IDirect3DDeviceX::PrepDevice()
 	// Set batched states
 	if (Config.Dd7to9)
 	{
-		for (const auto& entry : BatchStates.RenderState)
-		{
-			(*d3d9Device)->SetRenderState(entry.first, entry.second);
-		}
-		BatchStates.RenderState.clear();
-		for (UINT x = 0; x < D3DHAL_TSS_MAXSTAGES; x++)
-		{
-			for (const auto& entry : BatchStates.TextureStageState[x])
-			{
-				(*d3d9Device)->SetTextureStageState(x, entry.first, entry.second);
-			}
-			BatchStates.TextureStageState[x].clear();
-			for (const auto& entry : BatchStates.SamplerState[x])
+		// Z enable is also changed directly when the depth stencil surface changes
+		AppliedStates.RenderState.Invalidate(D3DRS_ZENABLE);
+
+		BatchStates.RenderState.Flush([&](UINT State, DWORD Value) {
+			if (AppliedStates.RenderState.Update(State, Value))
 			{
-				(*d3d9Device)->SetSamplerState(x, entry.first, entry.second);
+				(*d3d9Device)->SetRenderState((D3DRENDERSTATETYPE)State, Value);
 			}
-			BatchStates.SamplerState[x].clear();
+		});
+		for (UINT x = 0; x < D3DHAL_TSS_MAXSTAGES; x++)
+		{
+			BatchStates.TextureStageState[x].Flush([&](UINT Type, DWORD Value) {
+				if (AppliedStates.TextureStageState[x].Update(Type, Value))
+				{
+					(*d3d9Device)->SetTextureStageState(x, (D3DTEXTURESTAGESTATETYPE)Type, Value);
+				}
+			});
+			BatchStates.SamplerState[x].Flush([&](UINT Type, DWORD Value) {
+				if (AppliedStates.SamplerState[x].Update(Type, Value))
+				{
+					(*d3d9Device)->SetSamplerState(x, (D3DSAMPLERSTATETYPE)Type, Value);
+				}
+			});
 		}
 		for (const auto& entry : BatchStates.Light)
 		{
@@ -6286,11 +6235,9 @@ void m_IDirect3DDeviceX::PrepDevice()
 			(*d3d9Device)->LightEnable(entry.first, entry.second);
 		}
 		BatchStates.LightEnable.clear();
-		for (const auto& entry : BatchStates.ClipPlane)
-		{
-			(*d3d9Device)->SetClipPlane(entry.first, reinterpret_cast<const float*>(&entry.second));
-		}
-		BatchStates.ClipPlane.clear();
+		BatchStates.ClipPlane.Flush([&](UINT Index, const FLOAT4& Plane) {
+			(*d3d9Device)->SetClipPlane(Index, reinterpret_cast<const float*>(&Plane));
+		});
 		if (BatchStates.Material.Set)
 		{
 			(*d3d9Device)->SetMaterial(&DeviceStates.Material.Material);
@@ -6300,6 +6247,7 @@ void m_IDirect3DDeviceX::PrepDevice()
 		{
 			(*d3d9Device)->SetTransform(entry.first, &entry.second);
 		}
+		BatchStates.Matrix.clear();
 	}
 }
 
@@ -6315,6 +6263,7 @@ HRESULT m_IDirect3DDeviceX::RestoreStates()
 	// Reset vars
 	RequiresStateRestore = false;
 	ddrawParent->SetLastDrawDevice((DWORD)this);
+	AppliedStates.clear();
 
 	// Reset device state
 	ddrawParent->ApplyStateBlock();
@@ -6516,6 +6465,8 @@ void m_IDirect3DDeviceX::ClearDeviceState()
 
 	// Clear batch and draw states
 	BatchStates.clear();
+	AppliedStates.clear();
+	DrawBatch.clear();
 	ZeroMemory(&DrawStates, sizeof(DrawStates));
 
 	// Default clip status
@@ -6546,6 +6497,7 @@ void m_IDirect3DDeviceX::SetDrawStates(DWORD dwVertexTypeDesc, DWORD& dwFlags, D
 		{
 			GetD9RenderState(D3DRS_CLIPPING, &DrawStates.rsClipping);
 			(*d3d9Device)->SetRenderState(D3DRS_CLIPPING, FALSE);
+			AppliedStates.RenderState.Invalidate(D3DRS_CLIPPING);
 		}
 		if (DeviceStates.Viewport.UseViewportScale)
 		{
@@ -6559,6 +6511,7 @@ void m_IDirect3DDeviceX::SetDrawStates(DWORD dwVertexTypeDesc, DWORD& dwFlags, D
 			dwFlags |= D3DDP_DONOTLIGHT;
 			GetD9RenderState(D3DRS_CLIPPING, &DrawStates.rsLighting);
 			(*d3d9Device)->SetRenderState(D3DRS_LIGHTING, FALSE);
+			AppliedStates.RenderState.Invalidate(D3DRS_LIGHTING);
 		}
 		if (dwFlags & D3DDP_DONOTUPDATEEXTENTS)
 		{
@@ -6606,6 +6559,8 @@ void m_IDirect3DDeviceX::SetDrawStates(DWORD dwVertexTypeDesc, DWORD& dwFlags, D
 
 				(*d3d9Device)->SetSamplerState(x, D3DSAMP_MINFILTER, Config.DdrawFixByteAlignment == 2 ? D3DTEXF_POINT : D3DTEXF_LINEAR);
 				(*d3d9Device)->SetSamplerState(x, D3DSAMP_MAGFILTER, Config.DdrawFixByteAlignment == 2 ? D3DTEXF_POINT : D3DTEXF_LINEAR);
+				AppliedStates.SamplerState[x].Invalidate(D3DSAMP_MINFILTER);
+				AppliedStates.SamplerState[x].Invalidate(D3DSAMP_MAGFILTER);
 			}
 		}
 	}
@@ -6622,6 +6577,7 @@ void m_IDirect3DDeviceX::SetDrawStates(DWORD dwVertexTypeDesc, DWORD& dwFlags, D
 		{
 			(*d3d9Device)->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
 		}
+		AppliedStates.TextureStageState[0].Invalidate(D3DTSS_ALPHAOP);
 	}
 	for (UINT x = 0; x < D3DHAL_TSS_MAXSTAGES; x++)
 	{
@@ -6664,6 +6620,9 @@ void m_IDirect3DDeviceX::SetDrawStates(DWORD dwVertexTypeDesc, DWORD& dwFlags, D
 			(*d3d9Device)->SetRenderState(D3DRS_ALPHATESTENABLE, TRUE);
 			(*d3d9Device)->SetRenderState(D3DRS_ALPHAFUNC, D3DCMP_GREATER);
 			(*d3d9Device)->SetRenderState(D3DRS_ALPHAREF, (DWORD)0x01);
+			AppliedStates.RenderState.Invalidate(D3DRS_ALPHATESTENABLE);
+			AppliedStates.RenderState.Invalidate(D3DRS_ALPHAFUNC);
+			AppliedStates.RenderState.Invalidate(D3DRS_ALPHAREF);
 		}
 	}
 	if ((dwFlags & D3DDP_DXW_COLORKEYENABLE) && ddrawParent)
@@ -31,10 +31,6 @@ private:
 		DWORD DxVersion = 0;
 	} parent3DSurface;
 
-#ifdef ENABLE_PROFILING
-	std::chrono::steady_clock::time_point sceneTime;
-#endif
-
 	struct STATESTRUCT {
 		bool Set = false;
 		DWORD State = (DWORD)-1;
@@ -63,6 +59,7 @@ private:
 		CLIPPLANESTRUCT ClipPlane[MaxClipPlaneIndex];
 		VIEWPORTSTRUCT Viewport;
 		MATERIALSTRUCT Material = {};
+		// Light indexes are chosen by the application and can be any DWORD, so lights stay hashed
 		std::unordered_map<DWORD, D3DLIGHT9> Light;
 		std::unordered_map<DWORD, BOOL> LightEnable;
 		std::unordered_map<D3DTRANSFORMSTATETYPE, D3DMATRIX> Matrix;
@@ -76,13 +73,14 @@ private:
 	};
 	DEVICESTATE DeviceStates;
 
+	// States written since the last draw, applied by PrepDevice
 	struct {
-		std::unordered_map<D3DRENDERSTATETYPE, DWORD> RenderState;
-		std::unordered_map<D3DTEXTURESTAGESTATETYPE, DWORD> TextureStageState[D3DHAL_TSS_MAXSTAGES];
-		std::unordered_map<D3DSAMPLERSTATETYPE, DWORD> SamplerState[D3DHAL_TSS_MAXSTAGES];
+		DirtyStateArray<DWORD, D3D_MAXRENDERSTATES> RenderState;
+		DirtyStateArray<DWORD, MaxTextureStageStates> TextureStageState[D3DHAL_TSS_MAXSTAGES];
+		DirtyStateArray<DWORD, D3DHAL_TEXTURESTATEBUF_SIZE> SamplerState[D3DHAL_TSS_MAXSTAGES];
 		std::unordered_map<DWORD, D3DLIGHT9> Light;
 		std::unordered_map<DWORD, BOOL> LightEnable;
-		std::unordered_map<DWORD, FLOAT4> ClipPlane;
+		DirtyStateArray<FLOAT4, MaxClipPlaneIndex> ClipPlane;
 		struct { bool Set = false; } Material;
 		std::unordered_map<D3DTRANSFORMSTATETYPE, D3DMATRIX> Matrix;
 
@@ -102,11 +100,28 @@ private:
 		}
 	} BatchStates;
 
+	// Values last applied to the d3d9 device by PrepDevice, used to drop redundant writes
+	struct {
+		AppliedStateArray<D3D_MAXRENDERSTATES> RenderState;
+		AppliedStateArray<MaxTextureStageStates> TextureStageState[D3DHAL_TSS_MAXSTAGES];
+		AppliedStateArray<D3DHAL_TEXTURESTATEBUF_SIZE> SamplerState[D3DHAL_TSS_MAXSTAGES];
+
+		void clear()
+		{
+			RenderState.clear();
+			for (UINT x = 0; x < D3DHAL_TSS_MAXSTAGES; x++)
+			{
+				TextureStageState[x].clear();
+				SamplerState[x].clear();
+			}
+		}
+	} AppliedStates;
+
 	struct RECORDSTATE {
-		std::unordered_map<D3DRENDERSTATETYPE, DWORD> RenderState;
-		std::unordered_map<D3DRENDERSTATETYPE, DWORD> UnmappedRenderState;
-		std::unordered_map<D3DTEXTURESTAGESTATETYPE, DWORD> TextureStageState[D3DHAL_TSS_MAXSTAGES];
-		std::unordered_map<D3DSAMPLERSTATETYPE, DWORD> SamplerState[D3DHAL_TSS_MAXSTAGES];
+		DirtyStateArray<DWORD, D3D_MAXRENDERSTATES> RenderState;
+		DirtyStateArray<DWORD, D3D_MAXRENDERSTATES> UnmappedRenderState;
+		DirtyStateArray<DWORD, MaxTextureStageStates> TextureStageState[D3DHAL_TSS_MAXSTAGES];
+		DirtyStateArray<DWORD, D3DHAL_TEXTURESTATEBUF_SIZE> SamplerState[D3DHAL_TSS_MAXSTAGES];
 		std::unordered_map<DWORD, D3DLIGHT9> Light;
 		std::unordered_map<DWORD, BOOL> LightEnable;
 		std::unordered_map<DWORD, FLOAT4> ClipPlane;
@@ -143,6 +158,8 @@ private:
 		float highColorKey[4] = {};
 	} DrawStates;
 
+	PRIMITIVEBATCH DrawBatch;
+
 	// Vertex Stream
 	VERTEXSTREAMINFO VertexStreamInfo;
 
@@ -247,14 +264,13 @@ private:
 
 	// Helper functions
 	HRESULT CheckInterface(char* FunctionName, bool CheckD3DDevice);
+	HRESULT DrawStreamedPrimitive(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, LPVOID lpVertices, DWORD dwVertexCount, LPWORD lpwIndices, DWORD dwIndexCount);
+	bool AddToDrawBatch(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, LPVOID lpVertices, DWORD dwVertexCount, LPWORD lpwIndices, DWORD dwIndexCount, DWORD dwFlags, DWORD DirectXVersion);
+	HRESULT FlushDrawBatchX();
 
 	// Execute buffer function
-	void CopyConvertExecuteVertex(BYTE*& DestVertex, DWORD& DestVertexCount, BYTE* SrcVertex, DWORD SrcIndex, DWORD VertexTypeDesc);
 	void MergeExecuteExtents(D3DRECT& currentExtent1, D3DRECT& newExtent2, DWORD& dwFlags);
-	HRESULT DrawExecutePoint(D3DPOINT* point, WORD pointCount, DWORD vertexIndexCount, BYTE* vertexBuffer, DWORD VertexTypeDesc);
-	HRESULT DrawExecuteSpan(D3DSPAN* span, WORD spanCount, DWORD vertexIndexCount, BYTE* vertexBuffer, DWORD VertexTypeDesc);
-	HRESULT DrawExecuteLine(D3DLINE* line, WORD lineCount, DWORD vertexIndexCount, BYTE* vertexBuffer, DWORD VertexTypeDesc);
-	HRESULT DrawExecuteTriangle(D3DTRIANGLE* triangle, WORD triangleCount, DWORD vertexIndexCount, BYTE* vertexBuffer, DWORD VertexTypeDesc);
+	HRESULT DrawExecuteCommand(const EXECUTECOMMAND& Command, const EXECUTECOMMANDLIST& CommandList, BYTE* vertexBuffer, DWORD VertexTypeDesc);
 
 	HRESULT SetTextureHandle(DWORD TexHandle);
 	HRESULT SetMaterialHandle(DWORD MatHandle);
@@ -470,6 +486,9 @@ public:
 	ULONG AddRef(DWORD DirectXVersion);
 	ULONG Release(DWORD DirectXVersion);
 	bool IsDeviceInScene() const { return IsInScene; }
+	void FlushDrawBatch() { if (DrawBatch.DrawCount) { FlushDrawBatchX(); } }
+	bool IsTextureBound(m_IDirectDrawSurfaceX* lpSurfaceX) const;
+	bool IsPaletteBound(m_IDirectDrawPalette* lpPalette) const;
 	void SetParent3DSurface(m_IDirectDrawSurfaceX* lpSurfaceX, DWORD DxVersion) { parent3DSurface = { lpSurfaceX, DxVersion }; }
 	LPDIRECT3DDEVICE9* GetD3d9Device();
 
@@ -499,6 +518,10 @@ public:
 
 	// Viewport vector function
 	HRESULT SetViewportData(VIEWPORTINFO& Viewport);
+	HRESULT GetViewportTransform(VIEWPORTTRANSFORM& Transform);
+
+	// Clip status function
+	void MergeClipStatus(DWORD ClipUnion, DWORD ClipIntersection, const D3DVECTOR* pExtentMin, const D3DVECTOR* pExtentMax);
 	bool DeleteAttachedViewport(LPDIRECT3DVIEWPORT3 ViewportX);
 
 	// Texture handle function
@@ -208,6 +208,7 @@ HRESULT m_IDirect3DExecuteBuffer::Lock(LPD3DEXECUTEBUFFERDESC lpDesc)
 
 		// Mark data as unvalidated
 		IsDataValidated = false;
+		CommandList.IsCompiled = false;
 
 		return D3D_OK;
 	}
@@ -299,6 +300,7 @@ HRESULT m_IDirect3DExecuteBuffer::SetExecuteData(LPD3DEXECUTEDATA lpExecuteData)
 
 		// Mark data as unvalidated
 		IsDataValidated = false;
+		CommandList.IsCompiled = false;
 
 		return D3D_OK;
 	}
@@ -399,6 +401,7 @@ void m_IDirect3DExecuteBuffer::InitInterface(LPD3DEXECUTEBUFFERDESC lpDesc)
 
 	LockedCount = 0;
 	IsDataValidated = false;
+	CommandList.IsCompiled = false;
 	ExecuteData = {};
 	ExecuteData.dwSize = sizeof(D3DEXECUTEDATA);
 	Desc = {};
@@ -465,6 +468,20 @@ HRESULT m_IDirect3DExecuteBuffer::GetBuffer(LPVOID* lplpData, D3DEXECUTEDATA& Cu
 	return D3D_OK;
 }
 
+const EXECUTECOMMANDLIST& m_IDirect3DExecuteBuffer::GetCommandList()
+{
+	const BYTE* pInstructions = (const BYTE*)Desc.lpData + ExecuteData.dwInstructionOffset;
+
+	// Only compile again after the buffer has been locked or the execute data has changed.
+	// Application memory can be changed without a lock so it is compiled on every execute.
+	if (UsingAppMemory || !CommandList.IsCompiled || CommandList.pInstructions != pInstructions)
+	{
+		CompileExecuteInstructions(CommandList, pInstructions, ExecuteData.dwInstructionLength, ExecuteData.dwVertexCount);
+	}
+
+	return CommandList;
+}
+
 HRESULT m_IDirect3DExecuteBuffer::ValidateInstructionData(LPD3DEXECUTEDATA lpExecuteData, LPDWORD lpdwOffset, LPD3DVALIDATECALLBACK lpFunc, LPVOID lpUserArg)
 {
 	if (!lpExecuteData)
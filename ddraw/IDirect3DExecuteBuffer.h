@@ -19,6 +19,9 @@ private:
 	bool IsDataValidated = false;
 	bool UsingAppMemory = false;
 
+	// Compiled instructions, rebuilt after the buffer or execute data changes
+	EXECUTECOMMANDLIST CommandList;
+
 	// Instruction data 
 	HRESULT ValidateInstructionData(LPD3DEXECUTEDATA lpExecuteData, LPDWORD lpdwOffset, LPD3DVALIDATECALLBACK lpFunc, LPVOID lpUserArg);
 
@@ -93,6 +96,7 @@ public:
 	// Helper functions
 	void ClearD3DDevice() { D3DDeviceInterface = nullptr; }
 	HRESULT GetBuffer(LPVOID* lplpData, D3DEXECUTEDATA& CurrentExecuteData, LPD3DSTATUS* lplpStatus);
+	const EXECUTECOMMANDLIST& GetCommandList();
 	bool IsBufferLocked() const { return (IsLocking || LockedCount != 0); }
 	std::atomic<bool>& GetExecuteFlag() { return IsExecuting; }
 	static m_IDirect3DExecuteBuffer* CreateDirect3DExecuteBuffer(IDirect3DExecuteBuffer* aOriginal, m_IDirect3DDeviceX* NewD3DDInterface, LPD3DEXECUTEBUFFERDESC lpDesc);
@@ -404,6 +404,33 @@ struct VIEWPORTINFO {
     D3DVECTOR Clip = {};
 };
 
+// Light constants resolved once per call, specular is premultiplied by the material specular
+struct LIGHTCONST {
+    D3DLIGHTTYPE Type = D3DLIGHT_POINT;
+    D3DVECTOR Position = {};
+    D3DVECTOR Direction = {};
+    float Range = 0.0f;
+    float Attenuation0 = 0.0f;
+    float Attenuation1 = 0.0f;
+    float Attenuation2 = 0.0f;
+    float CosPhi = 0.0f;
+    float CosTheta = 0.0f;
+    float Falloff = 1.0f;
+    D3DCOLORVALUE Diffuse = {};
+    D3DCOLORVALUE Specular = {};
+    bool UseSpecular = false;
+};
+
+struct LIGHTINGCONTEXT {
+    std::vector<LIGHTCONST> Lights;
+    D3DCOLOR Ambient = 0;
+    D3DCOLORVALUE MaterialAmbient = {};
+    float Alpha = 1.0f;
+    float Power = 1.0f;
+    bool UseSpecular = false;
+    bool IsDefaultMaterial = false;
+};
+
 typedef enum _D3DSURFACETYPE {
     D3DTYPE_NONE = 0,
     D3DTYPE_OFFPLAINSURFACE = 1,
@@ -123,6 +123,8 @@ HRESULT m_IDirect3DVertexBufferX::Lock(DWORD dwFlags, LPVOID* lplpData, LPDWORD
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	PROFILE_ZONE(ZONE_VERTEXBUFFERLOCK);
+
 	if (Config.Dd7to9)
 	{
 		if (!lplpData)
@@ -172,10 +174,6 @@ HRESULT m_IDirect3DVertexBufferX::Lock(DWORD dwFlags, LPVOID* lplpData, LPDWORD
 			return D3D_OK;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		// Lock vertex
 		void* pData = nullptr;
 		HRESULT hr = d3d9VertexBuffer->Lock(0, 0, &pData, Flags);
@@ -219,10 +217,6 @@ HRESULT m_IDirect3DVertexBufferX::Lock(DWORD dwFlags, LPVOID* lplpData, LPDWORD
 			}
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return D3D_OK;
 	}
 
@@ -294,6 +288,8 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVertices(DWORD dwVertexOp, DWORD dwDest
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	PROFILE_ZONE(ZONE_PROCESSVERTICES);
+
 	if (Config.Dd7to9)
 	{
 		// Check if there are no vertices to process
@@ -330,10 +326,6 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVertices(DWORD dwVertexOp, DWORD dwDest
 			return DDERR_GENERIC;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		// Get FVF
 		DWORD dwSrcVertexTypeDesc = pSrcVertexBufferX->VB.Desc.dwFVF;
 
@@ -360,10 +352,6 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVertices(DWORD dwVertexOp, DWORD dwDest
 		// Unlock the source vertex buffer
 		pSrcVertexBufferX->Unlock();
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -433,6 +421,8 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVerticesStrided(DWORD dwVertexOp, DWORD
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	PROFILE_ZONE(ZONE_PROCESSVERTICES);
+
 	if (Config.Dd7to9)
 	{
 		// Check if there are no vertices to process
@@ -453,10 +443,6 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVerticesStrided(DWORD dwVertexOp, DWORD
 			return DDERR_GENERIC;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		// Setup vars
 		DWORD dwVertexTypeDesc = VB.Desc.dwFVF;
 		std::vector<BYTE, aligned_allocator<BYTE, 4>> VertexCache;
@@ -470,10 +456,6 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVerticesStrided(DWORD dwVertexOp, DWORD
 
 		HRESULT hr = ProcessVerticesUP(dwVertexOp, dwDestIndex, dwCount, VertexCache.data(), dwVertexTypeDesc, dwSrcIndex, lpD3DDevice, dwFlags);
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -1031,14 +1013,6 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVerticesUP(DWORD dwVertexOp, DWORD dwDe
 	}
 
 	// Handle dwVertexOp
-	if (dwVertexOp & D3DVOP_CLIP)
-	{
-		LOG_LIMIT(100, __FUNCTION__ << " Warning: 'D3DVOP_CLIP' not handled!");
-	}
-	if (dwVertexOp & D3DVOP_EXTENTS)
-	{
-		LOG_LIMIT(100, __FUNCTION__ << " Warning: 'D3DVOP_EXTENTS' not handled!");
-	}
 	// D3DVOP_TRANSFORM is inherently handled by ProcessVertices() as it performs vertex transformations based on the current world, view, and projection matrices.
 	if (!(dwVertexOp & D3DVOP_TRANSFORM))
 	{
@@ -1048,6 +1022,8 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVerticesUP(DWORD dwVertexOp, DWORD dwDe
 
 	bool DoNotCopyData = (dwFlags & D3DPV_DONOTCOPYDATA) != 0;
 	bool bLighting = (dwVertexOp & D3DVOP_LIGHT);
+	const bool bClip = (dwVertexOp & D3DVOP_CLIP);
+	const bool bExtents = (dwVertexOp & D3DVOP_EXTENTS);
 
 	DWORD PosSizeSrc = GetVertexPositionStride(SrcFVF);
 	DWORD PosSizeDest = GetVertexPositionStride(DestFVF);
@@ -1118,33 +1094,54 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVerticesUP(DWORD dwVertexOp, DWORD dwDe
 	D3DXMatrixMultiply(&matWorldView, &matWorld, &matView);
 	D3DXMatrixMultiply(&matWorldViewProj, &matWorldView, &matProj);
 
+	// Get screen mapping
+	VIEWPORTTRANSFORM ViewportTransform;
+	if (FAILED(pDirect3DDeviceX->GetViewportTransform(ViewportTransform)))
+	{
+		LOG_LIMIT(100, __FUNCTION__ << " Error: Failed to get viewport");
+		return DDERR_GENERIC;
+	}
+
+	// Extract rotation from world matrix
+	D3DMATRIX matWorldRotOnly = matWorld;
+	matWorldRotOnly._41 = 0.0f;
+	matWorldRotOnly._42 = 0.0f;
+	matWorldRotOnly._43 = 0.0f;
+	matWorldRotOnly._14 = 0.0f;
+	matWorldRotOnly._24 = 0.0f;
+	matWorldRotOnly._34 = 0.0f;
+	matWorldRotOnly._44 = 1.0f;
+
 	// Cache specular, ambient, material and lights if needed
-	bool UseSpecular = false;
-	D3DCOLOR ambient = 0;
-	LPD3DMATERIAL7 lpMaterial = nullptr;
-	D3DMATERIAL7 Material = {};
-	std::vector<DXLIGHT7> cachedLights;
+	LIGHTINGCONTEXT LightingContext;
 
 	if (bLighting)
 	{
+		bool UseSpecular = false;
 		if (DWORD rsSpecular = 0; SUCCEEDED(pDirect3DDeviceX->GetRenderState(D3DRENDERSTATE_SPECULARENABLE, &rsSpecular)))
 		{
 			UseSpecular = rsSpecular != FALSE;
 		}
 
+		D3DCOLOR ambient = 0;
 		pDirect3DDeviceX->GetRenderState(D3DRENDERSTATE_AMBIENT, &ambient);
 
+		LPD3DMATERIAL7 lpMaterial = nullptr;
+		D3DMATERIAL7 Material = {};
 		if (SUCCEEDED(pDirect3DDeviceX->GetMaterial(&Material)))
 		{
 			lpMaterial = &Material;
 		}
 
+		std::vector<DXLIGHT7> cachedLights;
 		pDirect3DDeviceX->GetEnabledLightList(cachedLights);
 
 		if (cachedLights.empty())
 		{
 			LOG_LIMIT(100, __FUNCTION__ << " Warning: no attached lights found!");
 		}
+
+		PrepareLighting(LightingContext, cachedLights, lpMaterial, ambient, UseSpecular);
 	}
 
 	// Lock destination buffer
@@ -1170,90 +1167,90 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVerticesUP(DWORD dwVertexOp, DWORD dwDe
 		}
 	}
 
-	for (UINT i = 0; i < dwCount; ++i)
+	// Process vertices in batches so positions and normals can be transformed four at a time
+	D3DXVECTOR4 Homogeneous[VertexBatchSize];
+	D3DXVECTOR3 Normals[VertexBatchSize];
+
+	DWORD ClipUnion = 0, ClipIntersection = D3DCLIP_FRUSTUM;
+	D3DVECTOR ExtentMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+	D3DVECTOR ExtentMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (DWORD Start = 0; Start < dwCount; Start += VertexBatchSize)
 	{
+		const DWORD Count = min(VertexBatchSize, dwCount - Start);
+		BYTE* pSrcBatch = pSrcVertex + Start * SrcStride;
+		BYTE* pDestBatch = pDestVertex + Start * DestStride;
+
 		// Copy or convert vertex data
 		if (!DoNotCopyData)
 		{
-			if (SimpleCopy)
-			{
-				memcpy(pDestVertex + PosSizeDest, pSrcVertex + PosSizeSrc, SrcStride - PosSizeSrc);
-			}
-			else
+			for (DWORD i = 0; i < Count; ++i)
 			{
-				ConvertVertex(pDestVertex, DestFVF, pSrcVertex, SrcFVF);
+				if (SimpleCopy)
+				{
+					memcpy(pDestBatch + i * DestStride + PosSizeDest, pSrcBatch + i * SrcStride + PosSizeSrc, SrcStride - PosSizeSrc);
+				}
+				else
+				{
+					ConvertVertex(pDestBatch + i * DestStride, DestFVF, pSrcBatch + i * SrcStride, SrcFVF);
+				}
 			}
 		}
 
-		// Transform vertex
-		D3DXVECTOR3& src = *reinterpret_cast<D3DXVECTOR3*>(pSrcVertex);
-		D3DXVECTOR4& dst = *reinterpret_cast<D3DXVECTOR4*>(pDestVertex);
-
-		D3DXVECTOR4 h;
-		D3DXVECTOR4 pos4(src.x, src.y, src.z, 1.0f);
-		D3DXVec4Transform(&h, &pos4, &matWorldViewProj);
+		// Transform vertices
+		TransformPositions(matWorldViewProj, pSrcBatch, SrcStride, pDestBatch, DestStride, bClip ? Homogeneous : nullptr, Count);
 
-		float rhw = (h.w != 0.0f) ? (1.0f / h.w) : 0.0f;
-
-		dst.x = h.x * rhw;
-		dst.y = h.y * rhw;
-		dst.z = h.z * rhw;
-		dst.w = rhw;
+		// Clip codes
+		if (bClip)
+		{
+			ClipUnion |= ComputeClipCodes(Homogeneous, nullptr, Count, ClipIntersection);
+		}
 
 		// Lighting
 		if (bLighting)
 		{
-			D3DCOLOR Diffuse = 0, Specular = 0;
-
-			// Extract rotation from world matrix
-			D3DMATRIX matWorldRotOnly = matWorld;
-			matWorldRotOnly._41 = 0.0f;
-			matWorldRotOnly._42 = 0.0f;
-			matWorldRotOnly._43 = 0.0f;
-			matWorldRotOnly._14 = 0.0f;
-			matWorldRotOnly._24 = 0.0f;
-			matWorldRotOnly._34 = 0.0f;
-			matWorldRotOnly._44 = 1.0f;
-
-			// Transform normal
-			D3DXVECTOR3 normal = *reinterpret_cast<D3DXVECTOR3*>(pSrcVertex + NormalSrcOffset);
-			D3DXVECTOR3 transformedNormal;
-			D3DXVec3TransformNormal(&transformedNormal, &normal, &matWorldRotOnly);
-			if (D3DXVec3LengthSq(&normal) > 1e-12f)
+			TransformNormals(matWorldRotOnly, pSrcBatch + NormalSrcOffset, SrcStride, Normals, Count);
+
+			for (DWORD i = 0; i < Count; ++i)
 			{
-				D3DXVec3Normalize(&transformedNormal, &transformedNormal);
-			}
+				BYTE* pDest = pDestBatch + i * DestStride;
 
-			D3DXVECTOR3 transformedPos = { dst.x, dst.y, dst.z };
+				D3DCOLOR Diffuse = 0, Specular = 0;
 
-			ComputeLighting(transformedPos, transformedNormal, cachedLights, lpMaterial, ambient, UseSpecular, Diffuse, Specular);
+				ComputeLighting(*reinterpret_cast<D3DVECTOR*>(pDest), Normals[i], LightingContext, Diffuse, Specular);
 
-			if (DiffuseDestOffset)
-			{
-				*reinterpret_cast<D3DCOLOR*>(pDestVertex + DiffuseDestOffset) = Diffuse;
-			}
-			if (SpecularDestOffset)
-			{
-				*reinterpret_cast<D3DCOLOR*>(pDestVertex + SpecularDestOffset) = Specular;
+				if (DiffuseDestOffset)
+				{
+					*reinterpret_cast<D3DCOLOR*>(pDest + DiffuseDestOffset) = Diffuse;
+				}
+				if (SpecularDestOffset)
+				{
+					*reinterpret_cast<D3DCOLOR*>(pDest + SpecularDestOffset) = Specular;
+				}
 			}
 		}
 
-		// Move to the next vertex
-		pSrcVertex += SrcStride;
-		pDestVertex += DestStride;
+		// Map to screen space and update extents
+		ApplyViewportTransform(ViewportTransform, pDestBatch, DestStride, Count, bExtents ? &ExtentMin : nullptr, bExtents ? &ExtentMax : nullptr);
 	}
 
 	// Unlock the destination vertex buffer
 	Unlock();
 
+	// Update clip status
+	if (bClip || bExtents)
+	{
+		pDirect3DDeviceX->MergeClipStatus(ClipUnion, bClip ? ClipIntersection : D3DCLIP_FRUSTUM, bExtents ? &ExtentMin : nullptr, bExtents ? &ExtentMax : nullptr);
+	}
+
 	return D3D_OK;
 }
 
-template HRESULT m_IDirect3DVertexBufferX::TransformVertexUP<XYZ>(m_IDirect3DDeviceX* , XYZ*, D3DTLVERTEX*, D3DHVERTEX*, const DWORD, D3DRECT&, bool, bool);
-template HRESULT m_IDirect3DVertexBufferX::TransformVertexUP<D3DVERTEX>(m_IDirect3DDeviceX*, D3DVERTEX*, D3DTLVERTEX*, D3DHVERTEX*, const DWORD, D3DRECT&, bool, bool);
-template HRESULT m_IDirect3DVertexBufferX::TransformVertexUP<D3DLVERTEX>(m_IDirect3DDeviceX* , D3DLVERTEX*, D3DTLVERTEX*, D3DHVERTEX*, const DWORD, D3DRECT&, bool, bool);
+template HRESULT m_IDirect3DVertexBufferX::TransformVertexUP<XYZ>(m_IDirect3DDeviceX* , XYZ*, D3DTLVERTEX*, D3DHVERTEX*, const DWORD, D3DRECT&, LPDWORD, bool, bool);
+template HRESULT m_IDirect3DVertexBufferX::TransformVertexUP<D3DVERTEX>(m_IDirect3DDeviceX*, D3DVERTEX*, D3DTLVERTEX*, D3DHVERTEX*, const DWORD, D3DRECT&, LPDWORD, bool, bool);
+template HRESULT m_IDirect3DVertexBufferX::TransformVertexUP<D3DLVERTEX>(m_IDirect3DDeviceX* , D3DLVERTEX*, D3DTLVERTEX*, D3DHVERTEX*, const DWORD, D3DRECT&, LPDWORD, bool, bool);
 template <typename T>
-HRESULT m_IDirect3DVertexBufferX::TransformVertexUP(m_IDirect3DDeviceX* pDirect3DDeviceX, T* srcVertex, D3DTLVERTEX* destVertex, D3DHVERTEX* pHOut, const DWORD dwCount, D3DRECT& drExtent, bool bLighting, bool bUpdateExtents)
+HRESULT m_IDirect3DVertexBufferX::TransformVertexUP(m_IDirect3DDeviceX* pDirect3DDeviceX, T* srcVertex, D3DTLVERTEX* destVertex, D3DHVERTEX* pHOut, const DWORD dwCount, D3DRECT& drExtent, LPDWORD lpClipStatus, bool bLighting, bool bUpdateExtents)
 {
 	// Check for lighiting, must have source normals and dest diffuse or specular
 	if (bLighting)
@@ -1279,32 +1276,35 @@ HRESULT m_IDirect3DVertexBufferX::TransformVertexUP(m_IDirect3DDeviceX* pDirect3
 	}
 
 	// Cache specular, ambient, material and lights if needed
-	bool UseSpecular = false;
-	D3DCOLOR ambient = 0;
-	LPD3DMATERIAL7 lpMaterial = nullptr;
-	D3DMATERIAL7 Material = {};
-	std::vector<DXLIGHT7> cachedLights;
+	LIGHTINGCONTEXT LightingContext;
 
 	if (bLighting)
 	{
+		bool UseSpecular = false;
 		if (DWORD rsSpecular = 0; SUCCEEDED(pDirect3DDeviceX->GetRenderState(D3DRENDERSTATE_SPECULARENABLE, &rsSpecular)))
 		{
 			UseSpecular = rsSpecular != FALSE;
 		}
 
+		D3DCOLOR ambient = 0;
 		pDirect3DDeviceX->GetRenderState(D3DRENDERSTATE_AMBIENT, &ambient);
 
+		LPD3DMATERIAL7 lpMaterial = nullptr;
+		D3DMATERIAL7 Material = {};
 		if (SUCCEEDED(pDirect3DDeviceX->GetMaterial(&Material)))
 		{
 			lpMaterial = &Material;
 		}
 
+		std::vector<DXLIGHT7> cachedLights;
 		pDirect3DDeviceX->GetEnabledLightList(cachedLights);
 
 		if (cachedLights.empty())
 		{
 			LOG_LIMIT(100, __FUNCTION__ << " Warning: no attached lights found!");
 		}
+
+		PrepareLighting(LightingContext, cachedLights, lpMaterial, ambient, UseSpecular);
 	}
 
 	D3DMATRIX matWorld, matView, matProj;
@@ -1320,100 +1320,122 @@ HRESULT m_IDirect3DVertexBufferX::TransformVertexUP(m_IDirect3DDeviceX* pDirect3
 	D3DXMatrixMultiply(&matWorldView, &matWorld, &matView);
 	D3DXMatrixMultiply(&matWorldViewProj, &matWorldView, &matProj);
 
-	D3DRECT newExtents = { LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN };
-
-	for (DWORD i = 0; i < dwCount; ++i)
+	// Get screen mapping
+	VIEWPORTTRANSFORM ViewportTransform;
+	if (FAILED(pDirect3DDeviceX->GetViewportTransform(ViewportTransform)))
 	{
-		T& src = srcVertex[i];
-		D3DTLVERTEX& dst = destVertex[i];
+		LOG_LIMIT(100, __FUNCTION__ << " Error: Failed to get viewport");
+		return DDERR_GENERIC;
+	}
 
-		D3DXVECTOR4 h;
-		D3DXVECTOR4 pos4(src.x, src.y, src.z, 1.0f);
-		D3DXVec4Transform(&h, &pos4, &matWorldViewProj);
+	// Extract rotation from world matrix
+	D3DMATRIX matWorldRotOnly = matWorld;
+	matWorldRotOnly._41 = 0.0f;
+	matWorldRotOnly._42 = 0.0f;
+	matWorldRotOnly._43 = 0.0f;
+	matWorldRotOnly._14 = 0.0f;
+	matWorldRotOnly._24 = 0.0f;
+	matWorldRotOnly._34 = 0.0f;
+	matWorldRotOnly._44 = 1.0f;
 
-		float rhw = (h.w != 0.0f) ? (1.0f / h.w) : 0.0f;
+	// Clip codes are needed for the homogeneous output and the clip status
+	const bool bClip = (pHOut || lpClipStatus);
 
-		dst.sx = h.x * rhw;
-		dst.sy = h.y * rhw;
-		dst.sz = h.z * rhw;
-		dst.rhw = rhw;
+	DWORD ClipUnion = 0, ClipIntersection = D3DCLIP_FRUSTUM;
+	D3DVECTOR ExtentMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+	D3DVECTOR ExtentMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
-		// Default values: set for XYZ or copy for detailed vertex
-		if constexpr (std::is_same_v<T, XYZ>)
-		{
-			dst.color = 0xFFFFFFFF;	// Default to white
-			dst.specular = 0;
-			dst.tu = 0.0f;
-			dst.tv = 0.0f;
-		}
-		else if constexpr (std::is_same_v<T, D3DVERTEX>)
-		{
-			D3DCOLOR Diffuse = 0, Specular = 0;
-
-			// Extract rotation from world matrix
-			D3DMATRIX matWorldRotOnly = matWorld;
-			matWorldRotOnly._41 = 0.0f;
-			matWorldRotOnly._42 = 0.0f;
-			matWorldRotOnly._43 = 0.0f;
-			matWorldRotOnly._14 = 0.0f;
-			matWorldRotOnly._24 = 0.0f;
-			matWorldRotOnly._34 = 0.0f;
-			matWorldRotOnly._44 = 1.0f;
-
-			// Transform normal
-			D3DXVECTOR3 normal = { src.nx, src.ny, src.nz };
-			D3DXVECTOR3 transformedNormal;
-			D3DXVec3TransformNormal(&transformedNormal, &normal, &matWorldRotOnly);
-			if (D3DXVec3LengthSq(&normal) > 1e-12f)
-			{
-				D3DXVec3Normalize(&transformedNormal, &transformedNormal);
-			}
+	// Process vertices in batches so positions and normals can be transformed four at a time
+	D3DXVECTOR4 Homogeneous[VertexBatchSize];
+	D3DXVECTOR3 Normals[VertexBatchSize];
+	DWORD ClipCodes[VertexBatchSize];
 
-			D3DXVECTOR3 transformedPos = { dst.sx, dst.sy, dst.sz };
+	for (DWORD Start = 0; Start < dwCount; Start += VertexBatchSize)
+	{
+		const DWORD Count = min(VertexBatchSize, dwCount - Start);
+		T* srcBatch = srcVertex + Start;
+		D3DTLVERTEX* destBatch = destVertex + Start;
 
-			ComputeLighting(transformedPos, transformedNormal, cachedLights, lpMaterial, ambient, UseSpecular, Diffuse, Specular);
+		TransformPositions(matWorldViewProj, reinterpret_cast<BYTE*>(srcBatch), sizeof(T), reinterpret_cast<BYTE*>(destBatch), sizeof(D3DTLVERTEX), bClip ? Homogeneous : nullptr, Count);
 
-			dst.color = Diffuse;
-			dst.specular = Specular;
-			dst.tu = src.tu;
-			dst.tv = src.tv;
-		}
-		else if constexpr (std::is_same_v<T, D3DLVERTEX>)
+		if (bClip)
 		{
-			dst.color = src.color;
-			dst.specular = src.specular;
-			dst.tu = src.tu;
-			dst.tv = src.tv;
-		}
-		else
-		{
-			static_assert(false);
+			ClipUnion |= ComputeClipCodes(Homogeneous, ClipCodes, Count, ClipIntersection);
 		}
 
-		// Fill homogeneous out if requested
-		if (pHOut)
+		if constexpr (std::is_same_v<T, D3DVERTEX>)
 		{
-			D3DHVERTEX& hdst = pHOut[i];
-			// Store pre-divide homogeneous coords
-			hdst.hx = h.x;
-			hdst.hy = h.y;
-			hdst.hz = h.z;
-			hdst.dwFlags = 0; // Clip flags not computed here (TransformVertices only sets them if clipping performed upstream)
+			TransformNormals(matWorldRotOnly, reinterpret_cast<BYTE*>(&srcBatch->nx), sizeof(T), Normals, Count);
 		}
 
-		// Update extents
-		if (bUpdateExtents)
+		for (DWORD i = 0; i < Count; ++i)
 		{
-			// floor/ceil convert to integer extents
-			newExtents.x1 = min(newExtents.x1, static_cast<LONG>(floorf(dst.sx)));
-			newExtents.y1 = min(newExtents.y1, static_cast<LONG>(floorf(dst.sy)));
-			newExtents.x2 = max(newExtents.x2, static_cast<LONG>(ceilf(dst.sx)));
-			newExtents.y2 = max(newExtents.y2, static_cast<LONG>(ceilf(dst.sy)));
+			T& src = srcBatch[i];
+			D3DTLVERTEX& dst = destBatch[i];
+
+			// Default values: set for XYZ or copy for detailed vertex
+			if constexpr (std::is_same_v<T, XYZ>)
+			{
+				dst.color = 0xFFFFFFFF;	// Default to white
+				dst.specular = 0;
+				dst.tu = 0.0f;
+				dst.tv = 0.0f;
+			}
+			else if constexpr (std::is_same_v<T, D3DVERTEX>)
+			{
+				D3DCOLOR Diffuse = 0, Specular = 0;
+
+				D3DXVECTOR3 transformedPos = { dst.sx, dst.sy, dst.sz };
+
+				ComputeLighting(transformedPos, Normals[i], LightingContext, Diffuse, Specular);
+
+				dst.color = Diffuse;
+				dst.specular = Specular;
+				dst.tu = src.tu;
+				dst.tv = src.tv;
+			}
+			else if constexpr (std::is_same_v<T, D3DLVERTEX>)
+			{
+				dst.color = src.color;
+				dst.specular = src.specular;
+				dst.tu = src.tu;
+				dst.tv = src.tv;
+			}
+			else
+			{
+				static_assert(false);
+			}
+
+			// Fill homogeneous out if requested
+			if (pHOut)
+			{
+				D3DHVERTEX& hdst = pHOut[Start + i];
+				// Store pre-divide homogeneous coords
+				hdst.hx = Homogeneous[i].x;
+				hdst.hy = Homogeneous[i].y;
+				hdst.hz = Homogeneous[i].z;
+				hdst.dwFlags = ClipCodes[i];
+			}
 		}
+
+		// Map to screen space and update extents
+		ApplyViewportTransform(ViewportTransform, reinterpret_cast<BYTE*>(destBatch), sizeof(D3DTLVERTEX), Count, bUpdateExtents ? &ExtentMin : nullptr, bUpdateExtents ? &ExtentMax : nullptr);
+	}
+
+	if (lpClipStatus)
+	{
+		*lpClipStatus = (ClipUnion & D3DCLIP_FRUSTUM) | ((ClipIntersection & D3DCLIP_FRUSTUM) << 12);
 	}
 
-	if (bUpdateExtents && newExtents.x1 != LONG_MAX)
+	if (bUpdateExtents && ExtentMin.x <= ExtentMax.x)
 	{
+		// floor/ceil convert to integer extents
+		D3DRECT newExtents = {
+			static_cast<LONG>(floorf(ExtentMin.x)),
+			static_cast<LONG>(floorf(ExtentMin.y)),
+			static_cast<LONG>(ceilf(ExtentMax.x)),
+			static_cast<LONG>(ceilf(ExtentMax.y)) };
+
 		if (!IsRectZero(drExtent))
 		{
 			// Merge with existing extents if valid
@@ -1435,35 +1457,91 @@ HRESULT m_IDirect3DVertexBufferX::TransformVertexUP(m_IDirect3DDeviceX* pDirect3
 	return D3D_OK;
 }
 
-void m_IDirect3DVertexBufferX::ComputeLighting(const D3DVECTOR& Position, const D3DVECTOR& Normal, const std::vector<DXLIGHT7>& cachedLights, const LPD3DMATERIAL7 pMat, D3DCOLOR ambient, bool UseSpecular, D3DCOLOR& outColor, D3DCOLOR& outSpecular)
+void m_IDirect3DVertexBufferX::PrepareLighting(LIGHTINGCONTEXT& Context, const std::vector<DXLIGHT7>& cachedLights, const LPD3DMATERIAL7 pMat, D3DCOLOR ambient, bool UseSpecular)
 {
-	// Note: assumes Normal and cached lights (spot & directional) are already normalized
-
-	// Vertex normal
-	D3DXVECTOR3 worldNormal(Normal.x, Normal.y, Normal.z);
-
-	// If a vertex has zero normals, it usually should be lit only by ambient.
-	if (D3DXVec3LengthSq(&worldNormal) < 1e-12f)
-	{
-		outColor = ambient;
-		outSpecular = 0;
-		return;
-	}
-
 	// Disable specular if material specular is zero
 	if (UseSpecular && pMat && IsColorValueZero(pMat->dcvSpecular))
 	{
 		UseSpecular = false;
 	}
 
+	Context.Ambient = ambient;
+	Context.UseSpecular = UseSpecular;
+
 	// Default material: fully lit
-	bool isDefaultMaterial =
+	Context.IsDefaultMaterial =
 		pMat &&
 		pMat->diffuse.r == 1.0f && pMat->diffuse.g == 1.0f && pMat->diffuse.b == 1.0f &&
 		pMat->ambient.r == 1.0f && pMat->ambient.g == 1.0f && pMat->ambient.b == 1.0f &&
 		!UseSpecular;
 
-	if (isDefaultMaterial)
+	Context.Alpha = pMat ? pMat->diffuse.a : 1.0f;
+	Context.Power = pMat ? CLAMP(pMat->power, 1.0f, 128.0f) : 1.0f;
+
+	// Ambient light
+	if (pMat)
+	{
+		Context.MaterialAmbient.r = pMat->ambient.r * (((ambient >> 16) & 0xFF) / 255.0f);
+		Context.MaterialAmbient.g = pMat->ambient.g * (((ambient >> 8) & 0xFF) / 255.0f);
+		Context.MaterialAmbient.b = pMat->ambient.b * ((ambient & 0xFF) / 255.0f);
+	}
+	else
+	{
+		Context.MaterialAmbient = {};
+	}
+
+	Context.Lights.clear();
+	Context.Lights.reserve(cachedLights.size());
+
+	for (const auto& light : cachedLights)
+	{
+		if (light.dltType != D3DLIGHT_DIRECTIONAL && light.dltType != D3DLIGHT_POINT && light.dltType != D3DLIGHT_SPOT)
+		{
+			continue; // unsupported light type
+		}
+
+		LIGHTCONST Light;
+		Light.Type = light.dltType;
+		Light.Position = light.dvPosition;
+		Light.Direction = light.dvDirection;
+		Light.Range = light.dvRange;
+		Light.Attenuation0 = light.dvAttenuation0;
+		Light.Attenuation1 = light.dvAttenuation1;
+		Light.Attenuation2 = light.dvAttenuation2;
+		Light.CosPhi = cosf(light.dvPhi * 0.5f);
+		Light.CosTheta = cosf(light.dvTheta * 0.5f);
+		Light.Falloff = max(light.dvFalloff, 1.0f);
+		Light.Diffuse = light.dcvDiffuse;
+		Light.UseSpecular = UseSpecular && pMat && !(light.dwFlags & D3DLIGHT_NO_SPECULAR);
+
+		if (Light.UseSpecular)
+		{
+			const bool IsLight7 = (light.dwLightVersion == 7);
+			Light.Specular.r = pMat->specular.r * (IsLight7 ? light.dcvSpecular.r : 1.0f);
+			Light.Specular.g = pMat->specular.g * (IsLight7 ? light.dcvSpecular.g : 1.0f);
+			Light.Specular.b = pMat->specular.b * (IsLight7 ? light.dcvSpecular.b : 1.0f);
+		}
+
+		Context.Lights.push_back(Light);
+	}
+}
+
+void m_IDirect3DVertexBufferX::ComputeLighting(const D3DVECTOR& Position, const D3DVECTOR& Normal, const LIGHTINGCONTEXT& Context, D3DCOLOR& outColor, D3DCOLOR& outSpecular)
+{
+	// Note: assumes Normal and cached lights (spot & directional) are already normalized
+
+	// Vertex normal
+	D3DXVECTOR3 worldNormal(Normal.x, Normal.y, Normal.z);
+
+	// If a vertex has zero normals, it usually should be lit only by ambient.
+	if (D3DXVec3LengthSq(&worldNormal) < 1e-12f)
+	{
+		outColor = Context.Ambient;
+		outSpecular = 0;
+		return;
+	}
+
+	if (Context.IsDefaultMaterial)
 	{
 		outColor = D3DCOLOR_COLORVALUE(1.0f, 1.0f, 1.0f, 1.0f);
 		outSpecular = 0;
@@ -1479,59 +1557,39 @@ void m_IDirect3DVertexBufferX::ComputeLighting(const D3DVECTOR& Position, const
 	float r = 0.0f, g = 0.0f, b = 0.0f;
 	float sr = 0.0f, sg = 0.0f, sb = 0.0f;
 
-	// Ambient light
-	float ar = ((ambient >> 16) & 0xFF) / 255.0f;
-	float ag = ((ambient >> 8) & 0xFF) / 255.0f;
-	float ab = (ambient & 0xFF) / 255.0f;
-
-	for (const auto& light : cachedLights)
+	for (const auto& light : Context.Lights)
 	{
 		D3DXVECTOR3 toLight;
 		float attenuation = 1.0f;
 
-		switch (light.dltType)
+		if (light.Type == D3DLIGHT_DIRECTIONAL)
 		{
-		case D3DLIGHT_DIRECTIONAL:
-		{
-			D3DXVECTOR3 dir(light.dvDirection.x, light.dvDirection.y, light.dvDirection.z);
-			toLight = -dir;
-			break;
+			toLight = D3DXVECTOR3(-light.Direction.x, -light.Direction.y, -light.Direction.z);
 		}
-		case D3DLIGHT_POINT:
-		case D3DLIGHT_SPOT:
+		else
 		{
-			D3DXVECTOR3 lightPos(light.dvPosition.x, light.dvPosition.y, light.dvPosition.z);
-			toLight = lightPos - pos;
+			toLight = D3DXVECTOR3(light.Position.x - pos.x, light.Position.y - pos.y, light.Position.z - pos.z);
 
 			float dist = D3DXVec3LengthSq(&toLight);
 			if (dist < 1e-12f) continue;
 
 			toLight *= (1.0f / dist);
 
-			attenuation = 1.0f / (light.dvAttenuation0 + light.dvAttenuation1 * dist + light.dvAttenuation2 * dist * dist);
+			attenuation = 1.0f / (light.Attenuation0 + light.Attenuation1 * dist + light.Attenuation2 * dist * dist);
 			if (attenuation <= 0.0f) continue;
-			if (light.dvRange > 0.0f && dist > light.dvRange) continue;
+			if (light.Range > 0.0f && dist > light.Range) continue;
 
-			if (light.dltType == D3DLIGHT_SPOT)
+			if (light.Type == D3DLIGHT_SPOT)
 			{
-				D3DXVECTOR3 dir(light.dvDirection.x, light.dvDirection.y, light.dvDirection.z);
-
-				D3DXVECTOR3 negLight = -toLight;
-				float spotCos = D3DXVec3Dot(&negLight, &dir);
+				float spotCos = -(toLight.x * light.Direction.x + toLight.y * light.Direction.y + toLight.z * light.Direction.z);
 				spotCos = max(-1.0f, min(1.0f, spotCos));
 
-				float cosPhi = cosf(light.dvPhi * 0.5f);
-				if (spotCos < cosPhi) continue;
+				if (spotCos < light.CosPhi) continue;
 
-				float cosTheta = cosf(light.dvTheta * 0.5f);
-				float prefalloff = cosTheta != cosPhi ? (spotCos - cosPhi) / (cosTheta - cosPhi) : 1.0f;
+				float prefalloff = light.CosTheta != light.CosPhi ? (spotCos - light.CosPhi) / (light.CosTheta - light.CosPhi) : 1.0f;
 
-				attenuation *= powf(prefalloff, max(light.dvFalloff, 1.0f));
+				attenuation *= FastPow(prefalloff, light.Falloff);
 			}
-			break;
-		}
-		default:
-			continue; // unsupported light type
 		}
 
 		float NdotL = max(0.0f, D3DXVec3Dot(&worldNormal, &toLight));
@@ -1539,52 +1597,42 @@ void m_IDirect3DVertexBufferX::ComputeLighting(const D3DVECTOR& Position, const
 
 		attenuation = min(max(attenuation, 0.0f), 1.0f);
 
-		r += light.dcvDiffuse.r * NdotL * attenuation;
-		g += light.dcvDiffuse.g * NdotL * attenuation;
-		b += light.dcvDiffuse.b * NdotL * attenuation;
+		r += light.Diffuse.r * NdotL * attenuation;
+		g += light.Diffuse.g * NdotL * attenuation;
+		b += light.Diffuse.b * NdotL * attenuation;
 
-		if (UseSpecular && pMat && !(light.dwFlags & D3DLIGHT_NO_SPECULAR))
+		if (light.UseSpecular)
 		{
 			D3DXVECTOR3 reflectDir = (worldNormal * (2.0f * NdotL)) - toLight;
 
-			D3DXVec3Normalize(&reflectDir, &reflectDir);
+			float reflectLengthSq = D3DXVec3LengthSq(&reflectDir);
+			if (reflectLengthSq > 0.0f)
+			{
+				reflectDir *= 1.0f / sqrtf(reflectLengthSq);
+			}
 
 			float RdotV = max(0.0f, D3DXVec3Dot(&reflectDir, &viewDir));
-			float spec = powf(RdotV, CLAMP(pMat->power, 1.0f, 128.0f)) * attenuation;
+			float spec = FastPow(RdotV, Context.Power) * attenuation;
 
-			if (light.dwLightVersion != 7)
-			{
-				sr += pMat->specular.r * spec;
-				sg += pMat->specular.g * spec;
-				sb += pMat->specular.b * spec;
-			}
-			else
-			{
-				sr += pMat->specular.r * light.dcvSpecular.r * spec;
-				sg += pMat->specular.g * light.dcvSpecular.g * spec;
-				sb += pMat->specular.b * light.dcvSpecular.b * spec;
-			}
+			sr += light.Specular.r * spec;
+			sg += light.Specular.g * spec;
+			sb += light.Specular.b * spec;
 		}
 	}
 
-	if (pMat)
-	{
-		r += pMat->ambient.r * ar;
-		g += pMat->ambient.g * ag;
-		b += pMat->ambient.b * ab;
-	}
-
-	float alpha = pMat ? pMat->diffuse.a : 1.0f;
+	r += Context.MaterialAmbient.r;
+	g += Context.MaterialAmbient.g;
+	b += Context.MaterialAmbient.b;
 
 	// Clamp and convert to DWORD color
 	outColor = D3DCOLOR_COLORVALUE(
 		CLAMP(r, 0.0f, 1.0f),
 		CLAMP(g, 0.0f, 1.0f),
 		CLAMP(b, 0.0f, 1.0f),
-		alpha);
+		Context.Alpha);
 
 	// Clamp and convert to DWORD specular
-	outSpecular = UseSpecular ? D3DCOLOR_COLORVALUE(
+	outSpecular = Context.UseSpecular ? D3DCOLOR_COLORVALUE(
 		CLAMP(sr, 0.0f, 1.0f),
 		CLAMP(sg, 0.0f, 1.0f),
 		CLAMP(sb, 0.0f, 1.0f),
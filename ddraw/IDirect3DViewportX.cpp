@@ -264,12 +264,8 @@ HRESULT m_IDirect3DViewportX::TransformVertices(DWORD dwVertexCount, LPD3DTRANSF
 			return DDERR_INVALIDPARAMS;
 		}
 
-		if (dwFlags & D3DTRANSFORM_CLIPPED)
-		{
-			LOG_LIMIT(100, __FUNCTION__ << " Warning: D3DTRANSFORM_CLIPPED is ignored");
-		}
-
-		// D3DTRANSFORM_UNCLIPPED: flag can be safily ignored
+		// D3DTRANSFORM_UNCLIPPED: vertices are known to be on screen so clip status is skipped
+		const bool IsClipped = (dwFlags & D3DTRANSFORM_CLIPPED) != 0;
 
 		if (AttachedD3DDevices.empty())
 		{
@@ -289,23 +285,22 @@ HRESULT m_IDirect3DViewportX::TransformVertices(DWORD dwVertexCount, LPD3DTRANSF
 			LOG_LIMIT(100, __FUNCTION__ << " Warning: More than one attached Direct3DDeviceX interface!");
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		D3DTLVERTEX* pOut = reinterpret_cast<D3DTLVERTEX*>(lpData->lpOut);
 		D3DHVERTEX* pHOut = reinterpret_cast<D3DHVERTEX*>(lpData->lpHOut);
 
+		DWORD ClipStatus = 0;
+		LPDWORD lpClipStatus = IsClipped ? &ClipStatus : nullptr;
+
 		HRESULT hr;
 		if (lpData->dwInSize == sizeof(XYZ))
 		{
 			XYZ* pIn = reinterpret_cast<XYZ*>(lpData->lpIn);
-			hr = m_IDirect3DVertexBufferX::TransformVertexUP(pDirect3DDeviceX, pIn, pOut, pHOut, dwVertexCount, lpData->drExtent, false, true);
+			hr = m_IDirect3DVertexBufferX::TransformVertexUP(pDirect3DDeviceX, pIn, pOut, pHOut, dwVertexCount, lpData->drExtent, lpClipStatus, false, true);
 		}
 		else if (lpData->dwInSize == sizeof(D3DLVERTEX))
 		{
 			D3DLVERTEX* pIn = reinterpret_cast<D3DLVERTEX*>(lpData->lpIn);
-			hr = m_IDirect3DVertexBufferX::TransformVertexUP(pDirect3DDeviceX, pIn, pOut, pHOut, dwVertexCount, lpData->drExtent, false, true);
+			hr = m_IDirect3DVertexBufferX::TransformVertexUP(pDirect3DDeviceX, pIn, pOut, pHOut, dwVertexCount, lpData->drExtent, lpClipStatus, false, true);
 		}
 		else
 		{
@@ -313,16 +308,15 @@ HRESULT m_IDirect3DViewportX::TransformVertices(DWORD dwVertexCount, LPD3DTRANSF
 			hr = DDERR_INVALIDPARAMS;
 		}
 
+		lpData->dwClipUnion = ClipStatus & D3DSTATUS_CLIPUNIONALL;
+		lpData->dwClipIntersection = (ClipStatus & D3DSTATUS_CLIPINTERSECTIONALL) >> 12;
+
 		//Address of a variable that is set to a nonzero value if the resulting vertices are all off-screen.
 		if (lpOffscreen)
 		{
-			*lpOffscreen = 0;
+			*lpOffscreen = (SUCCEEDED(hr) && lpData->dwClipIntersection) ? 1 : 0;
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)D3D_OK << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -383,10 +377,6 @@ HRESULT m_IDirect3DViewportX::LightElements(DWORD dwElementCount, LPD3DLIGHTDATA
 
 		LOG_LIMIT(100, __FUNCTION__ << " Warning: emulating LightElements()!");
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		// Get lighting info
 		bool UseSpecular = false;
 		if (DWORD rsSpecular = 0; SUCCEEDED(pDirect3DDeviceX->GetRenderState(D3DRENDERSTATE_SPECULARENABLE, &rsSpecular)))
@@ -410,6 +400,9 @@ HRESULT m_IDirect3DViewportX::LightElements(DWORD dwElementCount, LPD3DLIGHTDATA
 		std::vector<DXLIGHT7> cachedLights;
 		GetEnabledLightList(cachedLights, pDirect3DDeviceX);
 
+		LIGHTINGCONTEXT LightingContext;
+		m_IDirect3DVertexBufferX::PrepareLighting(LightingContext, cachedLights, lpMaterial, ambient, UseSpecular);
+
 		// Get world & view transforms for pre-transform
 		D3DMATRIX matWorld, matView;
 		if (FAILED(pDirect3DDeviceX->GetTransform(D3DTRANSFORMSTATE_WORLD, &matWorld)) ||
@@ -455,7 +448,7 @@ HRESULT m_IDirect3DViewportX::LightElements(DWORD dwElementCount, LPD3DLIGHTDATA
 
 			// Compute lighting
 			D3DCOLOR diffuse = 0, specular = 0;
-			m_IDirect3DVertexBufferX::ComputeLighting(transformedPos, transformedNormal, cachedLights, lpMaterial, ambient, UseSpecular, diffuse, specular);
+			m_IDirect3DVertexBufferX::ComputeLighting(transformedPos, transformedNormal, LightingContext, diffuse, specular);
 
 			// Output TL vertex
 			D3DTLVERTEX& outV = out[i];
@@ -469,10 +462,6 @@ HRESULT m_IDirect3DViewportX::LightElements(DWORD dwElementCount, LPD3DLIGHTDATA
 			outV.tv = 0.0f;
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)D3D_OK << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return D3D_OK;
 	}
 
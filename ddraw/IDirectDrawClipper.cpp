@@ -321,6 +321,7 @@ HRESULT m_IDirectDrawClipper::SetClipList(LPRGNDATA lpClipList, DWORD dwFlags)
 		{
 			// Delete associated clip list if it exists
 			IsClipListSet = false;
+			ClipListUSN++;
 		}
 		else
 		{
@@ -357,6 +358,7 @@ HRESULT m_IDirectDrawClipper::SetClipList(LPRGNDATA lpClipList, DWORD dwFlags)
 
 			// Set clip list to lpClipList
 			IsClipListSet = true;
+			ClipListUSN++;
 
 			DWORD Size = sizeof(RGNDATAHEADER) + lpClipList->rdh.nRgnSize;
 			ClipList.resize(Size);
@@ -385,8 +387,10 @@ HRESULT m_IDirectDrawClipper::SetHWnd(DWORD dwFlags, HWND hWnd)
 		// Load clip list from window
 
 		IsClipListSet = false;
+		ClipListUSN++;
 
 		cliphWnd = hWnd;
+		VisibleRgnData.clear();
 
 		return DD_OK;
 	}
@@ -408,7 +412,9 @@ void m_IDirectDrawClipper::InitInterface(DWORD dwFlags)
 	clipperCaps = dwFlags;
 	cliphWnd = nullptr;
 	ClipList.clear();
+	VisibleRgnData.clear();
 	IsClipListSet = false;
+	ClipListUSN++;
 }
 
 void m_IDirectDrawClipper::ReleaseInterface()
@@ -431,6 +437,7 @@ bool m_IDirectDrawClipper::CheckHwnd()
 	if (cliphWnd && !IsWindow(cliphWnd))
 	{
 		IsClipListSet = false;
+		ClipListUSN++;
 
 		cliphWnd = nullptr;
 
@@ -452,6 +459,123 @@ bool m_IDirectDrawClipper::GetClipBoundsFromData(RECT& bounds)
 	return false;
 }
 
+void m_IDirectDrawClipper::UpdateVisibleRegion()
+{
+	// Occlusion changes without a window move are picked up after the check interval
+	constexpr DWORD CheckInterval = 16;
+
+	RECT clientRect = {};
+	GetClientRect(cliphWnd, &clientRect);
+	MapWindowPoints(cliphWnd, HWND_DESKTOP, (LPPOINT)&clientRect, 2);
+
+	const DWORD Now = GetTickCount();
+	if (!VisibleRgnData.empty() && EqualRect(&clientRect, &VisibleRgnRect) && Now - VisibleRgnTick < CheckInterval)
+	{
+		return;
+	}
+	VisibleRgnRect = clientRect;
+	VisibleRgnTick = Now;
+
+	// The system region of the window DC is the visible part of the client area in screen coordinates
+	std::vector<BYTE> RgnData;
+	HRGN hRgn = CreateRectRgn(0, 0, 0, 0);
+	if (hRgn)
+	{
+		HDC hDC = ::GetDC(cliphWnd);
+		if (!hDC || GetRandomRgn(hDC, hRgn, SYSRGN) != 1)
+		{
+			SetRectRgn(hRgn, clientRect.left, clientRect.top, clientRect.right, clientRect.bottom);
+		}
+		if (hDC)
+		{
+			::ReleaseDC(cliphWnd, hDC);
+		}
+
+		DWORD Size = GetRegionData(hRgn, 0, nullptr);
+		if (Size)
+		{
+			RgnData.resize(Size);
+			if (!GetRegionData(hRgn, Size, reinterpret_cast<RGNDATA*>(RgnData.data())))
+			{
+				RgnData.clear();
+			}
+		}
+		DeleteObject(hRgn);
+	}
+
+	// Only a changed region invalidates the clip rects
+	if (RgnData != VisibleRgnData)
+	{
+		VisibleRgnData.swap(RgnData);
+		ClipListUSN++;
+	}
+}
+
+void m_IDirectDrawClipper::UpdateClipRects()
+{
+	if (ClipRectsUSN == ClipListUSN)
+	{
+		return;
+	}
+
+	ClipRects.clear();
+	ClipRectsUSN = ClipListUSN;
+
+	// Region data is already sorted y-x banded rects
+	if (!IsClipListSet)
+	{
+		if (VisibleRgnData.size() >= sizeof(RGNDATAHEADER))
+		{
+			const RGNDATA* pRgnData = reinterpret_cast<const RGNDATA*>(VisibleRgnData.data());
+			const RECT* rects = reinterpret_cast<const RECT*>(pRgnData->Buffer);
+			ClipRects.assign(rects, rects + pRgnData->rdh.nCount);
+		}
+		return;
+	}
+
+	// Let GDI merge the clip list, region data is returned as sorted y-x banded rects
+	HRGN hRgn = CreateRectRgn(0, 0, 0, 0);
+	if (hRgn && SUCCEEDED(GetClipRegion(hRgn)))
+	{
+		DWORD Size = GetRegionData(hRgn, 0, nullptr);
+		if (Size)
+		{
+			std::vector<BYTE> RgnData(Size);
+			if (GetRegionData(hRgn, Size, reinterpret_cast<RGNDATA*>(RgnData.data())))
+			{
+				const RGNDATA* pRgnData = reinterpret_cast<const RGNDATA*>(RgnData.data());
+				const RECT* rects = reinterpret_cast<const RECT*>(pRgnData->Buffer);
+				ClipRects.assign(rects, rects + pRgnData->rdh.nCount);
+			}
+		}
+	}
+	if (hRgn)
+	{
+		DeleteObject(hRgn);
+	}
+}
+
+bool m_IDirectDrawClipper::GetClipRectsFromData(const RECT& Rect, std::vector<RECT>& OutRects)
+{
+	OutRects.clear();
+
+	// Window clippers use the visible region of the window, the primary surface is in screen coordinates in windowed mode
+	if (!IsClipListSet)
+	{
+		if (!CheckHwnd() || (ddrawParent && ddrawParent->IsExclusiveMode()))
+		{
+			return false;
+		}
+		UpdateVisibleRegion();
+	}
+
+	UpdateClipRects();
+
+	IntersectClipRects(ClipRects, Rect, OutRects);
+
+	return true;
+}
+
 HRESULT m_IDirectDrawClipper::GetClipRegion(HRGN hOutRgn)
 {
 	if (!hOutRgn)
@@ -14,9 +14,17 @@ private:
 	std::vector<BYTE> ClipList;
 	bool IsClipListSet = false;
 	RECT LastClipBounds = {};
+	DWORD ClipListUSN = 1;						// Incremented each time the clip list changes
+	DWORD ClipRectsUSN = 0;						// The USN that was used last time the clip rects were built
+	std::vector<RECT> ClipRects;				// Clip list sorted into non-overlapping y-banded rects
+	std::vector<BYTE> VisibleRgnData;			// Visible region of the clipper window
+	RECT VisibleRgnRect = {};					// Client rect on screen when the visible region was read
+	DWORD VisibleRgnTick = 0;					// Tick count when the visible region was read
 
 	// Helper functions
 	bool CheckHwnd();
+	void UpdateVisibleRegion();
+	void UpdateClipRects();
 
 	// Interface initialization functions
 	void InitInterface(DWORD dwFlags);
@@ -90,6 +98,8 @@ public:
 	void ClearDdraw() { ddrawParent = nullptr; }
 	bool HasClipList() const { return IsClipListSet; }
 	bool GetClipBoundsFromData(RECT& bounds);
+	bool GetClipRectsFromData(const RECT& Rect, std::vector<RECT>& OutRects);
+	DWORD GetClipListUSN() const { return ClipListUSN; }
 	HRESULT GetClipRegion(HRGN hOutRgn);
 	static m_IDirectDrawClipper* CreateDirectDrawClipper(IDirectDrawClipper* aOriginal, m_IDirectDrawX* NewParent, DWORD dwFlags);
 };
@@ -232,11 +232,27 @@ HRESULT m_IDirectDrawPalette::SetEntries(DWORD dwFlags, DWORD dwStartingEntry, D
 			return DD_OK;
 		}
 
+		const bool UsingAlpha = (paletteCaps & DDPCAPS_ALPHA);
+
+		// Queued primitives using textures with this palette read it when they are drawn, so draw them before it changes
+		if (ddrawParent)
+		{
+			for (UINT i = Start, x = (Start - dwStartingEntry); i < End; i++, x++)
+			{
+				DXPALETTEENTRY SingleEntry = lpEntries[x];
+				SingleEntry.peFlags = UsingAlpha ? SingleEntry.peFlags : 0xFF;
+
+				if (rawPalette[i] != SingleEntry)
+				{
+					ddrawParent->FlushDrawBatches(nullptr, this);
+					break;
+				}
+			}
+		}
+
 		// Update palette data
 		bool FoundNewRecords = false;
 		{
-			const bool UsingAlpha = (paletteCaps & DDPCAPS_ALPHA);
-
 			// lpEntries array location
 			DWORD x = (Start - dwStartingEntry);
 
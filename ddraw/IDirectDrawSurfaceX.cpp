@@ -447,6 +447,8 @@ HRESULT m_IDirectDrawSurfaceX::Blt(LPRECT lpDestRect, LPDIRECTDRAWSURFACE7 lpDDS
 		" SyncSurfaces = " << SyncSurfaces <<
 		" PresentBlt = " << PresentBlt;
 
+	PROFILE_ZONE(ZONE_BLT);
+
 	// Check if source Surface exists
 	if (lpDDSrcSurface && !ProxyAddressLookupTable.IsValidWrapperAddress((m_IDirectDrawSurface*)lpDDSrcSurface))
 	{
@@ -456,6 +458,12 @@ HRESULT m_IDirectDrawSurfaceX::Blt(LPRECT lpDestRect, LPDIRECTDRAWSURFACE7 lpDDS
 
 	if (Config.Dd7to9)
 	{
+		// Draw any queued primitives before the surface is accessed
+		if (ddrawParent)
+		{
+			ddrawParent->FlushDrawBatches();
+		}
+
 		// All DDBLT_ALPHA flag values, Not currently implemented in DirectDraw.
 		DWORD AlphaFlags = dwFlags & (DDBLT_ALPHADEST | DDBLT_ALPHADESTCONSTOVERRIDE | DDBLT_ALPHADESTNEG | DDBLT_ALPHADESTSURFACEOVERRIDE |
 			DDBLT_ALPHASRC | DDBLT_ALPHASRCCONSTOVERRIDE | DDBLT_ALPHASRCNEG | DDBLT_ALPHASRCSURFACEOVERRIDE);
@@ -610,11 +618,6 @@ HRESULT m_IDirectDrawSurfaceX::Blt(LPRECT lpDestRect, LPDIRECTDRAWSURFACE7 lpDDS
 			}
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-		bool CopySurfaceFlag = false;
-#endif
-
 		HRESULT hr = DD_OK;
 
 		do {
@@ -706,10 +709,6 @@ HRESULT m_IDirectDrawSurfaceX::Blt(LPRECT lpDestRect, LPDIRECTDRAWSURFACE7 lpDDS
 
 				hr = CopySurface(lpDDSrcSurfaceX, lpSrcRect, lpDestRect, Filter, ColorKey.dwColorSpaceLowValue, Flags, SrcMipMapLevel, MipMapLevel);
 
-#ifdef ENABLE_PROFILING
-				CopySurfaceFlag = true;
-#endif
-
 			} while (false);
 
 			// Keep surface insync
@@ -745,14 +744,6 @@ HRESULT m_IDirectDrawSurfaceX::Blt(LPRECT lpDestRect, LPDIRECTDRAWSURFACE7 lpDDS
 
 		hr = LockReturnValue(hr, MipMapLevel, lpDDSrcSurfaceX, SrcMipMapLevel, BltWait);
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << lpDDSrcSurfaceX << ") -> (" << this << ")" <<
-			(CopySurfaceFlag ? " CopySurface()" : " ColorFill()") <<
-			" Type = " << lpDDSrcSurfaceX->surface.Type << " " << lpDDSrcSurfaceX->surface.Pool << " -> " << surface.Type << " " << surface.Pool <<
-			" hr = " << (D3DERR)hr <<
-			" Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		// Present surface
 		if (SUCCEEDED(hr) && PresentBlt)
 		{
@@ -1254,8 +1245,16 @@ HRESULT m_IDirectDrawSurfaceX::Flip(LPDIRECTDRAWSURFACE7 lpDDSurfaceTargetOverri
 		" Flags = " << Logging::hex(dwFlags) <<
 		" Version = " << DirectXVersion;
 
+	PROFILE_ZONE(ZONE_FLIP);
+
 	if (Config.Dd7to9)
 	{
+		// Draw any queued primitives before the surface is accessed
+		if (ddrawParent)
+		{
+			ddrawParent->FlushDrawBatches();
+		}
+
 		if ((dwFlags & (DDFLIP_EVEN | DDFLIP_ODD)) == (DDFLIP_EVEN | DDFLIP_ODD))
 		{
 			LOG_LIMIT(100, __FUNCTION__ << " Error: invalid flags!");
@@ -1426,11 +1425,6 @@ HRESULT m_IDirectDrawSurfaceX::Flip(LPDIRECTDRAWSURFACE7 lpDDSurfaceTargetOverri
 			}
 		}
 
-#ifdef ENABLE_PROFILING
-		HRESULT hr = DD_OK;
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr;
-#endif
-
 		// Present surface
 		EndWritePresent(nullptr, 0, SetVsync, false, true);
 
@@ -1788,8 +1782,16 @@ HRESULT m_IDirectDrawSurfaceX::GetDC(HDC FAR* lphDC, DWORD MipMapLevel)
 		" lpDC = " << (void*)lphDC <<
 		" MipMapLevel = " << MipMapLevel;
 
+	PROFILE_ZONE(ZONE_GETDC);
+
 	if (Config.Dd7to9)
 	{
+		// Draw any queued primitives before the surface is accessed
+		if (ddrawParent)
+		{
+			ddrawParent->FlushDrawBatches();
+		}
+
 		if (!lphDC)
 		{
 			return DDERR_INVALIDPARAMS;
@@ -1825,10 +1827,6 @@ HRESULT m_IDirectDrawSurfaceX::GetDC(HDC FAR* lphDC, DWORD MipMapLevel)
 		// Present before write if needed
 		BeginWritePresent(false);
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		HRESULT hr = DD_OK;
 
 		do {
@@ -1915,13 +1913,6 @@ HRESULT m_IDirectDrawSurfaceX::GetDC(HDC FAR* lphDC, DWORD MipMapLevel)
 
 		hr = LockReturnValue(hr, MipMapLevel, nullptr, 0, false);
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ")" <<
-			" Type = " << surface.Type << " " << surface.Pool <<
-			" hr = " << (D3DERR)hr <<
-			" Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -2363,8 +2354,16 @@ HRESULT m_IDirectDrawSurfaceX::Lock2(LPRECT lpDestRect, LPDDSURFACEDESC2 lpDDSur
 		" MipMapLevel = " << MipMapLevel <<
 		" Version = " << DirectXVersion;
 
+	PROFILE_ZONE(ZONE_LOCK);
+
 	if (Config.Dd7to9)
 	{
+		// Draw any queued primitives before the surface is accessed
+		if (ddrawParent)
+		{
+			ddrawParent->FlushDrawBatches();
+		}
+
 		// Check surfaceDesc size
 		if (lpDDSurfaceDesc2 && lpDDSurfaceDesc2->dwSize == sizeof(DDSURFACEDESC))
 		{
@@ -2517,10 +2516,6 @@ HRESULT m_IDirectDrawSurfaceX::Lock2(LPRECT lpDestRect, LPDDSURFACEDESC2 lpDDSur
 			}
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		HRESULT hr = DD_OK;
 
 		do {
@@ -2682,13 +2677,6 @@ HRESULT m_IDirectDrawSurfaceX::Lock2(LPRECT lpDestRect, LPDDSURFACEDESC2 lpDDSur
 
 		hr = LockReturnValue(hr, MipMapLevel, nullptr, 0, LockWait);
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ")" <<
-			" Type = " << surface.Type << " " << surface.Pool <<
-			" hr = " << (D3DERR)hr <<
-			" Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -2700,6 +2688,8 @@ HRESULT m_IDirectDrawSurfaceX::ReleaseDC(HDC hDC, DWORD MipMapLevel)
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")" <<
 		" DC = " << hDC;
 
+	PROFILE_ZONE(ZONE_RELEASEDC);
+
 	if (Config.Dd7to9)
 	{
 		// Check for device interface
@@ -2723,10 +2713,6 @@ HRESULT m_IDirectDrawSurfaceX::ReleaseDC(HDC hDC, DWORD MipMapLevel)
 			LOG_LIMIT(100, __FUNCTION__ << " Warning: HDC doesn't match: " << GetDCLevel[MipMapLevel] << " -> " << hDC);
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		HRESULT hr = DD_OK;
 
 		do {
@@ -2775,9 +2761,6 @@ HRESULT m_IDirectDrawSurfaceX::ReleaseDC(HDC hDC, DWORD MipMapLevel)
 
 		} while (false);
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
 		// Present surface
 		if (SUCCEEDED(hr))
 		{
@@ -2918,6 +2901,14 @@ HRESULT m_IDirectDrawSurfaceX::SetColorKey(DWORD dwFlags, LPDDCOLORKEY lpDDColor
 			return DDERR_NOCOLORKEYHW;
 		}
 
+		// Queued primitives using this texture read its source color key when they are drawn
+		if (dds == DDSD_CKSRCBLT && ddrawParent &&
+			(!lpDDColorKey ? (surfaceDesc2.dwFlags & dds) != 0 :
+				!(surfaceDesc2.dwFlags & dds) || lpDDColorKey->dwColorSpaceLowValue != surfaceDesc2.ddckCKSrcBlt.dwColorSpaceLowValue))
+		{
+			ddrawParent->FlushDrawBatches(this);
+		}
+
 		// Set color key
 		if (!lpDDColorKey)
 		{
@@ -3002,6 +2993,9 @@ HRESULT m_IDirectDrawSurfaceX::SetPalette(LPDIRECTDRAWPALETTE lpDDPalette)
 			return c_hr;
 		}
 
+		// Queued primitives using this texture read its palette when they are drawn
+		ddrawParent->FlushDrawBatches(this);
+
 		ScopedCriticalSection ThreadLockPE(DdrawWrapper::GetPECriticalSection());
 
 		// If palette exists increament ref
@@ -3040,6 +3034,7 @@ HRESULT m_IDirectDrawSurfaceX::SetPalette(LPDIRECTDRAWPALETTE lpDDPalette)
 		// Reset data for new palette
 		surface.LastPaletteUSN = 0;
 		surface.PaletteEntryArray = nullptr;
+		surface.PaletteLookupFormat = D3DFMT_UNKNOWN;
 
 		// Set new palette data
 		UpdatePaletteData();
@@ -3061,6 +3056,8 @@ HRESULT m_IDirectDrawSurfaceX::Unlock(LPRECT lpRect, DWORD MipMapLevel)
 		" Rect = " << lpRect <<
 		" MipMapLevel = " << MipMapLevel;
 
+	PROFILE_ZONE(ZONE_UNLOCK);
+
 	if (Config.Dd7to9)
 	{
 		// Handle dummy mipmaps
@@ -3112,10 +3109,6 @@ HRESULT m_IDirectDrawSurfaceX::Unlock(LPRECT lpRect, DWORD MipMapLevel)
 			}
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		HRESULT hr = DD_OK;
 
 		do {
@@ -3186,10 +3179,6 @@ HRESULT m_IDirectDrawSurfaceX::Unlock(LPRECT lpRect, DWORD MipMapLevel)
 
 		} while (false);
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		// If surface was changed
 		if (SUCCEEDED(hr) && !LastLock.ReadOnly)
 		{
@@ -4370,7 +4359,7 @@ LPDIRECT3DTEXTURE9 m_IDirectDrawSurfaceX::Get3DTexture()
 	// Prepare paletted surface for display
 	if (surface.IsPaletteDirty && IsUsingEmulation() && !primary.PaletteTexture)
 	{
-		CopyEmulatedPaletteSurface(nullptr);
+		CopyEmulatedPaletteSurface();
 	}
 
 	// Return palette display texture
@@ -4731,6 +4720,7 @@ HRESULT m_IDirectDrawSurfaceX::CreateD9Surface()
 		}
 
 		surface.IsPaletteDirty = IsPalette();
+		surface.PaletteDirtyRegion.SetFull();
 
 	} while (false);
 
@@ -5986,7 +5976,7 @@ void m_IDirectDrawSurfaceX::RemoveScanlines(LASTLOCK& LLock)
 		return;
 	}
 
-	DWORD size = EmuScanLine.ScanlineWidth * ByteCount;
+	DWORD size = RectWidth * ByteCount;
 	if (EmuScanLine.EvenScanLine.size() < size || EmuScanLine.OddScanLine.size() < size)
 	{
 		EmuScanLine.EvenScanLine.resize(size);
@@ -5995,42 +5985,19 @@ void m_IDirectDrawSurfaceX::RemoveScanlines(LASTLOCK& LLock)
 	EmuScanLine.ScanlineWidth = RectWidth;
 
 	BYTE* DestBuffer = (BYTE*)LLock.LockedRect.pBits;
+	const INT Pitch = LLock.LockedRect.Pitch;
 
 	// Check if video has scanlines
-	for (DWORD y = 0; y < RectHeight; y++)
+	DetectScanlines(DestBuffer, Pitch, size, RectHeight, EmuScanLine.bEvenScanlines, EmuScanLine.bOddScanlines);
+
+	// Store scanlines so they can be restored
+	if (EmuScanLine.bEvenScanlines)
 	{
-		// Check for even scanlines
-		if (y % 2 == 0)
-		{
-			if (y == 0)
-			{
-				EmuScanLine.bEvenScanlines = true;
-				memcpy(EmuScanLine.EvenScanLine.data(), DestBuffer, size);
-			}
-			else if (EmuScanLine.bEvenScanlines)
-			{
-				EmuScanLine.bEvenScanlines = (memcmp(EmuScanLine.EvenScanLine.data(), DestBuffer, size) == 0);
-			}
-		}
-		// Check for odd scanlines
-		else
-		{
-			if (y == 1)
-			{
-				EmuScanLine.bOddScanlines = true;
-				memcpy(EmuScanLine.OddScanLine.data(), DestBuffer, size);
-			}
-			else if (EmuScanLine.bOddScanlines)
-			{
-				EmuScanLine.bOddScanlines = (memcmp(EmuScanLine.OddScanLine.data(), DestBuffer, size) == 0);
-			}
-		}
-		// Exit if no scanlines found
-		if (!EmuScanLine.bOddScanlines && !EmuScanLine.bEvenScanlines)
-		{
-			break;
-		}
-		DestBuffer += LLock.LockedRect.Pitch;
+		memcpy(EmuScanLine.EvenScanLine.data(), DestBuffer, size);
+	}
+	if (EmuScanLine.bOddScanlines)
+	{
+		memcpy(EmuScanLine.OddScanLine.data(), DestBuffer + Pitch, size);
 	}
 
 	// If all scanlines are set then do nothing
@@ -6611,25 +6578,30 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 		return DDERR_INVALIDRECT;
 	}
 
-	// Handle clipper
-	if (attachedClipper)
+	// Handle clipper, every visible part of the rect is filled in the same pass
+	std::vector<RECT> ClipRects;
+	const RECT* pFillRects = &DestRect;
+	DWORD FillRectCount = 1;
+	if (attachedClipper && attachedClipper->GetClipRectsFromData(DestRect, ClipRects))
 	{
-		RECT clipBounds = {};
-		if (attachedClipper->GetClipBoundsFromData(clipBounds))
+		if (ClipRects.empty())
 		{
-			// Intersect destination rect with clip region
-			RECT clippedDest = {};
-			if (!IntersectRect(&clippedDest, &DestRect, &clipBounds))
-			{
-				// Fully clipped - no color fill needed
-				LOG_LIMIT(100, __FUNCTION__ << " Warning: dest rect is fully clipped!");
-				return DD_OK;
-			}
+			// Fully clipped - no color fill needed
+			LOG_LIMIT(100, __FUNCTION__ << " Warning: dest rect is fully clipped!");
+			return DD_OK;
+		}
+
+		pFillRects = ClipRects.data();
+		FillRectCount = (DWORD)ClipRects.size();
 
-			// Replace original rects with clipped/adjusted ones
-			DestRect = clippedDest;
+		// Dest rect becomes the bounding rect of the visible parts
+		DestRect = ClipRects[0];
+		for (DWORD x = 1; x < FillRectCount; x++)
+		{
+			UnionRect(&DestRect, &DestRect, &ClipRects[x]);
 		}
 	}
+	const bool IsFillRect = (pRect || pFillRects != &DestRect);
 
 	HRESULT hr = DDERR_GENERIC;
 
@@ -6691,15 +6663,9 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 				(*d3d9Device)->SetViewport(&NewViewport);
 			}
 
-			RECT* pDestRect = nullptr;
-			if (pRect)
-			{
-				pDestRect = &DestRect;
-			}
-
 			D3DCOLOR color = ConvertPixelColor(dwFillColor, surfaceDesc2.ddpfPixelFormat);
 
-			hr = (*d3d9Device)->Clear(pDestRect ? 1 : 0, (D3DRECT*)pDestRect, D3DCLEAR_TARGET, color, 1.0f, 0);
+			hr = (*d3d9Device)->Clear(IsFillRect ? FillRectCount : 0, IsFillRect ? (const D3DRECT*)pFillRects : nullptr, D3DCLEAR_TARGET, color, 1.0f, 0);
 			if (FAILED(hr))
 			{
 				LOG_LIMIT(100, __FUNCTION__ << " Error: failed to fill render target: " << (DDERR)hr);
@@ -6737,7 +6703,11 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 		{
 			D3DCOLOR color = ConvertPixelColor(dwFillColor, surfaceDesc2.ddpfPixelFormat);
 
-			hr = (*d3d9Device)->ColorFill(Dest.GetSurface(), &DestRect, color);
+			hr = D3D_OK;
+			for (DWORD x = 0; x < FillRectCount && SUCCEEDED(hr); x++)
+			{
+				hr = (*d3d9Device)->ColorFill(Dest.GetSurface(), &pFillRects[x], color);
+			}
 
 			if (FAILED(hr))
 			{
@@ -6751,16 +6721,12 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 		}
 	}
 
-	// Lock surface and manually fill with color
+	// Lock the bounding rect once and manually fill each visible part with color
 	{
-		// Get width and height of rect
-		LONG FillWidth = DestRect.right - DestRect.left;
-		LONG FillHeight = DestRect.bottom - DestRect.top;
-
 		// Check bit count
 		if (surface.BitCount != 8 && surface.BitCount != 12 && surface.BitCount != 16 && surface.BitCount != 24 && surface.BitCount != 32)
 		{
-			LOG_LIMIT(100, __FUNCTION__ << " Error: invalid bit count: " << surface.BitCount << " Width: " << FillWidth);
+			LOG_LIMIT(100, __FUNCTION__ << " Error: invalid bit count: " << surface.BitCount << " Width: " << (DestRect.right - DestRect.left));
 			return DDERR_GENERIC;
 		}
 
@@ -6788,31 +6754,55 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 									 (dwFillColor & 0xFF) == ((dwFillColor >> 16) & 0xFF) &&
 									 (dwFillColor & 0xFF) == ((dwFillColor >> 24) & 0xFF) : false;
 
-		if (FillWidth == (LONG)surfaceDesc2.dwWidth && CanUseMemSet)
+		// Get byte count
+		DWORD ByteCount = surface.BitCount / 8;
+		DWORD FillColor = dwFillColor;
+
+		// Handle 12-bit surface, two pixels are filled as one 3-byte pixel
+		if (surface.BitCount == 12)
 		{
-			memset(DestLockRect.pBits, dwFillColor, DestLockRect.Pitch * FillHeight);
+			ByteCount = 3;
+			FillColor = (dwFillColor & 0xFFF) + ((dwFillColor & 0xFFF) << 12);
 		}
-		else if (surface.BitCount == 8 || (surface.BitCount == 12 && FillWidth % 2 == 0) || surface.BitCount == 16 || surface.BitCount == 24 || surface.BitCount == 32)
+
+		hr = DD_OK;
+		for (DWORD i = 0; i < FillRectCount; i++)
 		{
-			// Get byte count
-			DWORD ByteCount = surface.BitCount / 8;
+			const RECT& FillRect = pFillRects[i];
+
+			// Get width and height of rect
+			LONG FillWidth = FillRect.right - FillRect.left;
+			LONG FillHeight = FillRect.bottom - FillRect.top;
+			LONG FillLeft = FillRect.left - DestRect.left;
+
+			if (surface.BitCount == 12 && (FillWidth % 2 != 0 || FillLeft % 2 != 0))
+			{
+				LOG_LIMIT(100, __FUNCTION__ << " Error: invalid bit count: " << surface.BitCount << " Width: " << FillWidth);
+				hr = DDERR_GENERIC;
+				break;
+			}
+
+			BYTE* pFillBits = (BYTE*)DestLockRect.pBits + (FillRect.top - DestRect.top) * DestLockRect.Pitch + FillLeft * (LONG)surface.BitCount / 8;
+
+			if (FillWidth == (LONG)surfaceDesc2.dwWidth && CanUseMemSet)
+			{
+				memset(pFillBits, dwFillColor, DestLockRect.Pitch * FillHeight);
+				continue;
+			}
 
-			// Handle 12-bit surface
 			if (surface.BitCount == 12)
 			{
-				ByteCount = 3;
-				dwFillColor = (dwFillColor & 0xFFF) + ((dwFillColor & 0xFFF) << 12);
 				FillWidth /= 2;
 			}
 
 			// Fill first line memory
 			if ((surface.BitCount == 8 || surface.BitCount == 16 || surface.BitCount == 32) &&								// Check bit count
-				(FillWidth % (sizeof(DWORD) / ByteCount) == 0) && reinterpret_cast<uintptr_t>(DestLockRect.pBits) % sizeof(DWORD) == 0)	// Check for aligned width and memory
+				(FillWidth % (sizeof(DWORD) / ByteCount) == 0) && reinterpret_cast<uintptr_t>(pFillBits) % sizeof(DWORD) == 0)	// Check for aligned width and memory
 			{
-				DWORD Color = (surface.BitCount == 8) ? (dwFillColor & 0xFF) * 0x01010101 :
-					(surface.BitCount == 16) ? (dwFillColor & 0xFFFF) * 0x00010001 : dwFillColor;
+				DWORD Color = (surface.BitCount == 8) ? (FillColor & 0xFF) * 0x01010101 :
+					(surface.BitCount == 16) ? (FillColor & 0xFFFF) * 0x00010001 : FillColor;
 
-				DWORD* DestBuffer = reinterpret_cast<DWORD*>(DestLockRect.pBits);
+				DWORD* DestBuffer = reinterpret_cast<DWORD*>(pFillBits);
 				LONG Iterations = FillWidth / (sizeof(DWORD) / ByteCount);
 
 				for (LONG x = 0; x < Iterations; ++x)
@@ -6822,8 +6812,8 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 			}
 			else
 			{
-				BYTE* SrcColor = reinterpret_cast<BYTE*>(&dwFillColor);
-				BYTE* DestBuffer = reinterpret_cast<BYTE*>(DestLockRect.pBits);
+				BYTE* SrcColor = reinterpret_cast<BYTE*>(&FillColor);
+				BYTE* DestBuffer = pFillBits;
 
 				for (LONG x = 0; x < FillWidth; ++x)
 				{
@@ -6837,8 +6827,8 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 			}
 
 			// Fill rest of surface rect using the first line as a template
-			BYTE* SrcBuffer = (BYTE*)DestLockRect.pBits;
-			BYTE* DestBuffer = (BYTE*)DestLockRect.pBits + DestLockRect.Pitch;
+			BYTE* SrcBuffer = pFillBits;
+			BYTE* DestBuffer = pFillBits + DestLockRect.Pitch;
 			size_t Size = FillWidth * ByteCount;
 			for (LONG y = 1; y < FillHeight; y++)
 			{
@@ -6846,11 +6836,6 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 				DestBuffer += DestLockRect.Pitch;
 			}
 		}
-		else
-		{
-			LOG_LIMIT(100, __FUNCTION__ << " Error: invalid bit count: " << surface.BitCount << " Width: " << FillWidth);
-			return DDERR_GENERIC;
-		}
 
 		// Unlock surface
 		if (!IsUsingEmulation())
@@ -6859,7 +6844,7 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor, DWOR
 		}
 	}
 
-	return DD_OK;
+	return hr;
 }
 
 HRESULT m_IDirectDrawSurfaceX::SaveDXTDataToDDS(const void *data, size_t dataSize, const char *filename, int dxtVersion) const
@@ -7023,6 +7008,8 @@ HRESULT m_IDirectDrawSurfaceX::SaveSurfaceToFile(const char *filename, D3DXIMAGE
 
 HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface, RECT* pSourceRect, RECT* pDestRect, D3DTEXTUREFILTERTYPE Filter, D3DCOLOR ColorKey, DWORD dwFlags, DWORD SrcMipMapLevel, DWORD MipMapLevel)
 {
+	PROFILE_ZONE(ZONE_COPYSURFACE);
+
 	// Check parameters
 	if (!pSourceSurface)
 	{
@@ -7084,98 +7071,147 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 		(IsStretchRect) ? D3DX_FILTER_POINT :												// Default to point filtering when stretching the rect, same as DirectDraw
 		D3DX_FILTER_NONE;
 
-#ifdef ENABLE_PROFILING
-	Logging::Log() << __FUNCTION__ << " (" << pSourceSurface << ") -> (" << this << ")" <<
-		" StretchRect = " << IsStretchRect <<
-		" ColorKey = " << IsColorKey <<
-		" MirrorLeftRight = " << IsMirrorLeftRight <<
-		" MirrorUpDown = " << IsMirrorUpDown;
-#endif
-
 	// Check rect and do clipping
 	if (!pSourceSurface->CheckCoordinates(SrcRect, &SrcRect, &SrcDesc2) || !CheckCoordinates(DestRect, &DestRect, &DestDesc2))
 	{
 		return DDERR_INVALIDRECT;
 	}
 
-	// Handle clipper
-	if (attachedClipper)
+	// Copies that are not stretched use the same size for the source and destination
+	if (!IsStretchRect)
 	{
-		RECT clipBounds = {};
-		if (attachedClipper->GetClipBoundsFromData(clipBounds))
-		{
-			// Intersect destination rect with clip region
-			RECT clippedDest = {};
-			if (!IntersectRect(&clippedDest, &DestRect, &clipBounds))
-			{
-				// Fully clipped - no blit needed
-				LOG_LIMIT(100, __FUNCTION__ << " Warning: dest rect is fully clipped!");
-				return DD_OK;
-			}
-
-			if (IsStretchRect)
-			{
-				// Calculate scaling factors
-				float scaleX = float(SrcRect.right - SrcRect.left) / float(DestRect.right - DestRect.left);
-				float scaleY = float(SrcRect.bottom - SrcRect.top) / float(DestRect.bottom - DestRect.top);
+		Filter = D3DTEXF_NONE;
+		const LONG Width = min(SrcRect.right - SrcRect.left, DestRect.right - DestRect.left);
+		const LONG Height = min(SrcRect.bottom - SrcRect.top, DestRect.bottom - DestRect.top);
+		SrcRect.right = SrcRect.left + Width;
+		SrcRect.bottom = SrcRect.top + Height;
+		DestRect.right = DestRect.left + Width;
+		DestRect.bottom = DestRect.top + Height;
+	}
+
+	// Lambda function to get the part of the source rect that maps to a clipped dest rect
+	auto GetClippedSrcRect = [&](const RECT& clippedDest) -> RECT {
+		if (IsStretchRect)
+		{
+			// Source span read by the part when stepping the whole stretch from its origin
+			LONG SrcLeft, SrcRight, SrcTop, SrcBottom;
+			GetStretchSrcSpan(SrcRect.right - SrcRect.left, DestRect.right - DestRect.left,
+				clippedDest.left - DestRect.left, clippedDest.right - DestRect.left, IsMirrorLeftRight, SrcLeft, SrcRight);
+			GetStretchSrcSpan(SrcRect.bottom - SrcRect.top, DestRect.bottom - DestRect.top,
+				clippedDest.top - DestRect.top, clippedDest.bottom - DestRect.top, IsMirrorUpDown, SrcTop, SrcBottom);
+			return { SrcRect.left + SrcLeft, SrcRect.top + SrcTop, SrcRect.left + SrcRight, SrcRect.top + SrcBottom };
+		}
+
+		// Calculate how many pixels were clipped off each side, mirroring flips which side of the source each clipped edge comes from
+		const LONG OffsetLeft = IsMirrorLeftRight ? DestRect.right - clippedDest.right : clippedDest.left - DestRect.left;
+		const LONG OffsetRight = IsMirrorLeftRight ? DestRect.right - clippedDest.left : clippedDest.right - DestRect.left;
+		const LONG OffsetTop = IsMirrorUpDown ? DestRect.bottom - clippedDest.bottom : clippedDest.top - DestRect.top;
+		const LONG OffsetBottom = IsMirrorUpDown ? DestRect.bottom - clippedDest.top : clippedDest.bottom - DestRect.top;
+		return {
+			SrcRect.left + OffsetLeft,
+			SrcRect.top + OffsetTop,
+			min(SrcRect.left + OffsetRight, SrcRect.right),
+			min(SrcRect.top + OffsetBottom, SrcRect.bottom)
+		};
+		};
 
-				// Lambda function to round up
-				auto RoundF = [](float value) {
-					return int(value + 0.5f);
-					};
+	// Handle clipper, the clip list is read once and every visible part is copied in the same pass
+	std::vector<RECT> ClipRects;
+	if (attachedClipper && attachedClipper->GetClipRectsFromData(DestRect, ClipRects))
+	{
+		if (ClipRects.empty())
+		{
+			// Fully clipped - no blit needed
+			LOG_LIMIT(100, __FUNCTION__ << " Warning: dest rect is fully clipped!");
+			return DD_OK;
+		}
 
-				// Adjust source rect proportionally
-				SrcRect = {
-					SrcRect.left + RoundF((clippedDest.left - DestRect.left) * scaleX),
-					SrcRect.top + RoundF((clippedDest.top - DestRect.top) * scaleY),
-					SrcRect.left + RoundF((clippedDest.right - DestRect.left) * scaleX),
-					SrcRect.top + RoundF((clippedDest.bottom - DestRect.top) * scaleY)
-				};
-			}
-			else
-			{
-				// Calculate how many pixels were clipped off each side
-				SrcRect.left += clippedDest.left - DestRect.left;
-				SrcRect.top += clippedDest.top - DestRect.top;
-				SrcRect.right -= DestRect.right - clippedDest.right;
-				SrcRect.bottom -= DestRect.bottom - clippedDest.bottom;
-			}
+		// A single part that is not a clipped stretch is copied as a plain rect
+		if (ClipRects.size() == 1 && (!IsStretchRect || EqualRect(&ClipRects[0], &DestRect)))
+		{
+			const RECT ClipSrcRect = GetClippedSrcRect(ClipRects[0]);
 
 			// Check if rect is fully clipped
-			if (SrcRect.left >= SrcRect.right || SrcRect.top >= SrcRect.bottom)
+			if (ClipSrcRect.left >= ClipSrcRect.right || ClipSrcRect.top >= ClipSrcRect.bottom)
 			{
 				LOG_LIMIT(100, __FUNCTION__ << " Warning: source rect is fully clipped!");
 				return DD_OK;
 			}
 
-			// Adjusted dest rects
-			DestRect = clippedDest;
+			// Adjusted source and dest rects
+			SrcRect = ClipSrcRect;
+			DestRect = ClipRects[0];
+			ClipRects.clear();
 		}
 	}
 
-	// Get width and height of rect
-	LONG SrcRectWidth = SrcRect.right - SrcRect.left;
-	LONG SrcRectHeight = SrcRect.bottom - SrcRect.top;
-	LONG DestRectWidth = DestRect.right - DestRect.left;
-	LONG DestRectHeight = DestRect.bottom - DestRect.top;
+	// Copies within the same surface
+	const bool IsSameSurface = (pSourceSurface == this && MipMapLevel == SrcMipMapLevel);
 
-	if (!IsStretchRect)
+	// Parts of the copy, clipped stretches step each part from the origin of the whole stretch
+	const bool IsClipped = !ClipRects.empty();
+	const RECT* pPartRects = IsClipped ? ClipRects.data() : &DestRect;
+	const DWORD PartCount = IsClipped ? (DWORD)ClipRects.size() : 1;
+
+	// Bounding rects of the visible parts, these are locked once for all parts
+	RECT SrcBounds = SrcRect, DestBounds = DestRect;
+	if (IsClipped)
 	{
-		Filter = D3DTEXF_NONE;
-		SrcRectWidth = min(SrcRectWidth, DestRectWidth);
-		SrcRectHeight = min(SrcRectHeight, DestRectHeight);
-		DestRectWidth = SrcRectWidth;
-		DestRectHeight = SrcRectHeight;
-		SrcRect.right = SrcRect.left + SrcRectWidth;
-		SrcRect.bottom = SrcRect.top + SrcRectHeight;
-		DestRect.right = DestRect.left + DestRectWidth;
-		DestRect.bottom = DestRect.top + DestRectHeight;
+		// When copying within the same surface order the parts so no part reads pixels already written by another part
+		if (IsSameSurface && !IsStretchRect)
+		{
+			const LONG SignY = (DestRect.top > SrcRect.top) ? -1 : 1;
+			const LONG SignX = (DestRect.left > SrcRect.left) ? -1 : 1;
+			std::sort(ClipRects.begin(), ClipRects.end(), [&](const RECT& a, const RECT& b) {
+				return (a.top != b.top) ? a.top * SignY < b.top * SignY : a.left * SignX < b.left * SignX;
+				});
+		}
+
+		SetRectEmpty(&SrcBounds);
+		SetRectEmpty(&DestBounds);
+		for (const RECT& ClipRect : ClipRects)
+		{
+			const RECT ClipSrcRect = GetClippedSrcRect(ClipRect);
+			if (ClipSrcRect.left < ClipSrcRect.right && ClipSrcRect.top < ClipSrcRect.bottom)
+			{
+				UnionRect(&SrcBounds, &SrcBounds, &ClipSrcRect);
+				UnionRect(&DestBounds, &DestBounds, &ClipRect);
+			}
+		}
+
+		// Check if rect is fully clipped
+		if (IsRectEmpty(&DestBounds))
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Warning: source rect is fully clipped!");
+			return DD_OK;
+		}
 	}
 
+	// Calls CopyPart with the source and dest rect of each visible part, stops on the first failure
+	auto ForEachPart = [&](auto CopyPart) -> HRESULT {
+		HRESULT hr = DD_OK;
+		for (DWORD x = 0; x < PartCount && SUCCEEDED(hr); x++)
+		{
+			RECT PartDestRect = pPartRects[x];
+			RECT PartSrcRect = IsClipped ? GetClippedSrcRect(PartDestRect) : SrcRect;
+			if (PartSrcRect.left < PartSrcRect.right && PartSrcRect.top < PartSrcRect.bottom)
+			{
+				hr = CopyPart(PartSrcRect, PartDestRect);
+			}
+		}
+		return hr;
+		};
+
+	// Get width and height of the bounding rects
+	LONG SrcRectWidth = SrcBounds.right - SrcBounds.left;
+	LONG SrcRectHeight = SrcBounds.bottom - SrcBounds.top;
+	LONG DestRectWidth = DestBounds.right - DestBounds.left;
+	LONG DestRectHeight = DestBounds.bottom - DestBounds.top;
+
 	// Read surface from GDI
 	if (ShouldReadFromGDI())
 	{
-		CopyEmulatedSurfaceFromGDI(&DestRect);
+		CopyEmulatedSurfaceFromGDI(&DestBounds);
 	}
 
 	// Variables
@@ -7201,71 +7237,75 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 
 			if (Src.GetSurface() && Dest.GetSurface())
 			{
-				hr = (*d3d9Device)->StretchRect(Src.GetSurface(), &SrcRect, Dest.GetSurface(), &DestRect, Filter);
+				hr = ForEachPart([&](RECT& PartSrcRect, RECT& PartDestRect) -> HRESULT {
+					hr = (*d3d9Device)->StretchRect(Src.GetSurface(), &PartSrcRect, Dest.GetSurface(), &PartDestRect, Filter);
 
-				if (hr == D3DERR_INVALIDCALL && Src.GetSurface() == Dest.GetSurface())
-				{
-					if (!tmpVideo.Surface)
+					if (hr == D3DERR_INVALIDCALL && Src.GetSurface() == Dest.GetSurface())
 					{
-						LOG_LIMIT(100, __FUNCTION__ << " Creating tmpVideo surface.");
+						if (!tmpVideo.Surface)
+						{
+							LOG_LIMIT(100, __FUNCTION__ << " Creating tmpVideo surface.");
 
-						D3DSURFACE_DESC Desc = {};
-						Dest.GetSurface()->GetDesc(&Desc);
+							D3DSURFACE_DESC Desc = {};
+							Dest.GetSurface()->GetDesc(&Desc);
 
-						if (surface.Type == D3DTYPE_OFFPLAINSURFACE)
-						{
-							if (FAILED((*d3d9Device)->CreateOffscreenPlainSurface(Desc.Width, Desc.Height, Desc.Format, surface.Pool, &tmpVideo.Surface, nullptr)))
+							if (surface.Type == D3DTYPE_OFFPLAINSURFACE)
 							{
-								LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create offplain tmpVideo.Surface. Size: " << Desc.Width << "x" << Desc.Height << " Format: " << Desc.Format);
+								if (FAILED((*d3d9Device)->CreateOffscreenPlainSurface(Desc.Width, Desc.Height, Desc.Format, surface.Pool, &tmpVideo.Surface, nullptr)))
+								{
+									LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create offplain tmpVideo.Surface. Size: " << Desc.Width << "x" << Desc.Height << " Format: " << Desc.Format);
+								}
 							}
-						}
-						else if (surface.Type == D3DTYPE_RENDERTARGET)
-						{
-							if (FAILED((*d3d9Device)->CreateRenderTarget(Desc.Width, Desc.Height, Desc.Format, D3DMULTISAMPLE_NONE, 0, FALSE, &tmpVideo.Surface, nullptr)))
-							{
-								LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create render target tmpVideo.Surface. Size: " << Desc.Width << "x" << Desc.Height << " Format: " << Desc.Format);
-							}
-						}
-						else if (surface.Type == D3DTYPE_TEXTURE)
-						{
-							if (!tmpVideo.Texture && FAILED((*d3d9Device)->CreateTexture(Desc.Width, Desc.Height, 1, surface.Usage, Desc.Format, surface.Pool, &tmpVideo.Texture, nullptr)))
+							else if (surface.Type == D3DTYPE_RENDERTARGET)
 							{
-								LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create texture tmpVideo.Texture. Size: " << Desc.Width << "x" << Desc.Height << " Format: " << Desc.Format);
+								if (FAILED((*d3d9Device)->CreateRenderTarget(Desc.Width, Desc.Height, Desc.Format, D3DMULTISAMPLE_NONE, 0, FALSE, &tmpVideo.Surface, nullptr)))
+								{
+									LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create render target tmpVideo.Surface. Size: " << Desc.Width << "x" << Desc.Height << " Format: " << Desc.Format);
+								}
 							}
-							if (tmpVideo.Texture && FAILED(tmpVideo.Texture->GetSurfaceLevel(0, &tmpVideo.Surface)))
+							else if (surface.Type == D3DTYPE_TEXTURE)
 							{
-								LOG_LIMIT(100, __FUNCTION__ << " Error: failed to get surface level for tmpVideo.Texture. Size: " << Desc.Width << "x" << Desc.Height << " Format: " << Desc.Format);
+								if (!tmpVideo.Texture && FAILED((*d3d9Device)->CreateTexture(Desc.Width, Desc.Height, 1, surface.Usage, Desc.Format, surface.Pool, &tmpVideo.Texture, nullptr)))
+								{
+									LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create texture tmpVideo.Texture. Size: " << Desc.Width << "x" << Desc.Height << " Format: " << Desc.Format);
+								}
+								if (tmpVideo.Texture && FAILED(tmpVideo.Texture->GetSurfaceLevel(0, &tmpVideo.Surface)))
+								{
+									LOG_LIMIT(100, __FUNCTION__ << " Error: failed to get surface level for tmpVideo.Texture. Size: " << Desc.Width << "x" << Desc.Height << " Format: " << Desc.Format);
+								}
 							}
 						}
-					}
-
-					if (tmpVideo.Surface)
-					{
-						hr = (*d3d9Device)->StretchRect(Src.GetSurface(), &SrcRect, tmpVideo.Surface, &DestRect, Filter);
 
-						if (FAILED(hr))
+						if (tmpVideo.Surface)
 						{
-							LOG_LIMIT(100, __FUNCTION__ << " Error: failed to StretchRect to tmpVideo.Surface!");
-						}
-
-						if (SUCCEEDED(hr))
-						{
-							hr = (*d3d9Device)->StretchRect(tmpVideo.Surface, &DestRect, Dest.GetSurface(), &DestRect, D3DTEXF_NONE);
+							hr = (*d3d9Device)->StretchRect(Src.GetSurface(), &PartSrcRect, tmpVideo.Surface, &PartDestRect, Filter);
 
 							if (FAILED(hr))
 							{
-								LOG_LIMIT(100, __FUNCTION__ << " Error: failed to StretchRect from tmpVideo.Surface!");
+								LOG_LIMIT(100, __FUNCTION__ << " Error: failed to StretchRect to tmpVideo.Surface!");
+							}
+
+							if (SUCCEEDED(hr))
+							{
+								hr = (*d3d9Device)->StretchRect(tmpVideo.Surface, &PartDestRect, Dest.GetSurface(), &PartDestRect, D3DTEXF_NONE);
+
+								if (FAILED(hr))
+								{
+									LOG_LIMIT(100, __FUNCTION__ << " Error: failed to StretchRect from tmpVideo.Surface!");
+								}
 							}
 						}
 					}
-				}
 
-				if (FAILED(hr))
-				{
-					LOG_LIMIT(100, __FUNCTION__ << " Error: could not copy rect: " << SrcDesc2.ddsCaps << " -> " << DestDesc2.ddsCaps << " " <<
-						SrcFormat << " -> " << DestFormat << " " << SrcRect << " -> " << DestRect << " " << IsStretchRect << " " <<
-						Src.GetSurface() << " -> " << Dest.GetSurface() << " " << (D3DERR)hr);
-				}
+					if (FAILED(hr))
+					{
+						LOG_LIMIT(100, __FUNCTION__ << " Error: could not copy rect: " << SrcDesc2.ddsCaps << " -> " << DestDesc2.ddsCaps << " " <<
+							SrcFormat << " -> " << DestFormat << " " << PartSrcRect << " -> " << PartDestRect << " " << IsStretchRect << " " <<
+							Src.GetSurface() << " -> " << Dest.GetSurface() << " " << (D3DERR)hr);
+					}
+
+					return hr;
+					});
 			}
 
 			if (SUCCEEDED(hr))
@@ -7290,50 +7330,55 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 
 			if (Src.GetSurface() && Dest.GetSurface())
 			{
-				if (pSourceSurface->surface.Pool == D3DPOOL_SYSTEMMEM || pSourceSurface->IsUsingShadowSurface())
-				{
-					hr = (*d3d9Device)->UpdateSurface(Src.GetSurface(), &SrcRect, Dest.GetSurface(), (LPPOINT)&DestRect);
-				}
-				else
-				{
-					do {
-						D3DLOCKED_RECT SrcLockedRect = {};
-						if (FAILED(Src.GetSurface()->LockRect(&SrcLockedRect, &SrcRect, D3DLOCK_READONLY)))
-						{
-							LOG_LIMIT(100, __FUNCTION__ << " Error: failed to lock source surface for update!");
-							break;
-						}
-						D3DLOCKED_RECT DestLockedRect = {};
-						if (FAILED(surface.Shadow->LockRect(&DestLockedRect, &DestRect, 0)))
-						{
-							LOG_LIMIT(100, __FUNCTION__ << " Error: failed to lock shadow surface for update!");
-							Src.GetSurface()->UnlockRect();
-							break;
-						}
+				hr = ForEachPart([&](RECT& PartSrcRect, RECT& PartDestRect) -> HRESULT {
+					if (pSourceSurface->surface.Pool == D3DPOOL_SYSTEMMEM || pSourceSurface->IsUsingShadowSurface())
+					{
+						hr = (*d3d9Device)->UpdateSurface(Src.GetSurface(), &PartSrcRect, Dest.GetSurface(), (LPPOINT)&PartDestRect);
+					}
+					else
+					{
+						hr = DDERR_GENERIC;
+						do {
+							D3DLOCKED_RECT SrcLockedRect = {};
+							if (FAILED(Src.GetSurface()->LockRect(&SrcLockedRect, &PartSrcRect, D3DLOCK_READONLY)))
+							{
+								LOG_LIMIT(100, __FUNCTION__ << " Error: failed to lock source surface for update!");
+								break;
+							}
+							D3DLOCKED_RECT DestLockedRect = {};
+							if (FAILED(surface.Shadow->LockRect(&DestLockedRect, &PartDestRect, 0)))
+							{
+								LOG_LIMIT(100, __FUNCTION__ << " Error: failed to lock shadow surface for update!");
+								Src.GetSurface()->UnlockRect();
+								break;
+							}
 
-						BYTE* SrcBytes = (BYTE*)SrcLockedRect.pBits;
-						BYTE* DestBytes = (BYTE*)DestLockedRect.pBits;
-						size_t Size = DestRectWidth * surface.BitCount / 8;
-						for (int x = 0; x < DestRectHeight; x++)
-						{
-							memcpy(DestBytes, SrcBytes, Size);
-							SrcBytes += SrcLockedRect.Pitch;
-							DestBytes += DestLockedRect.Pitch;
-						}
+							BYTE* SrcBytes = (BYTE*)SrcLockedRect.pBits;
+							BYTE* DestBytes = (BYTE*)DestLockedRect.pBits;
+							size_t Size = (PartDestRect.right - PartDestRect.left) * surface.BitCount / 8;
+							for (int x = 0; x < (PartDestRect.bottom - PartDestRect.top); x++)
+							{
+								memcpy(DestBytes, SrcBytes, Size);
+								SrcBytes += SrcLockedRect.Pitch;
+								DestBytes += DestLockedRect.Pitch;
+							}
 
-						surface.Shadow->UnlockRect();
-						Src.GetSurface()->UnlockRect();
+							surface.Shadow->UnlockRect();
+							Src.GetSurface()->UnlockRect();
 
-						hr = (*d3d9Device)->UpdateSurface(surface.Shadow, &DestRect, Dest.GetSurface(), (LPPOINT)&DestRect);
+							hr = (*d3d9Device)->UpdateSurface(surface.Shadow, &PartDestRect, Dest.GetSurface(), (LPPOINT)&PartDestRect);
 
-					} while (false);
-				}
+						} while (false);
+					}
 
-				if (FAILED(hr))
-				{
-					LOG_LIMIT(100, __FUNCTION__ << " Error: could not update surface: " << SrcDesc2.ddsCaps << " -> " << DestDesc2.ddsCaps << " " <<
-						SrcFormat << " -> " << DestFormat << " " << SrcRect << " -> " << DestRect << " " << IsStretchRect << " " << (D3DERR)hr);
-				}
+					if (FAILED(hr))
+					{
+						LOG_LIMIT(100, __FUNCTION__ << " Error: could not update surface: " << SrcDesc2.ddsCaps << " -> " << DestDesc2.ddsCaps << " " <<
+							SrcFormat << " -> " << DestFormat << " " << PartSrcRect << " -> " << PartDestRect << " " << IsStretchRect << " " << (D3DERR)hr);
+					}
+
+					return hr;
+					});
 			}
 
 			if (SUCCEEDED(hr))
@@ -7380,12 +7425,16 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 
 			if (Src.GetSurface() && Dest.GetSurface())
 			{
-				hr = D3DXLoadSurfaceFromSurface(Dest.GetSurface(), nullptr, &DestRect, Src.GetSurface(), nullptr, &SrcRect, D3DXFilter, 0);
+				hr = ForEachPart([&](RECT& PartSrcRect, RECT& PartDestRect) -> HRESULT {
+					hr = D3DXLoadSurfaceFromSurface(Dest.GetSurface(), nullptr, &PartDestRect, Src.GetSurface(), nullptr, &PartSrcRect, D3DXFilter, 0);
 
-				if (FAILED(hr))
-				{
-					LOG_LIMIT(100, __FUNCTION__ << " Error: could not decode source texture. " << (D3DERR)hr << " " << SrcFormat << "->" << DestFormat);
-				}
+					if (FAILED(hr))
+					{
+						LOG_LIMIT(100, __FUNCTION__ << " Error: could not decode source texture. " << (D3DERR)hr << " " << SrcFormat << "->" << DestFormat);
+					}
+
+					return hr;
+					});
 			}
 			else
 			{
@@ -7405,8 +7454,8 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 		{
 			LONG DestLeft = DestRect.left;
 			LONG DestTop = DestRect.top;
-			LONG DestWidth = DestRectWidth;
-			LONG DestHeight = DestRectHeight;
+			LONG DestWidth = DestRect.right - DestRect.left;
+			LONG DestHeight = DestRect.bottom - DestRect.top;
 
 			if (IsMirrorLeftRight)
 			{
@@ -7434,11 +7483,39 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 				SetBrushOrgEx(surface.emu->DC, org.x, org.y, nullptr);
 			}
 
-			if ((IsStretchRect || IsMirrorLeftRight || IsMirrorUpDown) ?
+			// Clipped copies are done as one blit through a clip region made of the visible parts
+			HRGN hOldRgn = nullptr;
+			bool HasOldRgn = false;
+			if (IsClipped)
+			{
+				hOldRgn = CreateRectRgn(0, 0, 0, 0);
+				HasOldRgn = (GetClipRgn(surface.emu->DC, hOldRgn) == 1);
+
+				HRGN hClipRgn = CreateRectRgnIndirect(&ClipRects[0]);
+				for (DWORD x = 1; x < PartCount; x++)
+				{
+					HRGN hTmp = CreateRectRgnIndirect(&ClipRects[x]);
+					CombineRgn(hClipRgn, hClipRgn, hTmp, RGN_OR);
+					DeleteObject(hTmp);
+				}
+				SelectClipRgn(surface.emu->DC, hClipRgn);
+				DeleteObject(hClipRgn);
+			}
+
+			const BOOL IsCopied = (IsStretchRect || IsMirrorLeftRight || IsMirrorUpDown) ?
 				StretchBlt(surface.emu->DC, DestLeft, DestTop, DestWidth, DestHeight,
 					pSourceSurface->surface.emu->DC, SrcRect.left, SrcRect.top, SrcRect.right - SrcRect.left, SrcRect.bottom - SrcRect.top, SRCCOPY) :
-				BitBlt(surface.emu->DC, DestRect.left, DestRect.top, DestRectWidth, DestRectHeight,
-					pSourceSurface->surface.emu->DC, SrcRect.left, SrcRect.top, SRCCOPY))
+				BitBlt(surface.emu->DC, DestRect.left, DestRect.top, DestRect.right - DestRect.left, DestRect.bottom - DestRect.top,
+					pSourceSurface->surface.emu->DC, SrcRect.left, SrcRect.top, SRCCOPY);
+
+			// Restore the clip region of the DC
+			if (IsClipped)
+			{
+				SelectClipRgn(surface.emu->DC, HasOldRgn ? hOldRgn : nullptr);
+				DeleteObject(hOldRgn);
+			}
+
+			if (IsCopied)
 			{
 				hr = DD_OK;
 				break;
@@ -7449,19 +7526,24 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 		if (!IsUsingEmulation() && !IsColorKey && !IsMirrorLeftRight && !IsMirrorUpDown &&
 			pSourceSurface->surface.Type == surface.Type &&	// D3DXLoadSurfaceFromSurface is very slow when copying from offplain to texture
 			!surface.UsingSurfaceMemory && !pSourceSurface->surface.UsingSurfaceMemory &&
-			(pSourceSurface->IsPalette() == IsPalette()))
+			(pSourceSurface->IsPalette() == IsPalette()) &&
+			!(IsClipped && IsSameSurface && IsStretchRect))	// Parts of a clipped stretch could read pixels written by another part
 		{
 			ScopedGetMipMapContext Src(pSourceSurface, SrcMipMapLevel);
 			ScopedGetMipMapContext Dest(this, MipMapLevel);
 
 			if (Src.GetSurface() && Dest.GetSurface())
 			{
-				hr = D3DXLoadSurfaceFromSurface(Dest.GetSurface(), nullptr, &DestRect, Src.GetSurface(), nullptr, &SrcRect, D3DXFilter, 0);
+				hr = ForEachPart([&](RECT& PartSrcRect, RECT& PartDestRect) -> HRESULT {
+					hr = D3DXLoadSurfaceFromSurface(Dest.GetSurface(), nullptr, &PartDestRect, Src.GetSurface(), nullptr, &PartSrcRect, D3DXFilter, 0);
 
-				if (FAILED(hr))
-				{
-					LOG_LIMIT(100, __FUNCTION__ << " Error: failed to load surface from surface. " << (D3DERR)hr);
-				}
+					if (FAILED(hr))
+					{
+						LOG_LIMIT(100, __FUNCTION__ << " Error: failed to load surface from surface. " << (D3DERR)hr);
+					}
+
+					return hr;
+					});
 			}
 
 			if (SUCCEEDED(hr))
@@ -7496,17 +7578,20 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 
 		// Check if source surface is not locked then lock it
 		D3DLOCKED_RECT SrcLockRect = {};
-		if (FAILED(pSourceSurface->IsUsingEmulation() ? pSourceSurface->LockEmulatedSurface(&SrcLockRect, &SrcRect) :
-			pSourceSurface->LockD3d9Surface(&SrcLockRect, &SrcRect, D3DLOCK_READONLY, SrcMipMapLevel)) || !SrcLockRect.pBits)
+		if (!IsSameSurface)
 		{
-			LOG_LIMIT(100, __FUNCTION__ << " Error: could not lock source surface " << SrcRect);
-			hr = (pSourceSurface->IsSurfaceBusy(MipMapLevel)) ? DDERR_SURFACEBUSY : DDERR_GENERIC;
-			break;
+			if (FAILED(pSourceSurface->IsUsingEmulation() ? pSourceSurface->LockEmulatedSurface(&SrcLockRect, &SrcBounds) :
+				pSourceSurface->LockD3d9Surface(&SrcLockRect, &SrcBounds, D3DLOCK_READONLY, SrcMipMapLevel)) || !SrcLockRect.pBits)
+			{
+				LOG_LIMIT(100, __FUNCTION__ << " Error: could not lock source surface " << SrcBounds);
+				hr = (pSourceSurface->IsSurfaceBusy(MipMapLevel)) ? DDERR_SURFACEBUSY : DDERR_GENERIC;
+				break;
+			}
+			UnlockSrc = true;
 		}
-		UnlockSrc = true;
 
-		// Use seperate memory cache if source and destination formats mismatch or are on the same surface
-		if ((pSourceSurface == this && MipMapLevel == SrcMipMapLevel) || FormatMismatch)
+		// Use seperate memory cache if source and destination formats mismatch
+		if (FormatMismatch && !IsSameSurface)
 		{
 			size_t size = SrcRectWidth * ByteCount * SrcRectHeight;
 			if (size > ByteArray.size())
@@ -7518,15 +7603,7 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 			INT DestPitch = SrcRectWidth * ByteCount;
 			if (FormatR5G6B5toX8R8G8B8)
 			{
-				for (LONG y = 0; y < SrcRectHeight; y++)
-				{
-					for (LONG x = 0; x < SrcRectWidth; x++)
-					{
-						((DWORD*)DestBuffer)[x] = D3DFMT_R5G6B5_TO_X8R8G8B8(((WORD*)SrcBuffer)[x]);
-					}
-					SrcBuffer += SrcLockRect.Pitch;
-					DestBuffer += DestPitch;
-				}
+				ConvertPixelRect(DestBuffer, DestPitch, D3DFMT_X8R8G8B8, SrcBuffer, SrcLockRect.Pitch, D3DFMT_R5G6B5, SrcRectWidth, SrcRectHeight);
 				ColorKey = D3DFMT_R5G6B5_TO_X8R8G8B8(ColorKey);
 			}
 			else
@@ -7547,87 +7624,206 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 			}
 		}
 
-		// Check if destination surface is not locked then lock it
-		if (FAILED(IsUsingEmulation() ? LockEmulatedSurface(&DestLockRect, &DestRect) :
-			LockD3d9Surface(&DestLockRect, &DestRect, 0, MipMapLevel)) || !DestLockRect.pBits)
+		// Check if destination surface is not locked then lock it, copies within the same surface use a single lock for both
+		RECT LockRect = DestBounds;
+		if (IsSameSurface)
 		{
-			LOG_LIMIT(100, __FUNCTION__ << " Error: could not lock destination surface " << DestRect);
+			UnionRect(&LockRect, &SrcBounds, &DestBounds);
+		}
+		if (FAILED(IsUsingEmulation() ? LockEmulatedSurface(&DestLockRect, &LockRect) :
+			LockD3d9Surface(&DestLockRect, &LockRect, 0, MipMapLevel)) || !DestLockRect.pBits)
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: could not lock destination surface " << LockRect);
 			hr = (IsSurfaceLocked(MipMapLevel)) ? DDERR_SURFACEBUSY : DDERR_GENERIC;
 			break;
 		}
 		UnlockDest = true;
 
-		// Create buffer variables
-		BYTE* SrcBuffer = (BYTE*)SrcLockRect.pBits;
-		BYTE* DestBuffer = (BYTE*)DestLockRect.pBits;
-
-		// For mirror copy up/down
-		INT DestPitch = DestLockRect.Pitch;
-		if (IsMirrorUpDown)
+		// Get source and destination from the combined lock
+		if (IsSameSurface)
 		{
-			DestPitch = -DestLockRect.Pitch;
-			DestBuffer += DestLockRect.Pitch * (DestRectHeight - 1);
+			SrcLockRect.Pitch = DestLockRect.Pitch;
+			SrcLockRect.pBits = (BYTE*)DestLockRect.pBits + (SrcBounds.top - LockRect.top) * DestLockRect.Pitch + (SrcBounds.left - LockRect.left) * ByteCount;
+			DestLockRect.pBits = (BYTE*)DestLockRect.pBits + (DestBounds.top - LockRect.top) * DestLockRect.Pitch + (DestBounds.left - LockRect.left) * ByteCount;
 		}
 
-		// Simple memory copy (QuickCopy)
-		if (!IsStretchRect && !IsColorKey && !IsMirrorLeftRight)
+		// Check if the source and destination rects overlap
+		RECT OverlapRect = {};
+		bool IsOverlapping = IsSameSurface && IntersectRect(&OverlapRect, &SrcBounds, &DestBounds);
+
+		// Clipped overlapping copy, copy the source region first so no part reads pixels already written by another part
+		if (IsOverlapping && IsClipped)
 		{
-			if (!IsMirrorUpDown && SrcLockRect.Pitch == DestLockRect.Pitch && (DWORD)DestRectWidth == DestDesc2.dwWidth)
+			const INT StagePitch = SrcRectWidth * ByteCount;
+			size_t size = StagePitch * SrcRectHeight;
+			if (size > ByteArray.size())
 			{
-				memcpy(DestBuffer, SrcBuffer, DestRectHeight * DestPitch);
+				ByteArray.resize(size);
 			}
-			else
+			BYTE* SrcBuffer = (BYTE*)SrcLockRect.pBits;
+			BYTE* DestBuffer = (BYTE*)ByteArray.data();
+			for (LONG y = 0; y < SrcRectHeight; y++)
 			{
-				for (LONG y = 0; y < DestRectHeight; y++)
-				{
-					memcpy(DestBuffer, SrcBuffer, DestRectWidth * ByteCount);
-					SrcBuffer += SrcLockRect.Pitch;
-					DestBuffer += DestPitch;
-				}
+				memcpy(DestBuffer, SrcBuffer, StagePitch);
+				SrcBuffer += SrcLockRect.Pitch;
+				DestBuffer += StagePitch;
 			}
-			hr = DD_OK;
-			break;
+			SrcLockRect.pBits = ByteArray.data();
+			SrcLockRect.Pitch = StagePitch;
+			IsOverlapping = false;
 		}
 
-		// Simple copy with ColorKey and Mirroring
-		if (!IsStretchRect)
+		// Unscaled overlapping copy, pick copy direction the same way as memmove
+		if (IsOverlapping && !IsStretchRect && !IsMirrorUpDown)
 		{
+			const size_t RowSize = DestRectWidth * ByteCount;
+			if (RowSize > ByteArray.size())
+			{
+				ByteArray.resize(RowSize);
+			}
+			BYTE* SrcBuffer = (BYTE*)SrcLockRect.pBits;
+			BYTE* DestBuffer = (BYTE*)DestLockRect.pBits;
+			const LONG OffsetY = DestRect.top - SrcRect.top;
 			switch (ByteCount)
 			{
 			case 1:
-				SimpleColorKeyCopy<BYTE>((BYTE)ColorKey, SrcBuffer, DestBuffer, SrcLockRect.Pitch, DestPitch, DestRectWidth, DestRectHeight, IsColorKey, IsMirrorLeftRight);
+				OverlapCopy<BYTE>((BYTE)ColorKey, SrcBuffer, DestBuffer, DestLockRect.Pitch, DestRectWidth, DestRectHeight, OffsetY, ByteArray.data(), IsColorKey, IsMirrorLeftRight);
 				break;
 			case 2:
-				SimpleColorKeyCopy<WORD>((WORD)ColorKey, SrcBuffer, DestBuffer, SrcLockRect.Pitch, DestPitch, DestRectWidth, DestRectHeight, IsColorKey, IsMirrorLeftRight);
+				OverlapCopy<WORD>((WORD)ColorKey, SrcBuffer, DestBuffer, DestLockRect.Pitch, DestRectWidth, DestRectHeight, OffsetY, ByteArray.data(), IsColorKey, IsMirrorLeftRight);
 				break;
 			case 3:
-				SimpleColorKeyCopy<TRIBYTE>((TRIBYTE)ColorKey, SrcBuffer, DestBuffer, SrcLockRect.Pitch, DestPitch, DestRectWidth, DestRectHeight, IsColorKey, IsMirrorLeftRight);
+				OverlapCopy<TRIBYTE>((TRIBYTE)ColorKey, SrcBuffer, DestBuffer, DestLockRect.Pitch, DestRectWidth, DestRectHeight, OffsetY, ByteArray.data(), IsColorKey, IsMirrorLeftRight);
 				break;
 			case 4:
-				SimpleColorKeyCopy<DWORD>((DWORD)ColorKey, SrcBuffer, DestBuffer, SrcLockRect.Pitch, DestPitch, DestRectWidth, DestRectHeight, IsColorKey, IsMirrorLeftRight);
+				OverlapCopy<DWORD>((DWORD)ColorKey, SrcBuffer, DestBuffer, DestLockRect.Pitch, DestRectWidth, DestRectHeight, OffsetY, ByteArray.data(), IsColorKey, IsMirrorLeftRight);
 				break;
 			}
 			hr = DD_OK;
 			break;
 		}
 
-		// Copy memory (complex)
-		switch (ByteCount)
+		// Scaled or mirrored overlapping copy, stage only the source rows that the destination rect covers
+		D3DLOCKED_RECT BandLockRect = {};
+		LONG BandTop = 0;
+		LONG BandHeight = 0;
+		if (IsOverlapping)
 		{
-		case 1:
-			ComplexCopy<BYTE>((BYTE)ColorKey, SrcLockRect, DestLockRect, SrcRectWidth, SrcRectHeight, DestRectWidth, DestRectHeight, IsColorKey, IsMirrorUpDown, IsMirrorLeftRight);
-			break;
-		case 2:
-			ComplexCopy<WORD>((WORD)ColorKey, SrcLockRect, DestLockRect, SrcRectWidth, SrcRectHeight, DestRectWidth, DestRectHeight, IsColorKey, IsMirrorUpDown, IsMirrorLeftRight);
-			break;
-		case 3:
-			ComplexCopy<TRIBYTE>((TRIBYTE)ColorKey, SrcLockRect, DestLockRect, SrcRectWidth, SrcRectHeight, DestRectWidth, DestRectHeight, IsColorKey, IsMirrorUpDown, IsMirrorLeftRight);
-			break;
-		case 4:
-			ComplexCopy<DWORD>((DWORD)ColorKey, SrcLockRect, DestLockRect, SrcRectWidth, SrcRectHeight, DestRectWidth, DestRectHeight, IsColorKey, IsMirrorUpDown, IsMirrorLeftRight);
-			break;
+			BandTop = max(SrcRect.top, DestRect.top) - SrcRect.top;
+			BandHeight = min(SrcRect.bottom, DestRect.bottom) - SrcRect.top - BandTop;
+			BandLockRect.Pitch = SrcRectWidth * ByteCount;
+			size_t size = BandLockRect.Pitch * BandHeight;
+			if (size > ByteArray.size())
+			{
+				ByteArray.resize(size);
+			}
+			BandLockRect.pBits = ByteArray.data();
+			BYTE* SrcBuffer = (BYTE*)SrcLockRect.pBits + SrcLockRect.Pitch * BandTop;
+			BYTE* DestBuffer = (BYTE*)BandLockRect.pBits;
+			for (LONG y = 0; y < BandHeight; y++)
+			{
+				memcpy(DestBuffer, SrcBuffer, BandLockRect.Pitch);
+				SrcBuffer += SrcLockRect.Pitch;
+				DestBuffer += BandLockRect.Pitch;
+			}
 		}
-		hr = DD_OK;
+
+		// Column table and row buffer for stretched copies, sized for the widest part
+		if (IsStretchRect || IsOverlapping)
+		{
+			const size_t ScratchSize = GetComplexCopyScratchSize(DestRectWidth, ByteCount);
+			if (ScratchSize > StretchArray.size())
+			{
+				StretchArray.resize(ScratchSize);
+			}
+		}
+
+		// Copy each part from the locked rects
+		hr = ForEachPart([&](RECT& PartSrcRect, RECT& PartDestRect) -> HRESULT {
+			const LONG PartSrcWidth = PartSrcRect.right - PartSrcRect.left;
+			const LONG PartSrcHeight = PartSrcRect.bottom - PartSrcRect.top;
+			const LONG PartDestWidth = PartDestRect.right - PartDestRect.left;
+			const LONG PartDestHeight = PartDestRect.bottom - PartDestRect.top;
+
+			// Get the part from the locked bounding rects
+			D3DLOCKED_RECT PartSrcLockRect = { SrcLockRect.Pitch,
+				(BYTE*)SrcLockRect.pBits + (PartSrcRect.top - SrcBounds.top) * SrcLockRect.Pitch + (PartSrcRect.left - SrcBounds.left) * ByteCount };
+			D3DLOCKED_RECT PartDestLockRect = { DestLockRect.Pitch,
+				(BYTE*)DestLockRect.pBits + (PartDestRect.top - DestBounds.top) * DestLockRect.Pitch + (PartDestRect.left - DestBounds.left) * ByteCount };
+
+			// Create buffer variables
+			BYTE* SrcBuffer = (BYTE*)PartSrcLockRect.pBits;
+			BYTE* DestBuffer = (BYTE*)PartDestLockRect.pBits;
+
+			// For mirror copy up/down
+			INT DestPitch = DestLockRect.Pitch;
+			if (IsMirrorUpDown)
+			{
+				DestPitch = -DestLockRect.Pitch;
+				DestBuffer += DestLockRect.Pitch * (PartDestHeight - 1);
+			}
+
+			// Simple memory copy (QuickCopy)
+			if (!IsStretchRect && !IsColorKey && !IsMirrorLeftRight && !IsOverlapping)
+			{
+				if (!IsMirrorUpDown && SrcLockRect.Pitch == DestLockRect.Pitch && (DWORD)PartDestWidth == DestDesc2.dwWidth)
+				{
+					memcpy(DestBuffer, SrcBuffer, PartDestHeight * DestPitch);
+				}
+				else
+				{
+					for (LONG y = 0; y < PartDestHeight; y++)
+					{
+						memcpy(DestBuffer, SrcBuffer, PartDestWidth * ByteCount);
+						SrcBuffer += SrcLockRect.Pitch;
+						DestBuffer += DestPitch;
+					}
+				}
+				return DD_OK;
+			}
+
+			// Simple copy with ColorKey and Mirroring
+			if (!IsStretchRect && !IsOverlapping)
+			{
+				switch (ByteCount)
+				{
+				case 1:
+					SimpleColorKeyCopy<BYTE>((BYTE)ColorKey, SrcBuffer, DestBuffer, SrcLockRect.Pitch, DestPitch, PartDestWidth, PartDestHeight, IsColorKey, IsMirrorLeftRight);
+					break;
+				case 2:
+					SimpleColorKeyCopy<WORD>((WORD)ColorKey, SrcBuffer, DestBuffer, SrcLockRect.Pitch, DestPitch, PartDestWidth, PartDestHeight, IsColorKey, IsMirrorLeftRight);
+					break;
+				case 3:
+					SimpleColorKeyCopy<TRIBYTE>((TRIBYTE)ColorKey, SrcBuffer, DestBuffer, SrcLockRect.Pitch, DestPitch, PartDestWidth, PartDestHeight, IsColorKey, IsMirrorLeftRight);
+					break;
+				case 4:
+					SimpleColorKeyCopy<DWORD>((DWORD)ColorKey, SrcBuffer, DestBuffer, SrcLockRect.Pitch, DestPitch, PartDestWidth, PartDestHeight, IsColorKey, IsMirrorLeftRight);
+					break;
+				}
+				return DD_OK;
+			}
+
+			// Copy memory (complex), the parts of a clipped stretch are stepped from the origin of the whole stretch
+			const STRETCHPART StretchPart = { SrcRect.right - SrcRect.left, SrcRect.bottom - SrcRect.top, DestRect.right - DestRect.left, DestRect.bottom - DestRect.top,
+				PartDestRect.left - DestRect.left, PartDestRect.top - DestRect.top };
+			const STRETCHPART* pStretchPart = IsClipped ? &StretchPart : nullptr;
+			switch (ByteCount)
+			{
+			case 1:
+				ComplexCopy<BYTE>((BYTE)ColorKey, PartSrcLockRect, PartDestLockRect, PartSrcWidth, PartSrcHeight, PartDestWidth, PartDestHeight, StretchArray.data(), IsColorKey, IsMirrorUpDown, IsMirrorLeftRight, BandLockRect, BandTop, BandHeight, pStretchPart);
+				break;
+			case 2:
+				ComplexCopy<WORD>((WORD)ColorKey, PartSrcLockRect, PartDestLockRect, PartSrcWidth, PartSrcHeight, PartDestWidth, PartDestHeight, StretchArray.data(), IsColorKey, IsMirrorUpDown, IsMirrorLeftRight, BandLockRect, BandTop, BandHeight, pStretchPart);
+				break;
+			case 3:
+				ComplexCopy<TRIBYTE>((TRIBYTE)ColorKey, PartSrcLockRect, PartDestLockRect, PartSrcWidth, PartSrcHeight, PartDestWidth, PartDestHeight, StretchArray.data(), IsColorKey, IsMirrorUpDown, IsMirrorLeftRight, BandLockRect, BandTop, BandHeight, pStretchPart);
+				break;
+			case 4:
+				ComplexCopy<DWORD>((DWORD)ColorKey, PartSrcLockRect, PartDestLockRect, PartSrcWidth, PartSrcHeight, PartDestWidth, PartDestHeight, StretchArray.data(), IsColorKey, IsMirrorUpDown, IsMirrorLeftRight, BandLockRect, BandTop, BandHeight, pStretchPart);
+				break;
+			}
+			return DD_OK;
+			});
 		break;
 
 	} while (false);
@@ -7638,10 +7834,10 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 		// Set last rect before removing scanlines
 		LASTLOCK LLock;
 		EmuScanLine.ScanlineWidth = DestRectWidth;
-		LLock.Rect = DestRect;
+		LLock.Rect = DestBounds;
 		if (IsUsingEmulation())
 		{
-			LockEmulatedSurface(&LLock.LockedRect, &DestRect);
+			LockEmulatedSurface(&LLock.LockedRect, &DestBounds);
 			RemoveScanlines(LLock);
 		}
 		else if (UnlockDest)
@@ -8066,7 +8262,9 @@ HRESULT m_IDirectDrawSurfaceX::LoadSurfaceFromMemory(LPDIRECT3DSURFACE9 pDestSur
 	const UINT SrcBitCount = GetBitCount(SrcFormat);
 	const UINT DestBitCount = GetBitCount(Desc.Format);
 
-	if (SrcBitCount == DestBitCount && !(Desc.Usage & D3DUSAGE_RENDERTARGET) && (SrcFormat == Desc.Format || GetFailoverFormat(SrcFormat) == Desc.Format))
+	const bool IsSameFormat = (SrcBitCount == DestBitCount && (SrcFormat == Desc.Format || GetFailoverFormat(SrcFormat) == Desc.Format));
+
+	if (!(Desc.Usage & D3DUSAGE_RENDERTARGET) && (IsSameFormat || IsPixelConversionSupported(SrcFormat, Desc.Format)))
 	{
 		// Lock destination surface
 		D3DLOCKED_RECT LockedRect = {};
@@ -8077,7 +8275,8 @@ HRESULT m_IDirectDrawSurfaceX::LoadSurfaceFromMemory(LPDIRECT3DSURFACE9 pDestSur
 		}
 
 		// Calculate bytes per pixel
-		const LONG BytesPerPixel = SrcBitCount / 8;
+		const LONG SrcBytesPerPixel = SrcBitCount / 8;
+		const LONG DestBytesPerPixel = DestBitCount / 8;
 
 		// Validate rectangle dimensions
 		if (Rect.left < 0 || Rect.top < 0 ||
@@ -8089,8 +8288,8 @@ HRESULT m_IDirectDrawSurfaceX::LoadSurfaceFromMemory(LPDIRECT3DSURFACE9 pDestSur
 		}
 
 		// Calculate source and destination buffers
-		const BYTE* SrcBuffer = (const BYTE*)pSrcMemory + (SrcPitch * Rect.top) + (BytesPerPixel * Rect.left);
-		BYTE* DestBuffer = (BYTE*)LockedRect.pBits + (LockedRect.Pitch * Rect.top) + (BytesPerPixel * Rect.left);
+		const BYTE* SrcBuffer = (const BYTE*)pSrcMemory + (SrcPitch * Rect.top) + (SrcBytesPerPixel * Rect.left);
+		BYTE* DestBuffer = (BYTE*)LockedRect.pBits + (LockedRect.Pitch * Rect.top) + (DestBytesPerPixel * Rect.left);
 
 		// Check dest buffer
 		if (!DestBuffer || !SrcBuffer)
@@ -8100,18 +8299,28 @@ HRESULT m_IDirectDrawSurfaceX::LoadSurfaceFromMemory(LPDIRECT3DSURFACE9 pDestSur
 			return DDERR_GENERIC;
 		}
 
-		// Calculate copy pitch and height
-		const LONG CopyPitch = (Rect.right - Rect.left) == (LONG)Desc.Width
-			? min(LockedRect.Pitch, (INT)SrcPitch)
-			: (Rect.right - Rect.left) * BytesPerPixel;
+		const LONG CopyWidth = Rect.right - Rect.left;
 		const LONG CopyHeight = Rect.bottom - Rect.top;
 
-		// Copy surface data row by row
-		for (LONG row = 0; row < CopyHeight; ++row)
+		if (IsSameFormat)
+		{
+			// Calculate copy pitch
+			const LONG CopyPitch = CopyWidth == (LONG)Desc.Width
+				? min(LockedRect.Pitch, (INT)SrcPitch)
+				: CopyWidth * SrcBytesPerPixel;
+
+			// Copy surface data row by row
+			for (LONG row = 0; row < CopyHeight; ++row)
+			{
+				memcpy(DestBuffer, SrcBuffer, CopyPitch);
+				SrcBuffer += SrcPitch;
+				DestBuffer += LockedRect.Pitch;
+			}
+		}
+		else
 		{
-			memcpy(DestBuffer, SrcBuffer, CopyPitch);
-			SrcBuffer += SrcPitch;
-			DestBuffer += LockedRect.Pitch;
+			// Convert surface data using the pixel converter table
+			ConvertPixelRect(DestBuffer, LockedRect.Pitch, Desc.Format, SrcBuffer, SrcPitch, SrcFormat, CopyWidth, CopyHeight);
 		}
 
 		// Unlock destination surface
@@ -8163,10 +8372,11 @@ HRESULT m_IDirectDrawSurfaceX::CopyFromEmulatedSurface(LPRECT lpDestRect)
 		return DDERR_GENERIC;
 	}
 
-	// Update palette surface data
-	if (!surface.DisplayTexture || FAILED(CopyEmulatedPaletteSurface(&DestRect)))
+	// Queue rect for the palette display texture, it gets updated when the display texture is used
+	if (IsPalette())
 	{
-		surface.IsPaletteDirty = IsPalette();
+		surface.PaletteDirtyRegion.Add(DestRect);
+		surface.IsPaletteDirty = true;
 	}
 
 	return DD_OK;
@@ -8213,106 +8423,47 @@ HRESULT m_IDirectDrawSurfaceX::CopyToEmulatedSurface(LPRECT lpDestRect)
 
 	HRESULT hr = DD_OK;
 
+	// Real surface format may differ from the emulated surface format
+	const D3DFORMAT RealFormat = ConvertSurfaceFormat(surface.Format);
+
 	// Copy real surface data to emulated surface
-	switch ((DWORD)surface.Format)
+	if (RealFormat != surface.Format && IsPixelConversionSupported(RealFormat, surface.Format))
 	{
-	case D3DFMT_X4R4G4B4:
-	case D3DFMT_A4R4G4B4:
-		for (LONG x = DestRect.top; x < DestRect.bottom; x++)
-		{
-			WORD* EmulatedBufferLoop = (WORD*)EmulatedBuffer;
-			DWORD* SurfaceBufferLoop = (DWORD*)SurfaceBuffer;
-			for (LONG y = DestRect.left; y < DestRect.right; y++)
-			{
-				*EmulatedBufferLoop = D3DFMT_A8R8G8B8_TO_A4R4G4B4(*SurfaceBufferLoop);
-				EmulatedBufferLoop++;
-				SurfaceBufferLoop++;
-			}
-			EmulatedBuffer += EmulatedLockRect.Pitch;
-			SurfaceBuffer += SrcLockRect.Pitch;
-		}
-		break;
-	case D3DFMT_R8G8B8:
-		for (LONG x = DestRect.top; x < DestRect.bottom; x++)
-		{
-			TRIBYTE* EmulatedBufferLoop = (TRIBYTE*)EmulatedBuffer;
-			DWORD* SurfaceBufferLoop = (DWORD*)SurfaceBuffer;
-			for (LONG y = DestRect.left; y < DestRect.right; y++)
-			{
-				*EmulatedBufferLoop = *(TRIBYTE*)SurfaceBufferLoop;
-				EmulatedBufferLoop++;
-				SurfaceBufferLoop++;
-			}
-			EmulatedBuffer += EmulatedLockRect.Pitch;
-			SurfaceBuffer += SrcLockRect.Pitch;
-		}
-		break;
-	case D3DFMT_B8G8R8:
-		for (LONG x = DestRect.top; x < DestRect.bottom; x++)
-		{
-			TRIBYTE* EmulatedBufferLoop = (TRIBYTE*)EmulatedBuffer;
-			DWORD* SurfaceBufferLoop = (DWORD*)SurfaceBuffer;
-			for (LONG y = DestRect.left; y < DestRect.right; y++)
-			{
-				DWORD Pixel = D3DFMT_X8R8G8B8_TO_B8G8R8(*SurfaceBufferLoop);
-				*EmulatedBufferLoop = *(TRIBYTE*)&Pixel;
-				EmulatedBufferLoop++;
-				SurfaceBufferLoop++;
-			}
-			EmulatedBuffer += EmulatedLockRect.Pitch;
-			SurfaceBuffer += SrcLockRect.Pitch;
-		}
-		break;
-	case D3DFMT_X8B8G8R8:
-	case D3DFMT_A8B8G8R8:
-		for (LONG x = DestRect.top; x < DestRect.bottom; x++)
+		ConvertPixelRect(EmulatedBuffer, EmulatedLockRect.Pitch, surface.Format, SurfaceBuffer, SrcLockRect.Pitch, RealFormat, DestRect.right - DestRect.left, Height);
+	}
+	else if (SrcLockRect.Pitch == EmulatedLockRect.Pitch && (DWORD)(DestRect.right - DestRect.left) == surfaceDesc2.dwWidth)
+	{
+		memcpy(EmulatedBuffer, SurfaceBuffer, SrcLockRect.Pitch * Height);
+	}
+	else if (surface.emu->bmi->bmiHeader.biBitCount == surface.BitCount)
+	{
+		for (UINT x = 0; x < Height; x++)
 		{
-			DWORD* EmulatedBufferLoop = (DWORD*)EmulatedBuffer;
-			DWORD* SurfaceBufferLoop = (DWORD*)SurfaceBuffer;
-			for (LONG y = DestRect.left; y < DestRect.right; y++)
-			{
-				*EmulatedBufferLoop = D3DFMT_A8R8G8B8_TO_A8B8G8R8(*SurfaceBufferLoop);
-				EmulatedBufferLoop++;
-				SurfaceBufferLoop++;
-			}
+			memcpy(EmulatedBuffer, SurfaceBuffer, WidthPitch);
 			EmulatedBuffer += EmulatedLockRect.Pitch;
 			SurfaceBuffer += SrcLockRect.Pitch;
 		}
-		break;
-	default:
-		if (SrcLockRect.Pitch == EmulatedLockRect.Pitch && (DWORD)(DestRect.right - DestRect.left) == surfaceDesc2.dwWidth)
-		{
-			memcpy(EmulatedBuffer, SurfaceBuffer, SrcLockRect.Pitch * Height);
-		}
-		else if (surface.emu->bmi->bmiHeader.biBitCount == surface.BitCount)
-		{
-			for (UINT x = 0; x < Height; x++)
-			{
-				memcpy(EmulatedBuffer, SurfaceBuffer, WidthPitch);
-				EmulatedBuffer += EmulatedLockRect.Pitch;
-				SurfaceBuffer += SrcLockRect.Pitch;
-			}
-		}
-		else
-		{
-			hr = DDERR_GENERIC;
-			LOG_LIMIT(100, __FUNCTION__ << " Error: emulated surface format not supported: " << surface.Format);
-		}
+	}
+	else
+	{
+		hr = DDERR_GENERIC;
+		LOG_LIMIT(100, __FUNCTION__ << " Error: emulated surface format not supported: " << surface.Format);
 	}
 
 	// Unlock surface
 	UnLockD3d9Surface(0);
 
-	// Update palette surface data
-	if (!surface.DisplayTexture || FAILED(CopyEmulatedPaletteSurface(&DestRect)))
+	// Queue rect for the palette display texture, it gets updated when the display texture is used
+	if (IsPalette())
 	{
-		surface.IsPaletteDirty = IsPalette();
+		surface.PaletteDirtyRegion.Add(DestRect);
+		surface.IsPaletteDirty = true;
 	}
 
 	return hr;
 }
 
-HRESULT m_IDirectDrawSurfaceX::CopyEmulatedPaletteSurface(LPRECT lpDestRect)
+HRESULT m_IDirectDrawSurfaceX::CopyEmulatedPaletteSurface()
 {
 	if (!IsPalette() || !d3d9Device || !*d3d9Device)
 	{
@@ -8354,14 +8505,16 @@ HRESULT m_IDirectDrawSurfaceX::CopyEmulatedPaletteSurface(LPRECT lpDestRect)
 				return DDERR_GENERIC;
 			}
 		}
+
+		// New texture needs the whole surface
+		surface.PaletteDirtyRegion.SetFull();
 	}
 
-	// Update rect, if palette surface is dirty then update the whole surface
-	RECT DestRect = {};
-	if (!CheckCoordinates(DestRect, (surface.IsPaletteDirty ? nullptr : lpDestRect), nullptr))
+	// Check if there is anything to update
+	if (surface.PaletteDirtyRegion.IsEmpty())
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: Invalid rect: " << lpDestRect);
-		return DDERR_INVALIDRECT;
+		surface.IsPaletteDirty = false;
+		return DD_OK;
 	}
 
 	// Get palette display context surface
@@ -8374,14 +8527,56 @@ HRESULT m_IDirectDrawSurfaceX::CopyEmulatedPaletteSurface(LPRECT lpDestRect)
 		}
 	}
 
-	// Use LoadSurfaceFromMemory to copy to the surface
-	if (FAILED(LoadSurfaceFromMemory(surface.DisplayContext, DestRect, surface.emu->pBits, D3DFMT_P8, surface.emu->Pitch)))
+	D3DSURFACE_DESC Desc = {};
+	if (FAILED(surface.DisplayContext->GetDesc(&Desc)))
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Warning: could not copy palette display texture: " << surface.Format);
+		LOG_LIMIT(100, __FUNCTION__ << " Error: failed to get palette display surface description!");
 		return DDERR_GENERIC;
 	}
 
+	// Rebuild palette lookup table only when the palette changes
+	if (surface.PaletteLookupUSN != surface.LastPaletteUSN || surface.PaletteLookupFormat != Desc.Format || surface.PaletteLookup.size() != MaxPaletteSize)
+	{
+		surface.PaletteLookup.resize(MaxPaletteSize);
+		if (!BuildPaletteLookup(surface.PaletteLookup.data(), surface.PaletteEntryArray, Desc.Format))
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: palette display format not supported: " << Desc.Format);
+			return DDERR_GENERIC;
+		}
+		surface.PaletteLookupUSN = surface.LastPaletteUSN;
+		surface.PaletteLookupFormat = Desc.Format;
+	}
+
+	// Update only the dirty rects, or the whole surface if the palette changed
+	const bool IsFullSurface = surface.PaletteDirtyRegion.IsFullSurface();
+	const DWORD RectCount = IsFullSurface ? 1 : surface.PaletteDirtyRegion.GetCount();
+	const RECT* pRects = surface.PaletteDirtyRegion.GetRects();
+
+	for (DWORD x = 0; x < RectCount; x++)
+	{
+		RECT DestRect = {};
+		if (!CheckCoordinates(DestRect, (IsFullSurface ? nullptr : (LPRECT)&pRects[x]), nullptr))
+		{
+			continue;
+		}
+
+		// Lock only the rect that needs to be updated
+		D3DLOCKED_RECT LockedRect = {};
+		if (FAILED(surface.DisplayContext->LockRect(&LockedRect, &DestRect, 0)) || !LockedRect.pBits)
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: could not lock palette display surface " << DestRect);
+			return DDERR_GENERIC;
+		}
+
+		// Expand palette indexes into the display surface
+		const BYTE* SrcBuffer = (const BYTE*)surface.emu->pBits + (surface.emu->Pitch * DestRect.top) + DestRect.left;
+		ExpandPaletteRect((BYTE*)LockedRect.pBits, LockedRect.Pitch, Desc.Format, SrcBuffer, surface.emu->Pitch, surface.PaletteLookup.data(), DestRect.right - DestRect.left, DestRect.bottom - DestRect.top);
+
+		surface.DisplayContext->UnlockRect();
+	}
+
 	// Reset palette texture dirty flag
+	surface.PaletteDirtyRegion.Clear();
 	surface.IsPaletteDirty = false;
 
 	return DD_OK;
@@ -8848,6 +9043,7 @@ void m_IDirectDrawSurfaceX::UpdatePaletteData()
 	if (IsPaletteDataUpdated)
 	{
 		surface.IsPaletteDirty = true;
+		surface.PaletteDirtyRegion.SetFull();
 		surface.LastPaletteUSN = NewPaletteUSN;
 		surface.PaletteEntryArray = NewPaletteEntry;
 	}
@@ -204,6 +204,10 @@ private:
 		DWORD LastShadowUSN = 0;
 		DWORD LastPaletteUSN = 0;							// The USN that was used last time the palette was updated
 		const PALETTEENTRY* PaletteEntryArray = nullptr;	// Used to store palette data address
+		DWORD PaletteLookupUSN = 0;							// The USN that was used last time the palette lookup table was built
+		D3DFORMAT PaletteLookupFormat = D3DFMT_UNKNOWN;		// Format the palette lookup table was built for
+		std::vector<DWORD> PaletteLookup;					// Palette entries converted to the display texture format
+		DirtyRegion PaletteDirtyRegion;						// Emulated surface area not yet copied to the palette display texture
 		EMUSURFACE* emu = nullptr;							// Emulated surface using device context
 		LPDIRECT3DSURFACE9 Surface = nullptr;				// Surface used for Direct3D
 		LPDIRECT3DSURFACE9 Shadow = nullptr;				// Shadow surface for render target
@@ -267,6 +271,7 @@ private:
 	DDRAWEMULATELOCK EmuLock;							// For aligning bits after a lock for games that hard code the pitch
 	REMOVESCANLINE EmuScanLine;							// For removal an restoration of scanlines
 	std::vector<BYTE, aligned_allocator<BYTE, 4>> ByteArray;						// Memory used for coping from one surface to the same surface
+	std::vector<BYTE, aligned_allocator<BYTE, 4>> StretchArray;					// Column table and row buffer used for stretched copies
 	std::vector<DDBACKUP> LostDeviceBackup;				// Memory used for backing up the surfaceTexture
 	COLORKEY ShaderColorKey;							// Used to store color key array for shader
 	SURFACECREATE ShouldEmulate = SC_NOT_CREATED;		// Used to help determine if surface should be emulated
@@ -380,7 +385,7 @@ private:
 	HRESULT LoadSurfaceFromMemory(LPDIRECT3DSURFACE9 pDestSurface, const RECT& Rect, LPCVOID pSrcMemory, D3DFORMAT SrcFormat, UINT SrcPitch);
 	HRESULT CopyFromEmulatedSurface(LPRECT lpDestRect);
 	HRESULT CopyToEmulatedSurface(LPRECT lpDestRect);
-	HRESULT CopyEmulatedPaletteSurface(LPRECT lpDestRect);
+	HRESULT CopyEmulatedPaletteSurface();
 	HRESULT CopyEmulatedSurfaceFromGDI(LPRECT lpDestRect);
 	HRESULT CopyEmulatedSurfaceToGDI(LPRECT lpDestRect);
 
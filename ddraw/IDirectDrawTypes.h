@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ddraw.h>
+#include "PixelTypes.h"
 
 class m_IDirectDrawX;
 
@@ -11,8 +12,6 @@ static constexpr D3DFORMAT D9DisplayFormat = D3DFMT_X8R8G8B8;
 
 static constexpr D3DMULTISAMPLE_TYPE D9SampleType = D3DMULTISAMPLE_4_SAMPLES;
 
-static constexpr DWORD MaxPaletteSize = 256;
-
 static constexpr DWORD DXW_ALL_SURFACE_LEVELS = 0xFFFF;
 
 #define BLT_MIRRORLEFTRIGHT		0x00000002l
@@ -29,20 +28,10 @@ static constexpr DWORD DXW_ALL_SURFACE_LEVELS = 0xFFFF;
 #define D3DCOLOR_GETGREEN(c)      (((c) >> 8) & 0xFF)
 #define D3DCOLOR_GETBLUE(c)       ((c) & 0xFF)
 
-#define D3DFMT_B8G8R8 (D3DFORMAT)19
 #define D3DFMT_AYUV   (D3DFORMAT)MAKEFOURCC('A', 'Y', 'U', 'V')
 #define D3DFMT_YV12   (D3DFORMAT)MAKEFOURCC('Y', 'V', '1', '2')
 #define D3DFMT_NV12   (D3DFORMAT)MAKEFOURCC('N', 'V', '1', '2')
 
-#define D3DFMT_R5G6B5_TO_X8R8G8B8(w) \
-	((((DWORD)((w>>11)&0x1f)*8)<<16)+(((DWORD)((w>>5)&0x3f)*4)<<8)+((DWORD)(w&0x1f)*8))
-#define D3DFMT_A8R8G8B8_TO_A4R4G4B4(w) \
-	(WORD)(((((w&0xFF000000)>>24)/17)<<12)+((((w&0xFF0000)>>16)/17)<<8)+((((w&0xFF00)>>8)/17)<<4)+(((w&0xFF)/17)))
-#define D3DFMT_X8R8G8B8_TO_B8G8R8(w) \
-	(((w&0xFF)<<16)+(w&0xFF00)+((w&0xFF0000)>>16))
-#define D3DFMT_A8R8G8B8_TO_A8B8G8R8(w) \
-	((w&0xFF000000)+((w&0xFF)<<16)+(w&0xFF00)+((w&0xFF0000)>>16))
-
 static constexpr D3DFORMAT FourCCTypes[] =
 {
 	(D3DFORMAT)MAKEFOURCC('N', 'V', '1', '2'),
@@ -183,7 +172,7 @@ struct PRESENTTHREAD
 	const bool& ExitFlag = Config.Exiting;
 	bool IsInitialized = false;
 	HANDLE workerThread = {};
-	HANDLE exitEvent = {};
+	PresentScheduler* Scheduler = nullptr;
 	LARGE_INTEGER LastPresentTime = {};
 };
 
@@ -205,40 +194,6 @@ struct EMUSURFACE
 	DWORD LastPaletteUSN = 0;
 };
 
-// Used for 24-bit surfaces
-struct TRIBYTE
-{
-	BYTE first;
-	BYTE second;
-	BYTE third;
-
-	// Constructor from DWORD
-	TRIBYTE(DWORD value)
-		: first(BYTE(value & 0xFF)),
-		second(BYTE((value >> 8) & 0xFF)),
-		third(BYTE((value >> 16) & 0xFF))
-	{
-	}
-
-	// Default constructor
-	TRIBYTE() : first(0), second(0), third(0) {}
-
-	// Conversion operator from TRIBYTE to DWORD
-	operator DWORD() const {
-		return (DWORD(first) | (DWORD(second) << 8) | (DWORD(third) << 16));
-	}
-
-	// Equality operator
-	bool operator==(const TRIBYTE& other) const {
-		return first == other.first && second == other.second && third == other.third;
-	}
-
-	// Inequality operator
-	bool operator!=(const TRIBYTE& other) const {
-		return !(*this == other);
-	}
-};
-
 static constexpr DWORD DDS_MAGIC				= 0x20534444; // "DDS "
 static constexpr DWORD DDS_HEADER_SIZE			= sizeof(DWORD) + sizeof(DDS_HEADER);
 static constexpr DWORD DDS_HEADER_FLAGS_TEXTURE	= 0x00001007; // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT 
@@ -246,10 +201,6 @@ static constexpr DWORD DDS_HEADER_FLAGS_PITCH	= 0x00000008;
 
 void AddDisplayResolution(DWORD Width, DWORD Height);
 bool IsDisplayResolution(DWORD Width, DWORD Height);
-template <typename T>
-void SimpleColorKeyCopy(T ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT SrcPitch, INT DestPitch, LONG DestRectWidth, LONG DestRectHeight, bool IsColorKey, bool IsMirrorLeftRight);
-template <typename T>
-void ComplexCopy(T ColorKey, D3DLOCKED_RECT SrcLockRect, D3DLOCKED_RECT DestLockRect, LONG SrcRectWidth, LONG SrcRectHeight, LONG DestRectWidth, LONG DestRectHeight, bool IsColorKey, bool IsMirrorUpDown, bool IsMirrorLeftRight);
 D3DCOLOR ConvertPixelColor(D3DCOLOR PixelColor, const DDPIXELFORMAT& ddpfPixelFormat);
 bool HasStencil(D3DFORMAT Format);
 DWORD GetDepthColor(float DepthValue, D3DFORMAT Format, DWORD& BPP);
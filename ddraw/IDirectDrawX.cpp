@@ -74,16 +74,8 @@ namespace {
 	// High resolution counter used for auto frame skipping
 	HIGHRESCOUNTER Counter = {};
 
-#ifdef ENABLE_PROFILING
-	std::chrono::steady_clock::time_point presentTime;
-#endif
-
-	struct DX_INDEX_BUFFER {
-		const DWORD MaxCount;
-		DWORD Size = 0;
-		LPDIRECT3DINDEXBUFFER9 Buffer = nullptr;
-		DX_INDEX_BUFFER(DWORD MaxCount) : MaxCount(MaxCount) {}
-	};
+	// Timer used to sleep through the scanout when polling for vertical blank
+	Utils::FrameLimiter VsyncTimer;
 
 	// Preset from another thread
 	PRESENTTHREAD PresentThread;
@@ -106,19 +98,8 @@ namespace {
 	LPDIRECT3DPIXELSHADER9 gammaPixelShader = nullptr;
 	LPDIRECT3DVERTEXSHADER9 fixupVertexShader = nullptr;
 	LPDIRECT3DVERTEXBUFFER9 validateDeviceVertexBuffer = nullptr;
-	constexpr UINT IndexBufferRotationSize = 3;
-	struct {
-		DX_INDEX_BUFFER IndexBuffer[8] = {
-			DX_INDEX_BUFFER(64),
-			DX_INDEX_BUFFER(128),
-			DX_INDEX_BUFFER(256),
-			DX_INDEX_BUFFER(512),
-			DX_INDEX_BUFFER(1024),
-			DX_INDEX_BUFFER(2048),
-			DX_INDEX_BUFFER(4096),
-			DX_INDEX_BUFFER(0xFFFFFFFF / sizeof(WORD))
-		};
-	} Layer[IndexBufferRotationSize];
+	DynamicVertexBuffer VertexStream(256 * 1024);
+	DynamicIndexBuffer IndexStream(64 * 1024);
 
 	// Direct3D9 flags
 	bool EnableWaitVsync = false;
@@ -2048,6 +2029,8 @@ HRESULT m_IDirectDrawX::WaitForVerticalBlank(DWORD dwFlags, HANDLE hEvent)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	PROFILE_ZONE(ZONE_WAITFORVERTICALBLANK);
+
 	if (Config.Dd7to9)
 	{
 		// Check for device interface
@@ -2056,12 +2039,34 @@ HRESULT m_IDirectDrawX::WaitForVerticalBlank(DWORD dwFlags, HANDLE hEvent)
 			return DDERR_GENERIC;
 		}
 
-#ifdef ENABLE_PROFILING
-		auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 		D3DRASTER_STATUS RasterStatus = {};
 
+		// Fallback: sleep through most of the visible scanout, then poll the raster status for vertical blank begin
+		auto WaitForRasterVBlank = [&]() {
+			int Width = 0, Height = 0;
+			Utils::GetScreenSize(hMonitor, Width, Height);
+			const LONGLONG Frequency = VsyncTimer.GetFrequency();
+			const LONGLONG FrameTicks = static_cast<LONGLONG>(Counter.PerFrameMS * Frequency / 1000.0);
+
+			// The frame also has blanking lines that are not known here, so the time left estimated from the visible height is too long.
+			// Sleep half of the estimate at a time and poll the raster status once less than 1ms is left.
+			while (Height > 0 && SUCCEEDED(d3d9Device->GetRasterStatus(0, &RasterStatus)) && !RasterStatus.InVBlank && RasterStatus.ScanLine < (UINT)Height)
+			{
+				const LONGLONG SleepTicks = FrameTicks * (Height - RasterStatus.ScanLine) / Height / 2;
+				if (SleepTicks < Frequency / 1000)
+				{
+					break;
+				}
+				LARGE_INTEGER ClickTime = {};
+				QueryPerformanceCounter(&ClickTime);
+				VsyncTimer.WaitUntil(ClickTime.QuadPart + SleepTicks);
+			}
+			while (SUCCEEDED(d3d9Device->GetRasterStatus(0, &RasterStatus)) && !RasterStatus.InVBlank)
+			{
+				Utils::BusyWaitYield(0);
+			}
+		};
+
 		HRESULT hr = DD_OK;
 
 		// Check flags
@@ -2076,10 +2081,7 @@ HRESULT m_IDirectDrawX::WaitForVerticalBlank(DWORD dwFlags, HANDLE hEvent)
 			}
 
 			// Fallback: Wait for vertical blank begin using raster status
-			while (SUCCEEDED(d3d9Device->GetRasterStatus(0, &RasterStatus)) && !RasterStatus.InVBlank)
-			{
-				Utils::BusyWaitYield(0);
-			}
+			WaitForRasterVBlank();
 			break;
 
 		case DDWAITVB_BLOCKEND:
@@ -2091,10 +2093,7 @@ HRESULT m_IDirectDrawX::WaitForVerticalBlank(DWORD dwFlags, HANDLE hEvent)
 			// Fallback: Wait for vertical blank to end using raster status
 			else
 			{
-				while (SUCCEEDED(d3d9Device->GetRasterStatus(0, &RasterStatus)) && !RasterStatus.InVBlank)
-				{
-					Utils::BusyWaitYield(0);
-				}
+				WaitForRasterVBlank();
 			}
 
 			// Then, wait for the vertical blank to end
@@ -2116,10 +2115,6 @@ HRESULT m_IDirectDrawX::WaitForVerticalBlank(DWORD dwFlags, HANDLE hEvent)
 			break;
 		}
 
-#ifdef ENABLE_PROFILING
-		Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 		return hr;
 	}
 
@@ -2530,9 +2525,6 @@ void m_IDirectDrawX::InitInterface(DWORD DirectXVersion)
 		Counter = {};
 		QueryPerformanceFrequency(&Counter.Frequency);
 
-#ifdef ENABLE_PROFILING
-		presentTime = std::chrono::high_resolution_clock::now();
-#endif
 		// Direct3D9 flags
 		EnableWaitVsync = false;
 
@@ -2556,8 +2548,18 @@ void m_IDirectDrawX::InitInterface(DWORD DirectXVersion)
 		// Prepare for present from another thread
 		if (Config.DdrawAutoFrameSkip)
 		{
-			PresentThread.exitEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
-			PresentThread.workerThread = CreateThread(NULL, 0, PresentThreadFunction, NULL, 0, NULL);
+			PresentThread.Scheduler = new PresentScheduler();
+			if (PresentThread.Scheduler->IsCreated())
+			{
+				PresentThread.workerThread = CreateThread(NULL, 0, PresentThreadFunction, PresentThread.Scheduler, 0, NULL);
+			}
+			PresentThread.IsInitialized = (PresentThread.workerThread != nullptr);
+			if (!PresentThread.IsInitialized)
+			{
+				LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create present thread!");
+				delete PresentThread.Scheduler;
+				PresentThread.Scheduler = nullptr;
+			}
 		}
 
 		// Mouse hook
@@ -2778,21 +2780,21 @@ void m_IDirectDrawX::ReleaseInterface()
 		// Close present thread first
 		if (PresentThread.IsInitialized)
 		{
-			// Trigger thread and terminate the thread
-			DWORD exitCode = 0;
-			while (GetExitCodeThread(PresentThread.workerThread, &exitCode) && exitCode == STILL_ACTIVE)
+			PresentThread.IsInitialized = false;
+
+			// Stop the thread, if it is waiting for the ddraw lock held here it deletes the scheduler itself,
+			// so the lock must stay held until the scheduler pointer is cleared
+			if (PresentThread.Scheduler->Stop(PresentThread.workerThread))
 			{
-				SetEvent(PresentThread.exitEvent);
-				Sleep(0);
+				delete PresentThread.Scheduler;
 			}
 
 			// Close handles
 			CloseHandle(PresentThread.workerThread);
-			CloseHandle(PresentThread.exitEvent);
 
 			// Clean up variables
 			PresentThread.workerThread = nullptr;
-			PresentThread.exitEvent = nullptr;
+			PresentThread.Scheduler = nullptr;
 		}
 
 		// Release all resources
@@ -3081,6 +3083,31 @@ bool m_IDirectDrawX::IsInScene()
 	return false;
 }
 
+// With a texture or palette, only devices that draw with it are flushed
+void m_IDirectDrawX::FlushDrawBatches(m_IDirectDrawSurfaceX* lpTextureX, m_IDirectDrawPalette* lpPalette)
+{
+	if (!Config.DdrawBatchPrimitives)
+	{
+		return;
+	}
+
+	const bool FlushAll = (!lpTextureX && !lpPalette);
+
+	for (const auto& pDDraw : DDrawVector)
+	{
+		if (pDDraw->D3DInterface)
+		{
+			for (DWORD x = 0; m_IDirect3DDeviceX* D3DDeviceX = pDDraw->D3DInterface->GetNextD3DDevice(x); ++x)
+			{
+				if (FlushAll || D3DDeviceX->IsTextureBound(lpTextureX) || D3DDeviceX->IsPaletteBound(lpPalette))
+				{
+					D3DDeviceX->FlushDrawBatch();
+				}
+			}
+		}
+	}
+}
+
 UINT m_IDirectDrawX::GetAdapterIndex() const
 {
 	return d3d9AdapterIndex;
@@ -3208,24 +3235,11 @@ LPDIRECT3DVERTEXBUFFER9 m_IDirectDrawX::GetValidateDeviceVertexBuffer(DWORD& FVF
 	return validateDeviceVertexBuffer;
 }
 
-LPDIRECT3DINDEXBUFFER9 m_IDirectDrawX::GetIndexBuffer(LPWORD lpwIndices, DWORD dwIndexCount)
-{
-	static UINT x = 0;
-	for (auto& entry : Layer[++x % IndexBufferRotationSize].IndexBuffer)
-	{
-		if (dwIndexCount <= entry.MaxCount)
-		{
-			return GetIndexBufferX(lpwIndices, dwIndexCount, entry.Size, entry.Buffer);
-		}
-	}
-	return nullptr;
-}
-
-LPDIRECT3DINDEXBUFFER9 m_IDirectDrawX::GetIndexBufferX(LPWORD lpwIndices, DWORD dwIndexCount, DWORD& IndexBufferSize, LPDIRECT3DINDEXBUFFER9& d3d9IndexBuffer)
+LPDIRECT3DVERTEXBUFFER9 m_IDirectDrawX::GetVertexBuffer(LPVOID lpVertices, DWORD dwVertexCount, DWORD Stride, UINT& StartVertex)
 {
-	if (!lpwIndices)
+	if (!lpVertices)
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: nullptr Indices!");
+		LOG_LIMIT(100, __FUNCTION__ << " Error: nullptr Vertices!");
 		return nullptr;
 	}
 
@@ -3235,48 +3249,38 @@ LPDIRECT3DINDEXBUFFER9 m_IDirectDrawX::GetIndexBufferX(LPWORD lpwIndices, DWORD
 		return nullptr;
 	}
 
-	DWORD NewIndexSize = dwIndexCount * sizeof(WORD);
-
-	HRESULT hr = D3D_OK;
-	if (!d3d9IndexBuffer || NewIndexSize > IndexBufferSize)
-	{
-		ReleaseD3D9IndexBuffer(d3d9IndexBuffer, IndexBufferSize);
-		// Create in video memory and then use discard when locking to improve system performance
-		hr = d3d9Device->CreateIndexBuffer(NewIndexSize, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFMT_INDEX16, D3DPOOL_DEFAULT, &d3d9IndexBuffer, nullptr);
-	}
-
-	if (FAILED(hr))
+	INT Start = VertexStream.Load(d3d9Device, lpVertices, dwVertexCount, Stride, Config.DdrawNoDrawBufferSysLock ? D3DLOCK_NOSYSLOCK : NULL);
+	if (Start < 0)
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create index buffer: " << (D3DERR)hr << " Size: " << NewIndexSize);
 		return nullptr;
 	}
 
-	if (NewIndexSize > IndexBufferSize)
+	StartVertex = Start;
+	return VertexStream.GetBuffer();
+}
+
+LPDIRECT3DINDEXBUFFER9 m_IDirectDrawX::GetIndexBuffer(LPWORD lpwIndices, DWORD dwIndexCount, UINT& StartIndex)
+{
+	if (!lpwIndices)
 	{
-		IndexBufferSize = NewIndexSize;
+		LOG_LIMIT(100, __FUNCTION__ << " Error: nullptr Indices!");
+		return nullptr;
 	}
 
-	DWORD Flags = D3DLOCK_DISCARD | (Config.DdrawNoDrawBufferSysLock ? D3DLOCK_NOSYSLOCK : NULL);
-
-	void* pData = nullptr;
-	hr = d3d9IndexBuffer->Lock(0, NewIndexSize, &pData, Flags);
-
-	if (FAILED(hr) && (Flags & D3DLOCK_NOSYSLOCK))
+	// Check for device interface
+	if (FAILED(CheckInterface(__FUNCTION__, true)))
 	{
-		hr = d3d9IndexBuffer->Lock(0, NewIndexSize, &pData, Flags & ~D3DLOCK_NOSYSLOCK);
+		return nullptr;
 	}
 
-	if (FAILED(hr))
+	INT Start = IndexStream.Load(d3d9Device, lpwIndices, dwIndexCount, sizeof(WORD), Config.DdrawNoDrawBufferSysLock ? D3DLOCK_NOSYSLOCK : NULL);
+	if (Start < 0)
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: failed to lock index buffer: " << (D3DERR)hr);
 		return nullptr;
 	}
 
-	memcpy(pData, lpwIndices, NewIndexSize);
-
-	d3d9IndexBuffer->Unlock();
-
-	return d3d9IndexBuffer;
+	StartIndex = Start;
+	return IndexStream.GetBuffer();
 }
 
 DWORD m_IDirectDrawX::GetHwndThreadID()
@@ -4225,21 +4229,6 @@ void m_IDirectDrawX::ResetAllSurfaceDisplay()
 	}
 }
 
-void m_IDirectDrawX::ReleaseD3D9IndexBuffer(LPDIRECT3DINDEXBUFFER9& d3d9IndexBuffer, DWORD& IndexBufferSize)
-{
-	// Release index buffer
-	if (d3d9IndexBuffer)
-	{
-		ULONG ref = d3d9IndexBuffer->Release();
-		if (ref)
-		{
-			Logging::Log() << __FUNCTION__ << " (" << this << ")" << " Error: there is still a reference to 'd3d9IndexBuffer' " << ref;
-		}
-		d3d9IndexBuffer = nullptr;
-		IndexBufferSize = 0;
-	}
-}
-
 void m_IDirectDrawX::ReleaseAllD9Resources(bool BackupData, bool ResetInterface)
 {
 	// Remove render target and depth stencil surfaces
@@ -4320,14 +4309,14 @@ void m_IDirectDrawX::ReleaseAllD9Resources(bool BackupData, bool ResetInterface)
 		validateDeviceVertexBuffer = nullptr;
 	}
 
-	// Release index buffer
-	for (UINT x = 0; x < IndexBufferRotationSize; x++)
+	// Release streaming vertex and index buffers
+	if (d3d9Device && ResetInterface)
 	{
-		for (auto& entry : Layer[x].IndexBuffer)
-		{
-			ReleaseD3D9IndexBuffer(entry.Buffer, entry.Size);
-		}
+		d3d9Device->SetStreamSource(0, nullptr, 0, 0);
+		d3d9Device->SetIndices(nullptr);
 	}
+	VertexStream.Release();
+	IndexStream.Release();
 
 	// Release palette pixel shader
 	if (palettePixelShader)
@@ -5226,12 +5215,15 @@ HRESULT m_IDirectDrawX::PresentScene(m_IDirectDrawSurfaceX* pPrimarySurface, REC
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	PROFILE_ZONE(ZONE_PRESENTSCENE);
+
 	HRESULT hr = DDERR_GENERIC;
 
 	PresentUSN++;
 
 	if (IsUsingThreadPresent())
 	{
+		PresentThread.Scheduler->Post();
 		return DD_OK;
 	}
 
@@ -5246,10 +5238,6 @@ HRESULT m_IDirectDrawX::PresentScene(m_IDirectDrawSurfaceX* pPrimarySurface, REC
 		LOG_LIMIT(100, __FUNCTION__ << " Warning: primary surface doesn't match: " << PrimarySurface << " -> " << pPrimarySurface);
 	}
 
-#ifdef ENABLE_PROFILING
-	auto startTime = std::chrono::high_resolution_clock::now();
-#endif
-
 	// Prepare primary surface render target before presenting
 	pPrimarySurface->PrepareRenderTarget();
 
@@ -5321,10 +5309,6 @@ HRESULT m_IDirectDrawX::PresentScene(m_IDirectDrawSurfaceX* pPrimarySurface, REC
 	// End scene
 	d3d9Device->EndScene();
 
-#ifdef ENABLE_PROFILING
-	Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
 	// Present to d3d9
 	if (SUCCEEDED(hr))
 	{
@@ -5339,52 +5323,39 @@ bool m_IDirectDrawX::IsUsingThreadPresent()
 	return (PresentThread.IsInitialized && ExclusiveMode && !RenderTargetSurface && !IsPrimaryRenderTarget());
 }
 
-DWORD WINAPI m_IDirectDrawX::PresentThreadFunction(LPVOID)
+DWORD WINAPI m_IDirectDrawX::PresentThreadFunction(LPVOID lpParam)
 {
 	LOG_LIMIT(100, __FUNCTION__ << " Creating thread!");
 
-	ScopedFlagSet AutoSet(PresentThread.IsInitialized);
+	PresentScheduler& Scheduler = *reinterpret_cast<PresentScheduler*>(lpParam);
 
-	while (!PresentThread.ExitFlag)
+	// Wait for a frame to be posted (check exit flag before and after wait)
+	while (!PresentThread.ExitFlag && Scheduler.WaitForFrame() && !PresentThread.ExitFlag)
 	{
 		// Check how long since the last successful present
 		LARGE_INTEGER ClickTime = {};
 		QueryPerformanceCounter(&ClickTime);
 		double DeltaPresentMS = ((ClickTime.QuadPart - PresentThread.LastPresentTime.QuadPart) * 1000.0) / Counter.Frequency.QuadPart;
 
-		DWORD timeout = (DWORD)(Counter.PerFrameMS - DeltaPresentMS < 0.0 ? 0.0 : Counter.PerFrameMS - DeltaPresentMS);
-
-		// Wait for timeout or for event trigger (check exit flag before and after wait)
-		if (PresentThread.ExitFlag || WaitForSingleObject(PresentThread.exitEvent, timeout) == WAIT_OBJECT_0 || PresentThread.ExitFlag)
+		// Don't present faster than the screen refresh rate, frames posted while waiting are merged into this present
+		if (DeltaPresentMS < Counter.PerFrameMS && !Scheduler.WaitForInterval((DWORD)ceil(Counter.PerFrameMS - DeltaPresentMS)))
 		{
 			break;
 		}
 
-		// Wait until d3d9 device is created
-		while (!d3d9Device) 
-		{
-			if (WaitForSingleObject(PresentThread.exitEvent, 100) == WAIT_OBJECT_0)
-			{
-				LOG_LIMIT(100, __FUNCTION__ << " Closing thread!");
-
-				return S_OK;
-			}
-		}
-
 		CRITICAL_SECTION* ddcs = DdrawWrapper::GetDDCriticalSection();
 
-		// Wait until can get thread lock
-		while (TryEnterCriticalSection(ddcs) == FALSE)
-		{
-			if (WaitForSingleObject(PresentThread.exitEvent, 0) == WAIT_OBJECT_0)
-			{
-				LOG_LIMIT(100, __FUNCTION__ << " Closing thread!");
+		// Take the locks in a fixed order: ddraw, primary surface and then palette
+		Scheduler.BeginLockWait();
+		ScopedCriticalSection ThreadLockDD(ddcs);
+		Scheduler.EndLockWait();
 
-				return S_OK;
-			}
-			Utils::BusyWaitYield(0);
+		if (Scheduler.IsExiting())
+		{
+			break;
 		}
-		ScopedLeaveCriticalSection ThreadLockDDLeave(ddcs);
+
+		const LONG FrameCount = Scheduler.Consume();
 
 		if (d3d9Device)
 		{
@@ -5399,38 +5370,31 @@ DWORD WINAPI m_IDirectDrawX::PresentThreadFunction(LPVOID)
 					break;
 				}
 			}
+
+			// A busy surface is posted again when it is unlocked or its DC is released
 			if (pDDraw && pDDraw->IsUsingThreadPresent() && pPrimarySurface && pPrimarySurface->IsSurfaceCreated() && !pPrimarySurface->IsSurfaceBusy())
 			{
-				CRITICAL_SECTION* cs = pPrimarySurface->GetCriticalSection();
+				ScopedCriticalSection ThreadLockSC(pPrimarySurface->GetCriticalSection());
+				ScopedCriticalSection ThreadLockPE(DdrawWrapper::GetPECriticalSection());
 
-				if (cs && TryEnterCriticalSection(cs) != FALSE)
+				if (pPrimarySurface->GetD3d9Texture(false))
 				{
-					ScopedLeaveCriticalSection ThreadLockSCLeave(cs);
-
-					CRITICAL_SECTION* pecs = DdrawWrapper::GetPECriticalSection();
+					Logging::LogDebug() << __FUNCTION__ << " Presenting " << FrameCount << " posted frames";
 
-					if (pecs && TryEnterCriticalSection(pecs) != FALSE)
-					{
-						ScopedLeaveCriticalSection ThreadLockPELeave(pecs);
-
-						if (pPrimarySurface->GetD3d9Texture(false))
-						{
-							// Begin scene
-							d3d9Device->BeginScene();
+					// Begin scene
+					d3d9Device->BeginScene();
 
-							// Draw surface before presenting
-							pDDraw->DrawPrimarySurface(pPrimarySurface, nullptr);
+					// Draw surface before presenting
+					pDDraw->DrawPrimarySurface(pPrimarySurface, nullptr);
 
-							// End scene
-							d3d9Device->EndScene();
+					// End scene
+					d3d9Device->EndScene();
 
-							// Present to d3d9
-							d3d9Device->Present(nullptr, nullptr, nullptr, nullptr);
+					// Present to d3d9
+					d3d9Device->Present(nullptr, nullptr, nullptr, nullptr);
 
-							// Store last successful present time
-							QueryPerformanceCounter(&PresentThread.LastPresentTime);
-						}
-					}
+					// Store last successful present time
+					QueryPerformanceCounter(&PresentThread.LastPresentTime);
 				}
 			}
 		}
@@ -5438,6 +5402,12 @@ DWORD WINAPI m_IDirectDrawX::PresentThreadFunction(LPVOID)
 
 	LOG_LIMIT(100, __FUNCTION__ << " Closing thread!");
 
+	// Scheduler was handed over while this thread was waiting for the ddraw lock
+	if (Scheduler.IsDetached())
+	{
+		delete &Scheduler;
+	}
+
 	return S_OK;
 }
 
@@ -5445,9 +5415,10 @@ HRESULT m_IDirectDrawX::Present(RECT* pSourceRect, RECT* pDestRect)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-#ifdef ENABLE_PROFILING
-	auto startTime = std::chrono::high_resolution_clock::now();
-#endif
+	PROFILE_ZONE(ZONE_PRESENT);
+
+	// Draw any queued primitives before presenting
+	FlushDrawBatches();
 
 	// Skip frame if time lapse is too small
 	if (Config.DdrawAutoFrameSkip && !EnableWaitVsync && !IsUsingThreadPresent())
@@ -5527,14 +5498,7 @@ HRESULT m_IDirectDrawX::Present(RECT* pSourceRect, RECT* pDestRect)
 		}
 	}
 
-#ifdef ENABLE_PROFILING
-	Logging::Log() << __FUNCTION__ << " (" << this << ") hr = " << (D3DERR)hr << " Timing = " << Logging::GetTimeLapseInMS(startTime);
-#endif
-
-#ifdef ENABLE_PROFILING
-	Logging::Log() << __FUNCTION__ << " (" << this << ") Full Frame Time = " << Logging::GetTimeLapseInMS(presentTime);
-	presentTime = std::chrono::high_resolution_clock::now();
-#endif
+	Profiler::EndFrame();
 
 	const HWND hWnd = GetHwnd();
 
@@ -84,7 +84,6 @@ private:
 	void Clear3DSurfaceFlag();
 	void MarkAllSurfacesDirty();
 	void ResetAllSurfaceDisplay();
-	void ReleaseD3D9IndexBuffer(LPDIRECT3DINDEXBUFFER9& d3d9IndexBuffer, DWORD& IndexBufferSize);
 	void ReleaseAllD9Resources(bool BackupData, bool ResetInterface);
 	void ReleaseD9Device();
 	void ReleaseD9Object();
@@ -219,6 +218,7 @@ public:
 	bool IsUsing3D() const { return Using3D; }
 	bool IsPrimaryRenderTarget() { return PrimarySurface ? PrimarySurface->IsRenderTarget() : false; }
 	bool IsInScene();
+	void FlushDrawBatches(m_IDirectDrawSurfaceX* lpTextureX = nullptr, m_IDirectDrawPalette* lpPalette = nullptr);
 
 	// Direct3D9 interfaces
 	UINT GetAdapterIndex() const;
@@ -229,8 +229,8 @@ public:
 	LPDIRECT3DPIXELSHADER9* GetColorKeyPixelShader();
 	LPDIRECT3DVERTEXSHADER9* GetFixupVertexShader();
 	LPDIRECT3DVERTEXBUFFER9 GetValidateDeviceVertexBuffer(DWORD& FVF, DWORD& Size);
-	LPDIRECT3DINDEXBUFFER9 GetIndexBuffer(LPWORD lpwIndices, DWORD dwIndexCount);
-	LPDIRECT3DINDEXBUFFER9 GetIndexBufferX(LPWORD lpwIndices, DWORD dwIndexCount, DWORD& IndexBufferSize, LPDIRECT3DINDEXBUFFER9& d3d9IndexBuffer);
+	LPDIRECT3DVERTEXBUFFER9 GetVertexBuffer(LPVOID lpVertices, DWORD dwVertexCount, DWORD Stride, UINT& StartVertex);
+	LPDIRECT3DINDEXBUFFER9 GetIndexBuffer(LPWORD lpwIndices, DWORD dwIndexCount, UINT& StartIndex);
 	void GetMultiSampleTypeQuality(D3DMULTISAMPLE_TYPE& MaxSampleType, DWORD& QualityLevels) const;
 	void AfterDeviceCreation();
 	void Clear3DDeviceState(bool SetDefaultStateBlock);
@@ -0,0 +1,50 @@
+#pragma once
+
+// Pixel types and conversions shared by the surfaces and the CPU blit helpers
+
+static constexpr DWORD MaxPaletteSize = 256;
+
+#define D3DFMT_B8G8R8 (D3DFORMAT)19
+
+#define D3DFMT_R5G6B5_TO_X8R8G8B8(w) \
+	((((DWORD)((w>>11)&0x1f)*8)<<16)+(((DWORD)((w>>5)&0x3f)*4)<<8)+((DWORD)(w&0x1f)*8))
+#define D3DFMT_A8R8G8B8_TO_A4R4G4B4(w) \
+	(WORD)(((((w&0xFF000000)>>24)/17)<<12)+((((w&0xFF0000)>>16)/17)<<8)+((((w&0xFF00)>>8)/17)<<4)+(((w&0xFF)/17)))
+#define D3DFMT_X8R8G8B8_TO_B8G8R8(w) \
+	(((w&0xFF)<<16)+(w&0xFF00)+((w&0xFF0000)>>16))
+#define D3DFMT_A8R8G8B8_TO_A8B8G8R8(w) \
+	((w&0xFF000000)+((w&0xFF)<<16)+(w&0xFF00)+((w&0xFF0000)>>16))
+
+// Used for 24-bit surfaces
+struct TRIBYTE
+{
+	BYTE first;
+	BYTE second;
+	BYTE third;
+
+	// Constructor from DWORD
+	TRIBYTE(DWORD value)
+		: first(BYTE(value & 0xFF)),
+		second(BYTE((value >> 8) & 0xFF)),
+		third(BYTE((value >> 16) & 0xFF))
+	{
+	}
+
+	// Default constructor
+	TRIBYTE() : first(0), second(0), third(0) {}
+
+	// Conversion operator from TRIBYTE to DWORD
+	operator DWORD() const {
+		return (DWORD(first) | (DWORD(second) << 8) | (DWORD(third) << 16));
+	}
+
+	// Equality operator
+	bool operator==(const TRIBYTE& other) const {
+		return first == other.first && second == other.second && third == other.third;
+	}
+
+	// Inequality operator
+	bool operator!=(const TRIBYTE& other) const {
+		return !(*this == other);
+	}
+};
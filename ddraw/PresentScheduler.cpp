@@ -0,0 +1,91 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "PresentScheduler.h"
+
+PresentScheduler::PresentScheduler()
+{
+	ReadyEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	ExitEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	LockWaitEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+}
+
+PresentScheduler::~PresentScheduler()
+{
+	if (ReadyEvent)
+	{
+		CloseHandle(ReadyEvent);
+	}
+	if (ExitEvent)
+	{
+		CloseHandle(ExitEvent);
+	}
+	if (LockWaitEvent)
+	{
+		CloseHandle(LockWaitEvent);
+	}
+}
+
+// Blocks until a frame is posted or the scheduler is stopped, returns false when stopped
+bool PresentScheduler::WaitForFrame()
+{
+	while (!IsExiting())
+	{
+		// Publish the waiting flag before checking so a producer either sees it or its token is seen here
+		InterlockedExchange(&Waiting, TRUE);
+		if (InterlockedCompareExchange(&PostedGeneration, 0, 0) != PresentedGeneration)
+		{
+			InterlockedExchange(&Waiting, FALSE);
+			return true;
+		}
+
+		HANDLE Events[] = { ExitEvent, ReadyEvent };
+		if (WaitForMultipleObjects(_countof(Events), Events, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+		{
+			break;
+		}
+	}
+	return false;
+}
+
+// Takes every token posted so far, returns the number of tokens merged into this present
+LONG PresentScheduler::Consume()
+{
+	const LONG Generation = InterlockedCompareExchange(&PostedGeneration, 0, 0);
+	const LONG Count = Generation - PresentedGeneration;
+	PresentedGeneration = Generation;
+	return Count;
+}
+
+// Stops the present thread and returns true once it has exited. The caller holds the ddraw
+// critical section, so the present thread can be blocked on it and cannot exit yet. In that case
+// the scheduler is detached and returns false: the thread sees the exit flag as soon as it gets
+// the lock and then deletes the scheduler itself. The handoff is only safe because the thread
+// cannot get the lock until the caller releases it, after Detached is set.
+bool PresentScheduler::Stop(HANDLE hThread)
+{
+	InterlockedExchange(&Exiting, TRUE);
+	SetEvent(ExitEvent);
+
+	HANDLE Events[] = { hThread, LockWaitEvent };
+	if (WaitForMultipleObjects(_countof(Events), Events, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+	{
+		InterlockedExchange(&Detached, TRUE);
+		return false;
+	}
+	return true;
+}
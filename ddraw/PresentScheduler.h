@@ -0,0 +1,51 @@
+#pragma once
+
+#include <windows.h>
+
+// Hands "frame ready" tokens from the threads writing to the primary surface to the present
+// thread. Each token bumps a generation counter and the present thread takes every generation
+// posted so far in one present, so several writes between two presents are merged. Producers only
+// signal the kernel event when the present thread is actually waiting for it.
+class PresentScheduler
+{
+private:
+	HANDLE ReadyEvent = nullptr;		// Auto reset, set by producers when the consumer is waiting
+	HANDLE ExitEvent = nullptr;			// Manual reset, set once when the scheduler is stopped
+	HANDLE LockWaitEvent = nullptr;		// Manual reset, set while the consumer is blocked on the present locks
+	volatile LONG PostedGeneration = 0;
+	volatile LONG Waiting = FALSE;
+	volatile LONG Exiting = FALSE;
+	volatile LONG Detached = FALSE;
+	LONG PresentedGeneration = 0;
+
+public:
+	PresentScheduler();
+	~PresentScheduler();
+
+	bool IsCreated() const { return ReadyEvent && ExitEvent && LockWaitEvent; }
+
+	// Producer side, can be called from any thread
+	void Post()
+	{
+		InterlockedIncrement(&PostedGeneration);
+		if (InterlockedExchange(&Waiting, FALSE))
+		{
+			SetEvent(ReadyEvent);
+		}
+	}
+
+	// Consumer side, only called from the present thread
+	bool WaitForFrame();
+	bool WaitForInterval(DWORD Milliseconds) { return WaitForSingleObject(ExitEvent, Milliseconds) == WAIT_TIMEOUT; }
+	LONG Consume();
+	void BeginLockWait() { SetEvent(LockWaitEvent); }
+	void EndLockWait() { ResetEvent(LockWaitEvent); }
+	bool IsExiting() const { return Exiting != FALSE; }
+	bool IsDetached() const { return Detached != FALSE; }
+
+	// Owner side. The caller must hold the lock the present thread takes between BeginLockWait() and
+	// EndLockWait() for the whole call and until the scheduler pointer is dropped. Otherwise the
+	// thread can get the lock and exit after Stop() saw it waiting but before it was detached, and
+	// neither side deletes the scheduler.
+	bool Stop(HANDLE hThread);
+};
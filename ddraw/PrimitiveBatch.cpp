@@ -0,0 +1,144 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "PrimitiveBatch.h"
+
+namespace {
+	// Index of the nth vertex, either from the index list or sequential
+	inline WORD GetBatchIndex(const WORD* pIndices, DWORD Index, DWORD BaseVertex)
+	{
+		return (WORD)(BaseVertex + (pIndices ? pIndices[Index] : Index));
+	}
+}
+
+// Returns the list type a primitive is merged as, or 0 if it cannot be batched
+D3DPRIMITIVETYPE GetBatchPrimitiveType(D3DPRIMITIVETYPE PrimitiveType)
+{
+	switch (PrimitiveType)
+	{
+	case D3DPT_POINTLIST:
+		return D3DPT_POINTLIST;
+	case D3DPT_LINELIST:
+	case D3DPT_LINESTRIP:
+		return D3DPT_LINELIST;
+	case D3DPT_TRIANGLELIST:
+	case D3DPT_TRIANGLESTRIP:
+	case D3DPT_TRIANGLEFAN:
+		return D3DPT_TRIANGLELIST;
+	default:
+		return (D3DPRIMITIVETYPE)0;
+	}
+}
+
+// Appends list indices for Count vertices or indices and returns the number of indices added
+DWORD AppendBatchIndices(std::vector<WORD>& Indices, D3DPRIMITIVETYPE PrimitiveType, const WORD* pIndices, DWORD Count, DWORD BaseVertex)
+{
+	const size_t StartSize = Indices.size();
+
+	switch (PrimitiveType)
+	{
+	case D3DPT_POINTLIST:
+		for (DWORD x = 0; x < Count; x++)
+		{
+			Indices.push_back(GetBatchIndex(pIndices, x, BaseVertex));
+		}
+		break;
+	case D3DPT_LINELIST:
+		for (DWORD x = 0; x + 1 < Count; x += 2)
+		{
+			Indices.push_back(GetBatchIndex(pIndices, x, BaseVertex));
+			Indices.push_back(GetBatchIndex(pIndices, x + 1, BaseVertex));
+		}
+		break;
+	case D3DPT_LINESTRIP:
+		for (DWORD x = 0; x + 1 < Count; x++)
+		{
+			Indices.push_back(GetBatchIndex(pIndices, x, BaseVertex));
+			Indices.push_back(GetBatchIndex(pIndices, x + 1, BaseVertex));
+		}
+		break;
+	case D3DPT_TRIANGLELIST:
+		for (DWORD x = 0; x + 2 < Count; x += 3)
+		{
+			Indices.push_back(GetBatchIndex(pIndices, x, BaseVertex));
+			Indices.push_back(GetBatchIndex(pIndices, x + 1, BaseVertex));
+			Indices.push_back(GetBatchIndex(pIndices, x + 2, BaseVertex));
+		}
+		break;
+	case D3DPT_TRIANGLESTRIP:
+		// Odd triangles swap the last two vertices to keep the winding
+		for (DWORD x = 0; x + 2 < Count; x++)
+		{
+			Indices.push_back(GetBatchIndex(pIndices, x, BaseVertex));
+			Indices.push_back(GetBatchIndex(pIndices, x + 1 + (x & 1), BaseVertex));
+			Indices.push_back(GetBatchIndex(pIndices, x + 2 - (x & 1), BaseVertex));
+		}
+		break;
+	case D3DPT_TRIANGLEFAN:
+		// Rotated so the second vertex of each triangle stays first
+		for (DWORD x = 1; x + 1 < Count; x++)
+		{
+			Indices.push_back(GetBatchIndex(pIndices, x, BaseVertex));
+			Indices.push_back(GetBatchIndex(pIndices, x + 1, BaseVertex));
+			Indices.push_back(GetBatchIndex(pIndices, 0, BaseVertex));
+		}
+		break;
+	}
+
+	return (DWORD)(Indices.size() - StartSize);
+}
+
+// Returns true if the draw can be queued at all
+bool PRIMITIVEBATCH::CanBatch(D3DPRIMITIVETYPE PrimitiveType, DWORD VertexCount)
+{
+	return GetBatchPrimitiveType(PrimitiveType) && VertexCount <= MaxDrawVertices;
+}
+
+// Returns true if the draw can be added to the queued draws without drawing them first
+bool PRIMITIVEBATCH::CanMerge(D3DPRIMITIVETYPE NewPrimitiveType, DWORD NewFVF, DWORD NewVertexCount, DWORD NewFlags, DWORD NewDirectXVersion) const
+{
+	if (!CanBatch(NewPrimitiveType, NewVertexCount))
+	{
+		return false;
+	}
+
+	return !DrawCount ||
+		(PrimitiveType == GetBatchPrimitiveType(NewPrimitiveType) &&
+		FVF == NewFVF &&
+		Flags == NewFlags &&
+		DirectXVersion == NewDirectXVersion &&
+		VertexCount + NewVertexCount <= MaxVertices);
+}
+
+// Queues the draw, CanMerge() must be checked first, IndexCount is ignored for non-indexed draws
+void PRIMITIVEBATCH::Append(D3DPRIMITIVETYPE NewPrimitiveType, DWORD NewFVF, const void* pVertices, DWORD NewVertexCount, DWORD Stride, const WORD* pIndices, DWORD IndexCount, DWORD NewFlags, DWORD NewDirectXVersion)
+{
+	if (!DrawCount)
+	{
+		PrimitiveType = GetBatchPrimitiveType(NewPrimitiveType);
+		FVF = NewFVF;
+		Flags = NewFlags;
+		DirectXVersion = NewDirectXVersion;
+	}
+
+	const BYTE* pData = reinterpret_cast<const BYTE*>(pVertices);
+	Vertices.insert(Vertices.end(), pData, pData + NewVertexCount * Stride);
+
+	AppendBatchIndices(Indices, NewPrimitiveType, pIndices, pIndices ? IndexCount : NewVertexCount, VertexCount);
+
+	VertexCount += NewVertexCount;
+	DrawCount++;
+}
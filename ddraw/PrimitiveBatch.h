@@ -0,0 +1,41 @@
+#pragma once
+
+#include <windows.h>
+#include <d3d.h>
+#include <vector>
+#include "ScopeGuard.h"
+
+// Strips and fans are converted to lists so consecutive draws can be merged into one draw.
+// Converted triangles keep the first vertex used for flat shading and the original winding.
+D3DPRIMITIVETYPE GetBatchPrimitiveType(D3DPRIMITIVETYPE PrimitiveType);
+DWORD AppendBatchIndices(std::vector<WORD>& Indices, D3DPRIMITIVETYPE PrimitiveType, const WORD* pIndices, DWORD Count, DWORD BaseVertex);
+
+// Consecutive draws merged into one indexed list, flushed before any state change
+struct PRIMITIVEBATCH
+{
+	static constexpr DWORD MaxVertices = 0x10000;		// Limited by 16-bit indices
+	static constexpr DWORD MaxDrawVertices = 1024;		// Larger draws gain nothing from batching
+
+	D3DPRIMITIVETYPE PrimitiveType = D3DPT_TRIANGLELIST;
+	DWORD FVF = 0;
+	DWORD Flags = 0;
+	DWORD DirectXVersion = 0;
+	DWORD DrawCount = 0;
+	DWORD VertexCount = 0;
+	std::vector<BYTE, aligned_allocator<BYTE, 4>> Vertices;
+	std::vector<WORD> Indices;
+
+	// A state set to a different value must not apply to the queued draws
+	bool IsStateChange(DWORD OldValue, DWORD NewValue) const { return DrawCount && OldValue != NewValue; }
+	static bool CanBatch(D3DPRIMITIVETYPE PrimitiveType, DWORD VertexCount);
+	bool CanMerge(D3DPRIMITIVETYPE PrimitiveType, DWORD FVF, DWORD VertexCount, DWORD Flags, DWORD DirectXVersion) const;
+	void Append(D3DPRIMITIVETYPE PrimitiveType, DWORD FVF, const void* pVertices, DWORD VertexCount, DWORD Stride, const WORD* pIndices, DWORD IndexCount, DWORD Flags, DWORD DirectXVersion);
+
+	void clear()
+	{
+		DrawCount = 0;
+		VertexCount = 0;
+		Vertices.clear();
+		Indices.clear();
+	}
+};
@@ -0,0 +1,130 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Profiler.h"
+#include <algorithm>
+#include <intrin.h>
+
+namespace {
+	inline DWORD BitScanReverse64(ULONGLONG Value)
+	{
+		DWORD Index;
+		if (_BitScanReverse(&Index, (DWORD)(Value >> 32)))
+		{
+			return Index + 32;
+		}
+		_BitScanReverse(&Index, (DWORD)Value);
+		return Index;
+	}
+}
+
+UINT ProfileHistogram::GetBucket(ULONGLONG Value)
+{
+	if (Value < 16)
+	{
+		return (UINT)Value;
+	}
+	const UINT Shift = BitScanReverse64(Value) - 3;
+	const UINT SubBucket = (UINT)(Value >> Shift) - SubBucketCount;
+	return 16 + (Shift - 1) * SubBucketCount + SubBucket;
+}
+
+ULONGLONG ProfileHistogram::GetBucketValue(UINT Bucket)
+{
+	if (Bucket < 16)
+	{
+		return Bucket;
+	}
+	const UINT Shift = (Bucket - 16) / SubBucketCount + 1;
+	const ULONGLONG SubBucket = (Bucket - 16) % SubBucketCount + SubBucketCount;
+	return ((SubBucket + 1) << Shift) - 1;
+}
+
+void ProfileHistogram::Record(ULONGLONG Value)
+{
+	InterlockedIncrement(&Counts[GetBucket(Value)]);
+	InterlockedIncrement(&Count);
+	InterlockedExchangeAdd64(&Total, (LONGLONG)Value);
+
+	LONGLONG OldMax = Max;
+	while ((LONGLONG)Value > OldMax)
+	{
+		const LONGLONG Prev = InterlockedCompareExchange64(&Max, (LONGLONG)Value, OldMax);
+		if (Prev == OldMax)
+		{
+			break;
+		}
+		OldMax = Prev;
+	}
+}
+
+ULONGLONG ProfileHistogram::GetPercentile(double Percentile) const
+{
+	const DWORD Target = (DWORD)(Count * Percentile / 100.0 + 0.5);
+	if (!Target)
+	{
+		return 0;
+	}
+
+	DWORD Sum = 0;
+	for (UINT x = 0; x < BucketCount; x++)
+	{
+		Sum += Counts[x];
+		if (Sum >= Target)
+		{
+			return (std::min)(GetBucketValue(x), GetMax());
+		}
+	}
+	return GetMax();
+}
+
+void ProfileHistogram::clear()
+{
+	for (UINT x = 0; x < BucketCount; x++)
+	{
+		InterlockedExchange(&Counts[x], 0);
+	}
+	InterlockedExchange(&Count, 0);
+	InterlockedExchange64(&Total, 0);
+	InterlockedExchange64(&Max, 0);
+}
+
+void ProfileStats::Record(PROFILERZONE Zone, ULONGLONG Time)
+{
+	CallTime[Zone].Record(Time);
+	InterlockedExchangeAdd64(&FrameTotal[Zone], (LONGLONG)Time);
+}
+
+void ProfileStats::EndFrame(ULONGLONG Time)
+{
+	Record(ZONE_FRAME, Time);
+	FrameCount++;
+
+	for (UINT x = 0; x < ZONE_COUNT; x++)
+	{
+		FrameTime[x].Record((ULONGLONG)InterlockedExchange64(&FrameTotal[x], 0));
+	}
+}
+
+void ProfileStats::clear()
+{
+	for (UINT x = 0; x < ZONE_COUNT; x++)
+	{
+		CallTime[x].clear();
+		FrameTime[x].clear();
+	}
+	FrameCount = 0;
+}
@@ -0,0 +1,240 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ddraw.h"
+#include "Dllmain\Dllmain.h"
+#include <atomic>
+
+namespace {
+	constexpr LONGLONG WriteInterval = 1000;
+
+	const char* ZoneNames[ZONE_COUNT] = {
+		"Present",
+		"PresentScene",
+		"Flip",
+		"Blt",
+		"CopySurface",
+		"Lock",
+		"Unlock",
+		"GetDC",
+		"ReleaseDC",
+		"Execute",
+		"DrawPrimitive",
+		"DrawIndexedPrimitive",
+		"DrawPrimitiveStrided",
+		"DrawIndexedPrimitiveStrided",
+		"DrawPrimitiveVB",
+		"DrawIndexedPrimitiveVB",
+		"VertexBufferLock",
+		"ProcessVertices",
+		"EndScene",
+		"WaitForVerticalBlank",
+		"Frame",
+	};
+
+	LARGE_INTEGER Frequency = {};
+	LONGLONG LastFrameTime = 0;
+	LONGLONG LastWriteTime = 0;
+	char StatsPath[MAX_PATH] = {};
+	HANDLE hWriteThread = nullptr;
+	HANDLE hWriteEvent = nullptr;
+	HANDLE hStopEvent = nullptr;
+	HANDLE hStoppedEvent = nullptr;
+
+	// Zones record into the active stats. Once a second the Present thread hands the active stats to
+	// the writer thread and records into the other one, so the file is never written from a frame.
+	// Each stats buffer counts the zones recording into it, the writer waits for the count of the
+	// buffer it was handed to drop to zero so a zone that loaded it just before the swap can finish.
+	ProfileStats Stats[2];
+	std::atomic<LONG> RecordCount[2] = {};
+	std::atomic<ProfileStats*> ActiveStats = &Stats[0];
+	ProfileStats* WriteStats = nullptr;
+	std::atomic<bool> IsWritePending = false;
+
+	inline ULONGLONG TicksToNS(LONGLONG Ticks)
+	{
+		return (Ticks > 0) ? (ULONGLONG)Ticks * 1000000000ULL / (ULONGLONG)Frequency.QuadPart : 0;
+	}
+
+	void WriteStatsFile(const ProfileStats& Stats)
+	{
+		FILE* file = nullptr;
+		if (fopen_s(&file, StatsPath, "w") != 0 || !file)
+		{
+			LOG_LIMIT(3, __FUNCTION__ << " Error: failed to open profiler stats file: " << StatsPath);
+			return;
+		}
+
+		fprintf(file, "Zone,Calls,CallsPerFrame,TotalMS,P50US,P99US,MaxUS,FrameP50US,FrameP99US,FrameMaxUS\n");
+		const DWORD FrameCount = Stats.GetFrameCount();
+		for (UINT x = 0; x < ZONE_COUNT; x++)
+		{
+			const ProfileHistogram& Call = Stats.GetCallTime((PROFILERZONE)x);
+			const ProfileHistogram& Frame = Stats.GetFrameTime((PROFILERZONE)x);
+			fprintf(file, "%s,%u,%.2f,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+				ZoneNames[x],
+				Call.GetCount(),
+				FrameCount ? (double)Call.GetCount() / FrameCount : 0.0,
+				Call.GetTotal() / 1000000.0,
+				Call.GetPercentile(50.0) / 1000.0,
+				Call.GetPercentile(99.0) / 1000.0,
+				Call.GetMax() / 1000.0,
+				Frame.GetPercentile(50.0) / 1000.0,
+				Frame.GetPercentile(99.0) / 1000.0,
+				Frame.GetMax() / 1000.0);
+		}
+		fclose(file);
+	}
+
+	DWORD WINAPI WriteThreadFunc(LPVOID)
+	{
+		HANDLE Handles[] = { hStopEvent, hWriteEvent };
+		while (WaitForMultipleObjects(2, Handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+		{
+			const std::atomic<LONG>& Count = RecordCount[WriteStats - Stats];
+			while (Count.load(std::memory_order_acquire))
+			{
+				Sleep(0);
+			}
+
+			WriteStatsFile(*WriteStats);
+
+			WriteStats->clear();
+			IsWritePending.store(false, std::memory_order_release);
+		}
+
+		// Signaled separately since the thread cannot exit while the loader lock is held
+		SetEvent(hStoppedEvent);
+
+		return 0;
+	}
+}
+
+bool Profiler::Enabled = false;
+
+void Profiler::Init()
+{
+	if (Enabled || !Config.DdrawProfiler)
+	{
+		return;
+	}
+
+	QueryPerformanceFrequency(&Frequency);
+	if (!Frequency.QuadPart)
+	{
+		Logging::Log() << __FUNCTION__ << " Error: high resolution counter not available!";
+		return;
+	}
+
+	// Stats are written next to the wrapper module
+	GetModuleFileName(hModule_dll, StatsPath, MAX_PATH);
+	char* pSlash = strrchr(StatsPath, '\\');
+	strcpy_s(pSlash ? pSlash + 1 : StatsPath, MAX_PATH - (pSlash ? pSlash + 1 - StatsPath : 0), "dxwrapper-profile.csv");
+
+	hWriteEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	hStopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	hStoppedEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	if (!hWriteEvent || !hStopEvent || !hStoppedEvent)
+	{
+		Logging::Log() << __FUNCTION__ << " Error: failed to create profiler events!";
+		return;
+	}
+
+	hWriteThread = CreateThread(nullptr, 0, WriteThreadFunc, nullptr, 0, nullptr);
+	if (!hWriteThread)
+	{
+		Logging::Log() << __FUNCTION__ << " Error: failed to create profiler stats thread!";
+		return;
+	}
+	SetThreadPriority(hWriteThread, THREAD_PRIORITY_BELOW_NORMAL);
+
+	Logging::Log() << "Profiler enabled, writing stats to: " << StatsPath;
+
+	LastFrameTime = GetTime();
+	LastWriteTime = LastFrameTime;
+	Enabled = true;
+}
+
+void Profiler::Stop()
+{
+	Enabled = false;
+
+	if (hWriteThread)
+	{
+		SetEvent(hStopEvent);
+
+		HANDLE Handles[] = { hStoppedEvent, hWriteThread };
+		WaitForMultipleObjects(2, Handles, FALSE, 1000);
+
+		CloseHandle(hWriteThread);
+		hWriteThread = nullptr;
+	}
+
+	for (HANDLE* pEvent : { &hWriteEvent, &hStopEvent, &hStoppedEvent })
+	{
+		if (*pEvent)
+		{
+			CloseHandle(*pEvent);
+			*pEvent = nullptr;
+		}
+	}
+}
+
+void Profiler::Record(PROFILERZONE Zone, LONGLONG StartTime)
+{
+	const ULONGLONG Time = TicksToNS(GetTime() - StartTime);
+
+	// Count this zone on the buffer before recording, if the buffer was swapped out in between
+	// then the writer may already have seen a zero count so retry on the new active buffer
+	while (true)
+	{
+		ProfileStats* Active = ActiveStats.load(std::memory_order_seq_cst);
+		std::atomic<LONG>& Count = RecordCount[Active - Stats];
+		Count.fetch_add(1, std::memory_order_seq_cst);
+		if (ActiveStats.load(std::memory_order_seq_cst) == Active)
+		{
+			Active->Record(Zone, Time);
+			Count.fetch_sub(1, std::memory_order_release);
+			return;
+		}
+		Count.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void Profiler::EndFrame()
+{
+	if (!Enabled)
+	{
+		return;
+	}
+
+	const LONGLONG Now = GetTime();
+	ProfileStats* Active = ActiveStats.load(std::memory_order_relaxed);
+	Active->EndFrame(TicksToNS(Now - LastFrameTime));
+	LastFrameTime = Now;
+
+	// Hand the window to the writer thread and start a new one, if the last write is still
+	// running the window keeps growing until the next frame
+	if ((Now - LastWriteTime) * 1000 >= WriteInterval * Frequency.QuadPart && !IsWritePending.load(std::memory_order_acquire))
+	{
+		WriteStats = Active;
+		ActiveStats.store((Active == &Stats[0]) ? &Stats[1] : &Stats[0], std::memory_order_seq_cst);
+		IsWritePending.store(true, std::memory_order_relaxed);
+		SetEvent(hWriteEvent);
+
+		LastWriteTime = Now;
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <windows.h>
+
+// Runtime profiler for the Dd7to9 entry points, enabled with DdrawProfiler. Each zone keeps a
+// log-linear histogram of call times and a per-frame total, and the stats are written to a CSV
+// file about once a second by a background thread so an external viewer can poll it.
+enum PROFILERZONE
+{
+	ZONE_PRESENT,
+	ZONE_PRESENTSCENE,
+	ZONE_FLIP,
+	ZONE_BLT,
+	ZONE_COPYSURFACE,
+	ZONE_LOCK,
+	ZONE_UNLOCK,
+	ZONE_GETDC,
+	ZONE_RELEASEDC,
+	ZONE_EXECUTE,
+	ZONE_DRAWPRIMITIVE,
+	ZONE_DRAWINDEXEDPRIMITIVE,
+	ZONE_DRAWPRIMITIVESTRIDED,
+	ZONE_DRAWINDEXEDPRIMITIVESTRIDED,
+	ZONE_DRAWPRIMITIVEVB,
+	ZONE_DRAWINDEXEDPRIMITIVEVB,
+	ZONE_VERTEXBUFFERLOCK,
+	ZONE_PROCESSVERTICES,
+	ZONE_ENDSCENE,
+	ZONE_WAITFORVERTICALBLANK,
+	ZONE_FRAME,
+	ZONE_COUNT
+};
+
+// Histogram with 8 linear sub-buckets per power of two, so any recorded value is within 12.5%
+// of its bucket. Counts are updated with interlocked operations and can be recorded from any thread.
+class ProfileHistogram
+{
+private:
+	static constexpr UINT SubBucketCount = 8;
+	static constexpr UINT BucketCount = 16 + 60 * SubBucketCount;
+
+	volatile LONG Counts[BucketCount] = {};
+	volatile LONGLONG Total = 0;
+	volatile LONGLONG Max = 0;
+	volatile LONG Count = 0;
+
+	static UINT GetBucket(ULONGLONG Value);
+	static ULONGLONG GetBucketValue(UINT Bucket);
+
+public:
+	void Record(ULONGLONG Value);
+	ULONGLONG GetPercentile(double Percentile) const;
+	ULONGLONG GetMax() const { return (ULONGLONG)Max; }
+	ULONGLONG GetTotal() const { return (ULONGLONG)Total; }
+	DWORD GetCount() const { return (DWORD)Count; }
+	void clear();
+};
+
+// Call time and per-frame time histograms for every zone. Call times are summed per zone until
+// EndFrame folds each zone's total into its frame histogram, zones with no calls fold a zero.
+class ProfileStats
+{
+private:
+	ProfileHistogram CallTime[ZONE_COUNT];
+	ProfileHistogram FrameTime[ZONE_COUNT];
+	volatile LONGLONG FrameTotal[ZONE_COUNT] = {};
+	DWORD FrameCount = 0;
+
+public:
+	void Record(PROFILERZONE Zone, ULONGLONG Time);
+	void EndFrame(ULONGLONG Time);
+	const ProfileHistogram& GetCallTime(PROFILERZONE Zone) const { return CallTime[Zone]; }
+	const ProfileHistogram& GetFrameTime(PROFILERZONE Zone) const { return FrameTime[Zone]; }
+	DWORD GetFrameCount() const { return FrameCount; }
+	void clear();
+};
+
+namespace Profiler
+{
+	extern bool Enabled;
+
+	void Init();
+	void Stop();
+	void Record(PROFILERZONE Zone, LONGLONG StartTime);
+	void EndFrame();
+
+	inline LONGLONG GetTime()
+	{
+		LARGE_INTEGER Time;
+		QueryPerformanceCounter(&Time);
+		return Time.QuadPart;
+	}
+}
+
+class ScopedProfileZone
+{
+private:
+	const PROFILERZONE Zone;
+	const LONGLONG StartTime;
+
+public:
+	ScopedProfileZone(PROFILERZONE Zone) : Zone(Zone), StartTime(Profiler::Enabled ? Profiler::GetTime() : 0) {}
+	~ScopedProfileZone()
+	{
+		if (StartTime)
+		{
+			Profiler::Record(Zone, StartTime);
+		}
+	}
+};
+
+#define PROFILE_ZONE(Zone) ScopedProfileZone ProfileZone(Zone)
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <windows.h>
+#include <intrin.h>
+
+// Fixed size state array with one dirty bit per entry. Flush only visits the entries that were
+// written since the last flush, in index order, so a frame with a few changes does not walk
+// every state.
+template <typename T, UINT Size>
+class DirtyStateArray
+{
+private:
+	static constexpr UINT WordCount = (Size + 31) / 32;
+
+	T Value[Size] = {};
+	DWORD Dirty[WordCount] = {};
+
+public:
+	void Set(UINT Index, const T& NewValue)
+	{
+		Value[Index] = NewValue;
+		Dirty[Index >> 5] |= 1UL << (Index & 31);
+	}
+	const T& Get(UINT Index) const { return Value[Index]; }
+	bool IsDirty(UINT Index) const { return (Dirty[Index >> 5] & (1UL << (Index & 31))) != 0; }
+	void Reset(UINT Index) { Dirty[Index >> 5] &= ~(1UL << (Index & 31)); }
+
+	// Calls Apply(Index, Value) for each dirty entry and keeps the dirty bits
+	template <typename F>
+	void ForEach(F Apply) const
+	{
+		for (UINT x = 0; x < WordCount; x++)
+		{
+			DWORD Mask = Dirty[x];
+			while (Mask)
+			{
+				DWORD Bit;
+				_BitScanForward(&Bit, Mask);
+				Mask &= Mask - 1;
+				Apply(x * 32 + Bit, Value[x * 32 + Bit]);
+			}
+		}
+	}
+
+	// Calls Apply(Index, Value) for each dirty entry and clears the dirty bits
+	template <typename F>
+	void Flush(F Apply)
+	{
+		for (UINT x = 0; x < WordCount; x++)
+		{
+			DWORD Mask = Dirty[x];
+			Dirty[x] = 0;
+			while (Mask)
+			{
+				DWORD Bit;
+				_BitScanForward(&Bit, Mask);
+				Mask &= Mask - 1;
+				Apply(x * 32 + Bit, Value[x * 32 + Bit]);
+			}
+		}
+	}
+	void clear() { memset(Dirty, 0, sizeof(Dirty)); }
+};
+
+// Last value sent to the device for each state. Entries start out unknown and must be invalidated
+// whenever the device state is changed without going through the cache.
+template <UINT Size>
+class AppliedStateArray
+{
+private:
+	static constexpr UINT WordCount = (Size + 31) / 32;
+
+	DWORD Value[Size] = {};
+	DWORD Known[WordCount] = {};
+
+public:
+	// Records the value and returns false if the device already has it
+	bool Update(UINT Index, DWORD NewValue)
+	{
+		const DWORD Bit = 1UL << (Index & 31);
+		if ((Known[Index >> 5] & Bit) && Value[Index] == NewValue)
+		{
+			return false;
+		}
+		Value[Index] = NewValue;
+		Known[Index >> 5] |= Bit;
+		return true;
+	}
+	void Invalidate(UINT Index) { Known[Index >> 5] &= ~(1UL << (Index & 31)); }
+	void clear() { memset(Known, 0, sizeof(Known)); }
+};
@@ -0,0 +1,1136 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SurfaceBlitter.h"
+#include <intrin.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#include <array>
+
+// CPU features are only checked once
+BLITLEVEL GetBlitLevel()
+{
+	static const BLITLEVEL Level = []() {
+		int cpu_info[4] = {};
+		__cpuid(cpu_info, 0);
+		const int MaxFunctionID = cpu_info[0];
+
+		__cpuid(cpu_info, 1);
+		const bool SSE2 = (cpu_info[3] & (1 << 26)) != 0;
+		const bool SSSE3 = (cpu_info[2] & (1 << 9)) != 0;
+		const bool OSXSAVE = (cpu_info[2] & (1 << 27)) != 0;
+		const bool AVX = (cpu_info[2] & (1 << 28)) != 0;
+
+		// Check that the OS saves the YMM registers on context switch
+		bool AVX2 = false;
+		if (MaxFunctionID >= 7 && OSXSAVE && AVX && (_xgetbv(0) & 0x6) == 0x6)
+		{
+			__cpuidex(cpu_info, 7, 0);
+			AVX2 = (cpu_info[1] & (1 << 5)) != 0;
+		}
+
+		return AVX2 ? BLIT_AVX2 : SSSE3 ? BLIT_SSSE3 : SSE2 ? BLIT_SSE2 : BLIT_SCALAR;
+		}();
+
+	return Level;
+}
+
+namespace {
+
+	// Nearest-neighbour stepping with a quotient and a remainder, Pos is always exactly
+	// x * SrcSize / DestSize rounded down so long stretches do not drift
+	struct STRETCHSTEP
+	{
+		DWORD Pos = 0;
+		DWORD Error = 0;
+		DWORD StepInt;
+		DWORD StepRem;
+		DWORD DestSize;
+
+		STRETCHSTEP(LONG SrcSize, LONG DestSize, LONG Start = 0) :
+			Pos((DWORD)((ULONGLONG)Start * (DWORD)SrcSize / (DWORD)DestSize)), Error((DWORD)((ULONGLONG)Start * (DWORD)SrcSize % (DWORD)DestSize)),
+			StepInt((DWORD)SrcSize / (DWORD)DestSize), StepRem((DWORD)SrcSize % (DWORD)DestSize), DestSize((DWORD)DestSize) {}
+
+		void Next()
+		{
+			Pos += StepInt;
+			Error += StepRem;
+			if (Error >= DestSize)
+			{
+				Error -= DestSize;
+				Pos++;
+			}
+		}
+	};
+
+	// Source column for each destination column, mirroring is baked into the table. Columns are for the
+	// Count destination columns from DestStart of the whole stretch, relative to source column SrcStart.
+	void BuildColumnTable(DWORD* ColumnTable, LONG SrcWidth, LONG DestWidth, LONG DestStart, LONG Count, LONG SrcStart, bool IsMirrorLeftRight)
+	{
+		const DWORD MaxColumn = SrcWidth - 1;
+
+		STRETCHSTEP Step(SrcWidth, DestWidth, DestStart);
+		for (LONG x = 0; x < Count; x++, Step.Next())
+		{
+			ColumnTable[x] = (IsMirrorLeftRight ? MaxColumn - Step.Pos : Step.Pos) - SrcStart;
+		}
+	}
+
+	// ******************************
+	// Scalar reference
+	// ******************************
+
+	template <typename T>
+	inline void CopyRowScalar(T* Dest, const T* Src, LONG Width, LONG x, T ColorKey, bool IsColorKey, bool IsMirror)
+	{
+		for (; x < Width; x++)
+		{
+			T PixelColor = Src[IsMirror ? Width - x - 1 : x];
+			if (!IsColorKey || PixelColor != ColorKey)
+			{
+				Dest[x] = PixelColor;
+			}
+		}
+	}
+
+	template <typename T>
+	inline void GatherRowScalar(T* Dest, const T* Src, const DWORD* ColumnTable, LONG Width, LONG x)
+	{
+		for (; x + 4 <= Width; x += 4)
+		{
+			Dest[x] = Src[ColumnTable[x]];
+			Dest[x + 1] = Src[ColumnTable[x + 1]];
+			Dest[x + 2] = Src[ColumnTable[x + 2]];
+			Dest[x + 3] = Src[ColumnTable[x + 3]];
+		}
+		for (; x < Width; x++)
+		{
+			Dest[x] = Src[ColumnTable[x]];
+		}
+	}
+
+	// ******************************
+	// SSE2 kernels for 8, 16 and 32-bit
+	// ******************************
+
+	template <typename T>
+	inline __m128i SetKey128(T ColorKey)
+	{
+		if constexpr (sizeof(T) == 1) return _mm_set1_epi8((char)ColorKey);
+		else if constexpr (sizeof(T) == 2) return _mm_set1_epi16((short)ColorKey);
+		else return _mm_set1_epi32((int)ColorKey);
+	}
+
+	template <typename T>
+	inline __m128i CompareKey128(__m128i Pixels, __m128i Key)
+	{
+		if constexpr (sizeof(T) == 1) return _mm_cmpeq_epi8(Pixels, Key);
+		else if constexpr (sizeof(T) == 2) return _mm_cmpeq_epi16(Pixels, Key);
+		else return _mm_cmpeq_epi32(Pixels, Key);
+	}
+
+	template <typename T>
+	inline __m128i Reverse128(__m128i Pixels)
+	{
+		if constexpr (sizeof(T) == 4)
+		{
+			return _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(0, 1, 2, 3));
+		}
+		else
+		{
+			Pixels = _mm_shufflelo_epi16(Pixels, _MM_SHUFFLE(0, 1, 2, 3));
+			Pixels = _mm_shufflehi_epi16(Pixels, _MM_SHUFFLE(0, 1, 2, 3));
+			Pixels = _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(1, 0, 3, 2));
+			if constexpr (sizeof(T) == 1)
+			{
+				Pixels = _mm_or_si128(_mm_slli_epi16(Pixels, 8), _mm_srli_epi16(Pixels, 8));
+			}
+			return Pixels;
+		}
+	}
+
+	template <typename T>
+	LONG CopyRowSSE2(T* Dest, const T* Src, LONG Width, LONG x, T ColorKey, bool IsColorKey, bool IsMirror)
+	{
+		constexpr LONG Count = sizeof(__m128i) / sizeof(T);
+		const __m128i Key = SetKey128<T>(ColorKey);
+
+		for (; x + Count <= Width; x += Count)
+		{
+			__m128i Pixels = IsMirror ?
+				Reverse128<T>(_mm_loadu_si128((const __m128i*)(Src + Width - x - Count))) :
+				_mm_loadu_si128((const __m128i*)(Src + x));
+
+			if (IsColorKey)
+			{
+				__m128i Mask = CompareKey128<T>(Pixels, Key);
+				int Bits = _mm_movemask_epi8(Mask);
+				if (Bits == 0xFFFF)
+				{
+					continue;	// Every pixel is transparent
+				}
+				if (Bits)
+				{
+					__m128i Existing = _mm_loadu_si128((const __m128i*)(Dest + x));
+					Pixels = _mm_or_si128(_mm_and_si128(Mask, Existing), _mm_andnot_si128(Mask, Pixels));
+				}
+			}
+			_mm_storeu_si128((__m128i*)(Dest + x), Pixels);
+		}
+		return x;
+	}
+
+	// ******************************
+	// AVX2 kernels for 8, 16 and 32-bit
+	// ******************************
+
+	template <typename T>
+	inline __m256i SetKey256(T ColorKey)
+	{
+		if constexpr (sizeof(T) == 1) return _mm256_set1_epi8((char)ColorKey);
+		else if constexpr (sizeof(T) == 2) return _mm256_set1_epi16((short)ColorKey);
+		else return _mm256_set1_epi32((int)ColorKey);
+	}
+
+	template <typename T>
+	inline __m256i CompareKey256(__m256i Pixels, __m256i Key)
+	{
+		if constexpr (sizeof(T) == 1) return _mm256_cmpeq_epi8(Pixels, Key);
+		else if constexpr (sizeof(T) == 2) return _mm256_cmpeq_epi16(Pixels, Key);
+		else return _mm256_cmpeq_epi32(Pixels, Key);
+	}
+
+	template <typename T>
+	inline __m256i Reverse256(__m256i Pixels)
+	{
+		if constexpr (sizeof(T) == 4)
+		{
+			return _mm256_permutevar8x32_epi32(Pixels, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+		}
+		else
+		{
+			const __m256i Mask = (sizeof(T) == 1) ?
+				_mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0) :
+				_mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1, 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+			return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(Pixels, Mask), _MM_SHUFFLE(1, 0, 3, 2));
+		}
+	}
+
+	template <typename T>
+	LONG CopyRowAVX2(T* Dest, const T* Src, LONG Width, LONG x, T ColorKey, bool IsColorKey, bool IsMirror)
+	{
+		constexpr LONG Count = sizeof(__m256i) / sizeof(T);
+		const __m256i Key = SetKey256<T>(ColorKey);
+
+		for (; x + Count <= Width; x += Count)
+		{
+			__m256i Pixels = IsMirror ?
+				Reverse256<T>(_mm256_loadu_si256((const __m256i*)(Src + Width - x - Count))) :
+				_mm256_loadu_si256((const __m256i*)(Src + x));
+
+			if (IsColorKey)
+			{
+				__m256i Mask = CompareKey256<T>(Pixels, Key);
+				DWORD Bits = (DWORD)_mm256_movemask_epi8(Mask);
+				if (Bits == 0xFFFFFFFF)
+				{
+					continue;	// Every pixel is transparent
+				}
+				if (Bits)
+				{
+					__m256i Existing = _mm256_loadu_si256((const __m256i*)(Dest + x));
+					Pixels = _mm256_blendv_epi8(Pixels, Existing, Mask);
+				}
+			}
+			_mm256_storeu_si256((__m256i*)(Dest + x), Pixels);
+		}
+		_mm256_zeroupper();
+		return x;
+	}
+
+	LONG GatherRowAVX2(DWORD* Dest, const DWORD* Src, const DWORD* ColumnTable, LONG Width, LONG x)
+	{
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m256i Index = _mm256_loadu_si256((const __m256i*)(ColumnTable + x));
+			_mm256_storeu_si256((__m256i*)(Dest + x), _mm256_i32gather_epi32((const int*)Src, Index, 4));
+		}
+		_mm256_zeroupper();
+		return x;
+	}
+
+	// ******************************
+	// SSSE3 kernel for 24-bit
+	// ******************************
+
+	// Copies 4 pixels per loop by expanding them to 32-bit lanes, comparing and packing them back.
+	// Each loop loads and stores 16 bytes, so 6 pixels must remain to stay inside the row.
+	LONG CopyRow24SSSE3(TRIBYTE* Dest, const TRIBYTE* Src, LONG Width, LONG x, TRIBYTE ColorKey, bool IsColorKey, bool IsMirror)
+	{
+		const __m128i Expand = IsMirror ?
+			_mm_setr_epi8(13, 14, 15, -1, 10, 11, 12, -1, 7, 8, 9, -1, 4, 5, 6, -1) :
+			_mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i Pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		const __m128i PackMask = _mm_setr_epi8(0, 0, 0, 4, 4, 4, 8, 8, 8, 12, 12, 12, -1, -1, -1, -1);
+		const __m128i Key = _mm_set1_epi32((int)(DWORD)ColorKey);
+		const __m128i AllPixels = _mm_set1_epi32(-1);
+
+		BYTE* DestBytes = (BYTE*)Dest;
+		const BYTE* SrcBytes = (const BYTE*)Src;
+
+		for (; x + 6 <= Width; x += 4)
+		{
+			__m128i Pixels = IsMirror ?
+				_mm_loadu_si128((const __m128i*)(SrcBytes + (Width - x) * 3 - 16)) :
+				_mm_loadu_si128((const __m128i*)(SrcBytes + x * 3));
+			Pixels = _mm_shuffle_epi8(Pixels, Expand);
+
+			// Write mask is set for each pixel that is not transparent
+			__m128i Write = IsColorKey ? _mm_andnot_si128(_mm_cmpeq_epi32(Pixels, Key), AllPixels) : AllPixels;
+			if (IsColorKey && _mm_movemask_epi8(Write) == 0)
+			{
+				continue;	// Every pixel is transparent
+			}
+			Pixels = _mm_shuffle_epi8(Pixels, Pack);
+			Write = _mm_shuffle_epi8(Write, PackMask);
+
+			__m128i Existing = _mm_loadu_si128((const __m128i*)(DestBytes + x * 3));
+			_mm_storeu_si128((__m128i*)(DestBytes + x * 3), _mm_or_si128(_mm_and_si128(Write, Pixels), _mm_andnot_si128(Write, Existing)));
+		}
+		return x;
+	}
+
+	// ******************************
+	// Row dispatch
+	// ******************************
+
+	template <typename T>
+	void CopyRow(T* Dest, const T* Src, LONG Width, T ColorKey, bool IsColorKey, bool IsMirror, BLITLEVEL Level)
+	{
+		if (!IsColorKey && !IsMirror)
+		{
+			memcpy(Dest, Src, Width * sizeof(T));
+			return;
+		}
+
+		LONG x = 0;
+		if constexpr (sizeof(T) == 3)
+		{
+			if (Level >= BLIT_SSSE3)
+			{
+				x = CopyRow24SSSE3(Dest, Src, Width, x, ColorKey, IsColorKey, IsMirror);
+			}
+		}
+		else
+		{
+			if (Level == BLIT_AVX2)
+			{
+				x = CopyRowAVX2<T>(Dest, Src, Width, x, ColorKey, IsColorKey, IsMirror);
+			}
+			if (Level >= BLIT_SSE2)
+			{
+				x = CopyRowSSE2<T>(Dest, Src, Width, x, ColorKey, IsColorKey, IsMirror);
+			}
+		}
+		CopyRowScalar<T>(Dest, Src, Width, x, ColorKey, IsColorKey, IsMirror);
+	}
+
+	template <typename T>
+	void GatherRow(T* Dest, const T* Src, const DWORD* ColumnTable, LONG Width, BLITLEVEL Level)
+	{
+		LONG x = 0;
+		if constexpr (sizeof(T) == 4)
+		{
+			if (Level == BLIT_AVX2)
+			{
+				x = GatherRowAVX2((DWORD*)Dest, (const DWORD*)Src, ColumnTable, Width, x);
+			}
+		}
+		GatherRowScalar<T>(Dest, Src, ColumnTable, Width, x);
+	}
+}
+
+// Simple copy with ColorKey and Mirroring
+template void SimpleColorKeyCopy<BYTE>(BYTE ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT SrcPitch, INT DestPitch, LONG DestRectWidth, LONG DestRectHeight, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level);
+template void SimpleColorKeyCopy<WORD>(WORD ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT SrcPitch, INT DestPitch, LONG DestRectWidth, LONG DestRectHeight, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level);
+template void SimpleColorKeyCopy<TRIBYTE>(TRIBYTE ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT SrcPitch, INT DestPitch, LONG DestRectWidth, LONG DestRectHeight, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level);
+template void SimpleColorKeyCopy<DWORD>(DWORD ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT SrcPitch, INT DestPitch, LONG DestRectWidth, LONG DestRectHeight, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level);
+template <typename T>
+void SimpleColorKeyCopy(T ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT SrcPitch, INT DestPitch, LONG DestRectWidth, LONG DestRectHeight, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level)
+{
+	for (LONG y = 0; y < DestRectHeight; y++)
+	{
+		CopyRow<T>(reinterpret_cast<T*>(DestBuffer), reinterpret_cast<T*>(SrcBuffer), DestRectWidth, ColorKey, IsColorKey, IsMirrorLeftRight, Level);
+		SrcBuffer += SrcPitch;
+		DestBuffer += DestPitch;
+	}
+}
+
+// Overlapping copy within the same surface
+template void OverlapCopy<BYTE>(BYTE ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT Pitch, LONG DestRectWidth, LONG DestRectHeight, LONG OffsetY, BYTE* RowBuffer, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level);
+template void OverlapCopy<WORD>(WORD ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT Pitch, LONG DestRectWidth, LONG DestRectHeight, LONG OffsetY, BYTE* RowBuffer, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level);
+template void OverlapCopy<TRIBYTE>(TRIBYTE ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT Pitch, LONG DestRectWidth, LONG DestRectHeight, LONG OffsetY, BYTE* RowBuffer, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level);
+template void OverlapCopy<DWORD>(DWORD ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT Pitch, LONG DestRectWidth, LONG DestRectHeight, LONG OffsetY, BYTE* RowBuffer, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level);
+template <typename T>
+void OverlapCopy(T ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT Pitch, LONG DestRectWidth, LONG DestRectHeight, LONG OffsetY, BYTE* RowBuffer, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level)
+{
+	const size_t RowSize = DestRectWidth * sizeof(T);
+
+	// Copy bottom-up when moving down so each source row is read before it is overwritten
+	if (OffsetY > 0)
+	{
+		SrcBuffer += Pitch * (DestRectHeight - 1);
+		DestBuffer += Pitch * (DestRectHeight - 1);
+		Pitch = -Pitch;
+	}
+
+	for (LONG y = 0; y < DestRectHeight; y++)
+	{
+		// Source and destination share the same row
+		if (OffsetY == 0)
+		{
+			if (!IsColorKey && !IsMirrorLeftRight)
+			{
+				memmove(DestBuffer, SrcBuffer, RowSize);
+			}
+			else
+			{
+				memcpy(RowBuffer, SrcBuffer, RowSize);
+				CopyRow<T>(reinterpret_cast<T*>(DestBuffer), reinterpret_cast<T*>(RowBuffer), DestRectWidth, ColorKey, IsColorKey, IsMirrorLeftRight, Level);
+			}
+		}
+		else
+		{
+			CopyRow<T>(reinterpret_cast<T*>(DestBuffer), reinterpret_cast<T*>(SrcBuffer), DestRectWidth, ColorKey, IsColorKey, IsMirrorLeftRight, Level);
+		}
+		SrcBuffer += Pitch;
+		DestBuffer += Pitch;
+	}
+}
+
+// Copy memory (complex)
+template void ComplexCopy<BYTE>(BYTE ColorKey, D3DLOCKED_RECT SrcLockRect, D3DLOCKED_RECT DestLockRect, LONG SrcRectWidth, LONG SrcRectHeight, LONG DestRectWidth, LONG DestRectHeight, BYTE* ScratchBuffer, bool IsColorKey, bool IsMirrorUpDown, bool IsMirrorLeftRight, D3DLOCKED_RECT BandLockRect, LONG BandTop, LONG BandHeight, const STRETCHPART* pPart, BLITLEVEL Level);
+template void ComplexCopy<WORD>(WORD ColorKey, D3DLOCKED_RECT SrcLockRect, D3DLOCKED_RECT DestLockRect, LONG SrcRectWidth, LONG SrcRectHeight, LONG DestRectWidth, LONG DestRectHeight, BYTE* ScratchBuffer, bool IsColorKey, bool IsMirrorUpDown, bool IsMirrorLeftRight, D3DLOCKED_RECT BandLockRect, LONG BandTop, LONG BandHeight, const STRETCHPART* pPart, BLITLEVEL Level);
+template void ComplexCopy<TRIBYTE>(TRIBYTE ColorKey, D3DLOCKED_RECT SrcLockRect, D3DLOCKED_RECT DestLockRect, LONG SrcRectWidth, LONG SrcRectHeight, LONG DestRectWidth, LONG DestRectHeight, BYTE* ScratchBuffer, bool IsColorKey, bool IsMirrorUpDown, bool IsMirrorLeftRight, D3DLOCKED_RECT BandLockRect, LONG BandTop, LONG BandHeight, const STRETCHPART* pPart, BLITLEVEL Level);
+template void ComplexCopy<DWORD>(DWORD ColorKey, D3DLOCKED_RECT SrcLockRect, D3DLOCKED_RECT DestLockRect, LONG SrcRectWidth, LONG SrcRectHeight, LONG DestRectWidth, LONG DestRectHeight, BYTE* ScratchBuffer, bool IsColorKey, bool IsMirrorUpDown, bool IsMirrorLeftRight, D3DLOCKED_RECT BandLockRect, LONG BandTop, LONG BandHeight, const STRETCHPART* pPart, BLITLEVEL Level);
+template <typename T>
+void ComplexCopy(T ColorKey, D3DLOCKED_RECT SrcLockRect, D3DLOCKED_RECT DestLockRect, LONG SrcRectWidth, LONG SrcRectHeight, LONG DestRectWidth, LONG DestRectHeight, BYTE* ScratchBuffer, bool IsColorKey, bool IsMirrorUpDown, bool IsMirrorLeftRight, D3DLOCKED_RECT BandLockRect, LONG BandTop, LONG BandHeight, const STRETCHPART* pPart, BLITLEVEL Level)
+{
+	if (SrcRectWidth <= 0 || SrcRectHeight <= 0 || DestRectWidth <= 0 || DestRectHeight <= 0)
+	{
+		return;
+	}
+
+	// Without a part the rects are the whole stretch
+	STRETCHPART Part = pPart ? *pPart : STRETCHPART{ SrcRectWidth, SrcRectHeight, DestRectWidth, DestRectHeight, 0, 0 };
+	if (Part.SrcWidth <= 0 || Part.SrcHeight <= 0 || Part.DestWidth <= 0 || Part.DestHeight <= 0)
+	{
+		return;
+	}
+
+	// First source column and row of the part, the source rect of a part starts there
+	LONG SrcLeft = 0, SrcRight = 0, SrcTop = 0, SrcBottom = 0;
+	if (pPart)
+	{
+		GetStretchSrcSpan(Part.SrcWidth, Part.DestWidth, Part.DestLeft, Part.DestLeft + DestRectWidth, IsMirrorLeftRight, SrcLeft, SrcRight);
+		GetStretchSrcSpan(Part.SrcHeight, Part.DestHeight, Part.DestTop, Part.DestTop + DestRectHeight, IsMirrorUpDown, SrcTop, SrcBottom);
+	}
+
+	// Column table followed by the stretched source row, only rebuilt when the source row changes
+	DWORD* ColumnTable = reinterpret_cast<DWORD*>(ScratchBuffer);
+	T* RowBuffer = reinterpret_cast<T*>(ColumnTable + DestRectWidth);
+	BuildColumnTable(ColumnTable, Part.SrcWidth, Part.DestWidth, Part.DestLeft, DestRectWidth, SrcLeft, IsMirrorLeftRight);
+	LONG LastSrcRow = -1;
+
+	STRETCHSTEP StepY(Part.SrcHeight, Part.DestHeight, Part.DestTop);
+
+	BYTE* DestBuffer = (BYTE*)DestLockRect.pBits;
+
+	for (LONG y = 0; y < DestRectHeight; y++, StepY.Next())
+	{
+		LONG sy = (LONG)StepY.Pos;
+		LONG SrcRow = (IsMirrorUpDown ? Part.SrcHeight - sy - 1 : sy) - SrcTop;
+
+		if (SrcRow != LastSrcRow)
+		{
+			// Rows that overlap the destination are read from the staged band
+			BYTE* SrcBuffer = (BandLockRect.pBits && SrcRow >= BandTop && SrcRow < BandTop + BandHeight) ?
+				(BYTE*)BandLockRect.pBits + BandLockRect.Pitch * (SrcRow - BandTop) :
+				(BYTE*)SrcLockRect.pBits + SrcLockRect.Pitch * SrcRow;
+			GatherRow<T>(RowBuffer, reinterpret_cast<T*>(SrcBuffer), ColumnTable, DestRectWidth, Level);
+			LastSrcRow = SrcRow;
+		}
+
+		CopyRow<T>(reinterpret_cast<T*>(DestBuffer), RowBuffer, DestRectWidth, ColorKey, IsColorKey, false, Level);
+		DestBuffer += DestLockRect.Pitch;
+	}
+}
+
+namespace {
+	// ******************************
+	// Scalar pixel format conversion
+	// ******************************
+
+	void ConvertRow_X8R8G8B8_A4R4G4B4(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const DWORD*)pSrc)[x];
+			((WORD*)pDest)[x] = (WORD)(D3DFMT_A8R8G8B8_TO_A4R4G4B4(Pixel) | AlphaMask);
+		}
+	}
+
+	void ConvertRow_A4R4G4B4_A8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const WORD*)pSrc)[x];
+			((DWORD*)pDest)[x] = ((((Pixel >> 12) & 0xF) * 17 << 24) + (((Pixel >> 8) & 0xF) * 17 << 16) + (((Pixel >> 4) & 0xF) * 17 << 8) + ((Pixel & 0xF) * 17)) | AlphaMask;
+		}
+	}
+
+	void ConvertRow_X4R4G4B4_X8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const WORD*)pSrc)[x];
+			((DWORD*)pDest)[x] = 0xFF000000 + (((Pixel >> 8) & 0xF) * 17 << 16) + (((Pixel >> 4) & 0xF) * 17 << 8) + ((Pixel & 0xF) * 17);
+		}
+	}
+
+	void ConvertRow_R5G6B5_X8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		for (; x < Width; x++)
+		{
+			WORD Pixel = ((const WORD*)pSrc)[x];
+			((DWORD*)pDest)[x] = D3DFMT_R5G6B5_TO_X8R8G8B8(Pixel) | AlphaMask;
+		}
+	}
+
+	void ConvertRow_X8R8G8B8_R5G6B5(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const DWORD*)pSrc)[x];
+			((WORD*)pDest)[x] = (WORD)(((Pixel >> 8) & 0xF800) | ((Pixel >> 5) & 0x07E0) | ((Pixel >> 3) & 0x001F));
+		}
+	}
+
+	void ConvertRow_A1R5G5B5_A8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const WORD*)pSrc)[x];
+			((DWORD*)pDest)[x] = ((Pixel & 0x8000) ? 0xFF000000 : 0) | ((Pixel & 0x7C00) << 9) | ((Pixel & 0x03E0) << 6) | ((Pixel & 0x001F) << 3);
+		}
+	}
+
+	void ConvertRow_X1R5G5B5_X8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const WORD*)pSrc)[x];
+			((DWORD*)pDest)[x] = 0xFF000000 | ((Pixel & 0x7C00) << 9) | ((Pixel & 0x03E0) << 6) | ((Pixel & 0x001F) << 3);
+		}
+	}
+
+	void ConvertRow_A8R8G8B8_A1R5G5B5(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const DWORD*)pSrc)[x];
+			((WORD*)pDest)[x] = (WORD)(((Pixel >> 16) & 0x8000) | ((Pixel >> 9) & 0x7C00) | ((Pixel >> 6) & 0x03E0) | ((Pixel >> 3) & 0x001F) | AlphaMask);
+		}
+	}
+
+	void ConvertRow_X8R8G8B8_R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x < Width; x++)
+		{
+			((TRIBYTE*)pDest)[x] = *(const TRIBYTE*)&((const DWORD*)pSrc)[x];
+		}
+	}
+
+	void ConvertRow_X8R8G8B8_B8G8R8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const DWORD*)pSrc)[x];
+			((TRIBYTE*)pDest)[x] = (TRIBYTE)D3DFMT_X8R8G8B8_TO_B8G8R8(Pixel);
+		}
+	}
+
+	void ConvertRow_R8G8B8_X8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x < Width; x++)
+		{
+			((DWORD*)pDest)[x] = 0xFF000000 | (DWORD)((const TRIBYTE*)pSrc)[x];
+		}
+	}
+
+	void ConvertRow_B8G8R8_X8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = (DWORD)((const TRIBYTE*)pSrc)[x];
+			((DWORD*)pDest)[x] = 0xFF000000 | D3DFMT_X8R8G8B8_TO_B8G8R8(Pixel);
+		}
+	}
+
+	// Swaps the red and blue channels, used for both directions
+	void ConvertRow_A8R8G8B8_A8B8G8R8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const DWORD*)pSrc)[x];
+			((DWORD*)pDest)[x] = D3DFMT_A8R8G8B8_TO_A8B8G8R8(Pixel) | AlphaMask;
+		}
+	}
+
+	// ******************************
+	// SSE2 pixel format conversion
+	// ******************************
+
+	// Packs the low 16 bits of each 32-bit lane into 16-bit lanes
+	inline __m128i Pack32To16(__m128i Lo, __m128i Hi)
+	{
+		Lo = _mm_srai_epi32(_mm_slli_epi32(Lo, 16), 16);
+		Hi = _mm_srai_epi32(_mm_slli_epi32(Hi, 16), 16);
+		return _mm_packs_epi32(Lo, Hi);
+	}
+
+	// Divides each channel by 17, the same as the scalar macro
+	inline __m128i Pack8888To4444(__m128i Pixels)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Div17 = _mm_set1_epi16(3856);		// (x * 3856) >> 16 == x / 17 for 0-255
+
+		__m128i Lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(Pixels, Zero), Div17);
+		__m128i Hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(Pixels, Zero), Div17);
+		__m128i Nibbles = _mm_packus_epi16(Lo, Hi);
+
+		// Merge nibbles: b | g << 4 in byte 0 and r | a << 4 in byte 2
+		Nibbles = _mm_and_si128(_mm_or_si128(Nibbles, _mm_srli_epi32(Nibbles, 4)), _mm_set1_epi32(0x00FF00FF));
+		return _mm_or_si128(Nibbles, _mm_srli_epi32(Nibbles, 8));
+	}
+
+	LONG ConvertRowSSE2_X8R8G8B8_A4R4G4B4(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		const __m128i Alpha = _mm_set1_epi16((short)AlphaMask);
+
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m128i Lo = Pack8888To4444(_mm_loadu_si128((const __m128i*)(pSrc + x * 4)));
+			__m128i Hi = Pack8888To4444(_mm_loadu_si128((const __m128i*)(pSrc + x * 4 + 16)));
+			_mm_storeu_si128((__m128i*)(pDest + x * 2), _mm_or_si128(Pack32To16(Lo, Hi), Alpha));
+		}
+		return x;
+	}
+
+	inline __m128i Unpack4444To8888(__m128i Pixels, __m128i Alpha)
+	{
+		__m128i Spread = _mm_or_si128(
+			_mm_or_si128(_mm_and_si128(Pixels, _mm_set1_epi32(0x000F)), _mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0x00F0)), 4)),
+			_mm_or_si128(_mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0x0F00)), 8), _mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0xF000)), 12)));
+		return _mm_or_si128(_mm_or_si128(Spread, _mm_slli_epi32(Spread, 4)), Alpha);
+	}
+
+	template <bool IsAlpha>
+	LONG ConvertRowSSE2_4444_8888(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Alpha = _mm_set1_epi32((int)((IsAlpha ? 0 : 0xFF000000) | AlphaMask));
+
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m128i Pixels = _mm_loadu_si128((const __m128i*)(pSrc + x * 2));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4), Unpack4444To8888(_mm_unpacklo_epi16(Pixels, Zero), Alpha));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4 + 16), Unpack4444To8888(_mm_unpackhi_epi16(Pixels, Zero), Alpha));
+		}
+		return x;
+	}
+
+	inline __m128i Unpack565To8888(__m128i Pixels)
+	{
+		return _mm_or_si128(
+			_mm_or_si128(_mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0xF800)), 8), _mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0x07E0)), 5)),
+			_mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0x001F)), 3));
+	}
+
+	LONG ConvertRowSSE2_R5G6B5_X8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Alpha = _mm_set1_epi32((int)AlphaMask);
+
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m128i Pixels = _mm_loadu_si128((const __m128i*)(pSrc + x * 2));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4), _mm_or_si128(Unpack565To8888(_mm_unpacklo_epi16(Pixels, Zero)), Alpha));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4 + 16), _mm_or_si128(Unpack565To8888(_mm_unpackhi_epi16(Pixels, Zero)), Alpha));
+		}
+		return x;
+	}
+
+	inline __m128i Pack8888To565(__m128i Pixels)
+	{
+		return _mm_or_si128(
+			_mm_or_si128(_mm_and_si128(_mm_srli_epi32(Pixels, 8), _mm_set1_epi32(0xF800)), _mm_and_si128(_mm_srli_epi32(Pixels, 5), _mm_set1_epi32(0x07E0))),
+			_mm_and_si128(_mm_srli_epi32(Pixels, 3), _mm_set1_epi32(0x001F)));
+	}
+
+	LONG ConvertRowSSE2_X8R8G8B8_R5G6B5(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m128i Lo = Pack8888To565(_mm_loadu_si128((const __m128i*)(pSrc + x * 4)));
+			__m128i Hi = Pack8888To565(_mm_loadu_si128((const __m128i*)(pSrc + x * 4 + 16)));
+			_mm_storeu_si128((__m128i*)(pDest + x * 2), Pack32To16(Lo, Hi));
+		}
+		return x;
+	}
+
+	template <bool IsAlpha>
+	inline __m128i Unpack1555To8888(__m128i Pixels)
+	{
+		__m128i Alpha = IsAlpha ?
+			_mm_and_si128(_mm_srai_epi32(_mm_slli_epi32(Pixels, 16), 31), _mm_set1_epi32((int)0xFF000000)) :
+			_mm_set1_epi32((int)0xFF000000);
+		return _mm_or_si128(
+			_mm_or_si128(_mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0x7C00)), 9), _mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0x03E0)), 6)),
+			_mm_or_si128(_mm_slli_epi32(_mm_and_si128(Pixels, _mm_set1_epi32(0x001F)), 3), Alpha));
+	}
+
+	template <bool IsAlpha>
+	LONG ConvertRowSSE2_1555_8888(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m128i Pixels = _mm_loadu_si128((const __m128i*)(pSrc + x * 2));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4), Unpack1555To8888<IsAlpha>(_mm_unpacklo_epi16(Pixels, Zero)));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4 + 16), Unpack1555To8888<IsAlpha>(_mm_unpackhi_epi16(Pixels, Zero)));
+		}
+		return x;
+	}
+
+	inline __m128i Pack8888To1555(__m128i Pixels)
+	{
+		return _mm_or_si128(
+			_mm_or_si128(_mm_and_si128(_mm_srli_epi32(Pixels, 16), _mm_set1_epi32(0x8000)), _mm_and_si128(_mm_srli_epi32(Pixels, 9), _mm_set1_epi32(0x7C00))),
+			_mm_or_si128(_mm_and_si128(_mm_srli_epi32(Pixels, 6), _mm_set1_epi32(0x03E0)), _mm_and_si128(_mm_srli_epi32(Pixels, 3), _mm_set1_epi32(0x001F))));
+	}
+
+	LONG ConvertRowSSE2_A8R8G8B8_A1R5G5B5(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		const __m128i Alpha = _mm_set1_epi16((short)AlphaMask);
+
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m128i Lo = Pack8888To1555(_mm_loadu_si128((const __m128i*)(pSrc + x * 4)));
+			__m128i Hi = Pack8888To1555(_mm_loadu_si128((const __m128i*)(pSrc + x * 4 + 16)));
+			_mm_storeu_si128((__m128i*)(pDest + x * 2), _mm_or_si128(Pack32To16(Lo, Hi), Alpha));
+		}
+		return x;
+	}
+
+	LONG ConvertRowSSE2_A8R8G8B8_A8B8G8R8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask)
+	{
+		const __m128i MaskAG = _mm_set1_epi32((int)0xFF00FF00);
+		const __m128i MaskB = _mm_set1_epi32(0x000000FF);
+		const __m128i Alpha = _mm_set1_epi32((int)AlphaMask);
+
+		for (; x + 4 <= Width; x += 4)
+		{
+			__m128i Pixels = _mm_loadu_si128((const __m128i*)(pSrc + x * 4));
+			__m128i RB = _mm_andnot_si128(MaskAG, Pixels);
+			RB = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(RB, MaskB), 16), _mm_srli_epi32(RB, 16));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4), _mm_or_si128(_mm_or_si128(_mm_and_si128(Pixels, MaskAG), RB), Alpha));
+		}
+		return x;
+	}
+
+	// ******************************
+	// SSSE3 pixel format conversion
+	// ******************************
+
+	// Compacts 16 pixels from 32-bit to 24-bit using three 16 byte stores
+	LONG ConvertRowSSSE3_8888_888(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, __m128i Shuffle)
+	{
+		for (; x + 16 <= Width; x += 16)
+		{
+			__m128i c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + x * 4)), Shuffle);
+			__m128i c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + x * 4 + 16)), Shuffle);
+			__m128i c2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + x * 4 + 32)), Shuffle);
+			__m128i c3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(pSrc + x * 4 + 48)), Shuffle);
+			_mm_storeu_si128((__m128i*)(pDest + x * 3), _mm_or_si128(c0, _mm_slli_si128(c1, 12)));
+			_mm_storeu_si128((__m128i*)(pDest + x * 3 + 16), _mm_or_si128(_mm_srli_si128(c1, 4), _mm_slli_si128(c2, 8)));
+			_mm_storeu_si128((__m128i*)(pDest + x * 3 + 32), _mm_or_si128(_mm_srli_si128(c2, 8), _mm_slli_si128(c3, 4)));
+		}
+		return x;
+	}
+
+	LONG ConvertRowSSSE3_X8R8G8B8_R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		return ConvertRowSSSE3_8888_888(pDest, pSrc, Width, x, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+	}
+
+	LONG ConvertRowSSSE3_X8R8G8B8_B8G8R8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		return ConvertRowSSSE3_8888_888(pDest, pSrc, Width, x, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	}
+
+	// Expands 16 pixels from 24-bit to 32-bit using three 16 byte loads
+	LONG ConvertRowSSSE3_888_8888(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, __m128i Shuffle)
+	{
+		const __m128i Alpha = _mm_set1_epi32((int)0xFF000000);
+
+		for (; x + 16 <= Width; x += 16)
+		{
+			__m128i i0 = _mm_loadu_si128((const __m128i*)(pSrc + x * 3));
+			__m128i i1 = _mm_loadu_si128((const __m128i*)(pSrc + x * 3 + 16));
+			__m128i i2 = _mm_loadu_si128((const __m128i*)(pSrc + x * 3 + 32));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4), _mm_or_si128(_mm_shuffle_epi8(i0, Shuffle), Alpha));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4 + 16), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(i1, i0, 12), Shuffle), Alpha));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4 + 32), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(i2, i1, 8), Shuffle), Alpha));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4 + 48), _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(i2, 4), Shuffle), Alpha));
+		}
+		return x;
+	}
+
+	LONG ConvertRowSSSE3_R8G8B8_X8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		return ConvertRowSSSE3_888_8888(pDest, pSrc, Width, x, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+	}
+
+	LONG ConvertRowSSSE3_B8G8R8_X8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD)
+	{
+		return ConvertRowSSSE3_888_8888(pDest, pSrc, Width, x, _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1));
+	}
+
+	// ******************************
+	// Conversion registry
+	// ******************************
+
+	// Converters OR AlphaMask into each stored pixel, it forces the alpha bits when the source has none
+	typedef void(*CONVERTROWSCALAR)(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask);
+	typedef LONG(*CONVERTROWSIMD)(BYTE* pDest, const BYTE* pSrc, LONG Width, LONG x, DWORD AlphaMask);
+
+	struct PIXELCONVERTER
+	{
+		D3DFORMAT SrcFormat;
+		D3DFORMAT DestFormat;
+		CONVERTROWSCALAR Scalar;
+		CONVERTROWSIMD SSE2;
+		CONVERTROWSIMD SSSE3;
+	};
+
+	const PIXELCONVERTER PixelConverters[] =
+	{
+		{ D3DFMT_A8R8G8B8, D3DFMT_A4R4G4B4, ConvertRow_X8R8G8B8_A4R4G4B4, ConvertRowSSE2_X8R8G8B8_A4R4G4B4, nullptr },
+		{ D3DFMT_X8R8G8B8, D3DFMT_X4R4G4B4, ConvertRow_X8R8G8B8_A4R4G4B4, ConvertRowSSE2_X8R8G8B8_A4R4G4B4, nullptr },
+		{ D3DFMT_A4R4G4B4, D3DFMT_A8R8G8B8, ConvertRow_A4R4G4B4_A8R8G8B8, ConvertRowSSE2_4444_8888<true>, nullptr },
+		{ D3DFMT_X4R4G4B4, D3DFMT_X8R8G8B8, ConvertRow_X4R4G4B4_X8R8G8B8, ConvertRowSSE2_4444_8888<false>, nullptr },
+		{ D3DFMT_R5G6B5, D3DFMT_X8R8G8B8, ConvertRow_R5G6B5_X8R8G8B8, ConvertRowSSE2_R5G6B5_X8R8G8B8, nullptr },
+		{ D3DFMT_X8R8G8B8, D3DFMT_R5G6B5, ConvertRow_X8R8G8B8_R5G6B5, ConvertRowSSE2_X8R8G8B8_R5G6B5, nullptr },
+		{ D3DFMT_A1R5G5B5, D3DFMT_A8R8G8B8, ConvertRow_A1R5G5B5_A8R8G8B8, ConvertRowSSE2_1555_8888<true>, nullptr },
+		{ D3DFMT_X1R5G5B5, D3DFMT_X8R8G8B8, ConvertRow_X1R5G5B5_X8R8G8B8, ConvertRowSSE2_1555_8888<false>, nullptr },
+		{ D3DFMT_A8R8G8B8, D3DFMT_A1R5G5B5, ConvertRow_A8R8G8B8_A1R5G5B5, ConvertRowSSE2_A8R8G8B8_A1R5G5B5, nullptr },
+		{ D3DFMT_X8R8G8B8, D3DFMT_X1R5G5B5, ConvertRow_A8R8G8B8_A1R5G5B5, ConvertRowSSE2_A8R8G8B8_A1R5G5B5, nullptr },
+		{ D3DFMT_X8R8G8B8, D3DFMT_R8G8B8, ConvertRow_X8R8G8B8_R8G8B8, nullptr, ConvertRowSSSE3_X8R8G8B8_R8G8B8 },
+		{ D3DFMT_X8R8G8B8, D3DFMT_B8G8R8, ConvertRow_X8R8G8B8_B8G8R8, nullptr, ConvertRowSSSE3_X8R8G8B8_B8G8R8 },
+		{ D3DFMT_R8G8B8, D3DFMT_X8R8G8B8, ConvertRow_R8G8B8_X8R8G8B8, nullptr, ConvertRowSSSE3_R8G8B8_X8R8G8B8 },
+		{ D3DFMT_B8G8R8, D3DFMT_X8R8G8B8, ConvertRow_B8G8R8_X8R8G8B8, nullptr, ConvertRowSSSE3_B8G8R8_X8R8G8B8 },
+		{ D3DFMT_A8R8G8B8, D3DFMT_A8B8G8R8, ConvertRow_A8R8G8B8_A8B8G8R8, ConvertRowSSE2_A8R8G8B8_A8B8G8R8, nullptr },
+		{ D3DFMT_A8B8G8R8, D3DFMT_A8R8G8B8, ConvertRow_A8R8G8B8_A8B8G8R8, ConvertRowSSE2_A8R8G8B8_A8B8G8R8, nullptr },
+		{ D3DFMT_X8R8G8B8, D3DFMT_X8B8G8R8, ConvertRow_A8R8G8B8_A8B8G8R8, ConvertRowSSE2_A8R8G8B8_A8B8G8R8, nullptr },
+		{ D3DFMT_X8B8G8R8, D3DFMT_X8R8G8B8, ConvertRow_A8R8G8B8_A8B8G8R8, ConvertRowSSE2_A8R8G8B8_A8B8G8R8, nullptr },
+	};
+
+	// X and A formats share the same conversion when there is no exact match
+	D3DFORMAT GetAlphaFormat(D3DFORMAT Format)
+	{
+		switch ((DWORD)Format)
+		{
+		case D3DFMT_X8R8G8B8:
+			return D3DFMT_A8R8G8B8;
+		case D3DFMT_X8B8G8R8:
+			return D3DFMT_A8B8G8R8;
+		case D3DFMT_X1R5G5B5:
+			return D3DFMT_A1R5G5B5;
+		case D3DFMT_X4R4G4B4:
+			return D3DFMT_A4R4G4B4;
+		default:
+			return Format;
+		}
+	}
+
+	const PIXELCONVERTER* FindPixelConverter(D3DFORMAT SrcFormat, D3DFORMAT DestFormat)
+	{
+		for (const auto& Entry : PixelConverters)
+		{
+			if (Entry.SrcFormat == SrcFormat && Entry.DestFormat == DestFormat)
+			{
+				return &Entry;
+			}
+		}
+		// Prefer the entry for the same source format so undefined X bits are not read as alpha
+		for (const auto& Entry : PixelConverters)
+		{
+			if (Entry.SrcFormat == SrcFormat && GetAlphaFormat(Entry.DestFormat) == GetAlphaFormat(DestFormat))
+			{
+				return &Entry;
+			}
+		}
+		for (const auto& Entry : PixelConverters)
+		{
+			if (GetAlphaFormat(Entry.SrcFormat) == GetAlphaFormat(SrcFormat) && GetAlphaFormat(Entry.DestFormat) == GetAlphaFormat(DestFormat))
+			{
+				return &Entry;
+			}
+		}
+		return nullptr;
+	}
+
+	// Alpha bits to set when a source without alpha is converted to a format with alpha
+	DWORD GetForcedAlphaMask(D3DFORMAT SrcFormat, D3DFORMAT DestFormat)
+	{
+		switch ((DWORD)SrcFormat)
+		{
+		case D3DFMT_A8R8G8B8:
+		case D3DFMT_A8B8G8R8:
+		case D3DFMT_A1R5G5B5:
+		case D3DFMT_A4R4G4B4:
+			return 0;
+		}
+		switch ((DWORD)DestFormat)
+		{
+		case D3DFMT_A8R8G8B8:
+		case D3DFMT_A8B8G8R8:
+			return 0xFF000000;
+		case D3DFMT_A1R5G5B5:
+			return 0x8000;
+		case D3DFMT_A4R4G4B4:
+			return 0xF000;
+		default:
+			return 0;
+		}
+	}
+
+	// Every supported format is below this, so the converter for a format pair is a table lookup
+	constexpr DWORD ConverterFormatCount = D3DFMT_X8B8G8R8 + 1;
+
+	struct PIXELCONVERSION
+	{
+		const PIXELCONVERTER* Converter;
+		DWORD AlphaMask;
+	};
+
+	const PIXELCONVERSION* GetPixelConversion(D3DFORMAT SrcFormat, D3DFORMAT DestFormat)
+	{
+		static const auto Table = []() {
+			std::array<std::array<PIXELCONVERSION, ConverterFormatCount>, ConverterFormatCount> Entries = {};
+			for (DWORD Src = 0; Src < ConverterFormatCount; Src++)
+			{
+				for (DWORD Dest = 0; Dest < ConverterFormatCount; Dest++)
+				{
+					Entries[Src][Dest].Converter = FindPixelConverter((D3DFORMAT)Src, (D3DFORMAT)Dest);
+					Entries[Src][Dest].AlphaMask = GetForcedAlphaMask((D3DFORMAT)Src, (D3DFORMAT)Dest);
+				}
+			}
+			return Entries;
+		}();
+
+		if ((DWORD)SrcFormat >= ConverterFormatCount || (DWORD)DestFormat >= ConverterFormatCount || !Table[SrcFormat][DestFormat].Converter)
+		{
+			return nullptr;
+		}
+		return &Table[SrcFormat][DestFormat];
+	}
+}
+
+bool IsPixelConversionSupported(D3DFORMAT SrcFormat, D3DFORMAT DestFormat)
+{
+	return GetPixelConversion(SrcFormat, DestFormat) != nullptr;
+}
+
+bool ConvertPixelRect(BYTE* pDest, INT DestPitch, D3DFORMAT DestFormat, const BYTE* pSrc, INT SrcPitch, D3DFORMAT SrcFormat, LONG Width, LONG Height, BLITLEVEL Level)
+{
+	const PIXELCONVERSION* Conversion = GetPixelConversion(SrcFormat, DestFormat);
+	if (!Conversion)
+	{
+		return false;
+	}
+
+	const PIXELCONVERTER* Converter = Conversion->Converter;
+	const CONVERTROWSIMD SimdRow =
+		(Level >= BLIT_SSSE3 && Converter->SSSE3) ? Converter->SSSE3 :
+		(Level >= BLIT_SSE2 && Converter->SSE2) ? Converter->SSE2 : nullptr;
+
+	const DWORD AlphaMask = Conversion->AlphaMask;
+
+	for (LONG y = 0; y < Height; y++)
+	{
+		LONG x = SimdRow ? SimdRow(pDest, pSrc, Width, 0, AlphaMask) : 0;
+		Converter->Scalar(pDest, pSrc, Width, x, AlphaMask);
+		pSrc += SrcPitch;
+		pDest += DestPitch;
+	}
+
+	return true;
+}
+
+// ******************************
+// Palette expansion
+// ******************************
+
+namespace {
+	template <typename T>
+	inline void ExpandPaletteRowScalar(T* Dest, const BYTE* Src, const DWORD* Lookup, LONG Width, LONG x)
+	{
+		for (; x + 4 <= Width; x += 4)
+		{
+			const T Pixel0 = (T)Lookup[Src[x + 0]];
+			const T Pixel1 = (T)Lookup[Src[x + 1]];
+			const T Pixel2 = (T)Lookup[Src[x + 2]];
+			const T Pixel3 = (T)Lookup[Src[x + 3]];
+			Dest[x + 0] = Pixel0;
+			Dest[x + 1] = Pixel1;
+			Dest[x + 2] = Pixel2;
+			Dest[x + 3] = Pixel3;
+		}
+		for (; x < Width; x++)
+		{
+			Dest[x] = (T)Lookup[Src[x]];
+		}
+	}
+
+	// Returns the number of pixels expanded
+	LONG ExpandPaletteRowAVX2(DWORD* Dest, const BYTE* Src, const DWORD* Lookup, LONG Width)
+	{
+		LONG x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			const __m128i Index = _mm_loadu_si128((const __m128i*)(Src + x));
+			const __m256i Lo = _mm256_i32gather_epi32((const int*)Lookup, _mm256_cvtepu8_epi32(Index), 4);
+			const __m256i Hi = _mm256_i32gather_epi32((const int*)Lookup, _mm256_cvtepu8_epi32(_mm_srli_si128(Index, 8)), 4);
+			_mm256_storeu_si256((__m256i*)(Dest + x), Lo);
+			_mm256_storeu_si256((__m256i*)(Dest + x + 8), Hi);
+		}
+		_mm256_zeroupper();
+		return x;
+	}
+
+	LONG ExpandPaletteRowAVX2(WORD* Dest, const BYTE* Src, const DWORD* Lookup, LONG Width)
+	{
+		LONG x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			const __m128i Index = _mm_loadu_si128((const __m128i*)(Src + x));
+			const __m256i Lo = _mm256_i32gather_epi32((const int*)Lookup, _mm256_cvtepu8_epi32(Index), 4);
+			const __m256i Hi = _mm256_i32gather_epi32((const int*)Lookup, _mm256_cvtepu8_epi32(_mm_srli_si128(Index, 8)), 4);
+			// Pack works per 128-bit lane so the quadwords need to be put back in order
+			const __m256i Packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(Lo, Hi), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256((__m256i*)(Dest + x), Packed);
+		}
+		_mm256_zeroupper();
+		return x;
+	}
+
+	template <typename T>
+	void ExpandPaletteRows(BYTE* pDest, INT DestPitch, const BYTE* pSrc, INT SrcPitch, const DWORD* pLookup, LONG Width, LONG Height, BLITLEVEL Level)
+	{
+		const bool UseAVX2 = (Level >= BLIT_AVX2);
+
+		for (LONG y = 0; y < Height; y++)
+		{
+			T* Dest = (T*)pDest;
+			LONG x = UseAVX2 ? ExpandPaletteRowAVX2(Dest, pSrc, pLookup, Width) : 0;
+			ExpandPaletteRowScalar<T>(Dest, pSrc, pLookup, Width, x);
+			pSrc += SrcPitch;
+			pDest += DestPitch;
+		}
+	}
+}
+
+bool BuildPaletteLookup(DWORD* pLookup, const PALETTEENTRY* pPalette, D3DFORMAT DestFormat)
+{
+	if (!pLookup || !pPalette)
+	{
+		return false;
+	}
+
+	switch ((DWORD)DestFormat)
+	{
+	case D3DFMT_X8R8G8B8:
+	case D3DFMT_A8R8G8B8:
+		for (UINT i = 0; i < MaxPaletteSize; i++)
+		{
+			pLookup[i] = D3DCOLOR_XRGB(pPalette[i].peRed, pPalette[i].peGreen, pPalette[i].peBlue);
+		}
+		return true;
+	case D3DFMT_R5G6B5:
+		for (UINT i = 0; i < MaxPaletteSize; i++)
+		{
+			pLookup[i] = ((pPalette[i].peRed >> 3) << 11) | ((pPalette[i].peGreen >> 2) << 5) | (pPalette[i].peBlue >> 3);
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool ExpandPaletteRect(BYTE* pDest, INT DestPitch, D3DFORMAT DestFormat, const BYTE* pSrc, INT SrcPitch, const DWORD* pLookup, LONG Width, LONG Height, BLITLEVEL Level)
+{
+	switch ((DWORD)DestFormat)
+	{
+	case D3DFMT_X8R8G8B8:
+	case D3DFMT_A8R8G8B8:
+		ExpandPaletteRows<DWORD>(pDest, DestPitch, pSrc, SrcPitch, pLookup, Width, Height, Level);
+		return true;
+	case D3DFMT_R5G6B5:
+		ExpandPaletteRows<WORD>(pDest, DestPitch, pSrc, SrcPitch, pLookup, Width, Height, Level);
+		return true;
+	default:
+		return false;
+	}
+}
+
+// ******************************
+// Row compare
+// ******************************
+
+// Plain memcmp on purpose, hand-written SSE2 and AVX2 compares and an all zero row check measured no faster in the scanline benchmark
+bool IsRowEqual(const BYTE* pRow1, const BYTE* pRow2, size_t Size)
+{
+	return memcmp(pRow1, pRow2, Size) == 0;
+}
+
+void DetectScanlines(const BYTE* pBits, INT Pitch, size_t RowSize, DWORD Height, bool& bEvenScanlines, bool& bOddScanlines)
+{
+	// Each row is compared to the row two above it in a single pass, equality carries down to the first row of the same parity
+	bEvenScanlines = true;
+	bOddScanlines = true;
+	for (DWORD y = 2; y < Height && (bEvenScanlines || bOddScanlines); y++)
+	{
+		bool& bScanlines = (y % 2 == 0) ? bEvenScanlines : bOddScanlines;
+		if (bScanlines)
+		{
+			bScanlines = IsRowEqual(pBits + Pitch * y, pBits + Pitch * (y - 2), RowSize);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <windows.h>
+#include <d3d9types.h>
+#include "PixelTypes.h"
+
+// Instruction sets used by the helpers below, each helper takes the level to use and defaults to the
+// highest one the CPU supports. The tests pass lower levels to check each path against the scalar one.
+enum BLITLEVEL
+{
+	BLIT_SCALAR,
+	BLIT_SSE2,
+	BLIT_SSSE3,
+	BLIT_AVX2,
+};
+BLITLEVEL GetBlitLevel();
+
+// Whole stretch a clipped part belongs to, DestLeft and DestTop are the offset of the part in the whole destination
+struct STRETCHPART
+{
+	LONG SrcWidth;
+	LONG SrcHeight;
+	LONG DestWidth;
+	LONG DestHeight;
+	LONG DestLeft;
+	LONG DestTop;
+};
+
+// Source span [SrcStart, SrcEnd) read by destination span [DestStart, DestEnd) of a stretch, uses the same stepping as ComplexCopy
+inline void GetStretchSrcSpan(LONG SrcSize, LONG DestSize, LONG DestStart, LONG DestEnd, bool IsMirror, LONG& SrcStart, LONG& SrcEnd)
+{
+	LONG First = (LONG)((ULONGLONG)DestStart * (DWORD)SrcSize / (DWORD)DestSize);
+	LONG Last = (LONG)((ULONGLONG)(DestEnd - 1) * (DWORD)SrcSize / (DWORD)DestSize);
+	SrcStart = IsMirror ? SrcSize - 1 - Last : First;
+	SrcEnd = IsMirror ? SrcSize - First : Last + 1;
+}
+
+// CPU blit helpers used by CopySurface when the copy cannot be done on the GPU
+template <typename T>
+void SimpleColorKeyCopy(T ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT SrcPitch, INT DestPitch, LONG DestRectWidth, LONG DestRectHeight, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level = GetBlitLevel());
+template <typename T>
+void OverlapCopy(T ColorKey, BYTE* SrcBuffer, BYTE* DestBuffer, INT Pitch, LONG DestRectWidth, LONG DestRectHeight, LONG OffsetY, BYTE* RowBuffer, bool IsColorKey, bool IsMirrorLeftRight, BLITLEVEL Level = GetBlitLevel());
+template <typename T>
+void ComplexCopy(T ColorKey, D3DLOCKED_RECT SrcLockRect, D3DLOCKED_RECT DestLockRect, LONG SrcRectWidth, LONG SrcRectHeight, LONG DestRectWidth, LONG DestRectHeight, BYTE* ScratchBuffer, bool IsColorKey, bool IsMirrorUpDown, bool IsMirrorLeftRight,
+	D3DLOCKED_RECT BandLockRect = {}, LONG BandTop = 0, LONG BandHeight = 0, const STRETCHPART* pPart = nullptr, BLITLEVEL Level = GetBlitLevel());
+
+// Size of the 4-byte aligned scratch buffer ComplexCopy needs for its column table and stretched row
+inline size_t GetComplexCopyScratchSize(LONG DestRectWidth, DWORD ByteCount) { return DestRectWidth * (sizeof(DWORD) + ByteCount); }
+
+// Pixel format conversion used for emulated surfaces and format mismatched copies
+bool IsPixelConversionSupported(D3DFORMAT SrcFormat, D3DFORMAT DestFormat);
+bool ConvertPixelRect(BYTE* pDest, INT DestPitch, D3DFORMAT DestFormat, const BYTE* pSrc, INT SrcPitch, D3DFORMAT SrcFormat, LONG Width, LONG Height, BLITLEVEL Level = GetBlitLevel());
+
+// Palette expansion used for 8-bit palette display textures
+bool BuildPaletteLookup(DWORD* pLookup, const PALETTEENTRY* pPalette, D3DFORMAT DestFormat);
+bool ExpandPaletteRect(BYTE* pDest, INT DestPitch, D3DFORMAT DestFormat, const BYTE* pSrc, INT SrcPitch, const DWORD* pLookup, LONG Width, LONG Height, BLITLEVEL Level = GetBlitLevel());
+
+// Row compare used for scanline detection, exits on the first difference
+bool IsRowEqual(const BYTE* pRow1, const BYTE* pRow2, size_t Size);
+
+// Sets the even or odd flag when every row of that parity is the same as the first one
+void DetectScanlines(const BYTE* pBits, INT Pitch, size_t RowSize, DWORD Height, bool& bEvenScanlines, bool& bOddScanlines);
@@ -0,0 +1,356 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "VertexTransform.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace {
+	inline __m128 LoadColumn(const BYTE* pSrc, UINT SrcStride, UINT Index)
+	{
+		return _mm_setr_ps(
+			((const float*)pSrc)[Index],
+			((const float*)(pSrc + SrcStride))[Index],
+			((const float*)(pSrc + SrcStride * 2))[Index],
+			((const float*)(pSrc + SrcStride * 3))[Index]);
+	}
+
+	inline void TransformPosition(const D3DMATRIX& Matrix, const float* pSrc, float* pDest, D3DXVECTOR4* pHomogeneous)
+	{
+		const float x = pSrc[0], y = pSrc[1], z = pSrc[2];
+
+		const float hx = x * Matrix._11 + y * Matrix._21 + z * Matrix._31 + Matrix._41;
+		const float hy = x * Matrix._12 + y * Matrix._22 + z * Matrix._32 + Matrix._42;
+		const float hz = x * Matrix._13 + y * Matrix._23 + z * Matrix._33 + Matrix._43;
+		const float hw = x * Matrix._14 + y * Matrix._24 + z * Matrix._34 + Matrix._44;
+
+		const float rhw = (hw != 0.0f) ? (1.0f / hw) : 0.0f;
+
+		pDest[0] = hx * rhw;
+		pDest[1] = hy * rhw;
+		pDest[2] = hz * rhw;
+		pDest[3] = rhw;
+
+		if (pHomogeneous)
+		{
+			*pHomogeneous = D3DXVECTOR4(hx, hy, hz, hw);
+		}
+	}
+
+	inline DWORD GetClipCode(const D3DXVECTOR4& h)
+	{
+		return
+			(h.x < -h.w ? D3DCLIP_LEFT : 0) |
+			(h.x > h.w ? D3DCLIP_RIGHT : 0) |
+			(h.y > h.w ? D3DCLIP_TOP : 0) |
+			(h.y < -h.w ? D3DCLIP_BOTTOM : 0) |
+			(h.z < 0.0f ? D3DCLIP_FRONT : 0) |
+			(h.z > h.w ? D3DCLIP_BACK : 0);
+	}
+
+	inline void TransformNormal(const D3DMATRIX& Matrix, const float* pSrc, D3DXVECTOR3& Dest)
+	{
+		const float x = pSrc[0], y = pSrc[1], z = pSrc[2];
+
+		Dest.x = x * Matrix._11 + y * Matrix._21 + z * Matrix._31;
+		Dest.y = x * Matrix._12 + y * Matrix._22 + z * Matrix._32;
+		Dest.z = x * Matrix._13 + y * Matrix._23 + z * Matrix._33;
+
+		// Zero length normals are left as is, they are only lit by ambient light
+		const float LengthSq = Dest.x * Dest.x + Dest.y * Dest.y + Dest.z * Dest.z;
+		if (x * x + y * y + z * z > 1e-12f && LengthSq > 0.0f)
+		{
+			const float InvLength = 1.0f / sqrtf(LengthSq);
+			Dest.x *= InvLength;
+			Dest.y *= InvLength;
+			Dest.z *= InvLength;
+		}
+	}
+}
+
+// Positions are read from the start of each source vertex and written as x, y, z, rhw to the start of each destination vertex
+void TransformPositions(const D3DMATRIX& Matrix, const BYTE* pSrc, UINT SrcStride, BYTE* pDest, UINT DestStride, D3DXVECTOR4* pHomogeneous, DWORD Count)
+{
+	const __m128 m11 = _mm_set1_ps(Matrix._11), m12 = _mm_set1_ps(Matrix._12), m13 = _mm_set1_ps(Matrix._13), m14 = _mm_set1_ps(Matrix._14);
+	const __m128 m21 = _mm_set1_ps(Matrix._21), m22 = _mm_set1_ps(Matrix._22), m23 = _mm_set1_ps(Matrix._23), m24 = _mm_set1_ps(Matrix._24);
+	const __m128 m31 = _mm_set1_ps(Matrix._31), m32 = _mm_set1_ps(Matrix._32), m33 = _mm_set1_ps(Matrix._33), m34 = _mm_set1_ps(Matrix._34);
+	const __m128 m41 = _mm_set1_ps(Matrix._41), m42 = _mm_set1_ps(Matrix._42), m43 = _mm_set1_ps(Matrix._43), m44 = _mm_set1_ps(Matrix._44);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	DWORD i = 0;
+	for (; i + 4 <= Count; i += 4)
+	{
+		const BYTE* pSrcBlock = pSrc + i * SrcStride;
+		BYTE* pDestBlock = pDest + i * DestStride;
+
+		// Gather four vertices into one register per component
+		const __m128 x = LoadColumn(pSrcBlock, SrcStride, 0);
+		const __m128 y = LoadColumn(pSrcBlock, SrcStride, 1);
+		const __m128 z = LoadColumn(pSrcBlock, SrcStride, 2);
+
+		__m128 hx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m11), _mm_mul_ps(y, m21)), _mm_mul_ps(z, m31)), m41);
+		__m128 hy = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m12), _mm_mul_ps(y, m22)), _mm_mul_ps(z, m32)), m42);
+		__m128 hz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m13), _mm_mul_ps(y, m23)), _mm_mul_ps(z, m33)), m43);
+		__m128 hw = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m14), _mm_mul_ps(y, m24)), _mm_mul_ps(z, m34)), m44);
+
+		// rhw is zero when w is zero
+		__m128 rhw = _mm_and_ps(_mm_div_ps(one, hw), _mm_cmpneq_ps(hw, zero));
+		__m128 sx = _mm_mul_ps(hx, rhw);
+		__m128 sy = _mm_mul_ps(hy, rhw);
+		__m128 sz = _mm_mul_ps(hz, rhw);
+
+		_MM_TRANSPOSE4_PS(sx, sy, sz, rhw);
+		_mm_storeu_ps((float*)pDestBlock, sx);
+		_mm_storeu_ps((float*)(pDestBlock + DestStride), sy);
+		_mm_storeu_ps((float*)(pDestBlock + DestStride * 2), sz);
+		_mm_storeu_ps((float*)(pDestBlock + DestStride * 3), rhw);
+
+		if (pHomogeneous)
+		{
+			_MM_TRANSPOSE4_PS(hx, hy, hz, hw);
+			_mm_storeu_ps((float*)&pHomogeneous[i], hx);
+			_mm_storeu_ps((float*)&pHomogeneous[i + 1], hy);
+			_mm_storeu_ps((float*)&pHomogeneous[i + 2], hz);
+			_mm_storeu_ps((float*)&pHomogeneous[i + 3], hw);
+		}
+	}
+	for (; i < Count; i++)
+	{
+		TransformPosition(Matrix, (const float*)(pSrc + i * SrcStride), (float*)(pDest + i * DestStride), pHomogeneous ? &pHomogeneous[i] : nullptr);
+	}
+}
+
+// Normals are transformed by the upper 3x3 of the matrix and renormalized
+void TransformNormals(const D3DMATRIX& Matrix, const BYTE* pSrc, UINT SrcStride, D3DXVECTOR3* pDest, DWORD Count)
+{
+	const __m128 m11 = _mm_set1_ps(Matrix._11), m12 = _mm_set1_ps(Matrix._12), m13 = _mm_set1_ps(Matrix._13);
+	const __m128 m21 = _mm_set1_ps(Matrix._21), m22 = _mm_set1_ps(Matrix._22), m23 = _mm_set1_ps(Matrix._23);
+	const __m128 m31 = _mm_set1_ps(Matrix._31), m32 = _mm_set1_ps(Matrix._32), m33 = _mm_set1_ps(Matrix._33);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 epsilon = _mm_set1_ps(1e-12f);
+
+	DWORD i = 0;
+	for (; i + 4 <= Count; i += 4)
+	{
+		const BYTE* pSrcBlock = pSrc + i * SrcStride;
+
+		const __m128 x = LoadColumn(pSrcBlock, SrcStride, 0);
+		const __m128 y = LoadColumn(pSrcBlock, SrcStride, 1);
+		const __m128 z = LoadColumn(pSrcBlock, SrcStride, 2);
+
+		__m128 nx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m11), _mm_mul_ps(y, m21)), _mm_mul_ps(z, m31));
+		__m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m12), _mm_mul_ps(y, m22)), _mm_mul_ps(z, m32));
+		__m128 nz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m13), _mm_mul_ps(y, m23)), _mm_mul_ps(z, m33));
+
+		// Only normalize where both the source and the transformed normal have a length
+		const __m128 SrcLengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		const __m128 LengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+		const __m128 Mask = _mm_and_ps(_mm_cmpgt_ps(SrcLengthSq, epsilon), _mm_cmpgt_ps(LengthSq, zero));
+		const __m128 InvLength = _mm_or_ps(_mm_and_ps(Mask, _mm_div_ps(one, _mm_sqrt_ps(LengthSq))), _mm_andnot_ps(Mask, one));
+
+		nx = _mm_mul_ps(nx, InvLength);
+		ny = _mm_mul_ps(ny, InvLength);
+		nz = _mm_mul_ps(nz, InvLength);
+
+		alignas(16) float ox[4], oy[4], oz[4];
+		_mm_store_ps(ox, nx);
+		_mm_store_ps(oy, ny);
+		_mm_store_ps(oz, nz);
+		for (UINT j = 0; j < 4; j++)
+		{
+			pDest[i + j] = D3DXVECTOR3(ox[j], oy[j], oz[j]);
+		}
+	}
+	for (; i < Count; i++)
+	{
+		TransformNormal(Matrix, (const float*)(pSrc + i * SrcStride), pDest[i]);
+	}
+}
+
+// Codes are computed from the homogeneous position before the perspective divide
+DWORD ComputeClipCodes(const D3DXVECTOR4* pHomogeneous, DWORD* pClipCodes, DWORD Count, DWORD& Intersection)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i Left = _mm_set1_epi32(D3DCLIP_LEFT);
+	const __m128i Right = _mm_set1_epi32(D3DCLIP_RIGHT);
+	const __m128i Top = _mm_set1_epi32(D3DCLIP_TOP);
+	const __m128i Bottom = _mm_set1_epi32(D3DCLIP_BOTTOM);
+	const __m128i Front = _mm_set1_epi32(D3DCLIP_FRONT);
+	const __m128i Back = _mm_set1_epi32(D3DCLIP_BACK);
+
+	__m128i Union4 = _mm_setzero_si128();
+	__m128i Intersection4 = _mm_set1_epi32(D3DCLIP_FRUSTUM);
+
+	DWORD i = 0;
+	for (; i + 4 <= Count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps((const float*)&pHomogeneous[i]);
+		__m128 y = _mm_loadu_ps((const float*)&pHomogeneous[i + 1]);
+		__m128 z = _mm_loadu_ps((const float*)&pHomogeneous[i + 2]);
+		__m128 w = _mm_loadu_ps((const float*)&pHomogeneous[i + 3]);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		const __m128 negw = _mm_sub_ps(zero, w);
+
+		__m128i Codes = _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(x, negw)), Left);
+		Codes = _mm_or_si128(Codes, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(x, w)), Right));
+		Codes = _mm_or_si128(Codes, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(y, w)), Top));
+		Codes = _mm_or_si128(Codes, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(y, negw)), Bottom));
+		Codes = _mm_or_si128(Codes, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(z, zero)), Front));
+		Codes = _mm_or_si128(Codes, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(z, w)), Back));
+
+		Union4 = _mm_or_si128(Union4, Codes);
+		Intersection4 = _mm_and_si128(Intersection4, Codes);
+
+		if (pClipCodes)
+		{
+			_mm_storeu_si128((__m128i*)&pClipCodes[i], Codes);
+		}
+	}
+
+	// Fold the four lanes
+	Union4 = _mm_or_si128(Union4, _mm_shuffle_epi32(Union4, _MM_SHUFFLE(1, 0, 3, 2)));
+	Union4 = _mm_or_si128(Union4, _mm_shuffle_epi32(Union4, _MM_SHUFFLE(2, 3, 0, 1)));
+	Intersection4 = _mm_and_si128(Intersection4, _mm_shuffle_epi32(Intersection4, _MM_SHUFFLE(1, 0, 3, 2)));
+	Intersection4 = _mm_and_si128(Intersection4, _mm_shuffle_epi32(Intersection4, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	DWORD Union = (DWORD)_mm_cvtsi128_si32(Union4);
+	Intersection &= (DWORD)_mm_cvtsi128_si32(Intersection4);
+
+	for (; i < Count; i++)
+	{
+		const DWORD Code = GetClipCode(pHomogeneous[i]);
+
+		Union |= Code;
+		Intersection &= Code;
+
+		if (pClipCodes)
+		{
+			pClipCodes[i] = Code;
+		}
+	}
+
+	return Union;
+}
+
+// Same mapping as the Direct3D viewport, y is flipped and z goes from [0, 1] to [MinZ, MaxZ]
+VIEWPORTTRANSFORM MakeViewportTransform(const D3DVIEWPORT7& View, float ScaleX, float ScaleY)
+{
+	const float HalfWidth = View.dwWidth / 2.0f;
+	const float HalfHeight = View.dwHeight / 2.0f;
+
+	VIEWPORTTRANSFORM Transform;
+	Transform.ScaleX = ScaleX * HalfWidth;
+	Transform.ScaleY = -ScaleY * HalfHeight;
+	Transform.ScaleZ = View.dvMaxZ - View.dvMinZ;
+	Transform.OffsetX = View.dwX + HalfWidth;
+	Transform.OffsetY = View.dwY + HalfHeight;
+	Transform.OffsetZ = View.dvMinZ;
+	return Transform;
+}
+
+// Scale and offset are applied to x, y and z in one step, rhw is left as is
+void ApplyViewportTransform(const VIEWPORTTRANSFORM& Viewport, BYTE* pDest, UINT DestStride, DWORD Count, D3DVECTOR* pExtentMin, D3DVECTOR* pExtentMax)
+{
+	const __m128 Scale = _mm_setr_ps(Viewport.ScaleX, Viewport.ScaleY, Viewport.ScaleZ, 1.0f);
+	const __m128 Offset = _mm_setr_ps(Viewport.OffsetX, Viewport.OffsetY, Viewport.OffsetZ, 0.0f);
+
+	__m128 Min = _mm_set1_ps(FLT_MAX);
+	__m128 Max = _mm_set1_ps(-FLT_MAX);
+
+	for (DWORD i = 0; i < Count; i++)
+	{
+		float* pVertex = (float*)(pDest + i * DestStride);
+
+		const __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pVertex), Scale), Offset);
+		_mm_storeu_ps(pVertex, v);
+
+		Min = _mm_min_ps(Min, v);
+		Max = _mm_max_ps(Max, v);
+	}
+
+	if (pExtentMin && pExtentMax && Count)
+	{
+		alignas(16) float vMin[4], vMax[4];
+		_mm_store_ps(vMin, Min);
+		_mm_store_ps(vMax, Max);
+
+		pExtentMin->x = (std::min)(pExtentMin->x, vMin[0]);
+		pExtentMin->y = (std::min)(pExtentMin->y, vMin[1]);
+		pExtentMin->z = (std::min)(pExtentMin->z, vMin[2]);
+		pExtentMax->x = (std::max)(pExtentMax->x, vMax[0]);
+		pExtentMax->y = (std::max)(pExtentMax->y, vMax[1]);
+		pExtentMax->z = (std::max)(pExtentMax->z, vMax[2]);
+	}
+}
+
+// Computes exp2(Exponent * log2(Base)) with short series for both, a zero exponent gives one and otherwise only positive bases give a non-zero result
+float FastPow(float Base, float Exponent)
+{
+	// Matches powf, any base raised to zero is one
+	if (Exponent == 0.0f)
+	{
+		return 1.0f;
+	}
+	if (!(Base >= FLT_MIN))
+	{
+		return 0.0f;
+	}
+
+	// Split the base into a mantissa in [sqrt(0.5), sqrt(2)) and a power of two
+	DWORD Bits;
+	memcpy(&Bits, &Base, sizeof(Bits));
+	int e = (int)((Bits >> 23) & 0xFF) - 127;
+	Bits = (Bits & 0x007FFFFF) | 0x3F800000;
+	float m;
+	memcpy(&m, &Bits, sizeof(m));
+	if (m > 1.41421356f)
+	{
+		m *= 0.5f;
+		e++;
+	}
+
+	// log2(m) = 2 / ln(2) * atanh(t), with t = (m - 1) / (m + 1)
+	const float t = (m - 1.0f) / (m + 1.0f);
+	const float t2 = t * t;
+	const float Log2 = e + t * (2.88539008f + t2 * (0.961796694f + t2 * (0.577078016f + t2 * 0.412198583f)));
+
+	const float y = Exponent * Log2;
+	if (y < -126.0f)
+	{
+		return 0.0f;
+	}
+	if (y > 127.0f)
+	{
+		return FLT_MAX;
+	}
+
+	// exp2(y) = 2^i * exp(f * ln(2)), with f in [-0.5, 0.5]
+	const int i = (int)(y + (y >= 0.0f ? 0.5f : -0.5f));
+	const float f = y - i;
+	const float p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f + f * (0.00961812911f + f * (0.00133335581f + f * 0.000154035304f)))));
+
+	Bits = (DWORD)(i + 127) << 23;
+	float Scale;
+	memcpy(&Scale, &Bits, sizeof(Scale));
+
+	return p * Scale;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <windows.h>
+#include "d3dx9math.h"
+#include <d3dtypes.h>
+
+// Screen mapping applied after the perspective divide
+struct VIEWPORTTRANSFORM {
+	float ScaleX = 1.0f;
+	float ScaleY = 1.0f;
+	float ScaleZ = 1.0f;
+	float OffsetX = 0.0f;
+	float OffsetY = 0.0f;
+	float OffsetZ = 0.0f;
+};
+
+// Frustum clip codes computed for software vertex processing
+#define D3DCLIP_FRUSTUM (D3DCLIP_LEFT | D3DCLIP_RIGHT | D3DCLIP_TOP | D3DCLIP_BOTTOM | D3DCLIP_FRONT | D3DCLIP_BACK)
+
+// Number of vertices processed per batch, sized so per batch scratch arrays fit on the stack
+constexpr DWORD VertexBatchSize = 64;
+
+// Batched vertex transform used for software vertex processing, works on four vertices at a time
+void TransformPositions(const D3DMATRIX& Matrix, const BYTE* pSrc, UINT SrcStride, BYTE* pDest, UINT DestStride, D3DXVECTOR4* pHomogeneous, DWORD Count);
+void TransformNormals(const D3DMATRIX& Matrix, const BYTE* pSrc, UINT SrcStride, D3DXVECTOR3* pDest, DWORD Count);
+
+// Clip codes use the D3DCLIP flags, the union of all codes is returned and Intersection is masked with the codes common to every vertex
+DWORD ComputeClipCodes(const D3DXVECTOR4* pHomogeneous, DWORD* pClipCodes, DWORD Count, DWORD& Intersection);
+
+// Builds the screen mapping for a viewport, ScaleX and ScaleY are the extra scale set by older viewport versions
+VIEWPORTTRANSFORM MakeViewportTransform(const D3DVIEWPORT7& View, float ScaleX, float ScaleY);
+
+// Maps transformed vertices to screen space, grows the extents when given
+void ApplyViewportTransform(const VIEWPORTTRANSFORM& Viewport, BYTE* pDest, UINT DestStride, DWORD Count, D3DVECTOR* pExtentMin, D3DVECTOR* pExtentMax);
+
+// Approximate powf for lighting, relative error is around 1e-5 for the exponents used by lights and materials
+float FastPow(float Base, float Exponent);
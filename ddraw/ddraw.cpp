@@ -751,6 +751,7 @@ void InitDDraw()
 			Logging::Log() << __FUNCTION__ << " Warning: failed to initialize CriticalSectionAndSpinCount for pecs.  Failing over to CriticalSection!";
 			InitializeCriticalSection(&pecs);
 		}
+		Profiler::Init();
 		IsInitialized = true;
 	}
 
@@ -15,9 +15,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <optional>
-
-// Enable for testing
-//#define ENABLE_PROFILING
+#include <cfloat>
 
 class m_IDirect3D;
 class m_IDirect3D2;
@@ -61,6 +59,7 @@ class m_IDirectDrawClipper;
 class m_IDirectDrawPalette;
 class m_IDirectDrawColorControl;
 class m_IDirectDrawGammaControl;
+class PresentScheduler;
 
 #include "External\DirectXMath\Inc\DirectXMath.h"
 #include "AddressLookupTable.h"
@@ -130,6 +129,16 @@ using namespace DdrawWrapper;
 #include "IDirect3DTypes.h"
 // DirectDraw Helpers
 #include "IDirectDrawTypes.h"
+#include "SurfaceBlitter.h"
+#include "ClipRects.h"
+#include "DirtyRegion.h"
+#include "DynamicBuffer.h"
+#include "VertexTransform.h"
+#include "ExecuteCompiler.h"
+#include "PrimitiveBatch.h"
+#include "StateCache.h"
+#include "Profiler.h"
+#include "PresentScheduler.h"
 // Direct3D Version Wrappers
 #include "Versions\IDirect3D.h"
 #include "Versions\IDirect3D2.h"
@@ -35,6 +35,11 @@ class m_IDirectDrawClipper;
 void InitDDraw();
 void ExitDDraw();
 
+namespace Profiler
+{
+	void Stop();
+}
+
 #define DECLARE_IN_WRAPPED_PROC(procName, unused) \
 	const FARPROC procName ## _in = (FARPROC)*dd_ ## procName;
 
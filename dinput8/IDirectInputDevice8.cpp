@@ -210,7 +210,7 @@ HRESULT m_IDirectInputDevice8::GetDeviceState(DWORD cbData, LPVOID lpvData)
 }
 
 template <class T>
-HRESULT m_IDirectInputDevice8::GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICEOBJECTDATA rgdod, LPDWORD pdwInOut, DWORD dwFlags, std::vector<T>& dod)
+HRESULT m_IDirectInputDevice8::GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICEOBJECTDATA rgdod, LPDWORD pdwInOut, DWORD dwFlags, MouseDataRing<T>& dod)
 {
 	// Check arguments
 	if (!pdwInOut || (rgdod && *pdwInOut == 0))
@@ -229,6 +229,9 @@ HRESULT m_IDirectInputDevice8::GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICE
 	// Lock for concurrency
 	ScopedCriticalSection ThreadLock(&dics);
 
+	// Keep at least as many records as the device buffer
+	dod.Reserve(max(MouseBufferSize, 128UL));
+
 	bool isBufferOverflow = false;
 	DWORD dwItems = INFINITE;
 
@@ -273,8 +276,7 @@ HRESULT m_IDirectInputDevice8::GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICE
 	// Merge and store device object data
 	if (!isFlushingData && dwItems)
 	{
-		bool isSet[3] = { false };
-		DWORD Loc[3] = { 0 };
+		MouseMergeLocations MergeLoc;
 
 		if (SequenceCounter == 0)
 		{
@@ -292,29 +294,37 @@ HRESULT m_IDirectInputDevice8::GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICE
 				const int v = lpdod->dwOfs == Ofs.x ? 0 : lpdod->dwOfs == Ofs.y ? 1 : 2;
 
 				// Merge data only
-				if (isSet[v])
+				DWORD Loc;
+				if (MergeLoc.Find(v, Loc))
 				{
 					InsertNewRecord = false;
-					dod[Loc[v]].lData += (LONG)lpdod->dwData;
+					dod[Loc].lData += (LONG)lpdod->dwData;
 				}
 				// Storing new movement data
 				else
 				{
-					isSet[v] = true;
-					Loc[v] = dod.size();
+					MergeLoc.Set(v, dod.size());
 				}
 			}
 
 			// Store data
 			if (InsertNewRecord)
 			{
+				bool Stored;
 				if constexpr (std::is_same_v<T, MOUSECACHEDATA_DX3>)
 				{
-					dod.push_back({ lpdod->dwOfs, (LONG)lpdod->dwData, lpdod->dwTimeStamp, SequenceCounter++ });
+					Stored = dod.push_back({ lpdod->dwOfs, (LONG)lpdod->dwData, lpdod->dwTimeStamp, SequenceCounter++ });
 				}
 				else
 				{
-					dod.push_back({ lpdod->dwOfs, (LONG)lpdod->dwData, lpdod->dwTimeStamp, SequenceCounter++, lpdod->uAppData });
+					Stored = dod.push_back({ lpdod->dwOfs, (LONG)lpdod->dwData, lpdod->dwTimeStamp, SequenceCounter++, lpdod->uAppData });
+				}
+
+				// Oldest record was dropped, shift the merge locations with it
+				if (!Stored)
+				{
+					isBufferOverflow = true;
+					MergeLoc.DropOldest();
 				}
 			}
 
@@ -326,9 +336,10 @@ HRESULT m_IDirectInputDevice8::GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICE
 		{
 			const int v = item == Ofs.x ? 0 : item == Ofs.y ? 1 : 2;
 
-			if (isSet[v])
+			DWORD Loc;
+			if (MergeLoc.Find(v, Loc))
 			{
-				AdjustMouseAxis(dod[Loc[v]].lData, (item == Ofs.y));
+				AdjustMouseAxis(dod[Loc].lData, (item == Ofs.y));
 			}
 		}
 	}
@@ -377,19 +388,12 @@ HRESULT m_IDirectInputDevice8::GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICE
 			isBufferOverflow = true;
 		}
 
-		memcpy(rgdod, dod.data(), sizeof(T) * dwOut);
+		dod.Peek(reinterpret_cast<T*>(rgdod), dwOut);
 
 		// Remove used entries from buffer
-		if (dwOut && !isPeek)
+		if (!isPeek)
 		{
-			if (dwOut < dod.size())
-			{
-				dod.erase(dod.begin(), dod.begin() + dwOut);
-			}
-			else
-			{
-				dod.clear();
-			}
+			dod.Consume(dwOut);
 		}
 	}
 
@@ -455,8 +459,10 @@ HRESULT m_IDirectInputDevice8::GetDeviceData(DWORD cbObjectData, LPDIDEVICEOBJEC
 				// Lock for concurrency
 				ScopedCriticalSection ThreadLock(&dics);
 
-				for (auto& item : dod_dx8)
+				dod_dx3.Reserve(dod_dx3.size() + dod_dx8.size());
+				for (DWORD x = 0; x < dod_dx8.size(); x++)
 				{
+					const MOUSECACHEDATA& item = dod_dx8[x];
 					dod_dx3.push_back({ item.dwOfs, item.lData, item.dwTimeStamp, item.dwSequence });
 				}
 				dod_dx8.clear();
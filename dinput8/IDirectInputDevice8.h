@@ -47,8 +47,8 @@ private:
 		DWORD z = DIMOFS_Z;
 	} Ofs;
 	std::vector<DWORD> cachedAxisOffsets;
-	std::vector<MOUSECACHEDATA_DX3> dod_dx3;
-	std::vector<MOUSECACHEDATA> dod_dx8;
+	MouseDataRing<MOUSECACHEDATA_DX3> dod_dx3;
+	MouseDataRing<MOUSECACHEDATA> dod_dx8;
 	std::vector<BYTE> tmp_dod;
 
 	template <class T, class V>
@@ -210,7 +210,7 @@ public:
 
 	// Helper functions
 	template <class T>
-	HRESULT GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICEOBJECTDATA rgdod, LPDWORD pdwInOut, DWORD dwFlags, std::vector<T>& dod);
+	HRESULT GetMouseDeviceData(DWORD cbObjectData, LPDIDEVICEOBJECTDATA rgdod, LPDWORD pdwInOut, DWORD dwFlags, MouseDataRing<T>& dod);
 	void SetAsMouse() { IsMouse = true; }
 	void AdjustMouseAxis(LONG& value, bool isY);
 };
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <windows.h>
+#include <vector>
+
+// Fixed capacity ring of buffered mouse records. Records are appended at the back and consumed
+// from the front in O(1), and records already in the ring can be updated in place so movement
+// can be merged into the record stored earlier in the same poll. When the ring is full the
+// oldest record is dropped, the same way the DirectInput buffer drops data on overflow.
+template <class T>
+class MouseDataRing
+{
+private:
+	std::vector<T> Data;
+	DWORD Mask = 0;
+	DWORD First = 0;
+	DWORD Count = 0;
+
+public:
+	// Grows the ring to hold at least the requested number of records, keeping stored records
+	void Reserve(DWORD Capacity)
+	{
+		if (Capacity <= Data.size())
+		{
+			return;
+		}
+
+		DWORD NewSize = 16;
+		while (NewSize < Capacity)
+		{
+			NewSize <<= 1;
+		}
+
+		std::vector<T> NewData(NewSize);
+		for (DWORD x = 0; x < Count; x++)
+		{
+			NewData[x] = Data[(First + x) & Mask];
+		}
+		Data.swap(NewData);
+		Mask = NewSize - 1;
+		First = 0;
+	}
+
+	DWORD size() const { return Count; }
+	bool empty() const { return Count == 0; }
+	void clear() { First = 0; Count = 0; }
+
+	// Index is relative to the oldest record
+	T& operator[](DWORD Index) { return Data[(First + Index) & Mask]; }
+	const T& operator[](DWORD Index) const { return Data[(First + Index) & Mask]; }
+
+	// Appends a record and returns false if the oldest record had to be dropped to make room
+	bool push_back(const T& Record)
+	{
+		bool Stored = true;
+		if (Count == Data.size())
+		{
+			First = (First + 1) & Mask;
+			Count--;
+			Stored = false;
+		}
+		Data[(First + Count) & Mask] = Record;
+		Count++;
+		return Stored;
+	}
+
+	// Copies up to Max of the oldest records to the buffer, returns the number copied
+	DWORD Peek(T* Buffer, DWORD Max) const
+	{
+		const DWORD Total = min(Count, Max);
+		if (!Total)
+		{
+			return 0;
+		}
+		const DWORD FirstPart = min(Total, (DWORD)Data.size() - First);
+		memcpy(Buffer, &Data[First], sizeof(T) * FirstPart);
+		memcpy(Buffer + FirstPart, Data.data(), sizeof(T) * (Total - FirstPart));
+		return Total;
+	}
+
+	// Removes up to Max of the oldest records
+	void Consume(DWORD Max)
+	{
+		const DWORD Total = min(Count, Max);
+		First = (First + Total) & Mask;
+		Count -= Total;
+	}
+};
+
+// Index of the movement record stored for each axis during one poll, so later movement on the same
+// axis is merged into it. The indexes follow the records when the ring drops the oldest record.
+class MouseMergeLocations
+{
+private:
+	bool isSet[3] = {};
+	DWORD Loc[3] = {};
+
+public:
+	// Returns true and the record index if the axis already has a record in this poll
+	bool Find(int Axis, DWORD& Index) const
+	{
+		Index = Loc[Axis];
+		return isSet[Axis];
+	}
+	void Set(int Axis, DWORD Index)
+	{
+		isSet[Axis] = true;
+		Loc[Axis] = Index;
+	}
+
+	// Call when push_back() dropped the oldest record, an axis whose record was dropped starts a new one
+	void DropOldest()
+	{
+		for (int v = 0; v < 3; v++)
+		{
+			if (isSet[v])
+			{
+				isSet[v] = (Loc[v] != 0);
+				Loc[v]--;
+			}
+		}
+	}
+};
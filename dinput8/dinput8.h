@@ -13,6 +13,7 @@ class m_IDirectInputEffect8;
 #include "External\dinputto8\ModuleObjectCount.h"
 #include "Settings\Settings.h"
 #include "Logging\Logging.h"
+#include "MouseDataRing.h"
 
 typedef HRESULT(WINAPI *DirectInput8CreateProc)(HINSTANCE, DWORD, REFIID, LPVOID*, LPUNKNOWN);
 typedef HRESULT(WINAPI *DllCanUnloadNowProc)();
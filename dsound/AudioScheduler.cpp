@@ -0,0 +1,156 @@
+/**
+* Copyright (C) 2026 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "dsound.h"
+#include "AudioStopQueue.h"
+
+namespace
+{
+	// Queue lock only guards the queue. Exec lock is held while jobs run, so Cancel can wait for a
+	// running job before the buffer is deleted. Lock order is exec, then buffer, then queue.
+	struct SCHEDULERLOCKS
+	{
+		CRITICAL_SECTION Queue;
+		CRITICAL_SECTION Exec;
+		SCHEDULERLOCKS()
+		{
+			InitializeCriticalSection(&Queue);
+			InitializeCriticalSection(&Exec);
+		}
+		~SCHEDULERLOCKS()
+		{
+			DeleteCriticalSection(&Queue);
+			DeleteCriticalSection(&Exec);
+		}
+	} Locks;
+
+	AudioStopQueue<AUDIOCLIP> JobQueue;
+	HANDLE hThread = nullptr;
+	HANDLE hWakeEvent = nullptr;
+	HANDLE hExitEvent = nullptr;
+	HANDLE hStoppedEvent = nullptr;
+}
+
+static DWORD WINAPI SchedulerThreadFunc(LPVOID)
+{
+	HANDLE Events[] = { hExitEvent, hWakeEvent };
+	DWORD Timeout = INFINITE;
+	DWORD WaitResult;
+
+	while ((WaitResult = WaitForMultipleObjects(_countof(Events), Events, FALSE, Timeout)) == WAIT_OBJECT_0 + 1 || WaitResult == WAIT_TIMEOUT)
+	{
+		ScopedCriticalSection ThreadLockExec(&Locks.Exec);
+
+		EnterCriticalSection(&Locks.Queue);
+
+		// Run every job that is due
+		AudioStopQueue<AUDIOCLIP>::STOPJOB Job;
+		while (JobQueue.PopDue(GetTickCount(), Job))
+		{
+			LeaveCriticalSection(&Locks.Queue);
+			const bool MoreSteps = JobQueue.RunJob(Job);
+			EnterCriticalSection(&Locks.Queue);
+
+			// Queue the next fade step
+			if (MoreSteps)
+			{
+				JobQueue.Requeue(Job, GetTickCount());
+			}
+		}
+
+		// Sleep until the next job is due or a job is posted to an empty queue
+		Timeout = JobQueue.GetTimeout(GetTickCount());
+
+		LeaveCriticalSection(&Locks.Queue);
+	}
+
+	// Signaled separately since the thread cannot exit while the loader lock is held
+	SetEvent(hStoppedEvent);
+
+	return S_OK;
+}
+
+bool AudioScheduler::PostStop(AUDIOCLIP* AudioClip, DWORD Generation)
+{
+	ScopedCriticalSection ThreadLock(&Locks.Queue);
+
+	if (!hThread)
+	{
+		if (!hWakeEvent)
+		{
+			hWakeEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		}
+		if (!hExitEvent)
+		{
+			hExitEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+		}
+		if (!hStoppedEvent)
+		{
+			hStoppedEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+		}
+		if (hWakeEvent && hExitEvent && hStoppedEvent)
+		{
+			hThread = CreateThread(nullptr, 0, SchedulerThreadFunc, nullptr, 0, nullptr);
+		}
+		if (!hThread)
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create audio scheduler thread!");
+			return false;
+		}
+	}
+
+	JobQueue.SetFadeOutDelay(Config.AudioFadeOutDelayMS);
+
+	// Thread already sleeps until an earlier deadline when the queue is not empty
+	if (JobQueue.Post(AudioClip, Generation, GetTickCount()))
+	{
+		SetEvent(hWakeEvent);
+	}
+
+	return true;
+}
+
+// Removes all jobs for a buffer that is being deleted, waiting for a running job to finish
+void AudioScheduler::Cancel(AUDIOCLIP* AudioClip)
+{
+	ScopedCriticalSection ThreadLockExec(&Locks.Exec);
+	ScopedCriticalSection ThreadLockQueue(&Locks.Queue);
+
+	JobQueue.Cancel(AudioClip);
+}
+
+void AudioScheduler::StopThread()
+{
+	if (hThread)
+	{
+		SetEvent(hExitEvent);
+
+		HANDLE Handles[] = { hStoppedEvent, hThread };
+		WaitForMultipleObjects(2, Handles, FALSE, 1000);
+
+		CloseHandle(hThread);
+		hThread = nullptr;
+	}
+	for (HANDLE* pEvent : { &hWakeEvent, &hExitEvent, &hStoppedEvent })
+	{
+		if (*pEvent)
+		{
+			CloseHandle(*pEvent);
+			*pEvent = nullptr;
+		}
+	}
+}
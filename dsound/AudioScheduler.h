@@ -0,0 +1,12 @@
+#pragma once
+
+struct AUDIOCLIP;
+
+// Single thread that runs the AudioStopQueue for the delayed stops queued by AudioClipDetection.
+// The thread sleeps until the next job is due and never polls.
+namespace AudioScheduler
+{
+	bool PostStop(AUDIOCLIP* AudioClip, DWORD Generation);
+	void Cancel(AUDIOCLIP* AudioClip);
+	void StopThread();
+}
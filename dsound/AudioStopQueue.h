@@ -0,0 +1,116 @@
+#pragma once
+
+#include <windows.h>
+#include <dsound.h>
+#include <deque>
+#include <algorithm>
+#include "Libraries\ScopeGuard.h"
+
+// Fade out and stop jobs for the buffers stopped by AudioClipDetection. A stop lowers the volume in
+// steps over the fade out delay and then stops the buffer. Every step uses the same delay, so jobs
+// come due in the order they are posted and the front of the FIFO queue is always the next deadline.
+// Times are tick counts passed in by the caller, and the queue does no locking of its own.
+template <typename C>
+class AudioStopQueue
+{
+public:
+	static constexpr DWORD FadeStepMS = 5;				// Fade steps are about this far apart
+	static constexpr DWORD DefaultFadeOutDelayMS = 20;
+
+	struct STOPJOB
+	{
+		C* AudioClip;
+		DWORD Generation;
+		DWORD DueTime;
+		DWORD Step;		// Fade steps done so far
+		DWORD Steps;	// Fade steps before the stop
+	};
+
+private:
+	std::deque<STOPJOB> JobQueue;
+	DWORD FadeSteps = DefaultFadeOutDelayMS / FadeStepMS;
+	DWORD StepDelay = FadeStepMS;
+
+public:
+	void SetFadeOutDelay(DWORD DelayMS)
+	{
+		const DWORD Delay = DelayMS ? DelayMS : DefaultFadeOutDelayMS;
+		FadeSteps = (std::max)(Delay / FadeStepMS, (DWORD)1);
+		StepDelay = Delay / FadeSteps;
+	}
+	DWORD GetFadeSteps() const { return FadeSteps; }
+	DWORD GetStepDelay() const { return StepDelay; }
+	size_t size() const { return JobQueue.size(); }
+
+	// Queues the first fade step, returns true if the queue was empty and the thread needs waking
+	bool Post(C* AudioClip, DWORD Generation, DWORD Now)
+	{
+		const bool WasEmpty = JobQueue.empty();
+		JobQueue.push_back({ AudioClip, Generation, Now + StepDelay, 0, FadeSteps });
+		return WasEmpty;
+	}
+
+	// Removes all jobs for a buffer
+	void Cancel(C* AudioClip)
+	{
+		JobQueue.erase(std::remove_if(JobQueue.begin(), JobQueue.end(),
+			[AudioClip](const STOPJOB& Job) { return Job.AudioClip == AudioClip; }), JobQueue.end());
+	}
+
+	// Takes the next job if it is due
+	bool PopDue(DWORD Now, STOPJOB& Job)
+	{
+		if (JobQueue.empty() || (LONG)(JobQueue.front().DueTime - Now) > 0)
+		{
+			return false;
+		}
+		Job = JobQueue.front();
+		JobQueue.pop_front();
+		return true;
+	}
+
+	// Queues the next fade step, jobs posted meanwhile are due no later than it
+	void Requeue(STOPJOB Job, DWORD Now)
+	{
+		Job.DueTime = Now + StepDelay;
+		JobQueue.push_back(Job);
+	}
+
+	// Time until the next job is due
+	DWORD GetTimeout(DWORD Now) const
+	{
+		return JobQueue.empty() ? INFINITE : (DWORD)(std::max)((LONG)(JobQueue.front().DueTime - Now), (LONG)0);
+	}
+
+	// Lowers the volume one step or stops the buffer after the last step, returns true if more steps are left
+	static bool RunJob(STOPJOB& Job)
+	{
+		C& AudioClip = *Job.AudioClip;
+
+		ScopedCriticalSection ThreadLock(&AudioClip.dics);
+
+		// Skip jobs that were overtaken by Play or Release
+		if (!AudioClip.PendingStop || AudioClip.Generation != Job.Generation || !AudioClip.ProxyInterface)
+		{
+			return false;
+		}
+
+		// Fade from the current volume towards silence, the volume can still be changed while fading
+		if (++Job.Step < Job.Steps)
+		{
+			AudioClip.ProxyInterface->SetVolume(AudioClip.CurrentVolume + (DSBVOLUME_MIN - AudioClip.CurrentVolume) * (LONG)Job.Step / (LONG)Job.Steps);
+			return true;
+		}
+
+		// Stop
+		AudioClip.ProxyInterface->Stop();
+
+		// Reset volume
+		AudioClip.ProxyInterface->SetVolume(AudioClip.CurrentVolume);
+
+		// Reset pending stop
+		AudioClip.PendingStop = false;
+
+		return false;
+	}
+};
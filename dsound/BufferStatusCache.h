@@ -0,0 +1,91 @@
+#pragma once
+
+#include <windows.h>
+#include <dsound.h>
+
+// Last known play status of a buffer, used by StoppedDriverWorkaround to skip GetStatus calls.
+// Stopped buffers only start from Play. Looping buffers only stop from Stop, but are refreshed
+// now and then in case the buffer was lost. Non-looping buffers can stop on their own, and
+// buffers with a pending stop are stopped by the audio scheduler. Times are tick counts passed
+// in by the caller.
+class BufferStatusCache
+{
+public:
+	static constexpr DWORD RefreshTime = 250;
+
+private:
+	bool IsKnown = false;
+	DWORD Status = 0;
+	DWORD LastQueryTime = 0;
+
+public:
+	bool IsStatusKnown() const { return IsKnown; }
+	DWORD GetCachedStatus() const { return Status; }
+	void Invalidate() { IsKnown = false; }
+
+	void SetStatus(DWORD dwStatus, DWORD Now)
+	{
+		Status = dwStatus;
+		LastQueryTime = Now;
+		IsKnown = true;
+	}
+
+	// Returns true if the cached status can be used without asking the driver
+	bool IsCurrent(bool PendingStop, DWORD Now) const
+	{
+		return IsKnown && !PendingStop &&
+			(!(Status & DSBSTATUS_PLAYING) ||
+			((Status & DSBSTATUS_LOOPING) && Now - LastQueryTime < RefreshTime));
+	}
+
+	// Results of the buffer calls that change the play status
+	void OnPlay(HRESULT hr, DWORD dwFlags, DWORD Now)
+	{
+		if (SUCCEEDED(hr))
+		{
+			SetStatus(DSBSTATUS_PLAYING | ((dwFlags & DSBPLAY_LOOPING) ? DSBSTATUS_LOOPING : 0), Now);
+		}
+		else
+		{
+			Invalidate();
+		}
+	}
+	void OnStop(HRESULT hr, DWORD Now)
+	{
+		if (SUCCEEDED(hr))
+		{
+			SetStatus(0, Now);
+		}
+		else
+		{
+			Invalidate();
+		}
+	}
+	// A status read while a stop is pending goes out of date when the scheduler stops the buffer
+	void OnGetStatus(HRESULT hr, DWORD dwStatus, bool PendingStop, DWORD Now)
+	{
+		if (SUCCEEDED(hr) && !PendingStop)
+		{
+			SetStatus(dwStatus, Now);
+		}
+		else
+		{
+			Invalidate();
+		}
+	}
+
+	// Returns the play status, only asking the buffer when the cached status may be out of date
+	template <typename B>
+	DWORD GetStatus(B* Buffer, bool PendingStop, DWORD Now)
+	{
+		if (IsCurrent(PendingStop, Now))
+		{
+			return Status;
+		}
+
+		DWORD dwStatus = 0;
+		HRESULT hr = Buffer->GetStatus(&dwStatus);
+		OnGetStatus(hr, dwStatus, PendingStop, Now);
+		return dwStatus;
+	}
+};
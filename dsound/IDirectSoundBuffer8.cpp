@@ -15,9 +15,6 @@
 */
 
 #include "dsound.h"
-#include "Utils\Utils.h"
-
-DWORD WINAPI ResetPending(LPVOID pvParam);
 
 HRESULT m_IDirectSoundBuffer8::QueryInterface(REFIID riid, LPVOID * ppvObj)
 {
@@ -58,10 +55,7 @@ ULONG m_IDirectSoundBuffer8::Release()
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	if (CheckThreadRunning())
-	{
-		StopThread();
-	}
+	FinishPendingStop();
 
 	ULONG x = ProxyInterface->Release();
 
@@ -86,11 +80,9 @@ HRESULT m_IDirectSoundBuffer8::GetCurrentPosition(_Out_opt_ LPDWORD pdwCurrentPl
 
 	HRESULT hr = ProxyInterface->GetCurrentPosition(pdwCurrentPlayCursor, pdwCurrentWriteCursor);
 
-	if (Config.StoppedDriverWorkaround && pdwCurrentWriteCursor)
+	if (Config.StoppedDriverWorkaround && pdwCurrentWriteCursor && SUCCEEDED(hr))
 	{
-		DWORD dwStatus;
-
-		ProxyInterface->GetStatus(&dwStatus);
+		DWORD dwStatus = GetShadowStatus();
 
 		if (dwStatus & DSBSTATUS_PLAYING)
 		{
@@ -99,7 +91,7 @@ HRESULT m_IDirectSoundBuffer8::GetCurrentPosition(_Out_opt_ LPDWORD pdwCurrentPl
 				if (++m_nWriteCursorIdent > 1)
 				{
 					ProxyInterface->Stop();
-					ProxyInterface->Play(0, 0, dwStatus & DSBPLAY_LOOPING);
+					ProxyInterface->Play(0, 0, (dwStatus & DSBSTATUS_LOOPING) ? DSBPLAY_LOOPING : 0);
 				}
 			}
 			else
@@ -167,7 +159,14 @@ HRESULT m_IDirectSoundBuffer8::GetStatus(_Out_ LPDWORD pdwStatus)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->GetStatus(pdwStatus);
+	HRESULT hr = ProxyInterface->GetStatus(pdwStatus);
+
+	if (pdwStatus)
+	{
+		ShadowStatus.OnGetStatus(hr, *pdwStatus, AudioClip.PendingStop, GetTickCount());
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirectSoundBuffer8::Initialize(_In_ LPDIRECTSOUND pDirectSound, _In_ LPCDSBUFFERDESC pcDSBufferDesc)
@@ -195,19 +194,13 @@ HRESULT m_IDirectSoundBuffer8::Play(DWORD dwReserved1, DWORD dwPriority, DWORD d
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	if (CheckThreadRunning())
-	{
-		// Stop thread
-		StopThread();
+	FinishPendingStop();
 
-		// Stop audio
-		ProxyInterface->Stop();
+	HRESULT hr = ProxyInterface->Play(dwReserved1, dwPriority, dwFlags);
 
-		// Reset volume
-		ProxyInterface->SetVolume(AudioClip.CurrentVolume);
-	}
+	ShadowStatus.OnPlay(hr, dwFlags, GetTickCount());
 
-	return ProxyInterface->Play(dwReserved1, dwPriority, dwFlags);
+	return hr;
 }
 
 HRESULT m_IDirectSoundBuffer8::SetCurrentPosition(DWORD dwNewPosition)
@@ -290,17 +283,10 @@ HRESULT m_IDirectSoundBuffer8::Stop()
 
 	if (Config.AudioClipDetection)
 	{
-		if (CheckThreadRunning())
-		{
-			return DS_OK;
-		}
-
 		EnterCriticalSection(&AudioClip.dics);
 
 		DWORD dwStatus = 0;
-		ProxyInterface->GetStatus(&dwStatus);
-
-		if (!AudioClip.ds_ThreadID && (dwStatus & DSBSTATUS_PLAYING))
+		if (!AudioClip.PendingStop && SUCCEEDED(ProxyInterface->GetStatus(&dwStatus)) && (dwStatus & DSBSTATUS_PLAYING))
 		{
 			// Set pending stop
 			AudioClip.PendingStop = true;
@@ -308,24 +294,29 @@ HRESULT m_IDirectSoundBuffer8::Stop()
 			// Get volume
 			ProxyInterface->GetVolume(&AudioClip.CurrentVolume);
 
-			// Lower volume
-			ProxyInterface->SetVolume(DSBVOLUME_MIN);
-
-			// Start thread
-			if (CreateThread(nullptr, 0, ResetPending, &AudioClip, 0, &AudioClip.ds_ThreadID) == nullptr || !AudioClip.ds_ThreadID)
+			// Queue the fade out and stop, stop right away if it could not be queued
+			if (!AudioScheduler::PostStop(&AudioClip, ++AudioClip.Generation))
 			{
+				ProxyInterface->Stop();
+				ProxyInterface->SetVolume(AudioClip.CurrentVolume);
 				AudioClip.PendingStop = false;
-				AudioClip.ds_ThreadID = 0;
 			}
 		}
 
+		// Buffer keeps playing muted until the scheduler stops it
+		ShadowStatus.Invalidate();
+
 		LeaveCriticalSection(&AudioClip.dics);
 
 		// Return
 		return DS_OK;
 	}
 
-	return ProxyInterface->Stop();
+	HRESULT hr = ProxyInterface->Stop();
+
+	ShadowStatus.OnStop(hr, GetTickCount());
+
+	return hr;
 }
 
 HRESULT m_IDirectSoundBuffer8::Unlock(_In_reads_bytes_(dwAudioBytes1) LPVOID pvAudioPtr1, DWORD dwAudioBytes1,
@@ -338,6 +329,8 @@ HRESULT m_IDirectSoundBuffer8::Unlock(_In_reads_bytes_(dwAudioBytes1) LPVOID pvA
 
 HRESULT m_IDirectSoundBuffer8::Restore()
 {
+	ShadowStatus.Invalidate();
+
 	return ProxyInterface->Restore();
 }
 
@@ -371,72 +364,28 @@ HRESULT m_IDirectSoundBuffer8::GetObjectInPath(_In_ REFGUID rguidObject, DWORD d
 }
 
 // Helper functions
-bool m_IDirectSoundBuffer8::CheckThreadRunning()
-{
-	bool ThreadRunning = false;
-
-	EnterCriticalSection(&AudioClip.dics);
-
-	if (AudioClip.ds_ThreadID)
-	{
-		ThreadRunning = true;
-	}
-
-	LeaveCriticalSection(&AudioClip.dics);
-
-	return ThreadRunning;
-}
-
-void m_IDirectSoundBuffer8::StopThread()
+void m_IDirectSoundBuffer8::FinishPendingStop()
 {
-	// Trigger thread
-	SetEvent(AudioClip.hTriggerEvent);
-
-	// Wiat for thread to exit
-	bool flag = false;
-	do {
-
-		Utils::BusyWaitYield((DWORD)-1);
-
-		EnterCriticalSection(&AudioClip.dics);
-
-		flag = (AudioClip.ds_ThreadID != 0);
-
-		LeaveCriticalSection(&AudioClip.dics);
-
-	} while (flag);
-}
-
-DWORD WINAPI ResetPending(LPVOID pvParam)
-{
-	if (!pvParam)
-	{
-		return S_FALSE;
-	}
-
-	AUDIOCLIP &AudioClip = *(AUDIOCLIP*)pvParam;
-
-	// Add slight delay
-	WaitForSingleObject(AudioClip.hTriggerEvent, ((Config.AudioFadeOutDelayMS) ? Config.AudioFadeOutDelayMS : 20));
-
 	EnterCriticalSection(&AudioClip.dics);
 
-	if (AudioClip.PendingStop && AudioClip.ProxyInterface)
+	if (AudioClip.PendingStop)
 	{
-		// Stop
-		AudioClip.ProxyInterface->Stop();
+		// Stop audio
+		ProxyInterface->Stop();
 
 		// Reset volume
-		AudioClip.ProxyInterface->SetVolume(AudioClip.CurrentVolume);
-	}
-
-	// Reset pending stop
-	AudioClip.PendingStop = false;
+		ProxyInterface->SetVolume(AudioClip.CurrentVolume);
 
-	// Reset thread ID
-	AudioClip.ds_ThreadID = 0;
+		// Reset pending stop, the queued job is skipped
+		AudioClip.PendingStop = false;
+		AudioClip.Generation++;
+	}
 
 	LeaveCriticalSection(&AudioClip.dics);
+}
 
-	return S_OK;
+// Returns the play status, only asking the driver when the last known status may be out of date
+DWORD m_IDirectSoundBuffer8::GetShadowStatus()
+{
+	return ShadowStatus.GetStatus(ProxyInterface, AudioClip.PendingStop, GetTickCount());
 }
@@ -2,11 +2,10 @@
 
 struct AUDIOCLIP
 {
-	DWORD ds_ThreadID = 0;
 	CRITICAL_SECTION dics = {};
 	LPDIRECTSOUNDBUFFER8 ProxyInterface = nullptr;
 	LONG CurrentVolume = 0;
-	HANDLE hTriggerEvent = nullptr;
+	DWORD Generation = 0;		// Incremented for each stop so stale scheduler jobs are skipped
 	bool PendingStop = false;
 };
 
@@ -22,6 +21,9 @@ protected:
 	DWORD m_dwOldWriteCursorPos = 0;
 	BYTE m_nWriteCursorIdent = 0;
 
+	// Last known play status, used by StoppedDriverWorkaround to skip GetStatus calls
+	BufferStatusCache ShadowStatus;
+
 	bool m_bIsPrimary = false;
 
 public:
@@ -33,17 +35,16 @@ public:
 
 		// Initialize Critical Section
 		InitializeCriticalSection(&AudioClip.dics);
-		char EventName[MAX_PATH];
-		sprintf_s(EventName, MAX_PATH, "Local\\SH2EAudioClipDetection-%u", (DWORD)this);
-		AudioClip.hTriggerEvent = CreateEvent(nullptr, FALSE, FALSE, EventName);
 	}
 	~m_IDirectSoundBuffer8()
 	{
 		LOG_LIMIT(3, __FUNCTION__ << " (" << this << ")" << " deleting interface!");
 
+		// Remove queued stops before the buffer goes away
+		AudioScheduler::Cancel(&AudioClip);
+
 		// Delete Critical Section
 		DeleteCriticalSection(&AudioClip.dics);
-		CloseHandle(AudioClip.hTriggerEvent);
 	}
 
 	// IUnknown methods
@@ -80,8 +81,8 @@ public:
 	IFACEMETHOD(GetObjectInPath)(THIS_ _In_ REFGUID rguidObject, DWORD dwIndex, _In_ REFGUID rguidInterface, _Outptr_ LPVOID *ppObject) override;
 
 	// Helper functions
-	bool CheckThreadRunning();
-	void StopThread();
+	void FinishPendingStop();
+	DWORD GetShadowStatus();
 	LPDIRECTSOUNDBUFFER8 GetProxyInterface() { return ProxyInterface; }
 	bool GetPrimaryBuffer()
 	{
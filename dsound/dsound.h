@@ -49,6 +49,8 @@ extern AddressLookupTableDsound ProxyAddressLookupTableDsound;
 
 using namespace DsoundWrapper;
 
+#include "AudioScheduler.h"
+#include "BufferStatusCache.h"
 #include "IDirectSound8.h"
 #include "IDirectSound3DBuffer8.h"
 #include "IDirectSound3DListener8.h"
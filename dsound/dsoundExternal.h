@@ -25,6 +25,11 @@ HRESULT WINAPI ds_DirectSoundFullDuplexCreate(LPCGUID pcGuidCaptureDevice, LPCGU
 HRESULT WINAPI ds_DllGetClassObject(IN REFCLSID rclsid, IN REFIID riid, OUT LPVOID FAR* ppv);
 HRESULT WINAPI ds_DllCanUnloadNow();
 
+namespace AudioScheduler
+{
+	void StopThread();
+}
+
 #define DECLARE_IN_WRAPPED_PROC(procName, unused) \
 	const FARPROC procName ## _in = (FARPROC)*ds_ ## procName;
 